@@ -7,6 +7,7 @@ include $(CLEAR_VARS)
 LOCAL_SRC_FILES := \
         util/QCameraCmdThread.cpp \
         util/QCameraQueue.cpp \
+        util/QCameraPrioQueue.cpp \
         util/QCameraBufferMaps.cpp \
         QCamera2Hal.cpp \
         QCamera2Factory.cpp
@@ -15,6 +16,7 @@ LOCAL_SRC_FILES := \
 LOCAL_SRC_FILES += \
         HAL3/QCamera3HWI.cpp \
         HAL3/QCamera3Mem.cpp \
+        HAL3/QCamera3MetaTable.cpp \
         HAL3/QCamera3Stream.cpp \
         HAL3/QCamera3Channel.cpp \
         HAL3/QCamera3VendorTags.cpp \
@@ -39,6 +39,7 @@
 
 #include "QCameraTrace.h"
 #include "QCameraQueue.h"
+#include "QCameraPrioQueue.h"
 #include "QCameraCmdThread.h"
 #include "QCameraChannel.h"
 #include "QCameraStream.h"
@@ -212,7 +213,7 @@ private:
     void                          *mJpegCallbackCookie;
     QCamera2HardwareInterface     *mParent;
 
-    QCameraQueue     mDataQ;
+    QCameraPrioQueue mDataQ;
     QCameraCmdThread mProcTh;
     bool             mActive;
 };
@@ -3080,7 +3080,10 @@ int32_t QCameraCbNotifier::notifyCallback(qcamera_callback_argm_t &cbArgs)
     memset(cbArg, 0, sizeof(qcamera_callback_argm_t));
     *cbArg = cbArgs;
 
-    if (mDataQ.enqueue((void *)cbArg)) {
+    /* Notifications (focus, shutter, error) go ahead of queued frames */
+    if (mDataQ.enqueue((void *)cbArg,
+            (QCAMERA_NOTIFY_CALLBACK == cbArg->cb_type) ?
+            QCAMERA_QUEUE_PRIO_HIGH : QCAMERA_QUEUE_PRIO_NORMAL)) {
         return mProcTh.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, FALSE, FALSE);
     } else {
         ALOGE("%s: Error adding cb data into queue", __func__);
@@ -33,6 +33,7 @@
 #include <sys/mman.h>
 #include <utils/Errors.h>
 #include <utils/Log.h>
+#include <cutils/properties.h>
 #include <gralloc_priv.h>
 #include <QComOMXMetadata.h>
 #include <OMX_IVCommon.h>
@@ -544,8 +545,21 @@ void QCameraMemory::deallocOneBuffer(QCameraMemInfo &memInfo)
  * RETURN     : None
  *==========================================================================*/
 QCameraMemoryPool::QCameraMemoryPool()
+    : mCachedBytes(0),
+      mPeakCachedBytes(0),
+      mCachedCount(0),
+      mHits(0),
+      mMisses(0),
+      mEvictions(0),
+      mWastedBytes(0)
 {
+    char value[PROPERTY_VALUE_MAX];
+
     pthread_mutex_init(&mLock, NULL);
+
+    property_get("persist.camera.mem.pool.cap", value, "");
+    mMaxCachedBytes = (size_t)((value[0] != '\0') ? atoi(value) :
+            QCAMERA_MEM_POOL_DEFAULT_CAP_MB) * 1024U * 1024U;
 }
 
 
@@ -564,6 +578,29 @@ QCameraMemoryPool::~QCameraMemoryPool()
     pthread_mutex_destroy(&mLock);
 }
 
+/*===========================================================================
+ * FUNCTION   : getSizeClass
+ *
+ * DESCRIPTION: maps a buffer size to the index of its free list bucket
+ *
+ * PARAMETERS :
+ *   @size    : size of the buffer
+ *
+ * RETURN     : size class index, from 0 to QCAMERA_MEM_POOL_SIZE_CLASSES - 1
+ *==========================================================================*/
+int QCameraMemoryPool::getSizeClass(size_t size)
+{
+    int sizeClass = 0;
+
+    size >>= QCAMERA_MEM_POOL_MIN_SHIFT;
+    while ((size >>= 1) != 0 &&
+            sizeClass < (QCAMERA_MEM_POOL_SIZE_CLASSES - 1)) {
+        sizeClass++;
+    }
+
+    return sizeClass;
+}
+
 /*===========================================================================
  * FUNCTION   : releaseBuffer
  *
@@ -579,9 +616,29 @@ void QCameraMemoryPool::releaseBuffer(
         struct QCameraMemory::QCameraMemInfo &memInfo,
         cam_stream_type_t streamType)
 {
+    QCameraMemPoolEntry entry;
+
     pthread_mutex_lock(&mLock);
 
-    mPools[streamType].push_back(memInfo);
+    if (memInfo.size > mMaxCachedBytes) {
+        // would evict everything else and still not fit
+        QCameraMemory::deallocOneBuffer(memInfo);
+        mEvictions++;
+        pthread_mutex_unlock(&mLock);
+        return;
+    }
+
+    trimLocked(mMaxCachedBytes - memInfo.size);
+
+    entry.memInfo = memInfo;
+    entry.idleSince = systemTime();
+    mPools[streamType][getSizeClass(memInfo.size)].push_back(entry);
+
+    mCachedBytes += memInfo.size;
+    mCachedCount++;
+    if (mCachedBytes > mPeakCachedBytes) {
+        mPeakCachedBytes = mCachedBytes;
+    }
 
     pthread_mutex_unlock(&mLock);
 }
@@ -600,22 +657,107 @@ void QCameraMemoryPool::clear()
     pthread_mutex_lock(&mLock);
 
     for (int i = CAM_STREAM_TYPE_DEFAULT; i < CAM_STREAM_TYPE_MAX; i++ ) {
-        List<struct QCameraMemory::QCameraMemInfo>::iterator it;
-        it = mPools[i].begin();
-        for( ; it != mPools[i].end() ; it++) {
-            QCameraMemory::deallocOneBuffer(*it);
-        }
+        for (int j = 0; j < QCAMERA_MEM_POOL_SIZE_CLASSES; j++) {
+            List<QCameraMemPoolEntry>::iterator it;
+            it = mPools[i][j].begin();
+            for( ; it != mPools[i][j].end() ; it++) {
+                QCameraMemory::deallocOneBuffer((*it).memInfo);
+            }
 
-        mPools[i].clear();
+            mPools[i][j].clear();
+        }
     }
+    mCachedBytes = 0;
+    mCachedCount = 0;
+
+    pthread_mutex_unlock(&mLock);
+}
+
+/*===========================================================================
+ * FUNCTION   : setMaxCachedBytes
+ *
+ * DESCRIPTION: sets the cap on memory held by idle cached buffers, evicting
+ *              least recently released buffers until the pool fits
+ *
+ * PARAMETERS :
+ *   @maxBytes : maximum number of bytes to keep cached
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::setMaxCachedBytes(size_t maxBytes)
+{
+    pthread_mutex_lock(&mLock);
+
+    mMaxCachedBytes = maxBytes;
+    trimLocked(mMaxCachedBytes);
 
     pthread_mutex_unlock(&mLock);
 }
 
+/*===========================================================================
+ * FUNCTION   : evictOneLocked
+ *
+ * DESCRIPTION: frees the cached buffer that has been idle the longest. Each
+ *              free list is kept in release order, so only list heads are
+ *              candidates.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : true if a buffer was freed, false if the pool is empty
+ *==========================================================================*/
+bool QCameraMemoryPool::evictOneLocked()
+{
+    List<QCameraMemPoolEntry> *oldest = NULL;
+
+    for (int i = CAM_STREAM_TYPE_DEFAULT; i < CAM_STREAM_TYPE_MAX; i++ ) {
+        for (int j = 0; j < QCAMERA_MEM_POOL_SIZE_CLASSES; j++) {
+            if (mPools[i][j].empty()) {
+                continue;
+            }
+            if ((oldest == NULL) ||
+                    ((*mPools[i][j].begin()).idleSince <
+                    (*oldest->begin()).idleSince)) {
+                oldest = &mPools[i][j];
+            }
+        }
+    }
+
+    if (oldest == NULL) {
+        return false;
+    }
+
+    List<QCameraMemPoolEntry>::iterator it = oldest->begin();
+    CDBG("%s : Evicting buffer %lx size %d", __func__,
+            (unsigned long)(*it).memInfo.handle, (*it).memInfo.size);
+    mCachedBytes -= (*it).memInfo.size;
+    mCachedCount--;
+    mEvictions++;
+    QCameraMemory::deallocOneBuffer((*it).memInfo);
+    oldest->erase(it);
+
+    return true;
+}
+
+/*===========================================================================
+ * FUNCTION   : trimLocked
+ *
+ * DESCRIPTION: evicts idle buffers until no more than maxBytes are cached
+ *
+ * PARAMETERS :
+ *   @maxBytes : number of cached bytes to trim down to
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::trimLocked(size_t maxBytes)
+{
+    while ((mCachedBytes > maxBytes) && evictOneLocked()) {
+    }
+}
+
 /*===========================================================================
  * FUNCTION   : findBufferLocked
  *
- * DESCRIPTION: search for a appropriate cached buffer
+ * DESCRIPTION: search for the smallest cached buffer that fits the request
  *
  * PARAMETERS :
  *   @memInfo : reference to struct that stores additional memory allocation info
@@ -632,42 +774,50 @@ int QCameraMemoryPool::findBufferLocked(
         struct QCameraMemory::QCameraMemInfo &memInfo, unsigned int heap_id,
         size_t size, bool cached, cam_stream_type_t streamType)
 {
-    int rc = NAME_NOT_FOUND;
-
-    if (mPools[streamType].empty()) {
-        return NAME_NOT_FOUND;
-    }
-
-    List<struct QCameraMemory::QCameraMemInfo>::iterator it = mPools[streamType].begin();
-    if (streamType == CAM_STREAM_TYPE_OFFLINE_PROC) {
-        for( ; it != mPools[streamType].end() ; it++) {
-            if( ((*it).size == size) &&
-                    ((*it).heap_id == heap_id) &&
-                    ((*it).cached == cached) ) {
-                memInfo = *it;
-                ALOGE("%s : Found buffer %lx size %d",
-                        __func__, (unsigned long)memInfo.handle, memInfo.size);
-                mPools[streamType].erase(it);
-                rc = NO_ERROR;
-                break;
+    size_t maxSize = size;
+    int firstClass = getSizeClass(size);
+    int lastClass = firstClass;
+
+    if (streamType != CAM_STREAM_TYPE_OFFLINE_PROC) {
+        maxSize += (size > QCAMERA_MEM_POOL_MIN_WASTE) ?
+                size : QCAMERA_MEM_POOL_MIN_WASTE;
+        lastClass = getSizeClass(maxSize);
+    }
+
+    // Every buffer of a size class is larger than those of the classes
+    // below it, so the first class holding a fit also holds the best fit
+    for (int j = firstClass; j <= lastClass; j++) {
+        List<QCameraMemPoolEntry> &pool = mPools[streamType][j];
+        List<QCameraMemPoolEntry>::iterator it = pool.begin();
+        List<QCameraMemPoolEntry>::iterator best = pool.end();
+
+        for( ; it != pool.end() ; it++) {
+            if (((*it).memInfo.size >= size) &&
+                    ((*it).memInfo.size <= maxSize) &&
+                    ((*it).memInfo.heap_id == heap_id) &&
+                    ((*it).memInfo.cached == cached) &&
+                    ((best == pool.end()) ||
+                    ((*it).memInfo.size < (*best).memInfo.size))) {
+                best = it;
+                if ((*best).memInfo.size == size) {
+                    break;
+                }
             }
         }
-    } else {
-        for( ; it != mPools[streamType].end() ; it++) {
-            if(((*it).size >= size) &&
-                    ((*it).heap_id == heap_id) &&
-                    ((*it).cached == cached) ) {
-                memInfo = *it;
-                ALOGE("%s : Found buffer %lx size %d",
-                        __func__, (unsigned long)memInfo.handle, memInfo.size);
-                mPools[streamType].erase(it);
-                rc = NO_ERROR;
-                break;
-            }
+
+        if (best != pool.end()) {
+            memInfo = (*best).memInfo;
+            CDBG("%s : Found buffer %lx size %d",
+                    __func__, (unsigned long)memInfo.handle, memInfo.size);
+            pool.erase(best);
+            mCachedBytes -= memInfo.size;
+            mCachedCount--;
+            mWastedBytes += memInfo.size - size;
+            return NO_ERROR;
         }
     }
 
-    return rc;
+    return NAME_NOT_FOUND;
 }
 
 /*===========================================================================
@@ -699,8 +849,13 @@ int QCameraMemoryPool::allocateBuffer(
     rc = findBufferLocked(memInfo, heap_id, size, cached, streamType);
     if (NAME_NOT_FOUND == rc ) {
         CDBG_HIGH("%s : Buffer not found!", __func__);
+        mMisses++;
+        // give idle buffers back to ion before asking it for a new one
+        trimLocked((mMaxCachedBytes > size) ? (mMaxCachedBytes - size) : 0);
         rc = QCameraMemory::allocOneBuffer(memInfo, heap_id, size, cached,
                  secure_mode);
+    } else {
+        mHits++;
     }
 
     pthread_mutex_unlock(&mLock);
@@ -708,6 +863,50 @@ int QCameraMemoryPool::allocateBuffer(
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : dump
+ *
+ * DESCRIPTION: Composes a string with the pool occupancy and statistics
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : Formatted string
+ *==========================================================================*/
+String8 QCameraMemoryPool::dump()
+{
+    String8 str("\n");
+    char s[128];
+
+    pthread_mutex_lock(&mLock);
+
+    snprintf(s, 128, "Cached buffers: %u, bytes: %zu (peak %zu, cap %zu)\n",
+            mCachedCount, mCachedBytes, mPeakCachedBytes, mMaxCachedBytes);
+    str += s;
+
+    snprintf(s, 128, "Hits: %u, Misses: %u, Evictions: %u\n",
+            mHits, mMisses, mEvictions);
+    str += s;
+
+    snprintf(s, 128, "Bytes wasted on hits: %llu\n",
+            (unsigned long long)mWastedBytes);
+    str += s;
+
+    for (int i = CAM_STREAM_TYPE_DEFAULT; i < CAM_STREAM_TYPE_MAX; i++ ) {
+        for (int j = 0; j < QCAMERA_MEM_POOL_SIZE_CLASSES; j++) {
+            if (!mPools[i][j].empty()) {
+                snprintf(s, 128, "  stream %d, class %d (>= %u bytes): %zu\n",
+                        i, j, 1U << (j + QCAMERA_MEM_POOL_MIN_SHIFT),
+                        mPools[i][j].size());
+                str += s;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&mLock);
+
+    return str;
+}
+
 /*===========================================================================
  * FUNCTION   : QCameraHeapMemory
  *
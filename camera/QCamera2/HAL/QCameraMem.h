@@ -34,6 +34,7 @@
 #include <utils/Mutex.h>
 #include <utils/List.h>
 #include <utils/Timers.h>
+#include <utils/String8.h>
 
 //Media depedancies
 #include "OMX_QCOMExtns.h"
@@ -137,6 +138,16 @@ protected:
     cam_stream_buf_type mBufType;
 };
 
+// Free lists are bucketed by size class: class k holds buffers whose size
+// is in [2^k, 2^(k+1)) bytes, starting at 2^QCAMERA_MEM_POOL_MIN_SHIFT.
+#define QCAMERA_MEM_POOL_MIN_SHIFT      12
+#define QCAMERA_MEM_POOL_SIZE_CLASSES   20
+// A cached buffer is only handed out if it is at most this much larger than
+// requested, or at most twice the request, whichever is larger
+#define QCAMERA_MEM_POOL_MIN_WASTE      (1024U * 1024U)
+// Default cap on idle cached bytes, overridden by persist.camera.mem.pool.cap (MB)
+#define QCAMERA_MEM_POOL_DEFAULT_CAP_MB 128
+
 class QCameraMemoryPool {
 
 public:
@@ -150,15 +161,35 @@ public:
     void releaseBuffer(struct QCameraMemory::QCameraMemInfo &memInfo,
             cam_stream_type_t streamType);
     void clear();
+    void setMaxCachedBytes(size_t maxBytes);
+    android::String8 dump();
 
 protected:
 
+    struct QCameraMemPoolEntry {
+        struct QCameraMemory::QCameraMemInfo memInfo;
+        nsecs_t idleSince;
+    };
+
+    static int getSizeClass(size_t size);
     int findBufferLocked(struct QCameraMemory::QCameraMemInfo &memInfo,
             unsigned int heap_id, size_t size, bool cached,
             cam_stream_type_t streamType);
+    bool evictOneLocked();
+    void trimLocked(size_t maxBytes);
 
-    android::List<QCameraMemory::QCameraMemInfo> mPools[CAM_STREAM_TYPE_MAX];
+    android::List<QCameraMemPoolEntry>
+            mPools[CAM_STREAM_TYPE_MAX][QCAMERA_MEM_POOL_SIZE_CLASSES];
     pthread_mutex_t mLock;
+
+    size_t mMaxCachedBytes;
+    size_t mCachedBytes;
+    size_t mPeakCachedBytes;
+    uint32_t mCachedCount;
+    uint32_t mHits;
+    uint32_t mMisses;
+    uint32_t mEvictions;
+    uint64_t mWastedBytes;
 };
 
 // Internal heap memory is used for memories used internally
@@ -44,6 +44,7 @@
 #include <gralloc_priv.h>
 #include "QCamera3HWI.h"
 #include "QCamera3Mem.h"
+#include "QCamera3MetaTable.h"
 #include "QCamera3Channel.h"
 #include "QCamera3PostProc.h"
 #include "QCamera3VendorTags.h"
@@ -325,11 +326,14 @@ QCamera3HardwareInterface::QCamera3HardwareInterface(uint32_t cameraId,
       mMinRawFrameDuration(0),
       m_pPowerModule(NULL),
       mMetaFrameCount(0U),
+      mMetaBufDumpCount(0U),
       mUpdateDebugLevel(false),
       mCallbacks(callbacks),
       mCaptureIntent(0),
       mCacMode(0),
-      mBootToMonoTimestampOffset(0)
+      mBootToMonoTimestampOffset(0),
+      mResultEntryHint(0),
+      mResultDataHint(0)
 {
     getLogLevel();
     mCameraDevice.common.tag = HARDWARE_DEVICE_TAG;
@@ -369,6 +373,11 @@ QCamera3HardwareInterface::QCamera3HardwareInterface(uint32_t cameraId,
     property_get("persist.camera.tnr.preview", prop, "0");
     m_bTnrEnabled = (uint8_t)atoi(prop);
 
+    //Number of result metadata buffers to record for offline translation
+    memset(prop, 0, sizeof(prop));
+    property_get("persist.camera.dumpmetabuf", prop, "0");
+    mMetaBufDumpCount = (uint32_t)atoi(prop);
+
     //Load and read GPU library.
     lib_surface_utils = NULL;
     LINK_get_surface_pixel_alignment = NULL;
@@ -472,8 +481,8 @@ QCamera3HardwareInterface::~QCamera3HardwareInterface()
     if (mCameraOpened)
         closeCamera();
 
-    mPendingBuffersMap.mPendingBufferList.clear();
-    mPendingRequestsList.clear();
+    clearPendingBuffers();
+    clearPendingRequests();
     mPendingReprocessResultList.clear();
 
     for (size_t i = 0; i < CAMERA3_TEMPLATE_COUNT; i++)
@@ -1649,11 +1658,11 @@ int QCamera3HardwareInterface::configureStreams(
     mStreamConfigInfo.buffer_info.max_buffers = MAX_INFLIGHT_REQUESTS;
 
     /* Initialize mPendingRequestInfo and mPendnigBuffersMap */
-    mPendingRequestsList.clear();
+    clearPendingRequests();
     mPendingFrameDropList.clear();
     // Initialize/Reset the pending buffers list
     mPendingBuffersMap.num_buffers = 0;
-    mPendingBuffersMap.mPendingBufferList.clear();
+    clearPendingBuffers();
     mPendingReprocessResultList.clear();
 
     mFirstRequest = true;
@@ -1909,28 +1918,24 @@ int32_t QCamera3HardwareInterface::handlePendingReprocResults(uint32_t frame_num
             CDBG("%s: Delayed reprocess notify %d", __func__,
                     frame_number);
 
-            for (List<PendingRequestInfo>::iterator k = mPendingRequestsList.begin();
-                k != mPendingRequestsList.end(); k++) {
-
-                if (k->frame_number == j->frame_number) {
-                    CDBG("%s: Found reprocess frame number %d in pending reprocess List "
-                            "Take it out!!", __func__,
-                            k->frame_number);
-
-                    camera3_capture_result result;
-                    memset(&result, 0, sizeof(camera3_capture_result));
-                    result.frame_number = frame_number;
-                    result.num_output_buffers = 1;
-                    result.output_buffers =  &j->buffer;
-                    result.input_buffer = k->input_buffer;
-                    result.result = k->settings;
-                    result.partial_result = PARTIAL_RESULT_COUNT;
-                    mCallbackOps->process_capture_result(mCallbackOps, &result);
-
-                    mPendingRequestsList.erase(k);
-                    mPendingRequest--;
-                    break;
-                }
+            pendingRequestIterator k = findPendingRequest(j->frame_number);
+            if (k != mPendingRequestsList.end()) {
+                CDBG("%s: Found reprocess frame number %d in pending reprocess List "
+                        "Take it out!!", __func__,
+                        k->frame_number);
+
+                camera3_capture_result result;
+                memset(&result, 0, sizeof(camera3_capture_result));
+                result.frame_number = frame_number;
+                result.num_output_buffers = 1;
+                result.output_buffers =  &j->buffer;
+                result.input_buffer = k->input_buffer;
+                result.result = k->settings;
+                result.partial_result = PARTIAL_RESULT_COUNT;
+                mCallbackOps->process_capture_result(mCallbackOps, &result);
+
+                erasePendingRequest(k);
+                mPendingRequest--;
             }
             mPendingReprocessResultList.erase(j);
             break;
@@ -2007,41 +2012,37 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
           __func__, urgent_frame_number, capture_time);
 
         //Recieved an urgent Frame Number, handle it
-        //using partial results
-        for (List<PendingRequestInfo>::iterator i =
-            mPendingRequestsList.begin(); i != mPendingRequestsList.end(); i++) {
-            CDBG("%s: Iterator Frame = %d urgent frame = %d",
-                __func__, i->frame_number, urgent_frame_number);
-
-            if (i->frame_number < urgent_frame_number &&
-                i->partial_result_cnt == 0) {
+        //using partial results. The list is in frame number order, so
+        //only the requests ahead of the urgent one can have missed theirs
+        for (pendingRequestIterator i = mPendingRequestsList.begin();
+                i != mPendingRequestsList.end() &&
+                i->frame_number < urgent_frame_number; i++) {
+            if (i->partial_result_cnt == 0) {
                 ALOGE("%s: Error: HAL missed urgent metadata for frame number %d",
                     __func__, i->frame_number);
             }
+        }
 
-            if (i->frame_number == urgent_frame_number &&
-                     i->bUrgentReceived == 0) {
-
-                camera3_capture_result_t result;
-                memset(&result, 0, sizeof(camera3_capture_result_t));
+        pendingRequestIterator i = findPendingRequest(urgent_frame_number);
+        if (i != mPendingRequestsList.end() && i->bUrgentReceived == 0) {
+            camera3_capture_result_t result;
+            memset(&result, 0, sizeof(camera3_capture_result_t));
 
-                i->partial_result_cnt++;
-                i->bUrgentReceived = 1;
-                // Extract 3A metadata
-                result.result =
-                    translateCbUrgentMetadataToResultMetadata(metadata);
-                // Populate metadata result
-                result.frame_number = urgent_frame_number;
-                result.num_output_buffers = 0;
-                result.output_buffers = NULL;
-                result.partial_result = i->partial_result_cnt;
+            i->partial_result_cnt++;
+            i->bUrgentReceived = 1;
+            // Extract 3A metadata
+            result.result =
+                translateCbUrgentMetadataToResultMetadata(metadata);
+            // Populate metadata result
+            result.frame_number = urgent_frame_number;
+            result.num_output_buffers = 0;
+            result.output_buffers = NULL;
+            result.partial_result = i->partial_result_cnt;
 
-                mCallbackOps->process_capture_result(mCallbackOps, &result);
-                CDBG("%s: urgent frame_number = %u, capture_time = %lld",
-                     __func__, result.frame_number, capture_time);
-                free_camera_metadata((camera_metadata_t *)result.result);
-                break;
-            }
+            mCallbackOps->process_capture_result(mCallbackOps, &result);
+            CDBG("%s: urgent frame_number = %u, capture_time = %lld",
+                 __func__, result.frame_number, capture_time);
+            free_camera_metadata((camera_metadata_t *)result.result);
         }
     }
 
@@ -2137,6 +2138,11 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
 
             i->timestamp = capture_time;
 
+            if (mMetaBufDumpCount) {
+                dumpMetaBufferToFile(metadata, i->frame_number);
+                mMetaBufDumpCount--;
+            }
+
             result.result = translateFromHalMetadata(metadata,
                     i->timestamp, i->request_id, i->jpegMetadata, i->pipeline_depth,
                     i->capture_intent, i->fwkCacMode);
@@ -2201,17 +2207,13 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
                         }
                     }
 
-                    for (List<PendingBufferInfo>::iterator k =
-                      mPendingBuffersMap.mPendingBufferList.begin();
-                      k != mPendingBuffersMap.mPendingBufferList.end(); k++) {
-                      if (k->buffer == j->buffer->buffer) {
+                    pendingBufferIterator k = findPendingBuffer(j->buffer->buffer);
+                    if (k != mPendingBuffersMap.mPendingBufferList.end()) {
                         CDBG("%s: Found buffer %p in pending buffer List "
                               "for frame %u, Take it out!!", __func__,
                                k->buffer, k->frame_number);
                         mPendingBuffersMap.num_buffers--;
-                        k = mPendingBuffersMap.mPendingBufferList.erase(k);
-                        break;
-                      }
+                        erasePendingBuffer(k);
                     }
 
                     result_buffers[result_buffers_idx++] = *(j->buffer);
@@ -2232,7 +2234,7 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
             free_camera_metadata((camera_metadata_t *)result.result);
         }
         // erase the element from the list
-        i = mPendingRequestsList.erase(i);
+        i = erasePendingRequest(i);
 
         if (!mPendingReprocessResultList.empty()) {
             handlePendingReprocResults(frame_number + 1);
@@ -2266,15 +2268,11 @@ void QCamera3HardwareInterface::handleBufferWithLock(
         // flush case
         //go through the pending buffers and mark them as returned.
         CDBG("%s: Handle buffer with lock called during flush", __func__);
-        for (List<PendingBufferInfo>::iterator i =
-                mPendingBuffersMap.mPendingBufferList.begin();
-                i != mPendingBuffersMap.mPendingBufferList.end(); i++) {
-            if (i->buffer == buffer->buffer) {
-                mPendingBuffersMap.num_buffers--;
-                CDBG("%s: Found Frame buffer, updated num_buffers %d, ",
-                        __func__, mPendingBuffersMap.num_buffers);
-                break;
-            }
+        if (findPendingBuffer(buffer->buffer) !=
+                mPendingBuffersMap.mPendingBufferList.end()) {
+            mPendingBuffersMap.num_buffers--;
+            CDBG("%s: Found Frame buffer, updated num_buffers %d, ",
+                    __func__, mPendingBuffersMap.num_buffers);
         }
         if (mPendingBuffersMap.num_buffers == 0) {
             //signal the flush()
@@ -2288,18 +2286,14 @@ void QCamera3HardwareInterface::handleBufferWithLock(
     // If the frame number doesn't exist in the pending request list,
     // directly send the buffer to the frameworks, and update pending buffers map
     // Otherwise, book-keep the buffer.
-    List<PendingRequestInfo>::iterator i = mPendingRequestsList.begin();
-    while (i != mPendingRequestsList.end() && i->frame_number != frame_number){
-        i++;
-    }
+    pendingRequestIterator i = findPendingRequest(frame_number);
     if (i == mPendingRequestsList.end()) {
         // Verify all pending requests frame_numbers are greater
-        for (List<PendingRequestInfo>::iterator j = mPendingRequestsList.begin();
-                j != mPendingRequestsList.end(); j++) {
-            if (j->frame_number < frame_number) {
-                ALOGE("%s: Error: pending frame number %d is smaller than %d",
-                        __func__, j->frame_number, frame_number);
-            }
+        for (pendingRequestIterator j = mPendingRequestsList.begin();
+                j != mPendingRequestsList.end() &&
+                j->frame_number < frame_number; j++) {
+            ALOGE("%s: Error: pending frame number %d is smaller than %d",
+                    __func__, j->frame_number, frame_number);
         }
         camera3_capture_result_t result;
         memset(&result, 0, sizeof(camera3_capture_result_t));
@@ -2323,17 +2317,13 @@ void QCamera3HardwareInterface::handleBufferWithLock(
         CDBG("%s: result frame_number = %d, buffer = %p",
                 __func__, frame_number, buffer->buffer);
 
-        for (List<PendingBufferInfo>::iterator k =
-                mPendingBuffersMap.mPendingBufferList.begin();
-                k != mPendingBuffersMap.mPendingBufferList.end(); k++ ) {
-            if (k->buffer == buffer->buffer) {
-                CDBG("%s: Found Frame buffer, take it out from list",
-                        __func__);
+        pendingBufferIterator k = findPendingBuffer(buffer->buffer);
+        if (k != mPendingBuffersMap.mPendingBufferList.end()) {
+            CDBG("%s: Found Frame buffer, take it out from list",
+                    __func__);
 
-                mPendingBuffersMap.num_buffers--;
-                k = mPendingBuffersMap.mPendingBufferList.erase(k);
-                break;
-            }
+            mPendingBuffersMap.num_buffers--;
+            erasePendingBuffer(k);
         }
         CDBG("%s: mPendingBuffersMap.num_buffers = %d",
             __func__, mPendingBuffersMap.num_buffers);
@@ -2367,29 +2357,21 @@ void QCamera3HardwareInterface::handleBufferWithLock(
                 ALOGE("%s: input buffer fence wait failed %d", __func__, rc);
             }
 
-            for (List<PendingBufferInfo>::iterator k =
-                    mPendingBuffersMap.mPendingBufferList.begin();
-                    k != mPendingBuffersMap.mPendingBufferList.end(); k++ ) {
-                if (k->buffer == buffer->buffer) {
-                    CDBG("%s: Found Frame buffer, take it out from list",
-                            __func__);
+            pendingBufferIterator k = findPendingBuffer(buffer->buffer);
+            if (k != mPendingBuffersMap.mPendingBufferList.end()) {
+                CDBG("%s: Found Frame buffer, take it out from list",
+                        __func__);
 
-                    mPendingBuffersMap.num_buffers--;
-                    k = mPendingBuffersMap.mPendingBufferList.erase(k);
-                    break;
-                }
+                mPendingBuffersMap.num_buffers--;
+                erasePendingBuffer(k);
             }
             CDBG("%s: mPendingBuffersMap.num_buffers = %d",
                 __func__, mPendingBuffersMap.num_buffers);
 
-            bool notifyNow = true;
-            for (List<PendingRequestInfo>::iterator j = mPendingRequestsList.begin();
-                    j != mPendingRequestsList.end(); j++) {
-                if (j->frame_number < frame_number) {
-                    notifyNow = false;
-                    break;
-                }
-            }
+            // Requests are in frame number order, so only the oldest one
+            // can be ahead of this frame
+            bool notifyNow =
+                    mPendingRequestsList.begin()->frame_number >= frame_number;
 
             if (notifyNow) {
                 camera3_capture_result result;
@@ -2404,7 +2386,7 @@ void QCamera3HardwareInterface::handleBufferWithLock(
                 mCallbackOps->notify(mCallbackOps, &notify_msg);
                 mCallbackOps->process_capture_result(mCallbackOps, &result);
                 CDBG("%s: Notify reprocess now %d!", __func__, frame_number);
-                i = mPendingRequestsList.erase(i);
+                i = erasePendingRequest(i);
                 mPendingRequest--;
             } else {
                 // Cache reprocess result for later
@@ -2452,6 +2434,152 @@ void QCamera3HardwareInterface::unblockRequestIfNecessary()
    pthread_cond_signal(&mRequestCond);
 }
 
+/*===========================================================================
+ * FUNCTION   : addPendingRequest
+ *
+ * DESCRIPTION: Append a request to the pending request list and index it by
+ *              frame number. Requests come in frame number order, which
+ *              keeps the list sorted.
+ *
+ * PARAMETERS :
+ *   @request : request to book-keep
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera3HardwareInterface::addPendingRequest(
+        const PendingRequestInfo &request)
+{
+    mPendingRequestsList.push_back(request);
+    pendingRequestIterator i = mPendingRequestsList.end();
+    i--;
+    if (mPendingRequestsIndex.add(request.frame_number, i) != NO_ERROR) {
+        ALOGE("%s: Failed to index pending request %d", __func__,
+                request.frame_number);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : findPendingRequest
+ *
+ * DESCRIPTION: Look up a pending request by frame number
+ *
+ * PARAMETERS :
+ *   @frame_number : frame number of the request
+ *
+ * RETURN     : position of the request in mPendingRequestsList, or end()
+ *              if it is not pending
+ *==========================================================================*/
+QCamera3HardwareInterface::pendingRequestIterator
+        QCamera3HardwareInterface::findPendingRequest(uint32_t frame_number)
+{
+    pendingRequestIterator *i = mPendingRequestsIndex.find(frame_number);
+    return (i == NULL) ? mPendingRequestsList.end() : *i;
+}
+
+/*===========================================================================
+ * FUNCTION   : erasePendingRequest
+ *
+ * DESCRIPTION: Remove a request from the pending request list and its index
+ *
+ * PARAMETERS :
+ *   @i : position of the request in mPendingRequestsList
+ *
+ * RETURN     : position of the next request
+ *==========================================================================*/
+QCamera3HardwareInterface::pendingRequestIterator
+        QCamera3HardwareInterface::erasePendingRequest(pendingRequestIterator i)
+{
+    mPendingRequestsIndex.remove(i->frame_number);
+    return mPendingRequestsList.erase(i);
+}
+
+/*===========================================================================
+ * FUNCTION   : clearPendingRequests
+ *
+ * DESCRIPTION: Drop all pending requests
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera3HardwareInterface::clearPendingRequests()
+{
+    mPendingRequestsIndex.clear();
+    mPendingRequestsList.clear();
+}
+
+/*===========================================================================
+ * FUNCTION   : addPendingBuffer
+ *
+ * DESCRIPTION: Append a buffer to the pending buffer list and index it by
+ *              buffer handle. num_buffers is left to the caller.
+ *
+ * PARAMETERS :
+ *   @info : buffer to book-keep
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera3HardwareInterface::addPendingBuffer(const PendingBufferInfo &info)
+{
+    mPendingBuffersMap.mPendingBufferList.push_back(info);
+    pendingBufferIterator k = mPendingBuffersMap.mPendingBufferList.end();
+    k--;
+    if (mPendingBuffersIndex.add(info.buffer, k) != NO_ERROR) {
+        ALOGE("%s: Failed to index pending buffer %p", __func__, info.buffer);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : findPendingBuffer
+ *
+ * DESCRIPTION: Look up a pending buffer by buffer handle
+ *
+ * PARAMETERS :
+ *   @buffer : buffer handle
+ *
+ * RETURN     : position of the buffer in mPendingBufferList, or end() if it
+ *              is not pending
+ *==========================================================================*/
+QCamera3HardwareInterface::pendingBufferIterator
+        QCamera3HardwareInterface::findPendingBuffer(buffer_handle_t *buffer)
+{
+    pendingBufferIterator *k = mPendingBuffersIndex.find(buffer);
+    return (k == NULL) ? mPendingBuffersMap.mPendingBufferList.end() : *k;
+}
+
+/*===========================================================================
+ * FUNCTION   : erasePendingBuffer
+ *
+ * DESCRIPTION: Remove a buffer from the pending buffer list and its index.
+ *              num_buffers is left to the caller.
+ *
+ * PARAMETERS :
+ *   @k : position of the buffer in mPendingBufferList
+ *
+ * RETURN     : position of the next buffer
+ *==========================================================================*/
+QCamera3HardwareInterface::pendingBufferIterator
+        QCamera3HardwareInterface::erasePendingBuffer(pendingBufferIterator k)
+{
+    mPendingBuffersIndex.remove(k->buffer);
+    return mPendingBuffersMap.mPendingBufferList.erase(k);
+}
+
+/*===========================================================================
+ * FUNCTION   : clearPendingBuffers
+ *
+ * DESCRIPTION: Drop all pending buffers. num_buffers is left to the caller.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera3HardwareInterface::clearPendingBuffers()
+{
+    mPendingBuffersIndex.clear();
+    mPendingBuffersMap.mPendingBufferList.clear();
+}
+
 /*===========================================================================
  * FUNCTION   : processCaptureRequest
  *
@@ -2871,7 +2999,7 @@ int QCamera3HardwareInterface::processCaptureRequest(
         bufferInfo.frame_number = frameNumber;
         bufferInfo.buffer = request->output_buffers[i].buffer;
         bufferInfo.stream = request->output_buffers[i].stream;
-        mPendingBuffersMap.mPendingBufferList.push_back(bufferInfo);
+        addPendingBuffer(bufferInfo);
         mPendingBuffersMap.num_buffers++;
         QCamera3Channel *channel = (QCamera3Channel *)bufferInfo.stream->priv;
         CDBG("%s: frame = %d, buffer = %p, streamTypeMask = %d, stream format = %d",
@@ -2881,7 +3009,7 @@ int QCamera3HardwareInterface::processCaptureRequest(
     CDBG("%s: mPendingBuffersMap.num_buffers = %d",
           __func__, mPendingBuffersMap.num_buffers);
 
-    mPendingRequestsList.push_back(pendingRequest);
+    addPendingRequest(pendingRequest);
 
     if (mFlush) {
         pthread_mutex_unlock(&mMutex);
@@ -3135,7 +3263,7 @@ int QCamera3HardwareInterface::flush()
             }
 
             mPendingBuffersMap.num_buffers--;
-            k = mPendingBuffersMap.mPendingBufferList.erase(k);
+            k = erasePendingBuffer(k);
         } else {
             k++;
         }
@@ -3203,7 +3331,7 @@ int QCamera3HardwareInterface::flush()
         }
 
         mPendingBuffersMap.num_buffers--;
-        k = mPendingBuffersMap.mPendingBufferList.erase(k);
+        k = erasePendingBuffer(k);
     }
 
     // Go through the pending requests info and send error request to framework
@@ -3248,13 +3376,13 @@ int QCamera3HardwareInterface::flush()
     }
 
     /* Reset pending buffer list and requests list */
-    mPendingRequestsList.clear();
+    clearPendingRequests();
     /* Reset pending frame Drop list and requests list */
     mPendingFrameDropList.clear();
 
     flushMap.clear();
     mPendingBuffersMap.num_buffers = 0;
-    mPendingBuffersMap.mPendingBufferList.clear();
+    clearPendingBuffers();
     mPendingReprocessResultList.clear();
     CDBG("%s: Cleared all the pending buffers ", __func__);
 
@@ -3407,7 +3535,7 @@ int QCamera3HardwareInterface::flushPerf()
                         flushMap.editValueFor(k->frame_number);
                 pending.add(*k);
             }
-            k = mPendingBuffersMap.mPendingBufferList.erase(k);
+            k = erasePendingBuffer(k);
         } else {
             k++;
         }
@@ -3474,7 +3602,7 @@ int QCamera3HardwareInterface::flushPerf()
                     flushMap.editValueFor(k->frame_number);
             pending.add(*k);
         }
-        k = mPendingBuffersMap.mPendingBufferList.erase(k);
+        k = erasePendingBuffer(k);
     }
 
     // Go through the pending requests info and send error request to framework
@@ -3520,13 +3648,13 @@ int QCamera3HardwareInterface::flushPerf()
     }
 
     /* Reset pending buffer list and requests list */
-    mPendingRequestsList.clear();
+    clearPendingRequests();
     /* Reset pending frame Drop list and requests list */
     mPendingFrameDropList.clear();
 
     flushMap.clear();
     mPendingBuffersMap.num_buffers = 0;
-    mPendingBuffersMap.mPendingBufferList.clear();
+    clearPendingBuffers();
     mPendingReprocessResultList.clear();
     CDBG("%s: Cleared all the pending buffers ", __func__);
 
@@ -3673,8 +3801,11 @@ QCamera3HardwareInterface::translateFromHalMetadata(
                                  uint8_t capture_intent,
                                  uint8_t fwk_cacMode)
 {
-    CameraMetadata camMetadata;
+    // Reserve what the previous results needed so that the updates below
+    // do not reallocate the metadata over and over
+    CameraMetadata camMetadata(mResultEntryHint, mResultDataHint);
     camera_metadata_t *resultMetadata;
+    uint64_t validMask[QCAMERA3_META_MASK_WORDS];
 
     if (jpegMetadata.entryCount())
         camMetadata.append(jpegMetadata);
@@ -3684,9 +3815,15 @@ QCamera3HardwareInterface::translateFromHalMetadata(
     camMetadata.update(ANDROID_REQUEST_PIPELINE_DEPTH, &pipeline_depth, 1);
     camMetadata.update(ANDROID_CONTROL_CAPTURE_INTENT, &capture_intent, 1);
 
-    IF_META_AVAILABLE(uint32_t, frame_number, CAM_INTF_META_FRAME_NUMBER, metadata) {
-        int64_t fwk_frame_number = *frame_number;
-        camMetadata.update(ANDROID_SYNC_FRAME_NUMBER, &fwk_frame_number, 1);
+    // Parameters mapping one to one on a framework tag, visiting only the
+    // valid ones
+    if (QCamera3MetaTable::getValidMask(metadata, validMask)) {
+        resultMetadata = camMetadata.release();
+        if (NO_ERROR != QCamera3MetaTable::translate(metadata, validMask,
+                &resultMetadata)) {
+            ALOGE("%s: Table translation failed", __func__);
+        }
+        camMetadata.acquire(resultMetadata);
     }
 
     IF_META_AVAILABLE(cam_fps_range_t, float_range, CAM_INTF_PARM_FPS_RANGE, metadata) {
@@ -3699,10 +3836,6 @@ QCamera3HardwareInterface::translateFromHalMetadata(
             __func__, fps_range[0], fps_range[1]);
     }
 
-    IF_META_AVAILABLE(int32_t, expCompensation, CAM_INTF_PARM_EXPOSURE_COMPENSATION, metadata) {
-        camMetadata.update(ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION, expCompensation, 1);
-    }
-
     /* HFR and BEST_MODE need to be both available to derive SCENE_MODE
      * Framework sets scenemode to indicate HFR and hence corresponding
      * translatation is required from hfr mode to scenemode */
@@ -3730,36 +3863,12 @@ QCamera3HardwareInterface::translateFromHalMetadata(
                 __func__, fwkSceneMode);
     }
 
-    IF_META_AVAILABLE(uint32_t, ae_lock, CAM_INTF_PARM_AEC_LOCK, metadata) {
-        uint8_t fwk_ae_lock = (uint8_t) *ae_lock;
-        camMetadata.update(ANDROID_CONTROL_AE_LOCK, &fwk_ae_lock, 1);
-    }
-
-    IF_META_AVAILABLE(uint32_t, awb_lock, CAM_INTF_PARM_AWB_LOCK, metadata) {
-        uint8_t fwk_awb_lock = (uint8_t) *awb_lock;
-        camMetadata.update(ANDROID_CONTROL_AWB_LOCK, &fwk_awb_lock, 1);
-    }
-
-    IF_META_AVAILABLE(uint32_t, color_correct_mode, CAM_INTF_META_COLOR_CORRECT_MODE, metadata) {
-        uint8_t fwk_color_correct_mode = (uint8_t) *color_correct_mode;
-        camMetadata.update(ANDROID_COLOR_CORRECTION_MODE, &fwk_color_correct_mode, 1);
-    }
-
     IF_META_AVAILABLE(cam_edge_application_t, edgeApplication,
             CAM_INTF_META_EDGE_MODE, metadata) {
         camMetadata.update(ANDROID_EDGE_MODE, &(edgeApplication->edge_mode), 1);
         camMetadata.update(ANDROID_EDGE_STRENGTH, &edgeStrength, 1);
     }
 
-    IF_META_AVAILABLE(uint32_t, flashPower, CAM_INTF_META_FLASH_POWER, metadata) {
-        uint8_t fwk_flashPower = (uint8_t) *flashPower;
-        camMetadata.update(ANDROID_FLASH_FIRING_POWER, &fwk_flashPower, 1);
-    }
-
-    IF_META_AVAILABLE(int64_t, flashFiringTime, CAM_INTF_META_FLASH_FIRING_TIME, metadata) {
-        camMetadata.update(ANDROID_FLASH_FIRING_TIME, flashFiringTime, 1);
-    }
-
     IF_META_AVAILABLE(int32_t, flashState, CAM_INTF_META_FLASH_STATE, metadata) {
         if (0 <= *flashState) {
             uint8_t fwk_flashState = (uint8_t) *flashState;
@@ -3778,42 +3887,10 @@ QCamera3HardwareInterface::translateFromHalMetadata(
         }
     }
 
-    IF_META_AVAILABLE(uint32_t, hotPixelMode, CAM_INTF_META_HOTPIXEL_MODE, metadata) {
-        uint8_t fwk_hotPixelMode = (uint8_t) *hotPixelMode;
-        camMetadata.update(ANDROID_HOT_PIXEL_MODE, &fwk_hotPixelMode, 1);
-    }
-
-    IF_META_AVAILABLE(float, lensAperture, CAM_INTF_META_LENS_APERTURE, metadata) {
-        camMetadata.update(ANDROID_LENS_APERTURE , lensAperture, 1);
-    }
-
-    IF_META_AVAILABLE(float, filterDensity, CAM_INTF_META_LENS_FILTERDENSITY, metadata) {
-        camMetadata.update(ANDROID_LENS_FILTER_DENSITY , filterDensity, 1);
-    }
-
-    IF_META_AVAILABLE(float, focalLength, CAM_INTF_META_LENS_FOCAL_LENGTH, metadata) {
-        camMetadata.update(ANDROID_LENS_FOCAL_LENGTH, focalLength, 1);
-    }
-
-    IF_META_AVAILABLE(uint32_t, opticalStab, CAM_INTF_META_LENS_OPT_STAB_MODE, metadata) {
-        uint8_t fwk_opticalStab = (uint8_t) *opticalStab;
-        camMetadata.update(ANDROID_LENS_OPTICAL_STABILIZATION_MODE, &fwk_opticalStab, 1);
-    }
-
     /*EIS is currently not hooked up to the app, so set the mode to OFF*/
     uint8_t vsMode = ANDROID_CONTROL_VIDEO_STABILIZATION_MODE_OFF;
     camMetadata.update(ANDROID_CONTROL_VIDEO_STABILIZATION_MODE, &vsMode, 1);
 
-    IF_META_AVAILABLE(uint32_t, noiseRedMode, CAM_INTF_META_NOISE_REDUCTION_MODE, metadata) {
-        uint8_t fwk_noiseRedMode = (uint8_t) *noiseRedMode;
-        camMetadata.update(ANDROID_NOISE_REDUCTION_MODE, &fwk_noiseRedMode, 1);
-    }
-
-    IF_META_AVAILABLE(uint32_t, noiseRedStrength, CAM_INTF_META_NOISE_REDUCTION_STRENGTH, metadata) {
-        uint8_t fwk_noiseRedStrength = (uint8_t) *noiseRedStrength;
-        camMetadata.update(ANDROID_NOISE_REDUCTION_STRENGTH, &fwk_noiseRedStrength, 1);
-    }
-
     IF_META_AVAILABLE(cam_crop_region_t, hScalerCropRegion,
             CAM_INTF_META_SCALER_CROP_REGION, metadata) {
         int32_t scalerCropRegion[4];
@@ -3830,24 +3907,6 @@ QCamera3HardwareInterface::translateFromHalMetadata(
         camMetadata.update(ANDROID_SCALER_CROP_REGION, scalerCropRegion, 4);
     }
 
-    IF_META_AVAILABLE(int64_t, sensorExpTime, CAM_INTF_META_SENSOR_EXPOSURE_TIME, metadata) {
-        CDBG("%s: sensorExpTime = %lld", __func__, *sensorExpTime);
-        camMetadata.update(ANDROID_SENSOR_EXPOSURE_TIME , sensorExpTime, 1);
-    }
-
-    IF_META_AVAILABLE(int64_t, sensorFameDuration,
-            CAM_INTF_META_SENSOR_FRAME_DURATION, metadata) {
-        CDBG("%s: sensorFameDuration = %lld", __func__, *sensorFameDuration);
-        camMetadata.update(ANDROID_SENSOR_FRAME_DURATION, sensorFameDuration, 1);
-    }
-
-    IF_META_AVAILABLE(int64_t, sensorRollingShutterSkew,
-            CAM_INTF_META_SENSOR_ROLLING_SHUTTER_SKEW, metadata) {
-        CDBG("%s: sensorRollingShutterSkew = %lld", __func__, *sensorRollingShutterSkew);
-        camMetadata.update(ANDROID_SENSOR_ROLLING_SHUTTER_SKEW,
-                sensorRollingShutterSkew, 1);
-    }
-
     IF_META_AVAILABLE(int32_t, sensorSensitivity, CAM_INTF_META_SENSOR_SENSITIVITY, metadata) {
         CDBG("%s: sensorSensitivity = %d", __func__, *sensorSensitivity);
         camMetadata.update(ANDROID_SENSOR_SENSITIVITY, sensorSensitivity, 1);
@@ -3866,11 +3925,6 @@ QCamera3HardwareInterface::translateFromHalMetadata(
                 (size_t) (2 * gCamCapability[mCameraId]->num_color_channels));
     }
 
-    IF_META_AVAILABLE(uint32_t, shadingMode, CAM_INTF_META_SHADING_MODE, metadata) {
-        uint8_t fwk_shadingMode = (uint8_t) *shadingMode;
-        camMetadata.update(ANDROID_SHADING_MODE, &fwk_shadingMode, 1);
-    }
-
     IF_META_AVAILABLE(uint32_t, faceDetectMode, CAM_INTF_META_STATS_FACEDETECT_MODE, metadata) {
         int val = lookupFwkName(FACEDETECT_MODES_MAP, METADATA_MAP_SIZE(FACEDETECT_MODES_MAP),
                 *faceDetectMode);
@@ -3935,17 +3989,6 @@ QCamera3HardwareInterface::translateFromHalMetadata(
         }
     }
 
-    IF_META_AVAILABLE(uint32_t, histogramMode, CAM_INTF_META_STATS_HISTOGRAM_MODE, metadata) {
-        uint8_t fwk_histogramMode = (uint8_t) *histogramMode;
-        camMetadata.update(ANDROID_STATISTICS_HISTOGRAM_MODE, &fwk_histogramMode, 1);
-    }
-
-    IF_META_AVAILABLE(uint32_t, sharpnessMapMode,
-            CAM_INTF_META_STATS_SHARPNESS_MAP_MODE, metadata) {
-        uint8_t fwk_sharpnessMapMode = (uint8_t) *sharpnessMapMode;
-        camMetadata.update(ANDROID_STATISTICS_SHARPNESS_MAP_MODE, &fwk_sharpnessMapMode, 1);
-    }
-
     IF_META_AVAILABLE(cam_sharpness_map_t, sharpnessMap,
             CAM_INTF_META_STATS_SHARPNESS_MAP, metadata) {
         camMetadata.update(ANDROID_STATISTICS_SHARPNESS_MAP, (int32_t *)sharpnessMap->sharpness,
@@ -3962,11 +4005,6 @@ QCamera3HardwareInterface::translateFromHalMetadata(
                 lensShadingMap->lens_shading, 4U * map_width * map_height);
     }
 
-    IF_META_AVAILABLE(uint32_t, toneMapMode, CAM_INTF_META_TONEMAP_MODE, metadata) {
-        uint8_t fwk_toneMapMode = (uint8_t) *toneMapMode;
-        camMetadata.update(ANDROID_TONEMAP_MODE, &fwk_toneMapMode, 1);
-    }
-
     IF_META_AVAILABLE(cam_rgb_tonemap_curves, tonemap, CAM_INTF_META_TONEMAP_CURVES, metadata) {
         //Populate CAM_INTF_META_TONEMAP_CURVES
         /* ch0 = G, ch 1 = B, ch 2 = R*/
@@ -4029,20 +4067,6 @@ QCamera3HardwareInterface::translateFromHalMetadata(
                 CC_MATRIX_ROWS * CC_MATRIX_COLS);
     }
 
-    IF_META_AVAILABLE(float, otpWbGrGb, CAM_INTF_META_OTP_WB_GRGB, metadata) {
-        camMetadata.update(ANDROID_SENSOR_GREEN_SPLIT, otpWbGrGb, 1);
-    }
-
-    IF_META_AVAILABLE(uint32_t, blackLevelLock, CAM_INTF_META_BLACK_LEVEL_LOCK, metadata) {
-        uint8_t fwk_blackLevelLock = (uint8_t) *blackLevelLock;
-        camMetadata.update(ANDROID_BLACK_LEVEL_LOCK, &fwk_blackLevelLock, 1);
-    }
-
-    IF_META_AVAILABLE(uint32_t, sceneFlicker, CAM_INTF_META_SCENE_FLICKER, metadata) {
-        uint8_t fwk_sceneFlicker = (uint8_t) *sceneFlicker;
-        camMetadata.update(ANDROID_STATISTICS_SCENE_FLICKER, &fwk_sceneFlicker, 1);
-    }
-
     IF_META_AVAILABLE(uint32_t, effectMode, CAM_INTF_PARM_EFFECT, metadata) {
         int val = lookupFwkName(EFFECT_MODES_MAP, METADATA_MAP_SIZE(EFFECT_MODES_MAP),
                 *effectMode);
@@ -4081,33 +4105,11 @@ QCamera3HardwareInterface::translateFromHalMetadata(
         camMetadata.update(ANDROID_SENSOR_TEST_PATTERN_DATA, fwk_testPatternData, 4);
     }
 
-    IF_META_AVAILABLE(double, gps_coords, CAM_INTF_META_JPEG_GPS_COORDINATES, metadata) {
-        camMetadata.update(ANDROID_JPEG_GPS_COORDINATES, gps_coords, 3);
-    }
-
     IF_META_AVAILABLE(uint8_t, gps_methods, CAM_INTF_META_JPEG_GPS_PROC_METHODS, metadata) {
         String8 str((const char *)gps_methods);
         camMetadata.update(ANDROID_JPEG_GPS_PROCESSING_METHOD, str);
     }
 
-    IF_META_AVAILABLE(int64_t, gps_timestamp, CAM_INTF_META_JPEG_GPS_TIMESTAMP, metadata) {
-        camMetadata.update(ANDROID_JPEG_GPS_TIMESTAMP, gps_timestamp, 1);
-    }
-
-    IF_META_AVAILABLE(int32_t, jpeg_orientation, CAM_INTF_META_JPEG_ORIENTATION, metadata) {
-        camMetadata.update(ANDROID_JPEG_ORIENTATION, jpeg_orientation, 1);
-    }
-
-    IF_META_AVAILABLE(uint32_t, jpeg_quality, CAM_INTF_META_JPEG_QUALITY, metadata) {
-        uint8_t fwk_jpeg_quality = (uint8_t) *jpeg_quality;
-        camMetadata.update(ANDROID_JPEG_QUALITY, &fwk_jpeg_quality, 1);
-    }
-
-    IF_META_AVAILABLE(uint32_t, thumb_quality, CAM_INTF_META_JPEG_THUMB_QUALITY, metadata) {
-        uint8_t fwk_thumb_quality = (uint8_t) *thumb_quality;
-        camMetadata.update(ANDROID_JPEG_THUMBNAIL_QUALITY, &fwk_thumb_quality, 1);
-    }
-
     IF_META_AVAILABLE(cam_dimension_t, thumb_size, CAM_INTF_META_JPEG_THUMB_SIZE, metadata) {
         int32_t fwk_thumb_size[2];
         fwk_thumb_size[0] = thumb_size->width;
@@ -4193,11 +4195,6 @@ QCamera3HardwareInterface::translateFromHalMetadata(
                 NEUTRAL_COL_POINTS);
     }
 
-    IF_META_AVAILABLE(uint32_t, shadingMapMode, CAM_INTF_META_LENS_SHADING_MAP_MODE, metadata) {
-        uint8_t fwk_shadingMapMode = (uint8_t) *shadingMapMode;
-        camMetadata.update(ANDROID_STATISTICS_LENS_SHADING_MAP_MODE, &fwk_shadingMapMode, 1);
-    }
-
     IF_META_AVAILABLE(cam_area_t, hAeRegions, CAM_INTF_META_AEC_ROI, metadata) {
         int32_t aeRegions[REGIONS_TUPLE_COUNT];
         // Adjust crop region from sensor output coordinate system to active
@@ -4252,11 +4249,6 @@ QCamera3HardwareInterface::translateFromHalMetadata(
         }
     }
 
-    IF_META_AVAILABLE(uint32_t, mode, CAM_INTF_META_MODE, metadata) {
-         uint8_t fwk_mode = (uint8_t) *mode;
-         camMetadata.update(ANDROID_CONTROL_MODE, &fwk_mode, 1);
-    }
-
     /* Constant metadata values to be update*/
     uint8_t hotPixelModeFast = ANDROID_HOT_PIXEL_MODE_FAST;
     camMetadata.update(ANDROID_HOT_PIXEL_MODE, &hotPixelModeFast, 1);
@@ -4401,6 +4393,12 @@ QCamera3HardwareInterface::translateFromHalMetadata(
     }
 
     resultMetadata = camMetadata.release();
+    if (NULL != resultMetadata) {
+        mResultEntryHint = MAX(mResultEntryHint,
+                get_camera_metadata_entry_count(resultMetadata));
+        mResultDataHint = MAX(mResultDataHint,
+                get_camera_metadata_data_count(resultMetadata));
+    }
     return resultMetadata;
 }
 
@@ -4719,6 +4717,37 @@ void QCamera3HardwareInterface::dumpMetadataToFile(tuning_params_t &meta,
     }
 }
 
+/*===========================================================================
+ * FUNCTION   : dumpMetaBufferToFile
+ *
+ * DESCRIPTION: Dumps a whole metadata buffer to file system, as input for
+ *              the metadata translation benchmark
+ *
+ * PARAMETERS :
+ *   @metadata    : metadata buffer from the backend
+ *   @frameNumber : frame number of the result
+ *
+ *==========================================================================*/
+void QCamera3HardwareInterface::dumpMetaBufferToFile(metadata_buffer_t *metadata,
+        uint32_t frameNumber)
+{
+    char buf[FILENAME_MAX];
+    memset(buf, 0, sizeof(buf));
+    snprintf(buf, sizeof(buf), QCAMERA_DUMP_FRM_LOCATION"metabuf_%d_%d.bin",
+            mCameraId, frameNumber);
+
+    int file_fd = open(buf, O_RDWR | O_CREAT | O_TRUNC, 0777);
+    if (file_fd >= 0) {
+        ssize_t written_len = write(file_fd, metadata, sizeof(metadata_buffer_t));
+        if (written_len != (ssize_t)sizeof(metadata_buffer_t)) {
+            ALOGE("%s: short write of %s", __func__, buf);
+        }
+        close(file_fd);
+    } else {
+        ALOGE("%s: fail to open file for metadata buffer dumping", __func__);
+    }
+}
+
 /*===========================================================================
  * FUNCTION   : cleanAndSortStreamInfo
  *
@@ -41,6 +41,7 @@
 
 #include "QCamera3Channel.h"
 #include "QCamera3CropRegionMapper.h"
+#include "QCamera3PendingIndex.h"
 
 #include <hardware/power.h>
 
@@ -222,6 +223,7 @@ private:
     void unblockRequestIfNecessary();
     void dumpMetadataToFile(tuning_params_t &meta, uint32_t &dumpFrameCount,
             bool enabled, const char *type, uint32_t frameNumber);
+    void dumpMetaBufferToFile(metadata_buffer_t *metadata, uint32_t frameNumber);
     static void getLogLevel();
 
     void cleanAndSortStreamInfo();
@@ -324,11 +326,28 @@ private:
     } PendingReprocessResult;
 
     typedef KeyedVector<uint32_t, Vector<PendingBufferInfo> > FlushMap;
+    typedef List<PendingRequestInfo>::iterator pendingRequestIterator;
+    typedef List<PendingBufferInfo>::iterator pendingBufferIterator;
+
+    // Keep the pending lists and their indices in sync
+    void addPendingRequest(const PendingRequestInfo &request);
+    pendingRequestIterator findPendingRequest(uint32_t frame_number);
+    pendingRequestIterator erasePendingRequest(pendingRequestIterator i);
+    void clearPendingRequests();
+    void addPendingBuffer(const PendingBufferInfo &info);
+    pendingBufferIterator findPendingBuffer(buffer_handle_t *buffer);
+    pendingBufferIterator erasePendingBuffer(pendingBufferIterator k);
+    void clearPendingBuffers();
 
     List<PendingReprocessResult> mPendingReprocessResultList;
     List<PendingRequestInfo> mPendingRequestsList;
     List<PendingFrameDropInfo> mPendingFrameDropList;
     PendingBuffersMap mPendingBuffersMap;
+    // Positions in mPendingRequestsList by frame number
+    QCamera3PendingIndex<uint32_t, pendingRequestIterator> mPendingRequestsIndex;
+    // Positions in mPendingBuffersMap.mPendingBufferList by buffer handle
+    QCamera3PendingIndex<buffer_handle_t *, pendingBufferIterator>
+            mPendingBuffersIndex;
     pthread_cond_t mRequestCond;
     int mPendingRequest;
     bool mWokenUpByDaemon;
@@ -349,6 +368,7 @@ private:
     power_module_t *m_pPowerModule;   // power module
 
     uint32_t mMetaFrameCount;
+    uint32_t mMetaBufDumpCount;
     bool    mUpdateDebugLevel;
     const camera_module_callbacks_t *mCallbacks;
 
@@ -395,6 +415,9 @@ private:
     cam_fps_range_t mFpsRange;
     //The offset between BOOTTIME and MONOTONIC timestamps
     nsecs_t mBootToMonoTimestampOffset;
+    //Largest result metadata so far, reserved up front for the next one
+    size_t mResultEntryHint;
+    size_t mResultDataHint;
 };
 
 }; // namespace qcamera
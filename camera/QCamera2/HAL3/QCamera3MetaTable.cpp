@@ -0,0 +1,381 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#define LOG_TAG "QCamera3MetaTable"
+
+#include <pthread.h>
+#include <string.h>
+#include <utils/Errors.h>
+#include <utils/Log.h>
+#include "QCamera3MetaTable.h"
+
+using namespace android;
+
+namespace qcamera {
+
+#define META_INDEX_NONE     0xFF
+
+/* Parameters with a single framework entry each, no tag twice */
+const qcamera3_meta_entry_t QCamera3MetaTable::sEntries[] = {
+    QCAMERA3_META_ENTRY(CAM_INTF_META_FRAME_NUMBER,
+            ANDROID_SYNC_FRAME_NUMBER, QCAMERA3_META_U32_TO_I64),
+    QCAMERA3_META_ENTRY(CAM_INTF_PARM_EXPOSURE_COMPENSATION,
+            ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION, QCAMERA3_META_COPY),
+    QCAMERA3_META_ENTRY(CAM_INTF_PARM_AEC_LOCK,
+            ANDROID_CONTROL_AE_LOCK, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_PARM_AWB_LOCK,
+            ANDROID_CONTROL_AWB_LOCK, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_COLOR_CORRECT_MODE,
+            ANDROID_COLOR_CORRECTION_MODE, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_FLASH_POWER,
+            ANDROID_FLASH_FIRING_POWER, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_FLASH_FIRING_TIME,
+            ANDROID_FLASH_FIRING_TIME, QCAMERA3_META_COPY),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_HOTPIXEL_MODE,
+            ANDROID_HOT_PIXEL_MODE, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_LENS_APERTURE,
+            ANDROID_LENS_APERTURE, QCAMERA3_META_COPY),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_LENS_FILTERDENSITY,
+            ANDROID_LENS_FILTER_DENSITY, QCAMERA3_META_COPY),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_LENS_FOCAL_LENGTH,
+            ANDROID_LENS_FOCAL_LENGTH, QCAMERA3_META_COPY),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_LENS_OPT_STAB_MODE,
+            ANDROID_LENS_OPTICAL_STABILIZATION_MODE, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_NOISE_REDUCTION_MODE,
+            ANDROID_NOISE_REDUCTION_MODE, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_NOISE_REDUCTION_STRENGTH,
+            ANDROID_NOISE_REDUCTION_STRENGTH, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_SENSOR_EXPOSURE_TIME,
+            ANDROID_SENSOR_EXPOSURE_TIME, QCAMERA3_META_COPY),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_SENSOR_FRAME_DURATION,
+            ANDROID_SENSOR_FRAME_DURATION, QCAMERA3_META_COPY),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_SENSOR_ROLLING_SHUTTER_SKEW,
+            ANDROID_SENSOR_ROLLING_SHUTTER_SKEW, QCAMERA3_META_COPY),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_SHADING_MODE,
+            ANDROID_SHADING_MODE, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_STATS_HISTOGRAM_MODE,
+            ANDROID_STATISTICS_HISTOGRAM_MODE, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_STATS_SHARPNESS_MAP_MODE,
+            ANDROID_STATISTICS_SHARPNESS_MAP_MODE, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_TONEMAP_MODE,
+            ANDROID_TONEMAP_MODE, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_OTP_WB_GRGB,
+            ANDROID_SENSOR_GREEN_SPLIT, QCAMERA3_META_COPY),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_BLACK_LEVEL_LOCK,
+            ANDROID_BLACK_LEVEL_LOCK, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_SCENE_FLICKER,
+            ANDROID_STATISTICS_SCENE_FLICKER, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_JPEG_GPS_COORDINATES,
+            ANDROID_JPEG_GPS_COORDINATES, QCAMERA3_META_COPY),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_JPEG_GPS_TIMESTAMP,
+            ANDROID_JPEG_GPS_TIMESTAMP, QCAMERA3_META_COPY),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_JPEG_ORIENTATION,
+            ANDROID_JPEG_ORIENTATION, QCAMERA3_META_COPY),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_JPEG_QUALITY,
+            ANDROID_JPEG_QUALITY, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_JPEG_THUMB_QUALITY,
+            ANDROID_JPEG_THUMBNAIL_QUALITY, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_LENS_SHADING_MAP_MODE,
+            ANDROID_STATISTICS_LENS_SHADING_MAP_MODE, QCAMERA3_META_U32_TO_U8),
+    QCAMERA3_META_ENTRY(CAM_INTF_META_MODE,
+            ANDROID_CONTROL_MODE, QCAMERA3_META_U32_TO_U8),
+};
+
+uint8_t QCamera3MetaTable::sIndex[CAM_INTF_PARM_MAX];
+
+static pthread_once_t gMetaIndexOnce = PTHREAD_ONCE_INIT;
+
+/*===========================================================================
+ * FUNCTION   : initIndex
+ *
+ * DESCRIPTION: build the parameter to table entry index, leaving out entries
+ *              whose converter does not match the framework tag type
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3MetaTable::initIndex()
+{
+    memset(sIndex, META_INDEX_NONE, sizeof(sIndex));
+
+    for (size_t i = 0; i < getEntryCount(); i++) {
+        const qcamera3_meta_entry_t &e = sEntries[i];
+        int type = get_camera_metadata_tag_type(e.tag);
+        bool valid;
+
+        switch (e.conv) {
+        case QCAMERA3_META_COPY:
+            valid = (type >= 0) && (type < NUM_TYPES) &&
+                    (e.elemSize == camera_metadata_type_size[type]);
+            break;
+        case QCAMERA3_META_U32_TO_U8:
+            valid = (type == TYPE_BYTE) && (e.elemSize == sizeof(uint32_t)) &&
+                    (e.count == 1);
+            break;
+        case QCAMERA3_META_U32_TO_I64:
+            valid = (type == TYPE_INT64) && (e.elemSize == sizeof(uint32_t)) &&
+                    (e.count == 1);
+            break;
+        default:
+            valid = false;
+            break;
+        }
+
+        if (!valid || (META_INDEX_NONE != sIndex[e.id])) {
+            ALOGE("%s: Invalid entry for parameter %d tag 0x%x",
+                    __func__, e.id, e.tag);
+            continue;
+        }
+        sIndex[e.id] = (uint8_t)i;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : getValidMask
+ *
+ * DESCRIPTION: pack the is_valid flags of a metadata buffer into a bitmap,
+ *              eight flags at a time
+ *
+ * PARAMETERS :
+ *   @metadata : metadata buffer from the backend
+ *   @mask     : QCAMERA3_META_MASK_WORDS words, bit n set if parameter n
+ *               is valid
+ *
+ * RETURN     : number of valid parameters
+ *==========================================================================*/
+uint32_t QCamera3MetaTable::getValidMask(const metadata_buffer_t *metadata,
+        uint64_t *mask)
+{
+    const uint8_t *valid = metadata->is_valid;
+    uint32_t count = 0;
+    size_t i = 0;
+
+    memset(mask, 0, QCAMERA3_META_MASK_WORDS * sizeof(uint64_t));
+
+    for (; i + 8 <= CAM_INTF_PARM_MAX; i += 8) {
+        uint64_t w;
+        memcpy(&w, valid + i, sizeof(w));
+        if (!w) {
+            continue;
+        }
+        // High bit of each byte set if the byte is non zero, then gather
+        // the eight high bits into the low byte (little endian flag order)
+        w = (((w & 0x7f7f7f7f7f7f7f7fULL) + 0x7f7f7f7f7f7f7f7fULL) | w) &
+                0x8080808080808080ULL;
+        uint64_t bits = ((w >> 7) * 0x0102040810204080ULL) >> 56;
+        mask[i / 64] |= bits << (i % 64);
+        count += (uint32_t)__builtin_popcountll(bits);
+    }
+    for (; i < CAM_INTF_PARM_MAX; i++) {
+        if (valid[i]) {
+            mask[i / 64] |= 1ULL << (i % 64);
+            count++;
+        }
+    }
+    return count;
+}
+
+/*===========================================================================
+ * FUNCTION   : translate
+ *
+ * DESCRIPTION: add the framework entries of the table parameters set in the
+ *              validity bitmap
+ *
+ * PARAMETERS :
+ *   @metadata : metadata buffer from the backend
+ *   @mask     : validity bitmap from getValidMask
+ *   @result   : framework metadata, may be reallocated if it runs out of
+ *               space
+ *
+ * RETURN     : NO_ERROR on success
+ *              error code of the first failed update otherwise
+ *==========================================================================*/
+int32_t QCamera3MetaTable::translate(const metadata_buffer_t *metadata,
+        const uint64_t *mask, camera_metadata_t **result)
+{
+    const uint8_t *base = (const uint8_t *)metadata;
+    int32_t rc = NO_ERROR;
+
+    pthread_once(&gMetaIndexOnce, initIndex);
+
+    for (size_t w = 0; w < QCAMERA3_META_MASK_WORDS; w++) {
+        uint64_t bits = mask[w];
+        while (bits) {
+            size_t id = w * 64 + (size_t)__builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            uint8_t index = sIndex[id];
+            if (META_INDEX_NONE == index) {
+                continue;
+            }
+            const qcamera3_meta_entry_t &e = sEntries[index];
+            const void *src = base + e.offset;
+
+            switch (e.conv) {
+            case QCAMERA3_META_U32_TO_U8: {
+                uint8_t fwk_val = (uint8_t) *(const uint32_t *)src;
+                rc = update(result, e.tag, &fwk_val, 1);
+                break;
+            }
+            case QCAMERA3_META_U32_TO_I64: {
+                int64_t fwk_val = *(const uint32_t *)src;
+                rc = update(result, e.tag, &fwk_val, 1);
+                break;
+            }
+            default:
+                rc = update(result, e.tag, src, e.count);
+                break;
+            }
+            if (NO_ERROR != rc) {
+                ALOGE("%s: Failed to update tag 0x%x", __func__, e.tag);
+                return rc;
+            }
+        }
+    }
+    return rc;
+}
+
+/*===========================================================================
+ * FUNCTION   : reserve
+ *
+ * DESCRIPTION: make room for more entries and data, doubling the capacity
+ *              as CameraMetadata does
+ *
+ * PARAMETERS :
+ *   @result       : framework metadata, reallocated if too small
+ *   @extraEntries : entries to be added
+ *   @extraData    : data bytes to be added
+ *
+ * RETURN     : NO_ERROR on success
+ *              NO_MEMORY if the metadata could not be grown
+ *==========================================================================*/
+int32_t QCamera3MetaTable::reserve(camera_metadata_t **result,
+        size_t extraEntries, size_t extraData)
+{
+    size_t entries = get_camera_metadata_entry_count(*result) + extraEntries;
+    size_t data = get_camera_metadata_data_count(*result) + extraData;
+    size_t entryCap = get_camera_metadata_entry_capacity(*result);
+    size_t dataCap = get_camera_metadata_data_capacity(*result);
+
+    if ((entries <= entryCap) && (data <= dataCap)) {
+        return NO_ERROR;
+    }
+
+    if (entries > entryCap) {
+        entryCap = entries * 2;
+    }
+    if (data > dataCap) {
+        dataCap = data * 2;
+    }
+    camera_metadata_t *grown = allocate_camera_metadata(entryCap, dataCap);
+    if (NULL == grown) {
+        return NO_MEMORY;
+    }
+    if (OK != append_camera_metadata(grown, *result)) {
+        free_camera_metadata(grown);
+        return NO_MEMORY;
+    }
+    free_camera_metadata(*result);
+    *result = grown;
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : update
+ *
+ * DESCRIPTION: add an entry, or replace the data of an existing one, the
+ *              same way CameraMetadata::update does
+ *
+ * PARAMETERS :
+ *   @result : framework metadata, may be reallocated
+ *   @tag    : framework tag
+ *   @data   : entry data, in the type of the tag
+ *   @count  : number of elements
+ *
+ * RETURN     : NO_ERROR on success
+ *              error code otherwise
+ *==========================================================================*/
+int32_t QCamera3MetaTable::update(camera_metadata_t **result, uint32_t tag,
+        const void *data, size_t count)
+{
+    int type = get_camera_metadata_tag_type(tag);
+    camera_metadata_entry_t entry;
+    int32_t rc;
+
+    if (type < 0) {
+        return BAD_VALUE;
+    }
+    size_t dataSize = calculate_camera_metadata_entry_data_size(type, count);
+
+    if (OK != find_camera_metadata_entry(*result, tag, &entry)) {
+        rc = reserve(result, 1, dataSize);
+        if (NO_ERROR == rc) {
+            rc = add_camera_metadata_entry(*result, tag, data, count);
+        }
+    } else {
+        rc = reserve(result, 0, dataSize);
+        if (NO_ERROR == rc) {
+            rc = update_camera_metadata_entry(*result, entry.index, data,
+                    count, NULL);
+        }
+    }
+    return rc;
+}
+
+/*===========================================================================
+ * FUNCTION   : getEntryCount
+ *
+ * DESCRIPTION: number of entries of the translation table
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : entry count
+ *==========================================================================*/
+size_t QCamera3MetaTable::getEntryCount()
+{
+    return sizeof(sEntries) / sizeof(sEntries[0]);
+}
+
+/*===========================================================================
+ * FUNCTION   : getEntry
+ *
+ * DESCRIPTION: table entry at index
+ *
+ * PARAMETERS :
+ *   @index : entry index
+ *
+ * RETURN     : entry, NULL if index is out of range
+ *==========================================================================*/
+const qcamera3_meta_entry_t *QCamera3MetaTable::getEntry(size_t index)
+{
+    return (index < getEntryCount()) ? &sEntries[index] : NULL;
+}
+
+}; // namespace qcamera
@@ -0,0 +1,93 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef __QCAMERA3METATABLE_H__
+#define __QCAMERA3METATABLE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <system/camera_metadata.h>
+#include "cam_intf.h"
+
+namespace qcamera {
+
+/* How a HAL metadata parameter becomes a framework entry */
+typedef enum {
+    QCAMERA3_META_COPY,         /* same element type on both sides */
+    QCAMERA3_META_U32_TO_U8,    /* HAL enum to framework byte enum */
+    QCAMERA3_META_U32_TO_I64,   /* frame number */
+} qcamera3_meta_conv_t;
+
+typedef struct {
+    cam_intf_parm_type_t id;
+    uint32_t tag;
+    qcamera3_meta_conv_t conv;
+    uint32_t offset;    /* of the parameter in metadata_buffer_t */
+    uint32_t elemSize;
+    uint32_t count;
+} qcamera3_meta_entry_t;
+
+#define QCAMERA3_META_ENTRY(META_ID, TAG, CONV) \
+    { META_ID, TAG, CONV, \
+      (uint32_t)offsetof(metadata_buffer_t, data.member_variable_##META_ID), \
+      (uint32_t)sizeof(((metadata_buffer_t *)0)->data.member_variable_##META_ID[0]), \
+      (uint32_t)(sizeof(((metadata_buffer_t *)0)->data.member_variable_##META_ID) / \
+              sizeof(((metadata_buffer_t *)0)->data.member_variable_##META_ID[0])) }
+
+/* Words of the packed validity bitmap of a metadata buffer */
+#define QCAMERA3_META_MASK_WORDS    ((CAM_INTF_PARM_MAX + 63) / 64)
+
+/*
+ * Translates the metadata parameters that map one to one on a framework
+ * tag, from a compile time table. Parameters needing capability data,
+ * lookups or more than one entry stay with translateFromHalMetadata.
+ */
+class QCamera3MetaTable {
+public:
+    static uint32_t getValidMask(const metadata_buffer_t *metadata,
+            uint64_t *mask);
+    static int32_t translate(const metadata_buffer_t *metadata,
+            const uint64_t *mask, camera_metadata_t **result);
+    static int32_t update(camera_metadata_t **result, uint32_t tag,
+            const void *data, size_t count);
+    static size_t getEntryCount();
+    static const qcamera3_meta_entry_t *getEntry(size_t index);
+
+private:
+    static void initIndex();
+    static int32_t reserve(camera_metadata_t **result, size_t extraEntries,
+            size_t extraData);
+
+    static const qcamera3_meta_entry_t sEntries[];
+    static uint8_t sIndex[CAM_INTF_PARM_MAX];
+};
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA3METATABLE_H__ */
@@ -0,0 +1,246 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef __QCAMERA3PENDINGINDEX_H__
+#define __QCAMERA3PENDINGINDEX_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <new>
+#include <utils/Errors.h>
+
+namespace qcamera {
+
+#define QCAMERA3_PENDING_INDEX_INIT_SIZE 16
+
+/*
+ * Open addressing map from a key to a value, used to find entries of the
+ * pending request and buffer lists without walking them. Values are
+ * usually list iterators, so the lists keep delivery order.
+ *
+ * Frame numbers hash to themselves: the frames in flight are a moving
+ * window of consecutive numbers and land in consecutive slots of the
+ * ring, with no collision as long as the window fits. Pointers are mixed
+ * first. The table doubles when half full, and removal shifts the
+ * following entries of a probe run back instead of leaving tombstones.
+ */
+template <typename K, typename V>
+class QCamera3PendingIndex {
+public:
+    QCamera3PendingIndex(uint32_t capacity = QCAMERA3_PENDING_INDEX_INIT_SIZE);
+    ~QCamera3PendingIndex();
+
+    int32_t add(const K &key, const V &value);
+    V *find(const K &key) const;
+    bool remove(const K &key);
+    void clear();
+    uint32_t size() const { return mCount; }
+    uint32_t capacity() const { return mMask + 1; }
+
+private:
+    QCamera3PendingIndex(const QCamera3PendingIndex &);
+    QCamera3PendingIndex &operator=(const QCamera3PendingIndex &);
+
+    static uint32_t hash(uint32_t key) { return key; }
+    template <typename P> static uint32_t hash(P *key)
+    {
+        uint64_t v = (uint64_t)(uintptr_t)key;
+        v ^= v >> 33;
+        v *= 0xff51afd7ed558ccdULL;
+        v ^= v >> 33;
+        return (uint32_t)v;
+    }
+
+    int32_t grow();
+    uint32_t lookup(const K &key) const;
+
+    K *mKeys;
+    V *mValues;
+    uint8_t *mUsed;
+    uint32_t mMask;
+    uint32_t mCount;
+};
+
+template <typename K, typename V>
+QCamera3PendingIndex<K, V>::QCamera3PendingIndex(uint32_t capacity)
+    : mKeys(NULL),
+      mValues(NULL),
+      mUsed(NULL),
+      mMask(0),
+      mCount(0)
+{
+    uint32_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+    mKeys = new (std::nothrow) K[size];
+    mValues = new (std::nothrow) V[size];
+    mUsed = new (std::nothrow) uint8_t[size];
+    if (mKeys == NULL || mValues == NULL || mUsed == NULL) {
+        delete [] mKeys;
+        delete [] mValues;
+        delete [] mUsed;
+        mKeys = NULL;
+        mValues = NULL;
+        mUsed = NULL;
+        return;
+    }
+    memset(mUsed, 0, size);
+    mMask = size - 1;
+}
+
+template <typename K, typename V>
+QCamera3PendingIndex<K, V>::~QCamera3PendingIndex()
+{
+    delete [] mKeys;
+    delete [] mValues;
+    delete [] mUsed;
+}
+
+/* Returns the slot holding key, or capacity() if there is none */
+template <typename K, typename V>
+uint32_t QCamera3PendingIndex<K, V>::lookup(const K &key) const
+{
+    if (mUsed == NULL)
+        return capacity();
+    for (uint32_t slot = hash(key) & mMask; mUsed[slot];
+            slot = (slot + 1) & mMask) {
+        if (mKeys[slot] == key)
+            return slot;
+    }
+    return capacity();
+}
+
+template <typename K, typename V>
+int32_t QCamera3PendingIndex<K, V>::grow()
+{
+    uint32_t oldSize = (mUsed == NULL) ? 0 : capacity();
+    uint32_t size = (oldSize == 0) ? QCAMERA3_PENDING_INDEX_INIT_SIZE :
+            oldSize << 1;
+    K *keys = new (std::nothrow) K[size];
+    V *values = new (std::nothrow) V[size];
+    uint8_t *used = new (std::nothrow) uint8_t[size];
+    if (keys == NULL || values == NULL || used == NULL) {
+        delete [] keys;
+        delete [] values;
+        delete [] used;
+        return android::NO_MEMORY;
+    }
+    memset(used, 0, size);
+
+    for (uint32_t i = 0; i < oldSize; i++) {
+        if (!mUsed[i])
+            continue;
+        uint32_t slot = hash(mKeys[i]) & (size - 1);
+        while (used[slot])
+            slot = (slot + 1) & (size - 1);
+        keys[slot] = mKeys[i];
+        values[slot] = mValues[i];
+        used[slot] = 1;
+    }
+
+    delete [] mKeys;
+    delete [] mValues;
+    delete [] mUsed;
+    mKeys = keys;
+    mValues = values;
+    mUsed = used;
+    mMask = size - 1;
+    return android::NO_ERROR;
+}
+
+/* Adds key, or replaces its value if it is already present */
+template <typename K, typename V>
+int32_t QCamera3PendingIndex<K, V>::add(const K &key, const V &value)
+{
+    uint32_t slot = lookup(key);
+    if (slot != capacity()) {
+        mValues[slot] = value;
+        return android::NO_ERROR;
+    }
+
+    if (mUsed == NULL || (mCount + 1) * 2 > capacity()) {
+        int32_t rc = grow();
+        if (rc != android::NO_ERROR)
+            return rc;
+    }
+
+    slot = hash(key) & mMask;
+    while (mUsed[slot])
+        slot = (slot + 1) & mMask;
+    mKeys[slot] = key;
+    mValues[slot] = value;
+    mUsed[slot] = 1;
+    mCount++;
+    return android::NO_ERROR;
+}
+
+template <typename K, typename V>
+V *QCamera3PendingIndex<K, V>::find(const K &key) const
+{
+    uint32_t slot = lookup(key);
+    if (slot == capacity())
+        return NULL;
+    return &mValues[slot];
+}
+
+template <typename K, typename V>
+bool QCamera3PendingIndex<K, V>::remove(const K &key)
+{
+    uint32_t hole = lookup(key);
+    if (hole == capacity())
+        return false;
+
+    /* Move back every later entry of the run that may no longer be
+     * reachable from its home slot across the hole */
+    for (uint32_t slot = (hole + 1) & mMask; mUsed[slot];
+            slot = (slot + 1) & mMask) {
+        uint32_t home = hash(mKeys[slot]) & mMask;
+        if (((slot - home) & mMask) >= ((slot - hole) & mMask)) {
+            mKeys[hole] = mKeys[slot];
+            mValues[hole] = mValues[slot];
+            hole = slot;
+        }
+    }
+    mUsed[hole] = 0;
+    mCount--;
+    return true;
+}
+
+template <typename K, typename V>
+void QCamera3PendingIndex<K, V>::clear()
+{
+    if (mUsed == NULL || mCount == 0)
+        return;
+    memset(mUsed, 0, capacity());
+    mCount = 0;
+}
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA3PENDINGINDEX_H__ */
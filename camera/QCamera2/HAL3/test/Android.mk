@@ -0,0 +1,37 @@
+#result metadata translation benchmark, runs on the build host
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS += -Wall -Wextra -Werror
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../../stack/common
+LOCAL_C_INCLUDES += $(TARGET_OUT_INTERMEDIATES)/KERNEL_OBJ/usr/include
+LOCAL_ADDITIONAL_DEPENDENCIES := $(TARGET_OUT_INTERMEDIATES)/KERNEL_OBJ/usr
+
+LOCAL_SRC_FILES := qcamera3_meta_bench.cpp \
+        ../QCamera3MetaTable.cpp
+
+LOCAL_MODULE           := qcamera3-meta-bench
+LOCAL_HEADER_LIBRARIES := libutils_headers
+LOCAL_SHARED_LIBRARIES := liblog libcamera_metadata
+LOCAL_LDLIBS           := -lpthread
+
+include $(BUILD_HOST_EXECUTABLE)
+
+#pending request and buffer tracking replay test, runs on the build host
+include $(CLEAR_VARS)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS += -Wall -Wextra -Werror
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_SRC_FILES := qcamera3_pending_replay.cpp
+
+LOCAL_MODULE           := qcamera3-pending-replay
+LOCAL_HEADER_LIBRARIES := libutils_headers
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,311 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Host benchmark of the table driven result metadata translation. Each
+ * metadata buffer is translated with the per parameter IF_META_AVAILABLE
+ * sequence translateFromHalMetadata used before, into metadata grown on
+ * demand, and with QCamera3MetaTable into metadata reserved from the
+ * previous results. Both outputs are compared and the cost per frame is
+ * reported.
+ *
+ * Buffers are read from metadata_buffer_t dumps, recorded on target with
+ * persist.camera.dumpmetabuf=<frames>, or generated when none are given.
+ *
+ * usage: qcamera3-meta-bench [-n iterations] [metabuf_*.bin ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <utils/Errors.h>
+
+#include "QCamera3MetaTable.h"
+
+using namespace android;
+using namespace qcamera;
+
+#define SYNTHETIC_FRAMES    16
+
+static int g_failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#define LEGACY_U8(TAG, META_ID) do { \
+    IF_META_AVAILABLE(uint32_t, val, META_ID, metadata) { \
+        uint8_t fwk_val = (uint8_t) *val; \
+        QCamera3MetaTable::update(&result, TAG, &fwk_val, 1); \
+    } \
+} while (0)
+
+#define LEGACY_COPY(TYPE, TAG, META_ID, COUNT) do { \
+    IF_META_AVAILABLE(TYPE, val, META_ID, metadata) { \
+        QCamera3MetaTable::update(&result, TAG, val, COUNT); \
+    } \
+} while (0)
+
+/* The blocks of translateFromHalMetadata the table replaced, in order */
+static camera_metadata_t *translate_legacy(metadata_buffer_t *metadata)
+{
+    camera_metadata_t *result = allocate_camera_metadata(0, 0);
+
+    IF_META_AVAILABLE(uint32_t, frame_number, CAM_INTF_META_FRAME_NUMBER, metadata) {
+        int64_t fwk_frame_number = *frame_number;
+        QCamera3MetaTable::update(&result, ANDROID_SYNC_FRAME_NUMBER,
+                &fwk_frame_number, 1);
+    }
+    LEGACY_COPY(int32_t, ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION,
+            CAM_INTF_PARM_EXPOSURE_COMPENSATION, 1);
+    LEGACY_U8(ANDROID_CONTROL_AE_LOCK, CAM_INTF_PARM_AEC_LOCK);
+    LEGACY_U8(ANDROID_CONTROL_AWB_LOCK, CAM_INTF_PARM_AWB_LOCK);
+    LEGACY_U8(ANDROID_COLOR_CORRECTION_MODE, CAM_INTF_META_COLOR_CORRECT_MODE);
+    LEGACY_U8(ANDROID_FLASH_FIRING_POWER, CAM_INTF_META_FLASH_POWER);
+    LEGACY_COPY(int64_t, ANDROID_FLASH_FIRING_TIME,
+            CAM_INTF_META_FLASH_FIRING_TIME, 1);
+    LEGACY_U8(ANDROID_HOT_PIXEL_MODE, CAM_INTF_META_HOTPIXEL_MODE);
+    LEGACY_COPY(float, ANDROID_LENS_APERTURE, CAM_INTF_META_LENS_APERTURE, 1);
+    LEGACY_COPY(float, ANDROID_LENS_FILTER_DENSITY,
+            CAM_INTF_META_LENS_FILTERDENSITY, 1);
+    LEGACY_COPY(float, ANDROID_LENS_FOCAL_LENGTH,
+            CAM_INTF_META_LENS_FOCAL_LENGTH, 1);
+    LEGACY_U8(ANDROID_LENS_OPTICAL_STABILIZATION_MODE,
+            CAM_INTF_META_LENS_OPT_STAB_MODE);
+    LEGACY_U8(ANDROID_NOISE_REDUCTION_MODE, CAM_INTF_META_NOISE_REDUCTION_MODE);
+    LEGACY_U8(ANDROID_NOISE_REDUCTION_STRENGTH,
+            CAM_INTF_META_NOISE_REDUCTION_STRENGTH);
+    LEGACY_COPY(int64_t, ANDROID_SENSOR_EXPOSURE_TIME,
+            CAM_INTF_META_SENSOR_EXPOSURE_TIME, 1);
+    LEGACY_COPY(int64_t, ANDROID_SENSOR_FRAME_DURATION,
+            CAM_INTF_META_SENSOR_FRAME_DURATION, 1);
+    LEGACY_COPY(int64_t, ANDROID_SENSOR_ROLLING_SHUTTER_SKEW,
+            CAM_INTF_META_SENSOR_ROLLING_SHUTTER_SKEW, 1);
+    LEGACY_U8(ANDROID_SHADING_MODE, CAM_INTF_META_SHADING_MODE);
+    LEGACY_U8(ANDROID_STATISTICS_HISTOGRAM_MODE,
+            CAM_INTF_META_STATS_HISTOGRAM_MODE);
+    LEGACY_U8(ANDROID_STATISTICS_SHARPNESS_MAP_MODE,
+            CAM_INTF_META_STATS_SHARPNESS_MAP_MODE);
+    LEGACY_U8(ANDROID_TONEMAP_MODE, CAM_INTF_META_TONEMAP_MODE);
+    LEGACY_COPY(float, ANDROID_SENSOR_GREEN_SPLIT, CAM_INTF_META_OTP_WB_GRGB, 1);
+    LEGACY_U8(ANDROID_BLACK_LEVEL_LOCK, CAM_INTF_META_BLACK_LEVEL_LOCK);
+    LEGACY_U8(ANDROID_STATISTICS_SCENE_FLICKER, CAM_INTF_META_SCENE_FLICKER);
+    LEGACY_COPY(double, ANDROID_JPEG_GPS_COORDINATES,
+            CAM_INTF_META_JPEG_GPS_COORDINATES, 3);
+    LEGACY_COPY(int64_t, ANDROID_JPEG_GPS_TIMESTAMP,
+            CAM_INTF_META_JPEG_GPS_TIMESTAMP, 1);
+    LEGACY_COPY(int32_t, ANDROID_JPEG_ORIENTATION,
+            CAM_INTF_META_JPEG_ORIENTATION, 1);
+    LEGACY_U8(ANDROID_JPEG_QUALITY, CAM_INTF_META_JPEG_QUALITY);
+    LEGACY_U8(ANDROID_JPEG_THUMBNAIL_QUALITY, CAM_INTF_META_JPEG_THUMB_QUALITY);
+    LEGACY_U8(ANDROID_STATISTICS_LENS_SHADING_MAP_MODE,
+            CAM_INTF_META_LENS_SHADING_MAP_MODE);
+    LEGACY_U8(ANDROID_CONTROL_MODE, CAM_INTF_META_MODE);
+
+    return result;
+}
+
+static camera_metadata_t *translate_table(metadata_buffer_t *metadata,
+        size_t *entryHint, size_t *dataHint)
+{
+    camera_metadata_t *result = allocate_camera_metadata(*entryHint, *dataHint);
+    uint64_t validMask[QCAMERA3_META_MASK_WORDS];
+
+    if (QCamera3MetaTable::getValidMask(metadata, validMask)) {
+        QCamera3MetaTable::translate(metadata, validMask, &result);
+    }
+    if (get_camera_metadata_entry_count(result) > *entryHint) {
+        *entryHint = get_camera_metadata_entry_count(result);
+    }
+    if (get_camera_metadata_data_count(result) > *dataHint) {
+        *dataHint = get_camera_metadata_data_count(result);
+    }
+    return result;
+}
+
+static void compare(camera_metadata_t *legacy, camera_metadata_t *table)
+{
+    CHECK(get_camera_metadata_entry_count(legacy) ==
+            get_camera_metadata_entry_count(table));
+
+    for (size_t i = 0; i < get_camera_metadata_entry_count(legacy); i++) {
+        camera_metadata_entry_t a, b;
+        get_camera_metadata_entry(legacy, i, &a);
+        if (OK != find_camera_metadata_entry(table, a.tag, &b)) {
+            printf("tag 0x%x missing from table result\n", a.tag);
+            g_failures++;
+            continue;
+        }
+        CHECK(a.type == b.type);
+        CHECK(a.count == b.count);
+        CHECK(!memcmp(a.data.u8, b.data.u8,
+                a.count * camera_metadata_type_size[a.type]));
+    }
+}
+
+static void check_valid_mask(const metadata_buffer_t *metadata)
+{
+    uint64_t mask[QCAMERA3_META_MASK_WORDS];
+    uint32_t count = 0;
+    uint32_t set = QCamera3MetaTable::getValidMask(metadata, mask);
+
+    for (int i = 0; i < CAM_INTF_PARM_MAX; i++) {
+        bool bit = (mask[i / 64] >> (i % 64)) & 1;
+        CHECK(bit == (metadata->is_valid[i] != 0));
+        count += bit;
+    }
+    CHECK(set == count);
+}
+
+/* Random values for the table parameters, other parameters only flagged */
+static void fill_synthetic(metadata_buffer_t *metadata, unsigned int seed)
+{
+    srand(seed);
+    clear_metadata_buffer(metadata);
+
+    for (int i = 0; i < CAM_INTF_PARM_MAX; i++) {
+        metadata->is_valid[i] = (rand() % 3 == 0) ? (uint8_t)(1 + rand() % 2) : 0;
+    }
+    for (size_t i = 0; i < QCamera3MetaTable::getEntryCount(); i++) {
+        const qcamera3_meta_entry_t *e = QCamera3MetaTable::getEntry(i);
+        uint8_t *p = (uint8_t *)metadata + e->offset;
+        for (uint32_t b = 0; b < e->elemSize * e->count; b++) {
+            p[b] = (uint8_t)rand();
+        }
+        metadata->is_valid[e->id] = (rand() % 4 != 0);
+    }
+}
+
+static metadata_buffer_t *load_dump(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    metadata_buffer_t *metadata;
+
+    if (!fp) {
+        printf("%s: cannot open\n", path);
+        return NULL;
+    }
+    metadata = (metadata_buffer_t *)malloc(sizeof(metadata_buffer_t));
+    if (metadata && fread(metadata, sizeof(*metadata), 1, fp) != 1) {
+        printf("%s: not a metadata_buffer_t dump of %zu bytes\n", path,
+                sizeof(metadata_buffer_t));
+        free(metadata);
+        metadata = NULL;
+    }
+    fclose(fp);
+    return metadata;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 2000;
+    int argi = 1;
+    metadata_buffer_t **frames;
+    int nframes = 0;
+
+    if (argc > 2 && !strcmp(argv[1], "-n")) {
+        iterations = atoi(argv[2]);
+        argi = 3;
+    }
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    frames = (metadata_buffer_t **)calloc((size_t)(argc + SYNTHETIC_FRAMES),
+            sizeof(*frames));
+    if (!frames) {
+        return 1;
+    }
+    for (; argi < argc; argi++) {
+        metadata_buffer_t *metadata = load_dump(argv[argi]);
+        if (metadata) {
+            frames[nframes++] = metadata;
+        }
+    }
+    if (!nframes) {
+        printf("no dumps given, using %d generated buffers\n", SYNTHETIC_FRAMES);
+        for (; nframes < SYNTHETIC_FRAMES; nframes++) {
+            frames[nframes] = (metadata_buffer_t *)malloc(sizeof(metadata_buffer_t));
+            if (!frames[nframes]) {
+                return 1;
+            }
+            fill_synthetic(frames[nframes], 0x5eed + (unsigned int)nframes);
+        }
+    }
+
+    size_t entryHint = 0, dataHint = 0;
+    for (int f = 0; f < nframes; f++) {
+        check_valid_mask(frames[f]);
+        camera_metadata_t *legacy = translate_legacy(frames[f]);
+        camera_metadata_t *table = translate_table(frames[f], &entryHint, &dataHint);
+        compare(legacy, table);
+        free_camera_metadata(legacy);
+        free_camera_metadata(table);
+    }
+
+    uint64_t t_legacy = 0, t_table = 0;
+    for (int it = 0; it < iterations; it++) {
+        for (int f = 0; f < nframes; f++) {
+            uint64_t t0 = now_ns();
+            camera_metadata_t *legacy = translate_legacy(frames[f]);
+            uint64_t t1 = now_ns();
+            camera_metadata_t *table = translate_table(frames[f], &entryHint,
+                    &dataHint);
+            uint64_t t2 = now_ns();
+            t_legacy += t1 - t0;
+            t_table += t2 - t1;
+            free_camera_metadata(legacy);
+            free_camera_metadata(table);
+        }
+    }
+
+    double n = (double)iterations * nframes;
+    printf("%d buffers, %d iterations, %zu table entries\n", nframes,
+            iterations, QCamera3MetaTable::getEntryCount());
+    printf("%-10s %10s\n", "path", "ns/frame");
+    printf("%-10s %10.0f\n", "legacy", t_legacy / n);
+    printf("%-10s %10.0f\n", "table", t_table / n);
+
+    for (int f = 0; f < nframes; f++) {
+        free(frames[f]);
+    }
+    free(frames);
+    printf("%s\n", g_failures ? "FAILED" : "PASSED");
+    return g_failures ? 1 : 0;
+}
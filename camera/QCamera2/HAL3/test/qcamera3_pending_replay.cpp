@@ -0,0 +1,634 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Host replay test of the pending request and buffer book-keeping of
+ * QCamera3HardwareInterface. A synthetic script of capture requests,
+ * out of order buffer returns, urgent and final metadata, dropped
+ * metadata and flushes is replayed twice through the result delivery
+ * logic of handleMetadataWithLock, handleBufferWithLock and flush: once
+ * looking entries up with QCamera3PendingIndex, once with the linear list
+ * scans used before. Both replays must deliver the same results in the
+ * same order. The cost of each replay is reported.
+ *
+ * usage: qcamera3-pending-replay [-s seed] [-n events] [-d depth]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <utils/Errors.h>
+#include <utils/List.h>
+
+#include "QCamera3PendingIndex.h"
+
+using namespace android;
+using namespace qcamera;
+
+#define MAX_BUFS_PER_REQUEST    3
+#define HANDLE_POOL_SIZE        256
+#define DEFAULT_EVENTS          200000
+#define DEFAULT_DEPTH           8
+
+typedef const void *fake_handle_t;
+
+static fake_handle_t g_handles[HANDLE_POOL_SIZE];
+static int g_failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t g_seed;
+
+static uint32_t next_rand(void)
+{
+    g_seed ^= g_seed << 13;
+    g_seed ^= g_seed >> 17;
+    g_seed ^= g_seed << 5;
+    return g_seed;
+}
+
+/* Script */
+typedef enum {
+    EV_REQUEST,
+    EV_BUFFER,
+    EV_URGENT,
+    EV_METADATA,
+    EV_FLUSH,
+} event_type_t;
+
+typedef struct {
+    event_type_t type;
+    uint32_t frame_number;
+    uint32_t num_buffers;
+    uint32_t handles[MAX_BUFS_PER_REQUEST];
+} event_t;
+
+/* Results handed to the framework */
+typedef enum {
+    RES_URGENT,
+    RES_METADATA,
+    RES_BUFFER,         /* with the metadata of its request */
+    RES_LATE_BUFFER,    /* after the metadata of its request */
+    RES_ERROR_BUFFER,
+    RES_ERROR_REQUEST,
+} result_type_t;
+
+typedef struct {
+    result_type_t type;
+    uint32_t frame_number;
+    fake_handle_t *buffer;
+} result_t;
+
+typedef struct {
+    result_t *results;
+    uint32_t count;
+    uint32_t size;
+} result_log_t;
+
+static void log_result(result_log_t *log, result_type_t type,
+        uint32_t frame_number, fake_handle_t *buffer)
+{
+    if (log->count == log->size) {
+        log->size = log->size ? log->size * 2 : 1024;
+        log->results = (result_t *)realloc(log->results,
+                log->size * sizeof(result_t));
+        if (log->results == NULL) {
+            printf("out of memory\n");
+            exit(1);
+        }
+    }
+    log->results[log->count].type = type;
+    log->results[log->count].frame_number = frame_number;
+    log->results[log->count].buffer = buffer;
+    log->count++;
+}
+
+/* Pending state, as kept by QCamera3HardwareInterface */
+typedef struct {
+    fake_handle_t *buffer;
+    bool returned;
+} RequestedBufferInfo;
+
+typedef struct {
+    uint32_t frame_number;
+    uint32_t num_buffers;
+    RequestedBufferInfo buffers[MAX_BUFS_PER_REQUEST];
+    bool bUrgentReceived;
+} PendingRequestInfo;
+
+typedef struct {
+    uint32_t frame_number;
+    fake_handle_t *buffer;
+} PendingBufferInfo;
+
+typedef List<PendingRequestInfo>::iterator pendingRequestIterator;
+typedef List<PendingBufferInfo>::iterator pendingBufferIterator;
+
+class PendingTracker {
+public:
+    PendingTracker() : num_buffers(0) {}
+    virtual ~PendingTracker() {}
+
+    void replay(const event_t *events, uint32_t count, result_log_t *log);
+    virtual bool consistent() { return true; }
+
+protected:
+    virtual void addPendingRequest(const PendingRequestInfo &request) = 0;
+    virtual pendingRequestIterator findPendingRequest(uint32_t frame_number) = 0;
+    virtual pendingRequestIterator erasePendingRequest(pendingRequestIterator i) = 0;
+    virtual void clearPendingRequests() = 0;
+    virtual void addPendingBuffer(const PendingBufferInfo &info) = 0;
+    virtual pendingBufferIterator findPendingBuffer(fake_handle_t *buffer) = 0;
+    virtual pendingBufferIterator erasePendingBuffer(pendingBufferIterator k) = 0;
+    virtual void clearPendingBuffers() = 0;
+
+    List<PendingRequestInfo> mPendingRequestsList;
+    List<PendingBufferInfo> mPendingBufferList;
+    uint32_t num_buffers;
+
+private:
+    void request(const event_t *ev);
+    void urgent(uint32_t frame_number, result_log_t *log);
+    void metadata(uint32_t frame_number, result_log_t *log);
+    void buffer(fake_handle_t *handle, uint32_t frame_number, result_log_t *log);
+    void flush(result_log_t *log);
+};
+
+void PendingTracker::replay(const event_t *events, uint32_t count,
+        result_log_t *log)
+{
+    for (uint32_t n = 0; n < count; n++) {
+        const event_t *ev = &events[n];
+        switch (ev->type) {
+        case EV_REQUEST:
+            request(ev);
+            break;
+        case EV_BUFFER:
+            buffer(&g_handles[ev->handles[0]], ev->frame_number, log);
+            break;
+        case EV_URGENT:
+            urgent(ev->frame_number, log);
+            break;
+        case EV_METADATA:
+            metadata(ev->frame_number, log);
+            break;
+        case EV_FLUSH:
+            flush(log);
+            break;
+        }
+    }
+}
+
+/* processCaptureRequest */
+void PendingTracker::request(const event_t *ev)
+{
+    PendingRequestInfo request;
+    memset(&request, 0, sizeof(request));
+    request.frame_number = ev->frame_number;
+    request.num_buffers = ev->num_buffers;
+    for (uint32_t b = 0; b < ev->num_buffers; b++) {
+        PendingBufferInfo info;
+        info.frame_number = ev->frame_number;
+        info.buffer = &g_handles[ev->handles[b]];
+        request.buffers[b].buffer = info.buffer;
+        addPendingBuffer(info);
+        num_buffers++;
+    }
+    addPendingRequest(request);
+}
+
+/* Urgent half of handleMetadataWithLock */
+void PendingTracker::urgent(uint32_t frame_number, result_log_t *log)
+{
+    pendingRequestIterator i = findPendingRequest(frame_number);
+    if (i != mPendingRequestsList.end() && !i->bUrgentReceived) {
+        i->bUrgentReceived = true;
+        log_result(log, RES_URGENT, frame_number, NULL);
+    }
+}
+
+/* Final half of handleMetadataWithLock */
+void PendingTracker::metadata(uint32_t frame_number, result_log_t *log)
+{
+    for (pendingRequestIterator i = mPendingRequestsList.begin();
+            i != mPendingRequestsList.end() && i->frame_number <= frame_number;) {
+        if (i->frame_number < frame_number) {
+            log_result(log, RES_ERROR_REQUEST, i->frame_number, NULL);
+        } else {
+            log_result(log, RES_METADATA, i->frame_number, NULL);
+        }
+        for (uint32_t b = 0; b < i->num_buffers; b++) {
+            if (!i->buffers[b].returned)
+                continue;
+            pendingBufferIterator k = findPendingBuffer(i->buffers[b].buffer);
+            CHECK(k != mPendingBufferList.end());
+            if (k != mPendingBufferList.end()) {
+                num_buffers--;
+                erasePendingBuffer(k);
+            }
+            log_result(log, RES_BUFFER, i->frame_number, i->buffers[b].buffer);
+        }
+        i = erasePendingRequest(i);
+    }
+}
+
+/* handleBufferWithLock */
+void PendingTracker::buffer(fake_handle_t *handle, uint32_t frame_number,
+        result_log_t *log)
+{
+    pendingRequestIterator i = findPendingRequest(frame_number);
+    if (i == mPendingRequestsList.end()) {
+        pendingBufferIterator k = findPendingBuffer(handle);
+        if (k != mPendingBufferList.end()) {
+            num_buffers--;
+            erasePendingBuffer(k);
+        }
+        log_result(log, RES_LATE_BUFFER, frame_number, handle);
+        return;
+    }
+    for (uint32_t b = 0; b < i->num_buffers; b++) {
+        if (i->buffers[b].buffer == handle)
+            i->buffers[b].returned = true;
+    }
+}
+
+/* flush */
+void PendingTracker::flush(result_log_t *log)
+{
+    if (!mPendingRequestsList.empty()) {
+        uint32_t oldest = mPendingRequestsList.begin()->frame_number;
+        for (pendingBufferIterator k = mPendingBufferList.begin();
+                k != mPendingBufferList.end();) {
+            if (k->frame_number < oldest) {
+                log_result(log, RES_ERROR_BUFFER, k->frame_number, k->buffer);
+                num_buffers--;
+                k = erasePendingBuffer(k);
+            } else {
+                k++;
+            }
+        }
+    }
+    for (pendingBufferIterator k = mPendingBufferList.begin();
+            k != mPendingBufferList.end();) {
+        log_result(log, RES_ERROR_REQUEST, k->frame_number, k->buffer);
+        num_buffers--;
+        k = erasePendingBuffer(k);
+    }
+    CHECK(num_buffers == 0);
+    clearPendingRequests();
+    clearPendingBuffers();
+}
+
+/* Lookups as done before, by walking the lists */
+class LinearTracker : public PendingTracker {
+protected:
+    void addPendingRequest(const PendingRequestInfo &request)
+    {
+        mPendingRequestsList.push_back(request);
+    }
+    pendingRequestIterator findPendingRequest(uint32_t frame_number)
+    {
+        pendingRequestIterator i = mPendingRequestsList.begin();
+        while (i != mPendingRequestsList.end() && i->frame_number != frame_number)
+            i++;
+        return i;
+    }
+    pendingRequestIterator erasePendingRequest(pendingRequestIterator i)
+    {
+        return mPendingRequestsList.erase(i);
+    }
+    void clearPendingRequests() { mPendingRequestsList.clear(); }
+    void addPendingBuffer(const PendingBufferInfo &info)
+    {
+        mPendingBufferList.push_back(info);
+    }
+    pendingBufferIterator findPendingBuffer(fake_handle_t *buffer)
+    {
+        pendingBufferIterator k = mPendingBufferList.begin();
+        while (k != mPendingBufferList.end() && k->buffer != buffer)
+            k++;
+        return k;
+    }
+    pendingBufferIterator erasePendingBuffer(pendingBufferIterator k)
+    {
+        return mPendingBufferList.erase(k);
+    }
+    void clearPendingBuffers() { mPendingBufferList.clear(); }
+};
+
+/* Lookups through QCamera3PendingIndex, as QCamera3HardwareInterface does */
+class IndexedTracker : public PendingTracker {
+public:
+    bool consistent();
+
+protected:
+    void addPendingRequest(const PendingRequestInfo &request)
+    {
+        mPendingRequestsList.push_back(request);
+        pendingRequestIterator i = mPendingRequestsList.end();
+        i--;
+        CHECK(mPendingRequestsIndex.add(request.frame_number, i) == NO_ERROR);
+    }
+    pendingRequestIterator findPendingRequest(uint32_t frame_number)
+    {
+        pendingRequestIterator *i = mPendingRequestsIndex.find(frame_number);
+        return (i == NULL) ? mPendingRequestsList.end() : *i;
+    }
+    pendingRequestIterator erasePendingRequest(pendingRequestIterator i)
+    {
+        mPendingRequestsIndex.remove(i->frame_number);
+        return mPendingRequestsList.erase(i);
+    }
+    void clearPendingRequests()
+    {
+        mPendingRequestsIndex.clear();
+        mPendingRequestsList.clear();
+    }
+    void addPendingBuffer(const PendingBufferInfo &info)
+    {
+        mPendingBufferList.push_back(info);
+        pendingBufferIterator k = mPendingBufferList.end();
+        k--;
+        CHECK(mPendingBuffersIndex.add(info.buffer, k) == NO_ERROR);
+    }
+    pendingBufferIterator findPendingBuffer(fake_handle_t *buffer)
+    {
+        pendingBufferIterator *k = mPendingBuffersIndex.find(buffer);
+        return (k == NULL) ? mPendingBufferList.end() : *k;
+    }
+    pendingBufferIterator erasePendingBuffer(pendingBufferIterator k)
+    {
+        mPendingBuffersIndex.remove(k->buffer);
+        return mPendingBufferList.erase(k);
+    }
+    void clearPendingBuffers()
+    {
+        mPendingBuffersIndex.clear();
+        mPendingBufferList.clear();
+    }
+
+private:
+    QCamera3PendingIndex<uint32_t, pendingRequestIterator> mPendingRequestsIndex;
+    QCamera3PendingIndex<fake_handle_t *, pendingBufferIterator> mPendingBuffersIndex;
+};
+
+/* Every list entry is indexed at its own position, and nothing else is */
+bool IndexedTracker::consistent()
+{
+    uint32_t count = 0;
+    for (pendingRequestIterator i = mPendingRequestsList.begin();
+            i != mPendingRequestsList.end(); i++, count++) {
+        if (findPendingRequest(i->frame_number) != i)
+            return false;
+    }
+    if (count != mPendingRequestsIndex.size())
+        return false;
+
+    count = 0;
+    for (pendingBufferIterator k = mPendingBufferList.begin();
+            k != mPendingBufferList.end(); k++, count++) {
+        if (findPendingBuffer(k->buffer) != k)
+            return false;
+    }
+    return count == mPendingBuffersIndex.size();
+}
+
+/* Builds a script the way the pipeline behaves: requests in frame order up
+ * to depth in flight, buffers returned in any order, urgent and final
+ * metadata in frame order with some dropped, and an occasional flush.
+ * A buffer handle is only reused once its result has gone back to the
+ * framework. */
+static uint32_t build_script(event_t *events, uint32_t count, uint32_t depth)
+{
+    bool busy[HANDLE_POOL_SIZE];    /* not returned by the pipeline yet */
+    bool used[HANDLE_POOL_SIZE];
+    uint32_t out_frame[HANDLE_POOL_SIZE];
+    uint32_t outstanding[HANDLE_POOL_SIZE];
+    uint32_t num_outstanding = 0;
+    uint32_t next_frame = next_rand() & 0xffff;
+    uint32_t next_urgent = next_frame;
+    uint32_t next_meta = next_frame;
+    uint32_t n = 0;
+
+    memset(busy, 0, sizeof(busy));
+    memset(used, 0, sizeof(used));
+    while (n < count) {
+        event_t *ev = &events[n];
+        uint32_t dice = next_rand() % 100;
+        memset(ev, 0, sizeof(*ev));
+
+        if (dice == 0) {
+            ev->type = EV_FLUSH;
+            memset(busy, 0, sizeof(busy));
+            memset(used, 0, sizeof(used));
+            num_outstanding = 0;
+            next_urgent = next_meta = next_frame;
+        } else if (dice < 35 && next_frame - next_meta < depth) {
+            uint32_t in_use = 0;
+            for (uint32_t h = 0; h < HANDLE_POOL_SIZE; h++) {
+                if (busy[h] || (used[h] && out_frame[h] >= next_meta))
+                    in_use++;
+            }
+            if (in_use + MAX_BUFS_PER_REQUEST > HANDLE_POOL_SIZE)
+                continue;
+            ev->type = EV_REQUEST;
+            ev->frame_number = next_frame++;
+            ev->num_buffers = 1 + next_rand() % MAX_BUFS_PER_REQUEST;
+            for (uint32_t b = 0; b < ev->num_buffers; b++) {
+                uint32_t h = next_rand() % HANDLE_POOL_SIZE;
+                while (busy[h] || (used[h] && out_frame[h] >= next_meta))
+                    h = (h + 1) % HANDLE_POOL_SIZE;
+                busy[h] = true;
+                used[h] = true;
+                out_frame[h] = ev->frame_number;
+                outstanding[num_outstanding++] = h;
+                ev->handles[b] = h;
+            }
+        } else if (dice < 70 && num_outstanding > 0) {
+            uint32_t pick = next_rand() % num_outstanding;
+            uint32_t h = outstanding[pick];
+            outstanding[pick] = outstanding[--num_outstanding];
+            busy[h] = false;
+            ev->type = EV_BUFFER;
+            ev->frame_number = out_frame[h];
+            ev->handles[0] = h;
+        } else if (dice < 80 && next_urgent < next_frame) {
+            ev->type = EV_URGENT;
+            ev->frame_number = next_urgent++;
+        } else if (next_meta < next_frame) {
+            /* One in eight metadata is dropped by the pipeline */
+            if ((next_rand() & 7) == 0 && next_meta + 1 < next_frame)
+                next_meta++;
+            ev->type = EV_METADATA;
+            ev->frame_number = next_meta++;
+            if (next_urgent < next_meta)
+                next_urgent = next_meta;
+        } else {
+            continue;
+        }
+        n++;
+    }
+    return n;
+}
+
+static void test_index(void)
+{
+    QCamera3PendingIndex<uint32_t, uint32_t> index(4);
+    uint32_t n;
+
+    /* A moving window of frame numbers wraps around the ring */
+    for (n = 0; n < 1000; n++) {
+        CHECK(index.add(n, n * 3) == NO_ERROR);
+        if (n >= 5) {
+            CHECK(index.remove(n - 5));
+        }
+        CHECK(index.find(n) != NULL && *index.find(n) == n * 3);
+    }
+    CHECK(index.size() == 5);
+    CHECK(index.capacity() == 16);
+    CHECK(index.find(994) == NULL);
+    CHECK(!index.remove(994));
+
+    /* Colliding keys form a probe run across the end of the table;
+     * removing from its middle keeps the rest reachable */
+    index.clear();
+    uint32_t cap = index.capacity();
+    uint32_t keys[] = { cap - 1, 2 * cap - 1, 3 * cap - 1, 0, 4 * cap - 1 };
+    for (n = 0; n < sizeof(keys) / sizeof(keys[0]); n++) {
+        CHECK(index.add(keys[n], n) == NO_ERROR);
+    }
+    CHECK(index.remove(2 * cap - 1));
+    CHECK(index.find(2 * cap - 1) == NULL);
+    for (n = 0; n < sizeof(keys) / sizeof(keys[0]); n++) {
+        if (keys[n] != 2 * cap - 1) {
+            CHECK(index.find(keys[n]) != NULL && *index.find(keys[n]) == n);
+        }
+    }
+
+    /* Adding a present key replaces its value */
+    CHECK(index.add(0, 42) == NO_ERROR);
+    CHECK(*index.find(0) == 42);
+    CHECK(index.size() == 4);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t seed = 1;
+    uint32_t num_events = DEFAULT_EVENTS;
+    uint32_t depth = DEFAULT_DEPTH;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:n:d:")) != -1) {
+        switch (opt) {
+        case 's':
+            seed = (uint32_t)atoi(optarg);
+            break;
+        case 'n':
+            num_events = (uint32_t)atoi(optarg);
+            break;
+        case 'd':
+            depth = (uint32_t)atoi(optarg);
+            break;
+        default:
+            printf("usage: %s [-s seed] [-n events] [-d depth]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (seed == 0 || num_events == 0 || depth == 0 ||
+            depth * MAX_BUFS_PER_REQUEST > HANDLE_POOL_SIZE) {
+        printf("seed and events must be non zero, depth 1 to %d\n",
+                HANDLE_POOL_SIZE / MAX_BUFS_PER_REQUEST);
+        return 1;
+    }
+
+    test_index();
+
+    event_t *events = (event_t *)malloc(num_events * sizeof(event_t));
+    if (events == NULL) {
+        printf("out of memory\n");
+        return 1;
+    }
+    g_seed = seed;
+    build_script(events, num_events, depth);
+
+    result_log_t linear_log, indexed_log;
+    memset(&linear_log, 0, sizeof(linear_log));
+    memset(&indexed_log, 0, sizeof(indexed_log));
+
+    LinearTracker linear;
+    uint64_t start = now_ns();
+    linear.replay(events, num_events, &linear_log);
+    uint64_t linear_ns = now_ns() - start;
+
+    IndexedTracker indexed;
+    start = now_ns();
+    indexed.replay(events, num_events, &indexed_log);
+    uint64_t indexed_ns = now_ns() - start;
+
+    CHECK(indexed.consistent());
+    CHECK(linear_log.count == indexed_log.count);
+    for (uint32_t n = 0; n < linear_log.count && n < indexed_log.count; n++) {
+        const result_t *a = &linear_log.results[n];
+        const result_t *b = &indexed_log.results[n];
+        if (a->type != b->type || a->frame_number != b->frame_number ||
+                a->buffer != b->buffer) {
+            printf("FAIL result %u: type %d frame %u buffer %p vs "
+                    "type %d frame %u buffer %p\n", n,
+                    a->type, a->frame_number, (const void *)a->buffer,
+                    b->type, b->frame_number, (const void *)b->buffer);
+            g_failures++;
+            break;
+        }
+    }
+
+    printf("%u events, depth %u, %u results\n", num_events, depth,
+            indexed_log.count);
+    printf("linear : %6.1f ns/event\n", (double)linear_ns / num_events);
+    printf("indexed: %6.1f ns/event\n", (double)indexed_ns / num_events);
+
+    free(linear_log.results);
+    free(indexed_log.results);
+    free(events);
+
+    printf("%s\n", g_failures ? "FAILED" : "PASSED");
+    return g_failures ? 1 : 0;
+}
@@ -80,6 +80,12 @@ typedef struct {
   uint32_t num_of_images;
 } mm_jpeg_multi_image_t;
 
+typedef enum {
+  MM_JPEG_JOB_PRIO_DEFAULT,  /* lane is picked from the output size */
+  MM_JPEG_JOB_PRIO_HIGH,     /* thumbnail or preview snapshot */
+  MM_JPEG_JOB_PRIO_NORMAL,   /* full size image */
+} mm_jpeg_job_prio_t;
+
 typedef struct {
   uint32_t sequence;          /* for jpeg bit streams, assembling is based on sequence. sequence starts from 0 */
   uint8_t *buf_vaddr;        /* ptr to buf */
@@ -271,6 +277,9 @@ typedef struct {
 
   /* work buf */
   mm_jpeg_buf_t work_buf;
+
+  /* scheduling priority */
+  mm_jpeg_job_prio_t priority;
 } mm_jpeg_encode_job_t;
 
 typedef struct {
@@ -325,6 +334,27 @@ typedef struct {
   size_t output_buff_size;
 } mm_jpeg_mpo_info_t;
 
+typedef struct {
+  /* jobs completed, per scheduling lane */
+  uint32_t jobs;
+  uint32_t high_lane_jobs;
+  uint32_t normal_lane_jobs;
+
+  /* time spent in the todo queue */
+  uint64_t wait_total_us;
+  uint64_t wait_max_us;
+
+  /* time from job start to job done */
+  uint64_t encode_total_us;
+  uint64_t encode_max_us;
+
+  /* exif tables built from the metadata */
+  uint32_t exif_tables;
+  uint32_t exif_heap_allocs;
+  uint64_t exif_build_us;
+  size_t exif_arena_size;
+} mm_jpeg_session_stats_t;
+
 typedef struct {
   /* config a job -- async call */
   int (*start_job)(mm_jpeg_job_t* job, uint32_t* job_id);
@@ -342,6 +372,10 @@ typedef struct {
   /* close a jpeg client -- sync call */
   int (*close) (uint32_t clientHdl);
 
+  /* get session statistics -- sync call */
+  int (*get_session_stats)(uint32_t session_id,
+    mm_jpeg_session_stats_t *p_stats);
+
 } mm_jpeg_ops_t;
 
 typedef struct {
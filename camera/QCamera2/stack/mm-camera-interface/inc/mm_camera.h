@@ -33,6 +33,7 @@
 #include <cam_semaphore.h>
 
 #include "mm_camera_interface.h"
+#include "mm_camera_superbuf_slots.h"
 #include <hardware/camera.h>
 #include <utils/Timers.h>
 
@@ -140,6 +141,13 @@ typedef enum {
     MM_CAMERA_POLL_TYPE_MAX
 } mm_camera_poll_thread_type_t;
 
+typedef enum {
+    MM_CAMERA_POLL_ENGINE_DEFAULT, /* set by persist.camera.poll.engine */
+    MM_CAMERA_POLL_ENGINE_POLL,    /* poll(), fd array rebuilt on updates */
+    MM_CAMERA_POLL_ENGINE_EPOLL,   /* epoll, fds registered once */
+    MM_CAMERA_POLL_ENGINE_MAX
+} mm_camera_poll_engine_t;
+
 /* function ptr defined for poll notify CB,
  * registered at poll thread with poll fd */
 typedef void (*mm_camera_poll_notify_t)(void *user_data);
@@ -169,6 +177,10 @@ typedef struct {
     int32_t status;
     char threadName[THREAD_NAME_SIZE];
     //void *my_obj;
+    mm_camera_poll_engine_t engine;
+    int32_t epoll_fd;
+    /* fd registered with epoll for each poll entry, -1 if none */
+    int32_t epoll_reg_fds[MAX_STREAM_NUM_IN_BUNDLE];
 } mm_camera_poll_thread_t;
 
 /* mm_stream */
@@ -352,6 +364,8 @@ typedef struct {
     uint8_t matched;
     uint8_t expected;
     uint32_t frame_idx;
+    /* bit i set once super_buf[i] is filled */
+    uint32_t filled_mask;
 } mm_channel_queue_node_t;
 
 typedef struct {
@@ -370,6 +384,8 @@ typedef struct {
     uint32_t frame_skip_count;
     uint32_t nomatch_frame_id;
     uint32_t frame_num_for_instant_capture;
+    /* frame_idx -> queue node lookup for superbuf matching */
+    mm_channel_superbuf_slots_t slots;
 } mm_channel_queue_t;
 
 typedef struct {
@@ -730,7 +746,8 @@ uint8_t mm_camera_util_get_index_by_handler(uint32_t handler);
 /* poll/cmd thread functions */
 extern int32_t mm_camera_poll_thread_launch(
                                 mm_camera_poll_thread_t * poll_cb,
-                                mm_camera_poll_thread_type_t poll_type);
+                                mm_camera_poll_thread_type_t poll_type,
+                                mm_camera_poll_engine_t engine);
 extern int32_t mm_camera_poll_thread_release(mm_camera_poll_thread_t *poll_cb);
 extern int32_t mm_camera_poll_thread_add_poll_fd(
                                 mm_camera_poll_thread_t * poll_cb,
@@ -0,0 +1,100 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __MM_CAMERA_SUPERBUF_SLOTS_H__
+#define __MM_CAMERA_SUPERBUF_SLOTS_H__
+
+#include <stdint.h>
+#include <string.h>
+#include "cam_list.h"
+
+/* Number of slots in the frame_idx ring of a superbuf queue, power of 2.
+ * Frames that land on an occupied slot are left to the linear queue walk. */
+#define MM_CHANNEL_SUPERBUF_SLOTS 64
+
+typedef struct {
+    /* queue position of the superbuf owning the slot, NULL if free */
+    struct cam_list *pos[MM_CHANNEL_SUPERBUF_SLOTS];
+    /* frame_idx of that superbuf */
+    uint32_t frame_idx[MM_CHANNEL_SUPERBUF_SLOTS];
+} mm_channel_superbuf_slots_t;
+
+/* frame_idx is kept in full next to each slot, so the ring stays correct
+ * across any rollover of the sequence mm_channel_util_seq_comp_w_rollover
+ * compares; only the low bits select the slot */
+static inline uint32_t mm_channel_superbuf_slot_of(uint32_t frame_idx)
+{
+    return frame_idx & (MM_CHANNEL_SUPERBUF_SLOTS - 1);
+}
+
+static inline void mm_channel_superbuf_slots_reset(
+        mm_channel_superbuf_slots_t *slots)
+{
+    memset(slots, 0, sizeof(*slots));
+}
+
+/* index a superbuf that was just added to the queue */
+static inline void mm_channel_superbuf_slots_add(
+        mm_channel_superbuf_slots_t *slots, uint32_t frame_idx,
+        struct cam_list *pos)
+{
+    uint32_t slot = mm_channel_superbuf_slot_of(frame_idx);
+
+    if (NULL == slots->pos[slot]) {
+        slots->pos[slot] = pos;
+        slots->frame_idx[slot] = frame_idx;
+    }
+}
+
+/* drop a superbuf that is being removed from the queue */
+static inline void mm_channel_superbuf_slots_del(
+        mm_channel_superbuf_slots_t *slots, uint32_t frame_idx,
+        struct cam_list *pos)
+{
+    uint32_t slot = mm_channel_superbuf_slot_of(frame_idx);
+
+    if (pos == slots->pos[slot]) {
+        slots->pos[slot] = NULL;
+    }
+}
+
+/* queue position of the superbuf for frame_idx, NULL if it is not indexed */
+static inline struct cam_list *mm_channel_superbuf_slots_find(
+        mm_channel_superbuf_slots_t *slots, uint32_t frame_idx)
+{
+    uint32_t slot = mm_channel_superbuf_slot_of(frame_idx);
+
+    if ((NULL != slots->pos[slot]) &&
+            (frame_idx == slots->frame_idx[slot])) {
+        return slots->pos[slot];
+    }
+    return NULL;
+}
+
+#endif /* __MM_CAMERA_SUPERBUF_SLOTS_H__ */
@@ -357,7 +357,8 @@ int32_t mm_camera_open(mm_camera_obj_t *my_obj)
     CDBG("%s : Launch evt Poll Thread in Cam Open", __func__);
     snprintf(my_obj->evt_poll_thread.threadName, THREAD_NAME_SIZE, "CAM_evntPoll");
     mm_camera_poll_thread_launch(&my_obj->evt_poll_thread,
-                                 MM_CAMERA_POLL_TYPE_EVT);
+                                 MM_CAMERA_POLL_TYPE_EVT,
+                                 MM_CAMERA_POLL_ENGINE_DEFAULT);
     mm_camera_evt_sub(my_obj, TRUE);
 
     /* unlock cam_lock, we need release global intf_lock in camera_open(),
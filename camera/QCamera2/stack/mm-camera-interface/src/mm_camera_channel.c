@@ -1165,7 +1165,8 @@ int32_t mm_channel_init(mm_channel_t *my_obj,
     CDBG("%s : Launch data poll thread in channel open", __func__);
     snprintf(my_obj->threadName, THREAD_NAME_SIZE, "CAM_dataPoll");
     mm_camera_poll_thread_launch(&my_obj->poll_thread[0],
-                                 MM_CAMERA_POLL_TYPE_DATA);
+                                 MM_CAMERA_POLL_TYPE_DATA,
+                                 MM_CAMERA_POLL_ENGINE_DEFAULT);
 
     /* change state to stopped state */
     my_obj->state = MM_CHANNEL_STATE_STOPPED;
@@ -2299,6 +2300,7 @@ int32_t mm_channel_unmap_stream_buf(mm_channel_t *my_obj,
  *==========================================================================*/
 int32_t mm_channel_superbuf_queue_init(mm_channel_queue_t * queue)
 {
+    mm_channel_superbuf_slots_reset(&queue->slots);
     return cam_queue_init(&queue->que);
 }
 
@@ -2316,6 +2318,7 @@ int32_t mm_channel_superbuf_queue_init(mm_channel_queue_t * queue)
  *==========================================================================*/
 int32_t mm_channel_superbuf_queue_deinit(mm_channel_queue_t * queue)
 {
+    mm_channel_superbuf_slots_reset(&queue->slots);
     return cam_queue_deinit(&queue->que);
 }
 
@@ -2630,9 +2633,11 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                         mm_camera_buf_info_t *buf_info)
 {
     cam_node_t* node = NULL;
+    struct cam_list *slot_pos = NULL;
     struct cam_list *head = NULL;
     struct cam_list *pos = NULL;
     mm_channel_queue_node_t* super_buf = NULL;
+    mm_channel_queue_node_t* older_buf = NULL;
     uint8_t buf_s_idx, i, found_super_buf, unmatched_bundles;
     struct cam_list *last_buf, *insert_before_buf, *last_buf_ptr;
 
@@ -2687,7 +2692,30 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
     insert_before_buf = NULL;
     last_buf_ptr = NULL;
 
-    while (pos != head) {
+    /* Exact frame_idx matches come straight from the slot ring. The walk
+     * below is kept for the nomatch metadata and low priority rules, which
+     * may bundle into a superbuf of another frame, and for placing new
+     * frames in the queue. */
+    if (!((queue->nomatch_frame_id != 0)
+            && (buf_info->buf->stream_type == CAM_STREAM_TYPE_METADATA))
+            && !((queue->attr.priority == MM_CAMERA_SUPER_BUF_PRIORITY_LOW)
+            && (buf_info->buf->stream_type != CAM_STREAM_TYPE_METADATA))) {
+        slot_pos = mm_channel_superbuf_slots_find(&queue->slots,
+                buf_info->frame_idx);
+        if (NULL != slot_pos) {
+            node = member_of(slot_pos, cam_node_t, list);
+            super_buf = (mm_channel_queue_node_t*)node->data;
+            if ((NULL != super_buf) && !super_buf->matched) {
+                found_super_buf = 1;
+                queue->nomatch_frame_id = 0;
+                pos = slot_pos;
+            } else {
+                slot_pos = NULL;
+            }
+        }
+    }
+
+    while (!found_super_buf && (pos != head)) {
         node = member_of(pos, cam_node_t, list);
         super_buf = (mm_channel_queue_node_t*)node->data;
 
@@ -2731,7 +2759,7 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
     }
 
     if ( found_super_buf ) {
-        if(super_buf->super_buf[buf_s_idx].frame_idx != 0) {
+        if (super_buf->filled_mask & (1U << buf_s_idx)) {
             //This can cause frame drop. We are overwriting same memory.
             pthread_mutex_unlock(&queue->que.lock);
             //CDBG_FATAL("FATAL: frame is already in camera ZSL queue");
@@ -2742,15 +2770,11 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
 
         /*Insert incoming buffer to super buffer*/
         super_buf->super_buf[buf_s_idx] = *buf_info;
+        super_buf->filled_mask |= (1U << buf_s_idx);
 
         /* check if superbuf is all matched */
-        super_buf->matched = 1;
-        for (i=0; i < super_buf->num_of_bufs; i++) {
-            if (super_buf->super_buf[i].frame_idx == 0) {
-                super_buf->matched = 0;
-                break;
-            }
-        }
+        super_buf->matched = (super_buf->filled_mask ==
+                ((1U << super_buf->num_of_bufs) - 1)) ? 1 : 0;
 
         if (super_buf->matched) {
             if(ch_obj->isFlashBracketingEnabled) {
@@ -2777,6 +2801,23 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                 mm_frame_sync_add(buf_info->frame_idx, ch_obj);
                 pthread_mutex_unlock(&fs_lock);
             }
+            if (NULL != slot_pos) {
+                /* matched through the slot ring, so find the oldest
+                 * unmatched superbuf ahead of it as the walk would have */
+                for (last_buf = head->next; last_buf != pos;
+                        last_buf = last_buf->next) {
+                    node = member_of(last_buf, cam_node_t, list);
+                    older_buf = (mm_channel_queue_node_t*)node->data;
+                    if ((NULL != older_buf) && !older_buf->matched &&
+                            (older_buf->frame_idx < buf_info->frame_idx)) {
+                        break;
+                    }
+                }
+                if (last_buf == pos) {
+                    last_buf = NULL;
+                }
+            }
+
             /* Any older unmatched buffer need to be released */
             if ( last_buf ) {
                 while ( last_buf != pos ) {
@@ -2790,6 +2831,8 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                         }
                         queue->que.size--;
                         last_buf = last_buf->next;
+                        mm_channel_superbuf_slots_del(&queue->slots,
+                                super_buf->frame_idx, &node->list);
                         cam_list_del_node(&node->list);
                         free(node);
                         free(super_buf);
@@ -2818,6 +2861,8 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                     && (last_buf_ptr != NULL && last_buf_ptr != pos)) {
                 node = member_of(last_buf_ptr, cam_node_t, list);
                 super_buf = (mm_channel_queue_node_t*)node->data;
+                /* step ahead before the node can be freed */
+                last_buf_ptr = last_buf_ptr->next;
                 if (NULL != super_buf && super_buf->expected == FALSE
                         && (&node->list != insert_before_buf)) {
                     for (i=0; i<super_buf->num_of_bufs; i++) {
@@ -2826,15 +2871,20 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                         }
                     }
                     queue->que.size--;
+                    mm_channel_superbuf_slots_del(&queue->slots,
+                            super_buf->frame_idx, &node->list);
+                    if (&node->list == last_buf) {
+                        last_buf = NULL;
+                    }
                     cam_list_del_node(&node->list);
                     free(node);
                     free(super_buf);
                     unmatched_bundles--;
                 }
-                last_buf_ptr = last_buf_ptr->next;
             }
 
-            if (queue->attr.max_unmatched_frames < unmatched_bundles) {
+            if ((queue->attr.max_unmatched_frames < unmatched_bundles)
+                    && (NULL != last_buf)) {
                 node = member_of(last_buf, cam_node_t, list);
                 super_buf = (mm_channel_queue_node_t*)node->data;
                 for (i=0; i<super_buf->num_of_bufs; i++) {
@@ -2843,6 +2893,8 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                     }
                 }
                 queue->que.size--;
+                mm_channel_superbuf_slots_del(&queue->slots,
+                        super_buf->frame_idx, &node->list);
                 cam_list_del_node(&node->list);
                 free(node);
                 free(super_buf);
@@ -2861,6 +2913,7 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                 new_node->data = (void *)new_buf;
                 new_buf->num_of_bufs = queue->num_streams;
                 new_buf->super_buf[buf_s_idx] = *buf_info;
+                new_buf->filled_mask = (1U << buf_s_idx);
                 new_buf->frame_idx = buf_info->frame_idx;
 
                 if (ch_obj->diverted_frame_id == buf_info->frame_idx) {
@@ -2875,6 +2928,8 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                     cam_list_add_tail_node(&new_node->list, &queue->que.head.list);
                 }
                 queue->que.size++;
+                mm_channel_superbuf_slots_add(&queue->slots,
+                        new_buf->frame_idx, &new_node->list);
 
                 if(queue->num_streams == 1) {
                     new_buf->matched = 1;
@@ -2949,6 +3004,8 @@ mm_channel_queue_node_t* mm_channel_superbuf_dequeue_internal(
         }
         if (NULL != super_buf) {
             /* remove from the queue */
+            mm_channel_superbuf_slots_del(&queue->slots,
+                    super_buf->frame_idx, &node->list);
             cam_list_del_node(&node->list);
             queue->que.size--;
             if (super_buf->matched == TRUE) {
@@ -3002,6 +3059,8 @@ mm_channel_queue_node_t* mm_channel_superbuf_dequeue_frame_internal(
         if (super_buf && super_buf->matched &&
                 (super_buf->frame_idx == frame_idx)) {
             /* remove from the queue */
+            mm_channel_superbuf_slots_del(&queue->slots,
+                    super_buf->frame_idx, &node->list);
             cam_list_del_node(&node->list);
             queue->que.size--;
             queue->match_cnt--;
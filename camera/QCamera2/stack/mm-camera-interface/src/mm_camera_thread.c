@@ -37,6 +37,8 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <sys/epoll.h>
+#include <cutils/properties.h>
 #include <cam_semaphore.h>
 
 #include "mm_camera_dbg.h"
@@ -67,6 +69,10 @@ typedef struct {
     mm_camera_event_t event;
 } mm_camera_sig_evt_t;
 
+/* back off on consecutive poll failures, from min doubling up to max */
+#define MM_CAMERA_POLL_ERR_SLEEP_MIN_US 1000
+#define MM_CAMERA_POLL_ERR_SLEEP_MAX_US 100000
+
 
 /*===========================================================================
  * FUNCTION   : mm_camera_poll_sig_async
@@ -199,6 +205,82 @@ static void mm_camera_poll_set_state(mm_camera_poll_thread_t *poll_cb,
     poll_cb->state = state;
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_err_sleep
+ *
+ * DESCRIPTION: sleep after a failed poll, doubling the delay on each
+ *              consecutive failure
+ *
+ * PARAMETERS :
+ *   @sleep_us : current delay, updated for the next failure
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void mm_camera_poll_err_sleep(uint32_t *sleep_us)
+{
+    usleep(*sleep_us);
+    if (*sleep_us < MM_CAMERA_POLL_ERR_SLEEP_MAX_US) {
+        *sleep_us *= 2;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_epoll_sync
+ *
+ * DESCRIPTION: bring the epoll set in line with the poll entries. Entries
+ *              whose fd did not change stay registered; the event data of
+ *              each fd points at its poll entry.
+ *
+ * PARAMETERS :
+ *   @poll_cb : ptr to poll thread object
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void mm_camera_poll_epoll_sync(mm_camera_poll_thread_t *poll_cb)
+{
+    struct epoll_event ev;
+    int32_t fd;
+    uint8_t i, num_entries;
+
+    /* for MM_CAMERA_POLL_TYPE_EVT only index 0 is valid */
+    num_entries = (MM_CAMERA_POLL_TYPE_EVT == poll_cb->poll_type) ?
+            1 : MAX_STREAM_NUM_IN_BUNDLE;
+
+    for (i = 0; i < num_entries; i++) {
+        fd = poll_cb->poll_entries[i].fd;
+        if ((poll_cb->epoll_reg_fds[i] >= 0) &&
+                (poll_cb->epoll_reg_fds[i] != fd)) {
+            /* fails harmlessly if the fd was closed already */
+            epoll_ctl(poll_cb->epoll_fd, EPOLL_CTL_DEL,
+                    poll_cb->epoll_reg_fds[i], NULL);
+            poll_cb->epoll_reg_fds[i] = -1;
+        }
+        if (fd < 0) {
+            continue;
+        }
+
+        memset(&ev, 0, sizeof(ev));
+        if (MM_CAMERA_POLL_TYPE_EVT == poll_cb->poll_type) {
+            ev.events = EPOLLPRI;
+        } else {
+            ev.events = EPOLLIN | EPOLLRDNORM;
+        }
+        ev.data.ptr = &poll_cb->poll_entries[i];
+
+        /* a registered fd number may meanwhile belong to a reopened file,
+         * which epoll does not know yet, so fall back to adding it */
+        if (((poll_cb->epoll_reg_fds[i] != fd) ||
+                (epoll_ctl(poll_cb->epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0)) &&
+                (epoll_ctl(poll_cb->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)) {
+            CDBG_ERROR("%s: failed to add fd %d to epoll, errno = %d",
+                    __func__, fd, errno);
+            poll_cb->epoll_reg_fds[i] = -1;
+            continue;
+        }
+        poll_cb->epoll_reg_fds[i] = fd;
+    }
+}
+
 /*===========================================================================
  * FUNCTION   : mm_camera_poll_proc_pipe
  *
@@ -220,6 +302,12 @@ static void mm_camera_poll_proc_pipe(mm_camera_poll_thread_t *poll_cb)
     switch (cmd_evt.cmd) {
     case MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED:
     case MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC:
+        if (MM_CAMERA_POLL_ENGINE_EPOLL == poll_cb->engine) {
+            mm_camera_poll_epoll_sync(poll_cb);
+            if (cmd_evt.cmd != MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC)
+                mm_camera_poll_sig_done(poll_cb);
+            break;
+        }
         /* we always have index 0 for pipe read */
         poll_cb->num_fds = 0;
         poll_cb->poll_fds[poll_cb->num_fds].fd = poll_cb->pfds[0];
@@ -284,6 +372,7 @@ static void mm_camera_poll_proc_pipe(mm_camera_poll_thread_t *poll_cb)
 static void *mm_camera_poll_fn(mm_camera_poll_thread_t *poll_cb)
 {
     int rc = 0, i;
+    uint32_t err_sleep_us = MM_CAMERA_POLL_ERR_SLEEP_MIN_US;
 
     if (NULL == poll_cb) {
         CDBG_ERROR("%s: poll_cb is NULL!\n", __func__);
@@ -292,12 +381,10 @@ static void *mm_camera_poll_fn(mm_camera_poll_thread_t *poll_cb)
     CDBG("%s: poll type = %d, num_fd = %d poll_cb = %p\n",
          __func__, poll_cb->poll_type, poll_cb->num_fds,poll_cb);
     do {
-         for(i = 0; i < poll_cb->num_fds; i++) {
-            poll_cb->poll_fds[i].events = POLLIN|POLLRDNORM|POLLPRI;
-         }
-
+         /* events of poll_fds are set up when the entries are updated */
          rc = poll(poll_cb->poll_fds, poll_cb->num_fds, poll_cb->timeoutms);
          if(rc > 0) {
+            err_sleep_us = MM_CAMERA_POLL_ERR_SLEEP_MIN_US;
             if ((poll_cb->poll_fds[0].revents & POLLIN) &&
                 (poll_cb->poll_fds[0].revents & POLLRDNORM)) {
                 /* if we have data on pipe, we only process pipe in this iteration */
@@ -324,15 +411,77 @@ static void *mm_camera_poll_fn(mm_camera_poll_thread_t *poll_cb)
                     }
                 }
             }
-        } else {
-            /* in error case sleep 10 us and then continue. hard coded here */
-            usleep(10);
-            continue;
+        } else if ((rc < 0) && (errno != EINTR)) {
+            CDBG_ERROR("%s: poll failed, errno = %d", __func__, errno);
+            mm_camera_poll_err_sleep(&err_sleep_us);
         }
     } while ((poll_cb != NULL) && (poll_cb->state == MM_CAMERA_POLL_TASK_STATE_POLL));
     return NULL;
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_epoll_fn
+ *
+ * DESCRIPTION: polling thread routine of the epoll engine. Ready fds hand
+ *              back their poll entry, so callbacks are dispatched without
+ *              scanning the entries.
+ *
+ * PARAMETERS :
+ *   @poll_cb : ptr to poll thread object
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void *mm_camera_poll_epoll_fn(mm_camera_poll_thread_t *poll_cb)
+{
+    struct epoll_event events[MAX_STREAM_NUM_IN_BUNDLE + 1];
+    mm_camera_poll_entry_t *entry;
+    uint32_t err_sleep_us = MM_CAMERA_POLL_ERR_SLEEP_MIN_US;
+    int rc, i;
+
+    CDBG("%s: poll type = %d, epoll fd = %d poll_cb = %p\n",
+         __func__, poll_cb->poll_type, poll_cb->epoll_fd, poll_cb);
+    do {
+        rc = epoll_wait(poll_cb->epoll_fd, events,
+                (int)ARRAY_SIZE(events), poll_cb->timeoutms);
+        if (rc < 0) {
+            if (errno != EINTR) {
+                CDBG_ERROR("%s: epoll_wait failed, errno = %d",
+                        __func__, errno);
+                mm_camera_poll_err_sleep(&err_sleep_us);
+            }
+            continue;
+        }
+        err_sleep_us = MM_CAMERA_POLL_ERR_SLEEP_MIN_US;
+
+        /* if we have data on pipe, we only process pipe in this iteration,
+         * the entries of the other events may be gone after it */
+        for (i = 0; i < rc; i++) {
+            if (NULL == events[i].data.ptr) {
+                break;
+            }
+        }
+        if (i < rc) {
+            CDBG("%s: cmd received on pipe\n", __func__);
+            mm_camera_poll_proc_pipe(poll_cb);
+            continue;
+        }
+
+        for (i = 0; i < rc; i++) {
+            entry = (mm_camera_poll_entry_t *)events[i].data.ptr;
+            if (((MM_CAMERA_POLL_TYPE_EVT == poll_cb->poll_type) &&
+                    (events[i].events & EPOLLPRI)) ||
+                    ((MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type) &&
+                    (events[i].events & EPOLLIN) &&
+                    (events[i].events & EPOLLRDNORM))) {
+                if (NULL != entry->notify_cb) {
+                    entry->notify_cb(entry->user_data);
+                }
+            }
+        }
+    } while (poll_cb->state == MM_CAMERA_POLL_TASK_STATE_POLL);
+    return NULL;
+}
+
 /*===========================================================================
  * FUNCTION   : mm_camera_poll_thread
  *
@@ -349,10 +498,15 @@ static void *mm_camera_poll_thread(void *data)
 
     mm_camera_cmd_thread_name(poll_cb->threadName);
     /* add pipe read fd into poll first */
-    poll_cb->poll_fds[poll_cb->num_fds++].fd = poll_cb->pfds[0];
+    poll_cb->poll_fds[poll_cb->num_fds].fd = poll_cb->pfds[0];
+    poll_cb->poll_fds[poll_cb->num_fds].events = POLLIN|POLLRDNORM|POLLPRI;
+    poll_cb->num_fds++;
 
     mm_camera_poll_sig_done(poll_cb);
     mm_camera_poll_set_state(poll_cb, MM_CAMERA_POLL_TASK_STATE_POLL);
+    if (MM_CAMERA_POLL_ENGINE_EPOLL == poll_cb->engine) {
+        return mm_camera_poll_epoll_fn(poll_cb);
+    }
     return mm_camera_poll_fn(poll_cb);
 }
 
@@ -493,13 +647,45 @@ int32_t mm_camera_poll_thread_del_poll_fd(mm_camera_poll_thread_t * poll_cb,
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_thread_launch
+ *
+ * DESCRIPTION: launch a polling thread
+ *
+ * PARAMETERS :
+ *   @poll_cb   : ptr to poll thread object
+ *   @poll_type : event or data polling thread
+ *   @engine    : poll() or epoll based polling,
+ *                MM_CAMERA_POLL_ENGINE_DEFAULT follows
+ *                persist.camera.poll.engine ("poll" or "epoll")
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
 int32_t mm_camera_poll_thread_launch(mm_camera_poll_thread_t * poll_cb,
-                                     mm_camera_poll_thread_type_t poll_type)
+                                     mm_camera_poll_thread_type_t poll_type,
+                                     mm_camera_poll_engine_t engine)
 {
     int32_t rc = 0;
     size_t i = 0, cnt = 0;
+    char prop[PROPERTY_VALUE_MAX];
+    struct epoll_event ev;
+
     poll_cb->poll_type = poll_type;
 
+    if (MM_CAMERA_POLL_ENGINE_DEFAULT == engine) {
+        property_get("persist.camera.poll.engine", prop, "epoll");
+        engine = strcmp(prop, "poll") ?
+                MM_CAMERA_POLL_ENGINE_EPOLL : MM_CAMERA_POLL_ENGINE_POLL;
+    }
+    poll_cb->engine = engine;
+    poll_cb->epoll_fd = -1;
+    cnt = sizeof(poll_cb->epoll_reg_fds) / sizeof(poll_cb->epoll_reg_fds[0]);
+    for (i = 0; i < cnt; i++) {
+        poll_cb->epoll_reg_fds[i] = -1;
+    }
+
     //Initialize poll_fds
     cnt = sizeof(poll_cb->poll_fds) / sizeof(poll_cb->poll_fds[0]);
     for (i = 0; i < cnt; i++) {
@@ -519,6 +705,24 @@ int32_t mm_camera_poll_thread_launch(mm_camera_poll_thread_t * poll_cb,
         return -1;
     }
 
+    if (MM_CAMERA_POLL_ENGINE_EPOLL == poll_cb->engine) {
+        poll_cb->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        /* the pipe is the only fd without a poll entry */
+        ev.data.ptr = NULL;
+        if ((poll_cb->epoll_fd < 0) || (epoll_ctl(poll_cb->epoll_fd,
+                EPOLL_CTL_ADD, poll_cb->pfds[0], &ev) < 0)) {
+            CDBG_ERROR("%s: epoll setup failed, errno = %d, using poll",
+                    __func__, errno);
+            if (poll_cb->epoll_fd >= 0) {
+                close(poll_cb->epoll_fd);
+                poll_cb->epoll_fd = -1;
+            }
+            poll_cb->engine = MM_CAMERA_POLL_ENGINE_POLL;
+        }
+    }
+
     poll_cb->timeoutms = -1;  /* Infinite seconds */
 
     CDBG("%s: poll_type = %d, read fd = %d, write fd = %d timeout = %d",
@@ -563,12 +767,16 @@ int32_t mm_camera_poll_thread_release(mm_camera_poll_thread_t *poll_cb)
     if(poll_cb->pfds[1] >= 0) {
         close(poll_cb->pfds[1]);
     }
+    if(poll_cb->epoll_fd >= 0) {
+        close(poll_cb->epoll_fd);
+    }
 
     pthread_mutex_destroy(&poll_cb->mutex);
     pthread_cond_destroy(&poll_cb->cond_v);
     memset(poll_cb, 0, sizeof(mm_camera_poll_thread_t));
     poll_cb->pfds[0] = -1;
     poll_cb->pfds[1] = -1;
+    poll_cb->epoll_fd = -1;
     return rc;
 }
 
@@ -0,0 +1,53 @@
+#superbuf matching test, drives mm_camera_channel.c, runs on the target
+OLD_LOCAL_PATH := $(LOCAL_PATH)
+MM_CAMERA_TEST_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(MM_CAMERA_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS += -Wall -Wextra -Werror
+LOCAL_CFLAGS += -D_ANDROID_
+
+LOCAL_C_INCLUDES := $(MM_CAMERA_TEST_PATH)/../inc
+LOCAL_C_INCLUDES += $(MM_CAMERA_TEST_PATH)/../../common
+LOCAL_C_INCLUDES += system/media/camera/include
+
+LOCAL_HEADER_LIBRARIES := generated_kernel_headers
+LOCAL_HEADER_LIBRARIES += camera_common_headers
+
+LOCAL_SRC_FILES := mm_camera_superbuf_test.c
+LOCAL_SRC_FILES += ../src/mm_camera_channel.c
+
+LOCAL_32_BIT_ONLY := $(BOARD_QTI_CAMERA_32BIT_ONLY)
+LOCAL_MODULE           := mm-camera-superbuf-test
+LOCAL_VENDOR_MODULE := true
+LOCAL_PRELINK_MODULE   := false
+LOCAL_SHARED_LIBRARIES := libcutils liblog
+
+include $(BUILD_EXECUTABLE)
+
+#poll thread dispatch latency benchmark, runs on the target
+include $(CLEAR_VARS)
+LOCAL_PATH := $(MM_CAMERA_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS += -Wall -Wextra -Werror
+LOCAL_CFLAGS += -D_ANDROID_
+
+LOCAL_C_INCLUDES := $(MM_CAMERA_TEST_PATH)/../inc
+LOCAL_C_INCLUDES += $(MM_CAMERA_TEST_PATH)/../../common
+
+LOCAL_HEADER_LIBRARIES := generated_kernel_headers
+
+LOCAL_SRC_FILES := mm_camera_poll_bench.c
+
+LOCAL_32_BIT_ONLY := $(BOARD_QTI_CAMERA_32BIT_ONLY)
+LOCAL_MODULE           := mm-camera-poll-bench
+LOCAL_VENDOR_MODULE := true
+LOCAL_PRELINK_MODULE   := false
+LOCAL_SHARED_LIBRARIES := libcutils liblog libmmcamera_interface
+
+include $(BUILD_EXECUTABLE)
+
+LOCAL_PATH := $(OLD_LOCAL_PATH)
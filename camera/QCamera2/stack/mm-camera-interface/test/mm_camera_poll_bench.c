@@ -0,0 +1,195 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Wakeup-to-callback latency of the mm-camera poll thread engines.
+ * Pipes stand in for the V4L2 stream fds: a producer writes a timestamp
+ * into every stream pipe once per frame and the notify callback of the
+ * data poll thread reads it back, the way mm_stream_data_notify dequeues
+ * one buffer per notification. Pipes are used rather than eventfds since
+ * the poll thread, like V4L2, signals data with POLLIN|POLLRDNORM. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+
+#include "mm_camera.h"
+
+#define BENCH_MAX_SAMPLES (1024 * 1024)
+
+typedef struct {
+    int fds[2];
+    uint32_t idx;
+} bench_stream_t;
+
+static uint64_t *g_lat;
+static uint32_t g_num_lat;
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* runs on the poll thread only, so the samples need no lock */
+static void bench_notify(void *user_data)
+{
+    bench_stream_t *stream = (bench_stream_t *)user_data;
+    uint64_t sent;
+
+    if (read(stream->fds[0], &sent, sizeof(sent)) != (ssize_t)sizeof(sent)) {
+        return;
+    }
+    if (g_num_lat < BENCH_MAX_SAMPLES) {
+        g_lat[g_num_lat++] = bench_now_ns() - sent;
+    }
+}
+
+static int bench_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int bench_run(mm_camera_poll_engine_t engine, uint32_t num_streams,
+        uint32_t fps, uint32_t seconds)
+{
+    mm_camera_poll_thread_t poll_cb;
+    bench_stream_t streams[MAX_STREAM_NUM_IN_BUNDLE];
+    struct timespec next;
+    uint64_t now, sum = 0;
+    uint32_t frame, i, sent = 0;
+    int rc = 0;
+
+    memset(&poll_cb, 0, sizeof(poll_cb));
+    memset(streams, 0, sizeof(streams));
+    g_num_lat = 0;
+
+    snprintf(poll_cb.threadName, THREAD_NAME_SIZE, "CAM_benchPoll");
+    if (mm_camera_poll_thread_launch(&poll_cb, MM_CAMERA_POLL_TYPE_DATA,
+            engine) < 0) {
+        printf("failed to launch poll thread\n");
+        return -1;
+    }
+
+    for (i = 0; i < num_streams; i++) {
+        streams[i].idx = i;
+        if (pipe(streams[i].fds) < 0) {
+            printf("pipe failed, errno = %d\n", errno);
+            rc = -1;
+            num_streams = i;
+            goto end;
+        }
+        /* the poll thread takes the stream index from the handler */
+        mm_camera_poll_thread_add_poll_fd(&poll_cb, (1U << 8) | i,
+                streams[i].fds[0], bench_notify, &streams[i],
+                mm_camera_sync_call);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (frame = 0; frame < fps * seconds; frame++) {
+        next.tv_nsec += 1000000000L / fps;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        for (i = 0; i < num_streams; i++) {
+            now = bench_now_ns();
+            if (write(streams[i].fds[1], &now, sizeof(now)) ==
+                    (ssize_t)sizeof(now)) {
+                sent++;
+            }
+        }
+    }
+    /* let the last frame drain */
+    usleep(100000);
+
+end:
+    for (i = 0; i < num_streams; i++) {
+        mm_camera_poll_thread_del_poll_fd(&poll_cb, (1U << 8) | i,
+                mm_camera_sync_call);
+    }
+    mm_camera_poll_thread_release(&poll_cb);
+    for (i = 0; i < num_streams; i++) {
+        close(streams[i].fds[0]);
+        close(streams[i].fds[1]);
+    }
+
+    if ((0 == rc) && (g_num_lat > 0)) {
+        for (i = 0; i < g_num_lat; i++) {
+            sum += g_lat[i];
+        }
+        qsort(g_lat, g_num_lat, sizeof(*g_lat), bench_cmp_u64);
+        printf("%-6s: %u streams at %u fps, %u/%u buffers, wakeup to "
+                "callback avg %llu us, p50 %llu us, p99 %llu us, "
+                "max %llu us\n",
+                (MM_CAMERA_POLL_ENGINE_EPOLL == engine) ? "epoll" : "poll",
+                num_streams, fps, g_num_lat, sent,
+                (unsigned long long)(sum / g_num_lat / 1000),
+                (unsigned long long)(g_lat[g_num_lat / 2] / 1000),
+                (unsigned long long)(g_lat[(g_num_lat * 99) / 100] / 1000),
+                (unsigned long long)(g_lat[g_num_lat - 1] / 1000));
+    }
+    return rc;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t num_streams = (argc > 1) ? (uint32_t)atoi(argv[1]) : 6;
+    uint32_t fps = (argc > 2) ? (uint32_t)atoi(argv[2]) : 120;
+    uint32_t seconds = (argc > 3) ? (uint32_t)atoi(argv[3]) : 5;
+    int rc = 0;
+
+    if ((num_streams == 0) || (num_streams > MAX_STREAM_NUM_IN_BUNDLE) ||
+            (fps == 0) || (seconds == 0)) {
+        printf("usage: %s [streams 1-%d] [fps] [seconds]\n",
+                argv[0], MAX_STREAM_NUM_IN_BUNDLE);
+        return -1;
+    }
+
+    g_lat = (uint64_t *)malloc(BENCH_MAX_SAMPLES * sizeof(*g_lat));
+    if (NULL == g_lat) {
+        return -1;
+    }
+
+    if ((bench_run(MM_CAMERA_POLL_ENGINE_POLL, num_streams, fps, seconds) < 0) ||
+            (bench_run(MM_CAMERA_POLL_ENGINE_EPOLL, num_streams, fps, seconds) < 0)) {
+        rc = -1;
+    }
+
+    free(g_lat);
+    return rc;
+}
@@ -0,0 +1,834 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Superbuf matching test for mm_camera_channel.c.
+ * Buffers of several bundled streams are fed out of order, with drops, into
+ * two channel fixtures. One runs mm_channel_superbuf_comp_and_enqueue with
+ * its frame_idx slot ring, the other the former linear queue walk kept
+ * below as the reference. After every buffer both superbuf queues, the
+ * queue counters and the set of buffers returned to their streams must be
+ * identical, and the slot ring may only index queued superbufs. The
+ * scenarios cover exact matching and the metadata stream with the normal
+ * and the low priority bundling rules. The per-buffer matching latency of
+ * both is reported. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <poll.h>
+#include "mm_camera_dbg.h"
+#include "mm_camera_interface.h"
+#include "mm_camera.h"
+
+/* superbuf queue functions of mm_camera_channel.c under test */
+extern int32_t mm_channel_superbuf_queue_init(mm_channel_queue_t * queue);
+extern int32_t mm_channel_superbuf_queue_deinit(mm_channel_queue_t * queue);
+extern int32_t mm_channel_superbuf_comp_and_enqueue(mm_channel_t *ch_obj,
+                                                    mm_channel_queue_t * queue,
+                                                    mm_camera_buf_info_t *buf);
+extern mm_channel_queue_node_t* mm_channel_superbuf_dequeue(
+        mm_channel_queue_t * queue, mm_channel_t *ch_obj);
+extern int32_t mm_channel_superbuf_flush(mm_channel_t* my_obj,
+        mm_channel_queue_t * queue, cam_stream_type_t cam_type);
+extern int32_t mm_channel_qbuf(mm_channel_t *my_obj,
+                               mm_camera_buf_def_t *buf);
+extern int32_t mm_channel_handle_metadata(mm_channel_t* ch_obj,
+                                          mm_channel_queue_t * queue,
+                                          mm_camera_buf_info_t *buf_info);
+extern int8_t mm_channel_util_seq_comp_w_rollover(uint32_t v1,
+                                                  uint32_t v2);
+
+#define MAX_STREAMS 6
+#define MAX_UNMATCHED 8
+
+typedef struct {
+    /* first member, the stream stubs map a channel back to its fixture */
+    mm_channel_t ch;
+    cam_stream_info_t info[MAX_STREAMS];
+    mm_camera_buf_def_t *bufs;
+    /* times each buffer was returned to its stream */
+    uint8_t *qbuf_cnt;
+    uint32_t num_bufs;
+    uint8_t use_ref;
+    uint64_t ns;
+    uint32_t delivered;
+} test_fixture_t;
+
+typedef struct {
+    uint32_t frame_idx;
+    uint8_t stream;
+} test_buf_t;
+
+typedef struct {
+    const char *name;
+    uint8_t has_metadata;
+    mm_camera_super_buf_priority_t priority;
+} test_scenario_t;
+
+typedef struct {
+    uint8_t num_streams;
+    uint32_t num_frames;
+    uint32_t jitter;
+    uint32_t zsl_depth;
+    uint32_t drop_permille;
+} test_cfg_t;
+
+volatile uint32_t gMmCameraIntfLogLevel = 0;
+
+static metadata_buffer_t *test_metadata;
+
+/* stream, thread and camera entry points mm_camera_channel.c refers to;
+ * only the buffer returns of the matcher reach them */
+int32_t mm_stream_fsm_fn(mm_stream_t *my_obj, mm_stream_evt_type_t evt,
+        void *in_val, void *out_val)
+{
+    test_fixture_t *f = (test_fixture_t *)my_obj->ch_obj;
+    mm_camera_buf_def_t *buf = (mm_camera_buf_def_t *)in_val;
+
+    (void)out_val;
+    if ((MM_STREAM_EVT_QBUF != evt) || (NULL == buf) ||
+            (buf->buf_idx >= f->num_bufs)) {
+        return -1;
+    }
+    f->qbuf_cnt[buf->buf_idx]++;
+    return 0;
+}
+
+int32_t mm_stream_reg_buf_cb(mm_stream_t *my_obj, mm_stream_data_cb_t val)
+{
+    (void)my_obj;
+    (void)val;
+    return -1;
+}
+
+int32_t mm_stream_map_buf(mm_stream_t *my_obj, uint8_t buf_type,
+        uint32_t frame_idx, int32_t plane_idx, int fd, size_t size)
+{
+    (void)my_obj;
+    (void)buf_type;
+    (void)frame_idx;
+    (void)plane_idx;
+    (void)fd;
+    (void)size;
+    return -1;
+}
+
+int32_t mm_stream_map_bufs(mm_stream_t *my_obj,
+        const cam_buf_map_type_list *buf_map_list)
+{
+    (void)my_obj;
+    (void)buf_map_list;
+    return -1;
+}
+
+int32_t mm_stream_unmap_buf(mm_stream_t *my_obj, uint8_t buf_type,
+        uint32_t frame_idx, int32_t plane_idx)
+{
+    (void)my_obj;
+    (void)buf_type;
+    (void)frame_idx;
+    (void)plane_idx;
+    return -1;
+}
+
+int32_t mm_camera_cmd_thread_launch(mm_camera_cmd_thread_t *cmd_thread,
+        mm_camera_cmd_cb_t cb, void *user_data)
+{
+    (void)cmd_thread;
+    (void)cb;
+    (void)user_data;
+    return -1;
+}
+
+int32_t mm_camera_cmd_thread_release(mm_camera_cmd_thread_t *cmd_thread)
+{
+    (void)cmd_thread;
+    return -1;
+}
+
+int32_t mm_camera_poll_thread_launch(mm_camera_poll_thread_t *poll_cb,
+        mm_camera_poll_thread_type_t poll_type,
+        mm_camera_poll_engine_t engine)
+{
+    (void)poll_cb;
+    (void)poll_type;
+    (void)engine;
+    return -1;
+}
+
+int32_t mm_camera_poll_thread_release(mm_camera_poll_thread_t *poll_cb)
+{
+    (void)poll_cb;
+    return -1;
+}
+
+int32_t mm_camera_start_zsl_snapshot(mm_camera_obj_t *my_obj)
+{
+    (void)my_obj;
+    return -1;
+}
+
+int32_t mm_camera_stop_zsl_snapshot(mm_camera_obj_t *my_obj)
+{
+    (void)my_obj;
+    return -1;
+}
+
+uint32_t mm_camera_util_generate_handler(uint8_t index)
+{
+    return index;
+}
+
+static uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* the linear queue walk mm_channel_superbuf_comp_and_enqueue used before
+ * the slot ring, without frame sync, which the fixtures do not enable */
+static int32_t test_linear_comp_and_enqueue(
+                        mm_channel_t* ch_obj,
+                        mm_channel_queue_t *queue,
+                        mm_camera_buf_info_t *buf_info)
+{
+    cam_node_t* node = NULL;
+    struct cam_list *head = NULL;
+    struct cam_list *pos = NULL;
+    mm_channel_queue_node_t* super_buf = NULL;
+    uint8_t buf_s_idx, i, found_super_buf, unmatched_bundles;
+    struct cam_list *last_buf, *insert_before_buf, *last_buf_ptr;
+
+    for (buf_s_idx = 0; buf_s_idx < queue->num_streams; buf_s_idx++) {
+        if (buf_info->stream_id == queue->bundled_streams[buf_s_idx]) {
+            break;
+        }
+    }
+
+    if (buf_s_idx == queue->num_streams) {
+        return -1;
+    }
+
+    if(buf_info->frame_idx == 0) {
+        mm_channel_qbuf(ch_obj, buf_info->buf);
+        return 0;
+    }
+
+    if (mm_channel_handle_metadata(ch_obj, queue, buf_info) < 0) {
+        mm_channel_qbuf(ch_obj, buf_info->buf);
+        return -1;
+    }
+
+    if (mm_channel_util_seq_comp_w_rollover(buf_info->frame_idx,
+                                            queue->expected_frame_id) < 0) {
+        mm_channel_qbuf(ch_obj, buf_info->buf);
+        return 0;
+    }
+
+    if((queue->nomatch_frame_id != 0)
+            && (queue->nomatch_frame_id > buf_info->frame_idx)
+            && (buf_info->buf->stream_type == CAM_STREAM_TYPE_METADATA)) {
+        /*Incoming metadata is older than expected*/
+        mm_channel_qbuf(ch_obj, buf_info->buf);
+        return 0;
+    }
+
+    /* comp */
+    pthread_mutex_lock(&queue->que.lock);
+    head = &queue->que.head.list;
+    /* get the last one in the queue which is possibly having no matching */
+    pos = head->next;
+
+    found_super_buf = 0;
+    unmatched_bundles = 0;
+    last_buf = NULL;
+    insert_before_buf = NULL;
+    last_buf_ptr = NULL;
+
+    while (pos != head) {
+        node = member_of(pos, cam_node_t, list);
+        super_buf = (mm_channel_queue_node_t*)node->data;
+
+        if (NULL != super_buf) {
+            if (super_buf->matched) {
+                /* find a matched super buf, move to next one */
+                pos = pos->next;
+                continue;
+            } else if ( buf_info->frame_idx == super_buf->frame_idx
+                    /*Pick metadata greater than available frameID*/
+                    || ((queue->nomatch_frame_id != 0)
+                    && (queue->nomatch_frame_id <= buf_info->frame_idx)
+                    && (super_buf->super_buf[buf_s_idx].frame_idx == 0)
+                    && (buf_info->buf->stream_type == CAM_STREAM_TYPE_METADATA))
+                    /*Pick available metadata closest to frameID*/
+                    || ((queue->attr.priority == MM_CAMERA_SUPER_BUF_PRIORITY_LOW)
+                    && (buf_info->buf->stream_type != CAM_STREAM_TYPE_METADATA)
+                    && (super_buf->super_buf[buf_s_idx].frame_idx == 0)
+                    && (super_buf->frame_idx > buf_info->frame_idx))){
+                found_super_buf = 1;
+                queue->nomatch_frame_id = 0;
+                break;
+            } else {
+                unmatched_bundles++;
+                if ( NULL == last_buf ) {
+                    if ( super_buf->frame_idx < buf_info->frame_idx ) {
+                        last_buf = pos;
+                    }
+                }
+                if ( NULL == insert_before_buf ) {
+                    if ( super_buf->frame_idx > buf_info->frame_idx ) {
+                        insert_before_buf = pos;
+                    }
+                }
+                pos = pos->next;
+            }
+        }
+    }
+
+    if ( found_super_buf ) {
+        if(super_buf->super_buf[buf_s_idx].frame_idx != 0) {
+            pthread_mutex_unlock(&queue->que.lock);
+            mm_channel_qbuf(ch_obj, buf_info->buf);
+            return 0;
+        }
+
+        /*Insert incoming buffer to super buffer*/
+        super_buf->super_buf[buf_s_idx] = *buf_info;
+
+        /* check if superbuf is all matched */
+        super_buf->matched = 1;
+        for (i=0; i < super_buf->num_of_bufs; i++) {
+            if (super_buf->super_buf[i].frame_idx == 0) {
+                super_buf->matched = 0;
+                break;
+            }
+        }
+
+        if (super_buf->matched) {
+            if(ch_obj->isFlashBracketingEnabled) {
+               queue->expected_frame_id =
+                   queue->expected_frame_id_without_led;
+               if (buf_info->frame_idx >=
+                       queue->expected_frame_id_without_led) {
+                   ch_obj->isFlashBracketingEnabled = FALSE;
+               }
+            } else {
+               queue->expected_frame_id = buf_info->frame_idx
+                                          + queue->attr.post_frame_skip;
+            }
+
+            super_buf->expected = FALSE;
+
+            queue->match_cnt++;
+            /* Any older unmatched buffer need to be released */
+            if ( last_buf ) {
+                while ( last_buf != pos ) {
+                    node = member_of(last_buf, cam_node_t, list);
+                    super_buf = (mm_channel_queue_node_t*)node->data;
+                    if (NULL != super_buf) {
+                        for (i=0; i<super_buf->num_of_bufs; i++) {
+                            if (super_buf->super_buf[i].frame_idx != 0) {
+                                mm_channel_qbuf(ch_obj, super_buf->super_buf[i].buf);
+                            }
+                        }
+                        queue->que.size--;
+                        last_buf = last_buf->next;
+                        cam_list_del_node(&node->list);
+                        free(node);
+                        free(super_buf);
+                    } else {
+                        break;
+                    }
+                }
+            }
+        }else {
+            if (ch_obj->diverted_frame_id == buf_info->frame_idx) {
+                super_buf->expected = TRUE;
+                ch_obj->diverted_frame_id = 0;
+            }
+        }
+    } else {
+        if ((queue->attr.max_unmatched_frames < unmatched_bundles)
+                && ( NULL == last_buf )) {
+            /* incoming frame is older than the last bundled one */
+            mm_channel_qbuf(ch_obj, buf_info->buf);
+        } else {
+            last_buf_ptr = last_buf;
+
+            /* Loop to remove unmatched frames */
+            while ((queue->attr.max_unmatched_frames < unmatched_bundles)
+                    && (last_buf_ptr != NULL && last_buf_ptr != pos)) {
+                node = member_of(last_buf_ptr, cam_node_t, list);
+                super_buf = (mm_channel_queue_node_t*)node->data;
+                /* step ahead before the node can be freed */
+                last_buf_ptr = last_buf_ptr->next;
+                if (NULL != super_buf && super_buf->expected == FALSE
+                        && (&node->list != insert_before_buf)) {
+                    for (i=0; i<super_buf->num_of_bufs; i++) {
+                        if (super_buf->super_buf[i].frame_idx != 0) {
+                            mm_channel_qbuf(ch_obj, super_buf->super_buf[i].buf);
+                        }
+                    }
+                    queue->que.size--;
+                    if (&node->list == last_buf) {
+                        last_buf = NULL;
+                    }
+                    cam_list_del_node(&node->list);
+                    free(node);
+                    free(super_buf);
+                    unmatched_bundles--;
+                }
+            }
+
+            if ((queue->attr.max_unmatched_frames < unmatched_bundles)
+                    && (NULL != last_buf)) {
+                node = member_of(last_buf, cam_node_t, list);
+                super_buf = (mm_channel_queue_node_t*)node->data;
+                for (i=0; i<super_buf->num_of_bufs; i++) {
+                    if (super_buf->super_buf[i].frame_idx != 0) {
+                        mm_channel_qbuf(ch_obj, super_buf->super_buf[i].buf);
+                    }
+                }
+                queue->que.size--;
+                cam_list_del_node(&node->list);
+                free(node);
+                free(super_buf);
+            }
+
+            /* insert the new frame at the appropriate position. */
+
+            mm_channel_queue_node_t *new_buf = NULL;
+            cam_node_t* new_node = NULL;
+
+            new_buf = (mm_channel_queue_node_t*)malloc(sizeof(mm_channel_queue_node_t));
+            new_node = (cam_node_t*)malloc(sizeof(cam_node_t));
+            if (NULL != new_buf && NULL != new_node) {
+                memset(new_buf, 0, sizeof(mm_channel_queue_node_t));
+                memset(new_node, 0, sizeof(cam_node_t));
+                new_node->data = (void *)new_buf;
+                new_buf->num_of_bufs = queue->num_streams;
+                new_buf->super_buf[buf_s_idx] = *buf_info;
+                new_buf->frame_idx = buf_info->frame_idx;
+
+                if (ch_obj->diverted_frame_id == buf_info->frame_idx) {
+                    new_buf->expected = TRUE;
+                    ch_obj->diverted_frame_id = 0;
+                }
+
+                /* enqueue */
+                if ( insert_before_buf ) {
+                    cam_list_insert_before_node(&new_node->list, insert_before_buf);
+                } else {
+                    cam_list_add_tail_node(&new_node->list, &queue->que.head.list);
+                }
+                queue->que.size++;
+
+                if(queue->num_streams == 1) {
+                    new_buf->matched = 1;
+                    new_buf->expected = FALSE;
+                    queue->expected_frame_id = buf_info->frame_idx + queue->attr.post_frame_skip;
+                    queue->match_cnt++;
+                }
+
+                if ((queue->attr.priority == MM_CAMERA_SUPER_BUF_PRIORITY_LOW)
+                        && (buf_info->buf->stream_type != CAM_STREAM_TYPE_METADATA)) {
+                    queue->nomatch_frame_id = buf_info->frame_idx;
+                }
+            } else {
+                /* No memory */
+                if (NULL != new_buf) {
+                    free(new_buf);
+                }
+                if (NULL != new_node) {
+                    free(new_node);
+                }
+                /* qbuf the new buf since we cannot enqueue */
+                mm_channel_qbuf(ch_obj, buf_info->buf);
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&queue->que.lock);
+    return 0;
+}
+
+/* every stream delivers each frame up to jitter frames late, so buffers of
+ * different streams reach the matcher out of order */
+static test_buf_t *test_gen_bufs(const test_cfg_t *cfg, uint32_t *num_bufs)
+{
+    uint32_t total = cfg->num_frames * cfg->num_streams;
+    test_buf_t *bufs = (test_buf_t *)calloc(total, sizeof(*bufs));
+    uint64_t *keys = (uint64_t *)calloc(total, sizeof(*keys));
+    uint32_t f, s, n = 0, i, j;
+
+    if ((NULL == bufs) || (NULL == keys)) {
+        free(bufs);
+        free(keys);
+        return NULL;
+    }
+
+    srand(1);
+    for (f = 1; f <= cfg->num_frames; f++) {
+        for (s = 0; s < cfg->num_streams; s++) {
+            if ((uint32_t)(rand() % 1000) < cfg->drop_permille) {
+                continue;
+            }
+            bufs[n].frame_idx = f;
+            bufs[n].stream = (uint8_t)s;
+            keys[n] = ((uint64_t)(f + (uint32_t)rand() % (cfg->jitter + 1)) << 32) | n;
+            n++;
+        }
+    }
+
+    /* order by arrival time, insertion sort keeps it dependency free */
+    for (i = 1; i < n; i++) {
+        uint64_t k = keys[i];
+        test_buf_t b = bufs[i];
+        for (j = i; (j > 0) && (keys[j - 1] > k); j--) {
+            keys[j] = keys[j - 1];
+            bufs[j] = bufs[j - 1];
+        }
+        keys[j] = k;
+        bufs[j] = b;
+    }
+
+    free(keys);
+    *num_bufs = n;
+    return bufs;
+}
+
+static cam_stream_type_t test_stream_type(const test_scenario_t *sc,
+        uint8_t stream)
+{
+    if (sc->has_metadata && (0 == stream)) {
+        return CAM_STREAM_TYPE_METADATA;
+    }
+    return (stream & 1) ? CAM_STREAM_TYPE_SNAPSHOT : CAM_STREAM_TYPE_PREVIEW;
+}
+
+static test_fixture_t *test_fixture_create(const test_cfg_t *cfg,
+        const test_scenario_t *sc, const test_buf_t *bufs, uint32_t num_bufs,
+        uint8_t use_ref)
+{
+    test_fixture_t *f = (test_fixture_t *)calloc(1, sizeof(*f));
+    mm_channel_queue_t *queue;
+    uint32_t i;
+    uint8_t s;
+
+    if (NULL == f) {
+        return NULL;
+    }
+    f->bufs = (mm_camera_buf_def_t *)calloc(num_bufs, sizeof(*f->bufs));
+    f->qbuf_cnt = (uint8_t *)calloc(num_bufs, sizeof(*f->qbuf_cnt));
+    if ((NULL == f->bufs) || (NULL == f->qbuf_cnt)) {
+        free(f->bufs);
+        free(f->qbuf_cnt);
+        free(f);
+        return NULL;
+    }
+    f->num_bufs = num_bufs;
+    f->use_ref = use_ref;
+
+    queue = &f->ch.bundle.superbuf_queue;
+    mm_channel_superbuf_queue_init(queue);
+    queue->num_streams = cfg->num_streams;
+    queue->attr.notify_mode = MM_CAMERA_SUPER_BUF_NOTIFY_BURST;
+    queue->attr.water_mark = (uint8_t)cfg->zsl_depth;
+    queue->attr.max_unmatched_frames = MAX_UNMATCHED;
+    queue->attr.priority = sc->priority;
+
+    for (s = 0; s < cfg->num_streams; s++) {
+        f->info[s].stream_type = test_stream_type(sc, s);
+        f->ch.streams[s].state = MM_STREAM_STATE_ACTIVE;
+        f->ch.streams[s].my_hdl = (uint32_t)(s + 1);
+        f->ch.streams[s].ch_obj = &f->ch;
+        f->ch.streams[s].stream_info = &f->info[s];
+        queue->bundled_streams[s] = f->ch.streams[s].my_hdl;
+    }
+
+    for (i = 0; i < num_bufs; i++) {
+        f->bufs[i].stream_id = (uint32_t)(bufs[i].stream + 1);
+        f->bufs[i].stream_type = f->info[bufs[i].stream].stream_type;
+        f->bufs[i].buf_idx = i;
+        f->bufs[i].frame_idx = bufs[i].frame_idx;
+        if (CAM_STREAM_TYPE_METADATA == f->bufs[i].stream_type) {
+            f->bufs[i].buffer = test_metadata;
+        }
+    }
+
+    return f;
+}
+
+static void test_fixture_destroy(test_fixture_t *f)
+{
+    mm_channel_superbuf_queue_deinit(&f->ch.bundle.superbuf_queue);
+    free(f->bufs);
+    free(f->qbuf_cnt);
+    free(f);
+}
+
+/* hand one buffer to the matcher, then let the consumer keep water_mark
+ * matched superbufs queued, like a ZSL look back, which is what makes
+ * the linear walk long */
+static void test_feed(test_fixture_t *f, uint32_t i)
+{
+    mm_channel_queue_t *queue = &f->ch.bundle.superbuf_queue;
+    mm_channel_queue_node_t *super_buf;
+    mm_camera_buf_info_t buf_info;
+    uint64_t t;
+    uint8_t s;
+
+    memset(&buf_info, 0, sizeof(buf_info));
+    buf_info.stream_id = f->bufs[i].stream_id;
+    buf_info.frame_idx = f->bufs[i].frame_idx;
+    buf_info.buf = &f->bufs[i];
+
+    t = test_now_ns();
+    if (f->use_ref) {
+        test_linear_comp_and_enqueue(&f->ch, queue, &buf_info);
+    } else {
+        mm_channel_superbuf_comp_and_enqueue(&f->ch, queue, &buf_info);
+    }
+    f->ns += test_now_ns() - t;
+
+    while (queue->match_cnt > queue->attr.water_mark) {
+        super_buf = mm_channel_superbuf_dequeue(queue, &f->ch);
+        if (NULL == super_buf) {
+            break;
+        }
+        for (s = 0; s < super_buf->num_of_bufs; s++) {
+            if (NULL != super_buf->super_buf[s].buf) {
+                mm_channel_qbuf(&f->ch, super_buf->super_buf[s].buf);
+            }
+        }
+        f->delivered++;
+        free(super_buf);
+    }
+}
+
+/* every slot must point at a queued superbuf of its own frame_idx */
+static int test_check_slots(test_fixture_t *f)
+{
+    mm_channel_queue_t *queue = &f->ch.bundle.superbuf_queue;
+    struct cam_list *head = &queue->que.head.list;
+    struct cam_list *pos;
+    mm_channel_queue_node_t *super_buf;
+    uint8_t seen[MM_CHANNEL_SUPERBUF_SLOTS];
+    uint32_t slot;
+    uint8_t s;
+
+    memset(seen, 0, sizeof(seen));
+    for (pos = head->next; pos != head; pos = pos->next) {
+        super_buf = (mm_channel_queue_node_t *)
+                member_of(pos, cam_node_t, list)->data;
+        slot = mm_channel_superbuf_slot_of(super_buf->frame_idx);
+        if (pos == queue->slots.pos[slot]) {
+            if (queue->slots.frame_idx[slot] != super_buf->frame_idx) {
+                return -1;
+            }
+            seen[slot] = 1;
+        }
+        for (s = 0; s < super_buf->num_of_bufs; s++) {
+            if (!(super_buf->filled_mask & (1U << s)) !=
+                    (0 == super_buf->super_buf[s].frame_idx)) {
+                return -1;
+            }
+        }
+    }
+    for (slot = 0; slot < MM_CHANNEL_SUPERBUF_SLOTS; slot++) {
+        if ((NULL != queue->slots.pos[slot]) && !seen[slot]) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int test_compare(test_fixture_t *a, test_fixture_t *b)
+{
+    mm_channel_queue_t *qa = &a->ch.bundle.superbuf_queue;
+    mm_channel_queue_t *qb = &b->ch.bundle.superbuf_queue;
+    struct cam_list *pa = qa->que.head.list.next;
+    struct cam_list *pb = qb->que.head.list.next;
+    mm_channel_queue_node_t *sa, *sb;
+    uint8_t s;
+
+    if ((qa->que.size != qb->que.size) || (qa->match_cnt != qb->match_cnt) ||
+            (qa->expected_frame_id != qb->expected_frame_id) ||
+            (qa->nomatch_frame_id != qb->nomatch_frame_id) ||
+            (a->delivered != b->delivered) ||
+            memcmp(a->qbuf_cnt, b->qbuf_cnt, a->num_bufs)) {
+        return -1;
+    }
+
+    while ((pa != &qa->que.head.list) && (pb != &qb->que.head.list)) {
+        sa = (mm_channel_queue_node_t *)member_of(pa, cam_node_t, list)->data;
+        sb = (mm_channel_queue_node_t *)member_of(pb, cam_node_t, list)->data;
+        if ((sa->frame_idx != sb->frame_idx) ||
+                (sa->matched != sb->matched) ||
+                (sa->expected != sb->expected)) {
+            return -1;
+        }
+        for (s = 0; s < sa->num_of_bufs; s++) {
+            if ((sa->super_buf[s].frame_idx != sb->super_buf[s].frame_idx) ||
+                    ((NULL == sa->super_buf[s].buf) !=
+                     (NULL == sb->super_buf[s].buf)) ||
+                    ((NULL != sa->super_buf[s].buf) &&
+                     (sa->super_buf[s].buf->buf_idx !=
+                      sb->super_buf[s].buf->buf_idx))) {
+                return -1;
+            }
+        }
+        pa = pa->next;
+        pb = pb->next;
+    }
+    return ((pa == &qa->que.head.list) && (pb == &qb->que.head.list)) ? 0 : -1;
+}
+
+static int test_run(const test_cfg_t *cfg, const test_scenario_t *sc,
+        const test_buf_t *bufs, uint32_t num_bufs)
+{
+    test_fixture_t *slots = test_fixture_create(cfg, sc, bufs, num_bufs, 0);
+    test_fixture_t *linear = test_fixture_create(cfg, sc, bufs, num_bufs, 1);
+    uint32_t i;
+    int rc = 0;
+
+    if ((NULL == slots) || (NULL == linear)) {
+        printf("%s: no memory\n", sc->name);
+        rc = -1;
+        goto end;
+    }
+
+    for (i = 0; i < num_bufs; i++) {
+        test_feed(slots, i);
+        test_feed(linear, i);
+        if (test_check_slots(slots) < 0) {
+            printf("%s: FAIL: slot ring inconsistent after buffer %u\n",
+                    sc->name, i);
+            rc = -1;
+            goto end;
+        }
+        if (test_compare(slots, linear) < 0) {
+            printf("%s: FAIL: matching differs from the linear walk after "
+                    "buffer %u (frame %u stream %u)\n", sc->name, i,
+                    bufs[i].frame_idx, bufs[i].stream);
+            rc = -1;
+            goto end;
+        }
+    }
+
+    printf("%-13s: %u superbufs delivered, queue %u, per buffer avg "
+            "slots %llu ns, linear %llu ns\n", sc->name, slots->delivered,
+            slots->ch.bundle.superbuf_queue.que.size,
+            (unsigned long long)(slots->ns / num_bufs),
+            (unsigned long long)(linear->ns / num_bufs));
+
+    /* every buffer goes back to its stream exactly once */
+    mm_channel_superbuf_flush(&slots->ch, &slots->ch.bundle.superbuf_queue,
+            CAM_STREAM_TYPE_DEFAULT);
+    if (test_check_slots(slots) < 0) {
+        printf("%s: FAIL: slot ring not empty after flush\n", sc->name);
+        rc = -1;
+        goto end;
+    }
+    for (i = 0; i < num_bufs; i++) {
+        if (1 != slots->qbuf_cnt[i]) {
+            printf("%s: FAIL: buffer %u returned %u times\n", sc->name, i,
+                    slots->qbuf_cnt[i]);
+            rc = -1;
+            goto end;
+        }
+    }
+
+end:
+    if (NULL != linear) {
+        mm_channel_superbuf_flush(&linear->ch,
+                &linear->ch.bundle.superbuf_queue, CAM_STREAM_TYPE_DEFAULT);
+        test_fixture_destroy(linear);
+    }
+    if (NULL != slots) {
+        test_fixture_destroy(slots);
+    }
+    return rc;
+}
+
+int main(int argc, char **argv)
+{
+    static const test_scenario_t scenarios[] = {
+        { "exact", 0, MM_CAMERA_SUPER_BUF_PRIORITY_NORMAL },
+        { "metadata", 1, MM_CAMERA_SUPER_BUF_PRIORITY_NORMAL },
+        { "metadata low", 1, MM_CAMERA_SUPER_BUF_PRIORITY_LOW },
+    };
+    test_cfg_t cfg;
+    test_buf_t *bufs;
+    uint32_t num_bufs = 0;
+    size_t i;
+    int rc = 0;
+
+    cfg.num_streams = (argc > 1) ? (uint8_t)atoi(argv[1]) : 6;
+    cfg.num_frames = (argc > 2) ? (uint32_t)atoi(argv[2]) : 4000;
+    cfg.jitter = (argc > 3) ? (uint32_t)atoi(argv[3]) : 8;
+    cfg.zsl_depth = (argc > 4) ? (uint32_t)atoi(argv[4]) : 32;
+    cfg.drop_permille = (argc > 5) ? (uint32_t)atoi(argv[5]) : 20;
+
+    if ((cfg.num_streams == 0) || (cfg.num_streams > MAX_STREAMS) ||
+            (cfg.num_frames == 0) || (cfg.zsl_depth > UINT8_MAX)) {
+        printf("usage: %s [streams 1-%d] [frames] [jitter] [zsl depth 0-%d] "
+                "[drop permille]\n", argv[0], MAX_STREAMS, UINT8_MAX);
+        return -1;
+    }
+
+    test_metadata = (metadata_buffer_t *)calloc(1, sizeof(*test_metadata));
+    bufs = test_gen_bufs(&cfg, &num_bufs);
+    if ((NULL == test_metadata) || (NULL == bufs) || (num_bufs == 0)) {
+        printf("no buffers generated\n");
+        free(test_metadata);
+        free(bufs);
+        return -1;
+    }
+
+    printf("%u streams, %u frames, %u buffers, jitter %u, zsl depth %u, "
+            "drop %u/1000\n", cfg.num_streams, cfg.num_frames, num_bufs,
+            cfg.jitter, cfg.zsl_depth, cfg.drop_permille);
+
+    for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        if (test_run(&cfg, &scenarios[i], bufs, num_bufs) < 0) {
+            rc = -1;
+        }
+    }
+    printf("%s\n", rc ? "FAIL" : "PASS");
+
+    free(test_metadata);
+    free(bufs);
+    return rc;
+}
@@ -44,6 +44,7 @@
 #define MM_JPEG_CIRQ_SIZE 30
 #define MM_JPEG_MAX_SESSION 10
 #define MAX_EXIF_TABLE_ENTRIES 50
+#define MM_JPEG_EXIF_ARENA_SIZE 4096
 #define MAX_JPEG_SIZE 20000000
 #define MAX_OMX_HANDLES (5)
 
@@ -62,9 +63,14 @@ typedef enum {
 } mm_jpeg_abort_state_t;
 
 
-/* define max num of supported concurrent jpeg jobs by OMX engine.
- * Current, only one per time */
-#define NUM_MAX_JPEG_CNCURRENT_JOBS 2
+/* max number of job manager worker threads. The number of workers and
+ * of jobs in flight default to MM_JPEG_CONCURRENT_SESSIONS_COUNT and can be
+ * raised with persist.camera.jpeg.workers / persist.camera.jpeg.max.jobs */
+#define MM_JPEG_MAX_WORKERS 4
+
+/* encode jobs producing at most this many pixels are scheduled in the
+ * high priority lane (thumbnails, preview sized snapshots) */
+#define MM_JPEG_LANE_HIGH_MAX_PIXELS (1920 * 1080)
 
 #define JOB_ID_MAGICVAL 0x1
 #define JOB_HIST_MAX 10000
@@ -257,6 +263,62 @@ typedef struct {
   pthread_mutex_t lock;
 } mm_jpeg_queue_t;
 
+/** mm_jpeg_lane_t:
+ *  @MM_JPEG_LANE_HIGH: thumbnail and preview sized jobs
+ *  @MM_JPEG_LANE_NORMAL: full size jobs
+ *
+ *  Scheduling lane of a job. Workers always serve the high
+ *  lane first; jobs of one session start in order within a lane.
+ **/
+typedef enum {
+  MM_JPEG_LANE_HIGH,
+  MM_JPEG_LANE_NORMAL,
+  MM_JPEG_LANE_MAX
+} mm_jpeg_lane_t;
+
+/** mm_jpeg_job_stats_t:
+ *  @jobs: number of completed jobs
+ *  @lane_jobs: completed jobs per lane
+ *  @wait_total_us: total time jobs spent in the todo queue
+ *  @wait_max_us: max time a job spent in the todo queue
+ *  @encode_total_us: total time from job start to job done
+ *  @encode_max_us: max time from job start to job done
+ *
+ *  Per session scheduling statistics
+ **/
+typedef struct {
+  uint32_t jobs;
+  uint32_t lane_jobs[MM_JPEG_LANE_MAX];
+  uint64_t wait_total_us;
+  uint64_t wait_max_us;
+  uint64_t encode_total_us;
+  uint64_t encode_max_us;
+} mm_jpeg_job_stats_t;
+
+/** mm_jpeg_exif_arena_t:
+ *  @base: arena memory
+ *  @size: arena size
+ *  @used: bytes handed out to the current job
+ *  @overflow: bytes of the current job that came from the heap
+ *  @num_jobs: number of exif tables built
+ *  @num_heap_allocs: heap allocations, arena growth included
+ *  @build_us: total time spent building exif tables
+ *
+ *  Bump allocator for the exif tag payloads of a session. It is
+ *  rewound at the start of every job and grows to the high water
+ *  mark, so building the exif table does not touch the heap once
+ *  the session is warmed up
+ **/
+typedef struct {
+  uint8_t *base;
+  size_t size;
+  size_t used;
+  size_t overflow;
+  uint32_t num_jobs;
+  uint32_t num_heap_allocs;
+  uint64_t build_us;
+} mm_jpeg_exif_arena_t;
+
 typedef enum {
   MM_JPEG_CMD_TYPE_JOB,          /* job cmd */
   MM_JPEG_CMD_TYPE_EXIT,         /* EXIT cmd for exiting jobMgr thread */
@@ -300,6 +362,7 @@ typedef struct mm_jpeg_job_session {
 
   QEXIF_INFO_DATA exif_info_local[MAX_EXIF_TABLE_ENTRIES];  //all exif tags for JPEG encoder
   int exif_count_local;
+  mm_jpeg_exif_arena_t exif_arena;  /* backing store of exif_info_local */
 
   mm_jpeg_cirq_t cb_q;
   int32_t ebd_count;
@@ -336,6 +399,11 @@ typedef struct mm_jpeg_job_session {
 
   int thumb_from_main;
   uint32_t job_index;
+
+  /* scheduling statistics, aggregated over next_session on destroy */
+  mm_jpeg_job_stats_t stats;
+  uint64_t job_start_us;
+  mm_jpeg_lane_t job_lane;
 } mm_jpeg_job_session_t;
 
 typedef struct {
@@ -352,6 +420,8 @@ typedef struct {
 
 typedef struct {
   mm_jpeg_cmd_type_t type;
+  mm_jpeg_lane_t lane;           /* scheduling lane */
+  uint64_t enq_us;               /* time the job was queued */
   union {
     mm_jpeg_encode_job_info_t enc_info;
     mm_jpeg_decode_job_info_t dec_info;
@@ -365,8 +435,23 @@ typedef struct {
   pthread_mutex_t lock;           /* job lock */
 } mm_jpeg_client_t;
 
+/** mm_jpeg_job_setup_t:
+ *  @session_id: session of the job, 0 if the worker is idle
+ *  @job_id: job being set up
+ *
+ *  Job a worker is setting up outside of the job lock
+ **/
+typedef struct {
+  uint32_t session_id;
+  uint32_t job_id;
+} mm_jpeg_job_setup_t;
+
 typedef struct {
-  pthread_t pid;                  /* job cmd thread ID */
+  pthread_t pid[MM_JPEG_MAX_WORKERS]; /* worker thread IDs */
+  uint32_t num_workers;           /* number of worker threads */
+  uint32_t max_jobs;              /* max number of jobs in flight */
+  mm_jpeg_job_setup_t setup[MM_JPEG_MAX_WORKERS]; /* jobs being set up */
+  pthread_cond_t setup_cond;      /* signalled when a job setup completes */
   cam_semaphore_t job_sem;        /* semaphore for job cmd thread */
   mm_jpeg_queue_t job_queue;      /* queue for job to do */
 } mm_jpeg_job_cmd_thread_t;
@@ -421,11 +506,17 @@ extern int32_t mm_jpeg_create_session(mm_jpeg_obj *my_obj,
   uint32_t* p_session_id);
 extern int32_t mm_jpeg_destroy_session_by_id(mm_jpeg_obj *my_obj,
   uint32_t session_id);
+extern int32_t mm_jpeg_get_session_stats(mm_jpeg_obj *my_obj,
+  uint32_t session_id,
+  mm_jpeg_session_stats_t *p_stats);
 
 extern int32_t mm_jpegdec_init(mm_jpeg_obj *my_obj);
 extern int32_t mm_jpegdec_deinit(mm_jpeg_obj *my_obj);
 extern int32_t mm_jpeg_jobmgr_thread_release(mm_jpeg_obj * my_obj);
 extern int32_t mm_jpeg_jobmgr_thread_launch(mm_jpeg_obj *my_obj);
+extern void mm_jpeg_jobmgr_wait_setup(mm_jpeg_obj *my_obj,
+  uint32_t session_id,
+  uint32_t job_id);
 extern int32_t mm_jpegdec_start_decode_job(mm_jpeg_obj *my_obj,
   mm_jpeg_job_t* job,
   uint32_t* jobId);
@@ -460,12 +551,16 @@ extern int32_t mm_jpeg_queue_deinit(mm_jpeg_queue_t* queue);
 extern int32_t mm_jpeg_queue_flush(mm_jpeg_queue_t* queue);
 extern uint32_t mm_jpeg_queue_get_size(mm_jpeg_queue_t* queue);
 extern mm_jpeg_q_data_t mm_jpeg_queue_peek(mm_jpeg_queue_t* queue);
-extern int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
+extern int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info,
+  mm_jpeg_exif_arena_t *p_arena, exif_tag_id_t tagid,
   exif_tag_type_t type, uint32_t count, void *data);
-extern int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data);
+extern int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data,
+  mm_jpeg_exif_arena_t *p_arena);
+extern int32_t mm_jpeg_exif_arena_rewind(mm_jpeg_exif_arena_t *p_arena);
+extern void mm_jpeg_exif_arena_release(mm_jpeg_exif_arena_t *p_arena);
 extern int process_meta_data(metadata_buffer_t *p_meta,
-  QOMX_EXIF_INFO *exif_info, mm_jpeg_exif_params_t *p_cam3a_params,
-  cam_hal_version_t hal_version);
+  QOMX_EXIF_INFO *exif_info, mm_jpeg_exif_arena_t *p_arena,
+  mm_jpeg_exif_params_t *p_cam3a_params, cam_hal_version_t hal_version);
 
 OMX_ERRORTYPE mm_jpeg_session_change_state(mm_jpeg_job_session_t* p_session,
   OMX_STATETYPE new_state,
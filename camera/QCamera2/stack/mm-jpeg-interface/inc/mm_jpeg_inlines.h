@@ -30,8 +30,28 @@
 #ifndef MM_JPEG_INLINES_H_
 #define MM_JPEG_INLINES_H_
 
+#include <time.h>
 #include "mm_jpeg.h"
 
+/** mm_jpeg_get_time_us:
+ *
+ *  Arguments:
+ *    none
+ *
+ *  Return:
+ *       monotonic time in microseconds
+ *
+ *  Description:
+ *       Get the timestamp used for the job statistics
+ *
+ **/
+static inline uint64_t mm_jpeg_get_time_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
 /** mm_jpeg_get_session:
  *
  *  Arguments:
@@ -35,6 +35,7 @@
 #include <sys/prctl.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <cutils/properties.h>
 
 #include "mm_jpeg_dbg.h"
 #include "mm_jpeg_interface.h"
@@ -376,6 +377,8 @@ void mm_jpeg_session_destroy(mm_jpeg_job_session_t* p_session)
     p_session->meta_enc_key = NULL;
   }
 
+  mm_jpeg_exif_arena_release(&p_session->exif_arena);
+
   my_obj->num_sessions--;
 
   // Destroy next session
@@ -1228,6 +1231,8 @@ OMX_ERRORTYPE mm_jpeg_session_config_common(mm_jpeg_job_session_t *p_session)
   OMX_CONFIG_ROTATIONTYPE rotate;
   mm_jpeg_encode_job_t *p_jobparams = &p_session->encode_job;
   QOMX_EXIF_INFO exif_info;
+  mm_jpeg_exif_arena_t *p_arena = &p_session->exif_arena;
+  uint64_t build_start_us;
 
   /* set rotation */
   memset(&rotate, 0, sizeof(rotate));
@@ -1262,12 +1267,16 @@ OMX_ERRORTYPE mm_jpeg_session_config_common(mm_jpeg_job_session_t *p_session)
     }
   }
   /*parse aditional exif data from the metadata*/
+  build_start_us = mm_jpeg_get_time_us();
+  mm_jpeg_exif_arena_rewind(p_arena);
   exif_info.numOfEntries = 0;
   exif_info.exif_data = &p_session->exif_info_local[0];
-  process_meta_data(p_jobparams->p_metadata, &exif_info,
+  process_meta_data(p_jobparams->p_metadata, &exif_info, p_arena,
     &p_jobparams->cam_exif_params, p_jobparams->hal_version);
   /* After Parse metadata */
   p_session->exif_count_local = (int)exif_info.numOfEntries;
+  p_arena->num_jobs++;
+  p_arena->build_us += mm_jpeg_get_time_us() - build_start_us;
 
   if (exif_info.numOfEntries > 0) {
     /* set exif tags */
@@ -1669,7 +1678,9 @@ error:
  *       0 for success -1 otherwise
  *
  *  Description:
- *       Start the encoding job
+ *       Start the encoding job. Called with the job lock held, the
+ *       lock is dropped while the session is configured and the job
+ *       is handed to OMX so other workers can start their jobs
  *
  **/
 int32_t mm_jpeg_process_encoding_job(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_t* job_node)
@@ -1679,6 +1690,7 @@ int32_t mm_jpeg_process_encoding_job(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_t*
   OMX_ERRORTYPE ret = OMX_ErrorNone;
   mm_jpeg_job_session_t *p_session = NULL;
   uint32_t buf_idx;
+  uint64_t wait_us;
 
   /* check if valid session */
   p_session = mm_jpeg_get_session(my_obj, job_node->enc_info.job_id);
@@ -1737,7 +1749,18 @@ int32_t mm_jpeg_process_encoding_job(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_t*
 
   p_session->encode_job = job_node->enc_info.encode_job;
   p_session->jobId = job_node->enc_info.job_id;
+  p_session->job_lane = job_node->lane;
+  p_session->job_start_us = mm_jpeg_get_time_us();
+  wait_us = p_session->job_start_us - job_node->enq_us;
+  p_session->stats.wait_total_us += wait_us;
+  if (wait_us > p_session->stats.wait_max_us) {
+    p_session->stats.wait_max_us = wait_us;
+  }
+
+  /* job_node belongs to the ongoing queue from here on */
+  pthread_mutex_unlock(&my_obj->job_lock);
   ret = mm_jpeg_session_encode(p_session);
+  pthread_mutex_lock(&my_obj->job_lock);
   if (ret) {
     CDBG_ERROR("%s:%d] encode session failed", __func__, __LINE__);
     goto error;
@@ -1769,6 +1792,207 @@ error:
 
 
 
+/** mm_jpeg_get_job_session_id:
+ *
+ *  Arguments:
+ *    @job_node: job node
+ *
+ *  Return:
+ *       session id of the job
+ *
+ *  Description:
+ *       Get the session id of an encode or decode job
+ *
+ **/
+static uint32_t mm_jpeg_get_job_session_id(mm_jpeg_job_q_node_t *job_node)
+{
+  if (MM_JPEG_CMD_TYPE_DECODE_JOB == job_node->type) {
+    return job_node->dec_info.decode_job.session_id;
+  }
+  return job_node->enc_info.encode_job.session_id;
+}
+
+/** mm_jpeg_jobmgr_job_ready:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @job_node: job node
+ *
+ *  Return:
+ *       1 if the job can be started, 0 otherwise
+ *
+ *  Description:
+ *       Checks that no other worker is setting up a job of the same
+ *       session and that the session has a free OMX handle and, if
+ *       needed, a free output buffer. Must be called with the job
+ *       lock held
+ *
+ **/
+static int mm_jpeg_jobmgr_job_ready(mm_jpeg_obj *my_obj,
+  mm_jpeg_job_q_node_t *job_node)
+{
+  mm_jpeg_job_cmd_thread_t *cmd_thread = &my_obj->job_mgr;
+  mm_jpeg_job_session_t *p_session = NULL;
+  uint32_t session_id = mm_jpeg_get_job_session_id(job_node);
+  uint32_t i;
+
+  for (i = 0; i < MM_JPEG_MAX_WORKERS; i++) {
+    if (cmd_thread->setup[i].session_id == session_id) {
+      return 0;
+    }
+  }
+
+  if (MM_JPEG_CMD_TYPE_JOB != job_node->type) {
+    return 1;
+  }
+
+  p_session = mm_jpeg_get_session(my_obj, job_node->enc_info.job_id);
+  if (NULL == p_session) {
+    /* let the worker report the invalid job */
+    return 1;
+  }
+  if (p_session->session_handle_q &&
+    (0 == mm_jpeg_queue_get_size(p_session->session_handle_q))) {
+    return 0;
+  }
+  if ((job_node->enc_info.encode_job.dst_index < 0) &&
+    p_session->out_buf_q &&
+    (0 == mm_jpeg_queue_get_size(p_session->out_buf_q))) {
+    return 0;
+  }
+  return 1;
+}
+
+/** mm_jpeg_jobmgr_pick_job:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *
+ *  Return:
+ *       job node to run, NULL if no job can be started
+ *
+ *  Description:
+ *       Removes the next job to run from the todo queue. The high
+ *       lane is served first. Within a lane only the oldest job of
+ *       each session is a candidate, so jobs of a session start in
+ *       the order they were queued. Must be called with the job
+ *       lock held
+ *
+ **/
+static mm_jpeg_job_q_node_t *mm_jpeg_jobmgr_pick_job(mm_jpeg_obj *my_obj)
+{
+  mm_jpeg_job_cmd_thread_t *cmd_thread = &my_obj->job_mgr;
+  mm_jpeg_queue_t *queue = &cmd_thread->job_queue;
+  mm_jpeg_q_node_t *node = NULL;
+  mm_jpeg_job_q_node_t *data = NULL;
+  mm_jpeg_job_q_node_t *job_node = NULL;
+  struct cam_list *head = NULL;
+  struct cam_list *pos = NULL;
+  uint8_t blocked[MAX_JPEG_CLIENT_NUM][MM_JPEG_MAX_SESSION];
+  uint32_t session_id;
+  uint32_t client_idx, session_idx;
+  uint32_t num_ongoing_jobs;
+  int lane;
+  int jobs_full;
+
+  num_ongoing_jobs = mm_jpeg_queue_get_size(&my_obj->ongoing_job_q);
+  jobs_full = (num_ongoing_jobs >= cmd_thread->max_jobs);
+  CDBG("%s:%d] ongoing job %d %d", __func__, __LINE__,
+    num_ongoing_jobs, cmd_thread->max_jobs);
+
+  pthread_mutex_lock(&queue->lock);
+  head = &queue->head.list;
+  for (lane = 0; (lane < MM_JPEG_LANE_MAX) && !job_node; lane++) {
+    memset(blocked, 0, sizeof(blocked));
+    for (pos = head->next; pos != head; pos = pos->next) {
+      node = member_of(pos, mm_jpeg_q_node_t, list);
+      data = (mm_jpeg_job_q_node_t *)node->data.p;
+      if (NULL == data) {
+        continue;
+      }
+      if ((MM_JPEG_CMD_TYPE_JOB != data->type) &&
+        (MM_JPEG_CMD_TYPE_DECODE_JOB != data->type)) {
+        /* exit command */
+        job_node = data;
+        break;
+      }
+      if (((int)data->lane != lane) || jobs_full) {
+        continue;
+      }
+
+      session_id = mm_jpeg_get_job_session_id(data);
+      client_idx = GET_CLIENT_IDX(session_id);
+      session_idx = GET_SESSION_IDX(session_id);
+      if ((client_idx < MAX_JPEG_CLIENT_NUM) &&
+        (session_idx < MM_JPEG_MAX_SESSION)) {
+        if (blocked[client_idx][session_idx]) {
+          continue;
+        }
+        if (!mm_jpeg_jobmgr_job_ready(my_obj, data)) {
+          blocked[client_idx][session_idx] = 1;
+          continue;
+        }
+      }
+      job_node = data;
+      break;
+    }
+  }
+
+  if (job_node) {
+    cam_list_del_node(&node->list);
+    queue->size--;
+    free(node);
+  }
+  pthread_mutex_unlock(&queue->lock);
+
+  if (jobs_full && !job_node) {
+    CDBG_HIGH("%s:%d] ongoing job already reach max %d", __func__,
+      __LINE__, num_ongoing_jobs);
+  }
+  return job_node;
+}
+
+/** mm_jpeg_jobmgr_wait_setup:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @session_id: session to wait for, 0 for any
+ *    @job_id: job to wait for, 0 for any
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Waits until no worker is setting up a matching job, so that
+ *       the job can be found in the ongoing queue. Must be called
+ *       with the job lock held
+ *
+ **/
+void mm_jpeg_jobmgr_wait_setup(mm_jpeg_obj *my_obj,
+  uint32_t session_id,
+  uint32_t job_id)
+{
+  mm_jpeg_job_cmd_thread_t *cmd_thread = &my_obj->job_mgr;
+  mm_jpeg_job_setup_t *p_setup;
+  uint32_t i;
+  int busy;
+
+  do {
+    busy = 0;
+    for (i = 0; i < MM_JPEG_MAX_WORKERS; i++) {
+      p_setup = &cmd_thread->setup[i];
+      if ((0 == p_setup->session_id) ||
+        (session_id && (p_setup->session_id != session_id)) ||
+        (job_id && (p_setup->job_id != job_id))) {
+        continue;
+      }
+      busy = 1;
+      pthread_cond_wait(&cmd_thread->setup_cond, &my_obj->job_lock);
+      break;
+    }
+  } while (busy);
+}
+
 /** mm_jpeg_jobmgr_thread:
  *
  *  Arguments:
@@ -1778,18 +2002,18 @@ error:
  *       0 for success else failure
  *
  *  Description:
- *       job manager thread main function
+ *       job manager worker thread main function
  *
  **/
 static void *mm_jpeg_jobmgr_thread(void *data)
 {
-  mm_jpeg_q_data_t qdata;
   int rc = 0;
   int running = 1;
-  uint32_t num_ongoing_jobs = 0;
+  uint32_t i;
   mm_jpeg_obj *my_obj = (mm_jpeg_obj*)data;
   mm_jpeg_job_cmd_thread_t *cmd_thread = &my_obj->job_mgr;
   mm_jpeg_job_q_node_t* node = NULL;
+  mm_jpeg_job_setup_t *p_setup = NULL;
   prctl(PR_SET_NAME, (unsigned long)"mm_jpeg_thread", 0, 0, 0);
 
   do {
@@ -1802,25 +2026,30 @@ static void *mm_jpeg_jobmgr_thread(void *data)
       }
     } while (rc != 0);
 
-    /* check ongoing q size */
-    num_ongoing_jobs = mm_jpeg_queue_get_size(&my_obj->ongoing_job_q);
-
-    CDBG("%s:%d] ongoing job  %d %d", __func__,
-      __LINE__, num_ongoing_jobs, MM_JPEG_CONCURRENT_SESSIONS_COUNT);
-    if (num_ongoing_jobs >= MM_JPEG_CONCURRENT_SESSIONS_COUNT) {
-      CDBG_ERROR("%s:%d] ongoing job already reach max %d", __func__,
-        __LINE__, num_ongoing_jobs);
-      continue;
-    }
-
     pthread_mutex_lock(&my_obj->job_lock);
     /* can go ahead with new work */
-    qdata = mm_jpeg_queue_deq(&cmd_thread->job_queue);
-    node = (mm_jpeg_job_q_node_t*)qdata.p;
+    node = mm_jpeg_jobmgr_pick_job(my_obj);
     if (node != NULL) {
       switch (node->type) {
       case MM_JPEG_CMD_TYPE_JOB:
+        /* claim a setup slot, there is one per worker */
+        for (i = 0; i < MM_JPEG_MAX_WORKERS; i++) {
+          if (0 == cmd_thread->setup[i].session_id) {
+            p_setup = &cmd_thread->setup[i];
+            break;
+          }
+        }
+        p_setup->session_id = node->enc_info.encode_job.session_id;
+        p_setup->job_id = node->enc_info.job_id;
+
         rc = mm_jpeg_process_encoding_job(my_obj, node);
+
+        memset(p_setup, 0, sizeof(*p_setup));
+        pthread_cond_broadcast(&cmd_thread->setup_cond);
+        /* jobs of this session may have been skipped meanwhile */
+        if (mm_jpeg_queue_get_size(&cmd_thread->job_queue)) {
+          cam_sem_post(&cmd_thread->job_sem);
+        }
         break;
       case MM_JPEG_CMD_TYPE_DECODE_JOB:
         rc = mm_jpegdec_process_decoding_job(my_obj, node);
@@ -1849,23 +2078,59 @@ static void *mm_jpeg_jobmgr_thread(void *data)
  *       0 for success else failure
  *
  *  Description:
- *       launches the job manager thread
+ *       launches the job manager worker threads
  *
  **/
 int32_t mm_jpeg_jobmgr_thread_launch(mm_jpeg_obj *my_obj)
 {
   int32_t rc = 0;
+  int val;
+  uint32_t i;
+  char prop[PROPERTY_VALUE_MAX];
+  char name[16];
   mm_jpeg_job_cmd_thread_t *job_mgr = &my_obj->job_mgr;
 
+  memset(prop, 0, sizeof(prop));
+  property_get("persist.camera.jpeg.max.jobs", prop, "0");
+  val = atoi(prop);
+  job_mgr->max_jobs = (val > 0) ?
+    (uint32_t)val : MM_JPEG_CONCURRENT_SESSIONS_COUNT;
+
+  memset(prop, 0, sizeof(prop));
+  property_get("persist.camera.jpeg.workers", prop, "0");
+  val = atoi(prop);
+  job_mgr->num_workers = (val > 0) ? (uint32_t)val : job_mgr->max_jobs;
+  if (job_mgr->num_workers > MM_JPEG_MAX_WORKERS) {
+    job_mgr->num_workers = MM_JPEG_MAX_WORKERS;
+  }
+
+  memset(job_mgr->setup, 0, sizeof(job_mgr->setup));
+  pthread_cond_init(&job_mgr->setup_cond, NULL);
   cam_sem_init(&job_mgr->job_sem, 0);
   mm_jpeg_queue_init(&job_mgr->job_queue);
 
-  /* launch the thread */
-  pthread_create(&job_mgr->pid,
-    NULL,
-    mm_jpeg_jobmgr_thread,
-    (void *)my_obj);
-  pthread_setname_np(job_mgr->pid, "CAM_jpeg_jobmgr");
+  /* launch the threads */
+  for (i = 0; i < job_mgr->num_workers; i++) {
+    if (pthread_create(&job_mgr->pid[i],
+      NULL,
+      mm_jpeg_jobmgr_thread,
+      (void *)my_obj)) {
+      CDBG_ERROR("%s:%d] cannot create worker %d", __func__, __LINE__, i);
+      break;
+    }
+    snprintf(name, sizeof(name), "CAM_jpeg_job%d", i);
+    pthread_setname_np(job_mgr->pid[i], name);
+  }
+  job_mgr->num_workers = i;
+  if (0 == i) {
+    mm_jpeg_queue_deinit(&job_mgr->job_queue);
+    cam_sem_destroy(&job_mgr->job_sem);
+    pthread_cond_destroy(&job_mgr->setup_cond);
+    rc = -1;
+  }
+
+  CDBG_HIGH("%s:%d] workers %d max jobs %d", __func__, __LINE__,
+    job_mgr->num_workers, job_mgr->max_jobs);
   return rc;
 }
 
@@ -1878,35 +2143,43 @@ int32_t mm_jpeg_jobmgr_thread_launch(mm_jpeg_obj *my_obj)
  *       0 for success else failure
  *
  *  Description:
- *       Releases the job manager thread
+ *       Releases the job manager worker threads
  *
  **/
 int32_t mm_jpeg_jobmgr_thread_release(mm_jpeg_obj * my_obj)
 {
   mm_jpeg_q_data_t qdata;
   int32_t rc = 0;
+  uint32_t i;
   mm_jpeg_job_cmd_thread_t * cmd_thread = &my_obj->job_mgr;
-  mm_jpeg_job_q_node_t* node =
-    (mm_jpeg_job_q_node_t *)malloc(sizeof(mm_jpeg_job_q_node_t));
-  if (NULL == node) {
-    CDBG_ERROR("%s: No memory for mm_jpeg_job_q_node_t", __func__);
-    return -1;
-  }
+  mm_jpeg_job_q_node_t* node = NULL;
 
-  memset(node, 0, sizeof(mm_jpeg_job_q_node_t));
-  node->type = MM_JPEG_CMD_TYPE_EXIT;
+  /* one exit command per worker */
+  for (i = 0; i < cmd_thread->num_workers; i++) {
+    node = (mm_jpeg_job_q_node_t *)malloc(sizeof(mm_jpeg_job_q_node_t));
+    if (NULL == node) {
+      CDBG_ERROR("%s: No memory for mm_jpeg_job_q_node_t", __func__);
+      return -1;
+    }
 
-  qdata.p = node;
-  mm_jpeg_queue_enq(&cmd_thread->job_queue, qdata);
-  cam_sem_post(&cmd_thread->job_sem);
+    memset(node, 0, sizeof(mm_jpeg_job_q_node_t));
+    node->type = MM_JPEG_CMD_TYPE_EXIT;
+
+    qdata.p = node;
+    mm_jpeg_queue_enq(&cmd_thread->job_queue, qdata);
+    cam_sem_post(&cmd_thread->job_sem);
+  }
 
-  /* wait until cmd thread exits */
-  if (pthread_join(cmd_thread->pid, NULL) != 0) {
-    CDBG("%s: pthread dead already", __func__);
+  /* wait until worker threads exit */
+  for (i = 0; i < cmd_thread->num_workers; i++) {
+    if (pthread_join(cmd_thread->pid[i], NULL) != 0) {
+      CDBG("%s: pthread dead already", __func__);
+    }
   }
   mm_jpeg_queue_deinit(&cmd_thread->job_queue);
 
   cam_sem_destroy(&cmd_thread->job_sem);
+  pthread_cond_destroy(&cmd_thread->setup_cond);
   memset(cmd_thread, 0, sizeof(mm_jpeg_job_cmd_thread_t));
   return rc;
 }
@@ -2160,6 +2433,38 @@ uint32_t mm_jpeg_new_client(mm_jpeg_obj *my_obj)
   return client_hdl;
 }
 
+/** mm_jpeg_get_job_lane:
+ *
+ *  Arguments:
+ *    @p_job: encode job
+ *
+ *  Return:
+ *       scheduling lane of the job
+ *
+ *  Description:
+ *       Uses the priority requested by the client, otherwise jobs
+ *       with a small output go to the high lane
+ *
+ **/
+static mm_jpeg_lane_t mm_jpeg_get_job_lane(mm_jpeg_encode_job_t *p_job)
+{
+  uint64_t pixels;
+
+  switch (p_job->priority) {
+  case MM_JPEG_JOB_PRIO_HIGH:
+    return MM_JPEG_LANE_HIGH;
+  case MM_JPEG_JOB_PRIO_NORMAL:
+    return MM_JPEG_LANE_NORMAL;
+  default:
+    break;
+  }
+
+  pixels = (uint64_t)p_job->main_dim.dst_dim.width *
+    (uint64_t)p_job->main_dim.dst_dim.height;
+  return (pixels <= MM_JPEG_LANE_HIGH_MAX_PIXELS) ?
+    MM_JPEG_LANE_HIGH : MM_JPEG_LANE_NORMAL;
+}
+
 /** mm_jpeg_start_job:
  *
  *  Arguments:
@@ -2282,6 +2587,8 @@ int32_t mm_jpeg_start_job(mm_jpeg_obj *my_obj,
   node->enc_info.job_id = *job_id;
   node->enc_info.client_handle = p_session->client_hdl;
   node->type = MM_JPEG_CMD_TYPE_JOB;
+  node->lane = mm_jpeg_get_job_lane(&node->enc_info.encode_job);
+  node->enq_us = mm_jpeg_get_time_us();
 
 
 
@@ -2321,6 +2628,7 @@ int32_t mm_jpeg_abort_job(mm_jpeg_obj *my_obj,
 
   CDBG("%s:%d] ", __func__, __LINE__);
   pthread_mutex_lock(&my_obj->job_lock);
+  mm_jpeg_jobmgr_wait_setup(my_obj, 0, jobId);
 
   /* abort job if in todo queue */
   node = mm_jpeg_queue_remove_job_by_job_id(&my_obj->job_mgr.job_queue, jobId);
@@ -2493,6 +2801,8 @@ int32_t mm_jpeg_create_session(mm_jpeg_obj *my_obj,
     ATRACE_INT(trace_tag, 1);
 
     p_session->job_index = 0;
+    memset(&p_session->stats, 0, sizeof(p_session->stats));
+    p_session->job_start_us = 0;
 
     p_session->next_session = NULL;
 
@@ -2605,7 +2915,8 @@ static int32_t mm_jpegenc_destroy_job(mm_jpeg_job_session_t *p_session)
     (int)p_jobparams->exif_info.numOfEntries,
     (int)p_session->exif_count_local);
   for (i = 0; i < p_session->exif_count_local; i++) {
-    rc = releaseExifEntry(&p_session->exif_info_local[i]);
+    rc = releaseExifEntry(&p_session->exif_info_local[i],
+      &p_session->exif_arena);
     if (rc) {
       CDBG_ERROR("%s:%d] Exif release failed (%d)", __func__, __LINE__, rc);
     }
@@ -2615,16 +2926,131 @@ static int32_t mm_jpegenc_destroy_job(mm_jpeg_job_session_t *p_session)
   return rc;
 }
 
-/** mm_jpeg_session_encode:
+/** mm_jpeg_session_collect_stats:
+ *
+ *  Arguments:
+ *    @p_session: first encode session of the chain
+ *    @p_stats: statistics to fill
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Sums the scheduling and exif arena statistics over all OMX
+ *       sessions of the chain
+ *
+ **/
+static void mm_jpeg_session_collect_stats(mm_jpeg_job_session_t *p_session,
+  mm_jpeg_session_stats_t *p_stats)
+{
+  mm_jpeg_job_session_t *p_cur_sess = p_session;
+  mm_jpeg_job_stats_t *p_job_stats;
+  mm_jpeg_exif_arena_t *p_arena;
+
+  memset(p_stats, 0, sizeof(*p_stats));
+  do {
+    p_job_stats = &p_cur_sess->stats;
+    p_stats->jobs += p_job_stats->jobs;
+    p_stats->high_lane_jobs += p_job_stats->lane_jobs[MM_JPEG_LANE_HIGH];
+    p_stats->normal_lane_jobs += p_job_stats->lane_jobs[MM_JPEG_LANE_NORMAL];
+    p_stats->wait_total_us += p_job_stats->wait_total_us;
+    p_stats->encode_total_us += p_job_stats->encode_total_us;
+    if (p_job_stats->wait_max_us > p_stats->wait_max_us) {
+      p_stats->wait_max_us = p_job_stats->wait_max_us;
+    }
+    if (p_job_stats->encode_max_us > p_stats->encode_max_us) {
+      p_stats->encode_max_us = p_job_stats->encode_max_us;
+    }
+
+    p_arena = &p_cur_sess->exif_arena;
+    p_stats->exif_tables += p_arena->num_jobs;
+    p_stats->exif_heap_allocs += p_arena->num_heap_allocs;
+    p_stats->exif_build_us += p_arena->build_us;
+    p_stats->exif_arena_size += p_arena->size;
+  } while (NULL != (p_cur_sess = p_cur_sess->next_session));
+}
+
+/** mm_jpeg_session_dump_stats:
+ *
+ *  Arguments:
+ *    @p_session: first encode session of the chain
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Logs the statistics of a session
+ *
+ **/
+static void mm_jpeg_session_dump_stats(mm_jpeg_job_session_t *p_session)
+{
+  mm_jpeg_session_stats_t stats;
+
+  mm_jpeg_session_collect_stats(p_session, &stats);
+  if (0 == stats.jobs) {
+    return;
+  }
+
+  CDBG_HIGH("%s:%d] session %x jobs %u (high %u normal %u) "
+    "queue wait avg %llu max %llu us, encode avg %llu max %llu us",
+    __func__, __LINE__, p_session->sessionId, stats.jobs,
+    stats.high_lane_jobs, stats.normal_lane_jobs,
+    (unsigned long long)(stats.wait_total_us / stats.jobs),
+    (unsigned long long)stats.wait_max_us,
+    (unsigned long long)(stats.encode_total_us / stats.jobs),
+    (unsigned long long)stats.encode_max_us);
+
+  if (stats.exif_tables) {
+    CDBG_HIGH("%s:%d] session %x exif tables %u heap allocs %u "
+      "build avg %llu us arena %zu bytes", __func__, __LINE__,
+      p_session->sessionId, stats.exif_tables, stats.exif_heap_allocs,
+      (unsigned long long)(stats.exif_build_us / stats.exif_tables),
+      stats.exif_arena_size);
+  }
+}
+
+/** mm_jpeg_get_session_stats:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @session_id: session id
+ *    @p_stats: statistics to fill
+ *
+ *  Return:
+ *       0 for success else failure
+ *
+ *  Description:
+ *       Get the statistics of an encode session
+ *
+ **/
+int32_t mm_jpeg_get_session_stats(mm_jpeg_obj *my_obj, uint32_t session_id,
+  mm_jpeg_session_stats_t *p_stats)
+{
+  mm_jpeg_job_session_t *p_session = mm_jpeg_get_session(my_obj, session_id);
+
+  if ((NULL == p_session) || (NULL == p_stats) ||
+    (OMX_FALSE == p_session->active)) {
+    CDBG_ERROR("%s:%d] invalid session %x", __func__, __LINE__, session_id);
+    return -1;
+  }
+
+  pthread_mutex_lock(&my_obj->job_lock);
+  mm_jpeg_session_collect_stats(p_session, p_stats);
+  pthread_mutex_unlock(&my_obj->job_lock);
+  return 0;
+}
+
+/** mm_jpegenc_job_done:
  *
  *  Arguments:
  *    @p_session: encode session
  *
  *  Return:
- *       OMX_ERRORTYPE
+ *       none
  *
  *  Description:
- *       Start the encoding
+ *       Completes the current job of the session and returns the
+ *       session and its output buffer to the free queues
  *
  **/
 static void mm_jpegenc_job_done(mm_jpeg_job_session_t *p_session)
@@ -2632,10 +3058,23 @@ static void mm_jpegenc_job_done(mm_jpeg_job_session_t *p_session)
   mm_jpeg_q_data_t qdata;
   mm_jpeg_obj *my_obj = (mm_jpeg_obj *)p_session->jpeg_obj;
   mm_jpeg_job_q_node_t *node = NULL;
+  mm_jpeg_job_stats_t *p_stats = &p_session->stats;
+  uint64_t encode_us;
 
   /*Destroy job related params*/
   mm_jpegenc_destroy_job(p_session);
 
+  if (p_session->job_start_us) {
+    encode_us = mm_jpeg_get_time_us() - p_session->job_start_us;
+    p_stats->jobs++;
+    p_stats->lane_jobs[p_session->job_lane]++;
+    p_stats->encode_total_us += encode_us;
+    if (encode_us > p_stats->encode_max_us) {
+      p_stats->encode_max_us = encode_us;
+    }
+    p_session->job_start_us = 0;
+  }
+
   /*remove the job*/
   node = mm_jpeg_queue_remove_job_by_job_id(&my_obj->ongoing_job_q,
     p_session->jobId);
@@ -2689,6 +3128,7 @@ int32_t mm_jpeg_destroy_session(mm_jpeg_obj *my_obj,
   session_id = p_session->sessionId;
 
   pthread_mutex_lock(&my_obj->job_lock);
+  mm_jpeg_jobmgr_wait_setup(my_obj, session_id, 0);
 
   /* abort job if in todo queue */
   CDBG_HIGH("%s:%d] abort todo jobs", __func__, __LINE__);
@@ -2708,6 +3148,7 @@ int32_t mm_jpeg_destroy_session(mm_jpeg_obj *my_obj,
 
   /* abort the current session */
   mm_jpeg_session_abort(p_session);
+  mm_jpeg_session_dump_stats(p_session);
   mm_jpeg_session_destroy(p_session);
 
   p_cur_sess = p_session;
@@ -2856,6 +3297,8 @@ int32_t mm_jpeg_close(mm_jpeg_obj *my_obj, uint32_t client_hdl)
 
   CDBG("%s:%d] ", __func__, __LINE__);
 
+  mm_jpeg_jobmgr_wait_setup(my_obj, 0, 0);
+
   for (i = 0; i < MM_JPEG_MAX_SESSION; i++) {
     if (OMX_TRUE == my_obj->clnt_mgr[clnt_idx].session[i].active)
       mm_jpeg_destroy_session_unlocked(my_obj,
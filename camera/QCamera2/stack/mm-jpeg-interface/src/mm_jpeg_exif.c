@@ -40,12 +40,130 @@
 #define ROUND(a) \
         ((a >= 0) ? (uint32_t)(a + 0.5) : (uint32_t)(a - 0.5))
 
+#define EXIF_ARENA_ALIGN(a)    (((a) + 7U) & ~(size_t)7U)
+#define EXIF_ARENA_GRANULE     1024U
+
+/** mm_jpeg_exif_arena_rewind:
+ *
+ *  Arguments:
+ *   @p_arena : exif arena
+ *
+ *  Retrun     : int32_t type of status
+ *               0  -- success
+ *              none-zero failure code
+ *
+ *  Description:
+ *       Prepares the arena for the next exif table. The entries of
+ *       the previous table must have been released. If the previous
+ *       table did not fit, the arena is grown so that it would have
+ *       fit, so steady state jobs do not allocate
+ *
+ **/
+int32_t mm_jpeg_exif_arena_rewind(mm_jpeg_exif_arena_t *p_arena)
+{
+  size_t size;
+  uint8_t *base;
+
+  if ((NULL == p_arena->base) || p_arena->overflow) {
+    size = p_arena->size ? p_arena->size : MM_JPEG_EXIF_ARENA_SIZE;
+    size += p_arena->overflow;
+    size = (size + EXIF_ARENA_GRANULE - 1) & ~(size_t)(EXIF_ARENA_GRANULE - 1);
+    base = (uint8_t *)malloc(size);
+    if (NULL == base) {
+      ALOGE("%s: No memory for exif arena of %zu bytes", __func__, size);
+      /* keep the old arena, the overflow goes to the heap again */
+      p_arena->used = 0;
+      p_arena->overflow = 0;
+      return -1;
+    }
+    p_arena->num_heap_allocs++;
+    free(p_arena->base);
+    p_arena->base = base;
+    p_arena->size = size;
+  }
+  p_arena->used = 0;
+  p_arena->overflow = 0;
+  return 0;
+}
+
+/** mm_jpeg_exif_arena_release:
+ *
+ *  Arguments:
+ *   @p_arena : exif arena
+ *
+ *  Retrun     : none
+ *
+ *  Description:
+ *       Frees the arena memory and clears its statistics
+ *
+ **/
+void mm_jpeg_exif_arena_release(mm_jpeg_exif_arena_t *p_arena)
+{
+  free(p_arena->base);
+  memset(p_arena, 0, sizeof(*p_arena));
+}
+
+/** exif_alloc:
+ *
+ *  Arguments:
+ *   @p_arena : exif arena, may be NULL
+ *   @size    : number of bytes
+ *
+ *  Retrun     : ptr to the memory, NULL on failure
+ *
+ *  Description:
+ *       Carves a tag payload from the arena, falls back to the heap
+ *       when the arena is full
+ *
+ **/
+static void *exif_alloc(mm_jpeg_exif_arena_t *p_arena, size_t size)
+{
+  size_t aligned = EXIF_ARENA_ALIGN(size);
+  void *ptr;
+
+  if (p_arena && p_arena->base &&
+    (aligned <= p_arena->size - p_arena->used)) {
+    ptr = p_arena->base + p_arena->used;
+    p_arena->used += aligned;
+    return ptr;
+  }
+
+  ptr = malloc(size);
+  if (p_arena && ptr) {
+    p_arena->overflow += aligned;
+    p_arena->num_heap_allocs++;
+  }
+  return ptr;
+}
+
+/** exif_free:
+ *
+ *  Arguments:
+ *   @p_arena : exif arena, may be NULL
+ *   @ptr     : tag payload
+ *
+ *  Retrun     : none
+ *
+ *  Description:
+ *       Frees a tag payload unless it was carved from the arena
+ *
+ **/
+static void exif_free(mm_jpeg_exif_arena_t *p_arena, void *ptr)
+{
+  if (p_arena && p_arena->base &&
+    ((uint8_t *)ptr >= p_arena->base) &&
+    ((uint8_t *)ptr < p_arena->base + p_arena->size)) {
+    return;
+  }
+  free(ptr);
+}
+
 
 /** addExifEntry:
  *
  *  Arguments:
  *   @exif_info : Exif info struct
- *   @p_session: job session
+ *   @p_arena : arena the payload is carved from, NULL for heap
  *   @tagid   : exif tag ID
  *   @type    : data type
  *   @count   : number of data in uint of its type
@@ -59,7 +177,8 @@
  *       Function to add an entry to exif data
  *
  **/
-int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
+int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info,
+  mm_jpeg_exif_arena_t *p_arena, exif_tag_id_t tagid,
   exif_tag_type_t type, uint32_t count, void *data)
 {
     int32_t rc = 0;
@@ -77,7 +196,7 @@ int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
     switch (type) {
     case EXIF_BYTE: {
       if (count > 1) {
-        uint8_t *values = (uint8_t *)malloc(count);
+        uint8_t *values = (uint8_t *)exif_alloc(p_arena, count);
         if (values == NULL) {
           ALOGE("%s: No memory for byte array", __func__);
           rc = -1;
@@ -92,7 +211,7 @@ int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
     break;
     case EXIF_ASCII: {
       char *str = NULL;
-      str = (char *)malloc(count + 1);
+      str = (char *)exif_alloc(p_arena, count + 1);
       if (str == NULL) {
         ALOGE("%s: No memory for ascii string", __func__);
         rc = -1;
@@ -105,7 +224,7 @@ int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
     break;
     case EXIF_SHORT: {
       if (count > 1) {
-        uint16_t *values = (uint16_t *)malloc(count * sizeof(uint16_t));
+        uint16_t *values = (uint16_t *)exif_alloc(p_arena, count * sizeof(uint16_t));
         if (values == NULL) {
           ALOGE("%s: No memory for short array", __func__);
           rc = -1;
@@ -120,7 +239,7 @@ int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
     break;
     case EXIF_LONG: {
       if (count > 1) {
-        uint32_t *values = (uint32_t *)malloc(count * sizeof(uint32_t));
+        uint32_t *values = (uint32_t *)exif_alloc(p_arena, count * sizeof(uint32_t));
         if (values == NULL) {
           ALOGE("%s: No memory for long array", __func__);
           rc = -1;
@@ -135,7 +254,7 @@ int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
     break;
     case EXIF_RATIONAL: {
       if (count > 1) {
-        rat_t *values = (rat_t *)malloc(count * sizeof(rat_t));
+        rat_t *values = (rat_t *)exif_alloc(p_arena, count * sizeof(rat_t));
         if (values == NULL) {
           ALOGE("%s: No memory for rational array", __func__);
           rc = -1;
@@ -149,7 +268,7 @@ int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
     }
     break;
     case EXIF_UNDEFINED: {
-      uint8_t *values = (uint8_t *)malloc(count);
+      uint8_t *values = (uint8_t *)exif_alloc(p_arena, count);
       if (values == NULL) {
         ALOGE("%s: No memory for undefined array", __func__);
         rc = -1;
@@ -161,7 +280,7 @@ int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
     break;
     case EXIF_SLONG: {
       if (count > 1) {
-        int32_t *values = (int32_t *)malloc(count * sizeof(int32_t));
+        int32_t *values = (int32_t *)exif_alloc(p_arena, count * sizeof(int32_t));
         if (values == NULL) {
           ALOGE("%s: No memory for signed long array", __func__);
           rc = -1;
@@ -176,7 +295,7 @@ int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
     break;
     case EXIF_SRATIONAL: {
       if (count > 1) {
-        srat_t *values = (srat_t *)malloc(count * sizeof(srat_t));
+        srat_t *values = (srat_t *)exif_alloc(p_arena, count * sizeof(srat_t));
         if (values == NULL) {
           ALOGE("%s: No memory for signed rational array", __func__);
           rc = -1;
@@ -200,6 +319,7 @@ int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
  *
  *  Arguments:
  *   @p_exif_data : Exif info struct
+ *   @p_arena : arena the payload was carved from, NULL for heap
  *
  *  Retrun     : int32_t type of status
  *               0  -- success
@@ -209,20 +329,21 @@ int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
  *       Function to release an entry from exif data
  *
  **/
-int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data)
+int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data,
+  mm_jpeg_exif_arena_t *p_arena)
 {
  switch (p_exif_data->tag_entry.type) {
   case EXIF_BYTE: {
     if (p_exif_data->tag_entry.count > 1 &&
       p_exif_data->tag_entry.data._bytes != NULL) {
-      free(p_exif_data->tag_entry.data._bytes);
+      exif_free(p_arena, p_exif_data->tag_entry.data._bytes);
       p_exif_data->tag_entry.data._bytes = NULL;
     }
   }
   break;
   case EXIF_ASCII: {
     if (p_exif_data->tag_entry.data._ascii != NULL) {
-      free(p_exif_data->tag_entry.data._ascii);
+      exif_free(p_arena, p_exif_data->tag_entry.data._ascii);
       p_exif_data->tag_entry.data._ascii = NULL;
     }
   }
@@ -230,7 +351,7 @@ int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data)
   case EXIF_SHORT: {
     if (p_exif_data->tag_entry.count > 1 &&
       p_exif_data->tag_entry.data._shorts != NULL) {
-      free(p_exif_data->tag_entry.data._shorts);
+      exif_free(p_arena, p_exif_data->tag_entry.data._shorts);
       p_exif_data->tag_entry.data._shorts = NULL;
     }
   }
@@ -238,7 +359,7 @@ int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data)
   case EXIF_LONG: {
     if (p_exif_data->tag_entry.count > 1 &&
       p_exif_data->tag_entry.data._longs != NULL) {
-      free(p_exif_data->tag_entry.data._longs);
+      exif_free(p_arena, p_exif_data->tag_entry.data._longs);
       p_exif_data->tag_entry.data._longs = NULL;
     }
   }
@@ -246,14 +367,14 @@ int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data)
   case EXIF_RATIONAL: {
     if (p_exif_data->tag_entry.count > 1 &&
       p_exif_data->tag_entry.data._rats != NULL) {
-      free(p_exif_data->tag_entry.data._rats);
+      exif_free(p_arena, p_exif_data->tag_entry.data._rats);
       p_exif_data->tag_entry.data._rats = NULL;
     }
   }
   break;
   case EXIF_UNDEFINED: {
     if (p_exif_data->tag_entry.data._undefined != NULL) {
-      free(p_exif_data->tag_entry.data._undefined);
+      exif_free(p_arena, p_exif_data->tag_entry.data._undefined);
       p_exif_data->tag_entry.data._undefined = NULL;
     }
   }
@@ -261,7 +382,7 @@ int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data)
   case EXIF_SLONG: {
     if (p_exif_data->tag_entry.count > 1 &&
       p_exif_data->tag_entry.data._slongs != NULL) {
-      free(p_exif_data->tag_entry.data._slongs);
+      exif_free(p_arena, p_exif_data->tag_entry.data._slongs);
       p_exif_data->tag_entry.data._slongs = NULL;
     }
   }
@@ -269,7 +390,7 @@ int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data)
   case EXIF_SRATIONAL: {
     if (p_exif_data->tag_entry.count > 1 &&
       p_exif_data->tag_entry.data._srats != NULL) {
-      free(p_exif_data->tag_entry.data._srats);
+      exif_free(p_arena, p_exif_data->tag_entry.data._srats);
       p_exif_data->tag_entry.data._srats = NULL;
     }
   }
@@ -283,6 +404,8 @@ int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data)
  *
  *  Arguments:
  *   @p_sensor_params : ptr to sensor data
+ *   @exif_info : Exif info struct
+ *   @p_arena : arena the tag payloads are carved from
  *
  *  Return     : int32_t type of status
  *               NO_ERROR  -- success
@@ -294,7 +417,7 @@ int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data)
  *  Notes: this needs to be filled for the metadata
  **/
 int process_sensor_data(cam_sensor_params_t *p_sensor_params,
-  QOMX_EXIF_INFO *exif_info)
+  QOMX_EXIF_INFO *exif_info, mm_jpeg_exif_arena_t *p_arena)
 {
   int rc = 0;
   rat_t val_rat;
@@ -312,14 +435,14 @@ int process_sensor_data(cam_sensor_params_t *p_sensor_params,
     apex_value = (double)2.0 * log(p_sensor_params->aperture_value) / log(2.0);
     val_rat.num = (uint32_t)(apex_value * 100);
     val_rat.denom = 100;
-    rc = addExifEntry(exif_info, EXIFTAGID_APERTURE, EXIF_RATIONAL, 1, &val_rat);
+    rc = addExifEntry(exif_info, p_arena, EXIFTAGID_APERTURE, EXIF_RATIONAL, 1, &val_rat);
     if (rc) {
       ALOGE("%s:%d]: Error adding Exif Entry", __func__, __LINE__);
     }
 
     val_rat.num = (uint32_t)(p_sensor_params->aperture_value * 100);
     val_rat.denom = 100;
-    rc = addExifEntry(exif_info, EXIFTAGID_F_NUMBER, EXIF_RATIONAL, 1, &val_rat);
+    rc = addExifEntry(exif_info, p_arena, EXIFTAGID_F_NUMBER, EXIF_RATIONAL, 1, &val_rat);
     if (rc) {
       ALOGE("%s:%d]: Error adding Exif Entry", __func__, __LINE__);
     }
@@ -352,13 +475,13 @@ int process_sensor_data(cam_sensor_params_t *p_sensor_params,
   }
   val_short = (short)(flash_fired | (flash_mode_exif << 3));
 
-  rc = addExifEntry(exif_info, EXIFTAGID_FLASH, EXIF_SHORT, 1, &val_short);
+  rc = addExifEntry(exif_info, p_arena, EXIFTAGID_FLASH, EXIF_SHORT, 1, &val_short);
   if (rc) {
     ALOGE("%s %d]: Error adding flash exif entry", __func__, __LINE__);
   }
   /* Sensing Method */
   val_short = (short) p_sensor_params->sensing_method;
-  rc = addExifEntry(exif_info, EXIFTAGID_SENSING_METHOD, EXIF_SHORT,
+  rc = addExifEntry(exif_info, p_arena, EXIFTAGID_SENSING_METHOD, EXIF_SHORT,
     sizeof(val_short)/2, &val_short);
   if (rc) {
     ALOGE("%s:%d]: Error adding flash Exif Entry", __func__, __LINE__);
@@ -367,7 +490,7 @@ int process_sensor_data(cam_sensor_params_t *p_sensor_params,
   /* Focal Length in 35 MM Film */
   val_short = (short)
     ((p_sensor_params->focal_length * p_sensor_params->crop_factor) + 0.5f);
-  rc = addExifEntry(exif_info, EXIFTAGID_FOCAL_LENGTH_35MM, EXIF_SHORT,
+  rc = addExifEntry(exif_info, p_arena, EXIFTAGID_FOCAL_LENGTH_35MM, EXIF_SHORT,
     1, &val_short);
   if (rc) {
     ALOGE("%s:%d]: Error adding Exif Entry", __func__, __LINE__);
@@ -376,7 +499,7 @@ int process_sensor_data(cam_sensor_params_t *p_sensor_params,
   /* F Number */
   val_rat.num = (uint32_t)(p_sensor_params->f_number * 100);
   val_rat.denom = 100;
-  rc = addExifEntry(exif_info, EXIFTAGTYPE_F_NUMBER, EXIF_RATIONAL, 1, &val_rat);
+  rc = addExifEntry(exif_info, p_arena, EXIFTAGTYPE_F_NUMBER, EXIF_RATIONAL, 1, &val_rat);
   if (rc) {
     ALOGE("%s:%d]: Error adding Exif Entry", __func__, __LINE__);
   }
@@ -388,6 +511,8 @@ int process_sensor_data(cam_sensor_params_t *p_sensor_params,
  *
  *  Arguments:
  *   @p_3a_params : ptr to 3a data
+ *   @exif_info : Exif info struct
+ *   @p_arena : arena the tag payloads are carved from
  *
  *  Return     : int32_t type of status
  *               NO_ERROR  -- success
@@ -398,7 +523,8 @@ int process_sensor_data(cam_sensor_params_t *p_sensor_params,
  *
  *  Notes: this needs to be filled for the metadata
  **/
-int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
+int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info,
+  mm_jpeg_exif_arena_t *p_arena)
 {
   int rc = 0;
   srat_t val_srat;
@@ -424,7 +550,7 @@ int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
   CDBG("%s: numer %d denom %d %zd", __func__, val_rat.num, val_rat.denom,
       sizeof(val_rat) / (8));
 
-  rc = addExifEntry(exif_info, EXIFTAGID_EXPOSURE_TIME, EXIF_RATIONAL,
+  rc = addExifEntry(exif_info, p_arena, EXIFTAGID_EXPOSURE_TIME, EXIF_RATIONAL,
     (sizeof(val_rat)/(8)), &val_rat);
   if (rc) {
     ALOGE("%s:%d]: Error adding Exif Entry Exposure time",
@@ -440,7 +566,7 @@ int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
     val_srat.num = 0;
     val_srat.denom = 0;
   }
-  rc = addExifEntry(exif_info, EXIFTAGID_SHUTTER_SPEED, EXIF_SRATIONAL,
+  rc = addExifEntry(exif_info, p_arena, EXIFTAGID_SHUTTER_SPEED, EXIF_SRATIONAL,
     (sizeof(val_srat)/(8)), &val_srat);
   if (rc) {
     ALOGE("%s:%d]: Error adding Exif Entry", __func__, __LINE__);
@@ -449,7 +575,7 @@ int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
   /*ISO*/
   short val_short;
   val_short = (short)p_3a_params->iso_value;
-  rc = addExifEntry(exif_info, EXIFTAGID_ISO_SPEED_RATING, EXIF_SHORT,
+  rc = addExifEntry(exif_info, p_arena, EXIFTAGID_ISO_SPEED_RATING, EXIF_SHORT,
     sizeof(val_short)/2, &val_short);
   if (rc) {
     ALOGE("%s:%d]: Error adding Exif Entry", __func__, __LINE__);
@@ -460,7 +586,7 @@ int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
     val_short = 0;
   else
     val_short = 1;
-  rc = addExifEntry(exif_info, EXIFTAGID_WHITE_BALANCE, EXIF_SHORT,
+  rc = addExifEntry(exif_info, p_arena, EXIFTAGID_WHITE_BALANCE, EXIF_SHORT,
     sizeof(val_short)/2, &val_short);
   if (rc) {
     ALOGE("%s:%d]: Error adding Exif Entry", __func__, __LINE__);
@@ -468,7 +594,7 @@ int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
 
   /* Metering Mode   */
   val_short = (short) p_3a_params->metering_mode;
-  rc = addExifEntry(exif_info,EXIFTAGID_METERING_MODE, EXIF_SHORT,
+  rc = addExifEntry(exif_info, p_arena, EXIFTAGID_METERING_MODE, EXIF_SHORT,
      sizeof(val_short)/2, &val_short);
   if (rc) {
      ALOGE("%s:%d]: Error adding Exif Entry", __func__, __LINE__);
@@ -476,7 +602,7 @@ int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
 
   /*Exposure Program*/
    val_short = (short) p_3a_params->exposure_program;
-   rc = addExifEntry(exif_info,EXIFTAGID_EXPOSURE_PROGRAM, EXIF_SHORT,
+   rc = addExifEntry(exif_info, p_arena, EXIFTAGID_EXPOSURE_PROGRAM, EXIF_SHORT,
       sizeof(val_short)/2, &val_short);
    if (rc) {
       ALOGE("%s:%d]: Error adding Exif Entry", __func__, __LINE__);
@@ -484,7 +610,7 @@ int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
 
    /*Exposure Mode */
     val_short = (short) p_3a_params->exposure_mode;
-    rc = addExifEntry(exif_info,EXIFTAGID_EXPOSURE_MODE, EXIF_SHORT,
+    rc = addExifEntry(exif_info, p_arena, EXIFTAGID_EXPOSURE_MODE, EXIF_SHORT,
        sizeof(val_short)/2, &val_short);
     if (rc) {
        ALOGE("%s:%d]: Error adding Exif Entry", __func__, __LINE__);
@@ -493,7 +619,7 @@ int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
     /*Scenetype*/
      uint8_t val_undef;
      val_undef = (uint8_t) p_3a_params->scenetype;
-     rc = addExifEntry(exif_info,EXIFTAGID_SCENE_TYPE, EXIF_UNDEFINED,
+     rc = addExifEntry(exif_info, p_arena, EXIFTAGID_SCENE_TYPE, EXIF_UNDEFINED,
         sizeof(val_undef), &val_undef);
      if (rc) {
         ALOGE("%s:%d]: Error adding Exif Entry", __func__, __LINE__);
@@ -505,7 +631,7 @@ int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
     /* Brightness Value*/
      val_srat.num = (int32_t) (p_3a_params->brightness * 100.0f);
      val_srat.denom = 100;
-     rc = addExifEntry(exif_info,EXIFTAGID_BRIGHTNESS, EXIF_SRATIONAL,
+     rc = addExifEntry(exif_info, p_arena, EXIFTAGID_BRIGHTNESS, EXIF_SRATIONAL,
                  (sizeof(val_srat)/(8)), &val_srat);
      if (rc) {
         ALOGE("%s:%d]: Error adding Exif Entry", __func__, __LINE__);
@@ -519,6 +645,7 @@ int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
  *  Arguments:
  *   @p_meta : ptr to metadata
  *   @exif_info: Exif info struct
+ *   @p_arena: arena the tag payloads are carved from
  *   @mm_jpeg_exif_params: exif params
  *
  *  Return     : int32_t type of status
@@ -529,7 +656,8 @@ int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
  *       Extract exif data from the metadata
  **/
 int process_meta_data(metadata_buffer_t *p_meta, QOMX_EXIF_INFO *exif_info,
-  mm_jpeg_exif_params_t *p_cam_exif_params, cam_hal_version_t hal_version)
+  mm_jpeg_exif_arena_t *p_arena, mm_jpeg_exif_params_t *p_cam_exif_params,
+  cam_hal_version_t hal_version)
 {
   int rc = 0;
   cam_sensor_params_t p_sensor_params;
@@ -612,13 +740,13 @@ int process_meta_data(metadata_buffer_t *p_meta, QOMX_EXIF_INFO *exif_info,
     }
   }
   if ((hal_version != CAM_HAL_V1) || (p_sensor_params.sens_type != CAM_SENSOR_YUV)) {
-    rc = process_3a_data(&p_3a_params, exif_info);
+    rc = process_3a_data(&p_3a_params, exif_info, p_arena);
     if (rc) {
       ALOGE("%s %d: Failed to add 3a exif params", __func__, __LINE__);
     }
   }
 
-  rc = process_sensor_data(&p_sensor_params, exif_info);
+  rc = process_sensor_data(&p_sensor_params, exif_info, p_arena);
   if (rc) {
     ALOGE("%s %d: Failed to extract sensor params", __func__, __LINE__);
   }
@@ -631,7 +759,7 @@ int process_meta_data(metadata_buffer_t *p_meta, QOMX_EXIF_INFO *exif_info,
       val_short = (short) *scene_cap_type;
     }
 
-    rc = addExifEntry(exif_info, EXIFTAGID_SCENE_CAPTURE_TYPE, EXIF_SHORT,
+    rc = addExifEntry(exif_info, p_arena, EXIFTAGID_SCENE_CAPTURE_TYPE, EXIF_SHORT,
       sizeof(val_short)/2, &val_short);
     if (rc) {
       ALOGE("%s:%d]: Error adding ASD Exif Entry", __func__, __LINE__);
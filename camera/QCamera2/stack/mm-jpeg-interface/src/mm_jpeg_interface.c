@@ -201,6 +201,42 @@ static int32_t mm_jpeg_intf_destroy_session(uint32_t session_id)
   return rc;
 }
 
+/** mm_jpeg_intf_get_session_stats:
+ *
+ *  Arguments:
+ *    @session_id: session id
+ *    @p_stats: statistics to fill
+ *
+ *  Return:
+ *       0 success, failure otherwise
+ *
+ *  Description:
+ *       Get the statistics of a jpeg session
+ *
+ **/
+static int32_t mm_jpeg_intf_get_session_stats(uint32_t session_id,
+  mm_jpeg_session_stats_t *p_stats)
+{
+  int32_t rc = -1;
+
+  if (0 == session_id) {
+    CDBG_ERROR("%s:%d] invalid session id", __func__, __LINE__);
+    return rc;
+  }
+
+  pthread_mutex_lock(&g_intf_lock);
+  if (NULL == g_jpeg_obj) {
+    /* mm_jpeg obj not exists, return error */
+    CDBG_ERROR("%s:%d] mm_jpeg is not opened yet", __func__, __LINE__);
+    pthread_mutex_unlock(&g_intf_lock);
+    return rc;
+  }
+
+  rc = mm_jpeg_get_session_stats(g_jpeg_obj, session_id, p_stats);
+  pthread_mutex_unlock(&g_intf_lock);
+  return rc;
+}
+
 /** mm_jpeg_intf_abort_job:
  *
  *  Arguments:
@@ -411,6 +447,7 @@ uint32_t jpeg_open(mm_jpeg_ops_t *ops, mm_jpeg_mpo_ops_t *mpo_ops,
       ops->create_session = mm_jpeg_intf_create_session;
       ops->destroy_session = mm_jpeg_intf_destroy_session;
       ops->close = mm_jpeg_intf_close;
+      ops->get_session_stats = mm_jpeg_intf_get_session_stats;
     }
     if (NULL != mpo_ops) {
       mpo_ops->compose_mpo = mm_jpeg_intf_compose_mpo;
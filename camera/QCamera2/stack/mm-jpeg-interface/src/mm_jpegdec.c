@@ -787,6 +787,8 @@ int32_t mm_jpegdec_start_decode_job(mm_jpeg_obj *my_obj,
   node->dec_info.job_id = *job_id;
   node->dec_info.client_handle = p_session->client_hdl;
   node->type = MM_JPEG_CMD_TYPE_DECODE_JOB;
+  node->lane = MM_JPEG_LANE_NORMAL;
+  node->enq_us = mm_jpeg_get_time_us();
 
   qdata.p = node;
   rc = mm_jpeg_queue_enq(&my_obj->job_mgr.job_queue, qdata);
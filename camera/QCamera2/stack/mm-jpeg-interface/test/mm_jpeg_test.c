@@ -72,6 +72,7 @@ typedef struct {
   int tmb_height;
   int main_quality;
   int thumb_quality;
+  uint32_t burst_count;
 } jpeg_test_input_t;
 
 /* Static constants */
@@ -118,6 +119,8 @@ typedef struct {
   uint32_t num_bufs;
   uint32_t min_out_bufs;
   size_t buf_filled_len[MAX_NUM_BUFS];
+  uint32_t burst_count;
+  struct timeval burst_end;
 } mm_jpeg_intf_test_t;
 
 
@@ -136,7 +139,7 @@ static const mm_jpeg_intf_test_colfmt_t color_formats[] =
 
 static jpeg_test_input_t jpeg_input[] = {
   { QCAMERA_DUMP_FRM_LOCATION"test_1.yuv", 4000, 3008, QCAMERA_DUMP_FRM_LOCATION"test_1.jpg", 0, 0,
-  { MM_JPEG_COLOR_FORMAT_YCRCBLP_H2V2, {3, 2}, "YCRCBLP_H2V2" }, 0, 320, 240, 80, 80}
+  { MM_JPEG_COLOR_FORMAT_YCRCBLP_H2V2, {3, 2}, "YCRCBLP_H2V2" }, 0, 320, 240, 80, 80, 0}
 };
 
 static void mm_jpeg_encode_callback(jpeg_job_status_t status,
@@ -151,6 +154,11 @@ static void mm_jpeg_encode_callback(jpeg_job_status_t status,
 
   if (status == JPEG_JOB_STATUS_ERROR) {
     CDBG_ERROR("%s:%d] Encode error", __func__, __LINE__);
+  } else if (p_obj->burst_count) {
+    /* burst runs only measure, outputs are overwritten */
+    if (g_i + 1 >= g_count) {
+      gettimeofday(&p_obj->burst_end, NULL);
+    }
   } else {
     int i = 0;
     for (i = 0; p_obj->job_id[i] && (jobId != p_obj->job_id[i]); i++)
@@ -259,6 +267,7 @@ static int encode_init(jpeg_test_input_t *p_input, mm_jpeg_intf_test_t *p_obj)
     p_obj->out_filename[i] = p_in->out_filename;
     p_obj->use_ion = 1;
     p_obj->min_out_bufs = p_input->min_out_bufs;
+    p_obj->burst_count = p_input->burst_count;
 
     /* allocate buffers */
     p_obj->input[i].size = size * (size_t)p_input->col_fmt.mult.numerator /
@@ -338,6 +347,9 @@ static int encode_init(jpeg_test_input_t *p_input, mm_jpeg_intf_test_t *p_obj)
   p_params->num_src_bufs = p_obj->num_bufs;
   p_params->num_tmb_bufs = 0;
   g_count = p_params->num_src_bufs;
+  if (p_obj->burst_count) {
+    g_count *= p_obj->burst_count;
+  }
 
   p_params->encode_thumbnail = p_input->encode_thumbnail;
   if (p_params->encode_thumbnail) {
@@ -393,6 +405,77 @@ static int encode_init(jpeg_test_input_t *p_input, mm_jpeg_intf_test_t *p_obj)
   return 0;
 }
 
+/** encode_burst:
+ *
+ *  Arguments:
+ *    @p_obj: test object
+ *
+ *  Return:
+ *       0 for success else failure
+ *
+ *  Description:
+ *       Queues every input burst_count times back to back and
+ *       reports the encode throughput and the session statistics
+ *
+ **/
+static int encode_burst(mm_jpeg_intf_test_t *p_obj)
+{
+  int rc = 0;
+  uint32_t i, n;
+  uint32_t job_id;
+  struct timeval start;
+  double elapsed;
+  mm_jpeg_session_stats_t stats;
+
+  gettimeofday(&start, NULL);
+  for (n = 0; n < p_obj->burst_count; n++) {
+    for (i = 0; i < p_obj->num_bufs; i++) {
+      p_obj->job.job_type = JPEG_JOB_TYPE_ENCODE;
+      p_obj->job.encode_job.src_index = (int32_t) i;
+      p_obj->job.encode_job.thumb_index = (uint32_t) i;
+      /* let the interface pick a free output buffer */
+      p_obj->job.encode_job.dst_index = -1;
+
+      rc = p_obj->ops.start_job(&p_obj->job, &job_id);
+      if (rc) {
+        CDBG_ERROR("%s:%d] Error",__func__, __LINE__);
+        return rc;
+      }
+    }
+  }
+
+  pthread_mutex_lock(&p_obj->lock);
+  while (g_i < g_count) {
+    pthread_cond_wait(&p_obj->cond, &p_obj->lock);
+  }
+  pthread_mutex_unlock(&p_obj->lock);
+
+  elapsed = (double)(p_obj->burst_end.tv_sec - start.tv_sec) +
+    (double)(p_obj->burst_end.tv_usec - start.tv_usec) / 1000000.0;
+  fprintf(stderr, "Burst: %u images in %.3f s, %.2f images/sec\n",
+    g_count, elapsed, (elapsed > 0) ? (double)g_count / elapsed : 0.0);
+
+  memset(&stats, 0, sizeof(stats));
+  if (p_obj->ops.get_session_stats &&
+    !p_obj->ops.get_session_stats(p_obj->job.encode_job.session_id, &stats) &&
+    stats.jobs) {
+    fprintf(stderr, "Queue wait avg %llu max %llu us, "
+      "encode avg %llu max %llu us\n",
+      (unsigned long long)(stats.wait_total_us / stats.jobs),
+      (unsigned long long)stats.wait_max_us,
+      (unsigned long long)(stats.encode_total_us / stats.jobs),
+      (unsigned long long)stats.encode_max_us);
+  }
+  if (stats.exif_tables) {
+    fprintf(stderr, "Exif: %.2f heap allocs per image, build avg %llu us, "
+      "arena %zu bytes\n",
+      (double)stats.exif_heap_allocs / stats.exif_tables,
+      (unsigned long long)(stats.exif_build_us / stats.exif_tables),
+      stats.exif_arena_size);
+  }
+  return 0;
+}
+
 static int encode_test(jpeg_test_input_t *p_input)
 {
   int rc = 0;
@@ -424,6 +507,13 @@ static int encode_test(jpeg_test_input_t *p_input)
     goto end;
   }
 
+  if (jpeg_obj.burst_count) {
+    rc = encode_burst(&jpeg_obj);
+    jpeg_obj.ops.destroy_session(jpeg_obj.job.encode_job.session_id);
+    jpeg_obj.ops.close(jpeg_obj.handle);
+    goto end;
+  }
+
   for (i = 0; i < jpeg_obj.num_bufs; i++) {
     jpeg_obj.job.job_type = JPEG_JOB_TYPE_ENCODE;
     jpeg_obj.job.encode_job.src_index = (int32_t) i;
@@ -457,7 +547,7 @@ static int encode_test(jpeg_test_input_t *p_input)
 
 end:
   for (i = 0; i < jpeg_obj.num_bufs; i++) {
-    if (!jpeg_obj.min_out_bufs) {
+    if (!jpeg_obj.min_out_bufs && !jpeg_obj.burst_count) {
       // Save output files
       CDBG_ERROR("%s:%d] Saving file%s addr %p len %zu",
           __func__, __LINE__,jpeg_obj.out_filename[i],
@@ -484,7 +574,7 @@ static int mm_jpeg_test_get_input(int argc, char *argv[],
   char *in_files[MAX_FILE_CNT];
   char *out_files[MAX_FILE_CNT];
 
-  while ((c = getopt(argc, argv, "-I:O:W:H:F:BTx:y:Q:q:")) != -1) {
+  while ((c = getopt(argc, argv, "-I:O:W:H:F:BTx:y:Q:q:N:")) != -1) {
     switch (c) {
     case 'B':
       fprintf(stderr, "%-25s\n", "Using burst mode");
@@ -546,6 +636,10 @@ static int mm_jpeg_test_get_input(int argc, char *argv[],
       p_test->thumb_quality = atoi(optarg);
       fprintf(stderr, "%-25s%d\n", "Thumb quality: ", p_test->thumb_quality);
       break;
+    case 'N':
+      p_test->burst_count = (uint32_t)atoi(optarg);
+      fprintf(stderr, "%-25s%u\n", "Burst count: ", p_test->burst_count);
+      break;
     default:;
     }
   }
@@ -601,6 +695,8 @@ static void mm_jpeg_test_print_usage()
   fprintf(stderr, "  -B \t\tBurst mode. Utilize both encoder engines on"
           "supported targets\n");
   fprintf(stderr, "  -M \t\tUse minimum number of output buffers \n");
+  fprintf(stderr, "  -N COUNT\t\tEncode the inputs COUNT times back to back"
+          " and report images/sec\n");
   fprintf(stderr, "\n");
 }
 
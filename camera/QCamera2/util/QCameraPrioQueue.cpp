@@ -0,0 +1,652 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include <sched.h>
+#include <utils/Log.h>
+#include "QCameraPrioQueue.h"
+
+#define Q_NIL 0xFFFFFFFF
+
+namespace qcamera {
+
+/*===========================================================================
+ * FUNCTION   : QCameraPrioQueue
+ *
+ * DESCRIPTION: default constructor of QCameraPrioQueue
+ *
+ * PARAMETERS :
+ *   @capacity : maximum number of nodes in the queue
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCameraPrioQueue::QCameraPrioQueue(uint32_t capacity)
+{
+    construct(NULL, NULL, capacity);
+}
+
+/*===========================================================================
+ * FUNCTION   : QCameraPrioQueue
+ *
+ * DESCRIPTION: constructor of QCameraPrioQueue
+ *
+ * PARAMETERS :
+ *   @data_rel_fn : function ptr to release node data internal resource
+ *   @user_data   : user data ptr
+ *   @capacity    : maximum number of nodes in the queue
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCameraPrioQueue::QCameraPrioQueue(release_data_fn data_rel_fn,
+        void *user_data, uint32_t capacity)
+{
+    construct(data_rel_fn, user_data, capacity);
+}
+
+/*===========================================================================
+ * FUNCTION   : ~QCameraPrioQueue
+ *
+ * DESCRIPTION: deconstructor of QCameraPrioQueue
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCameraPrioQueue::~QCameraPrioQueue()
+{
+    flush();
+    pthread_mutex_destroy(&m_lock);
+    free(m_nodes);
+}
+
+/*===========================================================================
+ * FUNCTION   : construct
+ *
+ * DESCRIPTION: allocates the nodes and puts them all on the free list
+ *
+ * PARAMETERS :
+ *   @data_rel_fn : function ptr to release node data internal resource
+ *   @user_data   : user data ptr
+ *   @capacity    : maximum number of nodes in the queue
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraPrioQueue::construct(release_data_fn data_rel_fn,
+        void *user_data, uint32_t capacity)
+{
+    pthread_mutex_init(&m_lock, NULL);
+    for (int i = 0; i < QCAMERA_QUEUE_PRIO_MAX; i++) {
+        cam_list_init(&m_head[i]);
+        m_inbox[i] = Q_NIL;
+    }
+    m_size = 0;
+    m_dataFn = data_rel_fn;
+    m_userData = user_data;
+    m_active = true;
+    m_pending = 0;
+    m_freeHead = Q_NIL;
+
+    m_nodes = (camera_q_node *)calloc(capacity, sizeof(camera_q_node));
+    if (NULL == m_nodes) {
+        ALOGE("%s: No memory for %u nodes", __func__, capacity);
+        capacity = 0;
+    }
+    m_capacity = capacity;
+    for (uint32_t i = 0; i < capacity; i++) {
+        m_nodes[i].next = (i + 1 < capacity) ? i + 1 : Q_NIL;
+    }
+    if (capacity > 0) {
+        m_freeHead = 0;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : allocNode
+ *
+ * DESCRIPTION: takes a node from the free list, from any thread
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : node ptr. NULL if all nodes are in use.
+ *==========================================================================*/
+QCameraPrioQueue::camera_q_node *QCameraPrioQueue::allocNode()
+{
+    uint64_t head = __atomic_load_n(&m_freeHead, __ATOMIC_ACQUIRE);
+    uint64_t newHead;
+    uint32_t index;
+
+    do {
+        index = (uint32_t)head;
+        if (Q_NIL == index) {
+            return NULL;
+        }
+        /* the tag makes the CAS fail if the node was taken meanwhile */
+        newHead = (((head >> 32) + 1) << 32) |
+            __atomic_load_n(&m_nodes[index].next, __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&m_freeHead, &head, newHead, true,
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    return &m_nodes[index];
+}
+
+/*===========================================================================
+ * FUNCTION   : freeNode
+ *
+ * DESCRIPTION: returns a node to the free list, from any thread
+ *
+ * PARAMETERS :
+ *   @node    : node to be freed, may be NULL
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraPrioQueue::freeNode(camera_q_node *node)
+{
+    uint64_t head, newHead;
+    uint32_t index;
+
+    if (NULL == node) {
+        return;
+    }
+    index = (uint32_t)(node - m_nodes);
+    node->data = NULL;
+
+    head = __atomic_load_n(&m_freeHead, __ATOMIC_RELAXED);
+    do {
+        __atomic_store_n(&node->next, (uint32_t)head, __ATOMIC_RELAXED);
+        newHead = (((head >> 32) + 1) << 32) | index;
+    } while (!__atomic_compare_exchange_n(&m_freeHead, &head, newHead, true,
+            __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/*===========================================================================
+ * FUNCTION   : collect
+ *
+ * DESCRIPTION: moves the nodes pushed by the producers to the tail of the
+ *              list of their level, in enqueue order. Called with m_lock.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraPrioQueue::collect()
+{
+    for (int i = 0; i < QCAMERA_QUEUE_PRIO_MAX; i++) {
+        uint32_t index, next, prev = Q_NIL;
+
+        if (Q_NIL == __atomic_load_n(&m_inbox[i], __ATOMIC_RELAXED)) {
+            continue;
+        }
+
+        /* inbox is newest first, reverse it */
+        index = __atomic_exchange_n(&m_inbox[i], Q_NIL, __ATOMIC_ACQUIRE);
+        while (Q_NIL != index) {
+            next = m_nodes[index].next;
+            m_nodes[index].next = prev;
+            prev = index;
+            index = next;
+        }
+        for (index = prev; Q_NIL != index; index = m_nodes[index].next) {
+            cam_list_add_tail_node(&m_nodes[index].list, &m_head[i]);
+        }
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : first
+ *
+ * DESCRIPTION: returns the node a dequeue would return. Called with m_lock.
+ *
+ * PARAMETERS :
+ *   @bFromHead : if true, the next node to be dequeued
+ *                if false, the last one
+ *
+ * RETURN     : node ptr. NULL if the queue is empty.
+ *==========================================================================*/
+QCameraPrioQueue::camera_q_node *QCameraPrioQueue::first(bool bFromHead)
+{
+    for (int i = 0; i < QCAMERA_QUEUE_PRIO_MAX; i++) {
+        struct cam_list *head =
+            &m_head[bFromHead ? i : QCAMERA_QUEUE_PRIO_MAX - 1 - i];
+        struct cam_list *pos = bFromHead ? head->next : head->prev;
+
+        if (pos != head) {
+            return member_of(pos, camera_q_node, list);
+        }
+    }
+    return NULL;
+}
+
+/*===========================================================================
+ * FUNCTION   : remove
+ *
+ * DESCRIPTION: unlinks a node from its level list. Called with m_lock.
+ *
+ * PARAMETERS :
+ *   @node    : node to be removed
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraPrioQueue::remove(camera_q_node *node)
+{
+    cam_list_del_node(&node->list);
+    __atomic_sub_fetch(&m_size, 1, __ATOMIC_RELAXED);
+}
+
+/*===========================================================================
+ * FUNCTION   : release
+ *
+ * DESCRIPTION: releases the data of a flushed node and frees the node
+ *
+ * PARAMETERS :
+ *   @node    : node removed from the queue
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraPrioQueue::release(camera_q_node *node)
+{
+    if (NULL != node->data) {
+        if (m_dataFn) {
+            m_dataFn(node->data, m_userData);
+        }
+        free(node->data);
+    }
+    freeNode(node);
+}
+
+/*===========================================================================
+ * FUNCTION   : init
+ *
+ * DESCRIPTION: Put the queue to active state (ready to enqueue and dequeue)
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraPrioQueue::init()
+{
+    pthread_mutex_lock(&m_lock);
+    __atomic_store_n(&m_active, true, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&m_lock);
+}
+
+/*===========================================================================
+ * FUNCTION   : isEmpty
+ *
+ * DESCRIPTION: return if the queue is empty or not
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : true -- queue is empty; false -- not empty
+ *==========================================================================*/
+bool QCameraPrioQueue::isEmpty()
+{
+    return getCurrentSize() == 0;
+}
+
+/*===========================================================================
+ * FUNCTION   : getCurrentSize
+ *
+ * DESCRIPTION: return the number of nodes in the queue
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : number of nodes, including the ones being enqueued
+ *==========================================================================*/
+int QCameraPrioQueue::getCurrentSize()
+{
+    return __atomic_load_n(&m_size, __ATOMIC_RELAXED);
+}
+
+/*===========================================================================
+ * FUNCTION   : enqueue
+ *
+ * DESCRIPTION: enqueue data into the queue with normal priority
+ *
+ * PARAMETERS :
+ *   @data    : data to be enqueued
+ *
+ * RETURN     : true -- success; false -- failed
+ *==========================================================================*/
+bool QCameraPrioQueue::enqueue(void *data)
+{
+    return enqueue(data, QCAMERA_QUEUE_PRIO_NORMAL);
+}
+
+/*===========================================================================
+ * FUNCTION   : enqueueWithPriority
+ *
+ * DESCRIPTION: enqueue data into the queue with high priority, it will be
+ *              dequeued before the nodes of lower priority
+ *
+ * PARAMETERS :
+ *   @data    : data to be enqueued
+ *
+ * RETURN     : true -- success; false -- failed
+ *==========================================================================*/
+bool QCameraPrioQueue::enqueueWithPriority(void *data)
+{
+    return enqueue(data, QCAMERA_QUEUE_PRIO_HIGH);
+}
+
+/*===========================================================================
+ * FUNCTION   : enqueue
+ *
+ * DESCRIPTION: enqueue data into the queue. Does not block.
+ *
+ * PARAMETERS :
+ *   @data    : data to be enqueued
+ *   @prio    : priority level
+ *
+ * RETURN     : true -- success; false -- failed
+ *==========================================================================*/
+bool QCameraPrioQueue::enqueue(void *data, qcamera_queue_prio_t prio)
+{
+    camera_q_node *node = NULL;
+    uint32_t index, head;
+    bool rc = false;
+
+    if (((int)prio < QCAMERA_QUEUE_PRIO_HIGH) || (prio >= QCAMERA_QUEUE_PRIO_MAX)) {
+        ALOGE("%s: Invalid priority %d", __func__, prio);
+        return false;
+    }
+
+    /* flush waits for enqueues that saw the queue active */
+    __atomic_add_fetch(&m_pending, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&m_active, __ATOMIC_SEQ_CST)) {
+        node = allocNode();
+        if (NULL == node) {
+            ALOGE("%s: Queue full, %u nodes", __func__, m_capacity);
+        }
+    }
+
+    if (NULL != node) {
+        node->data = data;
+        index = (uint32_t)(node - m_nodes);
+        __atomic_add_fetch(&m_size, 1, __ATOMIC_RELAXED);
+
+        head = __atomic_load_n(&m_inbox[prio], __ATOMIC_RELAXED);
+        do {
+            node->next = head;
+        } while (!__atomic_compare_exchange_n(&m_inbox[prio], &head, index,
+                true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+        rc = true;
+    }
+    __atomic_sub_fetch(&m_pending, 1, __ATOMIC_RELEASE);
+    return rc;
+}
+
+/*===========================================================================
+ * FUNCTION   : peek
+ *
+ * DESCRIPTION: return the head element without removing it
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : data ptr. NULL if not any data in the queue.
+ *==========================================================================*/
+void* QCameraPrioQueue::peek()
+{
+    camera_q_node* node = NULL;
+    void* data = NULL;
+
+    pthread_mutex_lock(&m_lock);
+    if (m_active) {
+        collect();
+        node = first(true);
+        if (NULL != node) {
+            data = node->data;
+        }
+    }
+    pthread_mutex_unlock(&m_lock);
+
+    return data;
+}
+
+/*===========================================================================
+ * FUNCTION   : dequeue
+ *
+ * DESCRIPTION: dequeue data from the queue
+ *
+ * PARAMETERS :
+ *   @bFromHead : if true, dequeue the oldest node of the highest priority
+ *                if false, dequeue the newest node of the lowest priority
+ *
+ * RETURN     : data ptr. NULL if not any data in the queue.
+ *==========================================================================*/
+void* QCameraPrioQueue::dequeue(bool bFromHead)
+{
+    camera_q_node* node = NULL;
+    void* data = NULL;
+
+    pthread_mutex_lock(&m_lock);
+    if (m_active) {
+        collect();
+        node = first(bFromHead);
+        if (NULL != node) {
+            remove(node);
+        }
+    }
+    pthread_mutex_unlock(&m_lock);
+
+    if (NULL != node) {
+        data = node->data;
+        freeNode(node);
+    }
+
+    return data;
+}
+
+/*===========================================================================
+ * FUNCTION   : dequeue
+ *
+ * DESCRIPTION: dequeue the first data matching, in dequeue order
+ *
+ * PARAMETERS :
+ *   @match : matching function callback
+ *   @match_data : the actual data to be matched
+ *
+ * RETURN     : data ptr. NULL if not any data in the queue.
+ *==========================================================================*/
+void* QCameraPrioQueue::dequeue(match_fn_data match, void *match_data)
+{
+    camera_q_node* node = NULL;
+    struct cam_list *head = NULL;
+    struct cam_list *pos = NULL;
+    void* data = NULL;
+
+    if ( NULL == match || NULL == match_data ) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&m_lock);
+    if (m_active) {
+        collect();
+        for (int i = 0; (i < QCAMERA_QUEUE_PRIO_MAX) && (NULL == data); i++) {
+            head = &m_head[i];
+            for (pos = head->next; pos != head; pos = pos->next) {
+                node = member_of(pos, camera_q_node, list);
+                if ( match(node->data, m_userData, match_data) ) {
+                    remove(node);
+                    data = node->data;
+                    freeNode(node);
+                    break;
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&m_lock);
+    return data;
+}
+
+/*===========================================================================
+ * FUNCTION   : dequeueBatch
+ *
+ * DESCRIPTION: dequeue up to max data from the queue in one lock
+ *
+ * PARAMETERS :
+ *   @data    : array receiving the data ptrs, in dequeue order
+ *   @max     : size of the array
+ *
+ * RETURN     : number of data dequeued
+ *==========================================================================*/
+int QCameraPrioQueue::dequeueBatch(void **data, int max)
+{
+    camera_q_node* node = NULL;
+    int count = 0;
+
+    if (NULL == data) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&m_lock);
+    if (m_active) {
+        collect();
+        while ((count < max) && (NULL != (node = first(true)))) {
+            remove(node);
+            data[count++] = node->data;
+            freeNode(node);
+        }
+    }
+    pthread_mutex_unlock(&m_lock);
+    return count;
+}
+
+/*===========================================================================
+ * FUNCTION   : flush
+ *
+ * DESCRIPTION: flush all nodes from the queue, queue will be empty after this
+ *              operation.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraPrioQueue::flush()
+{
+    camera_q_node* node = NULL;
+
+    pthread_mutex_lock(&m_lock);
+    if (m_active) {
+        /* no new enqueue after this; wait for the ones in progress */
+        __atomic_store_n(&m_active, false, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&m_pending, __ATOMIC_SEQ_CST)) {
+            sched_yield();
+        }
+
+        collect();
+        while (NULL != (node = first(true))) {
+            remove(node);
+            release(node);
+        }
+        __atomic_store_n(&m_size, 0, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&m_lock);
+}
+
+/*===========================================================================
+ * FUNCTION   : flushNodes
+ *
+ * DESCRIPTION: flush only specific nodes, depending on
+ *              the given matching function.
+ *
+ * PARAMETERS :
+ *   @match   : matching function
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraPrioQueue::flushNodes(match_fn match)
+{
+    camera_q_node* node = NULL;
+    struct cam_list *head = NULL;
+    struct cam_list *pos = NULL;
+
+    if ( NULL == match ) {
+        return;
+    }
+
+    pthread_mutex_lock(&m_lock);
+    if (m_active) {
+        collect();
+        for (int i = 0; i < QCAMERA_QUEUE_PRIO_MAX; i++) {
+            head = &m_head[i];
+            pos = head->next;
+            while (pos != head) {
+                node = member_of(pos, camera_q_node, list);
+                pos = pos->next;
+                if ( match(node->data, m_userData) ) {
+                    remove(node);
+                    release(node);
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&m_lock);
+}
+
+/*===========================================================================
+ * FUNCTION   : flushNodes
+ *
+ * DESCRIPTION: flush only specific nodes, depending on
+ *              the given matching function.
+ *
+ * PARAMETERS :
+ *   @match   : matching function
+ *   @match_data : the actual data to be matched
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraPrioQueue::flushNodes(match_fn_data match, void *match_data)
+{
+    camera_q_node* node = NULL;
+    struct cam_list *head = NULL;
+    struct cam_list *pos = NULL;
+
+    if ( NULL == match ) {
+        return;
+    }
+
+    pthread_mutex_lock(&m_lock);
+    if (m_active) {
+        collect();
+        for (int i = 0; i < QCAMERA_QUEUE_PRIO_MAX; i++) {
+            head = &m_head[i];
+            pos = head->next;
+            while (pos != head) {
+                node = member_of(pos, camera_q_node, list);
+                pos = pos->next;
+                if ( match(node->data, m_userData, match_data) ) {
+                    remove(node);
+                    release(node);
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&m_lock);
+}
+
+}; // namespace qcamera
@@ -0,0 +1,116 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __QCAMERA_PRIO_QUEUE_H__
+#define __QCAMERA_PRIO_QUEUE_H__
+
+#include <pthread.h>
+#include <stdint.h>
+#include "cam_list.h"
+#include "QCameraQueue.h"
+
+namespace qcamera {
+
+/* Priority levels, dequeued in this order */
+typedef enum {
+    QCAMERA_QUEUE_PRIO_HIGH,
+    QCAMERA_QUEUE_PRIO_NORMAL,
+    QCAMERA_QUEUE_PRIO_LOW,
+    QCAMERA_QUEUE_PRIO_MAX
+} qcamera_queue_prio_t;
+
+#define QCAMERA_PRIO_QUEUE_DEFAULT_SIZE 128
+
+/*
+ * Bounded queue with priority levels, for many producers and one consumer.
+ *
+ * All nodes are allocated at construction. Producers take a node from a
+ * lock free free list and push it on the inbox of its level without
+ * taking any lock. Dequeue, peek, match and flush calls serialize on a
+ * mutex and move the inboxes into per level FIFO lists first, so they may
+ * be called from any thread, as with QCameraQueue.
+ *
+ * Nodes are dequeued from the highest level first, in enqueue order within
+ * a level. Unlike QCameraQueue, enqueueWithPriority is FIFO among
+ * priority nodes. Enqueue fails once capacity nodes are queued.
+ */
+class QCameraPrioQueue {
+public:
+    QCameraPrioQueue(uint32_t capacity = QCAMERA_PRIO_QUEUE_DEFAULT_SIZE);
+    QCameraPrioQueue(release_data_fn data_rel_fn, void *user_data,
+            uint32_t capacity = QCAMERA_PRIO_QUEUE_DEFAULT_SIZE);
+    virtual ~QCameraPrioQueue();
+    void init();
+    bool enqueue(void *data);
+    bool enqueue(void *data, qcamera_queue_prio_t prio);
+    bool enqueueWithPriority(void *data);
+    /* This call will put queue into uninitialized state.
+     * Need to call init() in order to use the queue again */
+    void flush();
+    void flushNodes(match_fn match);
+    void flushNodes(match_fn_data match, void *spec_data);
+    void* dequeue(bool bFromHead = true);
+    void* dequeue(match_fn_data match, void *spec_data);
+    int dequeueBatch(void **data, int max);
+    void* peek();
+    bool isEmpty();
+    int getCurrentSize();
+    uint32_t getCapacity() {return m_capacity;}
+private:
+    typedef struct {
+        struct cam_list list;   // position in its level list, consumer side
+        uint32_t next;          // next node in the inbox or the free list
+        void* data;
+    } camera_q_node;
+
+    void construct(release_data_fn data_rel_fn, void *user_data,
+            uint32_t capacity);
+    camera_q_node *allocNode();
+    void freeNode(camera_q_node *node);
+    void collect();
+    camera_q_node *first(bool bFromHead);
+    void remove(camera_q_node *node);
+    void release(camera_q_node *node);
+
+    camera_q_node *m_nodes;
+    uint32_t m_capacity;
+    uint64_t m_freeHead;                        // tag << 32 | index
+    uint32_t m_inbox[QCAMERA_QUEUE_PRIO_MAX];   // LIFO, taken whole
+    struct cam_list m_head[QCAMERA_QUEUE_PRIO_MAX];
+    int32_t m_size;
+    uint32_t m_active;
+    uint32_t m_pending;                         // enqueues in progress
+    pthread_mutex_t m_lock;
+    release_data_fn m_dataFn;
+    void * m_userData;
+};
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA_PRIO_QUEUE_H__ */
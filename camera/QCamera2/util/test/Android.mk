@@ -0,0 +1,21 @@
+#callback queue latency benchmark, runs on the build host
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS += -Wall -Wextra -Werror
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../../stack/common
+
+LOCAL_SRC_FILES := qcamera_queue_bench.cpp \
+        ../QCameraQueue.cpp \
+        ../QCameraPrioQueue.cpp
+
+LOCAL_MODULE           := qcamera-queue-bench
+LOCAL_HEADER_LIBRARIES := libutils_headers
+LOCAL_SHARED_LIBRARIES := liblog
+LOCAL_LDLIBS           := -lpthread
+
+include $(BUILD_HOST_EXECUTABLE)
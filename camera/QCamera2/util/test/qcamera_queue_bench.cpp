@@ -0,0 +1,316 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Host benchmark of the HAL callback queues. Producer threads post frame
+ * notifications at a preview rate to a consumer woken the way
+ * QCameraCmdThread wakes its thread, through QCameraQueue and through
+ * QCameraPrioQueue, and the enqueue to dequeue latency is reported. A
+ * burst run without pacing gives the throughput. The QCameraPrioQueue
+ * ordering, match, flush and bound are checked first.
+ *
+ * usage: qcamera-queue-bench [fps] [frames] [producers]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cam_semaphore.h"
+#include "QCameraQueue.h"
+#include "QCameraPrioQueue.h"
+
+using namespace qcamera;
+
+#define MAX_PRODUCERS 8
+
+typedef struct {
+    uint64_t stamp;
+    int producer;
+    int seq;
+} bench_msg_t;
+
+static int g_failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static bool match_odd(void *data, void *)
+{
+    return ((bench_msg_t *)data)->seq & 1;
+}
+
+static bool match_seq(void *data, void *, void *match_data)
+{
+    return ((bench_msg_t *)data)->seq == *(int *)match_data;
+}
+
+static void check_prio_queue(void)
+{
+    QCameraPrioQueue q(8);
+    bench_msg_t *m[10];
+    void *out[8];
+    int i, n, seq;
+
+    for (i = 0; i < 10; i++) {
+        m[i] = (bench_msg_t *)calloc(1, sizeof(bench_msg_t));
+        m[i]->seq = i;
+    }
+
+    /* levels first, FIFO within a level */
+    CHECK(q.enqueue(m[0], QCAMERA_QUEUE_PRIO_LOW));
+    CHECK(q.enqueue(m[1]));
+    CHECK(q.enqueueWithPriority(m[2]));
+    CHECK(q.enqueue(m[3]));
+    CHECK(q.enqueueWithPriority(m[4]));
+    CHECK(q.getCurrentSize() == 5);
+    CHECK(q.peek() == m[2]);
+    CHECK(q.dequeue(false) == m[0]);
+    n = q.dequeueBatch(out, 8);
+    CHECK(n == 4 && out[0] == m[2] && out[1] == m[4] &&
+          out[2] == m[1] && out[3] == m[3]);
+    CHECK(q.isEmpty() && q.dequeue() == NULL);
+
+    /* bounded */
+    for (i = 0; i < 8; i++) {
+        CHECK(q.enqueue(m[i]));
+    }
+    CHECK(!q.enqueue(m[8]));
+    seq = 5;
+    CHECK(q.dequeue(match_seq, &seq) == m[5]);
+    CHECK(q.enqueue(m[8], QCAMERA_QUEUE_PRIO_HIGH));
+    CHECK(q.dequeue() == m[8]);
+
+    /* flushNodes frees the data it drops */
+    q.flushNodes(match_odd);
+    CHECK(q.getCurrentSize() == 4);
+    for (i = 0; i < 8; i += 2) {
+        CHECK(q.dequeue() == m[i]);
+    }
+    for (i = 1; i < 8; i += 2) {
+        if (i != 5) {
+            m[i] = NULL;
+        }
+    }
+
+    /* flush frees the rest and rejects enqueue until init */
+    CHECK(q.enqueue(m[0]));
+    q.flush();
+    m[0] = NULL;
+    CHECK(!q.enqueue(m[2]));
+    q.init();
+    CHECK(q.enqueue(m[2]) && q.dequeue() == m[2]);
+
+    for (i = 0; i < 10; i++) {
+        free(m[i]);
+    }
+}
+
+template <class Q>
+struct bench_ctx {
+    Q *q;
+    cam_semaphore_t sem;
+    int fps;
+    int frames;
+    int producers;
+    bench_msg_t *msgs;
+    uint32_t *latUs;
+    int received;
+    int orderErrors;
+};
+
+template <class Q>
+static void *producer_routine(void *arg)
+{
+    void **a = (void **)arg;
+    bench_ctx<Q> *ctx = (bench_ctx<Q> *)a[0];
+    int id = (int)(intptr_t)a[1];
+    struct timespec next;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (int i = 0; i < ctx->frames; i++) {
+        bench_msg_t *msg = &ctx->msgs[id * ctx->frames + i];
+
+        if (ctx->fps > 0) {
+            /* spread the producers over the frame period */
+            next.tv_nsec += 1000000000L / ctx->fps;
+            while (next.tv_nsec >= 1000000000L) {
+                next.tv_nsec -= 1000000000L;
+                next.tv_sec++;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        }
+        msg->producer = id;
+        msg->seq = i;
+        msg->stamp = now_ns();
+        while (!ctx->q->enqueue(msg)) {
+            sched_yield();
+        }
+        cam_sem_post(&ctx->sem);
+    }
+    return NULL;
+}
+
+template <class Q>
+static void *consumer_routine(void *arg)
+{
+    bench_ctx<Q> *ctx = (bench_ctx<Q> *)arg;
+    int total = ctx->frames * ctx->producers;
+    int last[MAX_PRODUCERS];
+
+    for (int i = 0; i < MAX_PRODUCERS; i++) {
+        last[i] = -1;
+    }
+    while (ctx->received < total) {
+        cam_sem_wait(&ctx->sem);
+        bench_msg_t *msg = (bench_msg_t *)ctx->q->dequeue();
+        if (NULL == msg) {
+            continue;
+        }
+        ctx->latUs[ctx->received++] =
+            (uint32_t)((now_ns() - msg->stamp) / 1000);
+        if (msg->seq != last[msg->producer] + 1) {
+            ctx->orderErrors++;
+        }
+        last[msg->producer] = msg->seq;
+    }
+    return NULL;
+}
+
+template <class Q>
+static Q *new_queue(int capacity);
+
+template <>
+QCameraQueue *new_queue<QCameraQueue>(int)
+{
+    return new QCameraQueue();
+}
+
+/* sized for the whole run so that the burst measures the queue, not the
+ * producers spinning on a full queue */
+template <>
+QCameraPrioQueue *new_queue<QCameraPrioQueue>(int capacity)
+{
+    return new QCameraPrioQueue(capacity);
+}
+
+template <class Q>
+static void run(const char *name, int fps, int frames, int producers)
+{
+    bench_ctx<Q> ctx;
+    pthread_t cons, prod[MAX_PRODUCERS];
+    void *args[MAX_PRODUCERS][2];
+    int total = frames * producers;
+    uint64_t start, elapsed;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.q = new_queue<Q>(total);
+    ctx.fps = fps;
+    ctx.frames = frames;
+    ctx.producers = producers;
+    ctx.msgs = (bench_msg_t *)calloc(total, sizeof(bench_msg_t));
+    ctx.latUs = (uint32_t *)calloc(total, sizeof(uint32_t));
+    if (!ctx.msgs || !ctx.latUs) {
+        printf("out of memory\n");
+        exit(1);
+    }
+    cam_sem_init(&ctx.sem, 0);
+
+    start = now_ns();
+    pthread_create(&cons, NULL, consumer_routine<Q>, &ctx);
+    for (int i = 0; i < producers; i++) {
+        args[i][0] = &ctx;
+        args[i][1] = (void *)(intptr_t)i;
+        pthread_create(&prod[i], NULL, producer_routine<Q>, args[i]);
+    }
+    for (int i = 0; i < producers; i++) {
+        pthread_join(prod[i], NULL);
+    }
+    pthread_join(cons, NULL);
+    elapsed = now_ns() - start;
+
+    qsort(ctx.latUs, total, sizeof(uint32_t), cmp_u32);
+    printf("%-24s %6d %8u %8u %8u %10.0f\n", name, total,
+           ctx.latUs[total / 2], ctx.latUs[total * 99 / 100],
+           ctx.latUs[total - 1], total * 1e9 / elapsed);
+    CHECK(ctx.received == total);
+    CHECK(ctx.orderErrors == 0);
+
+    cam_sem_destroy(&ctx.sem);
+    delete ctx.q;
+    free(ctx.msgs);
+    free(ctx.latUs);
+}
+
+int main(int argc, char **argv)
+{
+    int fps = argc > 1 ? atoi(argv[1]) : 120;
+    int frames = argc > 2 ? atoi(argv[2]) : 240;
+    int producers = argc > 3 ? atoi(argv[3]) : 3;
+
+    if (frames < 1) {
+        frames = 1;
+    }
+    if (producers < 1 || producers > MAX_PRODUCERS) {
+        producers = 3;
+    }
+
+    check_prio_queue();
+
+    printf("%d producers, %d frames each at %d fps, then unpaced\n",
+           producers, frames, fps);
+    printf("%-24s %6s %8s %8s %8s %10s\n",
+           "queue", "msgs", "p50 us", "p99 us", "max us", "msgs/s");
+    run<QCameraQueue>("QCameraQueue", fps, frames, producers);
+    run<QCameraPrioQueue>("QCameraPrioQueue", fps, frames, producers);
+    run<QCameraQueue>("QCameraQueue/burst", 0, frames * 20, producers);
+    run<QCameraPrioQueue>("QCameraPrioQueue/burst", 0, frames * 20, producers);
+
+    printf("%s\n", g_failures ? "FAILED" : "PASSED");
+    return g_failures ? 1 : 0;
+}
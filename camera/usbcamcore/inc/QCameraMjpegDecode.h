@@ -29,10 +29,47 @@
 #ifndef __QCAMERA_MJPEG_DECODE_H
 #define __QCAMERA_MJPEG_DECODE_H
 
+#include <stdint.h>
+
 typedef int MJPEGD_ERR;
 #define MJPEGD_NO_ERROR          0
 #define MJPEGD_ERROR            -1
 #define MJPEGD_INSUFFICIENT_MEM -2
+#define MJPEGD_NO_FRAME         -3
+
+/* Frames submitted and not yet decoded. When a new frame finds this many */
+/* in flight, the oldest one still waiting for the decoder is dropped.   */
+#define MJPEGD_MAX_INFLIGHT     2
+
+/* Completion status of a submitted frame */
+#define MJPEGD_FRAME_DECODED    0
+#define MJPEGD_FRAME_DROPPED    1
+#define MJPEGD_FRAME_FAILED     2
+
+typedef struct {
+    char*       mjpegBuffer;
+    int         mjpegBufferSize;
+    char*       outputYptr;
+    char*       outputUVptr;
+    int         outputFormat;
+    /* Opaque to the decoder, handed back on completion */
+    int         cookie;
+    /* Set on completion, one of MJPEGD_FRAME_* */
+    int         status;
+} mjpegd_frame_t;
+
+typedef struct {
+    uint32_t    submitted;
+    uint32_t    decoded;
+    uint32_t    dropped;
+    uint32_t    failed;
+    /* Decoded frames per second over the last full second */
+    float       fps;
+    /* Submit to completion, and time spent in the decoder */
+    uint32_t    avgLatencyUs;
+    uint32_t    maxLatencyUs;
+    uint32_t    avgDecodeUs;
+} mjpegd_stats_t;
 
 MJPEGD_ERR mjpegDecoderInit(void**);
 
@@ -46,4 +83,27 @@ MJPEGD_ERR mjpegDecode(
             char*   outputUVptr,
             int     outputFormat);
 
+/*
+ * Queues a frame for decoding and returns without waiting. Completed
+ * frames, dropped ones included, are returned by mjpegDecodeGetDone in
+ * submission order. Fails if MJPEGD_MAX_INFLIGHT * 2 frames are waiting
+ * to be collected.
+ */
+MJPEGD_ERR mjpegDecodeSubmit(void* mjpegd, const mjpegd_frame_t* frame);
+
+/*
+ * Returns the oldest submitted frame once it is complete. timeoutMs 0
+ * polls, a negative value waits forever. MJPEGD_NO_FRAME if none is ready.
+ */
+MJPEGD_ERR mjpegDecodeGetDone(void* mjpegd, mjpegd_frame_t* frame,
+                              int timeoutMs);
+
+/*
+ * Drops the frames still waiting for the decoder and waits for the one
+ * being decoded. All frames can then be collected without blocking.
+ */
+MJPEGD_ERR mjpegDecodeFlush(void* mjpegd);
+
+MJPEGD_ERR mjpegDecoderGetStats(void* mjpegd, mjpegd_stats_t* stats);
+
 #endif /* __QCAMERA_MJPEG_DECODE_H */
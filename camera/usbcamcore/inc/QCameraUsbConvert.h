@@ -0,0 +1,94 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __QCAMERA_USB_CONVERT_H
+#define __QCAMERA_USB_CONVERT_H
+
+typedef int USBCAM_CONV_ERR;
+#define USBCAM_CONV_NO_ERROR        0
+#define USBCAM_CONV_ERROR          -1
+#define USBCAM_CONV_INSUFFICIENT_MEM -2
+
+/* Output layouts of the YUYV conversion, both with a 4:2:0 chroma plane */
+#define USBCAM_CONV_OUT_NV12        0   /* Y plane followed by UVUV... */
+#define USBCAM_CONV_OUT_NV21        1   /* Y plane followed by VUVU... */
+
+/* Maximum number of helper threads of a converter object */
+#define USBCAM_CONV_MAX_THREADS     4
+
+/* Frames smaller than this are converted on the calling thread only */
+#define USBCAM_CONV_MT_MIN_PIXELS   (1280 * 720)
+
+/*
+ * Creates a converter object with numThreads helper threads. Frames of at
+ * least USBCAM_CONV_MT_MIN_PIXELS are split in bands of rows between the
+ * helpers and the calling thread. numThreads of 0 creates no threads.
+ */
+USBCAM_CONV_ERR usbCamConvertInit(void** conv_obj, int numThreads);
+
+USBCAM_CONV_ERR usbCamConvertDestroy(void* conv_obj);
+
+/*
+ * Converts a packed YUYV frame of wd x ht pixels into a semi-planar 4:2:0
+ * frame. The chroma plane starts at out_buf + wd * ht and is sampled from
+ * the even rows of the input. wd must be even; in-place conversion is not
+ * supported. conv_obj may be NULL to convert on the calling thread.
+ */
+USBCAM_CONV_ERR usbCamConvertYUYV(
+            void*       conv_obj,
+            const char* in_buf,
+            char*       out_buf,
+            int         wd,
+            int         ht,
+            int         outputFormat);
+
+/*
+ * Converts a NV12 frame of wd x ht pixels into NV21 by swapping the chroma
+ * bytes of each pair. in_buf may equal out_buf, in which case the luma
+ * plane is left untouched and only the chroma plane is rewritten.
+ */
+USBCAM_CONV_ERR usbCamConvertNV12toNV21(
+            const char* in_buf,
+            char*       out_buf,
+            int         wd,
+            int         ht);
+
+/*
+ * Converts rows [rowStart, rowEnd) of a frame on the calling thread.
+ * rowStart must be even. Exposed for the conversion test.
+ */
+USBCAM_CONV_ERR usbCamConvertYUYVRows(
+            const char* in_buf,
+            char*       out_buf,
+            int         wd,
+            int         ht,
+            int         rowStart,
+            int         rowEnd,
+            int         outputFormat);
+
+#endif /* __QCAMERA_USB_CONVERT_H */
@@ -35,7 +35,8 @@ namespace android {
 #define FILENAME_LENGTH     (256)
 
 /* Number of display buffers (in addition to minimum number of undequed buffers */
-#define PRVW_DISP_BUF_CNT   2
+/* MJPEG preview holds MJPEGD_MAX_INFLIGHT of them while decoding plus 1     */
+#define PRVW_DISP_BUF_CNT   3
 
 /* Number of V4L2 capture  buffers. */
 #define PRVW_CAP_BUF_CNT    4
@@ -43,11 +44,22 @@ namespace android {
 /* Maximum buffer size for JPEG output in number of bytes */
 #define MAX_JPEG_BUFFER_SIZE    (1024 * 1024)
 
+/* Helper threads converting YUYV frames of 720p and above */
+#define USB_CAM_CONV_THREADS    2
+
 /* Preview loop commands */
 #define USB_CAM_PREVIEW_EXIT    (0x100)
 #define USB_CAM_PREVIEW_PAUSE   (0x101)
 #define USB_CAM_PREVIEW_TAKEPIC (0x200)
 
+/******************************************************************************
+ * Macro function to check if the camera captures straight into the display
+ * buffers (V4L2 DMABUF or USERPTR memory) instead of its own mmap buffers
+ *****************************************************************************/
+#define USB_CAM_CAPTURE_TO_DISPLAY(camHal)    \
+    ((V4L2_MEMORY_DMABUF == (camHal)->captureMemory) || \
+     (V4L2_MEMORY_USERPTR == (camHal)->captureMemory))
+
 /******************************************************************************
  * Macro function to input validate device handle
  *****************************************************************************/
@@ -127,6 +139,14 @@ struct bufObj {
     int     len;
 };
 
+/* Time spent moving preview frames from capture to display buffers */
+typedef struct {
+    uint32_t    frames;
+    uint32_t    lastUs;
+    uint32_t    maxUs;
+    uint64_t    totalUs;
+} usbcam_xfer_stats_t;
+
 typedef struct {
     camera_device                       hw_dev;
     Mutex                               lock;
@@ -157,6 +177,12 @@ typedef struct {
     unsigned int                        n_buffers;
     struct v4l2_buffer                  curCaptureBuf;
     struct bufObj                       *buffers;
+    /* V4L2 memory type of the capture buffers. For DMABUF and USERPTR */
+    /* the capture buffers are the display buffers of previewMem       */
+    int                                 captureMemory;
+    /* Display buffers currently queued to the camera, bit per buffer id */
+    uint32_t                            capBufQueued;
+    usbcam_xfer_stats_t                 prvwXferStats;
 
     /* Display related members */
     preview_stream_ops*                 window;
@@ -170,6 +196,9 @@ typedef struct {
     /* MJPEG decoder object */
     void*                               mjpegd;
 
+    /* YUYV to NV21 converter object */
+    void*                               yuyvConv;
+
     /* JPEG picture and thumbnail related members */
     int                                 pictFormat;
     int                                 pictWidth;
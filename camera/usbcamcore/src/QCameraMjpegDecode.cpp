@@ -33,6 +33,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <pthread.h>
 
 extern "C" {
@@ -111,7 +113,6 @@ typedef struct
 
 } thread_ctrl_blk_t;
 
-OS_THREAD_FUNC_RET_T OS_THREAD_FUNC_MODIFIER decoder_test(OS_THREAD_FUNC_ARG_T p_thread_args);
 void decoder_event_handler(void        *p_user_data,
                            jpeg_event_t event,
                            void        *p_arg);
@@ -129,24 +130,158 @@ static int mjpegd_timer_start(timespec *p_timer);
 static int mjpegd_timer_get_elapsed(timespec *p_timer, int *elapsed_in_ms, uint8_t reset_start);
 static int mjpegd_cond_timedwait(pthread_cond_t *p_cond, pthread_mutex_t *p_mutex, uint32_t ms);
 
-// Global variables
-/* TBDJ: can be removed */
-thread_ctrl_blk_t *thread_ctrl_blks = NULL;
+#define MJPEGD_QUEUE_SIZE       (2 * MJPEGD_MAX_INFLIGHT)
+
+/* Slot states of a submitted frame */
+#define MJPEGD_SLOT_FREE        0
+#define MJPEGD_SLOT_PENDING     1
+#define MJPEGD_SLOT_RUNNING     2
+#define MJPEGD_SLOT_DONE        3
+
+typedef struct
+{
+    int                 state;
+    uint32_t            submitUs;
+    mjpegd_frame_t      frame;
+} mjpegd_slot_t;
+
+/*
+ * Decoder object. One worker thread owns the jpeg decoder for the life of
+ * the object and decodes the submitted frames one at a time, oldest first.
+ * Slots form a ring in submission order, so frames complete in order.
+ */
+typedef struct
+{
+    /* Parameters of the frame being decoded, read by the callbacks */
+    test_args_t         args;
+    thread_ctrl_blk_t   blk;
+    jpegd_src_t         source;
+    int                 decoderReady;
+
+    pthread_t           thread;
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    int                 exit;
+
+    mjpegd_slot_t       slots[MJPEGD_QUEUE_SIZE];
+    int                 head;
+    int                 count;
+
+    mjpegd_stats_t      stats;
+    uint64_t            totalLatencyUs;
+    uint64_t            totalDecodeUs;
+    uint32_t            fpsWindowStartUs;
+    uint32_t            fpsWindowFrames;
+} mjpegd_obj_t;
+
+static int decoder_setup(thread_ctrl_blk_t *p_thread_arg, jpegd_src_t *source);
+static int decoder_decode_frame(thread_ctrl_blk_t *p_thread_arg,
+                                jpegd_src_t *source);
+static void decoder_teardown(thread_ctrl_blk_t *p_thread_arg,
+                             jpegd_src_t *source);
+
+static uint32_t mjpegd_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000LL + ts.tv_nsec / 1000);
+}
+
+static mjpegd_slot_t *mjpegd_slot(mjpegd_obj_t *obj, int pos)
+{
+    return &obj->slots[(obj->head + pos) % MJPEGD_QUEUE_SIZE];
+}
+
+/*
+ * Decoder thread: decodes the oldest pending frame until asked to exit
+ */
+static void *mjpegd_worker(void *data)
+{
+    mjpegd_obj_t *obj = (mjpegd_obj_t *)data;
+    mjpegd_slot_t *slot;
+    uint32_t start, now;
+    int i, rc;
+
+    obj->decoderReady = !decoder_setup(&obj->blk, &obj->source);
+    if(!obj->decoderReady)
+        ALOGE("%s: decoder setup failed, frames will fail", __func__);
+
+    pthread_mutex_lock(&obj->lock);
+    while(1) {
+        slot = NULL;
+        for(i = 0; i < obj->count && !slot; i++)
+            if(MJPEGD_SLOT_PENDING == mjpegd_slot(obj, i)->state)
+                slot = mjpegd_slot(obj, i);
+        if(!slot) {
+            if(obj->exit)
+                break;
+            pthread_cond_wait(&obj->cond, &obj->lock);
+            continue;
+        }
+
+        slot->state = MJPEGD_SLOT_RUNNING;
+        obj->args.inputMjpegBuffer      = slot->frame.mjpegBuffer;
+        obj->args.inputMjpegBufferSize  = slot->frame.mjpegBufferSize;
+        obj->args.outputYptr            = slot->frame.outputYptr;
+        obj->args.outputUVptr           = slot->frame.outputUVptr;
+        obj->args.format                = slot->frame.outputFormat;
+        pthread_mutex_unlock(&obj->lock);
+
+        start = mjpegd_time_us();
+        rc = obj->decoderReady ?
+            decoder_decode_frame(&obj->blk, &obj->source) : 1;
+        now = mjpegd_time_us();
+
+        pthread_mutex_lock(&obj->lock);
+        slot->state = MJPEGD_SLOT_DONE;
+        if(rc) {
+            slot->frame.status = MJPEGD_FRAME_FAILED;
+            obj->stats.failed++;
+        } else {
+            uint32_t latency = now - slot->submitUs;
+
+            slot->frame.status = MJPEGD_FRAME_DECODED;
+            obj->stats.decoded++;
+            obj->totalLatencyUs += latency;
+            obj->totalDecodeUs  += now - start;
+            if(latency > obj->stats.maxLatencyUs)
+                obj->stats.maxLatencyUs = latency;
+
+            if(!obj->fpsWindowFrames++)
+                obj->fpsWindowStartUs = now;
+            if(now - obj->fpsWindowStartUs >= 1000000) {
+                obj->stats.fps = (obj->fpsWindowFrames - 1) * 1000000.0f /
+                    (now - obj->fpsWindowStartUs);
+                obj->fpsWindowFrames = 1;
+                obj->fpsWindowStartUs = now;
+            }
+        }
+        pthread_cond_broadcast(&obj->cond);
+    }
+    pthread_mutex_unlock(&obj->lock);
+
+    if(obj->decoderReady)
+        decoder_teardown(&obj->blk, &obj->source);
+    return NULL;
+}
 
 /*
  * This function initializes the mjpeg decoder and returns the object
  */
 MJPEGD_ERR mjpegDecoderInit(void** mjpegd_obj)
 {
+    mjpegd_obj_t* obj;
     test_args_t* mjpegd;
 
     ALOGD("%s: E", __func__);
 
-    mjpegd = (test_args_t *)malloc(sizeof(test_args_t));
-    if(!mjpegd)
+    obj = (mjpegd_obj_t *)malloc(sizeof(mjpegd_obj_t));
+    if(!obj)
         return MJPEGD_INSUFFICIENT_MEM;
 
-    memset(mjpegd, 0, sizeof(test_args_t));
+    memset(obj, 0, sizeof(mjpegd_obj_t));
+    mjpegd = &obj->args;
 
     /* Defaults */
     /* Due to current limitation, s/w decoder is selected always */
@@ -161,12 +296,187 @@ MJPEGD_ERR mjpegDecoderInit(void** mjpegd_obj)
     mjpegd->height                = 480;
     mjpegd->abort_time            = 0;
 
-    *mjpegd_obj = (void *)mjpegd;
+    obj->blk.p_args = mjpegd;
+    os_mutex_init(&obj->blk.mutex);
+    os_cond_init(&obj->blk.cond);
+    pthread_mutex_init(&obj->lock, NULL);
+    pthread_cond_init(&obj->cond, NULL);
+
+    if(pthread_create(&obj->thread, NULL, mjpegd_worker, obj)) {
+        ALOGE("%s: failed to create the decoder thread", __func__);
+        pthread_cond_destroy(&obj->cond);
+        pthread_mutex_destroy(&obj->lock);
+        pthread_cond_destroy(&obj->blk.cond);
+        pthread_mutex_destroy(&obj->blk.mutex);
+        free(obj);
+        return MJPEGD_ERROR;
+    }
+
+    *mjpegd_obj = (void *)obj;
 
     ALOGD("%s: X", __func__);
     return  MJPEGD_NO_ERROR;
 }
 
+/*
+ * This function stops the decoder thread and frees the object. Frames not
+ * collected yet are discarded.
+ */
+MJPEGD_ERR mjpegDecoderDestroy(void* mjpegd_obj)
+{
+    mjpegd_obj_t* obj = (mjpegd_obj_t*) mjpegd_obj;
+
+    if(!obj)
+        return MJPEGD_ERROR;
+
+    mjpegDecodeFlush(obj);
+
+    pthread_mutex_lock(&obj->lock);
+    obj->exit = 1;
+    pthread_cond_broadcast(&obj->cond);
+    pthread_mutex_unlock(&obj->lock);
+    pthread_join(obj->thread, NULL);
+
+    pthread_cond_destroy(&obj->cond);
+    pthread_mutex_destroy(&obj->lock);
+    pthread_cond_destroy(&obj->blk.cond);
+    pthread_mutex_destroy(&obj->blk.mutex);
+    free(obj);
+    return MJPEGD_NO_ERROR;
+}
+
+MJPEGD_ERR mjpegDecodeSubmit(void* mjpegd_obj, const mjpegd_frame_t* frame)
+{
+    mjpegd_obj_t* obj = (mjpegd_obj_t*) mjpegd_obj;
+    mjpegd_slot_t *slot, *oldest = NULL;
+    int i, inflight = 0;
+
+    if(!obj || !frame)
+        return MJPEGD_ERROR;
+
+    // check the formats
+    if (((frame->outputFormat == YCRCBLP_H1V2) || (frame->outputFormat == YCBCRLP_H1V2) ||
+      (frame->outputFormat == YCRCBLP_H1V1) || (frame->outputFormat == YCBCRLP_H1V1)) &&
+      !(obj->args.preference == JPEG_DECODER_PREF_HW_ACCELERATED_ONLY)) {
+        ALOGE("%s:These formats are not supported by SW format %d", __func__, frame->outputFormat);
+        return MJPEGD_ERROR;
+    }
+
+    pthread_mutex_lock(&obj->lock);
+    if(obj->count == MJPEGD_QUEUE_SIZE) {
+        pthread_mutex_unlock(&obj->lock);
+        ALOGE("%s: %d frames not collected", __func__, MJPEGD_QUEUE_SIZE);
+        return MJPEGD_ERROR;
+    }
+
+    /* Decoder behind: drop the oldest frame it has not started on */
+    for(i = 0; i < obj->count; i++) {
+        slot = mjpegd_slot(obj, i);
+        if(MJPEGD_SLOT_PENDING == slot->state && !oldest)
+            oldest = slot;
+        if(MJPEGD_SLOT_PENDING == slot->state ||
+           MJPEGD_SLOT_RUNNING == slot->state)
+            inflight++;
+    }
+    if(inflight >= MJPEGD_MAX_INFLIGHT && oldest) {
+        oldest->state           = MJPEGD_SLOT_DONE;
+        oldest->frame.status    = MJPEGD_FRAME_DROPPED;
+        obj->stats.dropped++;
+    }
+
+    slot = mjpegd_slot(obj, obj->count++);
+    slot->state     = MJPEGD_SLOT_PENDING;
+    slot->submitUs  = mjpegd_time_us();
+    slot->frame     = *frame;
+    obj->stats.submitted++;
+    pthread_cond_broadcast(&obj->cond);
+    pthread_mutex_unlock(&obj->lock);
+
+    return MJPEGD_NO_ERROR;
+}
+
+MJPEGD_ERR mjpegDecodeGetDone(void* mjpegd_obj, mjpegd_frame_t* frame,
+                              int timeoutMs)
+{
+    mjpegd_obj_t* obj = (mjpegd_obj_t*) mjpegd_obj;
+    mjpegd_slot_t *slot;
+
+    if(!obj || !frame)
+        return MJPEGD_ERROR;
+
+    pthread_mutex_lock(&obj->lock);
+    while(!obj->count || MJPEGD_SLOT_DONE != mjpegd_slot(obj, 0)->state) {
+        if(0 == timeoutMs ||
+           (timeoutMs > 0 && JPEGERR_ETIMEDOUT ==
+            mjpegd_cond_timedwait(&obj->cond, &obj->lock, timeoutMs))) {
+            pthread_mutex_unlock(&obj->lock);
+            return MJPEGD_NO_FRAME;
+        }
+        if(timeoutMs < 0)
+            pthread_cond_wait(&obj->cond, &obj->lock);
+    }
+
+    slot = mjpegd_slot(obj, 0);
+    *frame = slot->frame;
+    slot->state = MJPEGD_SLOT_FREE;
+    obj->head = (obj->head + 1) % MJPEGD_QUEUE_SIZE;
+    obj->count--;
+    pthread_mutex_unlock(&obj->lock);
+
+    return MJPEGD_NO_ERROR;
+}
+
+MJPEGD_ERR mjpegDecodeFlush(void* mjpegd_obj)
+{
+    mjpegd_obj_t* obj = (mjpegd_obj_t*) mjpegd_obj;
+    mjpegd_slot_t *slot;
+    int i, running;
+
+    if(!obj)
+        return MJPEGD_ERROR;
+
+    pthread_mutex_lock(&obj->lock);
+    do {
+        running = 0;
+        for(i = 0; i < obj->count; i++) {
+            slot = mjpegd_slot(obj, i);
+            if(MJPEGD_SLOT_PENDING == slot->state) {
+                slot->state         = MJPEGD_SLOT_DONE;
+                slot->frame.status  = MJPEGD_FRAME_DROPPED;
+                obj->stats.dropped++;
+            }
+            if(MJPEGD_SLOT_RUNNING == slot->state)
+                running = 1;
+        }
+        if(running)
+            pthread_cond_wait(&obj->cond, &obj->lock);
+    } while(running);
+    pthread_mutex_unlock(&obj->lock);
+
+    return MJPEGD_NO_ERROR;
+}
+
+MJPEGD_ERR mjpegDecoderGetStats(void* mjpegd_obj, mjpegd_stats_t* stats)
+{
+    mjpegd_obj_t* obj = (mjpegd_obj_t*) mjpegd_obj;
+
+    if(!obj || !stats)
+        return MJPEGD_ERROR;
+
+    pthread_mutex_lock(&obj->lock);
+    *stats = obj->stats;
+    if(obj->stats.decoded) {
+        stats->avgLatencyUs = obj->totalLatencyUs / obj->stats.decoded;
+        stats->avgDecodeUs  = obj->totalDecodeUs / obj->stats.decoded;
+    }
+    pthread_mutex_unlock(&obj->lock);
+
+    return MJPEGD_NO_ERROR;
+}
+
+/*
+ * Synchronous decode of one frame
+ */
 MJPEGD_ERR mjpegDecode(
             void*   mjpegd_obj,
             char*   inputMjpegBuffer,
@@ -175,73 +485,38 @@ MJPEGD_ERR mjpegDecode(
             char*   outputUVptr,
             int     outputFormat)
 {
-    int rc, c, i;
-    test_args_t* mjpegd;
-    test_args_t  test_args;
+    mjpegd_frame_t frame;
+    int rc;
 
     ALOGD("%s: E", __func__);
-    /* store input arguments in the context */
-    mjpegd = (test_args_t*) mjpegd_obj;
-    mjpegd->inputMjpegBuffer        = inputMjpegBuffer;
-    mjpegd->inputMjpegBufferSize    = inputMjpegBufferSize;
-    mjpegd->outputYptr              = outputYptr;
-    mjpegd->outputUVptr             = outputUVptr;
-    mjpegd->format                  = outputFormat;
 
-    /* TBDJ: can be removed */
-    memcpy(&test_args, mjpegd, sizeof(test_args_t));
+    memset(&frame, 0, sizeof(frame));
+    frame.mjpegBuffer       = inputMjpegBuffer;
+    frame.mjpegBufferSize   = inputMjpegBufferSize;
+    frame.outputYptr        = outputYptr;
+    frame.outputUVptr       = outputUVptr;
+    frame.outputFormat      = outputFormat;
 
-    // check the formats
-    if (((test_args.format == YCRCBLP_H1V2) || (test_args.format == YCBCRLP_H1V2) ||
-      (test_args.format == YCRCBLP_H1V1) || (test_args.format == YCBCRLP_H1V1)) &&
-      !(test_args.preference == JPEG_DECODER_PREF_HW_ACCELERATED_ONLY)) {
-        ALOGE("%s:These formats are not supported by SW format %d", __func__, test_args.format);
-        return 1;
-    }
-
-    // Create thread control blocks
-    thread_ctrl_blks = (thread_ctrl_blk_t *)malloc( sizeof(thread_ctrl_blk_t));
-    if (!thread_ctrl_blks)
-    {
-        ALOGE("%s: decoder_test failed: insufficient memory in creating thread control blocks", __func__);
-        return 1;
-    }
-    memset(thread_ctrl_blks, 0, sizeof(thread_ctrl_blk_t));
-    // Initialize the blocks and kick off the threads
-        thread_ctrl_blks[i].tid = i;
-        thread_ctrl_blks[i].p_args = &test_args;
-        os_mutex_init(&thread_ctrl_blks[i].mutex);
-        os_cond_init(&thread_ctrl_blks[i].cond);
-
-    rc = (int)decoder_test(&thread_ctrl_blks[i]);
-
-    if (!rc)
-        ALOGD("%s: decoder_test finished successfully ", __func__);
-    else
-        ALOGE("%s: decoder_test failed",__func__);
+    rc = mjpegDecodeSubmit(mjpegd_obj, &frame);
+    if(!rc)
+        rc = mjpegDecodeGetDone(mjpegd_obj, &frame, -1);
+    if(!rc && MJPEGD_FRAME_DECODED != frame.status)
+        rc = MJPEGD_ERROR;
 
     ALOGD("%s: X rc: %d", __func__, rc);
 
     return rc;
 }
 
-OS_THREAD_FUNC_RET_T OS_THREAD_FUNC_MODIFIER decoder_test(OS_THREAD_FUNC_ARG_T arg)
+/*
+ * Creates the jpeg decoder and its input buffers. Done once per object.
+ */
+static int decoder_setup(thread_ctrl_blk_t *p_thread_arg, jpegd_src_t *source)
 {
-    int rc, i;
+    int rc;
     jpegd_obj_t         decoder;
-    jpegd_src_t         source;
-    jpegd_dst_t         dest;
-    jpegd_cfg_t         config;
-    jpeg_hdr_t          header;
-    jpegd_output_buf_t  p_output_buffers;
-    uint32_t            output_buffers_count = 1; // currently only 1 buffer a time is supported
     uint8_t use_pmem = true;
-    timespec os_timer;
-    thread_ctrl_blk_t *p_thread_arg = (thread_ctrl_blk_t *)arg;
     test_args_t *p_args = p_thread_arg->p_args;
-    uint32_t            output_width;
-    uint32_t            output_height;
-    uint32_t total_time = 0;
 
     ALOGD("%s: E", __func__);
 
@@ -268,281 +543,215 @@ OS_THREAD_FUNC_RET_T OS_THREAD_FUNC_MODIFIER decoder_test(OS_THREAD_FUNC_ARG_T a
 
     if (JPEG_FAILED(rc)) {
         ALOGE("%s: decoder_test: jpegd_init failed", __func__);
-        goto fail;
+        return 1;
     }
     p_thread_arg->decoder = decoder;
 
     // Set source information
-    source.p_input_req_handler = &decoder_input_req_handler;
-    source.total_length        = p_args->inputMjpegBufferSize & 0xffffffff;
+    memset(source, 0, sizeof(jpegd_src_t));
+    source->p_input_req_handler = &decoder_input_req_handler;
 
-    rc = jpeg_buffer_init(&source.buffers[0]);
+    rc = jpeg_buffer_init(&source->buffers[0]);
     if (JPEG_SUCCEEDED(rc)) {
         /* TBDJ: why buffer [1] */
-        rc = jpeg_buffer_init(&source.buffers[1]);
+        rc = jpeg_buffer_init(&source->buffers[1]);
     }
     if (JPEG_SUCCEEDED(rc)) {
-#if 1
-        rc = jpeg_buffer_allocate(source.buffers[0], 0xA000, use_pmem);
-#else
-        rc = jpeg_buffer_use_external_buffer(source.buffers[0],
-                                             (uint8_t *)p_args->inputMjpegBuffer,
-                                             p_args->inputMjpegBufferSize,
-                                             0);
-#endif
-        ALOGD("%s: source.buffers[0]:%p compressed buffer ptr = %p", __func__,
-              source.buffers[0], p_args->inputMjpegBuffer);
+        rc = jpeg_buffer_allocate(source->buffers[0], 0xA000, use_pmem);
+        ALOGD("%s: source.buffers[0]:%p", __func__, source->buffers[0]);
     }
     if (JPEG_SUCCEEDED(rc)) {
-#if 1
-        rc = jpeg_buffer_allocate(source.buffers[1], 0xA000, use_pmem);
-#else
-         rc = jpeg_buffer_use_external_buffer(source.buffers[1],
-                                             (uint8_t *)p_args->inputMjpegBuffer,
-                                             p_args->inputMjpegBufferSize,
-                                             0);
-#endif
-        ALOGD("%s: source.buffers[1]:%p compressed buffer ptr  = %p", __func__,
-              source.buffers[1], p_args->inputMjpegBuffer);
-   }
+        rc = jpeg_buffer_allocate(source->buffers[1], 0xA000, use_pmem);
+        ALOGD("%s: source.buffers[1]:%p", __func__, source->buffers[1]);
+    }
     if (JPEG_FAILED(rc)) {
-        jpeg_buffer_destroy(&source.buffers[0]);
-        jpeg_buffer_destroy(&source.buffers[1]);
-        goto fail;
+        jpeg_buffer_destroy(&source->buffers[0]);
+        jpeg_buffer_destroy(&source->buffers[1]);
+        jpegd_destroy(&p_thread_arg->decoder);
+        return 1;
     }
 
-   ALOGI("%s: *** Starting back-to-back decoding of %d frame(s)***\n",
-                 __func__, p_args->back_to_back_count);
+    ALOGD("%s: X", __func__);
+    return 0;
+}
 
-	 // Loop to perform n back-to-back decoding (to the same output file)
-    for(i = 0; i < p_args->back_to_back_count; i++) {
-        if(mjpegd_timer_start(&os_timer) < 0) {
-            ALOGE("%s: failed to get start time", __func__);
-        }
+static void decoder_teardown(thread_ctrl_blk_t *p_thread_arg,
+                             jpegd_src_t *source)
+{
+    jpeg_buffer_destroy(&source->buffers[0]);
+    jpeg_buffer_destroy(&source->buffers[1]);
+    jpegd_destroy(&p_thread_arg->decoder);
+}
 
-        /* TBDJ: Every frame? */
-        ALOGD("%s: before jpegd_set_source source.p_arg:%p", __func__, source.p_arg);
-        rc = jpegd_set_source(decoder, &source);
-        if (JPEG_FAILED(rc))
-        {
-            ALOGE("%s: jpegd_set_source failed", __func__);
-            goto fail;
-        }
+/*
+ * Decodes the frame described by p_thread_arg->p_args with the decoder
+ * created by decoder_setup
+ */
+static int decoder_decode_frame(thread_ctrl_blk_t *p_thread_arg,
+                                jpegd_src_t *source)
+{
+    int rc;
+    jpegd_obj_t         decoder = p_thread_arg->decoder;
+    jpegd_dst_t         dest;
+    jpegd_cfg_t         config;
+    jpeg_hdr_t          header;
+    jpegd_output_buf_t  p_output_buffers;
+    uint32_t            output_buffers_count = 1; // currently only 1 buffer a time is supported
+    timespec os_timer;
+    test_args_t *p_args = p_thread_arg->p_args;
+    uint32_t            output_width;
+    uint32_t            output_height;
+    int diff;
 
-        rc = jpegd_read_header(decoder, &header);
-        if (JPEG_FAILED(rc))
-        {
-            ALOGE("%s: jpegd_read_header failed", __func__);
-            goto fail;
-        }
-        p_args->width = header.main.width;
-        p_args->height = header.main.height;
-        ALOGD("%s: main dimension: (%dx%d) subsampling: (%d)", __func__,
-                header.main.width, header.main.height, (int)header.main.subsampling);
-
-        // main image decoding:
-        // Set destination information
-        dest.width = (p_args->width) ? (p_args->width) : header.main.width;
-        dest.height = (p_args->height) ? (p_args->height) : header.main.height;
-        dest.output_format = (jpeg_color_format_t) p_args->format;
-        dest.region = p_args->region;
-
-        // if region is defined, re-assign the output width/height
-        output_width  = dest.width;
-        output_height = dest.height;
-
-        if (p_args->region.right || p_args->region.bottom)
-        {
-            if (0 == p_args->rotation || 180 == p_args->rotation)
-            {
-                output_width  = MIN((dest.width),
-                        (uint32_t)(dest.region.right  - dest.region.left + 1));
-                output_height = MIN((dest.height),
-                        (uint32_t)(dest.region.bottom - dest.region.top  + 1));
-            }
-            // Swap output width/height for 90/270 rotation cases
-            else if (90 == p_args->rotation || 270 == p_args->rotation)
-            {
-                output_height  = MIN((dest.height),
-                        (uint32_t)(dest.region.right  - dest.region.left + 1));
-                output_width   = MIN((dest.width),
-                        (uint32_t)(dest.region.bottom - dest.region.top  + 1));
-            }
-            // Unsupported rotation cases
-            else
-            {
-                goto fail;
-            }
-        }
+    ALOGD("%s: E", __func__);
 
-        if (dest.output_format == YCRCBLP_H2V2 || dest.output_format == YCBCRLP_H2V2 ||
-            dest.output_format == YCRCBLP_H2V1 || dest.output_format == YCBCRLP_H2V1 ||
-            dest.output_format == YCRCBLP_H1V2 || dest.output_format == YCBCRLP_H1V2 ||
-            dest.output_format == YCRCBLP_H1V1 || dest.output_format == YCBCRLP_H1V1) {
-            jpeg_buffer_init(&p_output_buffers.data.yuv.luma_buf);
-            jpeg_buffer_init(&p_output_buffers.data.yuv.chroma_buf);
-        } else {
-            jpeg_buffer_init(&p_output_buffers.data.rgb.rgb_buf);
+    memset(&p_output_buffers, 0, sizeof(p_output_buffers));
+    p_thread_arg->decode_success = false;
 
-        }
+    if(mjpegd_timer_start(&os_timer) < 0) {
+        ALOGE("%s: failed to get start time", __func__);
+    }
+
+    source->total_length = p_args->inputMjpegBufferSize & 0xffffffff;
+    ALOGD("%s: before jpegd_set_source source.p_arg:%p", __func__, source->p_arg);
+    rc = jpegd_set_source(decoder, source);
+    if (JPEG_FAILED(rc))
+    {
+        ALOGE("%s: jpegd_set_source failed", __func__);
+        return 1;
+    }
 
+    rc = jpegd_read_header(decoder, &header);
+    if (JPEG_FAILED(rc))
+    {
+        ALOGE("%s: jpegd_read_header failed", __func__);
+        return 1;
+    }
+    p_args->width = header.main.width;
+    p_args->height = header.main.height;
+    ALOGD("%s: main dimension: (%dx%d) subsampling: (%d)", __func__,
+            header.main.width, header.main.height, (int)header.main.subsampling);
+
+    // main image decoding:
+    // Set destination information
+    dest.width = (p_args->width) ? (p_args->width) : header.main.width;
+    dest.height = (p_args->height) ? (p_args->height) : header.main.height;
+    dest.output_format = (jpeg_color_format_t) p_args->format;
+    dest.region = p_args->region;
+
+    // if region is defined, re-assign the output width/height
+    output_width  = dest.width;
+    output_height = dest.height;
+
+    if (p_args->region.right || p_args->region.bottom)
+    {
+        if (0 == p_args->rotation || 180 == p_args->rotation)
         {
-            // Assign 0 to tile width and height
-            // to indicate that no tiling is requested.
-            p_output_buffers.tile_width  = 0;
-            p_output_buffers.tile_height = 0;
+            output_width  = MIN((dest.width),
+                    (uint32_t)(dest.region.right  - dest.region.left + 1));
+            output_height = MIN((dest.height),
+                    (uint32_t)(dest.region.bottom - dest.region.top  + 1));
         }
-        p_output_buffers.is_in_q = 0;
-
-        switch (dest.output_format)
+        // Swap output width/height for 90/270 rotation cases
+        else if (90 == p_args->rotation || 270 == p_args->rotation)
         {
-        case YCRCBLP_H2V2:
-        case YCBCRLP_H2V2:
-//        case YCRCBLP_H2V1:
-//        case YCBCRLP_H2V1:
-//        case YCRCBLP_H1V2:
-//        case YCBCRLP_H1V2:
-//        case YCRCBLP_H1V1:
-//        case YCBCRLP_H1V1:
-            jpeg_buffer_use_external_buffer(
-               p_output_buffers.data.yuv.luma_buf,
-               (uint8_t*)p_args->outputYptr,
-               p_args->width * p_args->height * SQUARE(p_args->scale_factor),
-               0);
-            jpeg_buffer_use_external_buffer(
-                p_output_buffers.data.yuv.chroma_buf,
-                (uint8_t*)p_args->outputUVptr,
-                p_args->width * p_args->height / 2 * SQUARE(p_args->scale_factor),
-                0);
-            break;
-
-        default:
-            ALOGE("%s: decoder_test: unsupported output format", __func__);
-            goto fail;
+            output_height  = MIN((dest.height),
+                    (uint32_t)(dest.region.right  - dest.region.left + 1));
+            output_width   = MIN((dest.width),
+                    (uint32_t)(dest.region.bottom - dest.region.top  + 1));
         }
-
-        // Set up configuration
-        memset(&config, 0, sizeof(jpegd_cfg_t));
-        config.preference = (jpegd_preference_t) p_args->preference;
-        config.decode_from = JPEGD_DECODE_FROM_AUTO;
-        config.rotation = p_args->rotation;
-        config.scale_factor = p_args->scale_factor;
-        config.hw_rotation = p_args->hw_rotation;
-        dest.back_to_back_count = p_args->back_to_back_count;
-
-        // Start decoding
-        p_thread_arg->decoding = true;
-
-        rc = jpegd_start(decoder, &config, &dest, &p_output_buffers, output_buffers_count);
-        dest.back_to_back_count--;
-
-        if(JPEG_FAILED(rc)) {
-            ALOGE("%s: decoder_test: jpegd_start failed (rc=%d)\n",
-                    __func__, rc);
-            goto fail;
+        // Unsupported rotation cases
+        else
+        {
+            return 1;
         }
+    }
+
+    switch (dest.output_format)
+    {
+    case YCRCBLP_H2V2:
+    case YCBCRLP_H2V2:
+        jpeg_buffer_init(&p_output_buffers.data.yuv.luma_buf);
+        jpeg_buffer_init(&p_output_buffers.data.yuv.chroma_buf);
+        jpeg_buffer_use_external_buffer(
+           p_output_buffers.data.yuv.luma_buf,
+           (uint8_t*)p_args->outputYptr,
+           p_args->width * p_args->height * SQUARE(p_args->scale_factor),
+           0);
+        jpeg_buffer_use_external_buffer(
+            p_output_buffers.data.yuv.chroma_buf,
+            (uint8_t*)p_args->outputUVptr,
+            p_args->width * p_args->height / 2 * SQUARE(p_args->scale_factor),
+            0);
+        break;
+
+    default:
+        ALOGE("%s: decoder_test: unsupported output format", __func__);
+        return 1;
+    }
 
+    // Assign 0 to tile width and height
+    // to indicate that no tiling is requested.
+    p_output_buffers.tile_width  = 0;
+    p_output_buffers.tile_height = 0;
+    p_output_buffers.is_in_q = 0;
+
+    // Set up configuration
+    memset(&config, 0, sizeof(jpegd_cfg_t));
+    config.preference = (jpegd_preference_t) p_args->preference;
+    config.decode_from = JPEGD_DECODE_FROM_AUTO;
+    config.rotation = p_args->rotation;
+    config.scale_factor = p_args->scale_factor;
+    config.hw_rotation = p_args->hw_rotation;
+    dest.back_to_back_count = 1;
+
+    // Start decoding
+    p_thread_arg->decoding = true;
+
+    rc = jpegd_start(decoder, &config, &dest, &p_output_buffers, output_buffers_count);
+
+    if(JPEG_FAILED(rc)) {
+        ALOGE("%s: decoder_test: jpegd_start failed (rc=%d)\n",
+                __func__, rc);
+        p_thread_arg->decoding = false;
+    } else {
         ALOGD("%s: decoder_test: jpegd_start succeeded", __func__);
 
-        // Do abort
-        if (p_args->abort_time) {
-            os_mutex_lock(&p_thread_arg->mutex);
-            while (p_thread_arg->decoding)
-            {
-                rc = mjpegd_cond_timedwait(&p_thread_arg->cond, &p_thread_arg->mutex, p_args->abort_time);
-                if (rc == JPEGERR_ETIMEDOUT)
-                {
-                    // Do abort
-                    os_mutex_unlock(&p_thread_arg->mutex);
-                    rc = jpegd_abort(decoder);
-                    if (rc)
-                    {
-                        ALOGE("%s: decoder_test: jpegd_abort failed: %d", __func__, rc);
-                        goto fail;
-                    }
-                    break;
-                }
-            }
-            if (p_thread_arg->decoding)
-                os_mutex_unlock(&p_thread_arg->mutex);
-        } else {
-            // Wait until decoding is done or stopped due to error
-            os_mutex_lock(&p_thread_arg->mutex);
-            while (p_thread_arg->decoding)
-            {
+        os_mutex_lock(&p_thread_arg->mutex);
+        while (p_thread_arg->decoding)
+        {
+            if (!p_args->abort_time) {
+                // Wait until decoding is done or stopped due to error
                 os_cond_wait(&p_thread_arg->cond, &p_thread_arg->mutex);
+            } else if (JPEGERR_ETIMEDOUT == mjpegd_cond_timedwait(
+                &p_thread_arg->cond, &p_thread_arg->mutex, p_args->abort_time)) {
+                // Do abort, the event handler stops the decoding
+                os_mutex_unlock(&p_thread_arg->mutex);
+                rc = jpegd_abort(decoder);
+                if (rc)
+                    ALOGE("%s: decoder_test: jpegd_abort failed: %d", __func__, rc);
+                os_mutex_lock(&p_thread_arg->mutex);
+                if (rc)
+                    break;
             }
-            os_mutex_unlock(&p_thread_arg->mutex);
         }
+        os_mutex_unlock(&p_thread_arg->mutex);
 
-        int diff;
         // Display the time elapsed
         if (mjpegd_timer_get_elapsed(&os_timer, &diff, 0) < 0) {
             ALOGE("%s: decoder_test: failed to get elapsed time", __func__);
+        } else if(p_thread_arg->decode_success) {
+            ALOGD("%s: decode time: %d ms", __func__, diff);
         } else {
-            if(p_args->abort_time) {
-                if(p_thread_arg->decoding) {
-                    ALOGI("%s: decoder_test: decoding aborted successfully after %d ms", __func__, diff);
-                    goto buffer_clean_up;
-                }
-                else
-                {
-                    ALOGI("%s: decoder_test: decoding stopped before abort is issued. "
-                                    "decode time: %d ms", __func__, diff);
-                }
-            }
-            else {
-                if(p_thread_arg->decode_success) {
-                    total_time += diff;
-                    ALOGI("%s: decode time: %d ms (%d frame(s), total=%dms, avg=%dms/frame)",
-                            __func__, diff, i+1, total_time, total_time/(i+1));
-                }
-                else
-                {
-                    fprintf(stderr, "decoder_test: decode failed\n");
-                }
-            }
+            ALOGE("%s: decoder_test: decode failed", __func__);
         }
     }
 
-    if(p_thread_arg->decode_success) {
-        ALOGD("%s: Frame(s) = %d, Total Time = %dms, Avg. decode time = %dms/frame)\n",
-                 __func__, p_args->back_to_back_count, total_time, total_time/p_args->back_to_back_count);
-    }
-
-buffer_clean_up:
-    // Clean up decoder and allocate buffers
-    jpeg_buffer_destroy(&source.buffers[0]);
-    jpeg_buffer_destroy(&source.buffers[1]);
-    switch (dest.output_format)
-    {
-    case YCRCBLP_H2V2:
-    case YCBCRLP_H2V2:
-    case YCRCBLP_H2V1:
-    case YCBCRLP_H2V1:
-    case YCRCBLP_H1V2:
-    case YCBCRLP_H1V2:
-    case YCRCBLP_H1V1:
-    case YCBCRLP_H1V1:
-        jpeg_buffer_destroy(&p_output_buffers.data.yuv.luma_buf);
-        jpeg_buffer_destroy(&p_output_buffers.data.yuv.chroma_buf);
-        break;
-    default:
-        break;
-    }
-    jpegd_destroy(&decoder);
-
-    if (!p_thread_arg->decode_success)
-    {
-        goto fail;
-    }
-
-    ALOGD("%s: X", __func__);
-    return OS_THREAD_FUNC_RET_SUCCEEDED;
-fail:
+    jpeg_buffer_destroy(&p_output_buffers.data.yuv.luma_buf);
+    jpeg_buffer_destroy(&p_output_buffers.data.yuv.chroma_buf);
 
     ALOGD("%s: X", __func__);
-    return OS_THREAD_FUNC_RET_FAILED;
+    return p_thread_arg->decode_success ? 0 : 1;
 }
 
 void decoder_event_handler(void        *p_user_data,
@@ -0,0 +1,465 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+//#define ALOG_NDEBUG 0
+#define ALOG_NIDEBUG 0
+#define LOG_TAG "QCameraUsbConvert"
+#include <utils/Log.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define USBCAM_CONV_NEON    1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define USBCAM_CONV_SSE2    1
+#endif
+
+#include "QCameraUsbConvert.h"
+
+/* One band of rows of the frame being converted */
+typedef struct
+{
+    const uint8_t*      in;
+    uint8_t*            out;
+    int                 wd;
+    int                 ht;
+    int                 outputFormat;
+    int                 numBands;
+    int                 rowsPerBand;
+} usbcam_conv_job_t;
+
+typedef struct usbcam_conv usbcam_conv_t;
+
+typedef struct
+{
+    usbcam_conv_t*      conv;
+    int                 band;
+} usbcam_conv_thread_arg_t;
+
+struct usbcam_conv
+{
+    int                 numThreads;
+    pthread_t           threads[USBCAM_CONV_MAX_THREADS];
+    usbcam_conv_thread_arg_t args[USBCAM_CONV_MAX_THREADS];
+
+    /* Serializes frames; a second caller converts on its own thread */
+    pthread_mutex_t     submitMutex;
+
+    /* Protects everything below */
+    pthread_mutex_t     mutex;
+    pthread_cond_t      startCond;
+    pthread_cond_t      doneCond;
+    unsigned int        generation;
+    int                 pending;
+    int                 exit;
+    usbcam_conv_job_t   job;
+};
+
+/******************************************************************************
+ * Function: convert_row
+ * Description: Converts one row of YUYV pixels. Luma is written to dst_y;
+ *              if dst_uv is not NULL, the row's chroma is written there in
+ *              UV (NV12) or VU (NV21) order.
+ *
+ * Input parameters:
+ *   src                 - start of the YUYV row
+ *   dst_y               - start of the output luma row
+ *   dst_uv              - start of the output chroma row or NULL
+ *   wd                  - width in pixels, must be even
+ *   nv21                - non zero to emit VU order
+ *
+ * Return values: none
+ *
+ * Notes: none
+ *****************************************************************************/
+static inline void convert_row(const uint8_t *src, uint8_t *dst_y,
+                               uint8_t *dst_uv, int wd, int nv21)
+{
+    int i = 0;
+
+#if USBCAM_CONV_NEON
+    /* 32 pixels per iteration: vld4 splits Y0, U, Y1 and V lanes */
+    if(dst_uv) {
+        for(; i + 32 <= wd; i += 32) {
+            uint8x16x4_t px = vld4q_u8(src + i * 2);
+            uint8x16x2_t y, c;
+            y.val[0] = px.val[0];
+            y.val[1] = px.val[2];
+            c.val[0] = nv21 ? px.val[3] : px.val[1];
+            c.val[1] = nv21 ? px.val[1] : px.val[3];
+            vst2q_u8(dst_y + i, y);
+            vst2q_u8(dst_uv + i, c);
+        }
+    } else {
+        for(; i + 32 <= wd; i += 32) {
+            uint8x16x4_t px = vld4q_u8(src + i * 2);
+            uint8x16x2_t y;
+            y.val[0] = px.val[0];
+            y.val[1] = px.val[2];
+            vst2q_u8(dst_y + i, y);
+        }
+    }
+#elif USBCAM_CONV_SSE2
+    /* 16 pixels per iteration: luma is the low byte of each 16 bit word,
+     * chroma the high byte, so mask/shift and pack with saturation */
+    const __m128i lo = _mm_set1_epi16(0x00FF);
+    if(dst_uv) {
+        for(; i + 16 <= wd; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(src + i * 2));
+            __m128i b = _mm_loadu_si128((const __m128i *)(src + i * 2 + 16));
+            __m128i y = _mm_packus_epi16(_mm_and_si128(a, lo),
+                                         _mm_and_si128(b, lo));
+            __m128i c = _mm_packus_epi16(_mm_srli_epi16(a, 8),
+                                         _mm_srli_epi16(b, 8));
+            if(nv21)
+                c = _mm_or_si128(_mm_slli_epi16(c, 8), _mm_srli_epi16(c, 8));
+            _mm_storeu_si128((__m128i *)(dst_y + i), y);
+            _mm_storeu_si128((__m128i *)(dst_uv + i), c);
+        }
+    } else {
+        for(; i + 16 <= wd; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(src + i * 2));
+            __m128i b = _mm_loadu_si128((const __m128i *)(src + i * 2 + 16));
+            __m128i y = _mm_packus_epi16(_mm_and_si128(a, lo),
+                                         _mm_and_si128(b, lo));
+            _mm_storeu_si128((__m128i *)(dst_y + i), y);
+        }
+    }
+#endif
+
+    /* Remaining pixels, one YUYV macro pixel at a time */
+    for(; i < wd; i += 2) {
+        const uint8_t *p = src + i * 2;
+        dst_y[i]     = p[0];
+        dst_y[i + 1] = p[2];
+        if(dst_uv) {
+            dst_uv[i]     = nv21 ? p[3] : p[1];
+            dst_uv[i + 1] = nv21 ? p[1] : p[3];
+        }
+    }
+}
+
+/******************************************************************************
+ * Function: swap_chroma
+ * Description: Swaps the two bytes of each chroma pair, turning a UV plane
+ *              into a VU plane and vice versa.
+ *
+ * Input parameters:
+ *   src                 - input chroma plane
+ *   dst                 - output chroma plane, may equal src
+ *   len                 - plane size in bytes, must be even
+ *
+ * Return values: none
+ *
+ * Notes: none
+ *****************************************************************************/
+static void swap_chroma(const uint8_t *src, uint8_t *dst, int len)
+{
+    int i = 0;
+
+#if USBCAM_CONV_NEON
+    for(; i + 32 <= len; i += 32) {
+        uint8x16x2_t c = vld2q_u8(src + i);
+        uint8x16_t t = c.val[0];
+        c.val[0] = c.val[1];
+        c.val[1] = t;
+        vst2q_u8(dst + i, c);
+    }
+#elif USBCAM_CONV_SSE2
+    for(; i + 16 <= len; i += 16) {
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + i));
+        c = _mm_or_si128(_mm_slli_epi16(c, 8), _mm_srli_epi16(c, 8));
+        _mm_storeu_si128((__m128i *)(dst + i), c);
+    }
+#endif
+
+    for(; i < len; i += 2) {
+        uint8_t t = src[i];
+        dst[i]     = src[i + 1];
+        dst[i + 1] = t;
+    }
+}
+
+/******************************************************************************
+ * Function: convert_rows
+ * Description: Converts rows [row_start, row_end) of a YUYV frame. Chroma
+ *              of each even row fills one row of the chroma plane.
+ *
+ * Input parameters:
+ *   in, out             - input and output frames
+ *   wd, ht              - frame dimensions
+ *   row_start, row_end  - rows to convert, row_start even
+ *   nv21                - non zero to emit VU order
+ *
+ * Return values: none
+ *
+ * Notes: none
+ *****************************************************************************/
+static void convert_rows(const uint8_t *in, uint8_t *out, int wd, int ht,
+                         int row_start, int row_end, int nv21)
+{
+    uint8_t *uv_plane = out + wd * ht;
+    int row;
+
+    for(row = row_start; row < row_end; row++) {
+        convert_row(in + row * wd * 2, out + row * wd,
+                    (row & 1) ? NULL : uv_plane + (row / 2) * wd, wd, nv21);
+    }
+}
+
+static void convert_band(const usbcam_conv_job_t *job, int band)
+{
+    int row_start = band * job->rowsPerBand;
+    int row_end   = row_start + job->rowsPerBand;
+
+    if(row_start >= job->ht)
+        return;
+    if(row_end > job->ht)
+        row_end = job->ht;
+    convert_rows(job->in, job->out, job->wd, job->ht, row_start, row_end,
+                 job->outputFormat == USBCAM_CONV_OUT_NV21);
+}
+
+/******************************************************************************
+ * Function: convert_thread
+ * Description: Helper thread. Waits for a new frame generation, converts
+ *              its band and reports completion.
+ *
+ * Input parameters:
+ *   data                - usbcam_conv_thread_arg_t of this thread
+ *
+ * Return values:
+ *   NULL
+ *
+ * Notes: none
+ *****************************************************************************/
+static void *convert_thread(void *data)
+{
+    usbcam_conv_thread_arg_t *arg = (usbcam_conv_thread_arg_t *)data;
+    usbcam_conv_t *conv = arg->conv;
+    unsigned int seen = 0;
+    usbcam_conv_job_t job;
+
+    pthread_mutex_lock(&conv->mutex);
+    while(1) {
+        while(!conv->exit && conv->generation == seen)
+            pthread_cond_wait(&conv->startCond, &conv->mutex);
+        if(conv->exit)
+            break;
+        seen = conv->generation;
+        job = conv->job;
+        pthread_mutex_unlock(&conv->mutex);
+
+        convert_band(&job, arg->band);
+
+        pthread_mutex_lock(&conv->mutex);
+        if(--conv->pending == 0)
+            pthread_cond_signal(&conv->doneCond);
+    }
+    pthread_mutex_unlock(&conv->mutex);
+    return NULL;
+}
+
+static void stop_threads(usbcam_conv_t *conv, int count)
+{
+    int i;
+
+    pthread_mutex_lock(&conv->mutex);
+    conv->exit = 1;
+    pthread_cond_broadcast(&conv->startCond);
+    pthread_mutex_unlock(&conv->mutex);
+
+    for(i = 0; i < count; i++)
+        pthread_join(conv->threads[i], NULL);
+}
+
+/*
+ * This function creates the converter object and its helper threads
+ */
+USBCAM_CONV_ERR usbCamConvertInit(void** conv_obj, int numThreads)
+{
+    usbcam_conv_t *conv;
+    int i;
+
+    if(!conv_obj || numThreads < 0) {
+        ALOGE("%s: invalid arguments", __func__);
+        return USBCAM_CONV_ERROR;
+    }
+    if(numThreads > USBCAM_CONV_MAX_THREADS)
+        numThreads = USBCAM_CONV_MAX_THREADS;
+
+    conv = (usbcam_conv_t *)malloc(sizeof(usbcam_conv_t));
+    if(!conv)
+        return USBCAM_CONV_INSUFFICIENT_MEM;
+    memset(conv, 0, sizeof(usbcam_conv_t));
+
+    pthread_mutex_init(&conv->submitMutex, NULL);
+    pthread_mutex_init(&conv->mutex, NULL);
+    pthread_cond_init(&conv->startCond, NULL);
+    pthread_cond_init(&conv->doneCond, NULL);
+
+    for(i = 0; i < numThreads; i++) {
+        conv->args[i].conv = conv;
+        conv->args[i].band = i + 1;
+        if(pthread_create(&conv->threads[i], NULL, convert_thread,
+                          &conv->args[i])) {
+            ALOGE("%s: pthread_create failed for helper %d", __func__, i);
+            break;
+        }
+    }
+    conv->numThreads = i;
+
+    ALOGD("%s: %d helper threads", __func__, conv->numThreads);
+    *conv_obj = (void *)conv;
+    return USBCAM_CONV_NO_ERROR;
+}
+
+/*
+ * This function stops the helper threads and frees the converter object
+ */
+USBCAM_CONV_ERR usbCamConvertDestroy(void* conv_obj)
+{
+    usbcam_conv_t *conv = (usbcam_conv_t *)conv_obj;
+
+    if(!conv)
+        return USBCAM_CONV_ERROR;
+
+    stop_threads(conv, conv->numThreads);
+
+    pthread_cond_destroy(&conv->doneCond);
+    pthread_cond_destroy(&conv->startCond);
+    pthread_mutex_destroy(&conv->mutex);
+    pthread_mutex_destroy(&conv->submitMutex);
+    free(conv);
+    return USBCAM_CONV_NO_ERROR;
+}
+
+/*
+ * This function converts a NV12 frame into NV21, in place if requested
+ */
+USBCAM_CONV_ERR usbCamConvertNV12toNV21(
+            const char* in_buf,
+            char*       out_buf,
+            int         wd,
+            int         ht)
+{
+    int ysize;
+
+    if(!in_buf || !out_buf || wd <= 0 || (wd & 1) || ht <= 0) {
+        ALOGE("%s: invalid arguments", __func__);
+        return USBCAM_CONV_ERROR;
+    }
+
+    ysize = wd * ht;
+    if(in_buf != out_buf)
+        memcpy(out_buf, in_buf, ysize);
+    swap_chroma((const uint8_t *)in_buf + ysize, (uint8_t *)out_buf + ysize,
+                wd * ((ht + 1) / 2));
+    return USBCAM_CONV_NO_ERROR;
+}
+
+/*
+ * This function converts a part of a frame on the calling thread
+ */
+USBCAM_CONV_ERR usbCamConvertYUYVRows(
+            const char* in_buf,
+            char*       out_buf,
+            int         wd,
+            int         ht,
+            int         rowStart,
+            int         rowEnd,
+            int         outputFormat)
+{
+    if(!in_buf || !out_buf || wd <= 0 || (wd & 1) || ht <= 0 ||
+       rowStart < 0 || (rowStart & 1) || rowEnd > ht) {
+        ALOGE("%s: invalid arguments", __func__);
+        return USBCAM_CONV_ERROR;
+    }
+
+    convert_rows((const uint8_t *)in_buf, (uint8_t *)out_buf, wd, ht,
+                 rowStart, rowEnd, outputFormat == USBCAM_CONV_OUT_NV21);
+    return USBCAM_CONV_NO_ERROR;
+}
+
+/*
+ * This function converts a whole frame, splitting large frames between the
+ * helper threads and the calling thread
+ */
+USBCAM_CONV_ERR usbCamConvertYUYV(
+            void*       conv_obj,
+            const char* in_buf,
+            char*       out_buf,
+            int         wd,
+            int         ht,
+            int         outputFormat)
+{
+    usbcam_conv_t *conv = (usbcam_conv_t *)conv_obj;
+    int numBands, rowPairs;
+
+    if(!conv || conv->numThreads == 0 || wd * ht < USBCAM_CONV_MT_MIN_PIXELS ||
+       pthread_mutex_trylock(&conv->submitMutex))
+        return usbCamConvertYUYVRows(in_buf, out_buf, wd, ht, 0, ht,
+                                     outputFormat);
+
+    if(!in_buf || !out_buf || wd <= 0 || (wd & 1) || ht <= 0) {
+        pthread_mutex_unlock(&conv->submitMutex);
+        ALOGE("%s: invalid arguments", __func__);
+        return USBCAM_CONV_ERROR;
+    }
+
+    /* Bands start on even rows so each owns its rows of the chroma plane */
+    numBands = conv->numThreads + 1;
+    rowPairs = (ht + 1) / 2;
+
+    pthread_mutex_lock(&conv->mutex);
+    conv->job.in            = (const uint8_t *)in_buf;
+    conv->job.out           = (uint8_t *)out_buf;
+    conv->job.wd            = wd;
+    conv->job.ht            = ht;
+    conv->job.outputFormat  = outputFormat;
+    conv->job.numBands      = numBands;
+    conv->job.rowsPerBand   = ((rowPairs + numBands - 1) / numBands) * 2;
+    conv->pending           = conv->numThreads;
+    conv->generation++;
+    pthread_cond_broadcast(&conv->startCond);
+    pthread_mutex_unlock(&conv->mutex);
+
+    convert_band(&conv->job, 0);
+
+    pthread_mutex_lock(&conv->mutex);
+    while(conv->pending)
+        pthread_cond_wait(&conv->doneCond, &conv->mutex);
+    pthread_mutex_unlock(&conv->mutex);
+
+    pthread_mutex_unlock(&conv->submitMutex);
+    return USBCAM_CONV_NO_ERROR;
+}
@@ -39,12 +39,14 @@
 #include <sys/prctl.h>
 #include <sys/resource.h>
 #include <pthread.h>
+#include <time.h>
 #include <linux/uvcvideo.h>
 
 #include "QCameraHAL.h"
 #include "QualcommUsbCamera.h"
 #include "QCameraUsbPriv.h"
 #include "QCameraMjpegDecode.h"
+#include "QCameraUsbConvert.h"
 #include "QCameraUsbParm.h"
 #include <gralloc_priv.h>
 #include <genlock.h>
@@ -93,6 +95,8 @@ camera_device_ops_t usbcam_camera_ops = {
 #define JPEG_ON_USB_CAMERA      1
 #define FILE_DUMP_CAMERA        0
 #define FILE_DUMP_B4_DISP       0
+#define CAPTURE_TO_DISPLAY      1
+#define MJPEG_PIPELINE          1
 
 namespace android {
 
@@ -103,6 +107,10 @@ static int startUsbCamCapture(          camera_hardware_t *camHal);
 static int stopUsbCamCapture(           camera_hardware_t *camHal);
 static int initV4L2mmap(                camera_hardware_t *camHal);
 static int unInitV4L2mmap(              camera_hardware_t *camHal);
+static int canCaptureToDisplay(         camera_hardware_t *camHal,
+                                        struct v4l2_format *v4l2format);
+static int initV4L2DisplayBufs(         camera_hardware_t *camHal);
+static int startPreviewInternal(        camera_hardware_t *camHal);
 static int launch_preview_thread(       camera_hardware_t *camHal);
 static int launchTakePictureThread(     camera_hardware_t *camHal);
 static int initDisplayBuffers(          camera_hardware_t *camHal);
@@ -113,10 +121,18 @@ static int put_buf_to_cam(              camera_hardware_t *camHal);
 static int prvwThreadTakePictureInternal(camera_hardware_t *camHal);
 static int get_buf_from_display( camera_hardware_t *camHal, int *buffer_id);
 static int put_buf_to_display(   camera_hardware_t *camHal, int buffer_id);
+static int put_disp_buf_to_cam(  camera_hardware_t *camHal, int buffer_id);
+static int fill_cam_with_disp_bufs(camera_hardware_t *camHal);
+static int cancel_disp_buf(      camera_hardware_t *camHal, int buffer_id);
+static uint32_t getTimeUs(void);
 static int convert_data_frm_cam_to_disp(camera_hardware_t *camHal, int buffer_id);
+static int queue_mjpeg_frame(    camera_hardware_t *camHal, int camBufRc,
+                                 int buffer_id);
+static int get_decoded_mjpeg_frame(camera_hardware_t *camHal, int *buffer_id);
+static void release_mjpeg_frame( camera_hardware_t *camHal, int cookie);
+static void flush_mjpeg_frames(  camera_hardware_t *camHal);
 static void * previewloop(void *);
 static void * takePictureThread(void *);
-static int convert_YUYV_to_420_NV12(char *in_buf, char *out_buf, int wd, int ht);
 static int get_uvc_device(char *devname);
 static int getPreviewCaptureFmt(camera_hardware_t *camHal);
 static int allocate_ion_memory(QCameraHalMemInfo_t *mem_info, int ion_type);
@@ -248,6 +264,14 @@ extern "C"  int usbcam_close_camera_device( hw_device_t *hw_dev)
                 ALOGE("%s: close failed ", __func__);
             }
             camHal->fd = 0;
+            if(camHal->yuyvConv) {
+                usbCamConvertDestroy(camHal->yuyvConv);
+                camHal->yuyvConv = NULL;
+            }
+            if(camHal->mjpegd) {
+                mjpegDecoderDestroy(camHal->mjpegd);
+                camHal->mjpegd = NULL;
+            }
             delete camHal;
         }else{
                 ALOGE("%s: camHal is NULL pointer ", __func__);
@@ -262,11 +286,27 @@ int usbcam_set_preview_window(struct camera_device * device,
 {
     ALOGI("%s: E", __func__);
     int rc = 0;
+    int restartPreview = 0;
     camera_hardware_t *camHal;
 
     VALIDATE_DEVICE_HDL(camHal, device, -1);
     Mutex::Autolock autoLock(camHal->lock);
 
+    /* The camera or the MJPEG decoder may hold display buffers of the  */
+    /* previous window. Stop the capture to get them back and restart it */
+    /* on the new window.                                                */
+    if(camHal->previewEnabledFlag && (USB_CAM_CAPTURE_TO_DISPLAY(camHal)
+#if MJPEG_PIPELINE
+        || (V4L2_PIX_FMT_MJPEG == camHal->captureFormat)
+#endif
+        )){
+        rc = stopPreviewInternal(camHal);
+        if(rc < 0) {
+            ALOGE("%s: stopPreviewInternal returned error", __func__);
+        }
+        restartPreview = 1;
+    }
+
     /* if window is already set, then de-init previous buffers */
     if(camHal->window){
         rc = deInitDisplayBuffers(camHal);
@@ -282,6 +322,13 @@ int usbcam_set_preview_window(struct camera_device * device,
             ALOGE("%s: initDisplayBuffers returned error", __func__);
         }
     }
+
+    if(restartPreview){
+        rc = startPreviewInternal(camHal);
+        if(rc < 0) {
+            ALOGE("%s: startPreviewInternal returned error", __func__);
+        }
+    }
     ALOGI("%s: X. rc = %d", __func__, rc);
     return rc;
 }
@@ -389,31 +436,7 @@ int usbcam_start_preview(struct camera_device * device)
         return 0;
     }
 
-#if CAPTURE
-    rc = initUsbCamera(camHal, camHal->prevWidth,
-                        camHal->prevHeight, getPreviewCaptureFmt(camHal));
-    if(rc < 0) {
-        ALOGE("%s: Failed to intialize the device", __func__);
-    }else{
-        rc = startUsbCamCapture(camHal);
-        if(rc < 0) {
-            ALOGE("%s: Failed to startUsbCamCapture", __func__);
-        }else{
-            rc = launch_preview_thread(camHal);
-            if(rc < 0) {
-                ALOGE("%s: Failed to launch_preview_thread", __func__);
-            }
-        }
-    }
-#else /* CAPTURE */
-    rc = launch_preview_thread(camHal);
-    if(rc < 0) {
-        ALOGE("%s: Failed to launch_preview_thread", __func__);
-    }
-#endif /* CAPTURE */
-    /* if no errors, then set the flag */
-    if(!rc)
-        camHal->previewEnabledFlag = 1;
+    rc = startPreviewInternal(camHal);
 
     ALOGD("%s: X", __func__);
     return rc;
@@ -690,6 +713,38 @@ int usbcam_dump(struct camera_device * device, int fd)
 {
     ALOGI("%s: E", __func__);
     int rc = 0;
+    camera_hardware_t *camHal;
+    usbcam_xfer_stats_t *stats;
+    mjpegd_stats_t mjpegStats;
+    const char *memory;
+
+    VALIDATE_DEVICE_HDL(camHal, device, -1);
+    Mutex::Autolock autoLock(camHal->lock);
+
+    stats = &camHal->prvwXferStats;
+    if(V4L2_MEMORY_DMABUF == camHal->captureMemory)
+        memory = "dmabuf (display buffers)";
+    else if(V4L2_MEMORY_USERPTR == camHal->captureMemory)
+        memory = "userptr (display buffers)";
+    else
+        memory = "mmap";
+
+    dprintf(fd, "USB camera %s\n", camHal->dev_name);
+    dprintf(fd, "  preview: %s, %dx%d, capture format 0x%x, memory %s\n",
+        camHal->previewEnabledFlag ? "on" : "off",
+        camHal->prevWidth, camHal->prevHeight,
+        camHal->captureFormat, memory);
+    dprintf(fd, "  capture to display: %u frames, last %u us, avg %llu us,"
+        " max %u us\n", stats->frames, stats->lastUs,
+        stats->frames ? (unsigned long long)(stats->totalUs / stats->frames) : 0ULL,
+        stats->maxUs);
+    if(camHal->mjpegd && !mjpegDecoderGetStats(camHal->mjpegd, &mjpegStats))
+        dprintf(fd, "  mjpeg decode: %u submitted, %u decoded, %u dropped,"
+            " %u failed, %.1f fps, latency avg %u us max %u us,"
+            " decode avg %u us\n",
+            mjpegStats.submitted, mjpegStats.decoded, mjpegStats.dropped,
+            mjpegStats.failed, mjpegStats.fps, mjpegStats.avgLatencyUs,
+            mjpegStats.maxLatencyUs, mjpegStats.avgDecodeUs);
 
     ALOGI("%s: X", __func__);
     return rc;
@@ -698,48 +753,6 @@ int usbcam_dump(struct camera_device * device, int fd)
 *  Static function definitions below
 *****************************************************************************/
 
-/******************************************************************************/
-/* No in place conversion supported. Output buffer and input MUST should be   */
-/* different input buffer for a 4x4 pixel video                             ***/
-/******                  YUYVYUYV          00 01 02 03 04 05 06 07 ************/
-/******                  YUYVYUYV          08 09 10 11 12 13 14 15 ************/
-/******                  YUYVYUYV          16 17 18 19 20 21 22 23 ************/
-/******                  YUYVYUYV          24 25 26 27 28 29 30 31 ************/
-/******************************************************************************/
-/* output generated by this function ******************************************/
-/************************** YYYY            00 02 04 06            ************/
-/************************** YYYY            08 10 12 14            ************/
-/************************** YYYY            16 18 20 22            ************/
-/************************** YYYY            24 26 28 30            ************/
-/************************** VUVU            03 01 07 05            ************/
-/************************** VUVU            19 17 23 21            ************/
-/******************************************************************************/
-
-static int convert_YUYV_to_420_NV12(char *in_buf, char *out_buf, int wd, int ht)
-{
-    int rc =0;
-    int row, col, uv_row;
-
-    ALOGD("%s: E", __func__);
-    /* Arrange Y */
-    for(row = 0; row < ht; row++)
-        for(col = 0; col < wd * 2; col += 2)
-        {
-            out_buf[row * wd + col / 2] = in_buf[row * wd * 2 + col];
-        }
-
-    /* Arrange UV */
-    for(row = 0, uv_row = ht; row < ht; row += 2, uv_row++)
-        for(col = 1; col < wd * 2; col += 4)
-        {
-            out_buf[uv_row * wd + col / 2]= in_buf[row * wd * 2 + col + 2];
-            out_buf[uv_row * wd + col / 2 + 1]  = in_buf[row * wd * 2 + col];
-        }
-
-    ALOGD("%s: X", __func__);
-    return rc;
-}
-
 /******************************************************************************
  * Function: initDisplayBuffers
  * Description: This function initializes the preview buffers
@@ -1062,6 +1075,7 @@ static int deInitDisplayBuffers(camera_hardware_t *camHal)
 static int getPreviewCaptureFmt(camera_hardware_t *camHal)
 {
     int     i = 0, mjpegSupported = 0, h264Supported = 0;
+    int     nv21Supported = 0, nv12Supported = 0;
     struct v4l2_fmtdesc fmtdesc;
 
     memset(&fmtdesc, 0, sizeof(v4l2_fmtdesc));
@@ -1093,6 +1107,14 @@ static int getPreviewCaptureFmt(camera_hardware_t *camHal)
             h264Supported = 1;
             ALOGI("%s: V4L2_PIX_FMT_H264 is supported", __func__ );
         }
+        if(V4L2_PIX_FMT_NV21 == fmtdesc.pixelformat){
+            nv21Supported = 1;
+            ALOGI("%s: V4L2_PIX_FMT_NV21 is supported", __func__ );
+        }
+        if(V4L2_PIX_FMT_NV12 == fmtdesc.pixelformat){
+            nv12Supported = 1;
+            ALOGI("%s: V4L2_PIX_FMT_NV12 is supported", __func__ );
+        }
 
     }
 
@@ -1101,15 +1123,23 @@ static int getPreviewCaptureFmt(camera_hardware_t *camHal)
     /************************************************************************/
     //V4L2_PIX_FMT_MJPEG; V4L2_PIX_FMT_YUYV; V4L2_PIX_FMT_H264 = 0x34363248;
     camHal->captureFormat = V4L2_PIX_FMT_YUYV;
+    /* Semi-planar 4:2:0 frames can be captured into the display buffers */
+    if(HAL_PIXEL_FORMAT_YCrCb_420_SP == camHal->dispFormat){
+        if(1 == nv21Supported)
+            camHal->captureFormat = V4L2_PIX_FMT_NV21;
+        else if(1 == nv12Supported)
+            camHal->captureFormat = V4L2_PIX_FMT_NV12;
+    }
     if(camHal->prevWidth > 640){
         if(1 == mjpegSupported)
             camHal->captureFormat = V4L2_PIX_FMT_MJPEG;
         else if(1 == h264Supported)
             camHal->captureFormat = V4L2_PIX_FMT_H264;
     }
-    ALOGI("%s: Capture format chosen: 0x%x. 0x%x:YUYV. 0x%x:MJPEG. 0x%x: H264",
-        __func__, camHal->captureFormat, V4L2_PIX_FMT_YUYV,
-        V4L2_PIX_FMT_MJPEG, V4L2_PIX_FMT_H264);
+    ALOGI("%s: Capture format chosen: 0x%x. 0x%x:YUYV. 0x%x:MJPEG. 0x%x: H264"
+        " 0x%x:NV21. 0x%x:NV12", __func__, camHal->captureFormat,
+        V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_MJPEG, V4L2_PIX_FMT_H264,
+        V4L2_PIX_FMT_NV21, V4L2_PIX_FMT_NV12);
 
     return camHal->captureFormat;
 }
@@ -1236,6 +1266,7 @@ static int initV4L2mmap(camera_hardware_t *camHal)
         if (MAP_FAILED == camHal->buffers[camHal->n_buffers].data)
             ALOGE("%s: mmap failed", __func__);
     }
+    camHal->captureMemory = V4L2_MEMORY_MMAP;
     ALOGD("%s: X", __func__);
     return 0;
 }
@@ -1258,6 +1289,33 @@ static int unInitV4L2mmap(camera_hardware_t *camHal)
     int i, rc = 0;
     ALOGD("%s: E", __func__);
 
+    if(USB_CAM_CAPTURE_TO_DISPLAY(camHal)) {
+        struct v4l2_requestbuffers  reqBufs;
+
+        /* Streaming is off, so buffers still queued to the camera are */
+        /* back with the HAL. Return them to the display unfilled.     */
+        for (i = 0; i < camHal->n_buffers; i++)
+            if(camHal->capBufQueued & (1U << i))
+                cancel_disp_buf(camHal, i);
+        camHal->capBufQueued = 0;
+
+        memset(&reqBufs, 0, sizeof(v4l2_requestbuffers));
+        reqBufs.type    = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        reqBufs.memory  = camHal->captureMemory;
+        reqBufs.count   = 0;
+        if (-1 == ioctlLoop(camHal->fd, VIDIOC_REQBUFS, &reqBufs)) {
+            ALOGE("%s: VIDIOC_REQBUFS(0) failed", __func__);
+            rc = -1;
+        }
+
+        free(camHal->buffers);
+        camHal->buffers         = NULL;
+        camHal->n_buffers       = 0;
+        camHal->captureMemory   = V4L2_MEMORY_MMAP;
+        ALOGD("%s: X", __func__);
+        return rc;
+    }
+
     for (i = 0; i < camHal->n_buffers; i++)
         if (-1 == munmap(camHal->buffers[i].data, camHal->buffers[i].len)){
             ALOGE("%s: munmap failed for buffer: %d", __func__, i);
@@ -1268,6 +1326,121 @@ static int unInitV4L2mmap(camera_hardware_t *camHal)
     return rc;
 }
 
+/******************************************************************************
+ * Function: canCaptureToDisplay
+ * Description: This function checks if the negotiated capture format can be
+ *              written by the camera straight into the display buffers
+ *
+ * Input parameters:
+ *   camHal              - camera HAL handle
+ *   v4l2format          - format returned by VIDIOC_S_FMT
+ *
+ * Return values:
+ *   1      Display buffers can be used as capture buffers
+ *   0      Capture into V4L2 driver buffers
+ *
+ * Notes: The display buffers are assumed to be packed, with the chroma
+ *        plane right after the luma plane, as the conversion routines do
+ *****************************************************************************/
+static int canCaptureToDisplay(camera_hardware_t *camHal,
+                               struct v4l2_format *v4l2format)
+{
+#if CAPTURE_TO_DISPLAY && DISPLAY
+    struct v4l2_pix_format *pix = &v4l2format->fmt.pix;
+    int i;
+
+    if(!camHal->window || camHal->previewMem.buffer_count <= 0 ||
+       camHal->previewMem.buffer_count > 32)
+        return 0;
+
+    if((V4L2_PIX_FMT_NV21 != pix->pixelformat) &&
+       (V4L2_PIX_FMT_NV12 != pix->pixelformat))
+        return 0;
+
+    if(((int)pix->width != camHal->dispWidth) ||
+       ((int)pix->height != camHal->dispHeight) ||
+       (pix->bytesperline && (pix->bytesperline != pix->width)))
+        return 0;
+
+    for(i = 0; i < camHal->previewMem.buffer_count; i++) {
+        struct private_handle_t *hdl =
+            camHal->previewMem.private_buffer_handle[i];
+
+        if(!hdl || !camHal->previewMem.camera_memory[i] ||
+           (hdl->offset != 0) || (hdl->size < (int)pix->sizeimage) ||
+           (camHal->previewMem.stride[i] != camHal->dispWidth))
+            return 0;
+    }
+    return 1;
+#else
+    return 0;
+#endif /* CAPTURE_TO_DISPLAY && DISPLAY */
+}
+
+/******************************************************************************
+ * Function: initV4L2DisplayBufs
+ * Description: This function sets up the display buffers as V4L2 capture
+ *              buffers. DMABUF is tried first, then USERPTR.
+ *
+ * Input parameters:
+ *   camHal              - camera HAL handle
+ *
+ * Return values:
+ *   0      No error
+ *   -1     Error, neither memory type is supported
+ *
+ * Notes: Capture buffer i is display buffer i
+ *****************************************************************************/
+static int initV4L2DisplayBufs(camera_hardware_t *camHal)
+{
+    static const int memTypes[] = {V4L2_MEMORY_DMABUF, V4L2_MEMORY_USERPTR};
+    struct v4l2_requestbuffers  reqBufs;
+    unsigned int                i, cnt = camHal->previewMem.buffer_count;
+
+    ALOGD("%s: E", __func__);
+
+    for(i = 0; i < sizeof(memTypes) / sizeof(memTypes[0]); i++) {
+        memset(&reqBufs, 0, sizeof(v4l2_requestbuffers));
+        reqBufs.type    = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        reqBufs.memory  = memTypes[i];
+        reqBufs.count   = cnt;
+
+        if (-1 == ioctlLoop(camHal->fd, VIDIOC_REQBUFS, &reqBufs)) {
+            ALOGI("%s: memory type %d not supported", __func__, memTypes[i]);
+            continue;
+        }
+        if (reqBufs.count >= cnt)
+            break;
+
+        ALOGI("%s: memory type %d: only %d buffers", __func__,
+            memTypes[i], reqBufs.count);
+        reqBufs.count = 0;
+        ioctlLoop(camHal->fd, VIDIOC_REQBUFS, &reqBufs);
+    }
+    if(i == sizeof(memTypes) / sizeof(memTypes[0]))
+        return -1;
+
+    camHal->buffers = (bufObj *)calloc(cnt, sizeof(bufObj));
+    if (!camHal->buffers) {
+        ALOGE("%s: Out of memory\n", __func__);
+        reqBufs.count = 0;
+        ioctlLoop(camHal->fd, VIDIOC_REQBUFS, &reqBufs);
+        return -1;
+    }
+    for (camHal->n_buffers = 0; camHal->n_buffers < cnt; camHal->n_buffers++) {
+        camHal->buffers[camHal->n_buffers].data =
+            camHal->previewMem.camera_memory[camHal->n_buffers]->data;
+        camHal->buffers[camHal->n_buffers].len =
+            camHal->previewMem.private_buffer_handle[camHal->n_buffers]->size;
+    }
+    camHal->captureMemory   = memTypes[i];
+    camHal->capBufQueued    = 0;
+
+    ALOGI("%s: X, capturing into %d display buffers, memory type %d",
+        __func__, cnt, camHal->captureMemory);
+    return 0;
+}
+
 /******************************************************************************
  * Function: initUsbCamera
  * Description: This function sets the resolution and pixel format of the
@@ -1370,7 +1543,11 @@ static int initUsbCamera(camera_hardware_t *camHal, int width, int height,
     /* might have to be calculated as per V4L2 sample application due to */
     /* open source driver bug */
 
-    rc = initV4L2mmap(camHal);
+    rc = -1;
+    if(canCaptureToDisplay(camHal, &v4l2format))
+        rc = initV4L2DisplayBufs(camHal);
+    if(rc < 0)
+        rc = initV4L2mmap(camHal);
     ALOGI("%s: X", __func__);
     return rc;
 }
@@ -1396,18 +1573,22 @@ static int startUsbCamCapture(camera_hardware_t *camHal)
     enum        v4l2_buf_type   v4l2BufType;
     ALOGD("%s: E", __func__);
 
-    for (i = 0; i < camHal->n_buffers; ++i) {
-        struct v4l2_buffer tempBuf;
-
-        memset(&tempBuf, 0, sizeof(tempBuf));
-        tempBuf.type    = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        tempBuf.memory  = V4L2_MEMORY_MMAP;
-        tempBuf.index   = i;
-
-        if (-1 == ioctlLoop(camHal->fd, VIDIOC_QBUF, &tempBuf))
-            ALOGE("%s: VIDIOC_QBUF for %d buffer failed", __func__, i);
-        else
-            ALOGD("%s: VIDIOC_QBUF for %d buffer success", __func__, i);
+    if (USB_CAM_CAPTURE_TO_DISPLAY(camHal)) {
+        fill_cam_with_disp_bufs(camHal);
+    } else {
+        for (i = 0; i < camHal->n_buffers; ++i) {
+            struct v4l2_buffer tempBuf;
+
+            memset(&tempBuf, 0, sizeof(tempBuf));
+            tempBuf.type    = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            tempBuf.memory  = V4L2_MEMORY_MMAP;
+            tempBuf.index   = i;
+
+            if (-1 == ioctlLoop(camHal->fd, VIDIOC_QBUF, &tempBuf))
+                ALOGE("%s: VIDIOC_QBUF for %d buffer failed", __func__, i);
+            else
+                ALOGD("%s: VIDIOC_QBUF for %d buffer success", __func__, i);
+        }
     }
 
     v4l2BufType = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -1460,6 +1641,56 @@ static int stopUsbCamCapture(camera_hardware_t *camHal)
     return rc;
 }
 
+/******************************************************************************
+ * Function: startPreviewInternal
+ * Description: This function starts the camera capture and preview thread
+ *
+ * Input parameters:
+ *   camHal              - camera HAL handle
+ *
+ * Return values:
+ *   0      No error
+ *   -1     Error
+ *
+ * Notes: Called with camHal->lock held
+ *****************************************************************************/
+static int startPreviewInternal(camera_hardware_t *camHal)
+{
+    int rc = -1;
+    ALOGD("%s: E", __func__);
+
+    memset(&camHal->prvwXferStats, 0, sizeof(camHal->prvwXferStats));
+
+#if CAPTURE
+    rc = initUsbCamera(camHal, camHal->prevWidth,
+                        camHal->prevHeight, getPreviewCaptureFmt(camHal));
+    if(rc < 0) {
+        ALOGE("%s: Failed to intialize the device", __func__);
+    }else{
+        rc = startUsbCamCapture(camHal);
+        if(rc < 0) {
+            ALOGE("%s: Failed to startUsbCamCapture", __func__);
+        }else{
+            rc = launch_preview_thread(camHal);
+            if(rc < 0) {
+                ALOGE("%s: Failed to launch_preview_thread", __func__);
+            }
+        }
+    }
+#else /* CAPTURE */
+    rc = launch_preview_thread(camHal);
+    if(rc < 0) {
+        ALOGE("%s: Failed to launch_preview_thread", __func__);
+    }
+#endif /* CAPTURE */
+    /* if no errors, then set the flag */
+    if(!rc)
+        camHal->previewEnabledFlag = 1;
+
+    ALOGD("%s: X, rc: %d", __func__, rc);
+    return rc;
+}
+
 /******************************************************************************
  * Function: stopPreviewInternal
  * Description: This function sends EXIT command to prview loop thread,
@@ -1693,7 +1924,7 @@ static int get_buf_from_cam(camera_hardware_t *camHal)
         memset(&camHal->curCaptureBuf, 0, sizeof(camHal->curCaptureBuf));
 
         camHal->curCaptureBuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        camHal->curCaptureBuf.memory = V4L2_MEMORY_MMAP;
+        camHal->curCaptureBuf.memory = camHal->captureMemory;
 
         if (-1 == ioctlLoop(camHal->fd, VIDIOC_DQBUF, &camHal->curCaptureBuf)){
             switch (errno) {
@@ -1713,6 +1944,7 @@ static int get_buf_from_cam(camera_hardware_t *camHal)
         else
         {
             rc = 0;
+            camHal->capBufQueued &= ~(1U << camHal->curCaptureBuf.index);
             ALOGD("%s: VIDIOC_DQBUF: %d successful, %d bytes",
                  __func__, camHal->curCaptureBuf.index,
                  camHal->curCaptureBuf.bytesused);
@@ -1740,6 +1972,9 @@ static int put_buf_to_cam(camera_hardware_t *camHal)
 {
     ALOGD("%s: E", __func__);
 
+    if(USB_CAM_CAPTURE_TO_DISPLAY(camHal))
+        return put_disp_buf_to_cam(camHal, camHal->curCaptureBuf.index);
+
     camHal->curCaptureBuf.type        = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     camHal->curCaptureBuf.memory      = V4L2_MEMORY_MMAP;
 
@@ -1902,6 +2137,131 @@ static int put_buf_to_display(camera_hardware_t *camHal, int buffer_id)
     return err;
 }
 
+/******************************************************************************
+ * Function: put_disp_buf_to_cam
+ * Description: This funtion queues 1 display buffer to the camera driver
+ *              when capturing straight into the display buffers
+ *
+ * Input parameters:
+ *  camHal                  - camera HAL handle
+ *  buffer_id               - id of the display buffer
+ *
+ * Return values:
+ *   0      No error
+ *   1      Error
+ *
+ * Notes: The buffer stays genlocked for write while the camera owns it
+ *****************************************************************************/
+static int put_disp_buf_to_cam(camera_hardware_t *camHal, int buffer_id)
+{
+    struct v4l2_buffer  tempBuf;
+
+    memset(&tempBuf, 0, sizeof(tempBuf));
+    tempBuf.type    = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    tempBuf.memory  = camHal->captureMemory;
+    tempBuf.index   = buffer_id;
+    tempBuf.length  = camHal->buffers[buffer_id].len;
+    if(V4L2_MEMORY_DMABUF == camHal->captureMemory)
+        tempBuf.m.fd =
+            camHal->previewMem.private_buffer_handle[buffer_id]->fd;
+    else
+        tempBuf.m.userptr = (unsigned long)camHal->buffers[buffer_id].data;
+
+    if (-1 == ioctlLoop(camHal->fd, VIDIOC_QBUF, &tempBuf)) {
+        ALOGE("%s: VIDIOC_QBUF for display buffer %d failed",
+            __func__, buffer_id);
+        /* Give it back so the display does not run out of buffers */
+        cancel_disp_buf(camHal, buffer_id);
+        return 1;
+    }
+    camHal->capBufQueued |= 1U << buffer_id;
+    return 0;
+}
+
+/******************************************************************************
+ * Function: fill_cam_with_disp_bufs
+ * Description: This funtion dequeues display buffers and queues them to the
+ *              camera until the camera holds all the buffers the HAL may
+ *              keep dequeued from the display window
+ *
+ * Input parameters:
+ *  camHal                  - camera HAL handle
+ *
+ * Return values:
+ *   0      No error
+ *   -1     Error
+ *
+ * Notes: none
+ *****************************************************************************/
+static int fill_cam_with_disp_bufs(camera_hardware_t *camHal)
+{
+    while(__builtin_popcount(camHal->capBufQueued) < PRVW_DISP_BUF_CNT) {
+        int buffer_id = -1;
+
+        if(get_buf_from_display(camHal, &buffer_id) || buffer_id < 0) {
+            ALOGE("%s: get_buf_from_display failed", __func__);
+            return -1;
+        }
+        if(put_disp_buf_to_cam(camHal, buffer_id))
+            return -1;
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Function: cancel_disp_buf
+ * Description: This funtion returns 1 display buffer held by the HAL to the
+ *              display window without displaying it
+ *
+ * Input parameters:
+ *  camHal                  - camera HAL handle
+ *  buffer_id               - id of the display buffer
+ *
+ * Return values:
+ *   0      No error
+ *   -1     Error
+ *
+ * Notes: none
+ *****************************************************************************/
+static int cancel_disp_buf(camera_hardware_t *camHal, int buffer_id)
+{
+    int err;
+
+    if(!camHal->window)
+        return -1;
+
+    if (GENLOCK_FAILURE == genlock_unlock_buffer(
+            (native_handle_t *)(*(camHal->previewMem.buffer_handle[buffer_id]))))
+        ALOGE("%s: genlock_unlock_buffer failed: hdl =%p", __func__,
+            (*(camHal->previewMem.buffer_handle[buffer_id])));
+
+    err = camHal->window->cancel_buffer(camHal->window,
+        (buffer_handle_t *)camHal->previewMem.buffer_handle[buffer_id]);
+    if(err)
+        ALOGE("%s: cancel_buffer failed: %p\n", __func__,
+             camHal->previewMem.buffer_handle[buffer_id]);
+    return err;
+}
+
+/******************************************************************************
+ * Function: getTimeUs
+ * Description: This function returns the monotonic time in microseconds
+ *
+ * Input parameters: none
+ *
+ * Return values:
+ *   time in microseconds, wraps around
+ *
+ * Notes: none
+ *****************************************************************************/
+static uint32_t getTimeUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000LL + ts.tv_nsec / 1000);
+}
+
 /******************************************************************************
  * Function: put_buf_to_display
  * Description: This funtion transfers the content from capture buffer to
@@ -1930,17 +2290,43 @@ static int convert_data_frm_cam_to_disp(camera_hardware_t *camHal, int buffer_id
     if( (V4L2_PIX_FMT_YUYV == camHal->captureFormat) &&
         (HAL_PIXEL_FORMAT_YCrCb_420_SP == camHal->dispFormat))
     {
-        convert_YUYV_to_420_NV12(
+        if(NULL == camHal->yuyvConv)
+        {
+            rc = usbCamConvertInit(&camHal->yuyvConv, USB_CAM_CONV_THREADS);
+            if(rc < 0)
+                ALOGE("%s: usbCamConvertInit Error: %d", __func__, rc);
+        }
+        /* A NULL converter still converts, on the preview thread only */
+        usbCamConvertYUYV(
+            camHal->yuyvConv,
             (char *)camHal->buffers[camHal->curCaptureBuf.index].data,
             (char *)camHal->previewMem.camera_memory[buffer_id]->data,
             camHal->prevWidth,
-            camHal->prevHeight);
+            camHal->prevHeight,
+            USBCAM_CONV_OUT_NV21);
         ALOGD("%s: Copied %d bytes from camera buffer %d to display buffer: %d",
              __func__, camHal->curCaptureBuf.bytesused,
              camHal->curCaptureBuf.index, buffer_id);
         rc = 0;
     }
 
+    /* Semi-planar capture: at most the chroma order needs fixing. When */
+    /* capturing into the display buffers, source and destination match */
+    if( ((V4L2_PIX_FMT_NV21 == camHal->captureFormat) ||
+         (V4L2_PIX_FMT_NV12 == camHal->captureFormat)) &&
+        (HAL_PIXEL_FORMAT_YCrCb_420_SP == camHal->dispFormat))
+    {
+        char *src = (char *)camHal->buffers[camHal->curCaptureBuf.index].data;
+        char *dst = (char *)camHal->previewMem.camera_memory[buffer_id]->data;
+
+        rc = 0;
+        if(V4L2_PIX_FMT_NV12 == camHal->captureFormat)
+            rc = usbCamConvertNV12toNV21(src, dst,
+                    camHal->prevWidth, camHal->prevHeight);
+        else if(src != dst)
+            memcpy(dst, src, camHal->prevWidth * camHal->prevHeight * 3 / 2);
+    }
+
     /* If camera buffer is MJPEG encoded, call mjpeg decode call */
     if(V4L2_PIX_FMT_MJPEG == camHal->captureFormat)
     {
@@ -1967,6 +2353,160 @@ static int convert_data_frm_cam_to_disp(camera_hardware_t *camHal, int buffer_id
     return rc;
 }
 
+#if MJPEG_PIPELINE
+/******************************************************************************
+ * Function: queue_mjpeg_frame
+ * Description: This function hands the MJPEG frame just dequeued from the
+ *              camera to the decoder, to be decoded into the display buffer
+ *              while the preview thread goes on with the next frame
+ *
+ * Input parameters:
+ *  camHal                  - camera HAL handle
+ *  camBufRc                - return value of get_buf_from_cam
+ *  buffer_id               - id of the display buffer to decode into
+ *
+ * Return values:
+ *   0      No error
+ *   -1     Error
+ *
+ * Notes: On error the display and capture buffers are given back
+ *****************************************************************************/
+static int queue_mjpeg_frame(camera_hardware_t *camHal, int camBufRc,
+                             int buffer_id)
+{
+    mjpegd_frame_t frame;
+    int rc = -1;
+
+    if(NULL == camHal->mjpegd)
+    {
+        rc = mjpegDecoderInit(&camHal->mjpegd);
+        if(rc < 0)
+            ALOGE("%s: mjpegDecoderInit Error: %d", __func__, rc);
+    }
+
+    if(0 == camBufRc && camHal->mjpegd)
+    {
+        memset(&frame, 0, sizeof(frame));
+        frame.mjpegBuffer       =
+            (char *)camHal->buffers[camHal->curCaptureBuf.index].data;
+        frame.mjpegBufferSize   = camHal->curCaptureBuf.bytesused;
+        frame.outputYptr        =
+            (char *)camHal->previewMem.camera_memory[buffer_id]->data;
+        frame.outputUVptr       = frame.outputYptr +
+            camHal->prevWidth * camHal->prevHeight;
+        frame.outputFormat      = getMjpegdOutputFormat(camHal->dispFormat);
+        frame.cookie            = (camHal->curCaptureBuf.index << 8) | buffer_id;
+
+        rc = mjpegDecodeSubmit(camHal->mjpegd, &frame);
+        if(rc < 0)
+            ALOGE("%s: mjpegDecodeSubmit Error: %d", __func__, rc);
+        else
+            return 0;
+    }
+
+    cancel_disp_buf(camHal, buffer_id);
+    if(0 == camBufRc && put_buf_to_cam(camHal))
+        ALOGE("%s: put_buf_to_cam error", __func__);
+    return -1;
+}
+
+/******************************************************************************
+ * Function: get_decoded_mjpeg_frame
+ * Description: This function returns the newest frame decoded by the MJPEG
+ *              decoder. Older frames, and the ones the decoder dropped or
+ *              failed on, are given back on the way.
+ *
+ * Input parameters:
+ *  camHal                  - camera HAL handle
+ *  buffer_id               - display buffer holding the decoded frame, on
+ *                              success. curCaptureBuf is set to its capture
+ *                              buffer.
+ *
+ * Return values:
+ *   0      No error
+ *   -1     No decoded frame
+ *
+ * Notes: Does not wait for the decoder
+ *****************************************************************************/
+static int get_decoded_mjpeg_frame(camera_hardware_t *camHal, int *buffer_id)
+{
+    mjpegd_frame_t frame;
+    int cookie = -1;
+
+    if(!camHal->mjpegd)
+        return -1;
+
+    while(0 == mjpegDecodeGetDone(camHal->mjpegd, &frame, 0))
+    {
+        if(MJPEGD_FRAME_DECODED != frame.status) {
+            ALOGD("%s: frame %s", __func__,
+                MJPEGD_FRAME_DROPPED == frame.status ? "dropped" : "failed");
+            release_mjpeg_frame(camHal, frame.cookie);
+            continue;
+        }
+
+        /* Only the newest decoded frame is displayed */
+        if(cookie >= 0)
+            release_mjpeg_frame(camHal, cookie);
+        cookie = frame.cookie;
+    }
+    if(cookie < 0)
+        return -1;
+
+    *buffer_id = cookie & 0xff;
+    memset(&camHal->curCaptureBuf, 0, sizeof(camHal->curCaptureBuf));
+    camHal->curCaptureBuf.index = cookie >> 8;
+    return 0;
+}
+
+/******************************************************************************
+ * Function: release_mjpeg_frame
+ * Description: This function gives back the display and capture buffers of
+ *              a frame submitted to the MJPEG decoder, without displaying it
+ *
+ * Input parameters:
+ *  camHal                  - camera HAL handle
+ *  cookie                  - cookie of the frame
+ *
+ * Return values: none
+ *
+ * Notes: none
+ *****************************************************************************/
+static void release_mjpeg_frame(camera_hardware_t *camHal, int cookie)
+{
+    cancel_disp_buf(camHal, cookie & 0xff);
+
+    memset(&camHal->curCaptureBuf, 0, sizeof(camHal->curCaptureBuf));
+    camHal->curCaptureBuf.index = cookie >> 8;
+    if(put_buf_to_cam(camHal))
+        ALOGE("%s: put_buf_to_cam error", __func__);
+}
+
+/******************************************************************************
+ * Function: flush_mjpeg_frames
+ * Description: This function drops all the frames submitted to the MJPEG
+ *              decoder and gives back their buffers
+ *
+ * Input parameters:
+ *  camHal                  - camera HAL handle
+ *
+ * Return values: none
+ *
+ * Notes: Waits for the frame being decoded, if any
+ *****************************************************************************/
+static void flush_mjpeg_frames(camera_hardware_t *camHal)
+{
+    mjpegd_frame_t frame;
+
+    if(!camHal->mjpegd)
+        return;
+
+    mjpegDecodeFlush(camHal->mjpegd);
+    while(0 == mjpegDecodeGetDone(camHal->mjpegd, &frame, 0))
+        release_mjpeg_frame(camHal, frame.cookie);
+}
+#endif /* MJPEG_PIPELINE */
+
 /******************************************************************************
  * Function: launch_preview_thread
  * Description: This is a wrapper function to start preview thread
@@ -2022,6 +2562,8 @@ static void * previewloop(void *hcamHal)
     camera_memory_t     *data       = NULL;
     camera_frame_metadata_t *metadata= NULL;
     camera_memory_t     *previewMem = NULL;
+    int                 camBufRc    = -1;
+    int                 decoded     = 0;
 
     camHal = (camera_hardware_t *)hcamHal;
     ALOGD("%s: E", __func__);
@@ -2091,6 +2633,10 @@ static void * previewloop(void *hcamHal)
         {
             /* command is serviced. Hence command pending = 0  */
             camHal->prvwCmdPending--;
+#if MJPEG_PIPELINE
+            /* Give back the buffers of the frames still being decoded */
+            flush_mjpeg_frames(camHal);
+#endif
             //sempost(ack)
             if(USB_CAM_PREVIEW_EXIT == camHal->prvwCmd){
                 /* unlock before exiting the thread */
@@ -2116,7 +2662,10 @@ static void * previewloop(void *hcamHal)
     /************************************************************************/
     /* - Dequeue display buffer from surface                                */
     /************************************************************************/
-        if(0 == get_buf_from_display(camHal, &buffer_id)) {
+        /* When capturing into display buffers, the camera returns one */
+        if(USB_CAM_CAPTURE_TO_DISPLAY(camHal)) {
+            ALOGD("%s: display buffer comes from the camera", __func__);
+        }else if(0 == get_buf_from_display(camHal, &buffer_id)) {
             ALOGD("%s: get_buf_from_display success: %d",
                  __func__, buffer_id);
         }else{
@@ -2130,10 +2679,34 @@ static void * previewloop(void *hcamHal)
     /************************************************************************/
     /* - Dequeue capture buffer from USB camera                             */
     /************************************************************************/
-        if (0 == get_buf_from_cam(camHal))
+        camBufRc = get_buf_from_cam(camHal);
+        if (0 == camBufRc)
             ALOGD("%s: get_buf_from_cam success", __func__);
-        else
+        else if(USB_CAM_CAPTURE_TO_DISPLAY(camHal)) {
+            ALOGE("%s: get_buf_from_cam error. Skipping the loop", __func__);
+            /* Recover if an earlier queue failed and left the camera dry */
+            fill_cam_with_disp_bufs(camHal);
+            continue;
+        }else
             ALOGE("%s: get_buf_from_cam error", __func__);
+
+        if(USB_CAM_CAPTURE_TO_DISPLAY(camHal))
+            buffer_id = camHal->curCaptureBuf.index;
+#endif
+
+        decoded = 0;
+#if CAPTURE && MJPEG_PIPELINE
+    /************************************************************************/
+    /* - Hand MJPEG frame to the decoder, pick the newest decoded frame     */
+    /************************************************************************/
+        /* The frame decodes while the next one is captured. From here on */
+        /* buffer_id and curCaptureBuf refer to the newest decoded frame.  */
+        if(V4L2_PIX_FMT_MJPEG == camHal->captureFormat) {
+            queue_mjpeg_frame(camHal, camBufRc, buffer_id);
+            if(get_decoded_mjpeg_frame(camHal, &buffer_id))
+                continue;
+            decoded = 1;
+        }
 #endif
 
 #if FILE_DUMP_CAMERA
@@ -2159,7 +2732,18 @@ static void * previewloop(void *hcamHal)
         memset(camHal->previewMem.camera_memory[buffer_id]->data,
                color, camHal->dispWidth * camHal->dispHeight * 1.5 + 2 * 1024);
 #else
-        convert_data_frm_cam_to_disp(camHal, buffer_id);
+        if(!decoded) {
+            uint32_t xferUs = getTimeUs();
+
+            convert_data_frm_cam_to_disp(camHal, buffer_id);
+            xferUs = getTimeUs() - xferUs;
+
+            camHal->prvwXferStats.frames++;
+            camHal->prvwXferStats.lastUs    = xferUs;
+            camHal->prvwXferStats.totalUs  += xferUs;
+            if(xferUs > camHal->prvwXferStats.maxUs)
+                camHal->prvwXferStats.maxUs = xferUs;
+        }
         ALOGD("%s: Copied data to buffer_id: %d", __func__, buffer_id);
 #endif
 
@@ -2191,7 +2775,11 @@ static void * previewloop(void *hcamHal)
      /************************************************************************/
     /* - Enqueue capture buffer back to USB camera                          */
     /************************************************************************/
-       if(0 == put_buf_to_cam(camHal)) {
+        /* The display owns the captured frame now; queue a free display */
+        /* buffer to the camera in its place                             */
+        if(USB_CAM_CAPTURE_TO_DISPLAY(camHal)) {
+            fill_cam_with_disp_bufs(camHal);
+        }else if(0 == put_buf_to_cam(camHal)) {
             ALOGD("%s: put_buf_to_cam success", __func__);
         }
         else
@@ -2827,10 +3415,11 @@ int encodeJpeg(camera_hardware_t *camHal)
         return -1;
     }
 
-    rc = convert_YUYV_to_420_NV12(
+    rc = usbCamConvertYUYV(camHal->yuyvConv,
         (char *)camHal->buffers[camHal->curCaptureBuf.index].data,
-        (char *)jpegInMem->data, camHal->pictWidth, camHal->pictHeight);
-    ERROR_CHECK_EXIT(rc, "convert_YUYV_to_420_NV12");
+        (char *)jpegInMem->data, camHal->pictWidth, camHal->pictHeight,
+        USBCAM_CONV_OUT_NV21);
+    ERROR_CHECK_EXIT(rc, "usbCamConvertYUYV");
     /************************************************************************/
     /* - Populate JPEG encoding parameters from the camHal context          */
     /************************************************************************/
@@ -0,0 +1,22 @@
+#YUYV conversion bit-exactness test and benchmark, runs on the build host
+OLD_LOCAL_PATH := $(LOCAL_PATH)
+USB_CAM_TEST_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(USB_CAM_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS += -Wall -Wextra -Werror
+
+LOCAL_C_INCLUDES := $(USB_CAM_TEST_PATH)/../inc
+
+LOCAL_SRC_FILES := QCameraUsbConvertTest.cpp
+LOCAL_SRC_FILES += ../src/QCameraUsbConvert.cpp
+
+LOCAL_MODULE           := usb-cam-convert-test
+LOCAL_SHARED_LIBRARIES := liblog
+LOCAL_LDLIBS           := -lpthread
+
+include $(BUILD_HOST_EXECUTABLE)
+
+LOCAL_PATH := $(OLD_LOCAL_PATH)
@@ -0,0 +1,187 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks the YUYV converter against the original scalar loop of the USB
+ * camera HAL over random frames, and reports the time per frame. The NV12
+ * output and the NV12 to NV21 chroma swap are checked against the same
+ * reference.
+ *
+ * usage: usb-cam-convert-test [iterations] [threads]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "QCameraUsbConvert.h"
+
+typedef struct {
+    int wd;
+    int ht;
+} frame_size_t;
+
+static const frame_size_t sizes[] = {
+    { 160,  120 },
+    { 176,  144 },
+    { 320,  240 },
+    { 352,  288 },
+    { 424,  239 },  /* partial vector tail and odd height */
+    { 640,  480 },
+    { 800,  600 },
+    { 1280, 720 },
+    { 1920, 1080 },
+};
+
+/* Original conversion of QualcommUsbCamera.cpp, emits VU (NV21) order */
+static int ref_convert_YUYV_to_420_NV12(char *in_buf, char *out_buf,
+                                        int wd, int ht)
+{
+    int row, col, uv_row;
+
+    for(row = 0; row < ht; row++)
+        for(col = 0; col < wd * 2; col += 2)
+        {
+            out_buf[row * wd + col / 2] = in_buf[row * wd * 2 + col];
+        }
+
+    for(row = 0, uv_row = ht; row < ht; row += 2, uv_row++)
+        for(col = 1; col < wd * 2; col += 4)
+        {
+            out_buf[uv_row * wd + col / 2]= in_buf[row * wd * 2 + col + 2];
+            out_buf[uv_row * wd + col / 2 + 1]  = in_buf[row * wd * 2 + col];
+        }
+    return 0;
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static void swap_uv(char *buf, int wd, int ht)
+{
+    char *uv = buf + wd * ht;
+    int i, len = wd * ((ht + 1) / 2);
+
+    for(i = 0; i < len; i += 2) {
+        char t = uv[i];
+        uv[i] = uv[i + 1];
+        uv[i + 1] = t;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 20;
+    int threads = argc > 2 ? atoi(argv[2]) : 2;
+    void *conv = NULL;
+    unsigned int s, i;
+    int it, failures = 0;
+
+    if(iterations < 1)
+        iterations = 1;
+    if(usbCamConvertInit(&conv, threads) != USBCAM_CONV_NO_ERROR) {
+        printf("usbCamConvertInit failed\n");
+        return 1;
+    }
+    srand(0x5eed);
+
+    printf("%-10s %10s %10s %10s %10s\n",
+           "size", "ref us", "simd us", "pool us", "nv12/swap");
+    for(s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int wd = sizes[s].wd, ht = sizes[s].ht;
+        size_t in_len  = (size_t)wd * ht * 2;
+        size_t out_len = (size_t)wd * ht + (size_t)wd * ((ht + 1) / 2);
+        char *in  = (char *)malloc(in_len);
+        char *ref = (char *)malloc(out_len);
+        char *out = (char *)malloc(out_len);
+        double t_ref = 0, t_simd = 0, t_pool = 0;
+        int ok = 1;
+        char label[16];
+
+        if(!in || !ref || !out) {
+            printf("out of memory\n");
+            return 1;
+        }
+
+        for(it = 0; it < iterations && ok; it++) {
+            double t0, t1, t2, t3;
+
+            for(i = 0; i < in_len; i++)
+                in[i] = (char)rand();
+            memset(ref, 0xAA, out_len);
+
+            t0 = now_us();
+            ref_convert_YUYV_to_420_NV12(in, ref, wd, ht);
+            t1 = now_us();
+            memset(out, 0x55, out_len);
+            usbCamConvertYUYV(NULL, in, out, wd, ht, USBCAM_CONV_OUT_NV21);
+            t2 = now_us();
+            ok = !memcmp(ref, out, out_len);
+            memset(out, 0x55, out_len);
+            t3 = now_us();
+            usbCamConvertYUYV(conv, in, out, wd, ht, USBCAM_CONV_OUT_NV21);
+            t_pool += now_us() - t3;
+            ok = ok && !memcmp(ref, out, out_len);
+
+            t_ref  += t1 - t0;
+            t_simd += t2 - t1;
+        }
+
+        /* NV12 output is the reference with each chroma pair swapped */
+        swap_uv(ref, wd, ht);
+        usbCamConvertYUYV(conv, in, out, wd, ht, USBCAM_CONV_OUT_NV12);
+        int ok12 = !memcmp(ref, out, out_len);
+
+        /* NV12 to NV21, out of place and in place, gives back NV21 */
+        char *nv21 = in;
+        usbCamConvertNV12toNV21(out, nv21, wd, ht);
+        swap_uv(ref, wd, ht);
+        ok12 = ok12 && !memcmp(ref, nv21, out_len);
+        usbCamConvertNV12toNV21(out, out, wd, ht);
+        ok12 = ok12 && !memcmp(ref, out, out_len);
+
+        snprintf(label, sizeof(label), "%dx%d", wd, ht);
+        printf("%-10s %10.1f %10.1f %10.1f %10s%s\n", label,
+               t_ref / it, t_simd / it, t_pool / it, ok12 ? "ok" : "FAIL",
+               ok ? "" : "  NV21 MISMATCH");
+        failures += !ok + !ok12;
+
+        free(in);
+        free(ref);
+        free(out);
+    }
+
+    usbCamConvertDestroy(conv);
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+/*
+Copyright (c) 2017, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef IPACM_CLIENTINDEX_H
+#define IPACM_CLIENTINDEX_H
+
+#include <stdint.h>
+
+/* Longest key, an IPv6 address */
+#define CLIENT_INDEX_MAX_KEY_LEN 16
+
+/* Index from a client key, its MAC or IP address, to the slot of the
+ * client in the array of its owner, which stays the backing storage.
+ * Keys are copied into an open addressing hash table, so the owner may
+ * lay its clients out however it likes. When two clients share a key,
+ * the first one indexed wins, as it did with the linear searches. */
+class ClientIndex
+{
+private:
+	uint8_t *keys;
+	int *slots;		/* client slot per bucket, -1 if empty; linear probing */
+	uint32_t bucket_mask;
+	int key_len;
+	int max_entries;
+	int count;
+
+	uint32_t Bucket(const uint8_t *key) const;
+	uint32_t Lookup(const uint8_t *key) const;
+
+public:
+	ClientIndex();
+	~ClientIndex();
+
+	/* Sizes the index for max_entries keys of key_len bytes */
+	int Init(int max_entries, int key_len);
+
+	/* Returns the slot of the client, -1 if not indexed */
+	int Find(const void *key) const;
+
+	/* Indexes the client at slot, unless a client with the same key
+	 * already is; fails if max_entries keys are indexed */
+	int Insert(const void *key, int slot);
+
+	/* Points the key at slot to, if it was at slot from or not indexed
+	 * at all; for owners compacting their client array */
+	int Move(const void *key, int from, int to);
+
+	void Remove(const void *key);
+	void Clear();
+
+	inline int GetCount(void) const
+	{
+		return count;
+	}
+};
+
+#endif /* IPACM_CLIENTINDEX_H */
@@ -58,8 +58,18 @@ typedef struct cmd_s
 {
 	void (*callback_ptr)(ipacm_cmd_q_data *);
 	ipacm_cmd_q_data data;
+	int if_index;	/* interface the event is about, -1 if it may touch any */
 }cmd_t;
 
+/* Messages kept for reuse instead of going back to the heap */
+#define IPACM_MSG_POOL_MAX 256
+
+/* Event worker threads, 0 runs every event on the command queue thread */
+#define IPACM_EVT_WORKERS_MAX 8
+#ifdef FEATURE_IPA_ANDROID
+#define IPACM_EVT_WORKERS_PROP "persist.vendor.ipacm.evt_workers"
+#endif
+
 class Message
 {
 private:
@@ -72,6 +82,7 @@ public:
 	{
 		m_next = NULL;
 		evt.callback_ptr = NULL;
+		evt.if_index = -1;
 	}
 	~Message() { }
 	void setnext(Message *item) { m_next = item; }
@@ -88,6 +99,15 @@ private:
 	static MessageQueue *inst_internal;
 	static MessageQueue *inst_external;
 
+	/* free messages, protected by the command queue mutex */
+	static Message *pool;
+	static int pool_cnt;
+
+	static int num_workers;
+	static int startWorkers(int num);
+	static bool dispatch(Message *item);
+	static void* Worker(void *);
+
 	MessageQueue()
 	{
 		Head = NULL;
@@ -103,6 +123,15 @@ public:
 	static MessageQueue* getInstanceInternal();
 	static MessageQueue* getInstanceExternal();
 
+	/* Message allocation, the caller holds the command queue mutex */
+	static Message* getMessage(void);
+	static void putMessage(Message *item);
+
+	/* Events with an interface index run on the worker picked by the
+	   index, so events of one interface keep their order. The other
+	   events wait for all workers to be idle and run alone */
+	static int getNumWorkers(void) { return num_workers; }
+
 };
 
 #endif  /* IPA_CONNTRACK_MESSAGE_H */
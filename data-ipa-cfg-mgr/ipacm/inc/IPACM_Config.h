@@ -111,6 +111,11 @@ public:
 
 	int ipa_nat_max_entries;
 
+	/* Client limits, from IPACM_cfg.xml or the defaults */
+	int ipa_max_wlan_clients;
+
+	int ipa_max_neighbor_clients;
+
 	bool ipacm_odu_router_mode;
 
 	bool ipacm_odu_enable;
@@ -221,6 +226,16 @@ public:
 		return ipa_nat_max_entries;
 	}
 
+	inline int GetMaxWlanClients(void)
+	{
+		return ipa_max_wlan_clients;
+	}
+
+	inline int GetMaxNeighborClients(void)
+	{
+		return ipa_max_neighbor_clients;
+	}
+
 	inline int GetNatIfacesCnt()
 	{
 		return ipa_nat_iface_entries;
@@ -35,6 +35,8 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "IPACM_Config.h"
 #include "IPACM_Xml.h"
+#include "IPACM_Conntrack_NATIndex.h"
+#include "IPACM_ClientIndex.h"
 
 extern "C"
 {
@@ -47,27 +49,36 @@ extern "C"
 #define IPACM_TCP_FULL_FILE_NAME  "/proc/sys/net/ipv4/netfilter/ip_conntrack_tcp_timeout_established"
 #define IPACM_UDP_FULL_FILE_NAME   "/proc/sys/net/ipv4/netfilter/ip_conntrack_udp_timeout_stream"
 
-typedef struct _nat_table_entry
-{
-	uint32_t private_ip;
-	uint16_t private_port;
-
-	uint32_t target_ip;
-	uint16_t target_port;
-
-	uint32_t public_ip;
-	uint16_t public_port;
+#define CHK_TBL_HDL()  if(nat_table_hdl == 0){ return -1; }
 
-	u_int8_t  protocol;
-	uint32_t timestamp;
+/* Number of cache entries checked per UpdateUDPTimeStamp() call */
+#define NAT_TS_SWEEP_SLICE 64
+/* Room reserved for one conntrack update request */
+#define NAT_CT_UPDATE_MSG_SIZE 512
 
-	bool dst_nat;
-	bool enabled;
+/* Cost of one full pass of the timestamp sweep over the cache */
+typedef struct
+{
+	uint32_t sweeps;        /* passes completed so far */
+	uint32_t slices;        /* calls the pass took */
+	uint32_t queried;       /* active entries whose timestamp was read */
+	uint32_t updated;       /* conntrack timeouts refreshed */
+	uint32_t failed;        /* refreshes refused, entry deleted */
+	uint32_t netlink_msgs;  /* netlink messages sent for the refreshes */
+	uint32_t total_us;      /* time spent in the pass */
+	uint32_t max_slice_us;  /* longest single call */
+} nat_sweep_stats;
+
+#ifndef FEATURE_IPACM_HAL
+/* Conntrack update waiting in the batch buffer */
+typedef struct
+{
+	int entry;
 	uint32_t rule_hdl;
-
-}nat_table_entry;
-
-#define CHK_TBL_HDL()  if(nat_table_hdl == 0){ return -1; }
+	uint32_t ts;
+	uint32_t seq;
+} nat_ct_update;
+#endif
 
 class NatApp
 {
@@ -76,6 +87,7 @@ private:
 	static NatApp *pInstance;
 
 	nat_table_entry *cache;
+	NatCacheIndex cache_index;
 	nat_table_entry temp[MAX_TEMP_ENTRIES];
 	uint32_t pub_ip_addr;
 	uint32_t pub_ip_addr_pre;
@@ -83,22 +95,43 @@ private:
 
 	int curCnt, max_entries;
 
+	/* rules of a batch that could not be enabled */
+	uint32_t *batch_failed;
+
 	ipacm_alg *pALGPorts;
 	uint16_t nALGPort;
 
 	uint32_t tcp_timeout;
 	uint32_t udp_timeout;
 
-	uint32_t PwrSaveIfs[IPA_MAX_NUM_WIFI_CLIENTS];
+	/* wlan clients in power save, by IPv4 address */
+	ClientIndex pwr_save_index;
 
 	struct nf_conntrack *ct;
 	struct nfct_handle *ct_hdl;
 
+	int sweep_cursor;
+	bool sweep_read_to;
+	nat_sweep_stats sweep_cur;
+	nat_sweep_stats sweep_last;
+
+#ifndef FEATURE_IPACM_HAL
+	char ct_batch_buf[NAT_TS_SWEEP_SLICE * NAT_CT_UPDATE_MSG_SIZE];
+	nat_ct_update ct_batch[NAT_TS_SWEEP_SLICE];
+	int ct_batch_cnt;
+	uint32_t ct_batch_len;
+	uint32_t ct_batch_seq;
+
+	void FlushCTUdpTs();
+#endif
+
 	NatApp();
 	int Init();
 
 	void UpdateCTUdpTs(nat_table_entry *, uint32_t);
 	bool ChkForDup(const nat_table_entry *);
+	void FreeCacheEntry(int);
+	void CommitBatch();
 	bool isAlgPort(uint8_t, uint16_t);
 	void Reset();
 	bool isPwrSaveIf(uint32_t);
@@ -114,6 +147,8 @@ public:
 	int DeleteEntry(const nat_table_entry *);
 
 	void UpdateUDPTimeStamp();
+	int GetSweepSlices();
+	void GetSweepStats(nat_sweep_stats *);
 
 	int UpdatePwrSaveIf(uint32_t);
 	int ResetPwrSaveIf(uint32_t);
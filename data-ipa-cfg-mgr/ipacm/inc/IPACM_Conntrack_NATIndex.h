@@ -0,0 +1,98 @@
+/*
+Copyright (c) 2017, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef IPACM_CONNTRACK_NATINDEX_H
+#define IPACM_CONNTRACK_NATINDEX_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef struct _nat_table_entry
+{
+	uint32_t private_ip;
+	uint16_t private_port;
+
+	uint32_t target_ip;
+	uint16_t target_port;
+
+	uint32_t public_ip;
+	uint16_t public_port;
+
+	u_int8_t  protocol;
+	uint32_t timestamp;
+
+	bool dst_nat;
+	bool enabled;
+	uint32_t rule_hdl;
+
+}nat_table_entry;
+
+/* Index over the NAT cache array, which stays the backing storage.
+ * Connections are looked up by their 5-tuple (private ip/port, target
+ * ip/port, protocol) in an open addressing hash table of cache slots, and
+ * free slots are kept on a stack, so that lookup, insertion and deletion
+ * do not need to scan the cache. */
+class NatCacheIndex
+{
+private:
+	nat_table_entry *cache;
+	int max_entries;
+
+	/* cache slot per bucket, -1 if empty; linear probing */
+	int *buckets;
+	uint32_t bucket_mask;
+
+	/* stack of unused cache slots */
+	int *free_slots;
+	int free_cnt;
+
+	uint32_t Bucket(const nat_table_entry *) const;
+
+public:
+	NatCacheIndex();
+	~NatCacheIndex();
+
+	/* Sizes the index for max_entries slots of cache, all of them free */
+	int Init(nat_table_entry *cache, int max_entries);
+
+	/* Returns the cache slot of the connection, -1 if not cached */
+	int Find(const nat_table_entry *) const;
+
+	/* Takes an unused cache slot, -1 if the cache is full */
+	int AllocSlot();
+	/* Returns a slot taken with AllocSlot(), which must not be indexed */
+	void FreeSlot(int);
+
+	/* Indexes cache[slot] by its current 5-tuple */
+	void Insert(int);
+	/* Drops cache[slot] from the index, its 5-tuple must not have changed
+	 * since Insert() */
+	void Remove(int);
+};
+
+#endif /* IPACM_CONNTRACK_NATINDEX_H */
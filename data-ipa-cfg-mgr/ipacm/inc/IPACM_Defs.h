@@ -117,7 +117,11 @@ extern "C"
 #define IPACM_IP_NULL (ipa_ip_type)0xFF
 #define IPACM_INVALID_INDEX (ipa_ip_type)0xFF
 
+/* Client limits used when IPACM_cfg.xml does not set them. Wlan
+   client slots must stay below IPACM_INVALID_INDEX */
 #define IPA_MAX_NUM_WIFI_CLIENTS  32
+#define IPA_MAX_NUM_NEIGHBOR_CLIENTS  100
+#define IPA_MAX_NUM_CLIENTS_LIMIT  255
 #define IPA_MAX_NUM_WAN_CLIENTS  10
 #define IPA_MAX_NUM_ETH_CLIENTS  15
 #define IPA_MAX_NUM_AMPDU_RULE  15
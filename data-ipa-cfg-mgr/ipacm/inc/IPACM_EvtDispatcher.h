@@ -63,14 +63,21 @@ public:
 	/* api for all iface instances to register events */
 	static int registr(ipa_cm_event_id event, IPACM_Listener *obj);
 
-	/* api for all iface instances to de-register events */
+	/* api for all iface instances to de-register events, only from
+	   events that do not run on the event workers */
 	static int deregistr(IPACM_Listener *obj);
 
 	static int PostEvt(ipacm_cmd_q_data *);
 	static void ProcessEvt(ipacm_cmd_q_data *);
 
+	/* interface an event may run in parallel for, -1 if none */
+	static int GetEvtIface(ipacm_cmd_q_data *);
+
 private:
-	static cmd_evts *head;
+	/* listeners of each event, in registration order */
+	static cmd_evts *evt_head[IPACM_EVENT_MAX];
+	static cmd_evts *evt_tail[IPACM_EVENT_MAX];
+	static pthread_mutex_t reg_lock;
 };
 
 #endif /* IPACM_EvtDispatcher_H */
@@ -0,0 +1,93 @@
+/*
+Copyright (c) 2017, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef IPACM_IFACEREGISTRY_H
+#define IPACM_IFACEREGISTRY_H
+
+#include <pthread.h>
+#include "IPACM_Defs.h"
+#include "IPACM_ClientIndex.h"
+
+/* Linux interfaces kept at once; lookups of others go to the kernel */
+#define IPA_MAX_NUM_NETDEVS 64
+
+/* ipa_index of an interface not matched against the iface table yet */
+#define IPA_IFACE_INDEX_UNKNOWN (-2)
+
+typedef struct
+{
+	int if_index;
+	char if_name[IF_NAME_LEN];	/* zero padded, the name key */
+	int ipa_index;
+} ipacm_netdev_entry;
+
+/* Linux interface index <-> name table, with the IPACM iface table index
+ * of each interface once it has been resolved. The netlink listener keeps
+ * it current from RTM_NEWLINK/RTM_DELLINK; a miss asks the kernel with
+ * SIOCGIFNAME/SIOCGIFINDEX and caches the answer, unless a link message
+ * was processed in the meantime. */
+class IPACM_IfaceRegistry
+{
+public:
+	/* from RTM_NEWLINK, also for renames */
+	static void UpdateLink(int if_index, const char *if_name);
+
+	/* from RTM_DELLINK */
+	static void RemoveLink(int if_index);
+
+	/* if_name must hold IF_NAME_LEN bytes */
+	static int GetIfName(int if_index, char *if_name);
+
+	static int GetIfIndex(const char *if_name, int *if_index);
+
+	/* IPA_IFACE_INDEX_UNKNOWN until SetIpaIndex() for the interface;
+	 * gen, unless NULL, receives the link generation to pass to
+	 * SetIpaIndex() once the index is resolved */
+	static int GetIpaIndex(int if_index, uint32_t *gen);
+	/* dropped if a link message was processed since GetIpaIndex() */
+	static void SetIpaIndex(int if_index, int ipa_index, uint32_t gen);
+
+	/* forget all ipa indexes, after the iface table is rebuilt */
+	static void ResetIpaIndex(void);
+
+private:
+	static ipacm_netdev_entry netdevs[IPA_MAX_NUM_NETDEVS];
+	static int free_slots[IPA_MAX_NUM_NETDEVS];
+	static int num_free;
+	static ClientIndex by_index;
+	static ClientIndex by_name;
+	static uint32_t link_gen;	/* bumped by each link message */
+	static bool inited;
+	static pthread_mutex_t lock;
+
+	static bool InitLocked(void);
+	static void AddLocked(int if_index, const char *name_key);
+	static void DropLocked(int slot);
+};
+
+#endif /* IPACM_IFACEREGISTRY_H */
@@ -49,6 +49,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Filtering.h"
 #include "IPACM_Config.h"
 #include "IPACM_Conntrack_NATApp.h"
+#include "IPACM_ClientIndex.h"
 
 #define IPA_WAN_DEFAULT_FILTER_RULE_HANDLES  1
 #define IPA_PRIV_SUBNET_FILTER_RULE_HANDLES  3
@@ -289,6 +290,9 @@ private:
 
 	ipa_eth_client *eth_client;
 
+	/* eth_client entries by MAC */
+	ClientIndex eth_client_index;
+
 	int header_name_count;
 
 	uint32_t num_eth_client;
@@ -315,33 +319,13 @@ private:
 
 	inline int get_eth_client_index(uint8_t *mac_addr)
 	{
-		int cnt;
-		int num_eth_client_tmp = num_eth_client;
+		int cnt = eth_client_index.Find(mac_addr);
 
-		IPACMDBG_H("Passed MAC %02x:%02x:%02x:%02x:%02x:%02x\n",
+		IPACMDBG_H("MAC %02x:%02x:%02x:%02x:%02x:%02x client index: %d\n",
 						 mac_addr[0], mac_addr[1], mac_addr[2],
-						 mac_addr[3], mac_addr[4], mac_addr[5]);
-
-		for(cnt = 0; cnt < num_eth_client_tmp; cnt++)
-		{
-			IPACMDBG_H("stored MAC %02x:%02x:%02x:%02x:%02x:%02x\n",
-							 get_client_memptr(eth_client, cnt)->mac[0],
-							 get_client_memptr(eth_client, cnt)->mac[1],
-							 get_client_memptr(eth_client, cnt)->mac[2],
-							 get_client_memptr(eth_client, cnt)->mac[3],
-							 get_client_memptr(eth_client, cnt)->mac[4],
-							 get_client_memptr(eth_client, cnt)->mac[5]);
-
-			if(memcmp(get_client_memptr(eth_client, cnt)->mac,
-								mac_addr,
-								sizeof(get_client_memptr(eth_client, cnt)->mac)) == 0)
-			{
-				IPACMDBG_H("Matched client index: %d\n", cnt);
-				return cnt;
-			}
-		}
+						 mac_addr[3], mac_addr[4], mac_addr[5], cnt);
 
-		return IPACM_INVALID_INDEX;
+		return (cnt < 0) ? IPACM_INVALID_INDEX : cnt;
 	}
 
 	inline int delete_eth_rtrules(int clt_indx, ipa_ip_type iptype)
@@ -40,6 +40,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef IPACM_LISTENER_H
 #define IPACM_LISTENER_H
 
+#include <pthread.h>
 #include "IPACM_Defs.h"
 #include "IPACM_CmdQueue.h"
 
@@ -47,8 +48,12 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 class IPACM_Listener
 {
 public:
+	IPACM_Listener(void) { pthread_mutex_init(&evt_lock, NULL); };
 	virtual void event_callback(ipa_cm_event_id event,															void *data) = 0;
-	virtual ~IPACM_Listener(void) {};
+	virtual ~IPACM_Listener(void) { pthread_mutex_destroy(&evt_lock); };
+
+	/* held around event_callback for events running on the event workers */
+	pthread_mutex_t evt_lock;
 };
 
 #endif /* IPACM_LISTENER_H */
@@ -48,12 +48,14 @@ extern "C"
 
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #include <syslog.h>
 
 #define MAX_BUF_LEN 256
 
 #ifdef FEATURE_IPA_ANDROID
 #define IPACMLOG_FILE "/dev/socket/ipacm_log_file"
+#define IPACM_LOG_LEVEL_PROP "persist.vendor.ipacm.loglevel"
 #else/* defined(FEATURE_IPA_ANDROID) */
 #define IPACMLOG_FILE "/etc/ipacm_log_file"
 #endif /* defined(NOT FEATURE_IPA_ANDROID)*/
@@ -64,36 +66,71 @@ typedef struct ipacm_log_buffer_s {
 
 void ipacm_log_send( void * user_data);
 
-static char buffer_send[MAX_BUF_LEN];
-static char dmesg_cmd[MAX_BUF_LEN];
+/* Messages above the runtime level are skipped with a single branch */
+#define IPACM_LOG_LEVEL_ERR  0
+#define IPACM_LOG_LEVEL_HIGH 1
+#define IPACM_LOG_LEVEL_DBG  2
 
-#define IPACMDBG_DMESG(fmt, ...) memset(buffer_send, 0, MAX_BUF_LEN);\
-								 snprintf(buffer_send,MAX_BUF_LEN,"%s:%d %s: " fmt, __FILE__,  __LINE__, __FUNCTION__, ##__VA_ARGS__);\
-								 ipacm_log_send (buffer_send);\
-								 printf("%s:%d %s() " fmt, __FILE__,  __LINE__, __FUNCTION__, ##__VA_ARGS__); \
-								 memset(dmesg_cmd, 0, MAX_BUF_LEN);\
-								 snprintf(dmesg_cmd, MAX_BUF_LEN, "echo %s > /dev/kmsg", buffer_send);\
-								 system(dmesg_cmd);
+/* Where a message goes once formatted */
+#define IPACM_LOG_STDOUT 0x01
+#define IPACM_LOG_STDERR 0x02
+#define IPACM_LOG_SOCKET 0x04
+#define IPACM_LOG_KMSG   0x08
+#define IPACM_LOG_PREFIX 0x10	/* file:line function() */
+#define IPACM_LOG_ERROR  0x20	/* error tag before the prefix */
+#define IPACM_LOG_KEEP   0x40	/* written synchronously if the ring is full */
+
+extern int ipacm_log_level;
+
+/*
+	Messages are not formatted by the caller. ipacm_log_write stores the
+	format string pointer, the raw arguments and a timestamp in a lock free
+	ring owned by the calling thread, and the log thread started by
+	ipacm_log_init formats and sends them. Until then messages are written
+	synchronously. When the ring of the caller is full, errors and high
+	priority messages are written synchronously and debug messages are
+	dropped and counted.
+*/
+int ipacm_log_init(void);
+void ipacm_log_set_level(int level);
+void ipacm_log_flush(void);
+void ipacm_log_write(int flags, const char *file, int line,
+		const char *func, const char *fmt, ...)
+		__attribute__((format(printf, 5, 6)));
+
+#define IPACM_LOG_AT(level, flags, fmt, ...) do { \
+		if (ipacm_log_level >= (level)) \
+			ipacm_log_write((flags) | \
+					((level) < IPACM_LOG_LEVEL_DBG ? IPACM_LOG_KEEP : 0), \
+					__FILE__, __LINE__, __FUNCTION__, fmt, ##__VA_ARGS__); \
+	} while (0)
+
+#define IPACMDBG_DMESG(fmt, ...) IPACM_LOG_AT(IPACM_LOG_LEVEL_HIGH, \
+		IPACM_LOG_STDOUT | IPACM_LOG_SOCKET | IPACM_LOG_KMSG | IPACM_LOG_PREFIX, \
+		fmt, ##__VA_ARGS__)
 #ifdef DEBUG
-#define PERROR(fmt)   memset(buffer_send, 0, MAX_BUF_LEN);\
-					  snprintf(buffer_send,MAX_BUF_LEN,"%s:%d %s()", __FILE__, __LINE__, __FUNCTION__);\
-					  ipacm_log_send (buffer_send); \
-                      perror(fmt);
-#define IPACMERR(fmt, ...)	memset(buffer_send, 0, MAX_BUF_LEN);\
-							snprintf(buffer_send,MAX_BUF_LEN,"ERROR: %s:%d %s() " fmt, __FILE__,  __LINE__, __FUNCTION__, ##__VA_ARGS__);\
-							ipacm_log_send (buffer_send);\
-							printf("ERROR: %s:%d %s() " fmt, __FILE__,  __LINE__, __FUNCTION__, ##__VA_ARGS__);
-#define IPACMDBG_H(fmt, ...) memset(buffer_send, 0, MAX_BUF_LEN);\
-							 snprintf(buffer_send,MAX_BUF_LEN,"%s:%d %s() " fmt, __FILE__,  __LINE__, __FUNCTION__, ##__VA_ARGS__);\
-							 ipacm_log_send (buffer_send);\
-							 printf("%s:%d %s() " fmt, __FILE__,  __LINE__, __FUNCTION__, ##__VA_ARGS__);
+#define PERROR(fmt)   IPACM_LOG_AT(IPACM_LOG_LEVEL_ERR, \
+		IPACM_LOG_STDERR | IPACM_LOG_SOCKET | IPACM_LOG_PREFIX, \
+		"%s: %s\n", fmt, strerror(errno))
+#define IPACMERR(fmt, ...)	IPACM_LOG_AT(IPACM_LOG_LEVEL_ERR, \
+		IPACM_LOG_STDOUT | IPACM_LOG_SOCKET | IPACM_LOG_PREFIX | IPACM_LOG_ERROR, \
+		fmt, ##__VA_ARGS__)
+#define IPACMDBG_H(fmt, ...) IPACM_LOG_AT(IPACM_LOG_LEVEL_HIGH, \
+		IPACM_LOG_STDOUT | IPACM_LOG_SOCKET | IPACM_LOG_PREFIX, \
+		fmt, ##__VA_ARGS__)
 #else
-#define PERROR(fmt)   perror(fmt)
-#define IPACMERR(fmt, ...)   printf("ERR: %s:%d %s() " fmt, __FILE__,  __LINE__, __FUNCTION__, ##__VA_ARGS__);
-#define IPACMDBG_H(fmt, ...) printf("%s:%d %s() " fmt, __FILE__,  __LINE__, __FUNCTION__, ##__VA_ARGS__);
+#define PERROR(fmt)   IPACM_LOG_AT(IPACM_LOG_LEVEL_ERR, IPACM_LOG_STDERR, \
+		"%s: %s\n", fmt, strerror(errno))
+#define IPACMERR(fmt, ...)   IPACM_LOG_AT(IPACM_LOG_LEVEL_ERR, \
+		IPACM_LOG_STDOUT | IPACM_LOG_PREFIX | IPACM_LOG_ERROR, \
+		fmt, ##__VA_ARGS__)
+#define IPACMDBG_H(fmt, ...) IPACM_LOG_AT(IPACM_LOG_LEVEL_HIGH, \
+		IPACM_LOG_STDOUT | IPACM_LOG_PREFIX, fmt, ##__VA_ARGS__)
 #endif
-#define IPACMDBG(fmt, ...)	printf("%s:%d %s() " fmt, __FILE__,  __LINE__, __FUNCTION__, ##__VA_ARGS__);
-#define IPACMLOG(fmt, ...)  printf(fmt, ##__VA_ARGS__);
+#define IPACMDBG(fmt, ...)	IPACM_LOG_AT(IPACM_LOG_LEVEL_DBG, \
+		IPACM_LOG_STDOUT | IPACM_LOG_PREFIX, fmt, ##__VA_ARGS__)
+#define IPACMLOG(fmt, ...)  IPACM_LOG_AT(IPACM_LOG_LEVEL_DBG, IPACM_LOG_STDOUT, \
+		fmt, ##__VA_ARGS__)
 
 #ifdef __cplusplus
 }
@@ -47,8 +47,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Filtering.h"
 #include "IPACM_Listener.h"
 #include "IPACM_Iface.h"
-
-#define IPA_MAX_NUM_NEIGHBOR_CLIENTS  100
+#include "IPACM_ClientIndex.h"
 
 struct ipa_neighbor_client
 {
@@ -66,6 +65,7 @@ class IPACM_Neighbor : public IPACM_Listener
 public:
 
 	IPACM_Neighbor();
+	~IPACM_Neighbor();
 
 	void event_callback(ipa_cm_event_id event,
 											void *data);
@@ -74,9 +74,19 @@ private:
 
 	int num_neighbor_client;
 
+	int max_neighbor_client;
+
 	int circular_index;
 
-	ipa_neighbor_client neighbor_client[IPA_MAX_NUM_NEIGHBOR_CLIENTS];
+	ipa_neighbor_client *neighbor_client;
+
+	/* neighbor_client entries by MAC */
+	ClientIndex neighbor_index;
+
+	inline int get_neighbor_index(uint8_t *mac_addr)
+	{
+		return neighbor_index.Find(mac_addr);
+	}
 
 };
 
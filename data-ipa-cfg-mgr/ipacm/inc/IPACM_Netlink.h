@@ -61,6 +61,10 @@ extern "C"
 
 #define MAX_NUM_OF_FD 10
 #define IPA_NL_MSG_MAX_LEN (2048)
+/* Datagrams read with one recvmmsg() call */
+#define IPA_NL_BATCH_SIZE 16
+/* Neighbor messages per batch checked for redundant updates */
+#define IPA_NL_NEIGH_COALESCE_MAX 64
 
 /*--------------------------------------------------------------------------- 
 	 Type representing enumeration of NetLink event indication messages
@@ -79,6 +83,7 @@ extern "C"
 #define IPA_NLA_PARAM_CACHEINFO   (0x0080)
 #define IPA_NLA_PARAM_PROTOINFO   (0x0100)
 #define IPA_NLA_PARAM_FLAGS       (0x0200)
+#define IPA_NLA_PARAM_IFNAME      (0x0400)
 
 #define IPA_RTA_PARAM_NONE        (0x0000)
 #define IPA_RTA_PARAM_DST         (0x0001)
@@ -140,6 +145,11 @@ typedef struct ipa_nl_proto_info_s {
 typedef struct
 {
 	struct ifinfomsg  metainfo;                   /* from header */
+	struct                                      /* attributes  */
+	{
+		unsigned int                  param_mask;
+		char                          ifname[IF_NAME_LEN];
+	} attr_info;
 } ipa_nl_link_info_t;
 
 
@@ -202,6 +212,17 @@ typedef struct
 	ipa_nl_route_info_t      nl_route_info;
 } ipa_nl_msg_t;
 
+/* Totals of the batched receive path, and the largest batch seen */
+typedef struct
+{
+	uint32_t batches;
+	uint32_t datagrams;
+	uint32_t messages;
+	uint32_t neigh_coalesced;	/* neighbor updates superseded within a batch */
+	uint32_t dropped;	/* truncated or not from the kernel */
+	uint32_t max_batch;
+} ipa_nl_batch_stats_t;
+
 /* Initialization routine for listener on NetLink sockets interface */
 int ipa_nl_listener_init
 (
@@ -214,6 +235,9 @@ int ipa_nl_listener_init
 /*  Virtual function registered to receive incoming messages over the NETLINK routing socket*/
 int ipa_nl_recv_msg(int fd);
 
+/* copy of the batch statistics of ipa_nl_recv_msg */
+void ipa_nl_get_batch_stats(ipa_nl_batch_stats_t *stats);
+
 /* map mask value for ipv6 */
 int mask_v6(int index, uint32_t *mask);
 
@@ -48,6 +48,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Lan.h"
 #include "IPACM_Iface.h"
 #include "IPACM_Conntrack_NATApp.h"
+#include "IPACM_ClientIndex.h"
 
 typedef struct _wlan_client_rt_hdl
 {
@@ -100,6 +101,9 @@ private:
 	int wlan_client_len;
 	ipa_wlan_client *wlan_client;
 
+	/* wlan_client entries by MAC */
+	ClientIndex wlan_client_index;
+
 	int header_name_count;
 	uint32_t num_wifi_client;
 
@@ -117,33 +121,13 @@ private:
 
 	inline int get_wlan_client_index(uint8_t *mac_addr)
 	{
-		int cnt;
-		int num_wifi_client_tmp = num_wifi_client;
+		int cnt = wlan_client_index.Find(mac_addr);
 
-		IPACMDBG_H("Passed MAC %02x:%02x:%02x:%02x:%02x:%02x\n",
+		IPACMDBG_H("MAC %02x:%02x:%02x:%02x:%02x:%02x client index: %d\n",
 						 mac_addr[0], mac_addr[1], mac_addr[2],
-						 mac_addr[3], mac_addr[4], mac_addr[5]);
-
-		for(cnt = 0; cnt < num_wifi_client_tmp; cnt++)
-		{
-			IPACMDBG_H("stored MAC %02x:%02x:%02x:%02x:%02x:%02x\n",
-							 get_client_memptr(wlan_client, cnt)->mac[0],
-							 get_client_memptr(wlan_client, cnt)->mac[1],
-							 get_client_memptr(wlan_client, cnt)->mac[2],
-							 get_client_memptr(wlan_client, cnt)->mac[3],
-							 get_client_memptr(wlan_client, cnt)->mac[4],
-							 get_client_memptr(wlan_client, cnt)->mac[5]);
-
-			if(memcmp(get_client_memptr(wlan_client, cnt)->mac,
-								mac_addr,
-								sizeof(get_client_memptr(wlan_client, cnt)->mac)) == 0)
-			{
-				IPACMDBG_H("Matched client index: %d\n", cnt);
-				return cnt;
-			}
-		}
+						 mac_addr[3], mac_addr[4], mac_addr[5], cnt);
 
-		return IPACM_INVALID_INDEX;
+		return (cnt < 0) ? IPACM_INVALID_INDEX : cnt;
 	}
 
 	inline int delete_default_qos_rtrules(int clt_indx, ipa_ip_type iptype)
@@ -178,6 +178,10 @@ if (!(a)) {                                                 \
 #define IPACMNat_TAG                         "IPACMNAT"
 #define NAT_MaxEntries_TAG                   "MaxNatEntries"
 
+#define IPACMClients_TAG                     "IPACMClients"
+#define MaxWlanClients_TAG                   "MaxWlanClients"
+#define MaxNeighborClients_TAG               "MaxNeighborClients"
+
 #define IP_PassthroughFlag_TAG               "IPPassthroughFlag"
 #define IP_PassthroughMode_TAG               "IPPassthroughMode"
 
@@ -275,6 +279,8 @@ typedef struct  _IPACM_conf_t
 	ipacm_private_subnet_conf_t private_subnet_config;
 	ipacm_alg_conf_t alg_config;
 	int nat_max_entries;
+	int max_wlan_clients;
+	int max_neighbor_clients;
 	bool odu_enable;
 	bool router_mode_enable;
 	bool odu_embms_enable;
@@ -59,6 +59,9 @@ LOCAL_SRC_FILES := IPACM_Main.cpp \
 		IPACM_Netlink.cpp \
 		IPACM_Xml.cpp \
 		IPACM_Conntrack_NATApp.cpp\
+		IPACM_Conntrack_NATIndex.cpp \
+		IPACM_ClientIndex.cpp \
+		IPACM_IfaceRegistry.cpp \
 		IPACM_ConntrackClient.cpp \
 		IPACM_ConntrackListener.cpp \
 		IPACM_Log.cpp \
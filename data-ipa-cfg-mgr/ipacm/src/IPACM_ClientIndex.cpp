@@ -0,0 +1,226 @@
+/*
+Copyright (c) 2017, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "IPACM_ClientIndex.h"
+
+#define CLIENT_INDEX_EMPTY (-1)
+
+ClientIndex::ClientIndex()
+{
+	keys = NULL;
+	slots = NULL;
+	bucket_mask = 0;
+	key_len = 0;
+	max_entries = 0;
+	count = 0;
+}
+
+ClientIndex::~ClientIndex()
+{
+	free(keys);
+	free(slots);
+}
+
+int ClientIndex::Init(int entries, int len)
+{
+	uint32_t nbuckets = 8;
+	uint32_t cnt;
+
+	if(entries < 0 || len <= 0 || len > CLIENT_INDEX_MAX_KEY_LEN)
+	{
+		return -1;
+	}
+
+	/* keep the load factor at or below 1/2 */
+	while(nbuckets < (uint32_t)entries * 2)
+	{
+		nbuckets <<= 1;
+	}
+
+	free(keys);
+	free(slots);
+	keys = (uint8_t *)malloc(nbuckets * len);
+	slots = (int *)malloc(sizeof(int) * nbuckets);
+	if(keys == NULL || slots == NULL)
+	{
+		free(keys);
+		free(slots);
+		keys = NULL;
+		slots = NULL;
+		max_entries = 0;
+		count = 0;
+		return -1;
+	}
+
+	key_len = len;
+	max_entries = entries;
+	bucket_mask = nbuckets - 1;
+	for(cnt = 0; cnt < nbuckets; cnt++)
+	{
+		slots[cnt] = CLIENT_INDEX_EMPTY;
+	}
+	count = 0;
+	return 0;
+}
+
+uint32_t ClientIndex::Bucket(const uint8_t *key) const
+{
+	uint32_t h = 0x811C9DC5;
+	int cnt;
+
+	/* FNV-1a, then a final avalanche: MAC addresses of one vendor
+	 * only differ in their last bytes */
+	for(cnt = 0; cnt < key_len; cnt++)
+	{
+		h ^= key[cnt];
+		h *= 0x01000193;
+	}
+	h ^= h >> 16;
+	h *= 0x85EBCA6B;
+	h ^= h >> 13;
+
+	return h & bucket_mask;
+}
+
+/* Returns the bucket holding key, or the empty bucket ending its run */
+uint32_t ClientIndex::Lookup(const uint8_t *key) const
+{
+	uint32_t b;
+
+	for(b = Bucket(key); slots[b] != CLIENT_INDEX_EMPTY; b = (b + 1) & bucket_mask)
+	{
+		if(memcmp(&keys[b * key_len], key, key_len) == 0)
+		{
+			break;
+		}
+	}
+	return b;
+}
+
+int ClientIndex::Find(const void *key) const
+{
+	if(slots == NULL)
+	{
+		return -1;
+	}
+	return slots[Lookup((const uint8_t *)key)];
+}
+
+int ClientIndex::Insert(const void *key, int slot)
+{
+	uint32_t b;
+
+	if(slots == NULL || slot < 0)
+	{
+		return -1;
+	}
+
+	b = Lookup((const uint8_t *)key);
+	if(slots[b] != CLIENT_INDEX_EMPTY)
+	{
+		return 0;
+	}
+	if(count >= max_entries)
+	{
+		return -1;
+	}
+	memcpy(&keys[b * key_len], key, key_len);
+	slots[b] = slot;
+	count++;
+	return 0;
+}
+
+int ClientIndex::Move(const void *key, int from, int to)
+{
+	uint32_t b;
+
+	if(slots == NULL)
+	{
+		return -1;
+	}
+
+	b = Lookup((const uint8_t *)key);
+	if(slots[b] == CLIENT_INDEX_EMPTY)
+	{
+		return Insert(key, to);
+	}
+	if(slots[b] == from)
+	{
+		slots[b] = to;
+	}
+	return 0;
+}
+
+void ClientIndex::Remove(const void *key)
+{
+	uint32_t b, next, home;
+
+	if(slots == NULL)
+	{
+		return;
+	}
+
+	b = Lookup((const uint8_t *)key);
+	if(slots[b] == CLIENT_INDEX_EMPTY)
+	{
+		return;
+	}
+
+	/* backward shift deletion: pull up the entries of the probe run that
+	 * would not be reachable anymore through the hole, so that no tombstones
+	 * are needed */
+	for(next = (b + 1) & bucket_mask; slots[next] != CLIENT_INDEX_EMPTY; next = (next + 1) & bucket_mask)
+	{
+		home = Bucket(&keys[next * key_len]);
+		if(((next - home) & bucket_mask) >= ((next - b) & bucket_mask))
+		{
+			memcpy(&keys[b * key_len], &keys[next * key_len], key_len);
+			slots[b] = slots[next];
+			b = next;
+		}
+	}
+	slots[b] = CLIENT_INDEX_EMPTY;
+	count--;
+}
+
+void ClientIndex::Clear()
+{
+	uint32_t cnt;
+
+	if(slots == NULL)
+	{
+		return;
+	}
+	for(cnt = 0; cnt <= bucket_mask; cnt++)
+	{
+		slots[cnt] = CLIENT_INDEX_EMPTY;
+	}
+	count = 0;
+}
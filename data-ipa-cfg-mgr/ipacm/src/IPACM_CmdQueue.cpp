@@ -38,15 +38,38 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 */
 #include <string.h>
+#include <stdlib.h>
 #include "IPACM_CmdQueue.h"
 #include "IPACM_Log.h"
 #include "IPACM_Iface.h"
+#ifdef FEATURE_IPA_ANDROID
+#include <cutils/properties.h>
+#endif
 
 pthread_mutex_t mutex    = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t  cond_var = PTHREAD_COND_INITIALIZER;
 
 MessageQueue* MessageQueue::inst_internal = NULL;
 MessageQueue* MessageQueue::inst_external = NULL;
+Message* MessageQueue::pool = NULL;
+int MessageQueue::pool_cnt = 0;
+int MessageQueue::num_workers = 0;
+
+/* Queue of one event worker thread */
+typedef struct
+{
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	MessageQueue *queue;
+} ipacm_evt_worker;
+
+static ipacm_evt_worker evt_workers[IPACM_EVT_WORKERS_MAX];
+
+/* Events handed to the workers and not finished yet */
+static int evt_workers_busy;
+static pthread_mutex_t evt_workers_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t evt_workers_idle = PTHREAD_COND_INITIALIZER;
 
 MessageQueue* MessageQueue::getInstanceInternal()
 {
@@ -111,19 +134,158 @@ Message* MessageQueue::dequeue(void)
 	{
 		Message *tmp = Head;
 		Head = Head->getnext();
+		tmp->setnext(NULL);
 
 		return tmp;
 	}
 }
 
+Message* MessageQueue::getMessage(void)
+{
+	Message *item = pool;
+
+	if(item == NULL)
+	{
+		return new Message();
+	}
+	pool = item->getnext();
+	pool_cnt--;
+	item->setnext(NULL);
+	return item;
+}
+
+void MessageQueue::putMessage(Message *item)
+{
+	if(pool_cnt >= IPACM_MSG_POOL_MAX)
+	{
+		delete item;
+		return;
+	}
+	item->evt.callback_ptr = NULL;
+	item->evt.if_index = -1;
+	item->setnext(pool);
+	pool = item;
+	pool_cnt++;
+}
+
+void* MessageQueue::Worker(void *param)
+{
+	ipacm_evt_worker *worker = (ipacm_evt_worker *)param;
+	Message *item;
+
+	while(1)
+	{
+		pthread_mutex_lock(&worker->lock);
+		while((item = worker->queue->dequeue()) == NULL)
+		{
+			pthread_cond_wait(&worker->cond, &worker->lock);
+		}
+		pthread_mutex_unlock(&worker->lock);
+
+		IPACMDBG("Processing item %p event ID: %d on worker %d\n", item,
+			item->evt.data.event, (int)(worker - evt_workers));
+		item->evt.callback_ptr(&item->evt.data);
+
+		pthread_mutex_lock(&mutex);
+		putMessage(item);
+		pthread_mutex_unlock(&mutex);
+
+		pthread_mutex_lock(&evt_workers_lock);
+		if(--evt_workers_busy == 0)
+		{
+			pthread_cond_signal(&evt_workers_idle);
+		}
+		pthread_mutex_unlock(&evt_workers_lock);
+	}
+	return NULL;
+}
+
+/* Starts up to num worker threads, returns how many are running */
+int MessageQueue::startWorkers(int num)
+{
+	char name[16];
+	int cnt;
+
+	if(num > IPACM_EVT_WORKERS_MAX)
+	{
+		num = IPACM_EVT_WORKERS_MAX;
+	}
+	for(cnt = 0; cnt < num; cnt++)
+	{
+		ipacm_evt_worker *worker = &evt_workers[cnt];
+
+		worker->queue = new MessageQueue();
+		pthread_mutex_init(&worker->lock, NULL);
+		pthread_cond_init(&worker->cond, NULL);
+		if(pthread_create(&worker->thread, NULL, MessageQueue::Worker, worker) != 0)
+		{
+			IPACMERR("unable to create event worker %d\n", cnt);
+			pthread_cond_destroy(&worker->cond);
+			pthread_mutex_destroy(&worker->lock);
+			delete worker->queue;
+			worker->queue = NULL;
+			break;
+		}
+		/* thread names are limited to 15 characters */
+		snprintf(name, sizeof(name), "ipacm_evt%u",
+			(unsigned int)cnt % IPACM_EVT_WORKERS_MAX);
+		pthread_setname_np(worker->thread, name);
+	}
+	IPACMDBG_H("%d event workers running\n", cnt);
+	return cnt;
+}
+
+/* Runs an event on its worker, or alone once the workers are idle.
+   Returns true if the worker owns the message now */
+bool MessageQueue::dispatch(Message *item)
+{
+	ipacm_evt_worker *worker;
+
+	if(num_workers == 0)
+	{
+		item->evt.callback_ptr(&item->evt.data);
+		return false;
+	}
+
+	pthread_mutex_lock(&evt_workers_lock);
+	if(item->evt.if_index < 0)
+	{
+		while(evt_workers_busy > 0)
+		{
+			pthread_cond_wait(&evt_workers_idle, &evt_workers_lock);
+		}
+		pthread_mutex_unlock(&evt_workers_lock);
+		item->evt.callback_ptr(&item->evt.data);
+		return false;
+	}
+	evt_workers_busy++;
+	pthread_mutex_unlock(&evt_workers_lock);
+
+	worker = &evt_workers[item->evt.if_index % num_workers];
+	pthread_mutex_lock(&worker->lock);
+	worker->queue->enqueue(item);
+	pthread_cond_signal(&worker->cond);
+	pthread_mutex_unlock(&worker->lock);
+	return true;
+}
+
 
 void* MessageQueue::Process(void *param)
 {
 	MessageQueue *MsgQueueInternal = NULL;
 	MessageQueue *MsgQueueExternal = NULL;
-	Message *item = NULL;
+	Message *item = NULL, *done = NULL;
 	param = NULL;
 	const char *eventName = NULL;
+	const char *workers = getenv("IPACM_EVT_WORKERS");
+#ifdef FEATURE_IPA_ANDROID
+	char prop[PROPERTY_VALUE_MAX];
+
+	if(property_get(IPACM_EVT_WORKERS_PROP, prop, NULL) > 0)
+	{
+		workers = prop;
+	}
+#endif
 
 	IPACMDBG("MessageQueue::Process()\n");
 
@@ -141,6 +303,11 @@ void* MessageQueue::Process(void *param)
 		return NULL;
 	}
 
+	if(workers != NULL && atoi(workers) > 0)
+	{
+		num_workers = startWorkers(atoi(workers));
+	}
+
 	while(1)
 	{
 		if(pthread_mutex_lock(&mutex) != 0)
@@ -149,6 +316,12 @@ void* MessageQueue::Process(void *param)
 			return NULL;
 		}
 
+		if(done != NULL)
+		{
+			putMessage(done);
+			done = NULL;
+		}
+
 		item = MsgQueueInternal->dequeue();
 		if(item == NULL)
 		{
@@ -202,8 +375,10 @@ void* MessageQueue::Process(void *param)
 			}
 
 			IPACMDBG("Processing item %p event ID: %d\n",item,item->evt.data.event);
-			item->evt.callback_ptr(&item->evt.data);
-			delete item;
+			if(!dispatch(item))
+			{
+				done = item;
+			}
 			item = NULL;
 		}
 
@@ -40,6 +40,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <IPACM_Config.h>
 #include <IPACM_Log.h>
 #include <IPACM_Iface.h>
+#include <IPACM_IfaceRegistry.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
 
@@ -134,6 +135,8 @@ IPACM_Config::IPACM_Config()
 	ipa_num_private_subnet = 0;
 	ipa_num_alg_ports = 0;
 	ipa_nat_max_entries = 0;
+	ipa_max_wlan_clients = IPA_MAX_NUM_WIFI_CLIENTS;
+	ipa_max_neighbor_clients = IPA_MAX_NUM_NEIGHBOR_CLIENTS;
 	ipa_nat_iface_entries = 0;
 	ipa_sw_rt_enable = false;
 	ipa_bridge_enable = false;
@@ -217,6 +220,9 @@ int IPACM_Config::Init(void)
 		goto fail;
 	}
 
+	/* ipa indexes cached for the old table may point elsewhere now */
+	IPACM_IfaceRegistry::ResetIpaIndex();
+
 	for (i = 0; i < cfg->iface_config.num_iface_entries; i++)
 	{
 		strlcpy(iface_table[i].iface_name, cfg->iface_config.iface_entries[i].iface_name, sizeof(iface_table[i].iface_name));
@@ -285,6 +291,22 @@ int IPACM_Config::Init(void)
 	ipa_nat_max_entries = cfg->nat_max_entries;
 	IPACMDBG_H("Nat Maximum Entries %d\n", ipa_nat_max_entries);
 
+	if (cfg->max_wlan_clients > 0)
+	{
+		ipa_max_wlan_clients = cfg->max_wlan_clients;
+	}
+	if (cfg->max_neighbor_clients > 0)
+	{
+		ipa_max_neighbor_clients = cfg->max_neighbor_clients;
+	}
+	if (ipa_max_wlan_clients > IPA_MAX_NUM_CLIENTS_LIMIT)
+	{
+		IPACMERR("Max wlan clients %d above %d\n", ipa_max_wlan_clients, IPA_MAX_NUM_CLIENTS_LIMIT);
+		ipa_max_wlan_clients = IPA_MAX_NUM_CLIENTS_LIMIT;
+	}
+	IPACMDBG_H("Max wlan clients %d, max neighbor clients %d\n",
+		ipa_max_wlan_clients, ipa_max_neighbor_clients);
+
 	/* Find ODU is either router mode or bridge mode*/
 	ipacm_odu_enable = cfg->odu_enable;
 	ipacm_odu_router_mode = cfg->router_mode_enable;
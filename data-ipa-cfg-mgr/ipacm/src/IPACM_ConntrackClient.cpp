@@ -402,8 +402,10 @@ void* IPACM_ConntrackClient::UDPConnTimeoutUpdate(void *ptr)
 
 	while(1)
 	{
+		/* one pass over the nat cache every UDP_TIMEOUT_UPDATE seconds,
+			 spread over GetSweepSlices() calls */
 		nat_inst->UpdateUDPTimeStamp();
-		sleep(UDP_TIMEOUT_UPDATE);
+		usleep(UDP_TIMEOUT_UPDATE * 1000000 / nat_inst->GetSweepSlices());
 	} /* end of while(1) loop */
 
 #ifdef IPACM_DEBUG
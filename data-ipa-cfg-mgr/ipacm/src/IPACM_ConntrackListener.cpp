@@ -35,6 +35,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_EvtDispatcher.h"
 #include "IPACM_Iface.h"
 #include "IPACM_Wan.h"
+#include "IPACM_IfaceRegistry.h"
 
 IPACM_ConntrackListener::IPACM_ConntrackListener()
 {
@@ -142,8 +143,8 @@ void IPACM_ConntrackListener::event_callback(ipa_cm_event_id evt,
 int IPACM_ConntrackListener::CheckNatIface(
    ipacm_event_data_all *data, bool *NatIface)
 {
-	int fd = 0, len = 0, cnt, i;
-	struct ifreq ifr;
+	int len = 0, cnt, i;
+	char if_name[IF_NAME_LEN];
 	*NatIface = false;
 
 	if (data->ipv4_addr == 0 || data->iptype != IPA_IP_v4)
@@ -190,25 +191,14 @@ int IPACM_ConntrackListener::CheckNatIface(
 	}
 
 	/* Search/Configure linux interface-index and map it to IPA interface-index */
-	if ((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
+	if (IPACM_IfaceRegistry::GetIfName(data->if_index, if_name) != IPACM_SUCCESS)
 	{
-		PERROR("get interface name socket create failed");
 		return IPACM_FAILURE;
 	}
 
-	memset(&ifr, 0, sizeof(struct ifreq));
-	ifr.ifr_ifindex = data->if_index;
-	if (ioctl(fd, SIOCGIFNAME, &ifr) < 0)
-	{
-		PERROR("call_ioctl_on_dev: ioctl failed:");
-		close(fd);
-		return IPACM_FAILURE;
-	}
-	close(fd);
-
 	for (i = 0; i < NatIfaceCnt; i++)
 	{
-		if (strncmp(ifr.ifr_name,
+		if (strncmp(if_name,
 					pNatIfaces[i].iface_name,
 					sizeof(pNatIfaces[i].iface_name)) == 0)
 		{
@@ -26,10 +26,16 @@ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
 OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
 IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
+#include <time.h>
 #include "IPACM_Conntrack_NATApp.h"
 #include "IPACM_ConntrackClient.h"
 #ifdef FEATURE_IPACM_HAL
 #include "IPACM_OffloadManager.h"
+#else
+extern "C"
+{
+#include <libnfnetlink/libnfnetlink.h>
+}
 #endif
 
 #define INVALID_IP_ADDR 0x0
@@ -40,6 +46,7 @@ NatApp::NatApp()
 {
 	max_entries = 0;
 	cache = NULL;
+	batch_failed = NULL;
 
 	nat_table_hdl = 0;
 	pub_ip_addr = 0;
@@ -52,6 +59,17 @@ NatApp::NatApp()
 	ct = NULL;
 	ct_hdl = NULL;
 
+	sweep_cursor = 0;
+	sweep_read_to = false;
+	memset(&sweep_cur, 0, sizeof(sweep_cur));
+	memset(&sweep_last, 0, sizeof(sweep_last));
+
+#ifndef FEATURE_IPACM_HAL
+	ct_batch_cnt = 0;
+	ct_batch_len = 0;
+	ct_batch_seq = 0;
+#endif
+
 	memset(temp, 0, sizeof(temp));
 }
 
@@ -79,6 +97,25 @@ int NatApp::Init(void)
 	IPACMDBG("Allocated %d bytes for config manager nat cache\n", size);
 	memset(cache, 0, size);
 
+	if(cache_index.Init(cache, max_entries) != 0)
+	{
+		IPACMERR("Unable to allocate memory for nat cache index\n");
+		goto fail;
+	}
+
+	batch_failed = (uint32_t *)malloc(sizeof(uint32_t) * max_entries);
+	if(batch_failed == NULL)
+	{
+		IPACMERR("Unable to allocate memory for batch results\n");
+		goto fail;
+	}
+
+	if(pwr_save_index.Init(pConfig->GetMaxWlanClients(), sizeof(uint32_t)) != 0)
+	{
+		IPACMERR("Unable to allocate memory for power save index\n");
+		goto fail;
+	}
+
 	nALGPort = pConfig->GetAlgPortCnt();
 	if(nALGPort > 0)
 	{
@@ -107,6 +144,7 @@ int NatApp::Init(void)
 
 fail:
 	free(cache);
+	free(batch_failed);
 	free(pALGPorts);
 	return -1;
 }
@@ -133,6 +171,7 @@ int NatApp::AddTable(uint32_t pub_ip)
 {
 	int ret;
 	int cnt = 0;
+	bool batched;
 	ipa_nat_ipv4_rule nat_rule;
 	IPACMDBG_H("%s() %d\n", __FUNCTION__, __LINE__);
 
@@ -156,6 +195,8 @@ int NatApp::AddTable(uint32_t pub_ip)
 	if (pub_ip == pub_ip_addr_pre)
 	{
 		IPACMDBG("Restore the cache to ipa NAT-table\n");
+		/* post the restored rules to hw with as few dma commands as possible */
+		batched = (ipa_nat_batch_begin(nat_table_hdl) == 0);
 		for(cnt = 0; cnt < max_entries; cnt++)
 		{
 			if(cache[cnt].private_ip !=0)
@@ -171,8 +212,7 @@ int NatApp::AddTable(uint32_t pub_ip)
 				if(ipa_nat_add_ipv4_rule(nat_table_hdl, &nat_rule, &cache[cnt].rule_hdl) < 0)
 				{
 					IPACMERR("unable to add the rule delete from cache\n");
-					memset(&cache[cnt], 0, sizeof(cache[cnt]));
-					curCnt--;
+					FreeCacheEntry(cnt);
 					continue;
 				}
 				cache[cnt].enabled = true;
@@ -185,6 +225,10 @@ int NatApp::AddTable(uint32_t pub_ip)
 				IPACMDBG("protocol: %d\n", nat_rule.protocol);
 			}
 		}
+		if(batched)
+		{
+			CommitBatch();
+		}
 	}
 
 	pub_ip_addr = pub_ip;
@@ -233,26 +277,53 @@ int NatApp::DeleteTable(uint32_t pub_ip)
 /* Check for duplicate entries */
 bool NatApp::ChkForDup(const nat_table_entry *rule)
 {
-	int cnt = 0;
 	IPACMDBG("%s() %d\n", __FUNCTION__, __LINE__);
 
-	for(; cnt < max_entries; cnt++)
+	if(cache_index.Find(rule) >= 0)
 	{
-		if(cache[cnt].private_ip == rule->private_ip &&
-			 cache[cnt].target_ip == rule->target_ip &&
-			 cache[cnt].private_port ==  rule->private_port  &&
-			 cache[cnt].target_port == rule->target_port &&
-			 cache[cnt].protocol == rule->protocol)
-		{
-			log_nat(rule->protocol,rule->private_ip,rule->target_ip,rule->private_port,\
-			rule->target_port,"Duplicate Rule\n");
-			return true;
-		}
+		log_nat(rule->protocol,rule->private_ip,rule->target_ip,rule->private_port,\
+		rule->target_port,"Duplicate Rule\n");
+		return true;
 	}
 
 	return false;
 }
 
+/* Drop a cache entry from the index and release its slot */
+void NatApp::FreeCacheEntry(int cnt)
+{
+	cache_index.Remove(cnt);
+	memset(&cache[cnt], 0, sizeof(cache[cnt]));
+	cache_index.FreeSlot(cnt);
+	curCnt--;
+}
+
+/* Post the rules added since ipa_nat_batch_begin(), the ones that
+   could not be enabled leave the cache as if their add had failed */
+void NatApp::CommitBatch()
+{
+	uint32_t num_failed = 0, idx;
+	int cnt;
+
+	if(ipa_nat_batch_commit(nat_table_hdl, batch_failed, max_entries, &num_failed) == 0)
+	{
+		return;
+	}
+
+	IPACMERR("unable to commit the batched rules, %d of them not added\n", num_failed);
+	for(idx = 0; idx < num_failed; idx++)
+	{
+		for(cnt = 0; cnt < max_entries; cnt++)
+		{
+			if(cache[cnt].enabled && cache[cnt].rule_hdl == batch_failed[idx])
+			{
+				FreeCacheEntry(cnt);
+				break;
+			}
+		}
+	}
+}
+
 /* Delete the entry from Nat table on connection close */
 int NatApp::DeleteEntry(const nat_table_entry *rule)
 {
@@ -263,33 +334,24 @@ int NatApp::DeleteEntry(const nat_table_entry *rule)
 	rule->target_port,"for deletion\n");
 
 
-	for(; cnt < max_entries; cnt++)
+	cnt = cache_index.Find(rule);
+	if(cnt >= 0)
 	{
-		if(cache[cnt].private_ip == rule->private_ip &&
-			 cache[cnt].target_ip == rule->target_ip &&
-			 cache[cnt].private_port ==  rule->private_port  &&
-			 cache[cnt].target_port == rule->target_port &&
-			 cache[cnt].protocol == rule->protocol)
+		if(cache[cnt].enabled == true)
 		{
-
-			if(cache[cnt].enabled == true)
-			{
-				if(ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl) < 0)
-				{
-					IPACMERR("%s() %d deletion failed\n", __FUNCTION__, __LINE__);
-				}
-
-				IPACMDBG_H("Deleted Nat entry(%d) Successfully\n", cnt);
-			}
-			else
+			if(ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl) < 0)
 			{
-				IPACMDBG_H("Deleted Nat entry(%d) only from cache\n", cnt);
+				IPACMERR("%s() %d deletion failed\n", __FUNCTION__, __LINE__);
 			}
 
-			memset(&cache[cnt], 0, sizeof(cache[cnt]));
-			curCnt--;
-			break;
+			IPACMDBG_H("Deleted Nat entry(%d) Successfully\n", cnt);
 		}
+		else
+		{
+			IPACMDBG_H("Deleted Nat entry(%d) only from cache\n", cnt);
+		}
+
+		FreeCacheEntry(cnt);
 	}
 
 	return 0;
@@ -325,19 +387,8 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 
 	if(!ChkForDup(rule))
 	{
-		for(; cnt < max_entries; cnt++)
-		{
-			if(cache[cnt].private_ip == 0 &&
-				 cache[cnt].target_ip == 0 &&
-				 cache[cnt].private_port == 0  &&
-				 cache[cnt].target_port == 0 &&
-				 cache[cnt].protocol == 0)
-			{
-				break;
-			}
-		}
-
-		if(max_entries == cnt)
+		cnt = cache_index.AllocSlot();
+		if(cnt < 0)
 		{
 			IPACMERR("Error: Unable to add, reached maximum rules\n");
 			return -1;
@@ -365,6 +416,7 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 				if(ipa_nat_add_ipv4_rule(nat_table_hdl, &nat_rule, &cache[cnt].rule_hdl) < 0)
 				{
 					IPACMERR("unable to add the rule\n");
+					cache_index.FreeSlot(cnt);
 					return -1;
 				}
 
@@ -379,6 +431,7 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 			cache[cnt].timestamp = 0;
 			cache[cnt].public_port = rule->public_port;
 			cache[cnt].dst_nat = rule->dst_nat;
+			cache_index.Insert(cnt);
 			curCnt++;
 		}
 
@@ -412,6 +465,7 @@ void NatApp::UpdateCTUdpTs(nat_table_entry *rule, uint32_t new_ts)
 	IPACMDBG("Private Port: %d, Target Port: %d\n", rule->private_port, rule->target_port);
 
 #ifndef FEATURE_IPACM_HAL
+	struct nlmsghdr *nlh;
 	int ret;
 	if(!ct_hdl)
 	{
@@ -474,17 +528,31 @@ void NatApp::UpdateCTUdpTs(nat_table_entry *rule, uint32_t new_ts)
 	IPACMDBG("updating %d connection with time: %d\n",
 					 rule->protocol, nfct_get_attr_u32(ct, ATTR_TIMEOUT));
 
-	ret = nfct_query(ct_hdl, NFCT_Q_UPDATE, ct);
-	if(ret == -1)
+	/* queue the update, FlushCTUdpTs() sends the slice as one message */
+	if(ct_batch_cnt == NAT_TS_SWEEP_SLICE)
 	{
-		IPACMERR("unable to update time stamp");
-		DeleteEntry(rule);
+		FlushCTUdpTs();
 	}
-	else
+
+	nlh = (struct nlmsghdr *)(ct_batch_buf + ct_batch_len);
+	ret = nfct_build_query(nfct_subsys_ct(ct_hdl), NFCT_Q_UPDATE, ct,
+												 nlh, sizeof(ct_batch_buf) - ct_batch_len);
+	if(ret == -1)
 	{
-		rule->timestamp = new_ts;
-		IPACMDBG("Updated time stamp successfully\n");
+		IPACMERR("unable to build time stamp update\n");
+		return;
 	}
+
+	/* only failed updates are reported back, matched by sequence number */
+	nlh->nlmsg_flags &= ~NLM_F_ACK;
+	nlh->nlmsg_seq = ++ct_batch_seq;
+
+	ct_batch[ct_batch_cnt].entry = rule - cache;
+	ct_batch[ct_batch_cnt].rule_hdl = rule->rule_hdl;
+	ct_batch[ct_batch_cnt].ts = new_ts;
+	ct_batch[ct_batch_cnt].seq = nlh->nlmsg_seq;
+	ct_batch_cnt++;
+	ct_batch_len += NLMSG_ALIGN(nlh->nlmsg_len);
 #else
 	if(rule->protocol == IPPROTO_UDP)
 	{
@@ -524,24 +592,125 @@ void NatApp::UpdateCTUdpTs(nat_table_entry *rule, uint32_t new_ts)
 		OffloadMng->touInstance->updateTimeout(entry);
 		IPACMDBG("Updated time stamp successfully\n");
 		rule->timestamp = new_ts;
+		sweep_cur.updated++;
 	}
 #endif
 	return;
 }
 
+#ifndef FEATURE_IPACM_HAL
+/* Sends the queued conntrack updates in a single netlink message and
+   applies the outcome to the cache entries they were queued for */
+void NatApp::FlushCTUdpTs()
+{
+	struct sockaddr_nl peer;
+	struct nlmsghdr *nlh;
+	struct nlmsgerr *err;
+	nat_table_entry *rule;
+	bool failed[NAT_TS_SWEEP_SLICE];
+	char buf[4096];
+	int fd, len, cnt, idx;
+
+	if(ct_batch_cnt == 0)
+	{
+		return;
+	}
+
+	memset(&peer, 0, sizeof(peer));
+	peer.nl_family = AF_NETLINK;
+	fd = nfnl_fd(nfct_nfnlh(ct_hdl));
+
+	if(sendto(fd, ct_batch_buf, ct_batch_len, 0,
+						(struct sockaddr *)&peer, sizeof(peer)) < 0)
+	{
+		PERROR("sendto");
+		IPACMERR("unable to send %d time stamp updates, retry on next sweep\n", ct_batch_cnt);
+		ct_batch_cnt = 0;
+		ct_batch_len = 0;
+		return;
+	}
+	sweep_cur.netlink_msgs++;
+
+	/* the kernel processes the whole message within sendto(), so any
+		 error report is queued on the socket by now */
+	memset(failed, 0, sizeof(failed));
+	while((len = recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+	{
+		for(nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len))
+		{
+			if(nlh->nlmsg_type != NLMSG_ERROR)
+			{
+				continue;
+			}
+
+			err = (struct nlmsgerr *)NLMSG_DATA(nlh);
+			idx = nlh->nlmsg_seq - ct_batch[0].seq;
+			if(err->error != 0 && idx >= 0 && idx < ct_batch_cnt)
+			{
+				failed[idx] = true;
+			}
+		}
+	}
+
+	for(cnt = 0; cnt < ct_batch_cnt; cnt++)
+	{
+		rule = &cache[ct_batch[cnt].entry];
+		if(rule->enabled == false || rule->rule_hdl != ct_batch[cnt].rule_hdl)
+		{
+			IPACMDBG("entry %d changed while queued, skip it\n", ct_batch[cnt].entry);
+			continue;
+		}
+
+		if(failed[cnt])
+		{
+			IPACMERR("unable to update time stamp");
+			sweep_cur.failed++;
+			DeleteEntry(rule);
+		}
+		else
+		{
+			rule->timestamp = ct_batch[cnt].ts;
+			sweep_cur.updated++;
+			IPACMDBG("Updated time stamp successfully\n");
+		}
+	}
+
+	ct_batch_cnt = 0;
+	ct_batch_len = 0;
+}
+#endif
+
+/* Checks the next NAT_TS_SWEEP_SLICE cache entries, resuming where the
+   previous call stopped, so one pass over the cache is spread over
+   GetSweepSlices() calls */
 void NatApp::UpdateUDPTimeStamp()
 {
-	int cnt;
-	uint32_t ts;
-	bool read_to = false;
+	int cnt, checked;
+	uint32_t ts, elapsed_us;
+	struct timespec start, end;
 
-	for(cnt = 0; cnt < max_entries; cnt++)
+	if(cache == NULL || max_entries == 0)
 	{
+		return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	if(sweep_cursor == 0)
+	{
+		memset(&sweep_cur, 0, sizeof(sweep_cur));
+		sweep_read_to = false;
+	}
+
+	for(checked = 0; checked < NAT_TS_SWEEP_SLICE && sweep_cursor < max_entries; checked++)
+	{
+		cnt = sweep_cursor++;
 		ts = 0;
 		if(cache[cnt].enabled == true &&
 		   (cache[cnt].private_ip != cache[cnt].public_ip))
 		{
 			IPACMDBG("\n");
+			sweep_cur.queried++;
 			if(ipa_nat_query_timestamp(nat_table_hdl, cache[cnt].rule_hdl, &ts) < 0)
 			{
 				IPACMERR("unable to retrieve timeout for rule hanle: %d\n", cache[cnt].rule_hdl);
@@ -555,8 +724,9 @@ void NatApp::UpdateUDPTimeStamp()
 				continue;
 			}
 
-			if (read_to == false) {
-				read_to = true;
+			/* timeouts are read once per pass */
+			if (sweep_read_to == false) {
+				sweep_read_to = true;
 				Read_TcpUdp_Timeout();
 			}
 
@@ -565,6 +735,49 @@ void NatApp::UpdateUDPTimeStamp()
 
 	} /* end of for loop */
 
+#ifndef FEATURE_IPACM_HAL
+	FlushCTUdpTs();
+#endif
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	elapsed_us = (end.tv_sec - start.tv_sec) * 1000000 +
+							 (end.tv_nsec - start.tv_nsec) / 1000;
+	sweep_cur.slices++;
+	sweep_cur.total_us += elapsed_us;
+	if(elapsed_us > sweep_cur.max_slice_us)
+	{
+		sweep_cur.max_slice_us = elapsed_us;
+	}
+
+	if(sweep_cursor >= max_entries)
+	{
+		sweep_cursor = 0;
+		sweep_cur.sweeps = sweep_last.sweeps + 1;
+		sweep_last = sweep_cur;
+		IPACMDBG_H("timestamp sweep %d: %d slices, %d queried, %d updated, %d failed, %d netlink msgs, %d us (max %d us per slice)\n",
+							 sweep_last.sweeps, sweep_last.slices, sweep_last.queried,
+							 sweep_last.updated, sweep_last.failed, sweep_last.netlink_msgs,
+							 sweep_last.total_us, sweep_last.max_slice_us);
+	}
+}
+
+/* Calls to UpdateUDPTimeStamp() needed for one pass over the cache */
+int NatApp::GetSweepSlices()
+{
+	if(max_entries <= 0)
+	{
+		return 1;
+	}
+	return (max_entries + NAT_TS_SWEEP_SLICE - 1) / NAT_TS_SWEEP_SLICE;
+}
+
+/* Statistics of the last completed sweep pass */
+void NatApp::GetSweepStats(nat_sweep_stats *stats)
+{
+	if(stats != NULL)
+	{
+		memcpy(stats, &sweep_last, sizeof(*stats));
+	}
 }
 
 bool NatApp::isAlgPort(uint8_t proto, uint16_t port)
@@ -584,18 +797,7 @@ bool NatApp::isAlgPort(uint8_t proto, uint16_t port)
 
 bool NatApp::isPwrSaveIf(uint32_t ip_addr)
 {
-	int cnt;
-
-	for(cnt = 0; cnt < IPA_MAX_NUM_WIFI_CLIENTS; cnt++)
-	{
-		if(0 != PwrSaveIfs[cnt] &&
-			 ip_addr == PwrSaveIfs[cnt])
-		{
-			return true;
-		}
-	}
-
-	return false;
+	return (pwr_save_index.Find(&ip_addr) >= 0);
 }
 
 int NatApp::UpdatePwrSaveIf(uint32_t client_lan_ip)
@@ -610,22 +812,15 @@ int NatApp::UpdatePwrSaveIf(uint32_t client_lan_ip)
 	}
 
 	/* check for duplicate events */
-	for(cnt = 0; cnt < IPA_MAX_NUM_WIFI_CLIENTS; cnt++)
+	if(isPwrSaveIf(client_lan_ip))
 	{
-		if(PwrSaveIfs[cnt] == client_lan_ip)
-		{
-			IPACMDBG("The client 0x%x is already in power save\n", client_lan_ip);
-			return 0;
-		}
+		IPACMDBG("The client 0x%x is already in power save\n", client_lan_ip);
+		return 0;
 	}
 
-	for(cnt = 0; cnt < IPA_MAX_NUM_WIFI_CLIENTS; cnt++)
+	if(pwr_save_index.Insert(&client_lan_ip, 0) != 0)
 	{
-		if(PwrSaveIfs[cnt] == 0)
-		{
-			PwrSaveIfs[cnt] = client_lan_ip;
-			break;
-		}
+		IPACMERR("Power save table full, 0x%x not added\n", client_lan_ip);
 	}
 
 	for(cnt = 0; cnt < max_entries; cnt++)
@@ -660,14 +855,7 @@ int NatApp::ResetPwrSaveIf(uint32_t client_lan_ip)
 		return -1;
 	}
 
-	for(cnt = 0; cnt < IPA_MAX_NUM_WIFI_CLIENTS; cnt++)
-	{
-		if(PwrSaveIfs[cnt] == client_lan_ip)
-		{
-			PwrSaveIfs[cnt] = 0;
-			break;
-		}
-	}
+	pwr_save_index.Remove(&client_lan_ip);
 
 	for(cnt = 0; cnt < max_entries; cnt++)
 	{
@@ -687,8 +875,7 @@ int NatApp::ResetPwrSaveIf(uint32_t client_lan_ip)
 			if(ipa_nat_add_ipv4_rule(nat_table_hdl, &nat_rule, &cache[cnt].rule_hdl) < 0)
 			{
 				IPACMERR("unable to add the rule delete from cache\n");
-				memset(&cache[cnt], 0, sizeof(cache[cnt]));
-				curCnt--;
+				FreeCacheEntry(cnt);
 				continue;
 			}
 			cache[cnt].enabled = true;
@@ -799,10 +986,17 @@ void NatApp::FlushTempEntries(uint32_t ip_addr, bool isAdd,
 {
 	int cnt;
 	int ret;
+	bool batched = false;
 
 	IPACMDBG_H("Received below with isAdd:%d ", isAdd);
 	iptodot("IP Address: ", ip_addr);
 
+	/* post the flushed rules to hw with as few dma commands as possible */
+	if(isAdd && nat_table_hdl != 0)
+	{
+		batched = (ipa_nat_batch_begin(nat_table_hdl) == 0);
+	}
+
 	for(cnt=0; cnt<MAX_TEMP_ENTRIES; cnt++)
 	{
 		if(temp[cnt].private_ip == ip_addr ||
@@ -832,6 +1026,11 @@ void NatApp::FlushTempEntries(uint32_t ip_addr, bool isAdd,
 		}
 	}
 
+	if(batched)
+	{
+		CommitBatch();
+	}
+
 	return;
 }
 
@@ -846,14 +1045,10 @@ int NatApp::DelEntriesOnClntDiscon(uint32_t ip_addr)
 		return -1;
 	}
 
-	for(cnt = 0; cnt < IPA_MAX_NUM_WIFI_CLIENTS; cnt++)
+	if(isPwrSaveIf(ip_addr))
 	{
-		if(PwrSaveIfs[cnt] == ip_addr)
-		{
-			PwrSaveIfs[cnt] = 0;
-			IPACMDBG("Remove %d power save entry\n", cnt);
-			break;
-		}
+		pwr_save_index.Remove(&ip_addr);
+		IPACMDBG("Remove 0x%x power save entry\n", ip_addr);
 	}
 
 	for(cnt = 0; cnt < max_entries; cnt++)
@@ -907,8 +1102,7 @@ int NatApp::DelEntriesOnSTAClntDiscon(uint32_t ip_addr)
 				}
 			}
 
-			memset(&cache[cnt], 0, sizeof(cache[cnt]));
-			curCnt--;
+			FreeCacheEntry(cnt);
 		}
 	}
 
@@ -932,19 +1126,8 @@ void NatApp::CacheEntry(const nat_table_entry *rule)
 
 	if(!ChkForDup(rule))
 	{
-		for(cnt=0; cnt < max_entries; cnt++)
-		{
-			if(cache[cnt].private_ip == 0 &&
-				 cache[cnt].target_ip == 0 &&
-				 cache[cnt].private_port == 0  &&
-				 cache[cnt].target_port == 0 &&
-				 cache[cnt].protocol == 0)
-			{
-				break;
-			}
-		}
-
-		if(max_entries == cnt)
+		cnt = cache_index.AllocSlot();
+		if(cnt < 0)
 		{
 			IPACMERR("Error: Unable to add, reached maximum rules\n");
 			return;
@@ -962,6 +1145,7 @@ void NatApp::CacheEntry(const nat_table_entry *rule)
 			cache[cnt].public_port = rule->public_port;
 			cache[cnt].public_ip = rule->public_ip;
 			cache[cnt].dst_nat = rule->dst_nat;
+			cache_index.Insert(cnt);
 			curCnt++;
 		}
 
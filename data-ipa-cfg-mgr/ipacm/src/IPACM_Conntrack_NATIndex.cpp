@@ -0,0 +1,196 @@
+/*
+Copyright (c) 2017, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "IPACM_Conntrack_NATIndex.h"
+
+#define NAT_INDEX_EMPTY (-1)
+
+static inline bool IsSameConn(const nat_table_entry *a, const nat_table_entry *b)
+{
+	return (a->private_ip == b->private_ip &&
+		a->target_ip == b->target_ip &&
+		a->private_port == b->private_port &&
+		a->target_port == b->target_port &&
+		a->protocol == b->protocol);
+}
+
+NatCacheIndex::NatCacheIndex()
+{
+	cache = NULL;
+	max_entries = 0;
+	buckets = NULL;
+	bucket_mask = 0;
+	free_slots = NULL;
+	free_cnt = 0;
+}
+
+NatCacheIndex::~NatCacheIndex()
+{
+	free(buckets);
+	free(free_slots);
+}
+
+int NatCacheIndex::Init(nat_table_entry *cache_array, int entries)
+{
+	uint32_t nbuckets = 1;
+	int cnt;
+
+	/* keep the load factor at or below 1/2 */
+	while(nbuckets < (uint32_t)entries * 2)
+	{
+		nbuckets <<= 1;
+	}
+
+	free(buckets);
+	free(free_slots);
+	buckets = (int *)malloc(sizeof(int) * nbuckets);
+	free_slots = (int *)malloc(sizeof(int) * (entries > 0 ? entries : 1));
+	if(buckets == NULL || free_slots == NULL)
+	{
+		free(buckets);
+		free(free_slots);
+		buckets = NULL;
+		free_slots = NULL;
+		return -1;
+	}
+
+	cache = cache_array;
+	max_entries = entries;
+	bucket_mask = nbuckets - 1;
+	for(cnt = 0; cnt < (int)nbuckets; cnt++)
+	{
+		buckets[cnt] = NAT_INDEX_EMPTY;
+	}
+
+	/* hand out the low slots first, like the linear search did */
+	free_cnt = 0;
+	for(cnt = max_entries - 1; cnt >= 0; cnt--)
+	{
+		free_slots[free_cnt++] = cnt;
+	}
+	return 0;
+}
+
+uint32_t NatCacheIndex::Bucket(const nat_table_entry *rule) const
+{
+	uint32_t h;
+
+	h = rule->private_ip * 0x9E3779B1;
+	h ^= rule->target_ip + 0x7F4A7C15 + (h << 6) + (h >> 2);
+	h ^= (((uint32_t)rule->private_port << 16) | rule->target_port) +
+		0x7F4A7C15 + (h << 6) + (h >> 2);
+	h ^= rule->protocol;
+
+	/* final avalanche, so that the low bits depend on the whole tuple */
+	h ^= h >> 16;
+	h *= 0x85EBCA6B;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35;
+	h ^= h >> 16;
+
+	return h & bucket_mask;
+}
+
+int NatCacheIndex::Find(const nat_table_entry *rule) const
+{
+	uint32_t b;
+
+	if(buckets == NULL)
+	{
+		return -1;
+	}
+
+	for(b = Bucket(rule); buckets[b] != NAT_INDEX_EMPTY; b = (b + 1) & bucket_mask)
+	{
+		if(IsSameConn(&cache[buckets[b]], rule))
+		{
+			return buckets[b];
+		}
+	}
+	return -1;
+}
+
+int NatCacheIndex::AllocSlot()
+{
+	if(free_cnt == 0)
+	{
+		return -1;
+	}
+	return free_slots[--free_cnt];
+}
+
+void NatCacheIndex::FreeSlot(int slot)
+{
+	if(slot >= 0 && slot < max_entries && free_cnt < max_entries)
+	{
+		free_slots[free_cnt++] = slot;
+	}
+}
+
+void NatCacheIndex::Insert(int slot)
+{
+	uint32_t b;
+
+	for(b = Bucket(&cache[slot]); buckets[b] != NAT_INDEX_EMPTY; b = (b + 1) & bucket_mask)
+	{
+		if(buckets[b] == slot)
+		{
+			return;
+		}
+	}
+	buckets[b] = slot;
+}
+
+void NatCacheIndex::Remove(int slot)
+{
+	uint32_t b, next, home;
+
+	for(b = Bucket(&cache[slot]); buckets[b] != slot; b = (b + 1) & bucket_mask)
+	{
+		if(buckets[b] == NAT_INDEX_EMPTY)
+		{
+			return;
+		}
+	}
+
+	/* backward shift deletion: pull up the entries of the probe run that
+	 * would not be reachable anymore through the hole, so that no tombstones
+	 * are needed */
+	for(next = (b + 1) & bucket_mask; buckets[next] != NAT_INDEX_EMPTY; next = (next + 1) & bucket_mask)
+	{
+		home = Bucket(&cache[buckets[next]]);
+		if(((next - home) & bucket_mask) >= ((next - b) & bucket_mask))
+		{
+			buckets[b] = buckets[next];
+			b = next;
+		}
+	}
+	buckets[b] = NAT_INDEX_EMPTY;
+}
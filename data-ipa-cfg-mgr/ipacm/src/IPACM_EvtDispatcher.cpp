@@ -47,9 +47,39 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 extern pthread_mutex_t mutex;
 extern pthread_cond_t  cond_var;
 
-cmd_evts *IPACM_EvtDispatcher::head = NULL;
+cmd_evts *IPACM_EvtDispatcher::evt_head[IPACM_EVENT_MAX];
+cmd_evts *IPACM_EvtDispatcher::evt_tail[IPACM_EVENT_MAX];
+pthread_mutex_t IPACM_EvtDispatcher::reg_lock = PTHREAD_MUTEX_INITIALIZER;
 extern uint32_t ipacm_event_stats[IPACM_EVENT_MAX];
 
+/* Client level events only touch the listener state of one interface and
+   may run on the event worker of that interface. Everything else, and in
+   particular every event that creates or deletes a listener, is a barrier
+   run on the command queue thread once the workers are idle. */
+int IPACM_EvtDispatcher::GetEvtIface(ipacm_cmd_q_data *data)
+{
+	if(data->evt_data == NULL)
+	{
+		return -1;
+	}
+
+	switch(data->event)
+	{
+	case IPA_WLAN_CLIENT_POWER_SAVE_EVENT:
+	case IPA_WLAN_CLIENT_RECOVER_EVENT:
+		return ((ipacm_event_data_mac *)data->evt_data)->if_index;
+
+	case IPA_NEW_NEIGH_EVENT:
+	case IPA_DEL_NEIGH_EVENT:
+	case IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT:
+	case IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT:
+		return ((ipacm_event_data_all *)data->evt_data)->if_index;
+
+	default:
+		return -1;
+	}
+}
+
 int IPACM_EvtDispatcher::PostEvt
 (
 	 ipacm_cmd_q_data *data
@@ -74,21 +104,23 @@ int IPACM_EvtDispatcher::PostEvt
 		return IPACM_FAILURE;
 	}
 
-	item = new Message();
+	if(pthread_mutex_lock(&mutex) != 0)
+	{
+		IPACMERR("unable to lock the mutex\n");
+		return IPACM_FAILURE;
+	}
+
+	item = MessageQueue::getMessage();
 	if(item == NULL)
 	{
 		IPACMERR("unable to create new message item\n");
+		pthread_mutex_unlock(&mutex);
 		return IPACM_FAILURE;
 	}
 
 	item->evt.callback_ptr = IPACM_EvtDispatcher::ProcessEvt;
 	memcpy(&item->evt.data, data, sizeof(ipacm_cmd_q_data));
-
-	if(pthread_mutex_lock(&mutex) != 0)
-	{
-		IPACMERR("unable to lock the mutex\n");
-		return IPACM_FAILURE;
-	}
+	item->evt.if_index = GetEvtIface(data);
 
 	IPACMDBG("Enqueing item\n");
 	MsgQueue->enqueue(item);
@@ -117,28 +149,48 @@ int IPACM_EvtDispatcher::PostEvt
 
 void IPACM_EvtDispatcher::ProcessEvt(ipacm_cmd_q_data *data)
 {
+	cmd_evts *tmp, tmp1;
+	bool parallel;
 
-	cmd_evts *tmp = head, tmp1;
+	if(data->event >= IPACM_EVENT_MAX)
+	{
+		IPACMERR("invalid event %d\n", data->event);
+		tmp = NULL;
+	}
+	else
+	{
+		tmp = __atomic_load_n(&evt_head[data->event], __ATOMIC_ACQUIRE);
+	}
 
-	if(head == NULL)
+	if(tmp == NULL)
 	{
 		IPACMDBG("Queue is empty\n");
 	}
 
+	/* other workers may be in the same listener for another interface */
+	parallel = (MessageQueue::getNumWorkers() > 0 && GetEvtIface(data) >= 0);
+
 	while(tmp != NULL)
 	{
-	        memcpy(&tmp1, tmp, sizeof(tmp1));
-		if(data->event == tmp1.event)
+		memcpy(&tmp1, tmp, sizeof(tmp1));
+		tmp1.next = __atomic_load_n(&tmp->next, __ATOMIC_ACQUIRE);
+		__atomic_fetch_add(&ipacm_event_stats[data->event], 1, __ATOMIC_RELAXED);
+		if(parallel)
+		{
+			pthread_mutex_lock(&tmp1.obj->evt_lock);
+			tmp1.obj->event_callback(data->event, data->evt_data);
+			pthread_mutex_unlock(&tmp1.obj->evt_lock);
+		}
+		else
 		{
-			ipacm_event_stats[data->event]++;
 			tmp1.obj->event_callback(data->event, data->evt_data);
-			IPACMDBG(" Find matched registered events\n");
 		}
-	        tmp = tmp1.next;
+		IPACMDBG(" Find matched registered events\n");
+		tmp = tmp1.next;
 	}
 
 	IPACMDBG(" Finished process events\n");
-			
+
 	if(data->evt_data != NULL)
 	{
 		IPACMDBG("free the event:%d data: %p\n", data->event, data->evt_data);
@@ -149,7 +201,13 @@ void IPACM_EvtDispatcher::ProcessEvt(ipacm_cmd_q_data *data)
 
 int IPACM_EvtDispatcher::registr(ipa_cm_event_id event, IPACM_Listener *obj)
 {
-	cmd_evts *tmp = head,*nw;
+	cmd_evts *nw;
+
+	if(event >= IPACM_EVENT_MAX)
+	{
+		IPACMERR("invalid event %d\n", event);
+		return IPACM_FAILURE;
+	}
 
 	nw = (cmd_evts *)malloc(sizeof(cmd_evts));
 	if(nw != NULL)
@@ -163,52 +221,61 @@ int IPACM_EvtDispatcher::registr(ipa_cm_event_id event, IPACM_Listener *obj)
 		return IPACM_FAILURE;
 	}
 
-	if(head == NULL)
+	/* listeners register from event callbacks, possibly on a worker
+	   walking the same list, so publish the node after filling it */
+	pthread_mutex_lock(&reg_lock);
+	if(evt_head[event] == NULL)
 	{
-		head = nw;
+		__atomic_store_n(&evt_head[event], nw, __ATOMIC_RELEASE);
 	}
 	else
 	{
-		while(tmp->next)
-		{
-			tmp = tmp->next;
-		}
-		tmp->next = nw;
+		__atomic_store_n(&evt_tail[event]->next, nw, __ATOMIC_RELEASE);
 	}
+	evt_tail[event] = nw;
+	pthread_mutex_unlock(&reg_lock);
 	return IPACM_SUCCESS;
 }
 
 
 int IPACM_EvtDispatcher::deregistr(IPACM_Listener *param)
 {
-	cmd_evts *tmp = head,*tmp1,*prev = head;
+	cmd_evts *tmp, *tmp1, *prev;
+	int event;
 
-	while(tmp != NULL)
+	pthread_mutex_lock(&reg_lock);
+	for(event = 0; event < IPACM_EVENT_MAX; event++)
 	{
-		if(tmp->obj == param)
+		tmp = evt_head[event];
+		prev = NULL;
+		while(tmp != NULL)
 		{
-			tmp1 = tmp;
-			if(tmp == head)
-			{
-				head = head->next;
-			}
-			else if(tmp->next == NULL)
+			if(tmp->obj == param)
 			{
-				prev->next = NULL;
+				tmp1 = tmp;
+				if(prev == NULL)
+				{
+					evt_head[event] = tmp->next;
+				}
+				else
+				{
+					prev->next = tmp->next;
+				}
+				if(evt_tail[event] == tmp)
+				{
+					evt_tail[event] = prev;
+				}
+
+				tmp = tmp->next;
+				free(tmp1);
 			}
 			else
 			{
-				prev->next = tmp->next;
+				prev = tmp;
+				tmp = tmp->next;
 			}
-
-			tmp = tmp->next;
-			free(tmp1);
-		}
-		else
-		{
-			prev = tmp;
-			tmp = tmp->next;
 		}
 	}
+	pthread_mutex_unlock(&reg_lock);
 	return IPACM_SUCCESS;
 }
@@ -44,6 +44,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.Z
 #include <IPACM_Lan.h>
 #include <IPACM_Wan.h>
 #include <IPACM_Wlan.h>
+#include <IPACM_IfaceRegistry.h>
 #include <string.h>
 
 extern "C"
@@ -316,10 +317,10 @@ int IPACM_Iface::iface_ipa_index_query
 	 int interface_index
 )
 {
-	int fd;
 	int link = INVALID_IFACE;
 	int i = 0;
-	struct ifreq ifr;
+	uint32_t gen;
+	char if_name[IF_NAME_LEN];
 
 
 	if(IPACM_Iface::ipacmcfg->iface_table == NULL)
@@ -328,6 +329,14 @@ int IPACM_Iface::iface_ipa_index_query
 		return link;
 	}
 
+	/* Resolved before and not renamed since */
+	link = IPACM_IfaceRegistry::GetIpaIndex(interface_index, &gen);
+	if (link != IPA_IFACE_INDEX_UNKNOWN)
+	{
+		return link;
+	}
+	link = INVALID_IFACE;
+
 	/* Search known linux interface-index and map to IPA interface-index*/
 	for (i = 0; i < IPACM_Iface::ipacmcfg->ipa_num_ipa_interfaces; i++)
 	{
@@ -338,39 +347,27 @@ int IPACM_Iface::iface_ipa_index_query
 							 IPACM_Iface::ipacmcfg->iface_table[i].iface_name,
 							 IPACM_Iface::ipacmcfg->iface_table[i].netlink_interface_index,
 							 link);
+			IPACM_IfaceRegistry::SetIpaIndex(interface_index, link, gen);
 			return link;
 			break;
 		}
 	}
 
 	/* Search/Configure linux interface-index and map it to IPA interface-index */
-	if ((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
-	{
-		PERROR("get interface name socket create failed");
-		return IPACM_FAILURE;
-	}
-
-	memset(&ifr, 0, sizeof(struct ifreq));
-
-	ifr.ifr_ifindex = interface_index;
 	IPACMDBG_H("Interface index %d\n", interface_index);
-
-	if (ioctl(fd, SIOCGIFNAME, &ifr) < 0)
+	if (IPACM_IfaceRegistry::GetIfName(interface_index, if_name) != IPACM_SUCCESS)
 	{
-		PERROR("call_ioctl_on_dev: ioctl failed:");
-		close(fd);
 		return IPACM_FAILURE;
 	}
-	close(fd);
 
-	IPACMDBG_H("Received interface name %s\n", ifr.ifr_name);
+	IPACMDBG_H("Received interface name %s\n", if_name);
 	for (i = 0; i < IPACM_Iface::ipacmcfg->ipa_num_ipa_interfaces; i++)
 	{
-		if (strncmp(ifr.ifr_name,
+		if (strncmp(if_name,
 								IPACM_Iface::ipacmcfg->iface_table[i].iface_name,
 								sizeof(IPACM_Iface::ipacmcfg->iface_table[i].iface_name)) == 0)
 		{
-			IPACMDBG_H("Interface (%s) linux(%d) mapped to ipa(%d) \n", ifr.ifr_name,
+			IPACMDBG_H("Interface (%s) linux(%d) mapped to ipa(%d) \n", if_name,
 							 IPACM_Iface::ipacmcfg->iface_table[i].netlink_interface_index, i);
 
 			link = i;
@@ -378,6 +375,8 @@ int IPACM_Iface::iface_ipa_index_query
 			break;
 		}
 	}
+	/* interfaces IPACM does not manage are remembered as INVALID_IFACE */
+	IPACM_IfaceRegistry::SetIpaIndex(interface_index, link, gen);
 
 	return link;
 }
@@ -388,33 +387,18 @@ void IPACM_Iface::iface_addr_query
 	 int interface_index
 )
 {
-	int fd;
-	struct ifreq ifr;
+	char if_name[IF_NAME_LEN];
 	struct ifaddrs *myaddrs, *ifa;
 	ipacm_cmd_q_data evt_data;
 	ipacm_event_data_addr *data_addr;
 	struct in_addr iface_ipv4;
 
 	/* use linux interface-index to find interface name */
-	if ((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
-	{
-		PERROR("get interface name socket create failed");
-		return ;
-	}
-
-	memset(&ifr, 0, sizeof(struct ifreq));
-
-	ifr.ifr_ifindex = interface_index;
-	IPACMDBG_H("Interface index %d\n", interface_index);
-
-	if (ioctl(fd, SIOCGIFNAME, &ifr) < 0)
+	if (IPACM_IfaceRegistry::GetIfName(interface_index, if_name) != IPACM_SUCCESS)
 	{
-		PERROR("call_ioctl_on_dev: ioctl failed:");
-		close(fd);
 		return ;
 	}
-	IPACMDBG_H("Interface index %d name: %s\n", interface_index,ifr.ifr_name);
-	close(fd);
+	IPACMDBG_H("Interface index %d name: %s\n", interface_index,if_name);
 
 	/* query ipv4/v6 address */
     if(getifaddrs(&myaddrs) != 0)
@@ -430,7 +414,7 @@ void IPACM_Iface::iface_addr_query
         if (!(ifa->ifa_flags & IFF_UP))
             continue;
 
-		if(strcmp(ifr.ifr_name,ifa->ifa_name) == 0) // find current iface
+		if(strcmp(if_name,ifa->ifa_name) == 0) // find current iface
 		{
 			IPACMDBG_H("Internal post new_addr event for iface %s\n", ifa->ifa_name);
 			switch (ifa->ifa_addr->sa_family)
@@ -453,7 +437,7 @@ void IPACM_Iface::iface_addr_query
 					data_addr->if_index = interface_index;
 					data_addr->ipv4_addr = 	iface_ipv4.s_addr;
 					data_addr->ipv4_addr = ntohl(data_addr->ipv4_addr);
-					strlcpy(data_addr->iface_name, ifr.ifr_name, sizeof(data_addr->iface_name));
+					strlcpy(data_addr->iface_name, if_name, sizeof(data_addr->iface_name));
 					IPACMDBG_H("Posting IPA_ADDR_ADD_EVENT with if index:%d, if name:%s, ipv4 addr:0x%x\n",
 						data_addr->if_index,
 						data_addr->iface_name,
@@ -486,7 +470,7 @@ void IPACM_Iface::iface_addr_query
 					data_addr->ipv6_addr[1] = ntohl(data_addr->ipv6_addr[1]);
 					data_addr->ipv6_addr[2] = ntohl(data_addr->ipv6_addr[2]);
 					data_addr->ipv6_addr[3] = ntohl(data_addr->ipv6_addr[3]);
-					strlcpy(data_addr->iface_name, ifr.ifr_name, sizeof(data_addr->iface_name));
+					strlcpy(data_addr->iface_name, if_name, sizeof(data_addr->iface_name));
 					IPACMDBG_H("Posting IPA_ADDR_ADD_EVENT with if index:%d, if name:%s, ipv6 addr:0x%x:%x:%x:%x\n",
 							data_addr->if_index,
 							data_addr->iface_name,
@@ -950,37 +934,7 @@ int IPACM_Iface::ipa_get_if_index
   int * if_index
 )
 {
-	int fd;
-	struct ifreq ifr;
-
-	if((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
-	{
-		IPACMERR("get interface index socket create failed \n");
-		return IPACM_FAILURE;
-	}
-
-	if(strlen(if_name) >= sizeof(ifr.ifr_name))
-	{
-		IPACMERR("interface name overflows: len %zu\n", strlen(if_name));
-		close(fd);
-		return IPACM_FAILURE;
-	}
-
-	memset(&ifr, 0, sizeof(struct ifreq));
-	(void)strlcpy(ifr.ifr_name, if_name, sizeof(ifr.ifr_name));
-	IPACMDBG_H("interface name (%s)\n", if_name);
-
-	if(ioctl(fd,SIOCGIFINDEX , &ifr) < 0)
-	{
-		IPACMERR("call_ioctl_on_dev: ioctl failed, interface name (%s):\n", ifr.ifr_name);
-		close(fd);
-		return IPACM_FAILURE;
-	}
-
-	*if_index = ifr.ifr_ifindex;
-	IPACMDBG_H("Interface index %d\n", *if_index);
-	close(fd);
-	return IPACM_SUCCESS;
+	return IPACM_IfaceRegistry::GetIfIndex(if_name, if_index);
 }
 
 void IPACM_Iface::config_ip_type(ipa_ip_type iptype)
@@ -0,0 +1,325 @@
+/*
+Copyright (c) 2017, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/if.h>
+#include "IPACM_IfaceRegistry.h"
+#include "IPACM_Log.h"
+
+ipacm_netdev_entry IPACM_IfaceRegistry::netdevs[IPA_MAX_NUM_NETDEVS];
+int IPACM_IfaceRegistry::free_slots[IPA_MAX_NUM_NETDEVS];
+int IPACM_IfaceRegistry::num_free = 0;
+ClientIndex IPACM_IfaceRegistry::by_index;
+ClientIndex IPACM_IfaceRegistry::by_name;
+uint32_t IPACM_IfaceRegistry::link_gen = 0;
+bool IPACM_IfaceRegistry::inited = false;
+pthread_mutex_t IPACM_IfaceRegistry::lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Names are keyed zero padded to IF_NAME_LEN */
+static int make_name_key(const char *if_name, char *name_key)
+{
+	if(strlen(if_name) >= IF_NAME_LEN)
+	{
+		IPACMERR("interface name overflows: len %zu\n", strlen(if_name));
+		return IPACM_FAILURE;
+	}
+	memset(name_key, 0, IF_NAME_LEN);
+	strlcpy(name_key, if_name, IF_NAME_LEN);
+	return IPACM_SUCCESS;
+}
+
+bool IPACM_IfaceRegistry::InitLocked(void)
+{
+	int i;
+
+	if(inited)
+	{
+		return true;
+	}
+	if(by_index.Init(IPA_MAX_NUM_NETDEVS, sizeof(int)) != 0 ||
+		 by_name.Init(IPA_MAX_NUM_NETDEVS, IF_NAME_LEN) != 0)
+	{
+		IPACMERR("unable to allocate memory for interface registry\n");
+		return false;
+	}
+	for(i = 0; i < IPA_MAX_NUM_NETDEVS; i++)
+	{
+		free_slots[i] = IPA_MAX_NUM_NETDEVS - 1 - i;
+	}
+	num_free = IPA_MAX_NUM_NETDEVS;
+	inited = true;
+	return true;
+}
+
+void IPACM_IfaceRegistry::AddLocked(int if_index, const char *name_key)
+{
+	int slot;
+
+	if(num_free == 0)
+	{
+		IPACMDBG("interface registry full, %s(%d) not cached\n", name_key, if_index);
+		return;
+	}
+	slot = free_slots[--num_free];
+	netdevs[slot].if_index = if_index;
+	memcpy(netdevs[slot].if_name, name_key, IF_NAME_LEN);
+	netdevs[slot].ipa_index = IPA_IFACE_INDEX_UNKNOWN;
+	by_index.Insert(&netdevs[slot].if_index, slot);
+	by_name.Insert(netdevs[slot].if_name, slot);
+}
+
+void IPACM_IfaceRegistry::DropLocked(int slot)
+{
+	by_index.Remove(&netdevs[slot].if_index);
+	by_name.Remove(netdevs[slot].if_name);
+	memset(&netdevs[slot], 0, sizeof(netdevs[slot]));
+	free_slots[num_free++] = slot;
+}
+
+void IPACM_IfaceRegistry::UpdateLink(int if_index, const char *if_name)
+{
+	char name_key[IF_NAME_LEN];
+	int slot;
+
+	if(make_name_key(if_name, name_key) != IPACM_SUCCESS)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&lock);
+	link_gen++;
+	if(!InitLocked())
+	{
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+
+	slot = by_index.Find(&if_index);
+	if(slot >= 0 && memcmp(netdevs[slot].if_name, name_key, IF_NAME_LEN) == 0)
+	{
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+	/* renamed, the ipa index has to be resolved again */
+	if(slot >= 0)
+	{
+		IPACMDBG_H("interface %d renamed from %s to %s\n", if_index,
+						 netdevs[slot].if_name, name_key);
+		DropLocked(slot);
+	}
+	/* the name now belongs to if_index */
+	slot = by_name.Find(name_key);
+	if(slot >= 0)
+	{
+		DropLocked(slot);
+	}
+	AddLocked(if_index, name_key);
+	pthread_mutex_unlock(&lock);
+}
+
+void IPACM_IfaceRegistry::RemoveLink(int if_index)
+{
+	int slot;
+
+	pthread_mutex_lock(&lock);
+	link_gen++;
+	if(inited)
+	{
+		slot = by_index.Find(&if_index);
+		if(slot >= 0)
+		{
+			DropLocked(slot);
+		}
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+int IPACM_IfaceRegistry::GetIfName(int if_index, char *if_name)
+{
+	int fd, slot = -1;
+	uint32_t gen;
+	struct ifreq ifr;
+	char name_key[IF_NAME_LEN];
+
+	pthread_mutex_lock(&lock);
+	if(InitLocked())
+	{
+		slot = by_index.Find(&if_index);
+	}
+	if(slot >= 0)
+	{
+		strlcpy(if_name, netdevs[slot].if_name, IF_NAME_LEN);
+		pthread_mutex_unlock(&lock);
+		return IPACM_SUCCESS;
+	}
+	gen = link_gen;
+	pthread_mutex_unlock(&lock);
+
+	if((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
+	{
+		IPACMERR("get interface name socket create failed \n");
+		return IPACM_FAILURE;
+	}
+
+	memset(&ifr, 0, sizeof(struct ifreq));
+	ifr.ifr_ifindex = if_index;
+	IPACMDBG("Interface index %d\n", if_index);
+
+	if(ioctl(fd, SIOCGIFNAME, &ifr) < 0)
+	{
+		IPACMERR("call_ioctl_on_dev: ioctl failed:\n");
+		close(fd);
+		return IPACM_FAILURE;
+	}
+	close(fd);
+	IPACMDBG("interface name %s\n", ifr.ifr_name);
+
+	if(make_name_key(ifr.ifr_name, name_key) != IPACM_SUCCESS)
+	{
+		return IPACM_FAILURE;
+	}
+	/* cache the answer unless a link message may have made it stale */
+	pthread_mutex_lock(&lock);
+	if(gen == link_gen && by_index.Find(&if_index) < 0 && by_name.Find(name_key) < 0)
+	{
+		AddLocked(if_index, name_key);
+	}
+	pthread_mutex_unlock(&lock);
+
+	strlcpy(if_name, name_key, IF_NAME_LEN);
+	return IPACM_SUCCESS;
+}
+
+int IPACM_IfaceRegistry::GetIfIndex(const char *if_name, int *if_index)
+{
+	int fd, slot = -1;
+	uint32_t gen;
+	struct ifreq ifr;
+	char name_key[IF_NAME_LEN];
+
+	if(make_name_key(if_name, name_key) != IPACM_SUCCESS)
+	{
+		return IPACM_FAILURE;
+	}
+
+	pthread_mutex_lock(&lock);
+	if(InitLocked())
+	{
+		slot = by_name.Find(name_key);
+	}
+	if(slot >= 0)
+	{
+		*if_index = netdevs[slot].if_index;
+		pthread_mutex_unlock(&lock);
+		return IPACM_SUCCESS;
+	}
+	gen = link_gen;
+	pthread_mutex_unlock(&lock);
+
+	if((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
+	{
+		IPACMERR("get interface index socket create failed \n");
+		return IPACM_FAILURE;
+	}
+
+	memset(&ifr, 0, sizeof(struct ifreq));
+	(void)strlcpy(ifr.ifr_name, name_key, sizeof(ifr.ifr_name));
+	IPACMDBG_H("interface name (%s)\n", name_key);
+
+	if(ioctl(fd, SIOCGIFINDEX, &ifr) < 0)
+	{
+		IPACMERR("call_ioctl_on_dev: ioctl failed, interface name (%s):\n", ifr.ifr_name);
+		close(fd);
+		return IPACM_FAILURE;
+	}
+	close(fd);
+	IPACMDBG_H("Interface index %d\n", ifr.ifr_ifindex);
+
+	pthread_mutex_lock(&lock);
+	if(gen == link_gen && by_index.Find(&ifr.ifr_ifindex) < 0 && by_name.Find(name_key) < 0)
+	{
+		AddLocked(ifr.ifr_ifindex, name_key);
+	}
+	pthread_mutex_unlock(&lock);
+
+	*if_index = ifr.ifr_ifindex;
+	return IPACM_SUCCESS;
+}
+
+int IPACM_IfaceRegistry::GetIpaIndex(int if_index, uint32_t *gen)
+{
+	int slot = -1, ipa_index = IPA_IFACE_INDEX_UNKNOWN;
+
+	pthread_mutex_lock(&lock);
+	if(inited)
+	{
+		slot = by_index.Find(&if_index);
+	}
+	if(slot >= 0)
+	{
+		ipa_index = netdevs[slot].ipa_index;
+	}
+	if(gen != NULL)
+	{
+		*gen = link_gen;
+	}
+	pthread_mutex_unlock(&lock);
+	return ipa_index;
+}
+
+void IPACM_IfaceRegistry::SetIpaIndex(int if_index, int ipa_index, uint32_t gen)
+{
+	int slot;
+
+	pthread_mutex_lock(&lock);
+	/* the index was resolved against a name that may be stale now */
+	if(inited && gen == link_gen)
+	{
+		slot = by_index.Find(&if_index);
+		if(slot >= 0)
+		{
+			netdevs[slot].ipa_index = ipa_index;
+		}
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+void IPACM_IfaceRegistry::ResetIpaIndex(void)
+{
+	int i;
+
+	pthread_mutex_lock(&lock);
+	for(i = 0; i < IPA_MAX_NUM_NETDEVS; i++)
+	{
+		netdevs[i].ipa_index = IPA_IFACE_INDEX_UNKNOWN;
+	}
+	pthread_mutex_unlock(&lock);
+}
@@ -101,7 +101,8 @@ IPACM_Lan::IPACM_Lan(int iface_index) : IPACM_Iface(iface_index)
 		{
 			eth_client_len = (sizeof(ipa_eth_client)) + (iface_query->num_tx_props * sizeof(eth_client_rt_hdl));
 			eth_client = (ipa_eth_client *)calloc(IPA_MAX_NUM_ETH_CLIENTS, eth_client_len);
-			if (eth_client == NULL)
+			if (eth_client == NULL ||
+					eth_client_index.Init(IPA_MAX_NUM_ETH_CLIENTS, IPA_MAC_ADDR_SIZE) != 0)
 			{
 				IPACMERR("unable to allocate memory\n");
 				return;
@@ -2033,6 +2034,7 @@ int IPACM_Lan::handle_eth_hdr_init(uint8_t *mac_addr)
 		get_client_memptr(eth_client, num_eth_client)->route_rule_set_v6 = 0;
 		get_client_memptr(eth_client, num_eth_client)->ipv4_set = false;
 		get_client_memptr(eth_client, num_eth_client)->ipv6_set = 0;
+		eth_client_index.Insert(get_client_memptr(eth_client, num_eth_client)->mac, num_eth_client);
 		num_eth_client++;
 		header_name_count++; //keep increasing header_name_count
 		res = IPACM_SUCCESS;
@@ -2754,12 +2756,14 @@ int IPACM_Lan::handle_eth_client_down_evt(uint8_t *mac_addr)
 	get_client_memptr(eth_client, clt_indx)->ipv6_header_set = false;
 	get_client_memptr(eth_client, clt_indx)->route_rule_set_v4 = false;
 	get_client_memptr(eth_client, clt_indx)->route_rule_set_v6 = 0;
+	eth_client_index.Remove(mac_addr);
 
 	for (; clt_indx < num_eth_client_tmp - 1; clt_indx++)
 	{
 		memcpy(get_client_memptr(eth_client, clt_indx)->mac,
 					 get_client_memptr(eth_client, (clt_indx + 1))->mac,
 					 sizeof(get_client_memptr(eth_client, clt_indx)->mac));
+		eth_client_index.Move(get_client_memptr(eth_client, clt_indx)->mac, clt_indx + 1, clt_indx);
 
 		get_client_memptr(eth_client, clt_indx)->hdr_hdl_v4 = get_client_memptr(eth_client, (clt_indx + 1))->hdr_hdl_v4;
 		get_client_memptr(eth_client, clt_indx)->hdr_hdl_v6 = get_client_memptr(eth_client, (clt_indx + 1))->hdr_hdl_v6;
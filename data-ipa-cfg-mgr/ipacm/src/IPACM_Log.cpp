@@ -39,8 +39,14 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "IPACM_Log.h"
 #include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <time.h>
 #include <sys/socket.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -49,6 +55,9 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <sys/un.h>
 #include <errno.h>
 #include <IPACM_Defs.h>
+#ifdef FEATURE_IPA_ANDROID
+#include <cutils/properties.h>
+#endif
 
 /* start IPACMDIAG socket*/
 int create_socket(int *sockfd)
@@ -100,3 +109,794 @@ void ipacm_log_send( void * user_data)
 	}
 	return;
 }
+
+/* Asynchronous logging */
+
+#define IPACM_LOG_RING_SIZE   (64 * 1024)	/* bytes per thread, power of 2 */
+#define IPACM_LOG_MAX_REC     1024		/* bytes per message, args included */
+#define IPACM_LOG_LINE_LEN    1024
+#define IPACM_LOG_PAD         0x80		/* ring filler up to the wrap, not a message */
+#define IPACM_LOG_ALIGN(x)    (((x) + 7) & ~7U)
+#define IPACM_LOG_BATCH       (IPACM_LOG_RING_SIZE / 4)	/* wakes a dozing log thread */
+#define IPACM_LOG_DOZE_MS     20
+
+/* Log thread states. Right after writing messages it dozes and is only
+   woken by a ring filling up, so a burst costs one wakeup per batch
+   instead of one per message */
+#define IPACM_LOG_AWAKE       0
+#define IPACM_LOG_DOZING      1
+#define IPACM_LOG_ASLEEP      2
+
+int ipacm_log_level = IPACM_LOG_LEVEL_DBG;
+
+/* One message: this header, then each argument in format order as an
+   8 byte value, or a string as a 2 byte length, the bytes and a NUL
+   padded to 8 bytes */
+typedef struct
+{
+	uint16_t size;		/* total, 8 byte multiple */
+	uint8_t flags;
+	uint8_t reserved;
+	int32_t line;
+	uint64_t ts;		/* CLOCK_MONOTONIC, orders messages of different threads */
+	const char *file;
+	const char *func;
+	const char *fmt;
+} ipacm_log_rec_t;
+
+#define IPACM_LOG_REC_HDR IPACM_LOG_ALIGN(sizeof(ipacm_log_rec_t))
+
+typedef union
+{
+	int64_t i;
+	uint64_t u;
+	double d;
+	const void *p;
+} ipacm_log_val_t;
+
+/* Single producer, single consumer: head moves on the owner thread, tail
+   on the log thread. Both only grow, offsets are taken modulo the size */
+typedef struct ipacm_log_ring_s
+{
+	struct ipacm_log_ring_s *next;
+	uint32_t head;
+	uint32_t tail;
+	uint32_t dropped;
+	uint32_t reported;
+	int busy;		/* set while the owner writes, catches signal handlers */
+	int orphan;		/* owner thread exited */
+	pid_t tid;
+	uint8_t data[IPACM_LOG_RING_SIZE] __attribute__((aligned(8)));
+} ipacm_log_ring_t;
+
+static ipacm_log_ring_t *ipacm_log_rings;
+static pthread_key_t ipacm_log_key;
+static pthread_once_t ipacm_log_key_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t ipacm_log_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ipacm_log_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t ipacm_log_flushed = PTHREAD_COND_INITIALIZER;
+static int ipacm_log_async;
+static int ipacm_log_state;
+static uint32_t ipacm_log_flush_req;
+static uint32_t ipacm_log_flush_done;
+static int ipacm_log_kmsg_fd = -1;
+
+/* Conversion specification of a printf format */
+enum
+{
+	IPACM_LOG_LEN_NONE,
+	IPACM_LOG_LEN_HH,
+	IPACM_LOG_LEN_H,
+	IPACM_LOG_LEN_L,
+	IPACM_LOG_LEN_LL,
+	IPACM_LOG_LEN_J,
+	IPACM_LOG_LEN_Z,
+	IPACM_LOG_LEN_T,
+	IPACM_LOG_LEN_BIG_L
+};
+
+typedef struct
+{
+	const char *start;	/* the '%' */
+	size_t len;
+	char conv;
+	int length;
+	int star_width;
+	int star_prec;
+} ipacm_log_spec_t;
+
+/* Parses the specification at p, which points at a '%'. Returns the
+   character after it; conv is 0 if the specification is not supported */
+static const char *ipacm_log_parse_spec(const char *p, ipacm_log_spec_t *spec)
+{
+	memset(spec, 0, sizeof(*spec));
+	spec->start = p++;
+
+	while (*p && strchr("-+ #0'", *p))
+		p++;
+	if (*p == '*')
+	{
+		spec->star_width = 1;
+		p++;
+	}
+	while (*p >= '0' && *p <= '9')
+		p++;
+	if (*p == '.')
+	{
+		p++;
+		if (*p == '*')
+		{
+			spec->star_prec = 1;
+			p++;
+		}
+		while (*p >= '0' && *p <= '9')
+			p++;
+	}
+
+	switch (*p)
+	{
+	case 'h':
+		p++;
+		spec->length = IPACM_LOG_LEN_H;
+		if (*p == 'h')
+		{
+			p++;
+			spec->length = IPACM_LOG_LEN_HH;
+		}
+		break;
+	case 'l':
+		p++;
+		spec->length = IPACM_LOG_LEN_L;
+		if (*p == 'l')
+		{
+			p++;
+			spec->length = IPACM_LOG_LEN_LL;
+		}
+		break;
+	case 'q':
+		p++;
+		spec->length = IPACM_LOG_LEN_LL;
+		break;
+	case 'j':
+		p++;
+		spec->length = IPACM_LOG_LEN_J;
+		break;
+	case 'z':
+		p++;
+		spec->length = IPACM_LOG_LEN_Z;
+		break;
+	case 't':
+		p++;
+		spec->length = IPACM_LOG_LEN_T;
+		break;
+	case 'L':
+		p++;
+		spec->length = IPACM_LOG_LEN_BIG_L;
+		break;
+	}
+
+	if (*p && strchr("diuoxXcspfFeEgGaAn%", *p))
+		spec->conv = *p++;
+	spec->len = p - spec->start;
+	return p;
+}
+
+static int ipacm_log_is_signed(char conv)
+{
+	return conv == 'd' || conv == 'i';
+}
+
+static int ipacm_log_is_unsigned(char conv)
+{
+	return conv == 'u' || conv == 'o' || conv == 'x' || conv == 'X';
+}
+
+/* Copies the arguments the format consumes into the record. Stops at the
+   first argument that does not fit or whose type is unknown */
+static uint32_t ipacm_log_capture(uint8_t *rec, uint32_t pos, const char *fmt,
+		va_list ap)
+{
+	ipacm_log_spec_t spec;
+	ipacm_log_val_t val;
+	const char *p = fmt;
+
+	while ((p = strchr(p, '%')) != NULL)
+	{
+		p = ipacm_log_parse_spec(p, &spec);
+		if (spec.conv == '%')
+			continue;
+		if (spec.conv == 0)
+			break;
+
+		if (spec.star_width)
+		{
+			if (pos + sizeof(val) > IPACM_LOG_MAX_REC)
+				break;
+			val.i = va_arg(ap, int);
+			memcpy(rec + pos, &val, sizeof(val));
+			pos += sizeof(val);
+		}
+		if (spec.star_prec)
+		{
+			if (pos + sizeof(val) > IPACM_LOG_MAX_REC)
+				break;
+			val.i = va_arg(ap, int);
+			memcpy(rec + pos, &val, sizeof(val));
+			pos += sizeof(val);
+		}
+
+		if (spec.conv == 's')
+		{
+			const char *str = va_arg(ap, const char *);
+			size_t len;
+
+			if (str == NULL)
+				str = "(null)";
+			len = strlen(str);
+			if (pos + 2 + 1 > IPACM_LOG_MAX_REC)
+				break;
+			if (len > IPACM_LOG_MAX_REC - pos - 2 - 1)
+				len = IPACM_LOG_MAX_REC - pos - 2 - 1;
+			rec[pos] = (uint8_t)(len & 0xff);
+			rec[pos + 1] = (uint8_t)(len >> 8);
+			memcpy(rec + pos + 2, str, len);
+			rec[pos + 2 + len] = '\0';
+			pos = IPACM_LOG_ALIGN(pos + 2 + len + 1);
+			if (pos > IPACM_LOG_MAX_REC)
+				pos = IPACM_LOG_MAX_REC;
+			continue;
+		}
+		if (spec.conv == 'n')
+		{
+			(void)va_arg(ap, void *);
+			continue;
+		}
+
+		if (pos + sizeof(val) > IPACM_LOG_MAX_REC)
+			break;
+		if (ipacm_log_is_signed(spec.conv))
+		{
+			switch (spec.length)
+			{
+			case IPACM_LOG_LEN_L: val.i = va_arg(ap, long); break;
+			case IPACM_LOG_LEN_LL: val.i = va_arg(ap, long long); break;
+			case IPACM_LOG_LEN_J: val.i = va_arg(ap, intmax_t); break;
+			case IPACM_LOG_LEN_Z: val.i = va_arg(ap, ssize_t); break;
+			case IPACM_LOG_LEN_T: val.i = va_arg(ap, ptrdiff_t); break;
+			default: val.i = va_arg(ap, int); break;
+			}
+		}
+		else if (ipacm_log_is_unsigned(spec.conv))
+		{
+			switch (spec.length)
+			{
+			case IPACM_LOG_LEN_L: val.u = va_arg(ap, unsigned long); break;
+			case IPACM_LOG_LEN_LL: val.u = va_arg(ap, unsigned long long); break;
+			case IPACM_LOG_LEN_J: val.u = va_arg(ap, uintmax_t); break;
+			case IPACM_LOG_LEN_Z: val.u = va_arg(ap, size_t); break;
+			case IPACM_LOG_LEN_T: val.u = va_arg(ap, ptrdiff_t); break;
+			default: val.u = va_arg(ap, unsigned int); break;
+			}
+		}
+		else if (spec.conv == 'c')
+		{
+			val.i = va_arg(ap, int);
+		}
+		else if (spec.conv == 'p')
+		{
+			val.p = va_arg(ap, void *);
+		}
+		else if (spec.length == IPACM_LOG_LEN_BIG_L)
+		{
+			val.d = (double)va_arg(ap, long double);
+		}
+		else
+		{
+			val.d = va_arg(ap, double);
+		}
+		memcpy(rec + pos, &val, sizeof(val));
+		pos += sizeof(val);
+	}
+	return pos;
+}
+
+static size_t ipacm_log_append(size_t size, size_t pos, int ret)
+{
+	if (ret < 0)
+		return pos;
+	pos += ret;
+	return (pos >= size) ? size - 1 : pos;
+}
+
+/* Formats the message in rec the way printf would have */
+static size_t ipacm_log_format(const ipacm_log_rec_t *hdr, char *buf, size_t size)
+{
+	const uint8_t *rec = (const uint8_t *)hdr;
+	uint32_t pos = IPACM_LOG_REC_HDR;
+	const char *p = hdr->fmt;
+	size_t out = 0;
+	ipacm_log_spec_t spec;
+	ipacm_log_val_t val, width, prec;
+	char sb[32];
+
+	buf[0] = '\0';
+	while (*p && out < size - 1)
+	{
+		const char *pct = strchr(p, '%');
+		size_t lit = (pct == NULL) ? strlen(p) : (size_t)(pct - p);
+
+		if (lit > size - 1 - out)
+			lit = size - 1 - out;
+		memcpy(buf + out, p, lit);
+		out += lit;
+		buf[out] = '\0';
+		if (pct == NULL)
+			break;
+
+		p = ipacm_log_parse_spec(pct, &spec);
+		if (spec.conv == '%')
+		{
+			out = ipacm_log_append(size, out, snprintf(buf + out, size - out, "%%"));
+			continue;
+		}
+		if (spec.conv == 0)
+			break;
+		if (spec.conv == 'n')
+			continue;
+		if (spec.len >= sizeof(sb))
+			break;
+		memcpy(sb, spec.start, spec.len);
+		sb[spec.len] = '\0';
+
+		width.i = prec.i = 0;
+		if (spec.star_width)
+		{
+			if (pos + sizeof(width) > hdr->size)
+				break;
+			memcpy(&width, rec + pos, sizeof(width));
+			pos += sizeof(width);
+		}
+		if (spec.star_prec)
+		{
+			if (pos + sizeof(prec) > hdr->size)
+				break;
+			memcpy(&prec, rec + pos, sizeof(prec));
+			pos += sizeof(prec);
+		}
+
+#define IPACM_LOG_PRINT(value) do { \
+		int ret; \
+		if (spec.star_width && spec.star_prec) \
+			ret = snprintf(buf + out, size - out, sb, (int)width.i, (int)prec.i, value); \
+		else if (spec.star_width) \
+			ret = snprintf(buf + out, size - out, sb, (int)width.i, value); \
+		else if (spec.star_prec) \
+			ret = snprintf(buf + out, size - out, sb, (int)prec.i, value); \
+		else \
+			ret = snprintf(buf + out, size - out, sb, value); \
+		out = ipacm_log_append(size, out, ret); \
+	} while (0)
+
+		if (spec.conv == 's')
+		{
+			if (pos + 3 > hdr->size)
+				break;
+			uint32_t len = rec[pos] | (rec[pos + 1] << 8);
+			IPACM_LOG_PRINT((const char *)(rec + pos + 2));
+			pos = IPACM_LOG_ALIGN(pos + 2 + len + 1);
+			continue;
+		}
+
+		if (pos + sizeof(val) > hdr->size)
+			break;
+		memcpy(&val, rec + pos, sizeof(val));
+		pos += sizeof(val);
+
+		if (ipacm_log_is_signed(spec.conv))
+		{
+			switch (spec.length)
+			{
+			case IPACM_LOG_LEN_L: IPACM_LOG_PRINT((long)val.i); break;
+			case IPACM_LOG_LEN_LL: IPACM_LOG_PRINT((long long)val.i); break;
+			case IPACM_LOG_LEN_J: IPACM_LOG_PRINT((intmax_t)val.i); break;
+			case IPACM_LOG_LEN_Z: IPACM_LOG_PRINT((ssize_t)val.i); break;
+			case IPACM_LOG_LEN_T: IPACM_LOG_PRINT((ptrdiff_t)val.i); break;
+			default: IPACM_LOG_PRINT((int)val.i); break;
+			}
+		}
+		else if (ipacm_log_is_unsigned(spec.conv))
+		{
+			switch (spec.length)
+			{
+			case IPACM_LOG_LEN_L: IPACM_LOG_PRINT((unsigned long)val.u); break;
+			case IPACM_LOG_LEN_LL: IPACM_LOG_PRINT((unsigned long long)val.u); break;
+			case IPACM_LOG_LEN_J: IPACM_LOG_PRINT((uintmax_t)val.u); break;
+			case IPACM_LOG_LEN_Z: IPACM_LOG_PRINT((size_t)val.u); break;
+			case IPACM_LOG_LEN_T: IPACM_LOG_PRINT((ptrdiff_t)val.u); break;
+			default: IPACM_LOG_PRINT((unsigned int)val.u); break;
+			}
+		}
+		else if (spec.conv == 'c')
+		{
+			IPACM_LOG_PRINT((int)val.i);
+		}
+		else if (spec.conv == 'p')
+		{
+			IPACM_LOG_PRINT(val.p);
+		}
+		else if (spec.length == IPACM_LOG_LEN_BIG_L)
+		{
+			IPACM_LOG_PRINT((long double)val.d);
+		}
+		else
+		{
+			IPACM_LOG_PRINT(val.d);
+		}
+#undef IPACM_LOG_PRINT
+	}
+	return out;
+}
+
+/* Formats a message and sends it to its destinations */
+static void ipacm_log_emit(const ipacm_log_rec_t *hdr)
+{
+	char line[IPACM_LOG_LINE_LEN];
+	size_t len = 0;
+
+	if (hdr->flags & IPACM_LOG_ERROR)
+	{
+#ifdef DEBUG
+		len = ipacm_log_append(sizeof(line), len,
+				snprintf(line, sizeof(line), "ERROR: "));
+#else
+		len = ipacm_log_append(sizeof(line), len,
+				snprintf(line, sizeof(line), "ERR: "));
+#endif
+	}
+	if (hdr->flags & IPACM_LOG_PREFIX)
+	{
+		len = ipacm_log_append(sizeof(line), len,
+				snprintf(line + len, sizeof(line) - len, "%s:%d %s() ",
+						hdr->file, hdr->line, hdr->func));
+	}
+	size_t body = len;
+	len += ipacm_log_format(hdr, line + len, sizeof(line) - len);
+
+	if (hdr->flags & IPACM_LOG_STDOUT)
+		fputs(line, stdout);
+	if (hdr->flags & IPACM_LOG_STDERR)
+		fputs(line + body, stderr);
+	if (hdr->flags & IPACM_LOG_SOCKET)
+	{
+		char buffer_send[MAX_BUF_LEN];
+
+		memset(buffer_send, 0, sizeof(buffer_send));
+		strlcpy(buffer_send, line, sizeof(buffer_send));
+		ipacm_log_send(buffer_send);
+	}
+	if (hdr->flags & IPACM_LOG_KMSG)
+	{
+		if (ipacm_log_kmsg_fd < 0)
+			ipacm_log_kmsg_fd = open("/dev/kmsg", O_WRONLY | O_CLOEXEC);
+		if (ipacm_log_kmsg_fd >= 0 && write(ipacm_log_kmsg_fd, line, len) < 0)
+		{
+			close(ipacm_log_kmsg_fd);
+			ipacm_log_kmsg_fd = -1;
+		}
+	}
+}
+
+static void ipacm_log_ring_release(void *data)
+{
+	ipacm_log_ring_t *ring = (ipacm_log_ring_t *)data;
+
+	__atomic_store_n(&ring->orphan, 1, __ATOMIC_RELEASE);
+}
+
+static void ipacm_log_make_key(void)
+{
+	if (pthread_key_create(&ipacm_log_key, ipacm_log_ring_release) != 0)
+	{
+		printf("unable to create ipacm log key\n");
+		return;
+	}
+}
+
+/* Ring of the calling thread, created on its first message */
+static ipacm_log_ring_t *ipacm_log_get_ring(void)
+{
+	ipacm_log_ring_t *ring;
+
+	pthread_once(&ipacm_log_key_once, ipacm_log_make_key);
+	ring = (ipacm_log_ring_t *)pthread_getspecific(ipacm_log_key);
+	if (ring != NULL)
+		return ring;
+
+	ring = (ipacm_log_ring_t *)calloc(1, sizeof(*ring));
+	if (ring == NULL)
+		return NULL;
+	ring->tid = (pid_t)syscall(SYS_gettid);
+	if (pthread_setspecific(ipacm_log_key, ring) != 0)
+	{
+		free(ring);
+		return NULL;
+	}
+	pthread_mutex_lock(&ipacm_log_lock);
+	ring->next = ipacm_log_rings;
+	__atomic_store_n(&ipacm_log_rings, ring, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&ipacm_log_lock);
+	return ring;
+}
+
+/* Copies a record into the ring of the calling thread */
+static int ipacm_log_push(const ipacm_log_rec_t *hdr)
+{
+	ipacm_log_ring_t *ring = ipacm_log_get_ring();
+	uint32_t head, tail, pos, pad;
+	int state;
+
+	if (ring == NULL || ring->busy)
+		return IPACM_FAILURE;
+	ring->busy = 1;
+	__atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+	head = ring->head;
+	tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	pos = head & (IPACM_LOG_RING_SIZE - 1);
+	pad = (pos + hdr->size > IPACM_LOG_RING_SIZE) ? IPACM_LOG_RING_SIZE - pos : 0;
+	if (IPACM_LOG_RING_SIZE - (head - tail) < pad + hdr->size)
+	{
+		__atomic_signal_fence(__ATOMIC_SEQ_CST);
+		ring->busy = 0;
+		return IPACM_FAILURE;
+	}
+	if (pad)
+	{
+		ipacm_log_rec_t *filler = (ipacm_log_rec_t *)(ring->data + pos);
+
+		filler->size = (uint16_t)pad;
+		filler->flags = IPACM_LOG_PAD;
+		pos = 0;
+	}
+	memcpy(ring->data + pos, hdr, hdr->size);
+	head += pad + hdr->size;
+	__atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+
+	__atomic_signal_fence(__ATOMIC_SEQ_CST);
+	ring->busy = 0;
+
+	/* Pairs with the fence of the log thread before it goes to sleep */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	state = __atomic_load_n(&ipacm_log_state, __ATOMIC_RELAXED);
+	if (state == IPACM_LOG_ASLEEP || (state == IPACM_LOG_DOZING &&
+			((hdr->flags & IPACM_LOG_KEEP) || head - tail >= IPACM_LOG_BATCH)))
+	{
+		pthread_mutex_lock(&ipacm_log_lock);
+		pthread_cond_signal(&ipacm_log_wake);
+		pthread_mutex_unlock(&ipacm_log_lock);
+	}
+	return IPACM_SUCCESS;
+}
+
+void ipacm_log_write(int flags, const char *file, int line,
+		const char *func, const char *fmt, ...)
+{
+	uint64_t rec[IPACM_LOG_MAX_REC / sizeof(uint64_t)];
+	ipacm_log_rec_t *hdr = (ipacm_log_rec_t *)rec;
+	struct timespec ts;
+	uint32_t size;
+	va_list ap;
+	int saved_errno = errno;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	hdr->flags = (uint8_t)flags;
+	hdr->reserved = 0;
+	hdr->line = line;
+	hdr->ts = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	hdr->file = file;
+	hdr->func = func;
+	hdr->fmt = fmt;
+
+	va_start(ap, fmt);
+	size = ipacm_log_capture((uint8_t *)rec, IPACM_LOG_REC_HDR, fmt, ap);
+	va_end(ap);
+	hdr->size = (uint16_t)IPACM_LOG_ALIGN(size);
+
+	if (!__atomic_load_n(&ipacm_log_async, __ATOMIC_ACQUIRE) ||
+			ipacm_log_push(hdr) != IPACM_SUCCESS)
+	{
+		/* Keep errors and high priority messages, drop debug ones */
+		if ((flags & IPACM_LOG_KEEP) ||
+				!__atomic_load_n(&ipacm_log_async, __ATOMIC_ACQUIRE))
+		{
+			ipacm_log_emit(hdr);
+		}
+		else
+		{
+			ipacm_log_ring_t *ring = ipacm_log_get_ring();
+
+			if (ring != NULL)
+				__atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+		}
+	}
+	errno = saved_errno;
+}
+
+/* Oldest message over all rings, NULL if they are empty. Frees the rings
+   of exited threads once drained */
+static ipacm_log_rec_t *ipacm_log_oldest(ipacm_log_ring_t **owner)
+{
+	ipacm_log_ring_t *ring, *next;
+	ipacm_log_rec_t *oldest = NULL;
+
+	for (ring = __atomic_load_n(&ipacm_log_rings, __ATOMIC_ACQUIRE); ring != NULL; ring = next)
+	{
+		uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		uint32_t dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+
+		next = ring->next;
+		if (dropped != ring->reported)
+		{
+			printf("ipacm log: dropped %u messages of thread %d\n",
+					dropped - ring->reported, (int)ring->tid);
+			ring->reported = dropped;
+		}
+
+		while (ring->tail != head)
+		{
+			ipacm_log_rec_t *hdr = (ipacm_log_rec_t *)
+					(ring->data + (ring->tail & (IPACM_LOG_RING_SIZE - 1)));
+
+			if (!(hdr->flags & IPACM_LOG_PAD))
+			{
+				if (oldest == NULL || hdr->ts < oldest->ts)
+				{
+					oldest = hdr;
+					*owner = ring;
+				}
+				break;
+			}
+			__atomic_store_n(&ring->tail, ring->tail + hdr->size, __ATOMIC_RELEASE);
+		}
+
+		if (ring->tail == head && __atomic_load_n(&ring->orphan, __ATOMIC_ACQUIRE) &&
+				head == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE))
+		{
+			ipacm_log_ring_t **link;
+
+			pthread_mutex_lock(&ipacm_log_lock);
+			for (link = &ipacm_log_rings; *link != ring; link = &(*link)->next)
+				;
+			*link = ring->next;
+			pthread_mutex_unlock(&ipacm_log_lock);
+			free(ring);
+		}
+	}
+	return oldest;
+}
+
+static int ipacm_log_pending(void)
+{
+	ipacm_log_ring_t *ring;
+
+	for (ring = __atomic_load_n(&ipacm_log_rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next)
+	{
+		if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) != ring->tail)
+			return 1;
+	}
+	return 0;
+}
+
+static void *ipacm_log_thread(void *arg)
+{
+	struct timespec ts;
+	(void)arg;
+
+	while (1)
+	{
+		uint32_t req = __atomic_load_n(&ipacm_log_flush_req, __ATOMIC_ACQUIRE);
+		ipacm_log_ring_t *owner = NULL;
+		ipacm_log_rec_t *hdr;
+		int state = IPACM_LOG_ASLEEP;
+
+		while ((hdr = ipacm_log_oldest(&owner)) != NULL)
+		{
+			ipacm_log_emit(hdr);
+			__atomic_store_n(&owner->tail, owner->tail + hdr->size, __ATOMIC_RELEASE);
+			state = IPACM_LOG_DOZING;
+		}
+		fflush(stdout);
+
+		pthread_mutex_lock(&ipacm_log_lock);
+		if (req != ipacm_log_flush_done)
+		{
+			ipacm_log_flush_done = req;
+			pthread_cond_broadcast(&ipacm_log_flushed);
+		}
+		__atomic_store_n(&ipacm_log_state, state, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (ipacm_log_flush_req == ipacm_log_flush_done &&
+				(state == IPACM_LOG_DOZING || !ipacm_log_pending()))
+		{
+			clock_gettime(CLOCK_REALTIME, &ts);
+			if (state == IPACM_LOG_DOZING)
+			{
+				ts.tv_nsec += IPACM_LOG_DOZE_MS * 1000000L;
+				if (ts.tv_nsec >= 1000000000L)
+				{
+					ts.tv_sec++;
+					ts.tv_nsec -= 1000000000L;
+				}
+			}
+			else
+			{
+				ts.tv_sec += 1;
+			}
+			pthread_cond_timedwait(&ipacm_log_wake, &ipacm_log_lock, &ts);
+		}
+		__atomic_store_n(&ipacm_log_state, IPACM_LOG_AWAKE, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&ipacm_log_lock);
+	}
+	return NULL;
+}
+
+/* Waits until the messages written so far are out, for up to a second */
+void ipacm_log_flush(void)
+{
+	struct timespec ts;
+	uint32_t req;
+
+	if (!__atomic_load_n(&ipacm_log_async, __ATOMIC_ACQUIRE))
+	{
+		fflush(stdout);
+		return;
+	}
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += 1;
+	pthread_mutex_lock(&ipacm_log_lock);
+	req = __atomic_add_fetch(&ipacm_log_flush_req, 1, __ATOMIC_RELEASE);
+	pthread_cond_signal(&ipacm_log_wake);
+	while ((int32_t)(ipacm_log_flush_done - req) < 0)
+	{
+		if (pthread_cond_timedwait(&ipacm_log_flushed, &ipacm_log_lock, &ts) != 0)
+			break;
+	}
+	pthread_mutex_unlock(&ipacm_log_lock);
+}
+
+void ipacm_log_set_level(int level)
+{
+	__atomic_store_n(&ipacm_log_level, level, __ATOMIC_RELAXED);
+}
+
+/* Reads the log level and starts the log thread */
+int ipacm_log_init(void)
+{
+	pthread_t thread;
+	const char *level = getenv("IPACM_LOG_LEVEL");
+#ifdef FEATURE_IPA_ANDROID
+	char prop[PROPERTY_VALUE_MAX];
+
+	if (property_get(IPACM_LOG_LEVEL_PROP, prop, NULL) > 0)
+		level = prop;
+#endif
+	if (level != NULL)
+		ipacm_log_set_level(atoi(level));
+
+	if (__atomic_load_n(&ipacm_log_async, __ATOMIC_ACQUIRE))
+		return IPACM_SUCCESS;
+	if (pthread_create(&thread, NULL, ipacm_log_thread, NULL) != 0)
+	{
+		printf("unable to create ipacm log thread, logging synchronously\n");
+		return IPACM_FAILURE;
+	}
+	if (pthread_setname_np(thread, "ipacm log") != 0)
+	{
+		printf("unable to set thread name\n");
+	}
+	pthread_detach(thread);
+	__atomic_store_n(&ipacm_log_async, 1, __ATOMIC_RELEASE);
+	atexit(ipacm_log_flush);
+	return IPACM_SUCCESS;
+}
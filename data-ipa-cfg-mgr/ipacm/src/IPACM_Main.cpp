@@ -67,6 +67,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_ConntrackListener.h"
 #include "IPACM_ConntrackClient.h"
 #include "IPACM_Netlink.h"
+#include "IPACM_IfaceRegistry.h"
 
 #ifdef FEATURE_IPACM_HAL
 #include "IPACM_OffloadManager.h"
@@ -841,6 +842,9 @@ int main(int argc, char **argv)
 	/* check if ipacm is already running or not */
 	ipa_is_ipacm_running();
 
+	/* move log formatting and output off the event threads */
+	ipacm_log_init();
+
 	IPACMDBG_H("In main()\n");
 	(void)argc;
 	(void)argv;
@@ -1024,28 +1028,12 @@ int ipa_get_if_index
 	 int *if_index
 	 )
 {
-	int fd;
-	struct ifreq ifr;
-
-	if ((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
-	{
-		PERROR("get interface index socket create failed");
-		return IPACM_FAILURE;
-	}
-
-	memset(&ifr, 0, sizeof(struct ifreq));
-
-	(void)strlcpy(ifr.ifr_name, if_name, sizeof(ifr.ifr_name));
-
-	if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0)
+	if (IPACM_IfaceRegistry::GetIfIndex(if_name, if_index) != IPACM_SUCCESS)
 	{
-		IPACMERR("call_ioctl_on_dev: ioctl failed: can't find device %s",if_name);
+		IPACMERR("can't find device %s\n", if_name);
 		*if_index = -1;
-		close(fd);
 		return IPACM_FAILURE;
 	}
 
-	*if_index = ifr.ifr_ifindex;
-	close(fd);
 	return IPACM_SUCCESS;
 }
@@ -49,13 +49,29 @@ IPACM_Neighbor::IPACM_Neighbor()
 {
 	num_neighbor_client = 0;
 	circular_index = 0;
-	memset(neighbor_client, 0, IPA_MAX_NUM_NEIGHBOR_CLIENTS * sizeof(ipa_neighbor_client));
+	max_neighbor_client = IPACM_Iface::ipacmcfg->GetMaxNeighborClients();
+	neighbor_client = (ipa_neighbor_client *)calloc(max_neighbor_client, sizeof(ipa_neighbor_client));
+	if (neighbor_client == NULL ||
+			neighbor_index.Init(max_neighbor_client, IPA_MAC_ADDR_SIZE) != 0)
+	{
+		IPACMERR("unable to allocate memory for %d neighbor clients\n", max_neighbor_client);
+		free(neighbor_client);
+		neighbor_client = NULL;
+		max_neighbor_client = 0;
+		/* no room to track neighbors, leave their events unhandled */
+		return;
+	}
 	IPACM_EvtDispatcher::registr(IPA_WLAN_CLIENT_ADD_EVENT_EX, this);
 	IPACM_EvtDispatcher::registr(IPA_NEW_NEIGH_EVENT, this);
 	IPACM_EvtDispatcher::registr(IPA_DEL_NEIGH_EVENT, this);
 	return;
 }
 
+IPACM_Neighbor::~IPACM_Neighbor()
+{
+	free(neighbor_client);
+}
+
 void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 {
 	ipacm_event_data_all *data_all = NULL;
@@ -96,61 +112,57 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 				}
 			}
 
-			for (i = 0; i < num_neighbor_client_temp; i++)
+			i = get_neighbor_index(client_mac_addr);
+			if (i >= 0)
 			{
-				/* find the client */
-				if (memcmp(neighbor_client[i].mac_addr, client_mac_addr, sizeof(neighbor_client[i].mac_addr)) == 0)
+				/* check if iface is not bridge interface*/
+				if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name) != 0)
 				{
-					/* check if iface is not bridge interface*/
-					if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name) != 0)
+					/* use previous ipv4 first */
+					if(data->if_index != neighbor_client[i].iface_index)
 					{
-						/* use previous ipv4 first */
-						if(data->if_index != neighbor_client[i].iface_index)
-						{
-							IPACMERR("update new kernel iface index \n");
-							neighbor_client[i].iface_index = data->if_index;
-						}
+						IPACMERR("update new kernel iface index \n");
+						neighbor_client[i].iface_index = data->if_index;
+					}
+
+					/* check if client associated with previous network interface */
+					if(ipa_interface_index != neighbor_client[i].ipa_if_num)
+					{
+						IPACMERR("client associate to different AP \n");
+						return;
+					}
 
-						/* check if client associated with previous network interface */
-						if(ipa_interface_index != neighbor_client[i].ipa_if_num)
+					if (neighbor_client[i].v4_addr != 0) /* not 0.0.0.0 */
+					{
+						evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
+						data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
+						if (data_all == NULL)
 						{
-							IPACMERR("client associate to different AP \n");
+							IPACMERR("Unable to allocate memory\n");
 							return;
 						}
-
-						if (neighbor_client[i].v4_addr != 0) /* not 0.0.0.0 */
-						{
-							evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
-							data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
-							if (data_all == NULL)
-							{
-								IPACMERR("Unable to allocate memory\n");
-								return;
-							}
-							memset(data_all,0,sizeof(ipacm_event_data_all));
-							data_all->iptype = IPA_IP_v4;
-							data_all->if_index = neighbor_client[i].iface_index;
-							data_all->ipv4_addr = neighbor_client[i].v4_addr; //use previous ipv4 address
-							memcpy(data_all->mac_addr,
-									neighbor_client[i].mac_addr,
-												sizeof(data_all->mac_addr));
-							memcpy(data_all->iface_name, neighbor_client[i].iface_name,
-								sizeof(data_all->iface_name));
-							evt_data.evt_data = (void *)data_all;
-							IPACM_EvtDispatcher::PostEvt(&evt_data);
-							/* ask for replaced iface name*/
-							ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
-							/* check for failure return */
-							if (IPACM_FAILURE == ipa_interface_index) {
-								IPACMERR("not supported iface id: %d\n", data_all->if_index);
-							} else {
-								IPACMDBG_H("Posted event %d, with %s for ipv4 client re-connect\n",
-									evt_data.event,
-									data_all->iface_name);
-							}
+						memset(data_all,0,sizeof(ipacm_event_data_all));
+						data_all->iptype = IPA_IP_v4;
+						data_all->if_index = neighbor_client[i].iface_index;
+						data_all->ipv4_addr = neighbor_client[i].v4_addr; //use previous ipv4 address
+						memcpy(data_all->mac_addr,
+								neighbor_client[i].mac_addr,
+											sizeof(data_all->mac_addr));
+						memcpy(data_all->iface_name, neighbor_client[i].iface_name,
+							sizeof(data_all->iface_name));
+						evt_data.evt_data = (void *)data_all;
+						IPACM_EvtDispatcher::PostEvt(&evt_data);
+						/* ask for replaced iface name*/
+						ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
+						/* check for failure return */
+						if (IPACM_FAILURE == ipa_interface_index) {
+							IPACMERR("not supported iface id: %d\n", data_all->if_index);
+						} else {
+							IPACMDBG_H("Posted event %d, with %s for ipv4 client re-connect\n",
+								evt_data.event,
+								data_all->iface_name);
 						}
 					}
-					break;
 				}
 			}
 		}
@@ -191,41 +203,38 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 					if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, data->iface_name) == 0)
 					{
 						/* searh if seen this client or not*/
-						for (i = 0; i < num_neighbor_client_temp; i++)
+						i = get_neighbor_index(data->mac_addr);
+						if (i >= 0)
 						{
-							if (memcmp(neighbor_client[i].mac_addr, data->mac_addr, sizeof(neighbor_client[i].mac_addr)) == 0)
+							data->if_index = neighbor_client[i].iface_index;
+							strlcpy(data->iface_name, neighbor_client[i].iface_name, sizeof(data->iface_name));
+							neighbor_client[i].v4_addr = data->ipv4_addr; // cache client's previous ipv4 address
+							/* construct IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT command and insert to command-queue */
+							if (event == IPA_NEW_NEIGH_EVENT)
+								evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
+							else
+								/* not to clean-up the client mac cache on bridge0 delneigh */
+								evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
+							data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
+							if (data_all == NULL)
 							{
-								data->if_index = neighbor_client[i].iface_index;
-								strlcpy(data->iface_name, neighbor_client[i].iface_name, sizeof(data->iface_name));
-								neighbor_client[i].v4_addr = data->ipv4_addr; // cache client's previous ipv4 address
-								/* construct IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT command and insert to command-queue */
-								if (event == IPA_NEW_NEIGH_EVENT)
-									evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
-								else
-									/* not to clean-up the client mac cache on bridge0 delneigh */
-									evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
-								data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
-								if (data_all == NULL)
-								{
-									IPACMERR("Unable to allocate memory\n");
-									return;
-								}
-								memcpy(data_all, data, sizeof(ipacm_event_data_all));
-								evt_data.evt_data = (void *)data_all;
-								IPACM_EvtDispatcher::PostEvt(&evt_data);
+								IPACMERR("Unable to allocate memory\n");
+								return;
+							}
+							memcpy(data_all, data, sizeof(ipacm_event_data_all));
+							evt_data.evt_data = (void *)data_all;
+							IPACM_EvtDispatcher::PostEvt(&evt_data);
 
-								/* ask for replaced iface name*/
-								ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
-								/* check for failure return */
-								if (IPACM_FAILURE == ipa_interface_index) {
-									IPACMERR("not supported iface id: %d\n", data_all->if_index);
-								} else {
-									IPACMDBG_H("Posted event %d,\
-										with %s for ipv4\n",
-										evt_data.event,
-										data->iface_name);
-								}
-								break;
+							/* ask for replaced iface name*/
+							ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
+							/* check for failure return */
+							if (IPACM_FAILURE == ipa_interface_index) {
+								IPACMERR("not supported iface id: %d\n", data_all->if_index);
+							} else {
+								IPACMDBG_H("Posted event %d,\
+									with %s for ipv4\n",
+									evt_data.event,
+									data->iface_name);
 							}
 						}
 					}
@@ -237,25 +246,21 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 							evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
 							/* Also save to cache for ipv4 */
 							/*searh if seen this client or not*/
-							for (i = 0; i < num_neighbor_client_temp; i++)
+							i = get_neighbor_index(data->mac_addr);
+							if (i >= 0)
 							{
-								/* find the client */
-								if (memcmp(neighbor_client[i].mac_addr, data->mac_addr, sizeof(neighbor_client[i].mac_addr)) == 0)
-								{
-									/* update the network interface client associated */
-									neighbor_client[i].iface_index = data->if_index;
-									neighbor_client[i].ipa_if_num = ipa_interface_index;
-									neighbor_client[i].v4_addr = data->ipv4_addr; // cache client's previous ipv4 address
-									strlcpy(neighbor_client[i].iface_name, data->iface_name, sizeof(neighbor_client[i].iface_name));
-									IPACMDBG_H("update cache %d-entry, with %s iface, ipv4 address: 0x%x\n",
-										i, data->iface_name, data->ipv4_addr);
-									break;
-								}
+								/* update the network interface client associated */
+								neighbor_client[i].iface_index = data->if_index;
+								neighbor_client[i].ipa_if_num = ipa_interface_index;
+								neighbor_client[i].v4_addr = data->ipv4_addr; // cache client's previous ipv4 address
+								strlcpy(neighbor_client[i].iface_name, data->iface_name, sizeof(neighbor_client[i].iface_name));
+								IPACMDBG_H("update cache %d-entry, with %s iface, ipv4 address: 0x%x\n",
+									i, data->iface_name, data->ipv4_addr);
 							}
 							/* not find client */
-							if (i == num_neighbor_client_temp)
+							if (i < 0)
 							{
-								if (num_neighbor_client_temp < IPA_MAX_NUM_NEIGHBOR_CLIENTS)
+								if (num_neighbor_client_temp < max_neighbor_client)
 								{
 									memcpy(neighbor_client[num_neighbor_client_temp].mac_addr,
 												data->mac_addr,
@@ -266,6 +271,7 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 									neighbor_client[num_neighbor_client_temp].v4_addr = data->ipv4_addr;
 									strlcpy(neighbor_client[num_neighbor_client_temp].iface_name,
 										data->iface_name, sizeof(neighbor_client[num_neighbor_client_temp].iface_name));
+									neighbor_index.Insert(neighbor_client[num_neighbor_client_temp].mac_addr, num_neighbor_client_temp);
 									num_neighbor_client++;
 									IPACMDBG_H("Cache client MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d\n",
 												neighbor_client[num_neighbor_client_temp].mac_addr[0],
@@ -280,6 +286,7 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 								{
 
 									IPACMERR("error:  neighbor client oversize! recycle %d-st entry ! \n", circular_index);
+									neighbor_index.Remove(neighbor_client[circular_index].mac_addr);
 									memcpy(neighbor_client[circular_index].mac_addr,
 												data->mac_addr,
 												sizeof(data->mac_addr));
@@ -298,7 +305,8 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 													neighbor_client[circular_index].mac_addr[5],
 													num_neighbor_client,
 													circular_index);
-									circular_index = (circular_index + 1) % IPA_MAX_NUM_NEIGHBOR_CLIENTS;
+									neighbor_index.Insert(neighbor_client[circular_index].mac_addr, circular_index);
+									circular_index = (circular_index + 1) % max_neighbor_client;
 								}
 							}
 						}
@@ -306,41 +314,39 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 						{
 							evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
 							/*searh if seen this client or not*/
-							for (i = 0; i < num_neighbor_client_temp; i++)
+							i = get_neighbor_index(data->mac_addr);
+							if (i >= 0)
 							{
-								/* find the client */
-								if (memcmp(neighbor_client[i].mac_addr, data->mac_addr, sizeof(neighbor_client[i].mac_addr)) == 0)
-								{
-									IPACMDBG_H("Clean %d-st Cached client-MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d\n",
-												i,
-												neighbor_client[i].mac_addr[0],
-												neighbor_client[i].mac_addr[1],
-												neighbor_client[i].mac_addr[2],
-												neighbor_client[i].mac_addr[3],
-												neighbor_client[i].mac_addr[4],
-												neighbor_client[i].mac_addr[5],
-												num_neighbor_client);
+								IPACMDBG_H("Clean %d-st Cached client-MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d\n",
+											i,
+											neighbor_client[i].mac_addr[0],
+											neighbor_client[i].mac_addr[1],
+											neighbor_client[i].mac_addr[2],
+											neighbor_client[i].mac_addr[3],
+											neighbor_client[i].mac_addr[4],
+											neighbor_client[i].mac_addr[5],
+											num_neighbor_client);
 
-									memset(neighbor_client[i].mac_addr, 0, sizeof(neighbor_client[i].mac_addr));
-									neighbor_client[i].iface_index = 0;
-									neighbor_client[i].v4_addr = 0;
-									neighbor_client[i].ipa_if_num = 0;
-									memset(neighbor_client[i].iface_name, 0, sizeof(neighbor_client[i].iface_name));
-									for (; i < num_neighbor_client_temp - 1; i++)
-									{
-										memcpy(neighbor_client[i].mac_addr,
-													neighbor_client[i+1].mac_addr,
-													sizeof(neighbor_client[i].mac_addr));
-										neighbor_client[i].iface_index = neighbor_client[i+1].iface_index;
-										neighbor_client[i].v4_addr = neighbor_client[i+1].v4_addr;
-										neighbor_client[i].ipa_if_num = neighbor_client[i+1].ipa_if_num;
-										strlcpy(neighbor_client[i].iface_name, neighbor_client[i+1].iface_name,
-											sizeof(neighbor_client[i].iface_name));
-									}
-									num_neighbor_client--;
-									IPACMDBG_H(" total number of left cased clients: %d\n", num_neighbor_client);
-									break;
+								neighbor_index.Remove(neighbor_client[i].mac_addr);
+								memset(neighbor_client[i].mac_addr, 0, sizeof(neighbor_client[i].mac_addr));
+								neighbor_client[i].iface_index = 0;
+								neighbor_client[i].v4_addr = 0;
+								neighbor_client[i].ipa_if_num = 0;
+								memset(neighbor_client[i].iface_name, 0, sizeof(neighbor_client[i].iface_name));
+								for (; i < num_neighbor_client_temp - 1; i++)
+								{
+									memcpy(neighbor_client[i].mac_addr,
+												neighbor_client[i+1].mac_addr,
+												sizeof(neighbor_client[i].mac_addr));
+									neighbor_index.Move(neighbor_client[i].mac_addr, i + 1, i);
+									neighbor_client[i].iface_index = neighbor_client[i+1].iface_index;
+									neighbor_client[i].v4_addr = neighbor_client[i+1].v4_addr;
+									neighbor_client[i].ipa_if_num = neighbor_client[i+1].ipa_if_num;
+									strlcpy(neighbor_client[i].iface_name, neighbor_client[i+1].iface_name,
+										sizeof(neighbor_client[i].iface_name));
 								}
+								num_neighbor_client--;
+								IPACMDBG_H(" total number of left cased clients: %d\n", num_neighbor_client);
 							}
 							/* not find client, no need clean-up */
 						}
@@ -369,37 +375,34 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 					if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, data->iface_name) == 0)
 					{
 						/* searh if seen this client or not*/
-						for (i = 0; i < num_neighbor_client_temp; i++)
+						i = get_neighbor_index(data->mac_addr);
+						if (i >= 0)
 						{
-							if (memcmp(neighbor_client[i].mac_addr, data->mac_addr, sizeof(neighbor_client[i].mac_addr)) == 0)
+							data->if_index = neighbor_client[i].iface_index;
+							strlcpy(data->iface_name, neighbor_client[i].iface_name, sizeof(data->iface_name));
+							/* construct IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT command and insert to command-queue */
+							if (event == IPA_NEW_NEIGH_EVENT) evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
+							else evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
+							data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
+							if (data_all == NULL)
 							{
-								data->if_index = neighbor_client[i].iface_index;
-								strlcpy(data->iface_name, neighbor_client[i].iface_name, sizeof(data->iface_name));
-								/* construct IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT command and insert to command-queue */
-								if (event == IPA_NEW_NEIGH_EVENT) evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
-								else evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
-								data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
-								if (data_all == NULL)
-								{
-									IPACMERR("Unable to allocate memory\n");
-									return;
-								}
-								memcpy(data_all, data, sizeof(ipacm_event_data_all));
-								evt_data.evt_data = (void *)data_all;
-								IPACM_EvtDispatcher::PostEvt(&evt_data);
-								/* ask for replaced iface name*/
-								ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
-								/* check for failure return */
-								if (IPACM_FAILURE == ipa_interface_index) {
-									IPACMERR("not supported iface id: %d\n", data_all->if_index);
-								} else {
-									IPACMDBG_H("Posted event %d,\
-										with %s for ipv6\n",
-										evt_data.event,
-										data->iface_name);
-								}
-								break;
-							};
+								IPACMERR("Unable to allocate memory\n");
+								return;
+							}
+							memcpy(data_all, data, sizeof(ipacm_event_data_all));
+							evt_data.evt_data = (void *)data_all;
+							IPACM_EvtDispatcher::PostEvt(&evt_data);
+							/* ask for replaced iface name*/
+							ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
+							/* check for failure return */
+							if (IPACM_FAILURE == ipa_interface_index) {
+								IPACMERR("not supported iface id: %d\n", data_all->if_index);
+							} else {
+								IPACMDBG_H("Posted event %d,\
+									with %s for ipv6\n",
+									evt_data.event,
+									data->iface_name);
+							}
 						}
 					}
 					else
@@ -426,104 +429,102 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 				{
 					IPACMDBG(" Got Neighbor event with no ipv6/ipv4 address \n");
 					/*no ipv6 in data searh if seen this client or not*/
-					for (i = 0; i < num_neighbor_client_temp; i++)
+					i = get_neighbor_index(data->mac_addr);
+					if (i >= 0)
 					{
-						/* find the client */
-						if (memcmp(neighbor_client[i].mac_addr, data->mac_addr, sizeof(neighbor_client[i].mac_addr)) == 0)
+						IPACMDBG_H(" find %d-st client, MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d\n",
+											i,
+											neighbor_client[i].mac_addr[0],
+											neighbor_client[i].mac_addr[1],
+											neighbor_client[i].mac_addr[2],
+											neighbor_client[i].mac_addr[3],
+											neighbor_client[i].mac_addr[4],
+											neighbor_client[i].mac_addr[5],
+											num_neighbor_client);
+						/* check if iface is not bridge interface*/
+						if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, data->iface_name) != 0)
 						{
-							IPACMDBG_H(" find %d-st client, MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d\n",
-												i,
-												neighbor_client[i].mac_addr[0],
-												neighbor_client[i].mac_addr[1],
-												neighbor_client[i].mac_addr[2],
-												neighbor_client[i].mac_addr[3],
-												neighbor_client[i].mac_addr[4],
-												neighbor_client[i].mac_addr[5],
-												num_neighbor_client);
-							/* check if iface is not bridge interface*/
-							if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, data->iface_name) != 0)
+							/* use previous ipv4 first */
+							if(data->if_index != neighbor_client[i].iface_index)
 							{
-								/* use previous ipv4 first */
-								if(data->if_index != neighbor_client[i].iface_index)
-								{
-									IPACMDBG_H("update new kernel iface index \n");
-									neighbor_client[i].iface_index = data->if_index;
-									strlcpy(neighbor_client[i].iface_name, data->iface_name, sizeof(neighbor_client[i].iface_name));
-								}
+								IPACMDBG_H("update new kernel iface index \n");
+								neighbor_client[i].iface_index = data->if_index;
+								strlcpy(neighbor_client[i].iface_name, data->iface_name, sizeof(neighbor_client[i].iface_name));
+							}
 
-								/* check if client associated with previous network interface */
-								if(ipa_interface_index != neighbor_client[i].ipa_if_num)
-								{
-									IPACMDBG_H("client associate to different AP \n");
-								}
+							/* check if client associated with previous network interface */
+							if(ipa_interface_index != neighbor_client[i].ipa_if_num)
+							{
+								IPACMDBG_H("client associate to different AP \n");
+							}
 
-								if (neighbor_client[i].v4_addr != 0) /* not 0.0.0.0 */
+							if (neighbor_client[i].v4_addr != 0) /* not 0.0.0.0 */
+							{
+								/* construct IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT command and insert to command-queue */
+								if (event == IPA_NEW_NEIGH_EVENT)
+									evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
+								else
+									evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
+								data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
+								if (data_all == NULL)
 								{
-									/* construct IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT command and insert to command-queue */
-									if (event == IPA_NEW_NEIGH_EVENT)
-										evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
-									else
-										evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
-									data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
-									if (data_all == NULL)
-									{
-										IPACMERR("Unable to allocate memory\n");
-										return;
-									}
-									data_all->iptype = IPA_IP_v4;
-									data_all->if_index = neighbor_client[i].iface_index;
-									data_all->ipv4_addr = neighbor_client[i].v4_addr; //use previous ipv4 address
-									memcpy(data_all->mac_addr, neighbor_client[i].mac_addr,
-										sizeof(data_all->mac_addr));
-									strlcpy(data_all->iface_name, neighbor_client[i].iface_name, sizeof(data_all->iface_name));
-									evt_data.evt_data = (void *)data_all;
-									IPACM_EvtDispatcher::PostEvt(&evt_data);
-									IPACMDBG_H("Posted event %d with %s for ipv4\n",
-										evt_data.event, data_all->iface_name);
+									IPACMERR("Unable to allocate memory\n");
+									return;
 								}
+								data_all->iptype = IPA_IP_v4;
+								data_all->if_index = neighbor_client[i].iface_index;
+								data_all->ipv4_addr = neighbor_client[i].v4_addr; //use previous ipv4 address
+								memcpy(data_all->mac_addr, neighbor_client[i].mac_addr,
+									sizeof(data_all->mac_addr));
+								strlcpy(data_all->iface_name, neighbor_client[i].iface_name, sizeof(data_all->iface_name));
+								evt_data.evt_data = (void *)data_all;
+								IPACM_EvtDispatcher::PostEvt(&evt_data);
+								IPACMDBG_H("Posted event %d with %s for ipv4\n",
+									evt_data.event, data_all->iface_name);
 							}
-							/* delete cache neighbor entry */
-							if (event == IPA_DEL_NEIGH_EVENT)
-							{
-								IPACMDBG_H("Clean %d-st Cached client-MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d\n",
-										i,
-										neighbor_client[i].mac_addr[0],
-										neighbor_client[i].mac_addr[1],
-										neighbor_client[i].mac_addr[2],
-										neighbor_client[i].mac_addr[3],
-										neighbor_client[i].mac_addr[4],
-										neighbor_client[i].mac_addr[5],
-										num_neighbor_client);
+						}
+						/* delete cache neighbor entry */
+						if (event == IPA_DEL_NEIGH_EVENT)
+						{
+							IPACMDBG_H("Clean %d-st Cached client-MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d\n",
+									i,
+									neighbor_client[i].mac_addr[0],
+									neighbor_client[i].mac_addr[1],
+									neighbor_client[i].mac_addr[2],
+									neighbor_client[i].mac_addr[3],
+									neighbor_client[i].mac_addr[4],
+									neighbor_client[i].mac_addr[5],
+									num_neighbor_client);
 
-								memset(neighbor_client[i].mac_addr, 0, sizeof(neighbor_client[i].mac_addr));
-								neighbor_client[i].iface_index = 0;
-								neighbor_client[i].v4_addr = 0;
-								neighbor_client[i].ipa_if_num = 0;
-								memset(neighbor_client[i].iface_name, 0, sizeof(neighbor_client[i].iface_name));
-								for (; i < num_neighbor_client_temp - 1; i++)
-								{
-									memcpy(neighbor_client[i].mac_addr,
-												neighbor_client[i+1].mac_addr,
-												sizeof(neighbor_client[i].mac_addr));
-									neighbor_client[i].iface_index = neighbor_client[i+1].iface_index;
-									neighbor_client[i].v4_addr = neighbor_client[i+1].v4_addr;
-									neighbor_client[i].ipa_if_num = neighbor_client[i+1].ipa_if_num;
-									strlcpy(neighbor_client[i].iface_name, neighbor_client[i+1].iface_name,
-										sizeof(neighbor_client[i].iface_name));
-								}
-								num_neighbor_client--;
-								IPACMDBG_H(" total number of left cased clients: %d\n", num_neighbor_client);
+							neighbor_index.Remove(neighbor_client[i].mac_addr);
+							memset(neighbor_client[i].mac_addr, 0, sizeof(neighbor_client[i].mac_addr));
+							neighbor_client[i].iface_index = 0;
+							neighbor_client[i].v4_addr = 0;
+							neighbor_client[i].ipa_if_num = 0;
+							memset(neighbor_client[i].iface_name, 0, sizeof(neighbor_client[i].iface_name));
+							for (; i < num_neighbor_client_temp - 1; i++)
+							{
+								memcpy(neighbor_client[i].mac_addr,
+											neighbor_client[i+1].mac_addr,
+											sizeof(neighbor_client[i].mac_addr));
+								neighbor_index.Move(neighbor_client[i].mac_addr, i + 1, i);
+								neighbor_client[i].iface_index = neighbor_client[i+1].iface_index;
+								neighbor_client[i].v4_addr = neighbor_client[i+1].v4_addr;
+								neighbor_client[i].ipa_if_num = neighbor_client[i+1].ipa_if_num;
+								strlcpy(neighbor_client[i].iface_name, neighbor_client[i+1].iface_name,
+									sizeof(neighbor_client[i].iface_name));
 							}
-							break;
+							num_neighbor_client--;
+							IPACMDBG_H(" total number of left cased clients: %d\n", num_neighbor_client);
 						}
 					}
 					/* not find client */
-					if ((i == num_neighbor_client_temp) && (event == IPA_NEW_NEIGH_EVENT))
+					if ((i < 0) && (event == IPA_NEW_NEIGH_EVENT))
 					{
 						/* check if iface is not bridge interface*/
 						if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, data->iface_name) != 0)
 						{
-							if (num_neighbor_client_temp < IPA_MAX_NUM_NEIGHBOR_CLIENTS)
+							if (num_neighbor_client_temp < max_neighbor_client)
 							{
 								memcpy(neighbor_client[num_neighbor_client_temp].mac_addr,
 											data->mac_addr,
@@ -534,6 +535,7 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 								neighbor_client[num_neighbor_client_temp].v4_addr = 0;
 								strlcpy(neighbor_client[num_neighbor_client_temp].iface_name, data->iface_name,
 									sizeof(neighbor_client[num_neighbor_client_temp].iface_name));
+								neighbor_index.Insert(neighbor_client[num_neighbor_client_temp].mac_addr, num_neighbor_client_temp);
 								num_neighbor_client++;
 								IPACMDBG_H("Copy client MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d\n",
 												neighbor_client[num_neighbor_client_temp].mac_addr[0],
@@ -548,6 +550,7 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 							else
 							{
 								IPACMERR("error:  neighbor client oversize! recycle %d-st entry ! \n", circular_index);
+								neighbor_index.Remove(neighbor_client[circular_index].mac_addr);
 								memcpy(neighbor_client[circular_index].mac_addr,
 											data->mac_addr,
 											sizeof(data->mac_addr));
@@ -566,7 +569,8 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 												neighbor_client[circular_index].mac_addr[5],
 												num_neighbor_client,
 												circular_index);
-								circular_index = (circular_index + 1) % IPA_MAX_NUM_NEIGHBOR_CLIENTS;
+								neighbor_index.Insert(neighbor_client[circular_index].mac_addr, circular_index);
+								circular_index = (circular_index + 1) % max_neighbor_client;
 								return;
 							}
 						}
@@ -45,6 +45,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Defs.h"
 #include "IPACM_Netlink.h"
 #include "IPACM_EvtDispatcher.h"
+#include "IPACM_IfaceRegistry.h"
 #include "IPACM_Log.h"
 
 int ipa_get_if_name(char *if_name, int if_index);
@@ -250,170 +251,149 @@ static int ipa_nl_sock_listener_start
 	return IPACM_SUCCESS;
 }
 
-/* allocate memory for ipa_nl__msg */
-static struct msghdr* ipa_nl_alloc_msg
-(
-	 uint32_t msglen
-	 )
-{
-	unsigned char *buf = NULL;
-	struct sockaddr_nl *nladdr = NULL;
-	struct iovec *iov = NULL;
-	struct msghdr *msgh = NULL;
+/* Receive buffers of the listener thread, set up once */
+static struct mmsghdr ipa_nl_batch_hdr[IPA_NL_BATCH_SIZE];
+static struct iovec ipa_nl_batch_iov[IPA_NL_BATCH_SIZE];
+static struct sockaddr_nl ipa_nl_batch_addr[IPA_NL_BATCH_SIZE];
+static char ipa_nl_batch_buf[IPA_NL_BATCH_SIZE][IPA_NL_MSG_MAX_LEN];
+static ipa_nl_msg_t ipa_nl_batch_msg;
+static bool ipa_nl_batch_ready = false;
 
-	if(IPA_NL_MSG_MAX_LEN < msglen)
-	{
-		IPACMERR("Netlink message exceeds maximum length\n");
-		return NULL;
-	}
+static ipa_nl_batch_stats_t ipa_nl_stats;
+static pthread_mutex_t ipa_nl_stats_lock = PTHREAD_MUTEX_INITIALIZER;
 
-	msgh = (struct msghdr *)malloc(sizeof(struct msghdr));
-	if(msgh == NULL)
-	{
-		IPACMERR("Failed malloc for msghdr\n");
-		return NULL;
-	}
+/* Neighbor message of the current batch, by address */
+typedef struct
+{
+	struct nlmsghdr *nlh;
+	int ifindex;
+	unsigned char family;
+	unsigned char addr[16];
+	unsigned char lladdr[IPA_MAC_ADDR_SIZE];
+} ipa_nl_neigh_key_t;
 
-	nladdr = (struct sockaddr_nl *)malloc(sizeof(struct sockaddr_nl));
-	if(nladdr == NULL)
-	{
-		IPACMERR("Failed malloc for sockaddr\n");
-		free(msgh);
-		return NULL;
-	}
+static ipa_nl_neigh_key_t ipa_nl_neigh_keys[IPA_NL_NEIGH_COALESCE_MAX];
 
-	iov = (struct iovec *)malloc(sizeof(struct iovec));
-	if(iov == NULL)
-	{
-		PERROR("Failed malloc for iovec");
-		free(nladdr);
-		free(msgh);
-		return NULL;
-	}
+/* point the receive headers at their buffers */
+static void ipa_nl_batch_init(void)
+{
+	int i;
 
-	buf = (unsigned char *)malloc(msglen);
-	if(buf == NULL)
+	for(i = 0; i < IPA_NL_BATCH_SIZE; i++)
 	{
-		IPACMERR("Failed malloc for mglen\n");
-		free(iov);
-		free(nladdr);
-		free(msgh);
-		return NULL;
-	}
+		memset(&ipa_nl_batch_addr[i], 0, sizeof(struct sockaddr_nl));
+		ipa_nl_batch_addr[i].nl_family = AF_NETLINK;
 
-	memset(nladdr, 0, sizeof(struct sockaddr_nl));
-	nladdr->nl_family = AF_NETLINK;
+		ipa_nl_batch_iov[i].iov_base = ipa_nl_batch_buf[i];
+		ipa_nl_batch_iov[i].iov_len = IPA_NL_MSG_MAX_LEN;
 
-	memset(msgh, 0x0, sizeof(struct msghdr));
-	msgh->msg_name = nladdr;
-	msgh->msg_namelen = sizeof(struct sockaddr_nl);
-	msgh->msg_iov = iov;
-	msgh->msg_iovlen = 1;
-
-	memset(iov, 0x0, sizeof(struct iovec));
-	iov->iov_base = buf;
-	iov->iov_len = msglen;
-
-	return msgh;
+		memset(&ipa_nl_batch_hdr[i], 0, sizeof(struct mmsghdr));
+		ipa_nl_batch_hdr[i].msg_hdr.msg_name = &ipa_nl_batch_addr[i];
+		ipa_nl_batch_hdr[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_nl);
+		ipa_nl_batch_hdr[i].msg_hdr.msg_iov = &ipa_nl_batch_iov[i];
+		ipa_nl_batch_hdr[i].msg_hdr.msg_iovlen = 1;
+	}
+	ipa_nl_batch_ready = true;
 }
 
-/* release IPA message */
-static void ipa_nl_release_msg
+/* Extracts the address key of an IPv4/IPv6 neighbor message */
+static bool ipa_nl_neigh_key
 (
-	 struct msghdr *msgh
+	 struct nlmsghdr *nlh,
+	 ipa_nl_neigh_key_t *key
 	 )
 {
-	unsigned char *buf = NULL;
-	struct sockaddr_nl *nladdr = NULL;
-	struct iovec *iov = NULL;
-
-	if(NULL == msgh)
-	{
-		return;
-	}
-
-	nladdr = (struct sockaddr_nl *)msgh->msg_name;
-	iov = msgh->msg_iov;
-	if(msgh->msg_iov)
-	{
-		buf = (unsigned char *)msgh->msg_iov->iov_base;
-	}
+	struct ndmsg *ndm;
+	struct rtattr *rtah;
+	int len, addr_len;
+	bool has_dst = false;
 
-	if(buf)
+	if(nlh->nlmsg_len < NLMSG_LENGTH(sizeof(struct ndmsg)))
 	{
-	free(buf);
+		return false;
 	}
-	if(iov)
+	ndm = (struct ndmsg *)NLMSG_DATA(nlh);
+	if(ndm->ndm_family == AF_INET)
 	{
-	free(iov);
+		addr_len = 4;
 	}
-	if(nladdr)
+	else if(ndm->ndm_family == AF_INET6)
 	{
-	free(nladdr);
+		addr_len = 16;
 	}
-	if(msgh)
+	else
 	{
-	free(msgh);
+		return false;
 	}
-	return;
-}
 
-/* receive and process nl message */
-static int ipa_nl_recv
-(
-	 int              fd,
-	 struct msghdr **msg_pptr,
-	 unsigned int  *msglen_ptr
-	 )
-{
-	struct msghdr *msgh = NULL;
-	int rmsgl;
+	memset(key, 0, sizeof(*key));
+	key->nlh = nlh;
+	key->ifindex = ndm->ndm_ifindex;
+	key->family = ndm->ndm_family;
 
-	msgh = ipa_nl_alloc_msg(IPA_NL_MSG_MAX_LEN);
-	if(NULL == msgh)
+	len = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(struct ndmsg));
+	for(rtah = NDA_RTA(ndm); RTA_OK(rtah, len); rtah = RTA_NEXT(rtah, len))
 	{
-		IPACMERR("Failed to allocate NL message\n");
-		goto error;
+		if(rtah->rta_type == NDA_DST && RTA_PAYLOAD(rtah) == (unsigned int)addr_len)
+		{
+			memcpy(key->addr, RTA_DATA(rtah), addr_len);
+			has_dst = true;
+		}
+		else if(rtah->rta_type == NDA_LLADDR && RTA_PAYLOAD(rtah) >= sizeof(key->lladdr))
+		{
+			memcpy(key->lladdr, RTA_DATA(rtah), sizeof(key->lladdr));
+		}
 	}
+	return has_dst;
+}
 
+/* Turns neighbor updates that the next message for the same address
+	 repeats, same type and same MAC, into NLMSG_NOOP. A different next
+	 message, e.g. a delete after an add, keeps both. */
+static uint32_t ipa_nl_coalesce_neigh(int num_msgs)
+{
+	struct nlmsghdr *nlh;
+	unsigned int len;
+	int i, j, num_keys = 0;
+	uint32_t coalesced = 0;
 
-	/* Receive message over the socket */
-	rmsgl = recvmsg(fd, msgh, 0);
-
-	/* Verify that something was read */
-	if(rmsgl <= 0)
-	{
-		PERROR("NL recv error");
-		goto error;
-	}
-
-	/* Verify that NL address length in the received message is expected value */
-	if(sizeof(struct sockaddr_nl) != msgh->msg_namelen)
+	for(i = 0; i < num_msgs && num_keys < IPA_NL_NEIGH_COALESCE_MAX; i++)
 	{
-		IPACMERR("rcvd msg with namelen != sizeof sockaddr_nl\n");
-		goto error;
+		nlh = (struct nlmsghdr *)ipa_nl_batch_buf[i];
+		len = ipa_nl_batch_hdr[i].msg_len;
+		for(; NLMSG_OK(nlh, len) && num_keys < IPA_NL_NEIGH_COALESCE_MAX; nlh = NLMSG_NEXT(nlh, len))
+		{
+			if((nlh->nlmsg_type == RTM_NEWNEIGH || nlh->nlmsg_type == RTM_DELNEIGH) &&
+				 ipa_nl_neigh_key(nlh, &ipa_nl_neigh_keys[num_keys]))
+			{
+				num_keys++;
+			}
+		}
 	}
 
-	/* Verify that message was not truncated. This should not occur */
-	if(msgh->msg_flags & MSG_TRUNC)
+	for(i = 0; i < num_keys; i++)
 	{
-		IPACMERR("Rcvd msg truncated!\n");
-		goto error;
+		for(j = i + 1; j < num_keys; j++)
+		{
+			if(ipa_nl_neigh_keys[i].ifindex == ipa_nl_neigh_keys[j].ifindex &&
+				 ipa_nl_neigh_keys[i].family == ipa_nl_neigh_keys[j].family &&
+				 memcmp(ipa_nl_neigh_keys[i].addr, ipa_nl_neigh_keys[j].addr,
+								sizeof(ipa_nl_neigh_keys[i].addr)) == 0)
+			{
+				break;
+			}
+		}
+		if(j < num_keys &&
+			 ipa_nl_neigh_keys[i].nlh->nlmsg_type == ipa_nl_neigh_keys[j].nlh->nlmsg_type &&
+			 memcmp(ipa_nl_neigh_keys[i].lladdr, ipa_nl_neigh_keys[j].lladdr,
+							sizeof(ipa_nl_neigh_keys[i].lladdr)) == 0)
+		{
+			ipa_nl_neigh_keys[i].nlh->nlmsg_type = NLMSG_NOOP;
+			coalesced++;
+		}
 	}
 
-	*msg_pptr    = msgh;
-	*msglen_ptr = rmsgl;
-
-	return IPACM_SUCCESS;
-
-/* An error occurred while receiving the message. Free all memory before
-				 returning. */
-error:
-	ipa_nl_release_msg(msgh);
-	*msg_pptr    = NULL;
-	*msglen_ptr  = 0;
-
-	return IPACM_FAILURE;
+	return coalesced;
 }
 
 /* decode the rtm netlink message */
@@ -424,7 +404,7 @@ static int ipa_nl_decode_rtm_link
 	 ipa_nl_link_info_t      *link_info
 )
 {
-	struct rtattr;
+	struct rtattr *rtah = NULL;
 	/* NL message header */
 	struct nlmsghdr *nlh = (struct nlmsghdr *)buffer;
 
@@ -432,6 +412,24 @@ static int ipa_nl_decode_rtm_link
 	link_info->metainfo = *(struct ifinfomsg *)NLMSG_DATA(nlh);
 	buflen -= sizeof(struct nlmsghdr);
 
+	/* Extract the interface name for the interface registry */
+	link_info->attr_info.param_mask = IPA_NLA_PARAM_NONE;
+
+	rtah = IFLA_RTA(NLMSG_DATA(nlh));
+
+	while(RTA_OK(rtah, buflen))
+	{
+		if(rtah->rta_type == IFLA_IFNAME &&
+			 RTA_PAYLOAD(rtah) <= sizeof(link_info->attr_info.ifname))
+		{
+			strlcpy(link_info->attr_info.ifname, (char *)RTA_DATA(rtah),
+				sizeof(link_info->attr_info.ifname));
+			link_info->attr_info.param_mask |= IPA_NLA_PARAM_IFNAME;
+		}
+		/* Advance to next attribute */
+		rtah = RTA_NEXT(rtah, buflen);
+	}
+
 	return IPACM_SUCCESS;
 }
 
@@ -621,13 +619,13 @@ static int ipa_nl_decode_nlmsg
 	while(NLMSG_OK(nlh, buflen))
 	{
 		memset(dev_name,0,IF_NAME_LEN);
-		IPACMDBG("Received msg:%d from netlink\n", nlh->nlmsg_type)
+		IPACMDBG("Received msg:%d from netlink\n", nlh->nlmsg_type);
 		switch(nlh->nlmsg_type)
 		{
 		case RTM_NEWLINK:
 			msg_ptr->type = nlh->nlmsg_type;
 			msg_ptr->link_event = true;
-			if(IPACM_SUCCESS != ipa_nl_decode_rtm_link(buffer, buflen, &(msg_ptr->nl_link_info)))
+			if(IPACM_SUCCESS != ipa_nl_decode_rtm_link((char *)nlh, nlh->nlmsg_len, &(msg_ptr->nl_link_info)))
 			{
 				IPACMERR("Failed to decode rtm link message\n");
 				return IPACM_FAILURE;
@@ -639,6 +637,11 @@ static int ipa_nl_decode_nlmsg
 				IPACMDBG("RTM_NEWLINK, ifi_flags:%d\n", msg_ptr->nl_link_info.metainfo.ifi_flags);
 				IPACMDBG("RTM_NEWLINK, ifi_index:%d\n", msg_ptr->nl_link_info.metainfo.ifi_index);
 				IPACMDBG("RTM_NEWLINK, family:%d\n", msg_ptr->nl_link_info.metainfo.ifi_family);
+				if(msg_ptr->nl_link_info.attr_info.param_mask & IPA_NLA_PARAM_IFNAME)
+				{
+					IPACM_IfaceRegistry::UpdateLink(msg_ptr->nl_link_info.metainfo.ifi_index,
+						msg_ptr->nl_link_info.attr_info.ifname);
+				}
 				/* RTM_NEWLINK event with AF_BRIDGE family should be ignored in Android
 				   but this should be processed in case of MDM for Ehernet interface.
 				*/
@@ -757,7 +760,7 @@ static int ipa_nl_decode_nlmsg
 			msg_ptr->type = nlh->nlmsg_type;
 			msg_ptr->link_event = true;
 			IPACMDBG("entering rtm decode\n");
-			if(IPACM_SUCCESS != ipa_nl_decode_rtm_link(buffer, buflen, &(msg_ptr->nl_link_info)))
+			if(IPACM_SUCCESS != ipa_nl_decode_rtm_link((char *)nlh, nlh->nlmsg_len, &(msg_ptr->nl_link_info)))
 			{
 				IPACMERR("Failed to decode rtm link message\n");
 				return IPACM_FAILURE;
@@ -779,14 +782,28 @@ static int ipa_nl_decode_nlmsg
 					return IPACM_SUCCESS;
 				}
 #endif
-				ret_val = ipa_get_if_name(dev_name, msg_ptr->nl_link_info.metainfo.ifi_index);
-				if(ret_val != IPACM_SUCCESS)
+				/* the device may be unregistered already, prefer the name it was sent with */
+				if(msg_ptr->nl_link_info.attr_info.param_mask & IPA_NLA_PARAM_IFNAME)
 				{
-					IPACMERR("Error while getting interface name\n");
-					return IPACM_FAILURE;
+					strlcpy(dev_name, msg_ptr->nl_link_info.attr_info.ifname, sizeof(dev_name));
+				}
+				else
+				{
+					ret_val = ipa_get_if_name(dev_name, msg_ptr->nl_link_info.metainfo.ifi_index);
+					if(ret_val != IPACM_SUCCESS)
+					{
+						IPACMERR("Error while getting interface name\n");
+						return IPACM_FAILURE;
+					}
 				}
 				IPACMDBG("Interface %s bring down \n", dev_name);
 
+				/* a port leaving a bridge is reported with AF_BRIDGE, the device stays */
+				if(msg_ptr->nl_link_info.metainfo.ifi_family != AF_BRIDGE)
+				{
+					IPACM_IfaceRegistry::RemoveLink(msg_ptr->nl_link_info.metainfo.ifi_index);
+				}
+
 				/* post link down to command queue */
 				evt_data.event = IPA_LINK_DOWN_EVENT;
 				data_fid = (ipacm_event_data_fid *)malloc(sizeof(ipacm_event_data_fid));
@@ -808,7 +825,7 @@ static int ipa_nl_decode_nlmsg
 
 		case RTM_NEWADDR:
 			IPACMDBG("\n GOT RTM_NEWADDR event\n");
-			if(IPACM_SUCCESS != ipa_nl_decode_rtm_addr(buffer, buflen, &(msg_ptr->nl_addr_info)))
+			if(IPACM_SUCCESS != ipa_nl_decode_rtm_addr((char *)nlh, nlh->nlmsg_len, &(msg_ptr->nl_addr_info)))
 			{
 				IPACMERR("Failed to decode rtm addr message\n");
 				return IPACM_FAILURE;
@@ -873,7 +890,7 @@ static int ipa_nl_decode_nlmsg
 
 		case RTM_NEWROUTE:
 
-			if(IPACM_SUCCESS != ipa_nl_decode_rtm_route(buffer, buflen, &(msg_ptr->nl_route_info)))
+			if(IPACM_SUCCESS != ipa_nl_decode_rtm_route((char *)nlh, nlh->nlmsg_len, &(msg_ptr->nl_route_info)))
 			{
 				IPACMERR("Failed to decode rtm route message\n");
 				return IPACM_FAILURE;
@@ -1148,7 +1165,7 @@ static int ipa_nl_decode_nlmsg
 			break;
 
 		case RTM_DELROUTE:
-			if(IPACM_SUCCESS != ipa_nl_decode_rtm_route(buffer, buflen, &(msg_ptr->nl_route_info)))
+			if(IPACM_SUCCESS != ipa_nl_decode_rtm_route((char *)nlh, nlh->nlmsg_len, &(msg_ptr->nl_route_info)))
 			{
 				IPACMERR("Failed to decode rtm route message\n");
 				return IPACM_FAILURE;
@@ -1361,7 +1378,7 @@ static int ipa_nl_decode_nlmsg
 			break;
 
 		case RTM_NEWNEIGH:
-			if(IPACM_SUCCESS != ipa_nl_decode_rtm_neigh(buffer, buflen, &(msg_ptr->nl_neigh_info)))
+			if(IPACM_SUCCESS != ipa_nl_decode_rtm_neigh((char *)nlh, nlh->nlmsg_len, &(msg_ptr->nl_neigh_info)))
 			{
 				IPACMERR("Failed to decode rtm neighbor message\n");
 				return IPACM_FAILURE;
@@ -1449,7 +1466,7 @@ static int ipa_nl_decode_nlmsg
 			break;
 
 		case RTM_DELNEIGH:
-			if(IPACM_SUCCESS != ipa_nl_decode_rtm_neigh(buffer, buflen, &(msg_ptr->nl_neigh_info)))
+			if(IPACM_SUCCESS != ipa_nl_decode_rtm_neigh((char *)nlh, nlh->nlmsg_len, &(msg_ptr->nl_neigh_info)))
 			{
 				IPACMERR("Failed to decode rtm neighbor message\n");
 				return IPACM_FAILURE;
@@ -1536,63 +1553,95 @@ static int ipa_nl_decode_nlmsg
 /*  Virtual function registered to receive incoming messages over the NETLINK routing socket*/
 int ipa_nl_recv_msg(int fd)
 {
-	struct msghdr *msghdr = NULL;
-	struct iovec *iov = NULL;
-	unsigned int msglen = 0;
-	ipa_nl_msg_t *nlmsg = NULL;
+	int i, num_msgs, ret = IPACM_SUCCESS;
+	uint32_t num_nl = 0, coalesced, dropped = 0;
+	struct nlmsghdr *nlh;
+	unsigned int len;
 
-	nlmsg = (ipa_nl_msg_t *)malloc(sizeof(ipa_nl_msg_t));
-	if(NULL == nlmsg)
+	if(!ipa_nl_batch_ready)
 	{
-		IPACMERR("Failed alloc of nlmsg \n");
-		goto error;
+		ipa_nl_batch_init();
 	}
-	else
+
+	/* select() reported the socket readable, take whatever is queued */
+	num_msgs = recvmmsg(fd, ipa_nl_batch_hdr, IPA_NL_BATCH_SIZE, MSG_DONTWAIT, NULL);
+	if(num_msgs <= 0)
 	{
-		if(IPACM_SUCCESS != ipa_nl_recv(fd, &msghdr, &msglen))
+		if(num_msgs < 0 && errno == EAGAIN)
 		{
-			IPACMERR("Failed to receive nl message \n");
-			goto error;
+			return IPACM_SUCCESS;
 		}
+		PERROR("NL recv error");
+		return IPACM_FAILURE;
+	}
 
-		if(msghdr== NULL)
+	for(i = 0; i < num_msgs; i++)
+	{
+		/* Verify that NL address length in the received message is expected value
+			 and that message was not truncated. This should not occur */
+		if(sizeof(struct sockaddr_nl) != ipa_nl_batch_hdr[i].msg_hdr.msg_namelen ||
+			 (ipa_nl_batch_hdr[i].msg_hdr.msg_flags & MSG_TRUNC))
 		{
-			IPACMERR(" failed to get msghdr\n");
-			goto error;
+			IPACMERR("rcvd msg %d with namelen %d flags 0x%x, dropped\n", i,
+							 ipa_nl_batch_hdr[i].msg_hdr.msg_namelen,
+							 ipa_nl_batch_hdr[i].msg_hdr.msg_flags);
+			ipa_nl_batch_hdr[i].msg_len = 0;
+			dropped++;
+			continue;
 		}
-
-		iov = msghdr->msg_iov;
-
-		memset(nlmsg, 0, sizeof(ipa_nl_msg_t));
-		if(IPACM_SUCCESS != ipa_nl_decode_nlmsg((char *)iov->iov_base, msglen, nlmsg))
+		nlh = (struct nlmsghdr *)ipa_nl_batch_buf[i];
+		len = ipa_nl_batch_hdr[i].msg_len;
+		for(; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len))
 		{
-			IPACMERR("Failed to decode nl message \n");
-			goto error;
+			num_nl++;
 		}
-		/* Release NetLink message buffer */
-		if(msghdr)
+	}
+
+	coalesced = ipa_nl_coalesce_neigh(num_msgs);
+
+	for(i = 0; i < num_msgs; i++)
+	{
+		if(ipa_nl_batch_hdr[i].msg_len == 0)
 		{
-			ipa_nl_release_msg(msghdr);
+			continue;
 		}
-		if(nlmsg)
+		memset(&ipa_nl_batch_msg, 0, sizeof(ipa_nl_msg_t));
+		if(IPACM_SUCCESS != ipa_nl_decode_nlmsg(ipa_nl_batch_buf[i],
+			 ipa_nl_batch_hdr[i].msg_len, &ipa_nl_batch_msg))
 		{
-			free(nlmsg);
+			IPACMERR("Failed to decode nl message %d of %d\n", i, num_msgs);
+			ret = IPACM_FAILURE;
 		}
 	}
 
-	return IPACM_SUCCESS;
+	IPACMDBG("netlink batch: %d datagrams, %d messages, %d neighbor updates coalesced, %d dropped\n",
+					 num_msgs, num_nl, coalesced, dropped);
 
-error:
-	if(msghdr)
+	pthread_mutex_lock(&ipa_nl_stats_lock);
+	ipa_nl_stats.batches++;
+	ipa_nl_stats.datagrams += num_msgs;
+	ipa_nl_stats.messages += num_nl;
+	ipa_nl_stats.neigh_coalesced += coalesced;
+	ipa_nl_stats.dropped += dropped;
+	if((uint32_t)num_msgs > ipa_nl_stats.max_batch)
 	{
-		ipa_nl_release_msg(msghdr);
+		ipa_nl_stats.max_batch = num_msgs;
 	}
-	if(nlmsg)
+	pthread_mutex_unlock(&ipa_nl_stats_lock);
+
+	/* recvmmsg() updated the name lengths */
+	for(i = 0; i < num_msgs; i++)
 	{
-		free(nlmsg);
+		ipa_nl_batch_hdr[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_nl);
 	}
+	return ret;
+}
 
-	return IPACM_FAILURE;
+void ipa_nl_get_batch_stats(ipa_nl_batch_stats_t *stats)
+{
+	pthread_mutex_lock(&ipa_nl_stats_lock);
+	*stats = ipa_nl_stats;
+	pthread_mutex_unlock(&ipa_nl_stats_lock);
 }
 
 /*  get ipa interface name */
@@ -1602,31 +1651,7 @@ int ipa_get_if_name
 	 int if_index
 	 )
 {
-	int fd;
-	struct ifreq ifr;
-
-	if((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
-	{
-		IPACMERR("get interface name socket create failed \n");
-		return IPACM_FAILURE;
-	}
-
-	memset(&ifr, 0, sizeof(struct ifreq));
-	ifr.ifr_ifindex = if_index;
-	IPACMDBG("Interface index %d\n", if_index);
-
-	if(ioctl(fd, SIOCGIFNAME, &ifr) < 0)
-	{
-		IPACMERR("call_ioctl_on_dev: ioctl failed:\n");
-		close(fd);
-		return IPACM_FAILURE;
-	}
-
-	(void)strlcpy(if_name, ifr.ifr_name, sizeof(ifr.ifr_name));
-	IPACMDBG("interface name %s\n", ifr.ifr_name);
-	close(fd);
-
-	return IPACM_SUCCESS;
+	return IPACM_IfaceRegistry::GetIfName(if_index, if_name);
 }
 
 /* Initialization routine for listener on NetLink sockets interface */
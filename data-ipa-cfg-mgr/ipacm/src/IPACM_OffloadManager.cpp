@@ -45,6 +45,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.Z
 #include "IPACM_ConntrackListener.h"
 #include "IPACM_Iface.h"
 #include "IPACM_Config.h"
+#include "IPACM_IfaceRegistry.h"
 #include <unistd.h>
 
 const char *IPACM_OffloadManager::DEVICE_NAME = "/dev/wwan_ioctl";
@@ -681,35 +682,12 @@ int IPACM_OffloadManager::post_route_evt(enum ipa_ip_type iptype, int index, ipa
 
 int IPACM_OffloadManager::ipa_get_if_index(const char * if_name, int * if_index)
 {
-	int fd;
-	struct ifreq ifr;
-
-	if((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
-	{
-		IPACMERR("get interface index socket create failed \n");
-		return IPACM_FAILURE;
-	}
-
-	if(strnlen(if_name, sizeof(if_name)) >= sizeof(ifr.ifr_name)) {
-		IPACMERR("interface name overflows: len %zu\n", strnlen(if_name, sizeof(if_name)));
-		close(fd);
-		return IPACM_FAILURE;
-	}
-
-	memset(&ifr, 0, sizeof(struct ifreq));
-	(void)strlcpy(ifr.ifr_name, if_name, sizeof(ifr.ifr_name));
-	IPACMDBG_H("interface name (%s)\n", if_name);
-
-	if(ioctl(fd,SIOCGIFINDEX , &ifr) < 0)
+	if(IPACM_IfaceRegistry::GetIfIndex(if_name, if_index) != IPACM_SUCCESS)
 	{
-		IPACMERR("call_ioctl_on_dev: ioctl failed, interface name (%s):\n", ifr.ifr_name);
-		close(fd);
 		return IPACM_FAILURE;
 	}
 
-	*if_index = ifr.ifr_ifindex;
 	IPACMDBG_H("Interface netdev index %d\n", *if_index);
-	close(fd);
 	return IPACM_SUCCESS;
 }
 
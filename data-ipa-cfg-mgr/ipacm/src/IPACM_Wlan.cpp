@@ -88,8 +88,9 @@ IPACM_Wlan::IPACM_Wlan(int iface_index) : IPACM_Lan(iface_index)
 	if(iface_query != NULL)
 	{
 		wlan_client_len = (sizeof(ipa_wlan_client)) + (iface_query->num_tx_props * sizeof(wlan_client_rt_hdl));
-		wlan_client = (ipa_wlan_client *)calloc(IPA_MAX_NUM_WIFI_CLIENTS, wlan_client_len);
-		if (wlan_client == NULL)
+		wlan_client = (ipa_wlan_client *)calloc(IPACM_Iface::ipacmcfg->GetMaxWlanClients(), wlan_client_len);
+		if (wlan_client == NULL ||
+				wlan_client_index.Init(IPACM_Iface::ipacmcfg->GetMaxWlanClients(), IPA_MAC_ADDR_SIZE) != 0)
 		{
 			IPACMERR("unable to allocate memory\n");
 			return;
@@ -939,8 +940,8 @@ int IPACM_Wlan::handle_wlan_client_init_ex(ipacm_event_data_wlan_ex *data)
 	IPACMDBG_H("Wifi client number for this iface: %d & total number of wlan clients: %d\n",
                  num_wifi_client,IPACM_Wlan::total_num_wifi_clients);
 
-	if ((num_wifi_client >= IPA_MAX_NUM_WIFI_CLIENTS) ||
-			(IPACM_Wlan::total_num_wifi_clients >= IPA_MAX_NUM_WIFI_CLIENTS))
+	if ((num_wifi_client >= (uint32_t)IPACM_Iface::ipacmcfg->GetMaxWlanClients()) ||
+			(IPACM_Wlan::total_num_wifi_clients >= IPACM_Iface::ipacmcfg->GetMaxWlanClients()))
 	{
 		IPACMERR("Reached maximum number of wlan clients\n");
 		return IPACM_FAILURE;
@@ -1199,6 +1200,7 @@ int IPACM_Wlan::handle_wlan_client_init_ex(ipacm_event_data_wlan_ex *data)
 		get_client_memptr(wlan_client, num_wifi_client)->ipv4_set = false;
 		get_client_memptr(wlan_client, num_wifi_client)->ipv6_set = 0;
 		get_client_memptr(wlan_client, num_wifi_client)->power_save_set=false;
+		wlan_client_index.Insert(get_client_memptr(wlan_client, num_wifi_client)->mac, num_wifi_client);
 		num_wifi_client++;
 		header_name_count++; //keep increasing header_name_count
 		IPACM_Wlan::total_num_wifi_clients++;
@@ -1661,6 +1663,7 @@ int IPACM_Wlan::handle_wlan_client_down_evt(uint8_t *mac_addr)
 	get_client_memptr(wlan_client, clt_indx)->route_rule_set_v4 = false;
 	get_client_memptr(wlan_client, clt_indx)->route_rule_set_v6 = 0;
 	free(get_client_memptr(wlan_client, clt_indx)->p_hdr_info);
+	wlan_client_index.Remove(mac_addr);
 
 	for (; clt_indx < num_wifi_client_tmp - 1; clt_indx++)
 	{
@@ -1669,6 +1672,7 @@ int IPACM_Wlan::handle_wlan_client_down_evt(uint8_t *mac_addr)
 		memcpy(get_client_memptr(wlan_client, clt_indx)->mac,
 					 get_client_memptr(wlan_client, (clt_indx + 1))->mac,
 					 sizeof(get_client_memptr(wlan_client, clt_indx)->mac));
+		wlan_client_index.Move(get_client_memptr(wlan_client, clt_indx)->mac, clt_indx + 1, clt_indx);
 
 		get_client_memptr(wlan_client, clt_indx)->hdr_hdl_v4 = get_client_memptr(wlan_client, (clt_indx + 1))->hdr_hdl_v4;
 		get_client_memptr(wlan_client, clt_indx)->hdr_hdl_v6 = get_client_memptr(wlan_client, (clt_indx + 1))->hdr_hdl_v6;
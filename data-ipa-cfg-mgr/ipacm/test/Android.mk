@@ -0,0 +1,137 @@
+BOARD_PLATFORM_LIST := test
+ifeq ($(call is-board-platform-in-list,$(BOARD_PLATFORM_LIST)),true)
+ifneq (,$(filter $(QCOM_BOARD_PLATFORMS),$(TARGET_BOARD_PLATFORM)))
+ifneq (, $(filter aarch64 arm arm64, $(TARGET_ARCH)))
+
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../inc
+
+LOCAL_MODULE := ipacm_nat_storm_test
+LOCAL_SRC_FILES := ipacm_nat_storm_test.cpp \
+		../src/IPACM_Conntrack_NATIndex.cpp
+
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/kernel-tests/ip_accelerator
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../inc
+LOCAL_C_INCLUDES += external/libnetfilter_conntrack/include
+LOCAL_C_INCLUDES += external/libnfnetlink/include
+
+LOCAL_HEADER_LIBRARIES := generated_kernel_headers
+
+LOCAL_CFLAGS := -DFEATURE_IPA_ANDROID -DDEBUG -Wall -Werror
+
+LOCAL_MODULE := ipacm_log_bench
+LOCAL_SRC_FILES := ipacm_log_bench.cpp \
+		../src/IPACM_Log.cpp
+
+LOCAL_SHARED_LIBRARIES := libcutils
+
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/kernel-tests/ip_accelerator
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../inc
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../../ipanat/inc
+LOCAL_C_INCLUDES += external/libxml2/include
+LOCAL_C_INCLUDES += external/libnetfilter_conntrack/include
+LOCAL_C_INCLUDES += external/libnfnetlink/include
+
+LOCAL_HEADER_LIBRARIES := generated_kernel_headers
+
+LOCAL_CFLAGS := -DFEATURE_IPA_ANDROID -Wall -Werror
+
+LOCAL_MODULE := ipacm_evt_replay
+LOCAL_SRC_FILES := ipacm_evt_replay.cpp \
+		../src/IPACM_EvtDispatcher.cpp \
+		../src/IPACM_CmdQueue.cpp \
+		../src/IPACM_Log.cpp
+
+LOCAL_SHARED_LIBRARIES := libcutils
+
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/kernel-tests/ip_accelerator
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../inc
+
+LOCAL_CFLAGS := -Wall -Werror
+
+LOCAL_MODULE := ipacm_client_index_test
+LOCAL_SRC_FILES := ipacm_client_index_test.cpp \
+		../src/IPACM_ClientIndex.cpp
+
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/kernel-tests/ip_accelerator
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../inc
+LOCAL_C_INCLUDES += external/libnetfilter_conntrack/include
+LOCAL_C_INCLUDES += external/libnfnetlink/include
+
+LOCAL_HEADER_LIBRARIES := generated_kernel_headers
+
+LOCAL_CFLAGS := -DFEATURE_IPA_ANDROID -Wall -Werror
+
+LOCAL_MODULE := ipacm_iface_registry_test
+LOCAL_SRC_FILES := ipacm_iface_registry_test.cpp \
+		../src/IPACM_IfaceRegistry.cpp \
+		../src/IPACM_ClientIndex.cpp \
+		../src/IPACM_Log.cpp
+
+LOCAL_SHARED_LIBRARIES := libcutils
+
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/kernel-tests/ip_accelerator
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../inc
+LOCAL_C_INCLUDES += external/libnetfilter_conntrack/include
+LOCAL_C_INCLUDES += external/libnfnetlink/include
+
+LOCAL_HEADER_LIBRARIES := generated_kernel_headers
+
+LOCAL_CFLAGS := -DFEATURE_IPA_ANDROID -Wall -Werror
+
+LOCAL_MODULE := ipacm_nl_batch_test
+LOCAL_SRC_FILES := ipacm_nl_batch_test.cpp \
+		../src/IPACM_Netlink.cpp \
+		../src/IPACM_IfaceRegistry.cpp \
+		../src/IPACM_ClientIndex.cpp \
+		../src/IPACM_Log.cpp
+
+LOCAL_SHARED_LIBRARIES := libcutils
+
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/kernel-tests/ip_accelerator
+
+include $(BUILD_EXECUTABLE)
+
+endif # $(TARGET_ARCH)
+endif
+endif
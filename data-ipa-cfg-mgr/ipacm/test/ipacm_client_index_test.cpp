@@ -0,0 +1,293 @@
+/*
+Copyright (c) 2017, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*
+ * Replays synthetic associate/disassociate/lookup traffic against a client
+ * array compacted on removal, the way IPACM_Wlan and IPACM_Neighbor keep
+ * their clients, once with the linear memcmp() search they used to do and
+ * once with ClientIndex, checks that both find the same slots and prints
+ * the average cost per client event.
+ *
+ * usage: ipacm_client_index_test [max_clients] [events]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "IPACM_ClientIndex.h"
+
+#define MAC_LEN 6
+#define DEFAULT_MAX_CLIENTS 255
+#define DEFAULT_EVENTS 500000
+
+typedef struct
+{
+	uint8_t mac_addr[MAC_LEN];
+	uint32_t v4_addr;
+} test_client;
+
+enum client_op
+{
+	CLIENT_ADD,
+	CLIENT_DEL,
+	CLIENT_FIND
+};
+
+typedef struct
+{
+	client_op op;
+	uint8_t mac_addr[MAC_LEN];
+} client_event;
+
+/* Client array kept like wlan_client: appended on add, shifted down on
+ * delete, looked up either linearly or through a ClientIndex */
+class ClientTable
+{
+public:
+	test_client *clients;
+	int num_clients, max_clients;
+	bool use_index;
+	ClientIndex index;
+
+	ClientTable(int entries, bool indexed)
+	{
+		max_clients = entries;
+		num_clients = 0;
+		use_index = indexed;
+		clients = (test_client *)calloc(entries, sizeof(test_client));
+		if(use_index)
+		{
+			index.Init(entries, MAC_LEN);
+		}
+	}
+	~ClientTable()
+	{
+		free(clients);
+	}
+	int Find(const uint8_t *mac_addr)
+	{
+		int cnt;
+		if(use_index)
+		{
+			return index.Find(mac_addr);
+		}
+		for(cnt = 0; cnt < num_clients; cnt++)
+		{
+			if(memcmp(clients[cnt].mac_addr, mac_addr, MAC_LEN) == 0)
+			{
+				return cnt;
+			}
+		}
+		return -1;
+	}
+	int Add(const uint8_t *mac_addr)
+	{
+		if(Find(mac_addr) >= 0 || num_clients == max_clients)
+		{
+			return -1;
+		}
+		memcpy(clients[num_clients].mac_addr, mac_addr, MAC_LEN);
+		if(use_index && index.Insert(mac_addr, num_clients) != 0)
+		{
+			return -1;
+		}
+		return num_clients++;
+	}
+	int Delete(const uint8_t *mac_addr)
+	{
+		int cnt, del = Find(mac_addr);
+		if(del < 0)
+		{
+			return -1;
+		}
+		if(use_index)
+		{
+			index.Remove(mac_addr);
+		}
+		for(cnt = del; cnt < num_clients - 1; cnt++)
+		{
+			clients[cnt] = clients[cnt + 1];
+			if(use_index)
+			{
+				index.Move(clients[cnt].mac_addr, cnt + 1, cnt);
+			}
+		}
+		num_clients--;
+		return del;
+	}
+	int Run(const client_event *evt)
+	{
+		switch(evt->op)
+		{
+		case CLIENT_ADD:
+			return Add(evt->mac_addr);
+		case CLIENT_DEL:
+			return Delete(evt->mac_addr);
+		default:
+			return Find(evt->mac_addr);
+		}
+	}
+};
+
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void random_mac(uint8_t *mac_addr)
+{
+	int cnt;
+	for(cnt = 0; cnt < MAC_LEN; cnt++)
+	{
+		mac_addr[cnt] = rand() & 0xFF;
+	}
+	/* same vendor prefix for most clients, as on a busy hotspot */
+	if(rand() % 4)
+	{
+		mac_addr[0] = 0x02;
+		mac_addr[1] = 0x1A;
+		mac_addr[2] = 0x11;
+	}
+}
+
+/* The table mostly stays near full: clients come and go, every packet
+ * path event looks one of them up, and some events name unknown or
+ * already associated clients, as repeated driver events do. */
+static client_event *make_traffic(int max_clients, int events)
+{
+	client_event *traffic = (client_event *)calloc(events, sizeof(client_event));
+	uint8_t (*live)[MAC_LEN] = (uint8_t (*)[MAC_LEN])calloc(max_clients, MAC_LEN);
+	int nlive = 0, cnt;
+
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		int r = rand() % 100;
+		if(nlive > 0 && r < 70)
+		{
+			traffic[cnt].op = CLIENT_FIND;
+			memcpy(traffic[cnt].mac_addr, live[rand() % nlive], MAC_LEN);
+		}
+		else if(nlive > 0 && (nlive == max_clients || r < 84))
+		{
+			int k = rand() % nlive;
+			traffic[cnt].op = CLIENT_DEL;
+			memcpy(traffic[cnt].mac_addr, live[k], MAC_LEN);
+			memcpy(live[k], live[--nlive], MAC_LEN);
+		}
+		else if(r < 88)
+		{
+			/* duplicate add or unknown client */
+			traffic[cnt].op = (r & 1) ? CLIENT_ADD : CLIENT_FIND;
+			if(nlive > 0 && traffic[cnt].op == CLIENT_ADD)
+			{
+				memcpy(traffic[cnt].mac_addr, live[rand() % nlive], MAC_LEN);
+			}
+			else
+			{
+				random_mac(traffic[cnt].mac_addr);
+			}
+		}
+		else
+		{
+			traffic[cnt].op = CLIENT_ADD;
+			random_mac(traffic[cnt].mac_addr);
+			memcpy(live[nlive++], traffic[cnt].mac_addr, MAC_LEN);
+		}
+	}
+
+	free(live);
+	return traffic;
+}
+
+int main(int argc, char **argv)
+{
+	int max_clients = (argc > 1) ? atoi(argv[1]) : DEFAULT_MAX_CLIENTS;
+	int events = (argc > 2) ? atoi(argv[2]) : DEFAULT_EVENTS;
+	client_event *traffic;
+	ClientTable *linear, *indexed;
+	int *linear_res, *indexed_res;
+	double start, linear_ns, indexed_ns;
+	int cnt;
+
+	if(max_clients <= 0 || events <= 0)
+	{
+		printf("usage: %s [max_clients] [events]\n", argv[0]);
+		return 1;
+	}
+
+	srand(time(NULL));
+	traffic = make_traffic(max_clients, events);
+	linear = new ClientTable(max_clients, false);
+	indexed = new ClientTable(max_clients, true);
+	linear_res = (int *)malloc(sizeof(int) * events);
+	indexed_res = (int *)malloc(sizeof(int) * events);
+
+	start = now_ns();
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		linear_res[cnt] = linear->Run(&traffic[cnt]);
+	}
+	linear_ns = now_ns() - start;
+
+	start = now_ns();
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		indexed_res[cnt] = indexed->Run(&traffic[cnt]);
+	}
+	indexed_ns = now_ns() - start;
+
+	/* both tables compact the same way, so every slot must match */
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		if(linear_res[cnt] != indexed_res[cnt])
+		{
+			printf("FAIL: event %d (op %d) linear %d, indexed %d\n", cnt,
+				traffic[cnt].op, linear_res[cnt], indexed_res[cnt]);
+			return 1;
+		}
+	}
+	if(indexed->index.GetCount() != indexed->num_clients)
+	{
+		printf("FAIL: %d clients, %d indexed\n", indexed->num_clients,
+			indexed->index.GetCount());
+		return 1;
+	}
+
+	printf("%d clients, %d client events\n", max_clients, events);
+	printf("linear search: %.0lf ns/event\n", linear_ns / events);
+	printf("client index:  %.0lf ns/event\n", indexed_ns / events);
+
+	free(linear_res);
+	free(indexed_res);
+	delete linear;
+	delete indexed;
+	free(traffic);
+	return 0;
+}
@@ -0,0 +1,643 @@
+/*
+Copyright (c) 2017, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*
+ * Replays an event sequence through the ipacm event dispatcher and checks
+ * that every listener sees the events of its interface, and the events
+ * that are not about one interface, in posting order. Internal events are
+ * taken before external ones, so the order is checked per queue. Each mode runs in a
+ * child process, since the command queue thread never exits:
+ *   - legacy: one listener list walked for every event, a new message
+ *     per event, as the dispatcher used to do
+ *   - table: per event listener lists and pooled messages
+ *   - workers N: the same with N event worker threads
+ * and prints the time taken to deliver the whole sequence.
+ *
+ * Without a trace, the sequence is a storm of neighbor and client events
+ * over several interfaces with address, link and conntrack events mixed in.
+ * Trace lines are "<event id> <if_index>".
+ *
+ * usage: ipacm_evt_replay [-i ifaces] [-n events] [-c handler_us]
+ *                         [-w max_workers] [trace]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include "IPACM_EvtDispatcher.h"
+#include "IPACM_Iface.h"
+#include "IPACM_Config.h"
+#include "IPACM_Log.h"
+
+#define DEFAULT_IFACES 4
+#define DEFAULT_EVENTS 100000
+#define DEFAULT_HANDLER_US 5
+#define DEFAULT_MAX_WORKERS 4
+#define MAX_IFACES 32
+#define FIRST_IF_INDEX 10
+
+/* Events each interface listener registers, like IPACM_Lan does */
+static const ipa_cm_event_id iface_events[] =
+{
+	IPA_LINK_UP_EVENT,
+	IPA_LINK_DOWN_EVENT,
+	IPA_ADDR_ADD_EVENT,
+	IPA_CFG_CHANGE_EVENT,
+	IPA_NEW_NEIGH_EVENT,
+	IPA_DEL_NEIGH_EVENT,
+	IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT,
+	IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT,
+	IPA_WLAN_CLIENT_POWER_SAVE_EVENT,
+	IPA_WLAN_CLIENT_RECOVER_EVENT,
+	IPA_HANDLE_WAN_UP,
+	IPA_HANDLE_WAN_DOWN,
+	IPA_HANDLE_WAN_UP_V6,
+	IPA_HANDLE_WAN_DOWN_V6,
+	IPA_LAN_DELETE_SELF,
+	IPA_PROCESS_CT_MESSAGE,
+};
+#define NUM_IFACE_EVENTS (int)(sizeof(iface_events) / sizeof(iface_events[0]))
+
+typedef struct
+{
+	ipa_cm_event_id event;
+	int if_index;
+} replay_event;
+
+/* The stubs the dispatcher needs from the rest of ipacm */
+uint32_t ipacm_event_stats[IPACM_EVENT_MAX];
+static uint64_t cfg_storage[(sizeof(IPACM_Config) + 7) / 8];
+IPACM_Config *IPACM_Iface::ipacmcfg = (IPACM_Config *)cfg_storage;
+
+const char* IPACM_Config::getEventName(ipa_cm_event_id event_id)
+{
+	return (event_id < IPACM_EVENT_MAX) ? "replay event" : NULL;
+}
+
+static int handler_us = DEFAULT_HANDLER_US;
+static int iface_index[MAX_IFACES];
+static int num_ifaces;
+static uint32_t delivered;
+static uint32_t expected;
+static uint32_t order_errors;
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Stands in for the rule and header updates of a real handler */
+static void handler_work(void)
+{
+	double end;
+
+	if(handler_us <= 0)
+	{
+		return;
+	}
+	end = now_ns() + handler_us * 1000.0;
+	while(now_ns() < end)
+	{
+	}
+}
+
+/* Sequence numbers travel in the event data, after the fields the
+   dispatcher reads */
+static void* alloc_evt_data(ipa_cm_event_id event, int if_index, uint32_t seq)
+{
+	if(event == IPA_WLAN_CLIENT_POWER_SAVE_EVENT || event == IPA_WLAN_CLIENT_RECOVER_EVENT)
+	{
+		ipacm_event_data_mac *data = (ipacm_event_data_mac *)calloc(1, sizeof(*data));
+
+		if(data != NULL)
+		{
+			data->if_index = if_index;
+			memcpy(data->mac_addr, &seq, sizeof(seq));
+		}
+		return data;
+	}
+	else
+	{
+		ipacm_event_data_all *data = (ipacm_event_data_all *)calloc(1, sizeof(*data));
+
+		if(data != NULL)
+		{
+			data->if_index = if_index;
+			data->ipv4_addr = seq;
+		}
+		return data;
+	}
+}
+
+static void get_evt_data(ipa_cm_event_id event, void *param, int *if_index, uint32_t *seq)
+{
+	if(event == IPA_WLAN_CLIENT_POWER_SAVE_EVENT || event == IPA_WLAN_CLIENT_RECOVER_EVENT)
+	{
+		ipacm_event_data_mac *data = (ipacm_event_data_mac *)param;
+
+		*if_index = data->if_index;
+		memcpy(seq, data->mac_addr, sizeof(*seq));
+	}
+	else
+	{
+		ipacm_event_data_all *data = (ipacm_event_data_all *)param;
+
+		*if_index = data->if_index;
+		*seq = data->ipv4_addr;
+	}
+}
+
+/* One listener per interface. Client events of other interfaces are
+   skipped after a look at the data, as the interface classes do */
+class ReplayListener : public IPACM_Listener
+{
+public:
+	int if_index;
+	uint32_t last_seq[2];	/* external, internal queue */
+
+	ReplayListener(int index) { if_index = index; last_seq[0] = last_seq[1] = 0; }
+
+	void event_callback(ipa_cm_event_id event, void *param)
+	{
+		int evt_if_index;
+		uint32_t seq;
+		ipacm_cmd_q_data data;
+		int queue = (event >= IPA_EXTERNAL_EVENT_MAX);
+
+		get_evt_data(event, param, &evt_if_index, &seq);
+		data.event = event;
+		data.evt_data = param;
+		if(IPACM_EvtDispatcher::GetEvtIface(&data) < 0 || evt_if_index == if_index)
+		{
+			handler_work();
+			if(seq <= last_seq[queue])
+			{
+				__atomic_fetch_add(&order_errors, 1, __ATOMIC_RELAXED);
+			}
+			last_seq[queue] = seq;
+		}
+		__atomic_fetch_add(&delivered, 1, __ATOMIC_RELEASE);
+	}
+};
+
+/* The dispatcher and command queue as they were before the per event
+   lists, the message pool and the event workers */
+typedef struct _legacy_evts
+{
+	ipa_cm_event_id event;
+	IPACM_Listener *obj;
+	_legacy_evts *next;
+} legacy_evts;
+
+static legacy_evts *legacy_head;
+static Message *legacy_q_head[2], *legacy_q_tail[2];	/* external, internal */
+static pthread_mutex_t legacy_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t legacy_cond = PTHREAD_COND_INITIALIZER;
+
+static void legacy_registr(ipa_cm_event_id event, IPACM_Listener *obj)
+{
+	legacy_evts *tmp = legacy_head, *nw;
+
+	nw = (legacy_evts *)malloc(sizeof(legacy_evts));
+	if(nw == NULL)
+	{
+		return;
+	}
+	nw->event = event;
+	nw->obj = obj;
+	nw->next = NULL;
+	if(legacy_head == NULL)
+	{
+		legacy_head = nw;
+		return;
+	}
+	while(tmp->next)
+	{
+		tmp = tmp->next;
+	}
+	tmp->next = nw;
+}
+
+static void legacy_process_evt(ipacm_cmd_q_data *data)
+{
+	legacy_evts *tmp = legacy_head, tmp1;
+
+	while(tmp != NULL)
+	{
+		memcpy(&tmp1, tmp, sizeof(tmp1));
+		if(data->event == tmp1.event)
+		{
+			ipacm_event_stats[data->event]++;
+			tmp1.obj->event_callback(data->event, data->evt_data);
+		}
+		tmp = tmp1.next;
+	}
+	free(data->evt_data);
+}
+
+static void legacy_post_evt(ipacm_cmd_q_data *data)
+{
+	Message *item = new Message();
+	int queue = (data->event >= IPA_EXTERNAL_EVENT_MAX);
+
+	item->evt.callback_ptr = legacy_process_evt;
+	memcpy(&item->evt.data, data, sizeof(ipacm_cmd_q_data));
+
+	pthread_mutex_lock(&legacy_mutex);
+	if(legacy_q_head[queue] == NULL)
+	{
+		legacy_q_head[queue] = item;
+	}
+	else
+	{
+		legacy_q_tail[queue]->setnext(item);
+	}
+	legacy_q_tail[queue] = item;
+	pthread_cond_signal(&legacy_cond);
+	pthread_mutex_unlock(&legacy_mutex);
+}
+
+static void* legacy_process(void *param)
+{
+	Message *item;
+	int queue;
+
+	(void)param;
+	while(1)
+	{
+		pthread_mutex_lock(&legacy_mutex);
+		while(legacy_q_head[0] == NULL && legacy_q_head[1] == NULL)
+		{
+			pthread_cond_wait(&legacy_cond, &legacy_mutex);
+		}
+		queue = (legacy_q_head[1] != NULL);
+		item = legacy_q_head[queue];
+		legacy_q_head[queue] = item->getnext();
+		pthread_mutex_unlock(&legacy_mutex);
+
+		item->evt.callback_ptr(&item->evt.data);
+		delete item;
+	}
+	return NULL;
+}
+
+static int load_trace(const char *path, replay_event **out)
+{
+	FILE *fp = fopen(path, "r");
+	replay_event *trace = NULL, *tmp;
+	int cnt = 0, size = 0, event, if_index;
+	char line[128];
+
+	if(fp == NULL)
+	{
+		printf("unable to open %s\n", path);
+		return -1;
+	}
+	while(fgets(line, sizeof(line), fp) != NULL)
+	{
+		if(sscanf(line, "%d %d", &event, &if_index) != 2 ||
+			event < 0 || event >= IPACM_EVENT_MAX)
+		{
+			continue;
+		}
+		if(cnt == size)
+		{
+			size = size ? size * 2 : 1024;
+			tmp = (replay_event *)realloc(trace, sizeof(replay_event) * size);
+			if(tmp == NULL)
+			{
+				free(trace);
+				fclose(fp);
+				return -1;
+			}
+			trace = tmp;
+		}
+		trace[cnt].event = (ipa_cm_event_id)event;
+		trace[cnt].if_index = if_index;
+		cnt++;
+	}
+	fclose(fp);
+	*out = trace;
+	return cnt;
+}
+
+static replay_event* make_storm(int events, int ifaces)
+{
+	static const ipa_cm_event_id client_events[] =
+	{
+		IPA_NEW_NEIGH_EVENT,
+		IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT,
+		IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT,
+		IPA_DEL_NEIGH_EVENT,
+		IPA_WLAN_CLIENT_POWER_SAVE_EVENT,
+		IPA_WLAN_CLIENT_RECOVER_EVENT,
+	};
+	static const ipa_cm_event_id other_events[] =
+	{
+		IPA_ADDR_ADD_EVENT,
+		IPA_PROCESS_CT_MESSAGE,
+		IPA_HANDLE_WAN_UP,
+		IPA_CFG_CHANGE_EVENT,
+	};
+	replay_event *storm;
+	int cnt;
+
+	storm = (replay_event *)malloc(sizeof(replay_event) * events);
+	if(storm == NULL)
+	{
+		return NULL;
+	}
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		storm[cnt].if_index = iface_index[rand() % ifaces];
+		/* one event in 32 is not about a single client */
+		if(rand() % 32 == 0)
+		{
+			storm[cnt].event = other_events[rand() % 4];
+		}
+		else
+		{
+			storm[cnt].event = client_events[rand() % 6];
+		}
+	}
+	return storm;
+}
+
+/* Delivers the sequence in the current process, workers < 0 for legacy */
+static int replay(replay_event *trace, int events, int workers, double *elapsed)
+{
+	ReplayListener *listeners[MAX_IFACES];
+	ipacm_cmd_q_data data;
+	pthread_t thread;
+	char num[16];
+	double start;
+	int cnt, evt, lst;
+
+	for(lst = 0; lst < num_ifaces; lst++)
+	{
+		listeners[lst] = new ReplayListener(iface_index[lst]);
+		for(evt = 0; evt < NUM_IFACE_EVENTS; evt++)
+		{
+			if(workers < 0)
+			{
+				legacy_registr(iface_events[evt], listeners[lst]);
+			}
+			else
+			{
+				IPACM_EvtDispatcher::registr(iface_events[evt], listeners[lst]);
+			}
+		}
+	}
+
+	expected = 0;
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		for(evt = 0; evt < NUM_IFACE_EVENTS; evt++)
+		{
+			if(iface_events[evt] == trace[cnt].event)
+			{
+				expected += num_ifaces;
+			}
+		}
+	}
+
+	if(workers < 0)
+	{
+		if(pthread_create(&thread, NULL, legacy_process, NULL) != 0)
+		{
+			return -1;
+		}
+	}
+	else
+	{
+		snprintf(num, sizeof(num), "%d", workers);
+		setenv("IPACM_EVT_WORKERS", num, 1);
+		/* the queues are created on first use, not under the mutex */
+		MessageQueue::getInstanceInternal();
+		MessageQueue::getInstanceExternal();
+		if(pthread_create(&thread, NULL, MessageQueue::Process, NULL) != 0)
+		{
+			return -1;
+		}
+	}
+
+	start = now_ns();
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		data.event = trace[cnt].event;
+		data.evt_data = alloc_evt_data(trace[cnt].event, trace[cnt].if_index, cnt + 1);
+		if(data.evt_data == NULL)
+		{
+			return -1;
+		}
+		if(workers < 0)
+		{
+			legacy_post_evt(&data);
+		}
+		else if(IPACM_EvtDispatcher::PostEvt(&data) != IPACM_SUCCESS)
+		{
+			free(data.evt_data);
+			return -1;
+		}
+	}
+	while(__atomic_load_n(&delivered, __ATOMIC_ACQUIRE) < expected)
+	{
+		usleep(100);
+	}
+	*elapsed = now_ns() - start;
+	return 0;
+}
+
+/* Runs one mode in a child process, returns the elapsed time or < 0 */
+static double run_mode(replay_event *trace, int events, int workers, uint32_t *errors)
+{
+	double result[2] = { -1, 0 };
+	int fds[2], status;
+	pid_t pid;
+
+	if(pipe(fds) != 0)
+	{
+		return -1;
+	}
+	fflush(stdout);
+	pid = fork();
+	if(pid < 0)
+	{
+		close(fds[0]);
+		close(fds[1]);
+		return -1;
+	}
+	if(pid == 0)
+	{
+		close(fds[0]);
+		if(replay(trace, events, workers, &result[0]) != 0)
+		{
+			result[0] = -1;
+		}
+		result[1] = order_errors;
+		if(write(fds[1], result, sizeof(result)) != sizeof(result))
+		{
+			_exit(1);
+		}
+		_exit(0);
+	}
+	close(fds[1]);
+	if(read(fds[0], result, sizeof(result)) != sizeof(result))
+	{
+		result[0] = -1;
+	}
+	close(fds[0]);
+	waitpid(pid, &status, 0);
+	*errors = (uint32_t)result[1];
+	return result[0];
+}
+
+int main(int argc, char **argv)
+{
+	int ifaces = DEFAULT_IFACES, events = DEFAULT_EVENTS;
+	int max_workers = DEFAULT_MAX_WORKERS, workers, opt, ret = 0;
+	replay_event *trace;
+	double legacy_ns, elapsed;
+	uint32_t errors;
+	char name[32];
+
+	while((opt = getopt(argc, argv, "i:n:c:w:")) != -1)
+	{
+		switch(opt)
+		{
+		case 'i':
+			ifaces = atoi(optarg);
+			break;
+		case 'n':
+			events = atoi(optarg);
+			break;
+		case 'c':
+			handler_us = atoi(optarg);
+			break;
+		case 'w':
+			max_workers = atoi(optarg);
+			break;
+		default:
+			ifaces = 0;
+			break;
+		}
+	}
+	if(ifaces <= 0 || ifaces > MAX_IFACES || events <= 0 ||
+		max_workers < 0 || max_workers > IPACM_EVT_WORKERS_MAX)
+	{
+		printf("usage: %s [-i ifaces] [-n events] [-c handler_us] [-w max_workers] [trace]\n",
+			argv[0]);
+		return 1;
+	}
+
+	ipacm_log_set_level(IPACM_LOG_LEVEL_ERR);
+	srand(time(NULL));
+	if(optind < argc)
+	{
+		events = load_trace(argv[optind], &trace);
+		if(events <= 0)
+		{
+			return 1;
+		}
+		/* a listener for each interface of the trace */
+		for(opt = 0; opt < events && num_ifaces < MAX_IFACES; opt++)
+		{
+			for(workers = 0; workers < num_ifaces; workers++)
+			{
+				if(iface_index[workers] == trace[opt].if_index)
+				{
+					break;
+				}
+			}
+			if(workers == num_ifaces)
+			{
+				iface_index[num_ifaces++] = trace[opt].if_index;
+			}
+		}
+	}
+	else
+	{
+		for(num_ifaces = 0; num_ifaces < ifaces; num_ifaces++)
+		{
+			iface_index[num_ifaces] = FIRST_IF_INDEX + num_ifaces;
+		}
+		trace = make_storm(events, ifaces);
+		if(trace == NULL)
+		{
+			return 1;
+		}
+	}
+
+	printf("%d events, %d interfaces, %d us per handler\n", events, num_ifaces, handler_us);
+	legacy_ns = run_mode(trace, events, -1, &errors);
+	if(legacy_ns < 0 || errors != 0)
+	{
+		printf("FAIL: legacy replay did not run\n");
+		free(trace);
+		return 1;
+	}
+	printf("%-12s %10.1f ms %8.0f ns/event\n", "legacy",
+		legacy_ns / 1e6, legacy_ns / events);
+
+	for(workers = 0; workers <= max_workers; workers = workers ? workers * 2 : 1)
+	{
+		elapsed = run_mode(trace, events, workers, &errors);
+		if(workers == 0)
+		{
+			snprintf(name, sizeof(name), "table");
+		}
+		else
+		{
+			snprintf(name, sizeof(name), "workers %d", workers);
+		}
+		if(elapsed < 0)
+		{
+			printf("FAIL: %s replay did not run\n", name);
+			ret = 1;
+			continue;
+		}
+		printf("%-12s %10.1f ms %8.0f ns/event %5.2fx", name,
+			elapsed / 1e6, elapsed / events, legacy_ns / elapsed);
+		if(errors != 0)
+		{
+			printf("  FAIL: %u events out of order", errors);
+			ret = 1;
+		}
+		printf("\n");
+	}
+
+	free(trace);
+	return ret;
+}
@@ -0,0 +1,269 @@
+/*
+Copyright (c) 2017, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*
+ * Replays a synthetic link flap storm into IPACM_IfaceRegistry the way the
+ * netlink listener feeds it (RTM_NEWLINK with renames, RTM_DELLINK) mixed
+ * with the name/index/ipa index lookups the event handlers do, checks every
+ * answer against a plain model of the links, and compares the cost of a
+ * cached lookup with the SIOCGIFINDEX/SIOCGIFNAME ioctls it replaces.
+ *
+ * usage: ipacm_iface_registry_test [events]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/if.h>
+#include "IPACM_IfaceRegistry.h"
+#include "IPACM_Log.h"
+
+#define DEFAULT_EVENTS 500000
+/* synthetic links, kept below IPA_MAX_NUM_NETDEVS so none falls back to
+ * the kernel, with indexes no real interface of the host uses */
+#define TEST_LINKS 48
+#define TEST_BASE_INDEX 100000
+#define LOOKUP_LOOPS 200000
+
+typedef struct
+{
+	bool up;
+	int if_index;
+	char if_name[IF_NAME_LEN];
+	int ipa_index;
+} model_link;
+
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int fail(int evt, const char *what, model_link *link)
+{
+	printf("FAIL: event %d, %s of %s(%d)\n", evt, what, link->if_name, link->if_index);
+	return 1;
+}
+
+/* Links come and go and get renamed; every event is followed by lookups of
+ * a random link the way the handlers of the posted events do them */
+static int run_storm(int events)
+{
+	model_link links[TEST_LINKS];
+	char name[IF_NAME_LEN];
+	int cnt, idx, next_index = TEST_BASE_INDEX, renames = 0;
+	uint32_t gen;
+
+	memset(links, 0, sizeof(links));
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		model_link *link = &links[rand() % TEST_LINKS];
+		int r = rand() % 100;
+
+		if(!link->up || r < 10)
+		{
+			/* new link, or a flag change of a known one that may come
+			 * with a new name; only a new name drops the ipa index */
+			snprintf(name, sizeof(name), "tst%d_%d", (int)(link - links), rand() % 8);
+			if(!link->up)
+			{
+				link->if_index = next_index++;
+				link->ipa_index = IPA_IFACE_INDEX_UNKNOWN;
+			}
+			else if(strcmp(name, link->if_name) != 0)
+			{
+				link->ipa_index = IPA_IFACE_INDEX_UNKNOWN;
+				renames++;
+			}
+			strlcpy(link->if_name, name, sizeof(link->if_name));
+			link->up = true;
+			IPACM_IfaceRegistry::UpdateLink(link->if_index, link->if_name);
+		}
+		else if(r < 20)
+		{
+			link->up = false;
+			IPACM_IfaceRegistry::RemoveLink(link->if_index);
+			if(IPACM_IfaceRegistry::GetIpaIndex(link->if_index, NULL) != IPA_IFACE_INDEX_UNKNOWN)
+			{
+				return fail(cnt, "stale ipa index", link);
+			}
+			continue;
+		}
+		else if(r < 25)
+		{
+			IPACM_IfaceRegistry::GetIpaIndex(link->if_index, &gen);
+			link->ipa_index = rand() % 16;
+			IPACM_IfaceRegistry::SetIpaIndex(link->if_index, link->ipa_index, gen);
+		}
+		else if(r < 30)
+		{
+			/* a link message processed while the index was being
+			 * resolved, the result must not be cached */
+			IPACM_IfaceRegistry::GetIpaIndex(link->if_index, &gen);
+			IPACM_IfaceRegistry::UpdateLink(link->if_index, link->if_name);
+			IPACM_IfaceRegistry::SetIpaIndex(link->if_index, rand() % 16, gen);
+		}
+
+		if(IPACM_IfaceRegistry::GetIfName(link->if_index, name) != IPACM_SUCCESS ||
+			 strcmp(name, link->if_name) != 0)
+		{
+			return fail(cnt, "name", link);
+		}
+		if(IPACM_IfaceRegistry::GetIfIndex(link->if_name, &idx) != IPACM_SUCCESS ||
+			 idx != link->if_index)
+		{
+			return fail(cnt, "index", link);
+		}
+		if(IPACM_IfaceRegistry::GetIpaIndex(link->if_index, NULL) != link->ipa_index)
+		{
+			return fail(cnt, "ipa index", link);
+		}
+	}
+
+	/* an iface table reload forgets every ipa index */
+	IPACM_IfaceRegistry::ResetIpaIndex();
+	for(cnt = 0; cnt < TEST_LINKS; cnt++)
+	{
+		if(links[cnt].up &&
+			 IPACM_IfaceRegistry::GetIpaIndex(links[cnt].if_index, NULL) != IPA_IFACE_INDEX_UNKNOWN)
+		{
+			return fail(events, "ipa index after reset", &links[cnt]);
+		}
+	}
+
+	printf("%d link events, %d renames, %d links created\n", events, renames,
+		next_index - TEST_BASE_INDEX);
+	return 0;
+}
+
+/* What each lookup cost before: a socket and an ioctl */
+static int ioctl_name(int if_index, char *if_name)
+{
+	struct ifreq ifr;
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+	if(fd < 0)
+	{
+		return -1;
+	}
+	memset(&ifr, 0, sizeof(ifr));
+	ifr.ifr_ifindex = if_index;
+	if(ioctl(fd, SIOCGIFNAME, &ifr) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	close(fd);
+	strlcpy(if_name, ifr.ifr_name, IF_NAME_LEN);
+	return 0;
+}
+
+static int ioctl_index(const char *if_name, int *if_index)
+{
+	struct ifreq ifr;
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+	if(fd < 0)
+	{
+		return -1;
+	}
+	memset(&ifr, 0, sizeof(ifr));
+	strlcpy(ifr.ifr_name, if_name, sizeof(ifr.ifr_name));
+	if(ioctl(fd, SIOCGIFINDEX, &ifr) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	close(fd);
+	*if_index = ifr.ifr_ifindex;
+	return 0;
+}
+
+static int run_lookups(void)
+{
+	char name[IF_NAME_LEN];
+	int cnt, lo_index, idx;
+	double start, ioctl_ns, cached_ns;
+
+	/* the first lookup misses and asks the kernel */
+	if(IPACM_IfaceRegistry::GetIfIndex("lo", &lo_index) != IPACM_SUCCESS ||
+		 ioctl_index("lo", &idx) != 0 || idx != lo_index)
+	{
+		printf("no loopback interface, lookup timing skipped\n");
+		return 0;
+	}
+
+	start = now_ns();
+	for(cnt = 0; cnt < LOOKUP_LOOPS; cnt++)
+	{
+		ioctl_index("lo", &idx);
+		ioctl_name(idx, name);
+	}
+	ioctl_ns = now_ns() - start;
+
+	start = now_ns();
+	for(cnt = 0; cnt < LOOKUP_LOOPS; cnt++)
+	{
+		IPACM_IfaceRegistry::GetIfIndex("lo", &idx);
+		IPACM_IfaceRegistry::GetIfName(idx, name);
+	}
+	cached_ns = now_ns() - start;
+
+	if(idx != lo_index || strcmp(name, "lo") != 0)
+	{
+		printf("FAIL: cached loopback is %s(%d)\n", name, idx);
+		return 1;
+	}
+
+	printf("index + name lookup, ioctl:    %.0lf ns\n", ioctl_ns / LOOKUP_LOOPS);
+	printf("index + name lookup, registry: %.0lf ns\n", cached_ns / LOOKUP_LOOPS);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int events = (argc > 1) ? atoi(argv[1]) : DEFAULT_EVENTS;
+
+	if(events <= 0)
+	{
+		printf("usage: %s [events]\n", argv[0]);
+		return 1;
+	}
+
+	ipacm_log_set_level(IPACM_LOG_LEVEL_ERR);
+	srand(time(NULL));
+	if(run_storm(events) || run_lookups())
+	{
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,378 @@
+/*
+Copyright (c) 2017, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*
+ * Checks that messages formatted by the ipacm log thread match what printf
+ * would have written, from several threads at once, then runs the debug
+ * logging of a conntrack event handler over synthetic events:
+ *   - printf on the calling thread, as IPACMDBG used to do
+ *   - through the log rings with level debug
+ *   - with level error, where debug messages cost a branch
+ * and prints the average cost per conntrack event, along with the debug
+ * messages the log rings dropped because the log thread fell behind.
+ *
+ * usage: ipacm_log_bench [events]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "IPACM_Log.h"
+
+#define DEFAULT_EVENTS 200000
+#define CHECK_THREADS 4
+#define CHECK_MESSAGES 500
+#define EXPECT_LEN (1024 * 1024)
+
+/* The way IPACMDBG expanded before the log rings */
+#define LEGACY_DBG(fmt, ...) printf("%s:%d %s() " fmt, __FILE__,  __LINE__, __FUNCTION__, ##__VA_ARGS__);
+
+static char expect[EXPECT_LEN];
+static size_t expect_len;
+
+/* Logs through IPACMDBG and appends what printf would have written */
+#define CHECK_DBG(fmt, ...) do { \
+		IPACMDBG(fmt, ##__VA_ARGS__); \
+		expect_len += snprintf(expect + expect_len, EXPECT_LEN - expect_len, \
+				"%s:%d %s() " fmt, __FILE__, __LINE__, __FUNCTION__, ##__VA_ARGS__); \
+	} while (0)
+
+typedef struct
+{
+	uint32_t src_ip;
+	uint32_t dst_ip;
+	uint16_t src_port;
+	uint16_t dst_port;
+	uint8_t protocol;
+	bool add;
+} ct_event;
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Points stdout at path, returns the previous stdout */
+static int redirect_stdout(const char *path)
+{
+	int saved, fd;
+
+	fflush(stdout);
+	saved = dup(STDOUT_FILENO);
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if(saved < 0 || fd < 0)
+	{
+		return -1;
+	}
+	dup2(fd, STDOUT_FILENO);
+	close(fd);
+	return saved;
+}
+
+static void restore_stdout(int saved)
+{
+	fflush(stdout);
+	dup2(saved, STDOUT_FILENO);
+	close(saved);
+}
+
+static uint32_t fake_nat_work(const ct_event *evt)
+{
+	uint32_t hash = evt->src_ip ^ (evt->dst_ip * 31) ^
+		((uint32_t)evt->src_port << 16 | evt->dst_port) ^ evt->protocol;
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	return hash ^ (hash >> 13);
+}
+
+/* Logging of IPACM_ConntrackListener for one conntrack event */
+static uint32_t handle_event_legacy(const ct_event *evt)
+{
+	uint32_t hash;
+
+	LEGACY_DBG("Received IPA_PROCESS_CT_MESSAGE event\n");
+	LEGACY_DBG("Conntrack %s, protocol %d\n", evt->add ? "new" : "destroy", evt->protocol);
+	LEGACY_DBG("Private ip: 0x%x, port: %d\n", evt->src_ip, evt->src_port);
+	LEGACY_DBG("Target ip: 0x%x, port: %d\n", evt->dst_ip, evt->dst_port);
+	hash = fake_nat_work(evt);
+	LEGACY_DBG("Nat entry (%d) %s\n", (int)(hash & 0xfff), evt->add ? "added" : "deleted");
+	return hash;
+}
+
+static uint32_t handle_event(const ct_event *evt)
+{
+	uint32_t hash;
+
+	IPACMDBG("Received IPA_PROCESS_CT_MESSAGE event\n");
+	IPACMDBG("Conntrack %s, protocol %d\n", evt->add ? "new" : "destroy", evt->protocol);
+	IPACMDBG("Private ip: 0x%x, port: %d\n", evt->src_ip, evt->src_port);
+	IPACMDBG("Target ip: 0x%x, port: %d\n", evt->dst_ip, evt->dst_port);
+	hash = fake_nat_work(evt);
+	IPACMDBG("Nat entry (%d) %s\n", (int)(hash & 0xfff), evt->add ? "added" : "deleted");
+	return hash;
+}
+
+static void *check_thread(void *arg)
+{
+	long id = (long)arg;
+
+	for(int cnt = 0; cnt < CHECK_MESSAGES; cnt++)
+	{
+		IPACMLOG("thread %ld message %d\n", id, cnt);
+	}
+	return NULL;
+}
+
+/* Formatting of the log thread must match printf, and every thread must
+   see all of its messages out in order */
+static int check_format(const char *path)
+{
+	static char out[EXPECT_LEN];
+	pthread_t threads[CHECK_THREADS];
+	int next[CHECK_THREADS];
+	const char *name = "rmnet_data0";
+	char *line, *save;
+	FILE *fp;
+	size_t len;
+	int saved;
+	long id;
+	int msg;
+
+	saved = redirect_stdout(path);
+	if(saved < 0)
+	{
+		printf("unable to open %s\n", path);
+		return 1;
+	}
+
+	CHECK_DBG("plain message\n");
+	CHECK_DBG("%d %i %u %x %X %o\n", -42, 7, 4000000000u, 0xbeef, 0xCAFE, 8);
+	CHECK_DBG("%hhd %hd %ld %lld %llu %zu\n", (signed char)-5, (short)-300,
+			-123456789L, -9000000000LL, 18000000000000000000ULL, sizeof(ct_event));
+	CHECK_DBG("[%8s] [%-8s] [%.3s] [%*d] [%-*d] [%.*s]\n", name, "wlan0", name,
+			6, 77, 5, 12, 4, name);
+	CHECK_DBG("%c%c %5.2f %e %g %%\n", 'o', 'k', 3.14159, 1e-7, 2.5);
+	CHECK_DBG("%p %#x %+d %05d\n", (void *)&saved, 255, 9, 42);
+	CHECK_DBG("%s %s\n", "", (const char *)name);
+	CHECK_DBG("no newline, ");
+	CHECK_DBG("%d\n", 1);
+	ipacm_log_flush();
+
+	for(id = 0; id < CHECK_THREADS; id++)
+	{
+		pthread_create(&threads[id], NULL, check_thread, (void *)id);
+	}
+	for(id = 0; id < CHECK_THREADS; id++)
+	{
+		pthread_join(threads[id], NULL);
+	}
+	ipacm_log_flush();
+	restore_stdout(saved);
+
+	fp = fopen(path, "r");
+	if(fp == NULL)
+	{
+		printf("unable to read %s\n", path);
+		return 1;
+	}
+	len = fread(out, 1, sizeof(out) - 1, fp);
+	out[len] = '\0';
+	fclose(fp);
+
+	if(len < expect_len || memcmp(out, expect, expect_len) != 0)
+	{
+		printf("FAIL: formatted messages differ\nexpected:\n%s\ngot:\n%.*s\n",
+			expect, (int)expect_len, out);
+		return 1;
+	}
+
+	memset(next, 0, sizeof(next));
+	for(line = strtok_r(out + expect_len, "\n", &save); line != NULL;
+			line = strtok_r(NULL, "\n", &save))
+	{
+		if(sscanf(line, "thread %ld message %d", &id, &msg) != 2 ||
+			 id < 0 || id >= CHECK_THREADS || msg != next[id])
+		{
+			printf("FAIL: unexpected line \"%s\"\n", line);
+			return 1;
+		}
+		next[id]++;
+	}
+	for(id = 0; id < CHECK_THREADS; id++)
+	{
+		if(next[id] != CHECK_MESSAGES)
+		{
+			printf("FAIL: thread %ld logged %d of %d messages\n", id, next[id], CHECK_MESSAGES);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Sums up the drop notices of the log thread */
+static long count_dropped(const char *path)
+{
+	char line[1024];
+	long total = 0;
+	unsigned int dropped;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if(fp == NULL)
+	{
+		return -1;
+	}
+	while(fgets(line, sizeof(line), fp) != NULL)
+	{
+		if(sscanf(line, "ipacm log: dropped %u messages", &dropped) == 1)
+		{
+			total += dropped;
+		}
+	}
+	fclose(fp);
+	return total;
+}
+
+int main(int argc, char **argv)
+{
+	int events = (argc > 1) ? atoi(argv[1]) : DEFAULT_EVENTS;
+	char path[] = "/tmp/ipacm_log_bench.XXXXXX";
+	double start, legacy_ns, async_ns, drain_ns, off_ns;
+	volatile uint32_t sink = 0;
+	ct_event *storm;
+	long dropped;
+	int saved, fd, cnt;
+
+	if(events <= 0)
+	{
+		printf("usage: %s [events]\n", argv[0]);
+		return 1;
+	}
+
+	if(ipacm_log_init() < 0)
+	{
+		printf("FAIL: unable to start the log thread\n");
+		return 1;
+	}
+	ipacm_log_set_level(IPACM_LOG_LEVEL_DBG);
+
+	fd = mkstemp(path);
+	if(fd < 0)
+	{
+		printf("unable to create %s\n", path);
+		return 1;
+	}
+	close(fd);
+	if(check_format(path) != 0)
+	{
+		unlink(path);
+		return 1;
+	}
+
+	srand(time(NULL));
+	storm = (ct_event *)malloc(sizeof(ct_event) * events);
+	if(storm == NULL)
+	{
+		unlink(path);
+		return 1;
+	}
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		storm[cnt].src_ip = 0xc0a80100 | (rand() & 0xff);
+		storm[cnt].dst_ip = (uint32_t)rand();
+		storm[cnt].src_port = (uint16_t)rand();
+		storm[cnt].dst_port = (rand() & 1) ? 443 : 80;
+		storm[cnt].protocol = (rand() & 3) ? 6 : 17;
+		storm[cnt].add = (rand() & 1) != 0;
+	}
+
+	saved = redirect_stdout(path);
+	if(saved < 0)
+	{
+		free(storm);
+		unlink(path);
+		return 1;
+	}
+
+	start = now_ns();
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		sink += handle_event_legacy(&storm[cnt]);
+	}
+	fflush(stdout);
+	legacy_ns = now_ns() - start;
+	restore_stdout(saved);
+
+	saved = redirect_stdout(path);
+	if(saved < 0)
+	{
+		free(storm);
+		unlink(path);
+		return 1;
+	}
+	start = now_ns();
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		sink += handle_event(&storm[cnt]);
+	}
+	async_ns = now_ns() - start;
+	ipacm_log_flush();
+	drain_ns = now_ns() - start;
+
+	ipacm_log_set_level(IPACM_LOG_LEVEL_ERR);
+	start = now_ns();
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		sink += handle_event(&storm[cnt]);
+	}
+	off_ns = now_ns() - start;
+	ipacm_log_set_level(IPACM_LOG_LEVEL_DBG);
+
+	restore_stdout(saved);
+	dropped = count_dropped(path);
+	unlink(path);
+
+	printf("%d conntrack events, 5 debug messages each, %ld cpus\n", events,
+		sysconf(_SC_NPROCESSORS_ONLN));
+	printf("printf logging:       %.0lf ns/event\n", legacy_ns / events);
+	printf("log rings:            %.0lf ns/event (%.0lf ns/event until written)\n",
+		async_ns / events, drain_ns / events);
+	printf("debug logging off:    %.0lf ns/event\n", off_ns / events);
+	printf("dropped by log rings: %ld of %d messages\n", dropped, events * 5);
+
+	free(storm);
+	return 0;
+}
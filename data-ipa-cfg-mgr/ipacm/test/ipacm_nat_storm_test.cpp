@@ -0,0 +1,280 @@
+/*
+Copyright (c) 2017, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*
+ * Replays synthetic conntrack add/delete storms against the NAT cache
+ * lookups, once with the linear scan of the cache array that NatApp used to
+ * do and once with NatCacheIndex, checks that both agree and prints the
+ * average cost per conntrack event.
+ *
+ * usage: ipacm_nat_storm_test [max_entries] [events]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <netinet/in.h>
+#include "IPACM_Conntrack_NATIndex.h"
+
+#define DEFAULT_MAX_ENTRIES 4096
+#define DEFAULT_EVENTS 200000
+
+/* NAT cache lookups the way NatApp::ChkForDup/AddEntry/DeleteEntry did them */
+class LinearCache
+{
+public:
+	nat_table_entry *cache;
+	int max_entries;
+
+	LinearCache(int entries)
+	{
+		max_entries = entries;
+		cache = (nat_table_entry *)calloc(entries, sizeof(nat_table_entry));
+	}
+	~LinearCache()
+	{
+		free(cache);
+	}
+	int Find(const nat_table_entry *rule)
+	{
+		for(int cnt = 0; cnt < max_entries; cnt++)
+		{
+			if(cache[cnt].private_ip == rule->private_ip &&
+				 cache[cnt].target_ip == rule->target_ip &&
+				 cache[cnt].private_port ==  rule->private_port  &&
+				 cache[cnt].target_port == rule->target_port &&
+				 cache[cnt].protocol == rule->protocol)
+			{
+				return cnt;
+			}
+		}
+		return -1;
+	}
+	int Add(const nat_table_entry *rule)
+	{
+		int cnt;
+		if(Find(rule) >= 0)
+		{
+			return -1;
+		}
+		for(cnt = 0; cnt < max_entries; cnt++)
+		{
+			if(cache[cnt].private_ip == 0 &&
+				 cache[cnt].target_ip == 0 &&
+				 cache[cnt].private_port == 0  &&
+				 cache[cnt].target_port == 0 &&
+				 cache[cnt].protocol == 0)
+			{
+				break;
+			}
+		}
+		if(cnt == max_entries)
+		{
+			return -1;
+		}
+		cache[cnt] = *rule;
+		return cnt;
+	}
+	int Delete(const nat_table_entry *rule)
+	{
+		int cnt = Find(rule);
+		if(cnt >= 0)
+		{
+			memset(&cache[cnt], 0, sizeof(cache[cnt]));
+		}
+		return cnt;
+	}
+};
+
+/* The same operations on top of NatCacheIndex, as NatApp does them now */
+class IndexedCache
+{
+public:
+	nat_table_entry *cache;
+	NatCacheIndex index;
+
+	IndexedCache(int entries)
+	{
+		cache = (nat_table_entry *)calloc(entries, sizeof(nat_table_entry));
+		index.Init(cache, entries);
+	}
+	~IndexedCache()
+	{
+		free(cache);
+	}
+	int Add(const nat_table_entry *rule)
+	{
+		int cnt;
+		if(index.Find(rule) >= 0)
+		{
+			return -1;
+		}
+		cnt = index.AllocSlot();
+		if(cnt < 0)
+		{
+			return -1;
+		}
+		cache[cnt] = *rule;
+		index.Insert(cnt);
+		return cnt;
+	}
+	int Delete(const nat_table_entry *rule)
+	{
+		int cnt = index.Find(rule);
+		if(cnt >= 0)
+		{
+			index.Remove(cnt);
+			memset(&cache[cnt], 0, sizeof(cache[cnt]));
+			index.FreeSlot(cnt);
+		}
+		return cnt;
+	}
+};
+
+typedef struct
+{
+	bool add;
+	nat_table_entry rule;
+} storm_event;
+
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void random_conn(nat_table_entry *rule)
+{
+	memset(rule, 0, sizeof(*rule));
+	/* tethered clients in 192.168.225.0/24 talking to random servers */
+	rule->private_ip = 0xC0A8E100 | (1 + rand() % 254);
+	rule->target_ip = ((uint32_t)rand() << 1) | 1;
+	rule->private_port = 1024 + rand() % 60000;
+	rule->target_port = (rand() & 1) ? 443 : (1 + rand() % 65535);
+	rule->protocol = (rand() & 1) ? IPPROTO_TCP : IPPROTO_UDP;
+}
+
+/* A storm mostly keeps the cache near full: a new connection is created for
+ * every one that is destroyed, with occasional bursts of either kind and
+ * duplicate new events, as conntrack sends them for retransmitted SYNs. */
+static storm_event *make_storm(int max_entries, int events)
+{
+	storm_event *storm = (storm_event *)calloc(events, sizeof(storm_event));
+	nat_table_entry *live = (nat_table_entry *)calloc(max_entries, sizeof(nat_table_entry));
+	int nlive = 0, cnt;
+
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		int r = rand() % 100;
+		if(nlive > 0 && (nlive == max_entries || r < 45))
+		{
+			int k = rand() % nlive;
+			storm[cnt].add = false;
+			storm[cnt].rule = live[k];
+			live[k] = live[--nlive];
+		}
+		else if(nlive > 0 && r < 50)
+		{
+			storm[cnt].add = true;
+			storm[cnt].rule = live[rand() % nlive];
+		}
+		else
+		{
+			storm[cnt].add = true;
+			random_conn(&storm[cnt].rule);
+			live[nlive++] = storm[cnt].rule;
+		}
+	}
+
+	free(live);
+	return storm;
+}
+
+int main(int argc, char **argv)
+{
+	int max_entries = (argc > 1) ? atoi(argv[1]) : DEFAULT_MAX_ENTRIES;
+	int events = (argc > 2) ? atoi(argv[2]) : DEFAULT_EVENTS;
+	storm_event *storm;
+	LinearCache *linear;
+	IndexedCache *indexed;
+	int *linear_res, *indexed_res;
+	double start, linear_ns, indexed_ns;
+	int cnt;
+
+	if(max_entries <= 0 || events <= 0)
+	{
+		printf("usage: %s [max_entries] [events]\n", argv[0]);
+		return 1;
+	}
+
+	srand(time(NULL));
+	storm = make_storm(max_entries, events);
+	linear = new LinearCache(max_entries);
+	indexed = new IndexedCache(max_entries);
+	linear_res = (int *)malloc(sizeof(int) * events);
+	indexed_res = (int *)malloc(sizeof(int) * events);
+
+	start = now_ns();
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		linear_res[cnt] = storm[cnt].add ? linear->Add(&storm[cnt].rule) :
+			linear->Delete(&storm[cnt].rule);
+	}
+	linear_ns = now_ns() - start;
+
+	start = now_ns();
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		indexed_res[cnt] = storm[cnt].add ? indexed->Add(&storm[cnt].rule) :
+			indexed->Delete(&storm[cnt].rule);
+	}
+	indexed_ns = now_ns() - start;
+
+	/* slots may differ, but every event must have the same outcome */
+	for(cnt = 0; cnt < events; cnt++)
+	{
+		if((linear_res[cnt] < 0) != (indexed_res[cnt] < 0))
+		{
+			printf("FAIL: event %d (%s) linear %d, indexed %d\n", cnt,
+				storm[cnt].add ? "new" : "destroy", linear_res[cnt], indexed_res[cnt]);
+			return 1;
+		}
+	}
+
+	printf("%d entries, %d conntrack events\n", max_entries, events);
+	printf("linear scan: %.0lf ns/event\n", linear_ns / events);
+	printf("hash index:  %.0lf ns/event\n", indexed_ns / events);
+
+	free(linear_res);
+	free(indexed_res);
+	delete linear;
+	delete indexed;
+	free(storm);
+	return 0;
+}
@@ -0,0 +1,315 @@
+/*
+Copyright (c) 2017, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*
+ * Feeds bursts of synthetic RTM_NEWNEIGH/RTM_DELNEIGH datagrams, some
+ * carrying two messages, through ipa_nl_recv_msg over a pair of netlink
+ * sockets, and checks that the events it posts are the ones left after
+ * dropping each neighbor update the next update of the same address
+ * repeats. Then prints the cost per datagram when every datagram is read
+ * on its own and when bursts of IPA_NL_BATCH_SIZE are read together.
+ *
+ * usage: ipacm_nl_batch_test [bursts]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/neighbour.h>
+#include <net/if.h>
+#include "IPACM_Netlink.h"
+#include "IPACM_EvtDispatcher.h"
+#include "IPACM_Log.h"
+
+#define DEFAULT_BURSTS 20000
+#define TEST_ADDRS 6
+#define MAX_POSTED (IPA_NL_BATCH_SIZE * 2)
+
+typedef struct
+{
+	int type;	/* RTM_NEWNEIGH or RTM_DELNEIGH */
+	uint32_t addr;
+	uint8_t mac[IPA_MAC_ADDR_SIZE];
+} neigh_update;
+
+typedef struct
+{
+	int event;
+	uint32_t addr;
+	uint8_t mac[IPA_MAC_ADDR_SIZE];
+} posted_event;
+
+/* Events ipa_nl_recv_msg posts end up here instead of the command queue */
+static posted_event posted[MAX_POSTED];
+static int num_posted;
+
+int IPACM_EvtDispatcher::PostEvt(ipacm_cmd_q_data *data)
+{
+	ipacm_event_data_all *data_all = (ipacm_event_data_all *)data->evt_data;
+
+	if(num_posted < MAX_POSTED)
+	{
+		posted[num_posted].event = data->event;
+		posted[num_posted].addr = data_all->ipv4_addr;
+		memcpy(posted[num_posted].mac, data_all->mac_addr, IPA_MAC_ADDR_SIZE);
+	}
+	num_posted++;
+	free(data->evt_data);
+	return IPACM_SUCCESS;
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int open_nl(uint32_t *pid)
+{
+	struct sockaddr_nl addr;
+	socklen_t len = sizeof(addr);
+	int fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+
+	if(fd < 0)
+	{
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+		 getsockname(fd, (struct sockaddr *)&addr, &len) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	*pid = addr.nl_pid;
+	return fd;
+}
+
+static void add_attr(struct nlmsghdr *nlh, int type, const void *data, int len)
+{
+	struct rtattr *rta = (struct rtattr *)((char *)nlh + NLMSG_ALIGN(nlh->nlmsg_len));
+
+	rta->rta_type = type;
+	rta->rta_len = RTA_LENGTH(len);
+	memcpy(RTA_DATA(rta), data, len);
+	nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+}
+
+/* Appends a neighbor message for the loopback interface at buf + off */
+static int put_neigh(char *buf, int off, int if_index, const neigh_update *upd)
+{
+	struct nlmsghdr *nlh = (struct nlmsghdr *)(buf + off);
+	struct ndmsg *ndm;
+	uint32_t addr = htonl(upd->addr);
+
+	memset(nlh, 0, NLMSG_SPACE(sizeof(struct ndmsg)));
+	nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
+	nlh->nlmsg_type = upd->type;
+	ndm = (struct ndmsg *)NLMSG_DATA(nlh);
+	ndm->ndm_family = AF_INET;
+	ndm->ndm_ifindex = if_index;
+	ndm->ndm_state = NUD_REACHABLE;
+	add_attr(nlh, NDA_DST, &addr, sizeof(addr));
+	add_attr(nlh, NDA_LLADDR, upd->mac, IPA_MAC_ADDR_SIZE);
+	return off + NLMSG_ALIGN(nlh->nlmsg_len);
+}
+
+/* Most updates repeat the state of a few clients, some move a client to
+ * another MAC or delete it */
+static void random_update(neigh_update *upd)
+{
+	int client = rand() % TEST_ADDRS;
+
+	memset(upd, 0, sizeof(*upd));
+	upd->type = (rand() % 5) ? RTM_NEWNEIGH : RTM_DELNEIGH;
+	upd->addr = 0xC0A8E100 | (client + 2);
+	upd->mac[0] = 0x02;
+	upd->mac[5] = client;
+	if(rand() % 8 == 0)
+	{
+		upd->mac[4] = 1;
+	}
+}
+
+/* The events a burst must leave after coalescing */
+static int expected_events(const neigh_update *upd, int num, posted_event *exp)
+{
+	int i, j, n = 0;
+
+	for(i = 0; i < num; i++)
+	{
+		for(j = i + 1; j < num && upd[j].addr != upd[i].addr; j++);
+		if(j < num && upd[j].type == upd[i].type &&
+			 memcmp(upd[j].mac, upd[i].mac, IPA_MAC_ADDR_SIZE) == 0)
+		{
+			continue;
+		}
+		exp[n].event = (upd[i].type == RTM_NEWNEIGH) ? IPA_NEW_NEIGH_EVENT : IPA_DEL_NEIGH_EVENT;
+		exp[n].addr = upd[i].addr;
+		memcpy(exp[n].mac, upd[i].mac, IPA_MAC_ADDR_SIZE);
+		n++;
+	}
+	return n;
+}
+
+/* Sends a burst of datagrams, a third of them with two updates, and has
+ * ipa_nl_recv_msg read them per read_every datagrams */
+static int run_burst(int tx, int rx, uint32_t rx_pid, int if_index,
+	neigh_update *upd, int read_every, bool check)
+{
+	char buf[IPA_NL_MSG_MAX_LEN];
+	struct sockaddr_nl dst;
+	posted_event exp[MAX_POSTED];
+	int dgram, num_upd = 0, off, n, i;
+
+	memset(&dst, 0, sizeof(dst));
+	dst.nl_family = AF_NETLINK;
+	dst.nl_pid = rx_pid;
+	num_posted = 0;
+
+	for(dgram = 0; dgram < IPA_NL_BATCH_SIZE; dgram++)
+	{
+		off = 0;
+		n = (check && rand() % 3 == 0) ? 2 : 1;
+		for(i = 0; i < n; i++)
+		{
+			off = put_neigh(buf, off, if_index, &upd[num_upd++]);
+		}
+		if(sendto(tx, buf, off, 0, (struct sockaddr *)&dst, sizeof(dst)) != off)
+		{
+			perror("sendto");
+			return -1;
+		}
+		if((dgram + 1) % read_every == 0)
+		{
+			ipa_nl_recv_msg(rx);
+		}
+	}
+	if(!check)
+	{
+		return 0;
+	}
+
+	n = expected_events(upd, num_upd, exp);
+	if(n != num_posted)
+	{
+		printf("FAIL: %d updates posted %d events, expected %d\n", num_upd, num_posted, n);
+		return -1;
+	}
+	for(i = 0; i < n; i++)
+	{
+		if(posted[i].event != exp[i].event || posted[i].addr != exp[i].addr ||
+			 memcmp(posted[i].mac, exp[i].mac, IPA_MAC_ADDR_SIZE) != 0)
+		{
+			printf("FAIL: event %d is %d for 0x%x, expected %d for 0x%x\n", i,
+				posted[i].event, posted[i].addr, exp[i].event, exp[i].addr);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int bursts = (argc > 1) ? atoi(argv[1]) : DEFAULT_BURSTS;
+	neigh_update upd[IPA_NL_BATCH_SIZE * 2];
+	ipa_nl_batch_stats_t stats;
+	uint32_t tx_pid, rx_pid;
+	int tx, rx, if_index, cnt, i;
+	double start, single_ns, batch_ns;
+
+	if(bursts <= 0)
+	{
+		printf("usage: %s [bursts]\n", argv[0]);
+		return 1;
+	}
+
+	ipacm_log_set_level(IPACM_LOG_LEVEL_ERR);
+	srand(time(NULL));
+	if_index = if_nametoindex("lo");
+	tx = open_nl(&tx_pid);
+	rx = open_nl(&rx_pid);
+	if(if_index <= 0 || tx < 0 || rx < 0)
+	{
+		printf("no netlink sockets or loopback interface, test skipped\n");
+		return 0;
+	}
+
+	for(cnt = 0; cnt < bursts / 10 + 1; cnt++)
+	{
+		for(i = 0; i < IPA_NL_BATCH_SIZE * 2; i++)
+		{
+			random_update(&upd[i]);
+		}
+		if(run_burst(tx, rx, rx_pid, if_index, upd, IPA_NL_BATCH_SIZE, true))
+		{
+			return 1;
+		}
+	}
+
+	/* every update distinct, so the timed runs post the same events */
+	for(i = 0; i < IPA_NL_BATCH_SIZE; i++)
+	{
+		random_update(&upd[i]);
+		upd[i].type = RTM_NEWNEIGH;
+		upd[i].addr = 0x0A000000 | i;
+	}
+
+	start = now_ns();
+	for(cnt = 0; cnt < bursts; cnt++)
+	{
+		run_burst(tx, rx, rx_pid, if_index, upd, 1, false);
+	}
+	single_ns = now_ns() - start;
+
+	start = now_ns();
+	for(cnt = 0; cnt < bursts; cnt++)
+	{
+		run_burst(tx, rx, rx_pid, if_index, upd, IPA_NL_BATCH_SIZE, false);
+	}
+	batch_ns = now_ns() - start;
+
+	ipa_nl_get_batch_stats(&stats);
+	printf("%u batches, %u datagrams, %u messages, %u neighbor updates coalesced, "
+		"%u dropped, largest batch %u\n", stats.batches, stats.datagrams,
+		stats.messages, stats.neigh_coalesced, stats.dropped, stats.max_batch);
+	printf("send + receive, one datagram per read:     %.0lf ns/datagram\n",
+		single_ns / bursts / IPA_NL_BATCH_SIZE);
+	printf("send + receive, %d datagrams per read:     %.0lf ns/datagram\n",
+		IPA_NL_BATCH_SIZE, batch_ns / bursts / IPA_NL_BATCH_SIZE);
+
+	close(tx);
+	close(rx);
+	return 0;
+}
@@ -112,6 +112,42 @@ int ipa_nat_add_ipv4_rule(uint32_t table_handle,
 int ipa_nat_del_ipv4_rule(uint32_t table_handle,
 				uint32_t rule_handle);
 
+/**
+ * ipa_nat_batch_begin() - start batching ipv4 rule additions
+ * @table_handle: [in] handle of ipv4 nat table
+ *
+ * Until ipa_nat_batch_commit() is called, ipa_nat_add_ipv4_rule() on
+ * this table from the calling thread writes the new rules into the
+ * table but only queues the DMA commands that link and enable them,
+ * instead of posting one IPA_IOC_NAT_DMA ioctl per command. Deleting a
+ * rule, or adding one from another thread, posts the queued commands
+ * first.
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_batch_begin(uint32_t table_handle);
+
+/**
+ * ipa_nat_batch_commit() - post the batched ipv4 rule additions
+ * @table_handle: [in] handle of ipv4 nat table
+ * @failed_handles: [out] handles of the rules that could not be enabled
+ * @max_failed: [in] number of handles failed_handles can hold, at least
+ *	the number of rules added in the batch
+ * @num_failed: [out] number of handles written to failed_handles
+ *
+ * Posts the DMA commands queued since ipa_nat_batch_begin() in as few
+ * IPA_IOC_NAT_DMA ioctls as the command size allows, and ends the batch.
+ * The rules added in the batch are active in hw only once this returns.
+ * If the ioctl fails, the commands are posted one by one. Rules that
+ * still could not be enabled are returned in failed_handles, their
+ * handles are no longer valid, as if ipa_nat_add_ipv4_rule() had failed.
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_batch_commit(uint32_t table_handle,
+				uint32_t *failed_handles,
+				uint32_t max_failed,
+				uint32_t *num_failed);
 
 /**
  * ipa_nat_query_timestamp() - to query timestamp
@@ -352,6 +352,30 @@ struct ipa_nat_cache {
 	enum ipa_hw_type ver;
 };
 
+/* ipa_ioc_nat_dma_cmd.entries is 8 bits wide */
+#define IPA_NAT_DMA_BATCH_MAX_ENTRIES 255
+
+/* queued dma command that does not enable a rule entry */
+#define IPA_NAT_DMA_BATCH_NO_ENTRY 0xFFFF
+
+/* DMA writes of rule additions queued between ipa_nati_batch_begin()
+   and ipa_nati_batch_commit() by the thread that began the batch, all
+   accesses are under nat_mutex */
+struct ipa_nat_dma_batch {
+	uint8_t active;
+	uint8_t tbl_indx;
+	pthread_t owner;
+	struct ipa_ioc_nat_dma_cmd *cmd;
+	/* per queued command, the rule entry it enables or IPA_NAT_DMA_BATCH_NO_ENTRY */
+	uint16_t cmd_entry[IPA_NAT_DMA_BATCH_MAX_ENTRIES];
+	/* per base and expansion table entry, set while its enable bit is queued */
+	uint8_t *enable_pending;
+	uint32_t total_entries;
+	/* handles of the rules whose enable bit could not be posted */
+	uint32_t *failed_hdls;
+	uint32_t failed_cnt;
+};
+
 struct ipa_nat_indx_tbl_sw_rule {
 	uint16_t tbl_entry;
 	uint16_t next_index;
@@ -474,6 +498,25 @@ int ipa_nati_post_ipv4_dma_cmd(uint8_t tbl_indx,
 int ipa_nati_del_ipv4_rule(uint32_t tbl_hdl,
 				uint32_t rule_hdl);
 
+int ipa_nati_batch_begin(uint32_t tbl_hdl);
+int ipa_nati_batch_commit(uint32_t tbl_hdl,
+				uint32_t *failed_hdls,
+				uint32_t max_failed,
+				uint32_t *num_failed);
+int ipa_nati_batch_flush(void);
+void ipa_nati_batch_queue(uint8_t tbl_indx,
+				uint8_t base_addr,
+				uint32_t offset,
+				uint16_t data,
+				uint16_t tbl_entry);
+uint8_t ipa_nati_batch_owned(uint8_t tbl_indx);
+uint8_t ipa_nati_batch_enable_pending(const char *tbl_addr,
+				uint16_t entry);
+uint16_t ipa_nati_batch_next_index(struct ipa_nat_ip4_table_cache *cache_ptr,
+				nat_table_type tbl_type,
+				uint16_t entry,
+				uint16_t value);
+
 int ipa_nati_post_del_dma_cmd(uint8_t tbl_indx,
 				uint16_t tbl_entry,
 				uint8_t expn_tbl,
@@ -146,6 +146,52 @@ int ipa_nat_del_ipv4_rule(uint32_t tbl_hdl,
   return 0;
 }
 
+/**
+ * ipa_nat_batch_begin() - start batching ipv4 rule additions
+ * @table_handle: [in] handle of ipv4 nat table
+ *
+ * Queue the DMA commands of ipa_nat_add_ipv4_rule() on this
+ * table until ipa_nat_batch_commit()
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_batch_begin(uint32_t tbl_hdl)
+{
+  if (IPA_NAT_INVALID_NAT_ENTRY == tbl_hdl ||
+      tbl_hdl > IPA_NAT_MAX_IP4_TBLS) {
+    IPAERR("invalid table handle passed \n");
+    return -EINVAL;
+  }
+  IPADBG("Passed Table Handle: 0x%x\n", tbl_hdl);
+
+  return ipa_nati_batch_begin(tbl_hdl);
+}
+
+/**
+ * ipa_nat_batch_commit() - post the batched ipv4 rule additions
+ * @table_handle: [in] handle of ipv4 nat table
+ *
+ * Post the DMA commands queued since ipa_nat_batch_begin(),
+ * and return the handles of the rules that could not be enabled
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_batch_commit(uint32_t tbl_hdl,
+		uint32_t *failed_hdls,
+		uint32_t max_failed,
+		uint32_t *num_failed)
+{
+  if (IPA_NAT_INVALID_NAT_ENTRY == tbl_hdl ||
+      tbl_hdl > IPA_NAT_MAX_IP4_TBLS || NULL == num_failed ||
+      (NULL == failed_hdls && max_failed != 0)) {
+    IPAERR("invalid parameters\n");
+    return -EINVAL;
+  }
+  IPADBG("Passed Table Handle: 0x%x\n", tbl_hdl);
+
+  return ipa_nati_batch_commit(tbl_hdl, failed_hdls, max_failed, num_failed);
+}
+
 /**
  * ipa_nat_query_timestamp() - to query timestamp
  * @table_handle: [in] handle of ipv4 nat table
@@ -50,6 +50,7 @@ struct ipa_nat_cache ipv4_nat_cache;
 pthread_mutex_t nat_mutex    = PTHREAD_MUTEX_INITIALIZER;
 
 static ipa_nat_pdn_entry pdns[IPA_MAX_PDN_NUM];
+static struct ipa_nat_dma_batch nat_batch;
 
 /* ------------------------------------------
 		UTILITY FUNCTIONS START
@@ -998,6 +999,14 @@ int ipa_nati_del_ipv4_table(uint32_t tbl_hdl)
 	free(ipv4_nat_cache.ip4_tbl[index].index_expn_table_meta);
 	free(ipv4_nat_cache.ip4_tbl[index].rule_id_array);
 
+	/* nothing left to post the queued commands to */
+	if (nat_batch.active && nat_batch.tbl_indx == index) {
+		free(nat_batch.cmd);
+		free(nat_batch.enable_pending);
+		free(nat_batch.failed_hdls);
+		memset(&nat_batch, 0, sizeof(nat_batch));
+	}
+
 	memset(&ipv4_nat_cache.ip4_tbl[index],
 				 0,
 				 sizeof(ipv4_nat_cache.ip4_tbl[index]));
@@ -1096,6 +1105,8 @@ int ipa_nati_add_ipv4_rule(uint32_t tbl_hdl,
 	struct ipa_nat_sw_rule sw_rule;
 	struct ipa_nat_indx_tbl_sw_rule index_sw_rule;
 	uint16_t new_entry, new_index_tbl_entry;
+	uint8_t tbl_indx = (uint8_t)(tbl_hdl - 1);
+	int ret = 0;
 
 	/* verify that the rule's PDN is valid */
 	if (clnt_rule->pdn_index >= IPA_MAX_PDN_NUM ||
@@ -1108,12 +1119,25 @@ int ipa_nati_add_ipv4_rule(uint32_t tbl_hdl,
 	memset(&sw_rule, 0, sizeof(sw_rule));
 	memset(&index_sw_rule, 0, sizeof(index_sw_rule));
 
+	if (pthread_mutex_lock(&nat_mutex) != 0) {
+		IPAERR("unable to lock the nat mutex\n");
+		return -1;
+	}
+
+	/* a batch another thread began on this table is posted first, this
+	   rule is posted right away */
+	if (nat_batch.active && nat_batch.tbl_indx == tbl_indx &&
+			!ipa_nati_batch_owned(tbl_indx)) {
+		ipa_nati_batch_flush();
+	}
+
 	/* Generate rule from client input */
 	if (ipa_nati_generate_rule(tbl_hdl, clnt_rule,
 					&sw_rule, &index_sw_rule,
 					&new_entry, &new_index_tbl_entry)) {
 		IPAERR("unable to generate rule\n");
-		return -EINVAL;
+		ret = -EINVAL;
+		goto unlock;
 	}
 
 	tbl_ptr = &ipv4_nat_cache.ip4_tbl[tbl_hdl-1];
@@ -1126,21 +1150,29 @@ int ipa_nati_add_ipv4_rule(uint32_t tbl_hdl,
 	IPADBG("new entry:%d, new index entry: %d\n", new_entry, new_index_tbl_entry);
 	if (ipa_nati_post_ipv4_dma_cmd((uint8_t)(tbl_hdl - 1), new_entry)) {
 		IPAERR("unable to post dma command\n");
-		return -EIO;
+		ret = -EIO;
+		goto unlock;
 	}
 
 	/* Generate rule handle */
 	*rule_hdl  = ipa_nati_make_rule_hdl((uint16_t)tbl_hdl, new_entry);
 	if (!(*rule_hdl)) {
 		IPAERR("unable to generate rule handle\n");
-		return -EINVAL;
+		ret = -EINVAL;
+		goto unlock;
 	}
 
 #ifdef NAT_DUMP
 	ipa_nat_dump_ipv4_table(tbl_hdl);
 #endif
 
-	return 0;
+unlock:
+	if (pthread_mutex_unlock(&nat_mutex) != 0) {
+		IPAERR("unable to unlock the nat mutex\n");
+		return -1;
+	}
+
+	return ret;
 }
 
 int ipa_nati_generate_rule(uint32_t tbl_hdl,
@@ -1248,27 +1280,29 @@ uint16_t ipa_nati_generate_tbl_rule(const ipa_nat_ipv4_rule *clnt_rule,
 	/* check whether there is any collision
 		 if no collision return */
 	if (!Read16BitFieldValue(tbl[new_entry].ip_cksm_enbl,
-													 ENABLE_FIELD)) {
+													 ENABLE_FIELD) &&
+			!ipa_nati_batch_enable_pending((char *)tbl, new_entry)) {
 		sw_rule->prev_index = 0;
 		IPADBG("Destination Nat New Entry Index %d\n", new_entry);
 		return new_entry;
 	}
 
+	nxt_indx = ipa_nati_batch_next_index(tbl_ptr, IPA_NAT_BASE_TBL, new_entry,
+			Read16BitFieldValue(tbl[new_entry].nxt_indx_pub_port,
+													NEXT_INDEX_FIELD));
+
 	/* First collision */
-	if (Read16BitFieldValue(tbl[new_entry].nxt_indx_pub_port,
-													NEXT_INDEX_FIELD) == IPA_NAT_INVALID_NAT_ENTRY) {
+	if (nxt_indx == IPA_NAT_INVALID_NAT_ENTRY) {
 		sw_rule->prev_index = new_entry;
 	} else { /* check for more than one collision	*/
 		/* Find the IPA_NAT_DEL_TYPE_LAST entry in list */
-		nxt_indx = Read16BitFieldValue(tbl[new_entry].nxt_indx_pub_port,
-																	 NEXT_INDEX_FIELD);
-
 		while (nxt_indx != IPA_NAT_INVALID_NAT_ENTRY) {
 			prev = nxt_indx;
 
 			nxt_indx -= tbl_ptr->table_entries;
-			nxt_indx = Read16BitFieldValue(expn_tbl[nxt_indx].nxt_indx_pub_port,
-																		 NEXT_INDEX_FIELD);
+			nxt_indx = ipa_nati_batch_next_index(tbl_ptr, IPA_NAT_EXPN_TBL, nxt_indx,
+					Read16BitFieldValue(expn_tbl[nxt_indx].nxt_indx_pub_port,
+																		 NEXT_INDEX_FIELD));
 
 			/* Handling error case */
 			if (prev == nxt_indx) {
@@ -1305,7 +1339,8 @@ uint16_t ipa_nati_expn_tbl_free_entry(struct ipa_nat_rule *expn_tbl,
 
 	for (cnt = 1; cnt < size; cnt++) {
 		if (!Read16BitFieldValue(expn_tbl[cnt].ip_cksm_enbl,
-														 ENABLE_FIELD)) {
+														 ENABLE_FIELD) &&
+				!ipa_nati_batch_enable_pending((char *)expn_tbl, cnt)) {
 			IPADBG("new expansion table entry index %d\n", cnt);
 			return cnt;
 		}
@@ -1343,22 +1378,23 @@ uint16_t ipa_nati_generate_index_rule(const ipa_nat_ipv4_rule *clnt_rule,
 		return new_entry;
 	}
 
+	nxt_indx = ipa_nati_batch_next_index(tbl_ptr, IPA_NAT_INDX_TBL, new_entry,
+			Read16BitFieldValue(indx_tbl[new_entry].tbl_entry_nxt_indx,
+													INDX_TBL_NEXT_INDEX_FILED));
+
 	/* check for more than one collision	*/
-	if (Read16BitFieldValue(indx_tbl[new_entry].tbl_entry_nxt_indx,
-													INDX_TBL_NEXT_INDEX_FILED) == IPA_NAT_INVALID_NAT_ENTRY) {
+	if (nxt_indx == IPA_NAT_INVALID_NAT_ENTRY) {
 		sw_rule->prev_index = new_entry;
 		IPADBG("First collosion. Entry %d\n", new_entry);
 	} else {
 		/* Find the IPA_NAT_DEL_TYPE_LAST entry in list */
-		nxt_indx = Read16BitFieldValue(indx_tbl[new_entry].tbl_entry_nxt_indx,
-																	 INDX_TBL_NEXT_INDEX_FILED);
-
 		while (nxt_indx != IPA_NAT_INVALID_NAT_ENTRY) {
 			prev = nxt_indx;
 
 			nxt_indx -= tbl_ptr->table_entries;
-			nxt_indx = Read16BitFieldValue(indx_expn_tbl[nxt_indx].tbl_entry_nxt_indx,
-																		 INDX_TBL_NEXT_INDEX_FILED);
+			nxt_indx = ipa_nati_batch_next_index(tbl_ptr, IPA_NAT_INDEX_EXPN_TBL, nxt_indx,
+					Read16BitFieldValue(indx_expn_tbl[nxt_indx].tbl_entry_nxt_indx,
+																		 INDX_TBL_NEXT_INDEX_FILED));
 
 			/* Handling error case */
 			if (prev == nxt_indx) {
@@ -1422,6 +1458,12 @@ void ipa_nati_write_next_index(uint8_t tbl_indx,
 	IPADBG("Updating next index field of table %d on collosion using dma\n", tbl_type);
 	IPADBG("table index: %d, value: %d offset;%d\n", tbl_indx, value, offset);
 
+	if (ipa_nati_batch_owned(tbl_indx)) {
+		ipa_nati_batch_queue(tbl_indx, tbl_type, offset, value,
+			IPA_NAT_DMA_BATCH_NO_ENTRY);
+		return;
+	}
+
 	cmd = (struct ipa_ioc_nat_dma_cmd *)
 	malloc(sizeof(struct ipa_ioc_nat_dma_cmd)+
 				 sizeof(struct ipa_ioc_nat_dma_one));
@@ -1550,41 +1592,53 @@ int ipa_nati_post_ipv4_dma_cmd(uint8_t tbl_indx,
 {
 	struct ipa_ioc_nat_dma_cmd *cmd;
 	struct ipa_nat_rule *tbl_ptr;
+	struct ipa_ioc_nat_dma_one dma;
 	uint32_t offset = ipv4_nat_cache.ip4_tbl[tbl_indx].tbl_addr_offset;
+	uint16_t tbl_entry = entry;
 	int ret = 0;
 
-	cmd = (struct ipa_ioc_nat_dma_cmd *)
-	malloc(sizeof(struct ipa_ioc_nat_dma_cmd)+
-				 sizeof(struct ipa_ioc_nat_dma_one));
-	if (NULL == cmd) {
-		IPAERR("unable to allocate memory\n");
-		return -ENOMEM;
-	}
-
 	if (entry < ipv4_nat_cache.ip4_tbl[tbl_indx].table_entries) {
 		tbl_ptr =
 			 (struct ipa_nat_rule *)ipv4_nat_cache.ip4_tbl[tbl_indx].ipv4_rules_addr;
 
-		cmd->dma[0].table_index = tbl_indx;
-		cmd->dma[0].base_addr = IPA_NAT_BASE_TBL;
-		cmd->dma[0].data = IPA_NAT_FLAG_ENABLE_BIT_MASK;
+		dma.table_index = tbl_indx;
+		dma.base_addr = IPA_NAT_BASE_TBL;
+		dma.data = IPA_NAT_FLAG_ENABLE_BIT_MASK;
 
-		cmd->dma[0].offset = (char *)&tbl_ptr[entry] - (char *)tbl_ptr;
-		cmd->dma[0].offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
+		dma.offset = (char *)&tbl_ptr[entry] - (char *)tbl_ptr;
+		dma.offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
 	} else {
 		tbl_ptr =
 			 (struct ipa_nat_rule *)ipv4_nat_cache.ip4_tbl[tbl_indx].ipv4_expn_rules_addr;
 		entry = entry - ipv4_nat_cache.ip4_tbl[tbl_indx].table_entries;
 
-		cmd->dma[0].table_index = tbl_indx;
-		cmd->dma[0].base_addr = IPA_NAT_EXPN_TBL;
-		cmd->dma[0].data = IPA_NAT_FLAG_ENABLE_BIT_MASK;
+		dma.table_index = tbl_indx;
+		dma.base_addr = IPA_NAT_EXPN_TBL;
+		dma.data = IPA_NAT_FLAG_ENABLE_BIT_MASK;
+
+		dma.offset = (char *)&tbl_ptr[entry] - (char *)tbl_ptr;
+		dma.offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
+		dma.offset += offset;
+	}
+
+	if (ipa_nati_batch_owned(tbl_indx)) {
+		ipa_nati_batch_queue(tbl_indx, dma.base_addr, dma.offset, dma.data,
+			tbl_entry);
+		nat_batch.enable_pending[tbl_entry] = 1;
+		IPADBG("queued enable of entry %d, %d dma commands queued\n",
+			tbl_entry, nat_batch.cmd->entries);
+		return 0;
+	}
 
-		cmd->dma[0].offset = (char *)&tbl_ptr[entry] - (char *)tbl_ptr;
-		cmd->dma[0].offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
-		cmd->dma[0].offset += offset;
+	cmd = (struct ipa_ioc_nat_dma_cmd *)
+	malloc(sizeof(struct ipa_ioc_nat_dma_cmd)+
+				 sizeof(struct ipa_ioc_nat_dma_one));
+	if (NULL == cmd) {
+		IPAERR("unable to allocate memory\n");
+		return -ENOMEM;
 	}
 
+	cmd->dma[0] = dma;
 	cmd->entries = 1;
 	if (ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_NAT_DMA, cmd)) {
 		perror("ipa_nati_post_ipv4_dma_cmd(): ioctl error value");
@@ -1602,6 +1656,357 @@ fail:
 	return ret;
 }
 
+/**
+ * ipa_nati_batch_begin() - start queueing dma commands of rule additions
+ * @tbl_hdl: [in] nat table handle
+ *
+ * Only rule additions of the calling thread are queued, the batch
+ * belongs to it until ipa_nati_batch_commit().
+ *
+ * Returns: 0 on success, negative on failure
+ */
+int ipa_nati_batch_begin(uint32_t tbl_hdl)
+{
+	uint8_t tbl_indx = (uint8_t)(tbl_hdl - 1);
+	struct ipa_nat_ip4_table_cache *tbl_ptr = &ipv4_nat_cache.ip4_tbl[tbl_indx];
+	int ret = 0;
+
+	if (pthread_mutex_lock(&nat_mutex) != 0) {
+		IPAERR("unable to lock the nat mutex\n");
+		return -1;
+	}
+
+	if (!tbl_ptr->valid) {
+		IPAERR("invalid table handle\n");
+		ret = -EINVAL;
+		goto unlock;
+	}
+
+	if (nat_batch.active) {
+		IPAERR("batch already started on table %d\n", nat_batch.tbl_indx + 1);
+		ret = -EBUSY;
+		goto unlock;
+	}
+
+	nat_batch.total_entries = tbl_ptr->table_entries + tbl_ptr->expn_table_entries;
+	nat_batch.cmd = (struct ipa_ioc_nat_dma_cmd *)
+	malloc(sizeof(struct ipa_ioc_nat_dma_cmd)+
+				 sizeof(struct ipa_ioc_nat_dma_one) * IPA_NAT_DMA_BATCH_MAX_ENTRIES);
+	nat_batch.enable_pending = (uint8_t *)calloc(nat_batch.total_entries, sizeof(uint8_t));
+	nat_batch.failed_hdls = (uint32_t *)calloc(nat_batch.total_entries, sizeof(uint32_t));
+	if (NULL == nat_batch.cmd || NULL == nat_batch.enable_pending ||
+			NULL == nat_batch.failed_hdls) {
+		IPAERR("unable to allocate memory\n");
+		free(nat_batch.cmd);
+		free(nat_batch.enable_pending);
+		free(nat_batch.failed_hdls);
+		memset(&nat_batch, 0, sizeof(nat_batch));
+		ret = -ENOMEM;
+		goto unlock;
+	}
+
+	nat_batch.cmd->entries = 0;
+	nat_batch.tbl_indx = tbl_indx;
+	nat_batch.owner = pthread_self();
+	nat_batch.active = 1;
+	IPADBG("started batch on table %d\n", tbl_hdl);
+
+unlock:
+	if (pthread_mutex_unlock(&nat_mutex) != 0) {
+		IPAERR("unable to unlock the nat mutex\n");
+		return -1;
+	}
+
+	return ret;
+}
+
+/**
+ * ipa_nati_batch_commit() - post the queued dma commands and end the batch
+ * @tbl_hdl: [in] nat table handle
+ * @failed_hdls: [out] handles of the rules that could not be enabled,
+ *	with room for every rule added in the batch
+ * @max_failed: [in] number of handles failed_hdls can hold
+ * @num_failed: [out] number of handles written to failed_hdls
+ *
+ * The handles of rules that could not be enabled are no longer valid.
+ *
+ * Returns: 0 on success, negative on failure
+ */
+int ipa_nati_batch_commit(uint32_t tbl_hdl,
+				uint32_t *failed_hdls,
+				uint32_t max_failed,
+				uint32_t *num_failed)
+{
+	uint32_t cnt;
+	int ret;
+
+	*num_failed = 0;
+
+	if (pthread_mutex_lock(&nat_mutex) != 0) {
+		IPAERR("unable to lock the nat mutex\n");
+		return -1;
+	}
+
+	if (!ipa_nati_batch_owned((uint8_t)(tbl_hdl - 1))) {
+		IPAERR("no batch started on table %d by this thread\n", tbl_hdl);
+		ret = -EINVAL;
+		goto unlock;
+	}
+
+	ret = ipa_nati_batch_flush();
+
+	if (nat_batch.failed_cnt > max_failed) {
+		IPAERR("%d rules failed, only %d can be reported\n",
+			nat_batch.failed_cnt, max_failed);
+	}
+	for (cnt = 0; cnt < nat_batch.failed_cnt && cnt < max_failed; cnt++) {
+		failed_hdls[cnt] = nat_batch.failed_hdls[cnt];
+	}
+	*num_failed = cnt;
+	if (nat_batch.failed_cnt) {
+		ret = -EIO;
+	}
+
+	free(nat_batch.cmd);
+	free(nat_batch.enable_pending);
+	free(nat_batch.failed_hdls);
+	memset(&nat_batch, 0, sizeof(nat_batch));
+	IPADBG("ended batch on table %d\n", tbl_hdl);
+
+unlock:
+	if (pthread_mutex_unlock(&nat_mutex) != 0) {
+		IPAERR("unable to unlock the nat mutex\n");
+		return -1;
+	}
+
+	return ret;
+}
+
+/**
+ * ipa_nati_batch_owned() - check for a batch of the calling thread
+ * @tbl_indx: [in] nat table index
+ *
+ * Called with nat_mutex held.
+ *
+ * Returns: 1 if the calling thread began a batch on the table, 0 otherwise
+ */
+uint8_t ipa_nati_batch_owned(uint8_t tbl_indx)
+{
+	return nat_batch.active && nat_batch.tbl_indx == tbl_indx &&
+		pthread_equal(nat_batch.owner, pthread_self());
+}
+
+/**
+ * ipa_nati_batch_fail_rule() - release the rule of an entry that was not enabled
+ * @tbl_entry: [in] base or expansion table entry of the rule
+ *
+ * Undoes ipa_nati_make_rule_hdl() for the entry, the way a failed
+ * addition outside a batch never makes a handle, and remembers the
+ * handle for ipa_nati_batch_commit().
+ */
+static void ipa_nati_batch_fail_rule(uint16_t tbl_entry)
+{
+	struct ipa_nat_ip4_table_cache *tbl_ptr = &ipv4_nat_cache.ip4_tbl[nat_batch.tbl_indx];
+	uint16_t rule_id;
+	uint32_t cnt;
+
+	if (tbl_entry >= tbl_ptr->table_entries) {
+		rule_id = (uint16_t)(tbl_entry - tbl_ptr->table_entries);
+		rule_id = (rule_id << IPA_NAT_RULE_HDL_TBL_TYPE_BITS);
+		rule_id = (rule_id | IPA_NAT_RULE_HDL_TBL_TYPE_MASK);
+	} else {
+		rule_id = tbl_entry;
+		rule_id = (rule_id << IPA_NAT_RULE_HDL_TBL_TYPE_BITS);
+	}
+
+	for (cnt = 0; cnt < nat_batch.total_entries; cnt++) {
+		if (tbl_ptr->rule_id_array[cnt] != rule_id) {
+			continue;
+		}
+
+		tbl_ptr->rule_id_array[cnt] = IPA_NAT_INVALID_NAT_ENTRY;
+		if (tbl_entry >= tbl_ptr->table_entries) {
+			tbl_ptr->cur_expn_tbl_cnt--;
+		} else {
+			tbl_ptr->cur_tbl_cnt--;
+		}
+		if (nat_batch.failed_cnt < nat_batch.total_entries) {
+			nat_batch.failed_hdls[nat_batch.failed_cnt++] = cnt + 1;
+		}
+		IPAERR("rule handle %d of entry %d not enabled\n", cnt + 1, tbl_entry);
+		return;
+	}
+}
+
+/**
+ * ipa_nati_batch_flush() - post the queued dma commands
+ *
+ * Post all commands queued so far with one IPA_IOC_NAT_DMA, the
+ * batch stays open. If that fails the commands are posted one by one,
+ * and the rules whose enable bit still cannot be posted are released
+ * and reported by ipa_nati_batch_commit(). Called with nat_mutex held.
+ *
+ * Returns: 0 on success, negative if some commands could not be posted
+ */
+int ipa_nati_batch_flush(void)
+{
+	struct ipa_ioc_nat_dma_cmd *cmd;
+	int ret = 0;
+	int cnt;
+
+	if (!nat_batch.active || 0 == nat_batch.cmd->entries) {
+		return 0;
+	}
+
+	if (!ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_NAT_DMA, nat_batch.cmd)) {
+		IPADBG("posted IPA_IOC_NAT_DMA with %d batched commands\n",
+			nat_batch.cmd->entries);
+		goto done;
+	}
+
+	perror("ipa_nati_batch_flush(): ioctl error value");
+	IPAERR("unable to call dma icotl for %d batched commands, post them one by one\n",
+		nat_batch.cmd->entries);
+	IPADBG("ipa fd %d\n", ipv4_nat_cache.ipa_fd);
+
+	cmd = (struct ipa_ioc_nat_dma_cmd *)
+	malloc(sizeof(struct ipa_ioc_nat_dma_cmd)+
+				 sizeof(struct ipa_ioc_nat_dma_one));
+	if (NULL == cmd) {
+		IPAERR("unable to allocate memory\n");
+	}
+
+	for (cnt = 0; cnt < nat_batch.cmd->entries; cnt++) {
+		if (NULL != cmd) {
+			cmd->dma[0] = nat_batch.cmd->dma[cnt];
+			cmd->entries = 1;
+			if (!ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_NAT_DMA, cmd)) {
+				continue;
+			}
+			perror("ipa_nati_batch_flush(): ioctl error value");
+		}
+
+		IPAERR("unable to post dma command %d of the batch\n", cnt);
+		ret = -EIO;
+		if (IPA_NAT_DMA_BATCH_NO_ENTRY != nat_batch.cmd_entry[cnt]) {
+			ipa_nati_batch_fail_rule(nat_batch.cmd_entry[cnt]);
+		}
+	}
+	free(cmd);
+
+done:
+	nat_batch.cmd->entries = 0;
+	memset(nat_batch.enable_pending, 0, nat_batch.total_entries);
+
+	return ret;
+}
+
+/**
+ * ipa_nati_batch_queue() - queue one dma command in the open batch
+ * @tbl_indx: [in] nat table index
+ * @base_addr: [in] table type the command writes into
+ * @offset: [in] offset of the field to write
+ * @data: [in] value to write
+ * @tbl_entry: [in] rule entry the command enables, or
+ *	IPA_NAT_DMA_BATCH_NO_ENTRY
+ *
+ * Posts the queued commands first when the batch is full. Called with
+ * nat_mutex held.
+ *
+ * Returns: None
+ */
+void ipa_nati_batch_queue(uint8_t tbl_indx,
+				uint8_t base_addr,
+				uint32_t offset,
+				uint16_t data,
+				uint16_t tbl_entry)
+{
+	struct ipa_ioc_nat_dma_one *dma;
+
+	if (IPA_NAT_DMA_BATCH_MAX_ENTRIES == nat_batch.cmd->entries) {
+		ipa_nati_batch_flush();
+	}
+
+	nat_batch.cmd_entry[nat_batch.cmd->entries] = tbl_entry;
+	dma = &nat_batch.cmd->dma[nat_batch.cmd->entries];
+	dma->table_index = tbl_indx;
+	dma->base_addr = base_addr;
+	dma->offset = offset;
+	dma->data = data;
+	nat_batch.cmd->entries++;
+}
+
+/**
+ * ipa_nati_batch_enable_pending() - check for a queued enable bit
+ * @tbl_addr: [in] base or expansion rule table
+ * @entry: [in] entry of that table
+ *
+ * The enable bit marks a rule entry as used, but it only reaches the
+ * table once the queued commands are posted.
+ *
+ * Returns: 1 if the enable bit of the entry is queued, 0 otherwise
+ */
+uint8_t ipa_nati_batch_enable_pending(const char *tbl_addr,
+				uint16_t entry)
+{
+	struct ipa_nat_ip4_table_cache *tbl_ptr;
+
+	if (!nat_batch.active) {
+		return 0;
+	}
+
+	tbl_ptr = &ipv4_nat_cache.ip4_tbl[nat_batch.tbl_indx];
+	if (tbl_addr == tbl_ptr->ipv4_rules_addr) {
+		return nat_batch.enable_pending[entry];
+	}
+	if (tbl_addr == tbl_ptr->ipv4_expn_rules_addr) {
+		return nat_batch.enable_pending[tbl_ptr->table_entries + entry];
+	}
+	return 0;
+}
+
+/**
+ * ipa_nati_batch_next_index() - next index of an entry, including queued updates
+ * @cache_ptr: [in] nat table
+ * @tbl_type: [in] table the entry belongs to
+ * @entry: [in] entry of that table
+ * @value: [in] next index read from the table
+ *
+ * Returns: the next index the entry has once the queued commands are posted
+ */
+uint16_t ipa_nati_batch_next_index(struct ipa_nat_ip4_table_cache *cache_ptr,
+				nat_table_type tbl_type,
+				uint16_t entry,
+				uint16_t value)
+{
+	uint32_t offset;
+	int cnt;
+
+	if (!nat_batch.active || 0 == nat_batch.cmd->entries ||
+			cache_ptr != &ipv4_nat_cache.ip4_tbl[nat_batch.tbl_indx]) {
+		return value;
+	}
+
+	/* same offsets as ipa_nati_copy_ipv4_rule_to_hw() and
+	   ipa_nati_copy_ipv4_index_rule_to_hw() pass to the dma command */
+	if (IPA_NAT_BASE_TBL == tbl_type || IPA_NAT_EXPN_TBL == tbl_type) {
+		offset = ipa_nati_get_entry_offset(cache_ptr, tbl_type, entry);
+		offset += IPA_NAT_RULE_NEXT_FIELD_OFFSET;
+	} else {
+		offset = (uint16_t)(ipa_nati_get_index_entry_offset(cache_ptr, tbl_type, entry) +
+			IPA_NAT_INDEX_RULE_NEXT_FIELD_OFFSET);
+	}
+
+	for (cnt = nat_batch.cmd->entries - 1; cnt >= 0; cnt--) {
+		if (nat_batch.cmd->dma[cnt].base_addr == tbl_type &&
+				nat_batch.cmd->dma[cnt].offset == offset) {
+			return nat_batch.cmd->dma[cnt].data;
+		}
+	}
+
+	return value;
+}
+
 
 int ipa_nati_del_ipv4_rule(uint32_t tbl_hdl,
 				uint32_t rule_hdl)
@@ -1639,6 +2044,11 @@ int ipa_nati_del_ipv4_rule(uint32_t tbl_hdl,
 		goto fail;
 	}
 
+	/* the rule may still be waiting for its links in an open batch */
+	if (nat_batch.active && nat_batch.tbl_indx == tbl_indx) {
+		ipa_nati_batch_flush();
+	}
+
 	ipa_nati_find_rule_pos(tbl_ptr, expn_tbl,
 												 tbl_entry, &rule_pos);
 	IPADBG("rule_pos:%d\n", rule_pos);
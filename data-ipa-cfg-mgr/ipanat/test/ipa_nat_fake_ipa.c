@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of The Linux Foundation nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*=========================================================================*/
+/*!
+	@file
+	ipa_nat_fake_ipa.c
+
+	@brief
+	Stand-in for /dev/ipa and the nat table device, to run the test
+	suite without ipa hardware.
+
+	Linked into the test executable, open() and ioctl() below take
+	precedence over the C library ones for libipanat as well. The nat
+	table is backed by a temporary file, the nat dma commands are applied
+	to it the way hw would, and every ioctl is counted so that tests can
+	check how many the driver posted.
+*/
+/*=========================================================================*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "ipa_nat_drv.h"
+#include "ipa_nat_drvi.h"
+#include "ipa_nat_test.h"
+
+#ifdef __BIONIC__
+typedef int ioctl_request_t;
+#else
+typedef unsigned long ioctl_request_t;
+#endif
+
+#define FAKE_IPA_MAX_IOCTLS 8
+
+static int fake_ipa_fd = -1;
+
+/* nat table memory, shared with the driver's mapping of the nat device */
+static FILE *fake_nat_file;
+static char *fake_nat_mem;
+static size_t fake_nat_size;
+/* start of the base, expansion, index and index expansion tables */
+static uint32_t fake_nat_tbl_offset[IPA_NAT_INDEX_EXPN_TBL + 1];
+
+static struct {
+	unsigned long request;
+	unsigned int cnt;
+} fake_ioctls[FAKE_IPA_MAX_IOCTLS];
+
+/* dma failures to inject, 0 for none */
+static unsigned int fake_dma_max_entries;
+static unsigned int fake_dma_fail_enable;
+static unsigned int fake_dma_enables;
+
+static void fake_ipa_count(unsigned long request)
+{
+	int cnt;
+
+	for (cnt = 0; cnt < FAKE_IPA_MAX_IOCTLS; cnt++) {
+		if (fake_ioctls[cnt].cnt == 0 || fake_ioctls[cnt].request == request) {
+			fake_ioctls[cnt].request = request;
+			fake_ioctls[cnt].cnt++;
+			return;
+		}
+	}
+}
+
+unsigned int ipa_nat_fake_ipa_ioctl_cnt(unsigned long request)
+{
+	int cnt;
+
+	for (cnt = 0; cnt < FAKE_IPA_MAX_IOCTLS; cnt++) {
+		if (fake_ioctls[cnt].cnt != 0 && fake_ioctls[cnt].request == request) {
+			return fake_ioctls[cnt].cnt;
+		}
+	}
+	return 0;
+}
+
+void ipa_nat_fake_ipa_fail_dma(unsigned int max_entries,
+				unsigned int fail_enable)
+{
+	fake_dma_max_entries = max_entries;
+	fake_dma_fail_enable = fail_enable;
+	fake_dma_enables = 0;
+}
+
+static int fake_ipa_alloc_nat_mem(struct ipa_ioc_nat_alloc_mem *mem)
+{
+	fake_nat_file = tmpfile();
+	if (fake_nat_file == NULL ||
+			ftruncate(fileno(fake_nat_file), mem->size)) {
+		return -ENOMEM;
+	}
+
+	fake_nat_mem = mmap(NULL, mem->size, PROT_READ | PROT_WRITE,
+			MAP_SHARED, fileno(fake_nat_file), 0);
+	if (fake_nat_mem == MAP_FAILED) {
+		fake_nat_mem = NULL;
+		return -ENOMEM;
+	}
+
+	fake_nat_size = mem->size;
+	mem->offset = 0;
+	return 0;
+}
+
+static void fake_ipa_del_nat(void)
+{
+	if (fake_nat_mem != NULL) {
+		munmap(fake_nat_mem, fake_nat_size);
+		fake_nat_mem = NULL;
+	}
+	if (fake_nat_file != NULL) {
+		fclose(fake_nat_file);
+		fake_nat_file = NULL;
+	}
+	fake_nat_size = 0;
+}
+
+static int fake_ipa_init_nat(struct ipa_ioc_v4_nat_init *init)
+{
+	fake_nat_tbl_offset[IPA_NAT_BASE_TBL] = init->ipv4_rules_offset;
+	fake_nat_tbl_offset[IPA_NAT_EXPN_TBL] = init->expn_rules_offset;
+	fake_nat_tbl_offset[IPA_NAT_INDX_TBL] = init->index_offset;
+	fake_nat_tbl_offset[IPA_NAT_INDEX_EXPN_TBL] = init->index_expn_offset;
+	return 0;
+}
+
+static int fake_ipa_nat_dma(struct ipa_ioc_nat_dma_cmd *cmd)
+{
+	uint32_t offset;
+	int cnt;
+
+	if (fake_nat_mem == NULL || cmd->entries == 0) {
+		return -EINVAL;
+	}
+
+	if (fake_dma_max_entries && cmd->entries > fake_dma_max_entries) {
+		return -ENOMEM;
+	}
+
+	/* no command of a failed ioctl is applied */
+	for (cnt = 0; fake_dma_fail_enable && cnt < cmd->entries; cnt++) {
+		if (cmd->dma[cnt].data == IPA_NAT_FLAG_ENABLE_BIT_MASK &&
+				++fake_dma_enables % fake_dma_fail_enable == 0) {
+			return -EIO;
+		}
+	}
+
+	for (cnt = 0; cnt < cmd->entries; cnt++) {
+		if (cmd->dma[cnt].base_addr > IPA_NAT_INDEX_EXPN_TBL) {
+			return -EINVAL;
+		}
+		offset = fake_nat_tbl_offset[cmd->dma[cnt].base_addr] + cmd->dma[cnt].offset;
+		if (offset + sizeof(uint16_t) > fake_nat_size) {
+			return -EINVAL;
+		}
+		memcpy(fake_nat_mem + offset, &cmd->dma[cnt].data, sizeof(uint16_t));
+	}
+	return 0;
+}
+
+int ioctl(int fd, ioctl_request_t request, ...)
+{
+	va_list ap;
+	void *arg;
+	int ret = 0;
+
+	va_start(ap, request);
+	arg = va_arg(ap, void *);
+	va_end(ap);
+
+	if (fd < 0 || fd != fake_ipa_fd) {
+		return syscall(SYS_ioctl, fd, request, arg);
+	}
+
+	fake_ipa_count((unsigned long)request);
+
+	switch ((unsigned long)request) {
+	case IPA_IOC_GET_HW_VERSION:
+		*(enum ipa_hw_type *)arg = IPA_HW_None;
+		break;
+	case IPA_IOC_ALLOC_NAT_MEM:
+		ret = fake_ipa_alloc_nat_mem((struct ipa_ioc_nat_alloc_mem *)arg);
+		break;
+	case IPA_IOC_V4_INIT_NAT:
+		ret = fake_ipa_init_nat((struct ipa_ioc_v4_nat_init *)arg);
+		break;
+	case IPA_IOC_NAT_DMA:
+		ret = fake_ipa_nat_dma((struct ipa_ioc_nat_dma_cmd *)arg);
+		break;
+	case IPA_IOC_V4_DEL_NAT:
+		fake_ipa_del_nat();
+		break;
+	case IPA_IOC_NAT_MODIFY_PDN:
+		break;
+	default:
+		ret = -ENOTTY;
+		break;
+	}
+
+	if (ret) {
+		errno = -ret;
+		return -1;
+	}
+	return 0;
+}
+
+int open(const char *path, int flags, ...)
+{
+	va_list ap;
+	int mode = 0;
+
+	if (flags & O_CREAT) {
+		va_start(ap, flags);
+		mode = va_arg(ap, int);
+		va_end(ap);
+	}
+
+	if (!strcmp(path, IPA_DEV_NAME)) {
+		if (fake_ipa_fd < 0) {
+			fake_ipa_fd = syscall(SYS_openat, AT_FDCWD, "/dev/null", O_RDONLY);
+		}
+		return fake_ipa_fd;
+	}
+
+	if (!strcmp(path, NAT_DEV_FULL_NAME)) {
+		if (fake_nat_file == NULL) {
+			errno = ENOENT;
+			return -1;
+		}
+		return dup(fileno(fake_nat_file));
+	}
+
+	return syscall(SYS_openat, AT_FDCWD, path, flags, mode);
+}
+
+#ifdef __BIONIC__
+/* what fortified open() calls when it is given no mode */
+int __open_2(const char *path, int flags)
+{
+	return open(path, flags);
+}
+#endif
@@ -102,3 +102,13 @@ int ipa_nat_test019(int, u32, u8);
 int ipa_nat_test020(int, u32, u8);
 int ipa_nat_test021(int, int);
 int ipa_nat_test022(int, u32, u8);
+int ipa_nat_test023(int, u32, u8);
+
+int ipa_nat_test024(int, u32, u8);
+
+/* ioctls seen by the fake ipa device, only linked in ipa_nat_fake_test */
+unsigned int ipa_nat_fake_ipa_ioctl_cnt(unsigned long request) __attribute__((weak));
+/* make the fake ipa device fail IPA_IOC_NAT_DMA with more than max_entries
+   commands, and every fail_enable'th command that enables a rule */
+void ipa_nat_fake_ipa_fail_dma(unsigned int max_entries,
+				unsigned int fail_enable) __attribute__((weak));
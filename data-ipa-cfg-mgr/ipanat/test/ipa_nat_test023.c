@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of The Linux Foundation nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*=========================================================================*/
+/*!
+	@file
+	ipa_nat_test023.c
+
+	@brief
+	Verify the following scenario:
+	1. Add ipv4 table
+	2. Add ipv4 rules one by one and delete them
+	3. Add the same ipv4 rules in a batch, some of them twice
+	4. Verify that the rules get enabled on commit only
+	5. Delete the rules
+	6. Delete ipv4 table
+	Run with the fake ipa device, also verify that the batch posted
+	fewer IPA_IOC_NAT_DMA ioctls than adding the rules one by one.
+*/
+/*=========================================================================*/
+
+#include <string.h>
+
+#include "ipa_nat_drv.h"
+#include "ipa_nat_drvi.h"
+#include "ipa_nat_test.h"
+
+#define IPA_NAT_TEST023_MAX_RULES 256
+
+extern struct ipa_nat_cache ipv4_nat_cache;
+
+static int count_enabled_rules(u32 tbl_hdl)
+{
+	struct ipa_nat_ip4_table_cache *cache_ptr = &ipv4_nat_cache.ip4_tbl[tbl_hdl - 1];
+	struct ipa_nat_rule *tbl_ptr;
+	int cnt, enabled = 0;
+
+	tbl_ptr = (struct ipa_nat_rule *)cache_ptr->ipv4_rules_addr;
+	for (cnt = 0; cnt < cache_ptr->table_entries; cnt++) {
+		if (Read16BitFieldValue(tbl_ptr[cnt].ip_cksm_enbl, ENABLE_FIELD)) {
+			enabled++;
+		}
+	}
+
+	tbl_ptr = (struct ipa_nat_rule *)cache_ptr->ipv4_expn_rules_addr;
+	for (cnt = 0; cnt < cache_ptr->expn_table_entries; cnt++) {
+		if (Read16BitFieldValue(tbl_ptr[cnt].ip_cksm_enbl, ENABLE_FIELD)) {
+			enabled++;
+		}
+	}
+
+	return enabled;
+}
+
+/* Rule 4n+1 is the same as rule 4n, so that the batch also has to link
+   rules that collide with rules added earlier in the same batch */
+static void make_rule(ipa_nat_ipv4_rule *ipv4_rule, int cnt)
+{
+	if (cnt % 4 == 1)
+	{
+		cnt--;
+	}
+
+	memset(ipv4_rule, 0, sizeof(*ipv4_rule));
+	ipv4_rule->target_ip = 0xC1171601 + cnt; /* 193.23.22.1 + cnt */
+	ipv4_rule->target_port = 1234;
+	ipv4_rule->private_ip = 0xC2171601; /* 194.23.22.1 */
+	ipv4_rule->private_port = 5678 + cnt;
+	ipv4_rule->protocol = (cnt & 2) ? IPPROTO_UDP : IPPROTO_TCP;
+	ipv4_rule->public_port = 9050 + cnt;
+}
+
+int ipa_nat_test023(int total_entries, u32 tbl_hdl, u8 sep)
+{
+	int ret = 0, cnt, enabled, early;
+	int num_rules = total_entries / 8;
+	u32 rule_hdl[IPA_NAT_TEST023_MAX_RULES];
+	u32 failed_hdl[IPA_NAT_TEST023_MAX_RULES], num_failed;
+	ipa_nat_ipv4_rule ipv4_rule;
+	unsigned int single_dma = 0, batch_dma = 0;
+
+	u32 pub_ip_add = 0x011617c0;   /* "192.23.22.1" */
+
+	IPADBG("%s():\n",__FUNCTION__);
+
+	if (num_rules > IPA_NAT_TEST023_MAX_RULES)
+	{
+		num_rules = IPA_NAT_TEST023_MAX_RULES;
+	}
+
+	if(sep)
+	{
+		ret = ipa_nat_add_ipv4_tbl(pub_ip_add, total_entries, &tbl_hdl);
+		CHECK_ERR1(ret, tbl_hdl);
+	}
+
+	enabled = count_enabled_rules(tbl_hdl);
+
+	/* One by one */
+	if (ipa_nat_fake_ipa_ioctl_cnt)
+	{
+		single_dma = ipa_nat_fake_ipa_ioctl_cnt(IPA_IOC_NAT_DMA);
+	}
+	for (cnt = 0; cnt < num_rules; cnt++)
+	{
+		make_rule(&ipv4_rule, cnt);
+		ret = ipa_nat_add_ipv4_rule(tbl_hdl, &ipv4_rule, &rule_hdl[cnt]);
+		CHECK_ERR1(ret, tbl_hdl);
+	}
+	if (ipa_nat_fake_ipa_ioctl_cnt)
+	{
+		single_dma = ipa_nat_fake_ipa_ioctl_cnt(IPA_IOC_NAT_DMA) - single_dma;
+	}
+
+	for (cnt = 0; cnt < num_rules; cnt++)
+	{
+		ret = ipa_nat_del_ipv4_rule(tbl_hdl, rule_hdl[cnt]);
+		CHECK_ERR1(ret, tbl_hdl);
+	}
+
+	/* Batched */
+	if (ipa_nat_fake_ipa_ioctl_cnt)
+	{
+		batch_dma = ipa_nat_fake_ipa_ioctl_cnt(IPA_IOC_NAT_DMA);
+	}
+
+	ret = ipa_nat_batch_begin(tbl_hdl);
+	CHECK_ERR1(ret, tbl_hdl);
+
+	for (cnt = 0; cnt < num_rules; cnt++)
+	{
+		make_rule(&ipv4_rule, cnt);
+		ret = ipa_nat_add_ipv4_rule(tbl_hdl, &ipv4_rule, &rule_hdl[cnt]);
+		CHECK_ERR1(ret, tbl_hdl);
+	}
+
+	/* a batch larger than one dma command gets posted on the way */
+	early = count_enabled_rules(tbl_hdl) - enabled;
+
+	ret = ipa_nat_batch_commit(tbl_hdl, failed_hdl, IPA_NAT_TEST023_MAX_RULES, &num_failed);
+	CHECK_ERR1(ret, tbl_hdl);
+
+	if (num_rules * 3 <= IPA_NAT_DMA_BATCH_MAX_ENTRIES && early != 0)
+	{
+		IPAERR("%d rules enabled before commit\n", early);
+		ret = -1;
+	}
+
+	if (ipa_nat_fake_ipa_ioctl_cnt)
+	{
+		batch_dma = ipa_nat_fake_ipa_ioctl_cnt(IPA_IOC_NAT_DMA) - batch_dma;
+		IPADBG("%d rules: %u dma ioctls one by one, %u batched\n",
+			num_rules, single_dma, batch_dma);
+		if (batch_dma > (num_rules * 3 + IPA_NAT_DMA_BATCH_MAX_ENTRIES - 1) /
+				IPA_NAT_DMA_BATCH_MAX_ENTRIES || batch_dma > single_dma)
+		{
+			IPAERR("too many dma ioctls in batch\n");
+			ret = -1;
+		}
+	}
+
+	if (count_enabled_rules(tbl_hdl) != enabled + num_rules)
+	{
+		IPAERR("%d rules enabled after commit, expected %d\n",
+			count_enabled_rules(tbl_hdl), enabled + num_rules);
+		ret = -1;
+	}
+	CHECK_ERR1(ret, tbl_hdl);
+
+	for (cnt = 0; cnt < num_rules; cnt++)
+	{
+		ret = ipa_nat_del_ipv4_rule(tbl_hdl, rule_hdl[cnt]);
+		CHECK_ERR1(ret, tbl_hdl);
+	}
+
+	if(sep)
+	{
+		ret = ipa_nat_del_ipv4_tbl(tbl_hdl);
+		CHECK_ERR(ret);
+	}
+
+	return 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of The Linux Foundation nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*=========================================================================*/
+/*!
+	@file
+	ipa_nat_test024.c
+
+	@brief
+	Verify the following scenario:
+	1. Add ipv4 table
+	2. Add ipv4 rules in a batch, with the batched dma command failing
+	3. Verify that the commit posts the commands one by one and
+	   enables every rule
+	4. Delete the rules
+	5. Add ipv4 rules in a batch, with some of the enable commands failing
+	6. Verify that the commit returns exactly the rules left disabled,
+	   and that their handles can no longer be deleted
+	7. Delete the other rules
+	8. Delete ipv4 table
+	Runs with the fake ipa device only.
+*/
+/*=========================================================================*/
+
+#include <string.h>
+
+#include "ipa_nat_drv.h"
+#include "ipa_nat_drvi.h"
+#include "ipa_nat_test.h"
+
+#define IPA_NAT_TEST024_MAX_RULES 64
+#define IPA_NAT_TEST024_FAIL_ENABLE 3
+
+extern struct ipa_nat_cache ipv4_nat_cache;
+
+static int is_enabled(u32 tbl_hdl, u32 rule_hdl)
+{
+	struct ipa_nat_ip4_table_cache *cache_ptr = &ipv4_nat_cache.ip4_tbl[tbl_hdl - 1];
+	struct ipa_nat_rule *tbl_ptr;
+	uint8_t expn_tbl;
+	uint16_t tbl_entry;
+
+	ipa_nati_parse_ipv4_rule_hdl((uint8_t)(tbl_hdl - 1), (uint16_t)rule_hdl,
+		&expn_tbl, &tbl_entry);
+
+	tbl_ptr = (struct ipa_nat_rule *)cache_ptr->ipv4_rules_addr;
+	if (expn_tbl)
+	{
+		tbl_ptr = (struct ipa_nat_rule *)cache_ptr->ipv4_expn_rules_addr;
+	}
+	return Read16BitFieldValue(tbl_ptr[tbl_entry].ip_cksm_enbl, ENABLE_FIELD);
+}
+
+static void make_rule(ipa_nat_ipv4_rule *ipv4_rule, int cnt)
+{
+	memset(ipv4_rule, 0, sizeof(*ipv4_rule));
+	ipv4_rule->target_ip = 0xC1171601 + (cnt & ~1); /* pairs collide */
+	ipv4_rule->target_port = 1234;
+	ipv4_rule->private_ip = 0xC2171601; /* 194.23.22.1 */
+	ipv4_rule->private_port = 5678 + cnt;
+	ipv4_rule->protocol = IPPROTO_TCP;
+	ipv4_rule->public_port = 9050 + cnt;
+}
+
+static int add_batch(u32 tbl_hdl, int num_rules, u32 *rule_hdl,
+				u32 *failed_hdl, u32 *num_failed)
+{
+	ipa_nat_ipv4_rule ipv4_rule;
+	int ret, cnt;
+
+	ret = ipa_nat_batch_begin(tbl_hdl);
+	if (ret)
+	{
+		return ret;
+	}
+
+	for (cnt = 0; cnt < num_rules; cnt++)
+	{
+		make_rule(&ipv4_rule, cnt);
+		ret = ipa_nat_add_ipv4_rule(tbl_hdl, &ipv4_rule, &rule_hdl[cnt]);
+		if (ret)
+		{
+			return ret;
+		}
+	}
+
+	return ipa_nat_batch_commit(tbl_hdl, failed_hdl, num_rules, num_failed);
+}
+
+int ipa_nat_test024(int total_entries, u32 tbl_hdl, u8 sep)
+{
+	int ret = 0, cnt, idx, failed;
+	int num_rules = total_entries / 8;
+	u32 rule_hdl[IPA_NAT_TEST024_MAX_RULES];
+	u32 failed_hdl[IPA_NAT_TEST024_MAX_RULES], num_failed;
+
+	u32 pub_ip_add = 0x011617c0;   /* "192.23.22.1" */
+
+	IPADBG("%s():\n",__FUNCTION__);
+
+	if (!ipa_nat_fake_ipa_fail_dma)
+	{
+		IPADBG("needs the fake ipa device, skipped\n");
+		return 0;
+	}
+
+	if (num_rules > IPA_NAT_TEST024_MAX_RULES)
+	{
+		num_rules = IPA_NAT_TEST024_MAX_RULES;
+	}
+
+	if(sep)
+	{
+		ret = ipa_nat_add_ipv4_tbl(pub_ip_add, total_entries, &tbl_hdl);
+		CHECK_ERR1(ret, tbl_hdl);
+	}
+
+	/* Batched command rejected, posted one by one */
+	ipa_nat_fake_ipa_fail_dma(1, 0);
+	ret = add_batch(tbl_hdl, num_rules, rule_hdl, failed_hdl, &num_failed);
+	ipa_nat_fake_ipa_fail_dma(0, 0);
+	if (ret == 0 && num_failed != 0)
+	{
+		IPAERR("%d rules failed\n", num_failed);
+		ret = -1;
+	}
+	CHECK_ERR1(ret, tbl_hdl);
+
+	for (cnt = 0; cnt < num_rules; cnt++)
+	{
+		if (!is_enabled(tbl_hdl, rule_hdl[cnt]))
+		{
+			IPAERR("rule %d not enabled\n", cnt);
+			ret = -1;
+		}
+		if (ipa_nat_del_ipv4_rule(tbl_hdl, rule_hdl[cnt]))
+		{
+			ret = -1;
+		}
+	}
+	CHECK_ERR1(ret, tbl_hdl);
+
+	/* Some enable commands fail even one by one */
+	ipa_nat_fake_ipa_fail_dma(1, IPA_NAT_TEST024_FAIL_ENABLE);
+	ret = add_batch(tbl_hdl, num_rules, rule_hdl, failed_hdl, &num_failed);
+	ipa_nat_fake_ipa_fail_dma(0, 0);
+	if (ret == 0 || num_failed == 0)
+	{
+		IPAERR("commit returned %d with %d failed rules\n", ret, num_failed);
+		CHECK_ERR1(-1, tbl_hdl);
+	}
+
+	ret = 0;
+	failed = 0;
+	for (cnt = 0; cnt < num_rules; cnt++)
+	{
+		for (idx = 0; idx < (int)num_failed && failed_hdl[idx] != rule_hdl[cnt]; idx++);
+		if (idx < (int)num_failed)
+		{
+			/* the handle is released, deleting it must fail */
+			failed++;
+			if (ipa_nat_del_ipv4_rule(tbl_hdl, rule_hdl[cnt]) == 0)
+			{
+				IPAERR("deleted failed rule %d\n", cnt);
+				ret = -1;
+			}
+			continue;
+		}
+
+		if (!is_enabled(tbl_hdl, rule_hdl[cnt]))
+		{
+			IPAERR("rule %d not enabled and not reported\n", cnt);
+			ret = -1;
+		}
+		if (ipa_nat_del_ipv4_rule(tbl_hdl, rule_hdl[cnt]))
+		{
+			ret = -1;
+		}
+	}
+	if (failed != (int)num_failed)
+	{
+		IPAERR("%d of %d failed handles are rules of the batch\n", failed, num_failed);
+		ret = -1;
+	}
+	IPADBG("%d of %d rules failed\n", num_failed, num_rules);
+	CHECK_ERR1(ret, tbl_hdl);
+
+	if(sep)
+	{
+		ret = ipa_nat_del_ipv4_tbl(tbl_hdl);
+		CHECK_ERR(ret);
+	}
+
+	return 0;
+}
@@ -16,6 +16,7 @@
 
 #define LOG_TAG "LocSvc_GnssDebugInterface"
 
+#include <inttypes.h>
 #include <log/log.h>
 #include <log_util.h>
 #include "Gnss.h"
@@ -131,6 +132,11 @@ Return<void> GnssDebug::getDebugData(getDebugData_cb _hidl_cb)
     }
     data.satelliteDataArray = s_array;
 
+    // no HIDL field for msg allocation counters, log them for field checks
+    LOC_LOGD("GnssDebug - msg alloc pooled=%" PRIu64 " heap=%" PRIu64 " peak=%u",
+             reports.mMsgAlloc.pooledAllocs, reports.mMsgAlloc.heapAllocs,
+             reports.mMsgAlloc.peakInUse);
+
     // callback HIDL with collected debug data
     _hidl_cb(data);
     return Void();
@@ -70,7 +70,8 @@ const MsgTask* LocDualContext::getMsgTask(LocThread::tCreate tCreator,
                                           const char* name, bool joinable)
 {
     if (NULL == mMsgTask) {
-        mMsgTask = new MsgTask(tCreator, name, joinable);
+        // the hal worker is fed by all LocApi reporting threads
+        mMsgTask = new MsgTask(tCreator, name, joinable, MsgTask::QUEUE_RING);
     }
     return mMsgTask;
 }
@@ -37,6 +37,7 @@
 #include <platform_lib_log_util.h>
 #include <MsgTask.h>
 #include <loc_nmea.h>
+#include <loc_cfg.h>
 #include <DataItemsFactoryProxy.h>
 #include <SystemStatus.h>
 #include <SystemStatusOsObserver.h>
@@ -49,9 +50,39 @@ namespace loc_core
 ******************************************************************************/
 class SystemStatusNmeaBase
 {
+public:
+    static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
+    static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
+    // PQWP7 is the widest sentence: talker, time and 3 fields per SV
+    static const uint32_t NMEA_MAXFIELDS = 2 + SV_ALL_NUM*3 + 8;
+
 protected:
-    std::vector<std::string> mField;
+    // string_view like index of the fields of one sentence. Fields are not
+    // copied: each entry points into the caller's sentence and ends at the
+    // next ',' or '*', where atoi() / atof() / strtol() stop anyway.
+    class FieldIndex
+    {
+        const char* mStr;
+        uint32_t mCount;
+        uint16_t mStart[NMEA_MAXFIELDS];
+        friend class SystemStatusNmeaBase;
+    public:
+        inline FieldIndex() : mStr(nullptr), mCount(0) {}
+        inline size_t size() const { return mCount; }
+        inline const char* operator[](size_t i) const { return mStr + mStart[i]; }
+    };
+    FieldIndex mField;
+
+    static inline int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
 
+    // single pass over the sentence: records where each field starts and
+    // folds the checksum, which is then verified against the one after '*'
     SystemStatusNmeaBase(const char *str_in, uint32_t len_in)
     {
         // check size and talker
@@ -59,34 +90,39 @@ protected:
             return;
         }
 
-        std::string parser(str_in);
-        std::string::size_type index = 0;
+        uint8_t checksum = 0;
+        uint32_t i = 0;
+        uint32_t count = 0;
+        mField.mStart[count++] = 0;
+        for (i = 1; i < len_in && str_in[i] != '\0' && str_in[i] != '*'; i++) {
+            checksum ^= (uint8_t)str_in[i];
+            if (str_in[i] == ',') {
+                if (count >= NMEA_MAXFIELDS) {
+                    LOC_LOGE("%s: too many fields in %.6s", __func__, str_in);
+                    return;
+                }
+                mField.mStart[count++] = i + 1;
+            }
+        }
 
         // verify checksum field
-        index = parser.find("*");
-        if (index == std::string::npos) {
+        if (i >= len_in || str_in[i] != '*') {
             return;
         }
-        parser[index] = ',';
-
-        // tokenize parser
-        while (1) {
-            std::string str;
-            index = parser.find(",");
-            if (index == std::string::npos) {
-                break;
+        if (i + 2 < len_in) {
+            int hi = hexValue(str_in[i + 1]);
+            int lo = hexValue(str_in[i + 2]);
+            if (hi >= 0 && lo >= 0 && ((hi << 4) | lo) != checksum) {
+                LOC_LOGE("%s: checksum mismatch in %.6s", __func__, str_in);
+                return;
             }
-            str = parser.substr(0, index);
-            parser = parser.substr(index + 1);
-            mField.push_back(str);
         }
+
+        mField.mStr = str_in;
+        mField.mCount = count;
     }
 
     virtual ~SystemStatusNmeaBase() { }
-
-public:
-    static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
-    static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
 };
 
 /******************************************************************************
@@ -191,30 +227,30 @@ public:
             mM1.mTimeValid = 0;
             return;
         }
-        mM1.mGpsWeek = atoi(mField[eGpsWeek].c_str());
-        mM1.mGpsTowMs = atoi(mField[eGpsTowMs].c_str());
-        mM1.mTimeValid = atoi(mField[eTimeValid].c_str());
-        mM1.mTimeSource = atoi(mField[eTimeSource].c_str());
-        mM1.mTimeUnc = atoi(mField[eTimeUnc].c_str());
-        mM1.mClockFreqBias = atoi(mField[eClockFreqBias].c_str());
-        mM1.mClockFreqBiasUnc = atoi(mField[eClockFreqBiasUnc].c_str());
-        mM1.mXoState = atoi(mField[eXoState].c_str());
-        mM1.mPgaGain = atoi(mField[ePgaGain].c_str());
-        mM1.mGpsBpAmpI = atoi(mField[eGpsBpAmpI].c_str());
-        mM1.mGpsBpAmpQ = atoi(mField[eGpsBpAmpQ].c_str());
-        mM1.mAdcI = atoi(mField[eAdcI].c_str());
-        mM1.mAdcQ = atoi(mField[eAdcQ].c_str());
-        mM1.mJammerGps = atoi(mField[eJammerGps].c_str());
-        mM1.mJammerGlo = atoi(mField[eJammerGlo].c_str());
-        mM1.mJammerBds = atoi(mField[eJammerBds].c_str());
-        mM1.mJammerGal = atoi(mField[eJammerGal].c_str());
-        mM1.mRecErrorRecovery = atoi(mField[eRecErrorRecovery].c_str());
-        mM1.mAgcGps = atof(mField[eAgcGps].c_str());
-        mM1.mAgcGlo = atof(mField[eAgcGlo].c_str());
-        mM1.mAgcBds = atof(mField[eAgcBds].c_str());
-        mM1.mAgcGal = atof(mField[eAgcGal].c_str());
-        mM1.mLeapSeconds = atoi(mField[eLeapSeconds].c_str());
-        mM1.mLeapSecUnc = atoi(mField[eLeapSecUnc].c_str());
+        mM1.mGpsWeek = atoi(mField[eGpsWeek]);
+        mM1.mGpsTowMs = atoi(mField[eGpsTowMs]);
+        mM1.mTimeValid = atoi(mField[eTimeValid]);
+        mM1.mTimeSource = atoi(mField[eTimeSource]);
+        mM1.mTimeUnc = atoi(mField[eTimeUnc]);
+        mM1.mClockFreqBias = atoi(mField[eClockFreqBias]);
+        mM1.mClockFreqBiasUnc = atoi(mField[eClockFreqBiasUnc]);
+        mM1.mXoState = atoi(mField[eXoState]);
+        mM1.mPgaGain = atoi(mField[ePgaGain]);
+        mM1.mGpsBpAmpI = atoi(mField[eGpsBpAmpI]);
+        mM1.mGpsBpAmpQ = atoi(mField[eGpsBpAmpQ]);
+        mM1.mAdcI = atoi(mField[eAdcI]);
+        mM1.mAdcQ = atoi(mField[eAdcQ]);
+        mM1.mJammerGps = atoi(mField[eJammerGps]);
+        mM1.mJammerGlo = atoi(mField[eJammerGlo]);
+        mM1.mJammerBds = atoi(mField[eJammerBds]);
+        mM1.mJammerGal = atoi(mField[eJammerGal]);
+        mM1.mRecErrorRecovery = atoi(mField[eRecErrorRecovery]);
+        mM1.mAgcGps = atof(mField[eAgcGps]);
+        mM1.mAgcGlo = atof(mField[eAgcGlo]);
+        mM1.mAgcBds = atof(mField[eAgcBds]);
+        mM1.mAgcGal = atof(mField[eAgcGal]);
+        mM1.mLeapSeconds = atoi(mField[eLeapSeconds]);
+        mM1.mLeapSecUnc = atoi(mField[eLeapSecUnc]);
     }
 
     inline SystemStatusPQWM1& get() { return mM1;} //getparser
@@ -269,13 +305,13 @@ public:
             return;
         }
         memset(&mP1, 0, sizeof(mP1));
-        mP1.mEpiValidity = strtol(mField[eEpiValidity].c_str(), NULL, 16);
-        mP1.mEpiLat = atof(mField[eEpiLat].c_str());
-        mP1.mEpiLon = atof(mField[eEpiLon].c_str());
-        mP1.mEpiAlt = atof(mField[eEpiAlt].c_str());
-        mP1.mEpiHepe = atoi(mField[eEpiHepe].c_str());
-        mP1.mEpiAltUnc = atof(mField[eEpiAltUnc].c_str());
-        mP1.mEpiSrc = atoi(mField[eEpiSrc].c_str());
+        mP1.mEpiValidity = strtol(mField[eEpiValidity], NULL, 16);
+        mP1.mEpiLat = atof(mField[eEpiLat]);
+        mP1.mEpiLon = atof(mField[eEpiLon]);
+        mP1.mEpiAlt = atof(mField[eEpiAlt]);
+        mP1.mEpiHepe = atoi(mField[eEpiHepe]);
+        mP1.mEpiAltUnc = atof(mField[eEpiAltUnc]);
+        mP1.mEpiSrc = atoi(mField[eEpiSrc]);
     }
 
     inline SystemStatusPQWP1& get() { return mP1;}
@@ -324,11 +360,11 @@ public:
             return;
         }
         memset(&mP2, 0, sizeof(mP2));
-        mP2.mBestLat = atof(mField[eBestLat].c_str());
-        mP2.mBestLon = atof(mField[eBestLon].c_str());
-        mP2.mBestAlt = atof(mField[eBestAlt].c_str());
-        mP2.mBestHepe = atof(mField[eBestHepe].c_str());
-        mP2.mBestAltUnc = atof(mField[eBestAltUnc].c_str());
+        mP2.mBestLat = atof(mField[eBestLat]);
+        mP2.mBestLon = atof(mField[eBestLon]);
+        mP2.mBestAlt = atof(mField[eBestAlt]);
+        mP2.mBestHepe = atof(mField[eBestHepe]);
+        mP2.mBestAltUnc = atof(mField[eBestAltUnc]);
     }
 
     inline SystemStatusPQWP2& get() { return mP2;}
@@ -395,17 +431,17 @@ public:
             return;
         }
         memset(&mP3, 0, sizeof(mP3));
-        mP3.mXtraValidMask = strtol(mField[eXtraValidMask].c_str(), NULL, 16);
-        mP3.mGpsXtraAge = atoi(mField[eGpsXtraAge].c_str());
-        mP3.mGloXtraAge = atoi(mField[eGloXtraAge].c_str());
-        mP3.mBdsXtraAge = atoi(mField[eBdsXtraAge].c_str());
-        mP3.mGalXtraAge = atoi(mField[eGalXtraAge].c_str());
-        mP3.mQzssXtraAge = atoi(mField[eQzssXtraAge].c_str());
-        mP3.mGpsXtraValid = strtol(mField[eGpsXtraValid].c_str(), NULL, 16);
-        mP3.mGloXtraValid = strtol(mField[eGloXtraValid].c_str(), NULL, 16);
-        mP3.mBdsXtraValid = strtol(mField[eBdsXtraValid].c_str(), NULL, 16);
-        mP3.mGalXtraValid = strtol(mField[eGalXtraValid].c_str(), NULL, 16);
-        mP3.mQzssXtraValid = strtol(mField[eQzssXtraValid].c_str(), NULL, 16);
+        mP3.mXtraValidMask = strtol(mField[eXtraValidMask], NULL, 16);
+        mP3.mGpsXtraAge = atoi(mField[eGpsXtraAge]);
+        mP3.mGloXtraAge = atoi(mField[eGloXtraAge]);
+        mP3.mBdsXtraAge = atoi(mField[eBdsXtraAge]);
+        mP3.mGalXtraAge = atoi(mField[eGalXtraAge]);
+        mP3.mQzssXtraAge = atoi(mField[eQzssXtraAge]);
+        mP3.mGpsXtraValid = strtol(mField[eGpsXtraValid], NULL, 16);
+        mP3.mGloXtraValid = strtol(mField[eGloXtraValid], NULL, 16);
+        mP3.mBdsXtraValid = strtol(mField[eBdsXtraValid], NULL, 16);
+        mP3.mGalXtraValid = strtol(mField[eGalXtraValid], NULL, 16);
+        mP3.mQzssXtraValid = strtol(mField[eQzssXtraValid], NULL, 16);
     }
 
     inline SystemStatusPQWP3& get() { return mP3;}
@@ -454,11 +490,11 @@ public:
             return;
         }
         memset(&mP4, 0, sizeof(mP4));
-        mP4.mGpsEpheValid = strtol(mField[eGpsEpheValid].c_str(), NULL, 16);
-        mP4.mGloEpheValid = strtol(mField[eGloEpheValid].c_str(), NULL, 16);
-        mP4.mBdsEpheValid = strtol(mField[eBdsEpheValid].c_str(), NULL, 16);
-        mP4.mGalEpheValid = strtol(mField[eGalEpheValid].c_str(), NULL, 16);
-        mP4.mQzssEpheValid = strtol(mField[eQzssEpheValid].c_str(), NULL, 16);
+        mP4.mGpsEpheValid = strtol(mField[eGpsEpheValid], NULL, 16);
+        mP4.mGloEpheValid = strtol(mField[eGloEpheValid], NULL, 16);
+        mP4.mBdsEpheValid = strtol(mField[eBdsEpheValid], NULL, 16);
+        mP4.mGalEpheValid = strtol(mField[eGalEpheValid], NULL, 16);
+        mP4.mQzssEpheValid = strtol(mField[eQzssEpheValid], NULL, 16);
     }
 
     inline SystemStatusPQWP4& get() { return mP4;}
@@ -537,21 +573,21 @@ public:
             return;
         }
         memset(&mP5, 0, sizeof(mP5));
-        mP5.mGpsUnknownMask = strtol(mField[eGpsUnknownMask].c_str(), NULL, 16);
-        mP5.mGloUnknownMask = strtol(mField[eGloUnknownMask].c_str(), NULL, 16);
-        mP5.mBdsUnknownMask = strtol(mField[eBdsUnknownMask].c_str(), NULL, 16);
-        mP5.mGalUnknownMask = strtol(mField[eGalUnknownMask].c_str(), NULL, 16);
-        mP5.mQzssUnknownMask = strtol(mField[eQzssUnknownMask].c_str(), NULL, 16);
-        mP5.mGpsGoodMask = strtol(mField[eGpsGoodMask].c_str(), NULL, 16);
-        mP5.mGloGoodMask = strtol(mField[eGloGoodMask].c_str(), NULL, 16);
-        mP5.mBdsGoodMask = strtol(mField[eBdsGoodMask].c_str(), NULL, 16);
-        mP5.mGalGoodMask = strtol(mField[eGalGoodMask].c_str(), NULL, 16);
-        mP5.mQzssGoodMask = strtol(mField[eQzssGoodMask].c_str(), NULL, 16);
-        mP5.mGpsBadMask = strtol(mField[eGpsBadMask].c_str(), NULL, 16);
-        mP5.mGloBadMask = strtol(mField[eGloBadMask].c_str(), NULL, 16);
-        mP5.mBdsBadMask = strtol(mField[eBdsBadMask].c_str(), NULL, 16);
-        mP5.mGalBadMask = strtol(mField[eGalBadMask].c_str(), NULL, 16);
-        mP5.mQzssBadMask = strtol(mField[eQzssBadMask].c_str(), NULL, 16);
+        mP5.mGpsUnknownMask = strtol(mField[eGpsUnknownMask], NULL, 16);
+        mP5.mGloUnknownMask = strtol(mField[eGloUnknownMask], NULL, 16);
+        mP5.mBdsUnknownMask = strtol(mField[eBdsUnknownMask], NULL, 16);
+        mP5.mGalUnknownMask = strtol(mField[eGalUnknownMask], NULL, 16);
+        mP5.mQzssUnknownMask = strtol(mField[eQzssUnknownMask], NULL, 16);
+        mP5.mGpsGoodMask = strtol(mField[eGpsGoodMask], NULL, 16);
+        mP5.mGloGoodMask = strtol(mField[eGloGoodMask], NULL, 16);
+        mP5.mBdsGoodMask = strtol(mField[eBdsGoodMask], NULL, 16);
+        mP5.mGalGoodMask = strtol(mField[eGalGoodMask], NULL, 16);
+        mP5.mQzssGoodMask = strtol(mField[eQzssGoodMask], NULL, 16);
+        mP5.mGpsBadMask = strtol(mField[eGpsBadMask], NULL, 16);
+        mP5.mGloBadMask = strtol(mField[eGloBadMask], NULL, 16);
+        mP5.mBdsBadMask = strtol(mField[eBdsBadMask], NULL, 16);
+        mP5.mGalBadMask = strtol(mField[eGalBadMask], NULL, 16);
+        mP5.mQzssBadMask = strtol(mField[eQzssBadMask], NULL, 16);
     }
 
     inline SystemStatusPQWP5& get() { return mP5;}
@@ -588,7 +624,7 @@ public:
             return;
         }
         memset(&mP6, 0, sizeof(mP6));
-        mP6.mFixInfoMask = strtol(mField[eFixInfoMask].c_str(), NULL, 16);
+        mP6.mFixInfoMask = strtol(mField[eFixInfoMask], NULL, 16);
     }
 
     inline SystemStatusPQWP6& get() { return mP6;}
@@ -623,9 +659,9 @@ public:
             return;
         }
         for (uint32_t i=0; i<SV_ALL_NUM; i++) {
-            mP7.mNav[i].mType   = GnssEphemerisType(atoi(mField[i*3+2].c_str()));
-            mP7.mNav[i].mSource = GnssEphemerisSource(atoi(mField[i*3+3].c_str()));
-            mP7.mNav[i].mAgeSec = atoi(mField[i*3+4].c_str());
+            mP7.mNav[i].mType   = GnssEphemerisType(atoi(mField[i*3+2]));
+            mP7.mNav[i].mSource = GnssEphemerisSource(atoi(mField[i*3+3]));
+            mP7.mNav[i].mAgeSec = atoi(mField[i*3+4]);
         }
     }
 
@@ -666,8 +702,8 @@ public:
             return;
         }
         memset(&mS1, 0, sizeof(mS1));
-        mS1.mFixInfoMask = atoi(mField[eFixInfoMask].c_str());
-        mS1.mHepeLimit = atoi(mField[eHepeLimit].c_str());
+        mS1.mFixInfoMask = atoi(mField[eFixInfoMask]);
+        mS1.mHepeLimit = atoi(mField[eHepeLimit]);
     }
 
     inline SystemStatusPQWS1& get() { return mS1;}
@@ -1218,24 +1254,81 @@ SystemStatus::SystemStatus(const MsgTask* msgTask) :
 {
     int result = 0;
     ENTRY_LOG ();
-    mCache.mLocation.clear();
+    uint32_t historySize = SystemStatusHistory<SystemStatusLocation>::DEFAULT_CAPACITY;
+    const loc_param_s_type gps_conf_param_table[] =
+    {
+        {"SYSTEM_STATUS_HISTORY_SIZE", &historySize, nullptr, 'n'},
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, gps_conf_param_table);
+    mCache.setCapacity(historySize);
+    LOC_LOGD("SystemStatus history size: %u", mCache.mLocation.capacity());
 
-    mCache.mTimeAndClock.clear();
-    mCache.mXoState.clear();
-    mCache.mRfAndParams.clear();
-    mCache.mErrRecovery.clear();
+    EXIT_LOG_WITH_ERROR ("%d",result);
+}
 
-    mCache.mInjectedPosition.clear();
-    mCache.mBestPosition.clear();
-    mCache.mXtra.clear();
-    mCache.mEphemeris.clear();
-    mCache.mSvHealth.clear();
-    mCache.mPdr.clear();
-    mCache.mNavData.clear();
+/******************************************************************************
+ SystemStatusReports
+******************************************************************************/
+template <typename T>
+static inline void copyLatest(SystemStatusHistory<T>& to,
+                              const SystemStatusHistory<T>& from, bool selected)
+{
+    if (selected && !from.empty()) {
+        to.push_back(from.back());
+    }
+}
 
-    mCache.mPositionFailure.clear();
+template <typename T>
+static inline void dumpLatest(SystemStatusHistory<T>& history, bool selected)
+{
+    if (selected && !history.empty()) {
+        history.back().dump();
+    }
+}
 
-    EXIT_LOG_WITH_ERROR ("%d",result);
+void SystemStatusReports::setCapacity(uint32_t capacity)
+{
+    mLocation.setCapacity(capacity);
+
+    mTimeAndClock.setCapacity(capacity);
+    mXoState.setCapacity(capacity);
+    mRfAndParams.setCapacity(capacity);
+    mErrRecovery.setCapacity(capacity);
+
+    mInjectedPosition.setCapacity(capacity);
+    mBestPosition.setCapacity(capacity);
+    mXtra.setCapacity(capacity);
+    mEphemeris.setCapacity(capacity);
+    mSvHealth.setCapacity(capacity);
+    mPdr.setCapacity(capacity);
+    mNavData.setCapacity(capacity);
+
+    mPositionFailure.setCapacity(capacity);
+
+    mGpsState.setCapacity(capacity);
+    mNetworkInfo.setCapacity(capacity);
+    mTac.setCapacity(capacity);
+    mMccMnc.setCapacity(capacity);
+}
+
+void SystemStatusReports::dump(SystemStatusReportMask mask)
+{
+    dumpLatest(mLocation, mask & SYSTEM_STATUS_REPORT_LOCATION_BIT);
+
+    dumpLatest(mTimeAndClock, mask & SYSTEM_STATUS_REPORT_TIME_AND_CLOCK_BIT);
+    dumpLatest(mXoState, mask & SYSTEM_STATUS_REPORT_XO_STATE_BIT);
+    dumpLatest(mRfAndParams, mask & SYSTEM_STATUS_REPORT_RF_AND_PARAMS_BIT);
+    dumpLatest(mErrRecovery, mask & SYSTEM_STATUS_REPORT_ERR_RECOVERY_BIT);
+
+    dumpLatest(mInjectedPosition, mask & SYSTEM_STATUS_REPORT_INJECTED_POSITION_BIT);
+    dumpLatest(mBestPosition, mask & SYSTEM_STATUS_REPORT_BEST_POSITION_BIT);
+    dumpLatest(mXtra, mask & SYSTEM_STATUS_REPORT_XTRA_BIT);
+    dumpLatest(mEphemeris, mask & SYSTEM_STATUS_REPORT_EPHEMERIS_BIT);
+    dumpLatest(mSvHealth, mask & SYSTEM_STATUS_REPORT_SV_HEALTH_BIT);
+    dumpLatest(mPdr, mask & SYSTEM_STATUS_REPORT_PDR_BIT);
+    dumpLatest(mNavData, mask & SYSTEM_STATUS_REPORT_NAV_DATA_BIT);
+
+    dumpLatest(mPositionFailure, mask & SYSTEM_STATUS_REPORT_POSITION_FAILURE_BIT);
 }
 
 /******************************************************************************
@@ -1248,9 +1341,6 @@ bool SystemStatus::setTimeAndCLock(const SystemStatusPQWM1& nmea)
         mCache.mTimeAndClock.back().mUtcReported = s.mUtcReported;
     } else {
         mCache.mTimeAndClock.push_back(s);
-        if (mCache.mTimeAndClock.size() > maxTimeAndClock) {
-            mCache.mTimeAndClock.erase(mCache.mTimeAndClock.begin());
-        }
     }
     return true;
 }
@@ -1262,9 +1352,6 @@ bool SystemStatus::setXoState(const SystemStatusPQWM1& nmea)
         mCache.mXoState.back().mUtcReported = s.mUtcReported;
     } else {
         mCache.mXoState.push_back(s);
-        if (mCache.mXoState.size() > maxXoState) {
-            mCache.mXoState.erase(mCache.mXoState.begin());
-        }
     }
     return true;
 }
@@ -1276,9 +1363,6 @@ bool SystemStatus::setRfAndParams(const SystemStatusPQWM1& nmea)
         mCache.mRfAndParams.back().mUtcReported = s.mUtcReported;
     } else {
         mCache.mRfAndParams.push_back(s);
-        if (mCache.mRfAndParams.size() > maxRfAndParams) {
-            mCache.mRfAndParams.erase(mCache.mRfAndParams.begin());
-        }
     }
     return true;
 }
@@ -1290,9 +1374,6 @@ bool SystemStatus::setErrRecovery(const SystemStatusPQWM1& nmea)
         mCache.mErrRecovery.back().mUtcReported = s.mUtcReported;
     } else {
         mCache.mErrRecovery.push_back(s);
-        if (mCache.mErrRecovery.size() > maxErrRecovery) {
-            mCache.mErrRecovery.erase(mCache.mErrRecovery.begin());
-        }
     }
     return true;
 }
@@ -1307,9 +1388,6 @@ bool SystemStatus::setInjectedPosition(const SystemStatusPQWP1& nmea)
         mCache.mInjectedPosition.back().mUtcReported = s.mUtcReported;
     } else {
         mCache.mInjectedPosition.push_back(s);
-        if (mCache.mInjectedPosition.size() > maxInjectedPosition) {
-            mCache.mInjectedPosition.erase(mCache.mInjectedPosition.begin());
-        }
     }
     return true;
 }
@@ -1321,9 +1399,6 @@ bool SystemStatus::setBestPosition(const SystemStatusPQWP2& nmea)
         mCache.mBestPosition.back().mUtcReported = s.mUtcReported;
     } else {
         mCache.mBestPosition.push_back(s);
-        if (mCache.mBestPosition.size() > maxBestPosition) {
-            mCache.mBestPosition.erase(mCache.mBestPosition.begin());
-        }
     }
     return true;
 }
@@ -1335,9 +1410,6 @@ bool SystemStatus::setXtra(const SystemStatusPQWP3& nmea)
         mCache.mXtra.back().mUtcReported = s.mUtcReported;
     } else {
         mCache.mXtra.push_back(s);
-        if (mCache.mXtra.size() > maxXtra) {
-            mCache.mXtra.erase(mCache.mXtra.begin());
-        }
     }
     return true;
 }
@@ -1349,9 +1421,6 @@ bool SystemStatus::setEphemeris(const SystemStatusPQWP4& nmea)
         mCache.mEphemeris.back().mUtcReported = s.mUtcReported;
     } else {
         mCache.mEphemeris.push_back(s);
-        if (mCache.mEphemeris.size() > maxEphemeris) {
-            mCache.mEphemeris.erase(mCache.mEphemeris.begin());
-        }
     }
     return true;
 }
@@ -1363,9 +1432,6 @@ bool SystemStatus::setSvHealth(const SystemStatusPQWP5& nmea)
         mCache.mSvHealth.back().mUtcReported = s.mUtcReported;
     } else {
         mCache.mSvHealth.push_back(s);
-        if (mCache.mSvHealth.size() > maxSvHealth) {
-            mCache.mSvHealth.erase(mCache.mSvHealth.begin());
-        }
     }
     return true;
 }
@@ -1377,9 +1443,6 @@ bool SystemStatus::setPdr(const SystemStatusPQWP6& nmea)
         mCache.mPdr.back().mUtcReported = s.mUtcReported;
     } else {
         mCache.mPdr.push_back(s);
-        if (mCache.mPdr.size() > maxPdr) {
-            mCache.mPdr.erase(mCache.mPdr.begin());
-        }
     }
     return true;
 }
@@ -1391,9 +1454,6 @@ bool SystemStatus::setNavData(const SystemStatusPQWP7& nmea)
         mCache.mNavData.back().mUtcReported = s.mUtcReported;
     } else {
         mCache.mNavData.push_back(s);
-        if (mCache.mNavData.size() > maxNavData) {
-            mCache.mNavData.erase(mCache.mNavData.begin());
-        }
     }
     return true;
 }
@@ -1408,9 +1468,6 @@ bool SystemStatus::setPositionFailure(const SystemStatusPQWS1& nmea)
         mCache.mPositionFailure.back().mUtcReported = s.mUtcReported;
     } else {
         mCache.mPositionFailure.push_back(s);
-        if (mCache.mPositionFailure.size() > maxPositionFailure) {
-            mCache.mPositionFailure.erase(mCache.mPositionFailure.begin());
-        }
     }
     return true;
 }
@@ -1430,9 +1487,6 @@ bool SystemStatus::setNetworkInfo(IDataItemCore* dataitem)
         mCache.mNetworkInfo.back().mUtcReported = s.mUtcReported;
     } else {
         mCache.mNetworkInfo.push_back(s);
-        if (mCache.mNetworkInfo.size() > maxNetworkInfo) {
-            mCache.mNetworkInfo.erase(mCache.mNetworkInfo.begin());
-        }
     }
     return true;
 }
@@ -1463,14 +1517,12 @@ bool SystemStatus::setNmeaString(const char *data, uint32_t len)
         return false;
     }
 
-    char buf[SystemStatusNmeaBase::NMEA_MAXSIZE + 1] = { 0 };
-    strlcpy(buf, data, sizeof(buf));
-
+    // data is NUL terminated by all callers, parsers read it in place
     pthread_mutex_lock(&mMutexSystemStatus);
 
     // parse the received nmea strings here
     if      (0 == strncmp(data, "$PQWM1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        SystemStatusPQWM1 s = SystemStatusPQWM1parser(buf, len).get();
+        SystemStatusPQWM1 s = SystemStatusPQWM1parser(data, len).get();
         ret  = setTimeAndCLock(s);
         ret |= setXoState(s);
         ret |= setRfAndParams(s);
@@ -1478,35 +1530,35 @@ bool SystemStatus::setNmeaString(const char *data, uint32_t len)
         cnt_m1++;
     }
     else if (0 == strncmp(data, "$PQWP1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        ret = setInjectedPosition(SystemStatusPQWP1parser(buf, len).get());
+        ret = setInjectedPosition(SystemStatusPQWP1parser(data, len).get());
         cnt_p1++;
     }
     else if (0 == strncmp(data, "$PQWP2", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        ret = setBestPosition(SystemStatusPQWP2parser(buf, len).get());
+        ret = setBestPosition(SystemStatusPQWP2parser(data, len).get());
         cnt_p2++;
     }
     else if (0 == strncmp(data, "$PQWP3", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        ret = setXtra(SystemStatusPQWP3parser(buf, len).get());
+        ret = setXtra(SystemStatusPQWP3parser(data, len).get());
         cnt_p3++;
     }
     else if (0 == strncmp(data, "$PQWP4", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        ret = setEphemeris(SystemStatusPQWP4parser(buf, len).get());
+        ret = setEphemeris(SystemStatusPQWP4parser(data, len).get());
         cnt_p4++;
     }
     else if (0 == strncmp(data, "$PQWP5", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        ret = setSvHealth(SystemStatusPQWP5parser(buf, len).get());
+        ret = setSvHealth(SystemStatusPQWP5parser(data, len).get());
         cnt_p5++;
     }
     else if (0 == strncmp(data, "$PQWP6", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        ret = setPdr(SystemStatusPQWP6parser(buf, len).get());
+        ret = setPdr(SystemStatusPQWP6parser(data, len).get());
         cnt_p6++;
     }
     else if (0 == strncmp(data, "$PQWP7", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        ret = setNavData(SystemStatusPQWP7parser(buf, len).get());
+        ret = setNavData(SystemStatusPQWP7parser(data, len).get());
         cnt_p7++;
     }
     else if (0 == strncmp(data, "$PQWS1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        ret = setPositionFailure(SystemStatusPQWS1parser(buf, len).get());
+        ret = setPositionFailure(SystemStatusPQWS1parser(data, len).get());
         cnt_s1++;
     }
     else {
@@ -1540,15 +1592,14 @@ bool SystemStatus::eventPosition(const UlpLocation& location,
                                  const GpsLocationExtended& locationEx)
 {
     SystemStatusLocation s(location, locationEx);
+    pthread_mutex_lock(&mMutexSystemStatus);
     if (!mCache.mLocation.empty() && mCache.mLocation.back().equals(s)) {
         mCache.mLocation.back().mUtcReported = s.mUtcReported;
     }
     else {
         mCache.mLocation.push_back(s);
-        if (mCache.mLocation.size() > maxLocation) {
-            mCache.mLocation.erase(mCache.mLocation.begin());
-        }
     }
+    pthread_mutex_unlock(&mMutexSystemStatus);
     LOC_LOGV("eventPosition - lat=%f lon=%f alt=%f speed=%f",
              s.mLocation.gpsLocation.latitude,
              s.mLocation.gpsLocation.longitude,
@@ -1587,101 +1638,66 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
 ******************************************************************************/
 bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) const
 {
-    pthread_mutex_lock(&mMutexSystemStatus);
-
     if (isLatestOnly) {
         // push back only the latest report and return it
-        report.mLocation.clear();
-        if (mCache.mLocation.size() >= 1) {
-            report.mLocation.push_back(mCache.mLocation.back());
-            report.mLocation.back().dump();
-        }
+        return getLatestReport(report, SYSTEM_STATUS_REPORT_ALL);
+    }
 
-        report.mTimeAndClock.clear();
-        if (mCache.mTimeAndClock.size() >= 1) {
-            report.mTimeAndClock.push_back(mCache.mTimeAndClock.back());
-            report.mTimeAndClock.back().dump();
-        }
-        report.mXoState.clear();
-        if (mCache.mXoState.size() >= 1) {
-            report.mXoState.push_back(mCache.mXoState.back());
-            report.mXoState.back().dump();
-        }
-        report.mRfAndParams.clear();
-        if (mCache.mRfAndParams.size() >= 1) {
-            report.mRfAndParams.push_back(mCache.mRfAndParams.back());
-            report.mRfAndParams.back().dump();
-        }
-        report.mErrRecovery.clear();
-        if (mCache.mErrRecovery.size() >= 1) {
-            report.mErrRecovery.push_back(mCache.mErrRecovery.back());
-            report.mErrRecovery.back().dump();
-        }
+    // copy entire reports and return them
+    pthread_mutex_lock(&mMutexSystemStatus);
+    report = mCache;
+    pthread_mutex_unlock(&mMutexSystemStatus);
+    return true;
+}
 
-        report.mInjectedPosition.clear();
-        if (mCache.mInjectedPosition.size() >= 1) {
-            report.mInjectedPosition.push_back(mCache.mInjectedPosition.back());
-            report.mInjectedPosition.back().dump();
-        }
-        report.mBestPosition.clear();
-        if (mCache.mBestPosition.size() >= 1) {
-            report.mBestPosition.push_back(mCache.mBestPosition.back());
-            report.mBestPosition.back().dump();
-        }
-        report.mXtra.clear();
-        if (mCache.mXtra.size() >= 1) {
-            report.mXtra.push_back(mCache.mXtra.back());
-            report.mXtra.back().dump();
-        }
-        report.mEphemeris.clear();
-        if (mCache.mEphemeris.size() >= 1) {
-            report.mEphemeris.push_back(mCache.mEphemeris.back());
-            report.mEphemeris.back().dump();
-        }
-        report.mSvHealth.clear();
-        if (mCache.mSvHealth.size() >= 1) {
-            report.mSvHealth.push_back(mCache.mSvHealth.back());
-            report.mSvHealth.back().dump();
-        }
-        report.mPdr.clear();
-        if (mCache.mPdr.size() >= 1) {
-            report.mPdr.push_back(mCache.mPdr.back());
-            report.mPdr.back().dump();
-        }
-        report.mNavData.clear();
-        if (mCache.mNavData.size() >= 1) {
-            report.mNavData.push_back(mCache.mNavData.back());
-            report.mNavData.back().dump();
-        }
+/******************************************************************************
+@brief      API to get a snapshot of the latest report of selected types
 
-        report.mPositionFailure.clear();
-        if (mCache.mPositionFailure.size() >= 1) {
-            report.mPositionFailure.push_back(mCache.mPositionFailure.back());
-            report.mPositionFailure.back().dump();
-        }
-    }
-    else {
-        // copy entire reports and return them
-        report.mLocation.clear();
-
-        report.mTimeAndClock.clear();
-        report.mXoState.clear();
-        report.mRfAndParams.clear();
-        report.mErrRecovery.clear();
-
-        report.mInjectedPosition.clear();
-        report.mBestPosition.clear();
-        report.mXtra.clear();
-        report.mEphemeris.clear();
-        report.mSvHealth.clear();
-        report.mPdr.clear();
-        report.mNavData.clear();
-
-        report.mPositionFailure.clear();
-        report = mCache;
-    }
+@param[In]  reference to report buffer, each history ends up with at most
+            the latest entry of its type
+@param[In]  mask of the report types to copy, other types are left empty
+
+@return     true when successfully done
+******************************************************************************/
+bool SystemStatus::getLatestReport(SystemStatusReports& report,
+                                   SystemStatusReportMask mask) const
+{
+    // only one entry per type is copied, keep the lock hold time to that
+    report.setCapacity(1);
 
+    pthread_mutex_lock(&mMutexSystemStatus);
+    copyLatest(report.mLocation, mCache.mLocation,
+               mask & SYSTEM_STATUS_REPORT_LOCATION_BIT);
+
+    copyLatest(report.mTimeAndClock, mCache.mTimeAndClock,
+               mask & SYSTEM_STATUS_REPORT_TIME_AND_CLOCK_BIT);
+    copyLatest(report.mXoState, mCache.mXoState,
+               mask & SYSTEM_STATUS_REPORT_XO_STATE_BIT);
+    copyLatest(report.mRfAndParams, mCache.mRfAndParams,
+               mask & SYSTEM_STATUS_REPORT_RF_AND_PARAMS_BIT);
+    copyLatest(report.mErrRecovery, mCache.mErrRecovery,
+               mask & SYSTEM_STATUS_REPORT_ERR_RECOVERY_BIT);
+
+    copyLatest(report.mInjectedPosition, mCache.mInjectedPosition,
+               mask & SYSTEM_STATUS_REPORT_INJECTED_POSITION_BIT);
+    copyLatest(report.mBestPosition, mCache.mBestPosition,
+               mask & SYSTEM_STATUS_REPORT_BEST_POSITION_BIT);
+    copyLatest(report.mXtra, mCache.mXtra,
+               mask & SYSTEM_STATUS_REPORT_XTRA_BIT);
+    copyLatest(report.mEphemeris, mCache.mEphemeris,
+               mask & SYSTEM_STATUS_REPORT_EPHEMERIS_BIT);
+    copyLatest(report.mSvHealth, mCache.mSvHealth,
+               mask & SYSTEM_STATUS_REPORT_SV_HEALTH_BIT);
+    copyLatest(report.mPdr, mCache.mPdr,
+               mask & SYSTEM_STATUS_REPORT_PDR_BIT);
+    copyLatest(report.mNavData, mCache.mNavData,
+               mask & SYSTEM_STATUS_REPORT_NAV_DATA_BIT);
+
+    copyLatest(report.mPositionFailure, mCache.mPositionFailure,
+               mask & SYSTEM_STATUS_REPORT_POSITION_FAILURE_BIT);
     pthread_mutex_unlock(&mMutexSystemStatus);
+
+    report.dump(mask);
     return true;
 }
 
@@ -1697,60 +1713,21 @@ bool SystemStatus::setDefaultReport(void)
     pthread_mutex_lock(&mMutexSystemStatus);
 
     mCache.mLocation.push_back(SystemStatusLocation());
-    if (mCache.mLocation.size() > maxLocation) {
-        mCache.mLocation.erase(mCache.mLocation.begin());
-    }
 
     mCache.mTimeAndClock.push_back(SystemStatusTimeAndClock());
-    if (mCache.mTimeAndClock.size() > maxTimeAndClock) {
-        mCache.mTimeAndClock.erase(mCache.mTimeAndClock.begin());
-    }
     mCache.mXoState.push_back(SystemStatusXoState());
-    if (mCache.mXoState.size() > maxXoState) {
-        mCache.mXoState.erase(mCache.mXoState.begin());
-    }
     mCache.mRfAndParams.push_back(SystemStatusRfAndParams());
-    if (mCache.mRfAndParams.size() > maxRfAndParams) {
-        mCache.mRfAndParams.erase(mCache.mRfAndParams.begin());
-    }
     mCache.mErrRecovery.push_back(SystemStatusErrRecovery());
-    if (mCache.mErrRecovery.size() > maxErrRecovery) {
-        mCache.mErrRecovery.erase(mCache.mErrRecovery.begin());
-    }
 
     mCache.mInjectedPosition.push_back(SystemStatusInjectedPosition());
-    if (mCache.mInjectedPosition.size() > maxInjectedPosition) {
-        mCache.mInjectedPosition.erase(mCache.mInjectedPosition.begin());
-    }
     mCache.mBestPosition.push_back(SystemStatusBestPosition());
-    if (mCache.mBestPosition.size() > maxBestPosition) {
-        mCache.mBestPosition.erase(mCache.mBestPosition.begin());
-    }
     mCache.mXtra.push_back(SystemStatusXtra());
-    if (mCache.mXtra.size() > maxXtra) {
-        mCache.mXtra.erase(mCache.mXtra.begin());
-    }
     mCache.mEphemeris.push_back(SystemStatusEphemeris());
-    if (mCache.mEphemeris.size() > maxEphemeris) {
-        mCache.mEphemeris.erase(mCache.mEphemeris.begin());
-    }
     mCache.mSvHealth.push_back(SystemStatusSvHealth());
-    if (mCache.mSvHealth.size() > maxSvHealth) {
-        mCache.mSvHealth.erase(mCache.mSvHealth.begin());
-    }
     mCache.mPdr.push_back(SystemStatusPdr());
-    if (mCache.mPdr.size() > maxPdr) {
-        mCache.mPdr.erase(mCache.mPdr.begin());
-    }
     mCache.mNavData.push_back(SystemStatusNavData());
-    if (mCache.mNavData.size() > maxNavData) {
-        mCache.mNavData.erase(mCache.mNavData.begin());
-    }
 
     mCache.mPositionFailure.push_back(SystemStatusPositionFailure());
-    if (mCache.mPositionFailure.size() > maxPositionFailure) {
-        mCache.mPositionFailure.erase(mCache.mPositionFailure.begin());
-    }
 
     pthread_mutex_unlock(&mMutexSystemStatus);
     return true;
@@ -1786,3 +1763,90 @@ bool SystemStatus::eventConnectionStatus(bool connected, uint8_t type)
 
 } // namespace loc_core
 
+
+#ifdef __LOC_DEBUG__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+using namespace loc_core;
+
+struct PqwBench {
+    const char* mTag;
+    uint32_t mCount;
+    uint64_t mNs;
+};
+
+template <typename PARSER>
+static uint64_t benchParser(const char* str, uint32_t len, int loops)
+{
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < loops; i++) {
+        PARSER p(str, len);
+        (void)p.get();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0.tv_sec) * 1000000000ULL + t1.tv_nsec - t0.tv_nsec;
+}
+
+// compilation: g++ -D__LOC_HOST_DEBUG__ -D__LOC_DEBUG__ -g -I. -I../utils -I../location -I../../../../vendor/qcom/proprietary/gps-internal/unit-tests/fakes_for_host -I../../../../system/core/include SystemStatus.cpp
+// test: ./a.out <debug-nmea corpus, one sentence per line> [loops]
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("usage: %s <corpus> [loops]\n", argv[0]);
+        return 1;
+    }
+    FILE* fp = fopen(argv[1], "r");
+    if (NULL == fp) {
+        printf("can not open %s\n", argv[1]);
+        return 1;
+    }
+    int loops = (argc > 2) ? atoi(argv[2]) : 1000;
+    PqwBench bench[] = {
+        { "$PQWM1", 0, 0 }, { "$PQWP1", 0, 0 }, { "$PQWP2", 0, 0 },
+        { "$PQWP3", 0, 0 }, { "$PQWP4", 0, 0 }, { "$PQWP5", 0, 0 },
+        { "$PQWP6", 0, 0 }, { "$PQWP7", 0, 0 }, { "$PQWS1", 0, 0 }
+    };
+    char line[SystemStatusNmeaBase::NMEA_MAXSIZE + 1];
+
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        uint32_t len = strlen(line);
+        if (len < SystemStatusNmeaBase::NMEA_MINSIZE) {
+            continue;
+        }
+        uint64_t ns = 0;
+        uint32_t i = 0;
+        for (; i < sizeof(bench) / sizeof(bench[0]); i++) {
+            if (0 == strncmp(line, bench[i].mTag, SystemStatusNmeaBase::NMEA_MINSIZE)) {
+                break;
+            }
+        }
+        switch (i) {
+        case 0: ns = benchParser<SystemStatusPQWM1parser>(line, len, loops); break;
+        case 1: ns = benchParser<SystemStatusPQWP1parser>(line, len, loops); break;
+        case 2: ns = benchParser<SystemStatusPQWP2parser>(line, len, loops); break;
+        case 3: ns = benchParser<SystemStatusPQWP3parser>(line, len, loops); break;
+        case 4: ns = benchParser<SystemStatusPQWP4parser>(line, len, loops); break;
+        case 5: ns = benchParser<SystemStatusPQWP5parser>(line, len, loops); break;
+        case 6: ns = benchParser<SystemStatusPQWP6parser>(line, len, loops); break;
+        case 7: ns = benchParser<SystemStatusPQWP7parser>(line, len, loops); break;
+        case 8: ns = benchParser<SystemStatusPQWS1parser>(line, len, loops); break;
+        default: continue;
+        }
+        bench[i].mCount++;
+        bench[i].mNs += ns;
+    }
+    fclose(fp);
+
+    for (uint32_t i = 0; i < sizeof(bench) / sizeof(bench[0]); i++) {
+        if (bench[i].mCount > 0) {
+            printf("%s: %u sentences, %llu ns/sentence\n", bench[i].mTag, bench[i].mCount,
+                   (unsigned long long)(bench[i].mNs / ((uint64_t)bench[i].mCount * loops)));
+        }
+    }
+    return 0;
+}
+
+#endif
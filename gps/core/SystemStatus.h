@@ -32,6 +32,7 @@
 #include <stdint.h>
 #include <string>
 #include <vector>
+#include <new>
 #include <platform_lib_log_util.h>
 #include <MsgTask.h>
 #include <IDataItemCore.h>
@@ -529,38 +530,158 @@ public:
     }
 };
 
+/******************************************************************************
+ SystemStatusHistory
+******************************************************************************/
+// Fixed-capacity ring holding the most recent reports of one type, oldest
+// first. Storage is allocated once on the first push_back(); once full, each
+// push_back() overwrites the oldest entry in place.
+template <typename T>
+class SystemStatusHistory
+{
+public:
+    static const uint32_t DEFAULT_CAPACITY = 5;
+    static const uint32_t MAX_CAPACITY = 64;
+
+    inline SystemStatusHistory(uint32_t capacity = DEFAULT_CAPACITY) :
+        mItems(nullptr), mCapacity(clamp(capacity)), mHead(0), mSize(0) {}
+    inline SystemStatusHistory(const SystemStatusHistory& peer) :
+        mItems(nullptr), mCapacity(peer.mCapacity), mHead(0), mSize(0) {
+        append(peer);
+    }
+    inline ~SystemStatusHistory() {
+        clear();
+        ::operator delete(mItems);
+    }
+    inline SystemStatusHistory& operator=(const SystemStatusHistory& peer) {
+        if (this != &peer) {
+            setCapacity(peer.mCapacity);
+            append(peer);
+        }
+        return *this;
+    }
+
+    // drops all entries; storage is reallocated only if capacity changes
+    inline void setCapacity(uint32_t capacity) {
+        clear();
+        capacity = clamp(capacity);
+        if (capacity != mCapacity) {
+            ::operator delete(mItems);
+            mItems = nullptr;
+            mCapacity = capacity;
+        }
+    }
+    inline uint32_t capacity() const { return mCapacity; }
+    inline uint32_t size() const { return mSize; }
+    inline bool empty() const { return (0 == mSize); }
+
+    // index 0 is the oldest entry, size()-1 the latest
+    inline T& operator[](uint32_t i) { return mItems[slot(i)]; }
+    inline const T& operator[](uint32_t i) const { return mItems[slot(i)]; }
+    inline T& front() { return mItems[mHead]; }
+    inline const T& front() const { return mItems[mHead]; }
+    inline T& back() { return mItems[slot(mSize - 1)]; }
+    inline const T& back() const { return mItems[slot(mSize - 1)]; }
+
+    inline void push_back(const T& item) {
+        if (nullptr == mItems) {
+            mItems = static_cast<T*>(::operator new(sizeof(T) * mCapacity));
+        }
+        if (mSize < mCapacity) {
+            new (&mItems[slot(mSize)]) T(item);
+            mSize++;
+        } else {
+            mItems[mHead] = item;
+            mHead = slot(1);
+        }
+    }
+    inline void clear() {
+        for (uint32_t i = 0; i < mSize; i++) {
+            mItems[slot(i)].~T();
+        }
+        mHead = 0;
+        mSize = 0;
+    }
+
+private:
+    T*       mItems;
+    uint32_t mCapacity;
+    uint32_t mHead;
+    uint32_t mSize;
+
+    static inline uint32_t clamp(uint32_t capacity) {
+        if (0 == capacity) {
+            capacity = 1;
+        } else if (capacity > MAX_CAPACITY) {
+            capacity = MAX_CAPACITY;
+        }
+        return capacity;
+    }
+    inline uint32_t slot(uint32_t i) const {
+        i += mHead;
+        return (i >= mCapacity) ? (i - mCapacity) : i;
+    }
+    inline void append(const SystemStatusHistory& peer) {
+        uint32_t skip = (peer.mSize > mCapacity) ? (peer.mSize - mCapacity) : 0;
+        for (uint32_t i = skip; i < peer.mSize; i++) {
+            push_back(peer[i]);
+        }
+    }
+};
+
 /******************************************************************************
  SystemStatusReports
 ******************************************************************************/
+typedef uint32_t SystemStatusReportMask;
+typedef enum {
+    SYSTEM_STATUS_REPORT_LOCATION_BIT          = (1<<0),
+    SYSTEM_STATUS_REPORT_TIME_AND_CLOCK_BIT    = (1<<1),
+    SYSTEM_STATUS_REPORT_XO_STATE_BIT          = (1<<2),
+    SYSTEM_STATUS_REPORT_RF_AND_PARAMS_BIT     = (1<<3),
+    SYSTEM_STATUS_REPORT_ERR_RECOVERY_BIT      = (1<<4),
+    SYSTEM_STATUS_REPORT_INJECTED_POSITION_BIT = (1<<5),
+    SYSTEM_STATUS_REPORT_BEST_POSITION_BIT     = (1<<6),
+    SYSTEM_STATUS_REPORT_XTRA_BIT              = (1<<7),
+    SYSTEM_STATUS_REPORT_EPHEMERIS_BIT         = (1<<8),
+    SYSTEM_STATUS_REPORT_SV_HEALTH_BIT         = (1<<9),
+    SYSTEM_STATUS_REPORT_PDR_BIT               = (1<<10),
+    SYSTEM_STATUS_REPORT_NAV_DATA_BIT          = (1<<11),
+    SYSTEM_STATUS_REPORT_POSITION_FAILURE_BIT  = (1<<12),
+    SYSTEM_STATUS_REPORT_ALL                   = 0x1FFF
+} SystemStatusReportBits;
+
 class SystemStatusReports
 {
 public:
     // from QMI_LOC indication
-    std::vector<SystemStatusLocation>         mLocation;
+    SystemStatusHistory<SystemStatusLocation>         mLocation;
 
     // from ME debug NMEA
-    std::vector<SystemStatusTimeAndClock>     mTimeAndClock;
-    std::vector<SystemStatusXoState>          mXoState;
-    std::vector<SystemStatusRfAndParams>      mRfAndParams;
-    std::vector<SystemStatusErrRecovery>      mErrRecovery;
+    SystemStatusHistory<SystemStatusTimeAndClock>     mTimeAndClock;
+    SystemStatusHistory<SystemStatusXoState>          mXoState;
+    SystemStatusHistory<SystemStatusRfAndParams>      mRfAndParams;
+    SystemStatusHistory<SystemStatusErrRecovery>      mErrRecovery;
 
     // from PE debug NMEA
-    std::vector<SystemStatusInjectedPosition> mInjectedPosition;
-    std::vector<SystemStatusBestPosition>     mBestPosition;
-    std::vector<SystemStatusXtra>             mXtra;
-    std::vector<SystemStatusEphemeris>        mEphemeris;
-    std::vector<SystemStatusSvHealth>         mSvHealth;
-    std::vector<SystemStatusPdr>              mPdr;
-    std::vector<SystemStatusNavData>          mNavData;
+    SystemStatusHistory<SystemStatusInjectedPosition> mInjectedPosition;
+    SystemStatusHistory<SystemStatusBestPosition>     mBestPosition;
+    SystemStatusHistory<SystemStatusXtra>             mXtra;
+    SystemStatusHistory<SystemStatusEphemeris>        mEphemeris;
+    SystemStatusHistory<SystemStatusSvHealth>         mSvHealth;
+    SystemStatusHistory<SystemStatusPdr>              mPdr;
+    SystemStatusHistory<SystemStatusNavData>          mNavData;
 
     // from SM debug NMEA
-    std::vector<SystemStatusPositionFailure>  mPositionFailure;
+    SystemStatusHistory<SystemStatusPositionFailure>  mPositionFailure;
 
     // from dataitems observer
-    std::vector<SystemStatusGpsState>         mGpsState;
-    std::vector<SystemStatusNetworkInfo>      mNetworkInfo;
-    std::vector<SystemStatusTac>              mTac;
-    std::vector<SystemStatusMccMnc>           mMccMnc;
+    SystemStatusHistory<SystemStatusGpsState>         mGpsState;
+    SystemStatusHistory<SystemStatusNetworkInfo>      mNetworkInfo;
+    SystemStatusHistory<SystemStatusTac>              mTac;
+    SystemStatusHistory<SystemStatusMccMnc>           mMccMnc;
+
+    void setCapacity(uint32_t capacity);
+    void dump(SystemStatusReportMask mask);
 };
 
 /******************************************************************************
@@ -579,28 +700,6 @@ private:
     // Data members
     static pthread_mutex_t                    mMutexSystemStatus;
 
-    static const uint32_t                     maxLocation = 5;
-
-    static const uint32_t                     maxTimeAndClock = 5;
-    static const uint32_t                     maxXoState = 5;
-    static const uint32_t                     maxRfAndParams = 5;
-    static const uint32_t                     maxErrRecovery = 5;
-
-    static const uint32_t                     maxInjectedPosition = 5;
-    static const uint32_t                     maxBestPosition = 5;
-    static const uint32_t                     maxXtra = 5;
-    static const uint32_t                     maxEphemeris = 5;
-    static const uint32_t                     maxSvHealth = 5;
-    static const uint32_t                     maxPdr = 5;
-    static const uint32_t                     maxNavData = 5;
-
-    static const uint32_t                     maxPositionFailure = 5;
-
-    static const uint32_t                     maxGpsState = 5;
-    static const uint32_t                     maxNetworkInfo = 5;
-    static const uint32_t                     maxTac = 5;
-    static const uint32_t                     maxMccMnc = 5;
-
     SystemStatusReports mCache;
     bool mConnected;
 
@@ -634,6 +733,7 @@ public:
     bool eventDataItemNotify(IDataItemCore* dataitem);
     bool setNmeaString(const char *data, uint32_t len);
     bool getReport(SystemStatusReports& reports, bool isLatestonly = false) const;
+    bool getLatestReport(SystemStatusReports& reports, SystemStatusReportMask mask) const;
     bool setDefaultReport(void);
     bool eventConnectionStatus(bool connected, uint8_t type);
 };
@@ -45,6 +45,7 @@
 #include <SystemStatus.h>
 
 #include <vector>
+#include <new>
 
 #define RAD2DEG    (180.0 / M_PI)
 
@@ -63,6 +64,7 @@ GnssAdapter::GnssAdapter() :
     mControlCallbacks(),
     mPowerVoteId(0),
     mNmeaMask(0),
+    mNmeaBuffer(nullptr),
     mNiData(),
     mAgpsManager(),
     mAgpsCbInfo(),
@@ -1941,7 +1943,11 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
         }
     };
 
-    sendMsg(new MsgReportPosition(*this, ulpLocation, locationExtended, status, techMask));
+    // fix path: place the msg in the task's slab pool, heap only as fallback
+    void* buf = mMsgTask->allocMsg(sizeof(MsgReportPosition));
+    sendMsg((nullptr != buf) ?
+            new (buf) MsgReportPosition(*this, ulpLocation, locationExtended, status, techMask) :
+            new MsgReportPosition(*this, ulpLocation, locationExtended, status, techMask));
 }
 
 void
@@ -1998,11 +2004,9 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
                           (0 == ulpLocation.gpsLocation.longitude) &&
                           (LOC_RELIABILITY_NOT_SET == locationExtended.horizontal_reliability));
         uint8_t generate_nmea = (reported && status != LOC_SESS_FAILURE && !blank_fix);
-        std::vector<std::string> nmeaArraystr;
-        loc_nmea_generate_pos(ulpLocation, locationExtended, generate_nmea, nmeaArraystr);
-        for (auto sentence : nmeaArraystr) {
-            reportNmea(sentence.c_str(), sentence.length());
-        }
+        LocNmeaBuffer* nmea = getNmeaBuffer();
+        loc_nmea_generate_pos(ulpLocation, locationExtended, generate_nmea, *nmea);
+        reportNmea(*nmea);
     }
 
     // Free the allocated memory for rawData
@@ -2041,7 +2045,10 @@ GnssAdapter::reportSvEvent(const GnssSvNotification& svNotify,
         }
     };
 
-    sendMsg(new MsgReportSv(*this, svNotify));
+    void* buf = mMsgTask->allocMsg(sizeof(MsgReportSv));
+    sendMsg((nullptr != buf) ?
+            new (buf) MsgReportSv(*this, svNotify) :
+            new MsgReportSv(*this, svNotify));
 }
 
 void
@@ -2102,11 +2109,9 @@ GnssAdapter::reportSv(GnssSvNotification& svNotify)
     }
 
     if (NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER && !mTrackingSessions.empty()) {
-        std::vector<std::string> nmeaArraystr;
-        loc_nmea_generate_sv(svNotify, nmeaArraystr);
-        for (auto sentence : nmeaArraystr) {
-            reportNmea(sentence.c_str(), sentence.length());
-        }
+        LocNmeaBuffer* nmea = getNmeaBuffer();
+        loc_nmea_generate_sv(svNotify, *nmea);
+        reportNmea(*nmea);
     }
 
     mGnssSvIdUsedInPosAvail = false;
@@ -2122,17 +2127,22 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length, bool fromUlp)
         }
     }
 
+    // with inlineNmea, the sentence is stored right behind the msg object,
+    // in the same block the msg is placed in
     struct MsgReportNmea : public LocMsg {
         GnssAdapter& mAdapter;
         const char* mNmea;
         size_t mLength;
+        bool mInlineNmea;
         inline MsgReportNmea(GnssAdapter& adapter,
                              const char* nmea,
-                             size_t length) :
+                             size_t length,
+                             bool inlineNmea) :
             LocMsg(),
             mAdapter(adapter),
-            mNmea(new char[length+1]),
-            mLength(length) {
+            mNmea(inlineNmea ? (const char*)(this + 1) : new char[length+1]),
+            mLength(length),
+            mInlineNmea(inlineNmea) {
                 if (mNmea == nullptr) {
                     LOC_LOGE("%s] new allocation failed, fatal error.", __func__);
                     return;
@@ -2141,7 +2151,9 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length, bool fromUlp)
             }
         inline virtual ~MsgReportNmea()
         {
-            delete[] mNmea;
+            if (!mInlineNmea) {
+                delete[] mNmea;
+            }
         }
         inline virtual void proc() const {
             // extract bug report info - this returns true if consumed by systemstatus
@@ -2157,7 +2169,10 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length, bool fromUlp)
         }
     };
 
-    sendMsg(new MsgReportNmea(*this, nmea, length));
+    void* buf = mMsgTask->allocMsg(sizeof(MsgReportNmea) + length + 1);
+    sendMsg((nullptr != buf) ?
+            new (buf) MsgReportNmea(*this, nmea, length, true) :
+            new MsgReportNmea(*this, nmea, length, false));
 }
 
 void
@@ -2180,6 +2195,28 @@ GnssAdapter::reportNmea(const char* nmea, size_t length)
     }
 }
 
+void
+GnssAdapter::reportNmea(const LocNmeaBuffer& nmea)
+{
+    if (nmea.dropped() > 0) {
+        LOC_LOGW("%s]: %u NMEA sentences did not fit the buffer", __func__, nmea.dropped());
+    }
+    for (uint32_t i = 0; i < nmea.count(); i++) {
+        reportNmea(nmea.sentence(i), nmea.length(i));
+    }
+}
+
+LocNmeaBuffer*
+GnssAdapter::getNmeaBuffer()
+{
+    if (nullptr == mNmeaBuffer) {
+        mNmeaBuffer = new LocNmeaBuffer();
+    } else {
+        mNmeaBuffer->reset();
+    }
+    return mNmeaBuffer;
+}
+
 bool
 GnssAdapter::requestNiNotifyEvent(const GnssNiNotification &notify, const void* data)
 {
@@ -2896,7 +2933,13 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
     }
 
     SystemStatusReports reports = {};
-    systemstatus->getReport(reports, true);
+    systemstatus->getLatestReport(reports,
+                                  SYSTEM_STATUS_REPORT_LOCATION_BIT |
+                                  SYSTEM_STATUS_REPORT_BEST_POSITION_BIT |
+                                  SYSTEM_STATUS_REPORT_TIME_AND_CLOCK_BIT |
+                                  SYSTEM_STATUS_REPORT_SV_HEALTH_BIT |
+                                  SYSTEM_STATUS_REPORT_XTRA_BIT |
+                                  SYSTEM_STATUS_REPORT_NAV_DATA_BIT);
 
     r.size = sizeof(r);
 
@@ -2979,6 +3022,18 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
     convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_GALILEO, reports);
     LOC_LOGV("getDebugReport - satellite=%zu", r.mSatelliteInfo.size());
 
+    // msg allocation block
+    LocMsgPoolStats poolStats = {};
+    mMsgTask->getMsgPoolStats(poolStats);
+    r.mMsgAlloc.size = sizeof(r.mMsgAlloc);
+    r.mMsgAlloc.pooledAllocs = poolStats.mAllocs;
+    r.mMsgAlloc.heapAllocs = poolStats.mMisses;
+    r.mMsgAlloc.inUse = poolStats.mInUse;
+    r.mMsgAlloc.peakInUse = poolStats.mPeakInUse;
+    LOC_LOGV("getDebugReport - msg pooled=%" PRIu64 " heap=%" PRIu64 " inuse=%u peak=%u",
+            r.mMsgAlloc.pooledAllocs, r.mMsgAlloc.heapAllocs,
+            r.mMsgAlloc.inUse, r.mMsgAlloc.peakInUse);
+
     return true;
 }
 
@@ -2990,7 +3045,9 @@ GnssAdapter::getAgcInformation(GnssMeasurementsNotification& measurements, int m
 
     if (nullptr != systemstatus) {
         SystemStatusReports reports = {};
-        systemstatus->getReport(reports, true);
+        systemstatus->getLatestReport(reports,
+                                      SYSTEM_STATUS_REPORT_RF_AND_PARAMS_BIT |
+                                      SYSTEM_STATUS_REPORT_TIME_AND_CLOCK_BIT);
 
         if ((!reports.mRfAndParams.empty()) && (!reports.mTimeAndClock.empty()) &&
             reports.mTimeAndClock.back().mTimeValid &&
@@ -36,6 +36,7 @@
 #include <Agps.h>
 #include <SystemStatus.h>
 #include <XtraSystemStatusObserver.h>
+#include <loc_nmea.h>
 
 #define MAX_URL_LEN 256
 #define NMEA_SENTENCE_MAX_LENGTH 200
@@ -98,6 +99,9 @@ class GnssAdapter : public LocAdapterBase {
     LocationControlCallbacks mControlCallbacks;
     uint32_t mPowerVoteId;
     uint32_t mNmeaMask;
+    // sentences of the latest epoch, reused for every epoch
+    LocNmeaBuffer* mNmeaBuffer;
+    LocNmeaBuffer* getNmeaBuffer();
 
     /* ==== NI ============================================================================= */
     NiData mNiData;
@@ -123,7 +127,10 @@ class GnssAdapter : public LocAdapterBase {
 public:
 
     GnssAdapter();
-    virtual inline ~GnssAdapter() { delete mUlpProxy; }
+    virtual inline ~GnssAdapter() {
+        delete mUlpProxy;
+        delete mNmeaBuffer;
+    }
 
     /* ==== SSR ============================================================================ */
     /* ======== EVENTS ====(Called from QMI Thread)========================================= */
@@ -245,6 +252,7 @@ public:
                         LocPosTechMask techMask);
     void reportSv(GnssSvNotification& svNotify);
     void reportNmea(const char* nmea, size_t length);
+    void reportNmea(const LocNmeaBuffer& nmea);
     bool requestNiNotify(const GnssNiNotification& notify, const void* data);
     void reportGnssMeasurementData(const GnssMeasurementsNotification& measurements);
 
@@ -646,11 +646,20 @@ typedef struct {
     float                               serverPredictionAgeSeconds;
 } GnssDebugSatelliteInfo;
 
+typedef struct {
+    size_t size;                        // set to sizeof
+    uint64_t                            pooledAllocs; // report msgs placed in the slab pool
+    uint64_t                            heapAllocs;   // report msgs that fell back to the heap
+    uint32_t                            inUse;        // slab blocks currently in use
+    uint32_t                            peakInUse;    // high water mark of inUse
+} GnssDebugMsgAlloc;
+
 typedef struct {
     size_t size;                        // set to sizeof
     GnssDebugLocation                   mLocation;
     GnssDebugTime                       mTime;
     std::vector<GnssDebugSatelliteInfo> mSatelliteInfo;
+    GnssDebugMsgAlloc                   mMsgAlloc;
 } GnssDebugReport;
 
 /* Provides the capabilities of the system
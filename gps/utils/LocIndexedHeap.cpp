@@ -0,0 +1,212 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <stdlib.h>
+#include <LocIndexedHeap.h>
+
+LocIndexedHeap::~LocIndexedHeap() {
+    for (uint32_t i = 0; i < mSize; i++) {
+        mNodes[i]->mHeapIndex = LocIndexedRankable::INVALID_INDEX;
+    }
+    free(mNodes);
+    mNodes = NULL;
+    mSize = 0;
+    mCapacity = 0;
+}
+
+void LocIndexedHeap::siftUp(uint32_t i) {
+    LocIndexedRankable* node = mNodes[i];
+    while (i > 0) {
+        uint32_t parent = parentOf(i);
+        if (!node->outRanks(*mNodes[parent])) {
+            break;
+        }
+        place(mNodes[parent], i);
+        i = parent;
+    }
+    place(node, i);
+}
+
+void LocIndexedHeap::siftDown(uint32_t i) {
+    LocIndexedRankable* node = mNodes[i];
+    for (uint32_t child = firstChildOf(i); child < mSize; child = firstChildOf(i)) {
+        // find the highest ranking of up to ARITY children
+        uint32_t top = child;
+        uint32_t last = (mSize - child > ARITY) ? (child + ARITY) : mSize;
+        for (child++; child < last; child++) {
+            if (mNodes[child]->outRanks(*mNodes[top])) {
+                top = child;
+            }
+        }
+        if (!mNodes[top]->outRanks(*node)) {
+            break;
+        }
+        place(mNodes[top], i);
+        i = top;
+    }
+    place(node, i);
+}
+
+bool LocIndexedHeap::push(LocIndexedRankable& node) {
+    if (node.isInHeap()) {
+        return false;
+    }
+    if (mSize == mCapacity) {
+        uint32_t capacity = (0 == mCapacity) ? 16 : (mCapacity << 1);
+        LocIndexedRankable** nodes = (LocIndexedRankable**)
+                realloc(mNodes, capacity * sizeof(LocIndexedRankable*));
+        if (NULL == nodes) {
+            return false;
+        }
+        mNodes = nodes;
+        mCapacity = capacity;
+    }
+    place(&node, mSize++);
+    siftUp(node.mHeapIndex);
+    return true;
+}
+
+LocIndexedRankable* LocIndexedHeap::pop() {
+    LocIndexedRankable* top = NULL;
+    if (mSize > 0) {
+        top = mNodes[0];
+        remove(*top);
+    }
+    return top;
+}
+
+LocIndexedRankable* LocIndexedHeap::remove(LocIndexedRankable& node) {
+    uint32_t i = node.mHeapIndex;
+    if (i >= mSize || mNodes[i] != &node) {
+        return NULL;
+    }
+
+    node.mHeapIndex = LocIndexedRankable::INVALID_INDEX;
+    LocIndexedRankable* last = mNodes[--mSize];
+    if (i < mSize) {
+        // move the last node into the hole, then restore the heap order
+        // in whichever direction it is violated
+        place(last, i);
+        if (i > 0 && last->outRanks(*mNodes[parentOf(i)])) {
+            siftUp(i);
+        } else {
+            siftDown(i);
+        }
+    }
+    return &node;
+}
+
+#ifdef __LOC_UNIT_TEST__
+bool LocIndexedHeap::checkHeap() {
+    for (uint32_t i = 0; i < mSize; i++) {
+        if (mNodes[i]->mHeapIndex != i ||
+            (i > 0 && mNodes[i]->outRanks(*mNodes[parentOf(i)]))) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+#ifdef __LOC_DEBUG__
+
+#include <stdio.h>
+#include <time.h>
+
+class LocIndexedHeapDebugData : public LocIndexedRankable {
+public:
+    const int mID;
+    LocIndexedHeapDebugData(int id) : mID(id) {}
+    inline virtual int ranks(LocRankable& rankable) {
+        LocIndexedHeapDebugData* testData = static_cast<LocIndexedHeapDebugData*>(&rankable);
+        return testData->mID - mID;
+    }
+};
+
+// For Linux command line testing:
+// compilation: g++ -D__LOC_HOST_DEBUG__ -D__LOC_DEBUG__ -D__LOC_UNIT_TEST__ -g -I. -I../../../../vendor/qcom/proprietary/gps-internal/unit-tests/fakes_for_host -I../../../../system/core/include LocIndexedHeap.cpp
+// test: valgrind --leak-check=full ./a.out 100000
+int main(int argc, char** argv) {
+    srand(time(NULL));
+    int tries = (argc > 1) ? atoi(argv[1]) : 1000;
+    int checks = (tries >> 3) ? (tries >> 3) : 1;
+    LocIndexedHeap heap;
+    LocIndexedHeapDebugData** data = new LocIndexedHeapDebugData*[tries];
+    int count = 0;
+
+    for (int i = 0; i < tries; i++) {
+        int r = rand();
+        if (0 == count || (r & 3) < 2) {
+            data[count] = new LocIndexedHeapDebugData(r >> 2);
+            heap.push(*data[count++]);
+        } else if ((r & 3) == 2) {
+            // remove a random node, not necessarily the top
+            int k = (r >> 2) % count;
+            if (heap.remove(*data[k]) != data[k]) {
+                printf("remove of %dth node failed at %dth op\n", k, i);
+                return 1;
+            }
+            delete data[k];
+            data[k] = data[--count];
+        } else {
+            LocIndexedHeapDebugData* top = (LocIndexedHeapDebugData*)heap.pop();
+            for (int k = 0; k < count; k++) {
+                if (data[k] == top) {
+                    data[k] = data[--count];
+                    break;
+                }
+                if (data[k]->mID < top->mID) {
+                    printf("pop returned %d while %d is in the heap\n", top->mID, data[k]->mID);
+                    return 1;
+                }
+            }
+            delete top;
+        }
+        if (heap.size() != (uint32_t)count || (i % checks == 0 && !heap.checkHeap())) {
+            printf("heap check failed at %dth op\n", i);
+            return 1;
+        }
+    }
+
+    int last = -1;
+    for (LocIndexedHeapDebugData* top = (LocIndexedHeapDebugData*)heap.pop();
+         NULL != top; top = (LocIndexedHeapDebugData*)heap.pop()) {
+        if (top->mID < last) {
+            printf("pop out of order: %d after %d\n", top->mID, last);
+            return 1;
+        }
+        last = top->mID;
+        delete top;
+    }
+    delete[] data;
+    printf("success!\n");
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,107 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_INDEXED_HEAP__
+#define __LOC_INDEXED_HEAP__
+
+#include <stdint.h>
+#include <LocHeap.h>
+
+// a LocRankable that remembers where it sits in a LocIndexedHeap, so that it
+// can be removed from the heap without a search. An obj can be in at most one
+// heap at a time.
+class LocIndexedRankable : public LocRankable {
+    friend class LocIndexedHeap;
+    // position in the heap array; INVALID_INDEX when not in a heap
+    uint32_t mHeapIndex;
+public:
+    static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+    inline LocIndexedRankable() : LocRankable(), mHeapIndex(INVALID_INDEX) {}
+    inline virtual ~LocIndexedRankable() {}
+    inline bool isInHeap() const { return INVALID_INDEX != mHeapIndex; }
+};
+
+// an array backed d-ary heap. Same ordering semantics as LocHeap, i.e. the
+// highest ranking node is on the top, but nodes are kept in one contiguous
+// array of pointers instead of separately allocated tree nodes. The array
+// only grows, so once warmed up, push / pop / remove do not allocate. All
+// operations are O(log n); remove() takes the node itself and does not need
+// to search the heap.
+class LocIndexedHeap {
+protected:
+    static const uint32_t ARITY = 4;
+    LocIndexedRankable** mNodes;
+    uint32_t mSize;
+    uint32_t mCapacity;
+
+    static inline uint32_t parentOf(uint32_t i) { return (i - 1) / ARITY; }
+    static inline uint32_t firstChildOf(uint32_t i) { return i * ARITY + 1; }
+
+    // node at index i of the heap array, NULL if i is out of range.
+    // Children of node i are at firstChildOf(i) .. firstChildOf(i) + ARITY - 1
+    inline LocIndexedRankable* at(uint32_t i) { return (i < mSize) ? mNodes[i] : NULL; }
+
+private:
+    inline void place(LocIndexedRankable* node, uint32_t i) {
+        mNodes[i] = node;
+        node->mHeapIndex = i;
+    }
+    void siftUp(uint32_t i);
+    void siftDown(uint32_t i);
+
+public:
+    inline LocIndexedHeap() : mNodes(NULL), mSize(0), mCapacity(0) {}
+    // nodes are owned by the client, they are only detached here.
+    ~LocIndexedHeap();
+
+    // node is reference to an obj that is managed by client, that client
+    //      creates and destroyes. The destroy should happen after the
+    //      node is popped out from or removed from the heap.
+    // Returns false if node is already in a heap or the array can't grow
+    bool push(LocIndexedRankable& node);
+
+    // Returns NULL if the heap is empty, otherwise pointer to the node that
+    //         has currently the highest ranking
+    inline LocIndexedRankable* peek() { return (mSize > 0) ? mNodes[0] : NULL; }
+
+    // Return - pointer to the node popped out, or NULL if heap is already empty
+    LocIndexedRankable* pop();
+
+    // removes the given node from the heap.
+    // returns the pointer to the node removed; or NULL if the node is not
+    //         in this heap.
+    LocIndexedRankable* remove(LocIndexedRankable& node);
+
+    inline uint32_t size() { return mSize; }
+
+#ifdef __LOC_UNIT_TEST__
+    bool checkHeap();
+#endif
+};
+
+#endif //__LOC_INDEXED_HEAP__
@@ -0,0 +1,165 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocMsgPool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// header in front of every block; while a block is free, mNext links it
+// into the free stack of its size class
+struct LocMsgPoolBlock {
+    LocMsgPool* mPool;
+    uint32_t mClass;
+    uint32_t mNext;
+};
+
+// keeps the LocMsg that follows the header aligned like malloc() would
+#define LOC_MSG_POOL_HDR_SIZE 16
+#define LOC_MSG_POOL_NIL 0xFFFFFFFF
+
+// block sizes are picked to fit an NMEA sentence, a position report and
+// an SV report respectively, as those are sent for every fix
+static const struct {
+    size_t blockSize;
+    uint32_t count;
+} sSizeClasses[] = {
+    { 256,  64 },
+    { 1024, 32 },
+    { 2560, 16 }
+};
+
+LocMsgPool::LocMsgPool() : mSlab(NULL), mSlabSize(0) {
+    memset(&mStats, 0, sizeof(mStats));
+
+    size_t offset = 0;
+    for (uint32_t c = 0; c < NUM_CLASSES; c++) {
+        mClasses[c].mBlockSize = sSizeClasses[c].blockSize;
+        mClasses[c].mCount = sSizeClasses[c].count;
+        mClasses[c].mOffset = offset;
+        mClasses[c].mHead = LOC_MSG_POOL_NIL;
+        offset += mClasses[c].mBlockSize * mClasses[c].mCount;
+    }
+
+    if (0 != posix_memalign((void**)&mSlab, LOC_MSG_POOL_HDR_SIZE, offset)) {
+        mSlab = NULL;
+        for (uint32_t c = 0; c < NUM_CLASSES; c++) {
+            mClasses[c].mCount = 0;
+        }
+        return;
+    }
+    mSlabSize = offset;
+
+    for (uint32_t c = 0; c < NUM_CLASSES; c++) {
+        // chain the blocks in ascending order, block 0 on top
+        for (uint32_t i = 0; i < mClasses[c].mCount; i++) {
+            LocMsgPoolBlock* blk = block(mClasses[c], i);
+            blk->mPool = this;
+            blk->mClass = c;
+            blk->mNext = (i + 1 < mClasses[c].mCount) ? i + 1 : LOC_MSG_POOL_NIL;
+        }
+        mClasses[c].mHead = (mClasses[c].mCount > 0) ? 0 : LOC_MSG_POOL_NIL;
+    }
+}
+
+LocMsgPool::~LocMsgPool() {
+    ::free(mSlab);
+}
+
+// The tag in the upper half of mHead is bumped on every update, so that a
+// pop() racing with a pop() / push() pair of the same block fails its CAS.
+LocMsgPoolBlock* LocMsgPool::pop(SizeClass& sizeClass) {
+    uint64_t head = __atomic_load_n(&sizeClass.mHead, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint32_t index = (uint32_t)head;
+        if (LOC_MSG_POOL_NIL == index) {
+            return NULL;
+        }
+        LocMsgPoolBlock* blk = block(sizeClass, index);
+        uint32_t next = __atomic_load_n(&blk->mNext, __ATOMIC_RELAXED);
+        uint64_t newHead = (((head >> 32) + 1) << 32) | next;
+        if (__atomic_compare_exchange_n(&sizeClass.mHead, &head, newHead, true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+            return blk;
+        }
+    }
+}
+
+void LocMsgPool::push(SizeClass& sizeClass, LocMsgPoolBlock* blk) {
+    uint32_t index = ((char*)blk - mSlab - sizeClass.mOffset) / sizeClass.mBlockSize;
+    uint64_t head = __atomic_load_n(&sizeClass.mHead, __ATOMIC_RELAXED);
+    for (;;) {
+        __atomic_store_n(&blk->mNext, (uint32_t)head, __ATOMIC_RELAXED);
+        uint64_t newHead = (((head >> 32) + 1) << 32) | index;
+        if (__atomic_compare_exchange_n(&sizeClass.mHead, &head, newHead, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+}
+
+void* LocMsgPool::alloc(size_t size) {
+    LocMsgPoolBlock* blk = NULL;
+    for (uint32_t c = 0; NULL == blk && c < NUM_CLASSES; c++) {
+        if (size + LOC_MSG_POOL_HDR_SIZE <= mClasses[c].mBlockSize) {
+            blk = pop(mClasses[c]);
+        }
+    }
+
+    if (NULL == blk) {
+        __atomic_fetch_add(&mStats.mMisses, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    __atomic_fetch_add(&mStats.mAllocs, 1, __ATOMIC_RELAXED);
+    uint32_t inUse = __atomic_add_fetch(&mStats.mInUse, 1, __ATOMIC_RELAXED);
+    uint32_t peak = __atomic_load_n(&mStats.mPeakInUse, __ATOMIC_RELAXED);
+    while (inUse > peak &&
+           !__atomic_compare_exchange_n(&mStats.mPeakInUse, &peak, inUse, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    return (char*)blk + LOC_MSG_POOL_HDR_SIZE;
+}
+
+void LocMsgPool::free(void* ptr) {
+    if (NULL != ptr) {
+        LocMsgPoolBlock* blk = (LocMsgPoolBlock*)((char*)ptr - LOC_MSG_POOL_HDR_SIZE);
+        LocMsgPool* pool = blk->mPool;
+        pool->push(pool->mClasses[blk->mClass], blk);
+        __atomic_fetch_add(&pool->mStats.mFrees, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&pool->mStats.mInUse, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void LocMsgPool::getStats(LocMsgPoolStats& stats) const {
+    stats.mAllocs = __atomic_load_n(&mStats.mAllocs, __ATOMIC_RELAXED);
+    stats.mMisses = __atomic_load_n(&mStats.mMisses, __ATOMIC_RELAXED);
+    stats.mFrees = __atomic_load_n(&mStats.mFrees, __ATOMIC_RELAXED);
+    stats.mInUse = __atomic_load_n(&mStats.mInUse, __ATOMIC_RELAXED);
+    stats.mPeakInUse = __atomic_load_n(&mStats.mPeakInUse, __ATOMIC_RELAXED);
+}
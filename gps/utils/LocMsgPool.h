@@ -0,0 +1,91 @@
+/* Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_MSG_POOL__
+#define __LOC_MSG_POOL__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// running counters of a LocMsgPool, all are monotonic except mInUse
+struct LocMsgPoolStats {
+    uint64_t mAllocs;     // allocations served from the pool
+    uint64_t mMisses;     // requests the pool could not serve (heap fallback)
+    uint64_t mFrees;      // blocks returned to the pool
+    uint32_t mInUse;      // blocks currently handed out
+    uint32_t mPeakInUse;  // high water mark of mInUse
+};
+
+// opaque class to provide service implementation.
+struct LocMsgPoolBlock;
+
+// A fixed size slab allocator for LocMsg objects. All blocks are carved
+// out of a single allocation made at construction, grouped in a few size
+// classes. alloc() may be called from any thread and never blocks or calls
+// into malloc; free() may be called from any thread as well. Each size
+// class keeps its free blocks on a tagged lock free stack.
+class LocMsgPool {
+    struct SizeClass {
+        size_t mBlockSize;        // including the block header
+        uint32_t mCount;
+        size_t mOffset;           // offset of the first block in mSlab
+        uint64_t mHead;           // tag << 32 | index of top free block
+    };
+    static const uint32_t NUM_CLASSES = 3;
+    SizeClass mClasses[NUM_CLASSES];
+    char* mSlab;
+    size_t mSlabSize;
+    LocMsgPoolStats mStats;
+
+    inline LocMsgPoolBlock* block(const SizeClass& sizeClass, uint32_t index) const {
+        return (LocMsgPoolBlock*)(mSlab + sizeClass.mOffset + index * sizeClass.mBlockSize);
+    }
+    LocMsgPoolBlock* pop(SizeClass& sizeClass);
+    void push(SizeClass& sizeClass, LocMsgPoolBlock* blk);
+public:
+    LocMsgPool();
+    ~LocMsgPool();
+
+    // Returns a block of at least size bytes, suitably aligned for any
+    // LocMsg; NULL if size is too large or all fitting blocks are in use,
+    // in which case the caller is expected to fall back to the heap.
+    void* alloc(size_t size);
+
+    // Returns ptr, obtained from alloc() of any pool, to its pool.
+    static void free(void* ptr);
+
+    // true if ptr was handed out by this pool
+    inline bool owns(const void* ptr) const {
+        return (const char*)ptr >= mSlab && (const char*)ptr < mSlab + mSlabSize;
+    }
+
+    // snapshot of the pool counters
+    void getStats(LocMsgPoolStats& stats) const;
+};
+
+#endif //__LOC_MSG_POOL__
@@ -36,7 +36,7 @@
 #include <sys/epoll.h>
 #include <unistd.h>
 #include <LocTimer.h>
-#include <LocHeap.h>
+#include <LocIndexedHeap.h>
 #include <LocThread.h>
 #include <LocSharedLock.h>
 #include <MsgTask.h>
@@ -64,13 +64,17 @@ LocTimerDelegate - an internal timer entity, which also is a LocRankable obj.
                    heap, its ranks() implementation decides where it is placed
                    in the heap.
 LocTimerContainer - core of the timer service. It is a container (derived from
-                    LocHeap) for LocTimerDelegate (implements LocRankable) objs.
-                    There are 2 of such containers, one for sw timers (or Linux
-                    timers) one for hw timers (or Linux alarms). It adds one of
-                    each (those that expire the soonest) to kernel via services
-                    provided by LocTimerPollTask. All the heap management on the
-                    LocTimerDelegate objs are done in the MsgTask context, such
-                    that synchronization is ensured.
+                    LocIndexedHeap) for LocTimerDelegate (implements
+                    LocIndexedRankable) objs. There are 2 of such containers,
+                    one for sw timers (or Linux timers) one for hw timers (or
+                    Linux alarms). It adds one of each (those that expire the
+                    soonest) to kernel via services provided by
+                    LocTimerPollTask. Timers started with a slack are coalesced,
+                    i.e. the kernel timer is armed at the latest time that still
+                    satisfies every timer whose window overlaps that of the
+                    soonest one, and all of them expire on that one wakeup. All
+                    the heap management on the LocTimerDelegate objs are done in
+                    the MsgTask context, such that synchronization is ensured.
 LocTimerPollTask - is a class that wraps timerfd and epoll POXIS APIs. It also
                    both implements LocRunnalbe with epoll_wait() in the run()
                    method. It is also a LocThread client, so as to loop the run
@@ -83,14 +87,15 @@ LocTimerWrapper - a LocTimer client itself, to implement the existing C API with
 class LocTimerPollTask;
 
 // This is a multi-functaional class that:
-// * extends the LocHeap class for the detection of head update upon add / remove
-//   events. When that happens, soonest time out changes, so timerfd needs update.
+// * extends the LocIndexedHeap class for the detection of head update upon add /
+//   remove events. When that happens, soonest time out changes, so timerfd needs
+//   update.
 // * contains the timers, and add / remove them into the heap
 // * provides and maps 2 of such containers, one for timers (or  mSwTimers), one
 //   for alarms (or mHwTimers);
 // * provides a polling thread;
 // * provides a MsgTask thread for synchronized add / remove / timer client callback.
-class LocTimerContainer : public LocHeap {
+class LocTimerContainer : public LocIndexedHeap {
     // mutex to synchronize getters of static members
     static pthread_mutex_t mMutex;
     // Container of timers
@@ -103,16 +108,24 @@ class LocTimerContainer : public LocHeap {
     static LocTimerPollTask* mPollTask;
     // timer / alarm fd
     int mDevFd;
+    // if mDevFd is armed and polled, and the time it is armed with
+    bool mArmed;
+    struct timespec mArmedTime;
     // ctor
     LocTimerContainer(bool wakeOnExpire);
     // dtor
     ~LocTimerContainer();
     static MsgTask* getMsgTaskLocked();
     static LocTimerPollTask* getPollTaskLocked();
-    // extend LocHeap and pop if the top outRanks input
+    // extend LocIndexedHeap and pop if the top outRanks input
     LocTimerDelegate* popIfOutRanks(LocTimerDelegate& timer);
-    // update the timer POSIX calls with updated soonest timer spec
-    void updateSoonestTime(LocTimerDelegate* priorTop);
+    // lower armTime to the latest time of any timer in the subtree at index i
+    // that is due before armTime
+    void getArmTime(uint32_t i, struct timespec& armTime);
+    // update the timer POSIX calls with updated soonest timer spec.
+    // removed - timer just removed from the heap, if any, which might have
+    //           been the one that decided the armed time
+    void updateSoonestTime(LocTimerDelegate* removed = NULL);
 
 public:
     // factory method to control the creation of mSwTimers / mHwTimers
@@ -126,6 +139,10 @@ public:
     void remove(LocTimerDelegate& timer);
     // handling of timer / alarm expiration
     void expire();
+#ifdef __LOC_DEBUG__
+    // number of timer fd wakeups, to measure coalescing
+    static uint32_t mWakeups;
+#endif
 };
 
 // This class implements the polling thread that epolls imer / alarm fds.
@@ -171,27 +188,46 @@ public:
 // Internal class of timer obj. It gets born when client calls LocTimer::start();
 // and gets deleted when client calls LocTimer::stop() or when the it expire()'s.
 // This class implements LocRankable::ranks() so that when an obj is added into
-// the container (of LocHeap), it gets placed in sorted order.
-class LocTimerDelegate : public LocRankable {
+// the container (of LocIndexedHeap), it gets placed in sorted order.
+class LocTimerDelegate : public LocIndexedRankable {
     friend class LocTimerContainer;
     friend class LocTimer;
     LocTimer* mClient;
     LocSharedLock* mLock;
     struct timespec mFutureTime;
+    // mFutureTime plus the slack the client tolerates
+    struct timespec mLatestTime;
     LocTimerContainer* mContainer;
     // not a complete obj, just ctor for LocRankable comparisons
     inline LocTimerDelegate(struct timespec& delay)
-        : mClient(NULL), mLock(NULL), mFutureTime(delay), mContainer(NULL) {}
+        : mClient(NULL), mLock(NULL), mFutureTime(delay), mLatestTime(delay),
+          mContainer(NULL) {}
     inline ~LocTimerDelegate() { if (mLock) { mLock->drop(); mLock = NULL; } }
 public:
-    LocTimerDelegate(LocTimer& client, struct timespec& futureTime, LocTimerContainer* container);
+    LocTimerDelegate(LocTimer& client, struct timespec& futureTime,
+                     struct timespec& latestTime, LocTimerContainer* container);
     void destroyLocked();
     // LocRankable virtual method
     virtual int ranks(LocRankable& rankable);
     void expire();
     inline struct timespec getFutureTime() { return mFutureTime; }
+    inline struct timespec getLatestTime() { return mLatestTime; }
 };
 
+static inline bool isEarlier(const struct timespec& time, const struct timespec& than) {
+    return (time.tv_sec < than.tv_sec) ||
+           ((time.tv_sec == than.tv_sec) && (time.tv_nsec < than.tv_nsec));
+}
+
+static inline void addMs(struct timespec& time, uint32_t ms) {
+    time.tv_sec += ms / 1000;
+    time.tv_nsec += (ms % 1000) * 1000000;
+    if (time.tv_nsec >= 1000000000) {
+        time.tv_sec += time.tv_nsec / 1000000000;
+        time.tv_nsec %= 1000000000;
+    }
+}
+
 /***************************LocTimerContainer methods***************************/
 
 // Most of these static recources are created on demand. They however are never
@@ -204,13 +240,18 @@ LocTimerContainer* LocTimerContainer::mSwTimers = NULL;
 LocTimerContainer* LocTimerContainer::mHwTimers = NULL;
 MsgTask* LocTimerContainer::mMsgTask = NULL;
 LocTimerPollTask* LocTimerContainer::mPollTask = NULL;
+#ifdef __LOC_DEBUG__
+uint32_t LocTimerContainer::mWakeups = 0;
+#endif
 
 // ctor - initialize timer heaps
 // A container for swTimer (timer) is created, when wakeOnExpire is true; or
 // HwTimer (alarm), when wakeOnExpire is false.
 LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
-    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)) {
+    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)),
+    mArmed(false) {
 
+    memset(&mArmedTime, 0, sizeof(mArmedTime));
     if ((-1 == mDevFd) && (errno == EINVAL)) {
         LOC_LOGW("%s: timerfd_create failure, fallback to CLOCK_MONOTONIC - %s",
             __FUNCTION__, strerror(errno));
@@ -279,31 +320,55 @@ int LocTimerContainer::getTimerFd() {
     return mDevFd;
 }
 
-void LocTimerContainer::updateSoonestTime(LocTimerDelegate* priorTop) {
+void LocTimerContainer::getArmTime(uint32_t i, struct timespec& armTime) {
+    LocTimerDelegate* timer = (LocTimerDelegate*)(at(i));
+
+    // children are never due before their parent, so a subtree whose top is
+    // not due before armTime can not lower it any further
+    if (timer && isEarlier(timer->mFutureTime, armTime)) {
+        if (isEarlier(timer->mLatestTime, armTime)) {
+            armTime = timer->mLatestTime;
+        }
+        for (uint32_t child = firstChildOf(i), last = child + ARITY; child < last; child++) {
+            getArmTime(child, armTime);
+        }
+    }
+}
+
+void LocTimerContainer::updateSoonestTime(LocTimerDelegate* removed) {
     LocTimerDelegate* curTop = getSoonestTimer();
+    struct itimerspec delay;
+    memset(&delay, 0, sizeof(struct itimerspec));
 
-    // check if top has changed
-    if (curTop != priorTop) {
-        struct itimerspec delay;
-        memset(&delay, 0, sizeof(struct itimerspec));
-        bool toSetTime = false;
-        // if tree is empty now, we remove poll and disarm timer
-        if (!curTop) {
+    // if tree is empty now, we remove poll and disarm timer
+    if (!curTop) {
+        if (mArmed) {
+            mArmed = false;
             mPollTask->removePoll(*this);
             // setting the values to disarm timer
-            delay.it_value.tv_sec = 0;
-            delay.it_value.tv_nsec = 0;
-            toSetTime = true;
-        } else if (!priorTop || curTop->outRanks(*priorTop)) {
+            timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
+        }
+        return;
+    }
+
+    // the soonest time that all the timers due in the window of the top
+    // timer can be expired together
+    delay.it_value = curTop->getLatestTime();
+    getArmTime(0, delay.it_value);
+
+    // rearm if the new time is sooner, or if the removed timer might have been
+    // the one the current time was armed for
+    if (!mArmed || isEarlier(delay.it_value, mArmedTime) ||
+        (removed && !isEarlier(mArmedTime, removed->getFutureTime()) &&
+         isEarlier(mArmedTime, delay.it_value))) {
+        if (!mArmed) {
             // do this first to avoid race condition, in case settime is called
             // with too small an interval
             mPollTask->addPoll(*this);
-            delay.it_value = curTop->getFutureTime();
-            toSetTime = true;
-        }
-        if (toSetTime) {
-            timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
+            mArmed = true;
         }
+        mArmedTime = delay.it_value;
+        timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
     }
 }
 
@@ -312,14 +377,12 @@ inline
 void LocTimerContainer::add(LocTimerDelegate& timer) {
     struct MsgTimerPush : public LocMsg {
         LocTimerContainer* mTimerContainer;
-        LocHeapNode* mTree;
         LocTimerDelegate* mTimer;
         inline MsgTimerPush(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
-            LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
-            mTimerContainer->push((LocRankable&)(*mTimer));
-            mTimerContainer->updateSoonestTime(priorTop);
+            mTimerContainer->push(*mTimer);
+            mTimerContainer->updateSoonestTime();
         }
     };
 
@@ -334,14 +397,10 @@ void LocTimerContainer::remove(LocTimerDelegate& timer) {
         inline MsgTimerRemove(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
-            LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
-
             // update soonest timer only if mTimer is actually removed from
-            // mTimerContainer AND mTimer is not priorTop.
-            if (priorTop == ((LocHeap*)mTimerContainer)->remove((LocRankable&)*mTimer)) {
-                // if passing in NULL, we tell updateSoonestTime to update
-                // kernel with the current top timer interval.
-                mTimerContainer->updateSoonestTime(NULL);
+            // mTimerContainer, i.e. it has not expired already.
+            if (NULL != ((LocIndexedHeap*)mTimerContainer)->remove(*mTimer)) {
+                mTimerContainer->updateSoonestTime(mTimer);
             }
             // all timers are deleted here, and only here.
             delete mTimer;
@@ -364,18 +423,24 @@ void LocTimerContainer::expire() {
             // get time spec of now
             clock_gettime(CLOCK_BOOTTIME, &now);
             LocTimerDelegate timerOfNow(now);
+            // expire() below has disarmed the timer fd and removed it from poll
+            mTimerContainer->mArmed = false;
             // pop everything in the heap that outRanks now, i.e. has time older than now
-            // and then call expire() on that timer.
-            for (LocTimerDelegate* timer = (LocTimerDelegate*)mTimerContainer->pop();
+            // and then call expire() on that timer. With coalescing, that covers all
+            // the timers that were due within the window we were armed for.
+            for (LocTimerDelegate* timer = mTimerContainer->popIfOutRanks(timerOfNow);
                  NULL != timer;
                  timer = mTimerContainer->popIfOutRanks(timerOfNow)) {
                 // the timer delegate obj will be deleted before the return of this call
                 timer->expire();
             }
-            mTimerContainer->updateSoonestTime(NULL);
+            mTimerContainer->updateSoonestTime();
         }
     };
 
+#ifdef __LOC_DEBUG__
+    __atomic_add_fetch(&mWakeups, 1, __ATOMIC_RELAXED);
+#endif
     struct itimerspec delay;
     memset(&delay, 0, sizeof(struct itimerspec));
     timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
@@ -385,7 +450,7 @@ void LocTimerContainer::expire() {
 
 LocTimerDelegate* LocTimerContainer::popIfOutRanks(LocTimerDelegate& timer) {
     LocTimerDelegate* poppedNode = NULL;
-    if (mTree && !timer.outRanks(*peek())) {
+    if (size() > 0 && !timer.outRanks(*peek())) {
         poppedNode = (LocTimerDelegate*)(pop());
     }
 
@@ -477,10 +542,12 @@ bool LocTimerPollTask::run() {
 inline
 LocTimerDelegate::LocTimerDelegate(LocTimer& client,
                                    struct timespec& futureTime,
+                                   struct timespec& latestTime,
                                    LocTimerContainer* container)
     : mClient(&client),
       mLock(mClient->mLock->share()),
       mFutureTime(futureTime),
+      mLatestTime(latestTime),
       mContainer(container) {
     // adding the timer into the container
     mContainer->add(*this);
@@ -550,22 +617,23 @@ LocTimer::~LocTimer() {
 }
 
 bool LocTimer::start(unsigned int timeOutInMs, bool wakeOnExpire) {
+    return start(timeOutInMs, wakeOnExpire, 0);
+}
+
+bool LocTimer::start(uint32_t timeOutInMs, bool wakeOnExpire, uint32_t slackInMs) {
     bool success = false;
     mLock->lock();
     if (!mTimer) {
         struct timespec futureTime;
         clock_gettime(CLOCK_BOOTTIME, &futureTime);
-        futureTime.tv_sec += timeOutInMs / 1000;
-        futureTime.tv_nsec += (timeOutInMs % 1000) * 1000000;
-        if (futureTime.tv_nsec >= 1000000000) {
-            futureTime.tv_sec += futureTime.tv_nsec / 1000000000;
-            futureTime.tv_nsec %= 1000000000;
-        }
+        addMs(futureTime, timeOutInMs);
+        struct timespec latestTime = futureTime;
+        addMs(latestTime, slackInMs);
 
         LocTimerContainer* container;
         container = LocTimerContainer::get(wakeOnExpire);
         if (NULL != container) {
-            mTimer = new LocTimerDelegate(*this, futureTime, container);
+            mTimer = new LocTimerDelegate(*this, futureTime, latestTime, container);
             // if mTimer is non 0, success should be 0; or vice versa
         }
         success = (NULL != mTimer);
@@ -674,13 +742,15 @@ class LocTimerTest : public LocTimer, public LocRankable {
         return now;
     }
 public:
+    bool mExpired;
     inline LocTimerTest(int timeout) : LocTimer(), LocRankable(),
-            mTimeOut(timeout), mTimeOfBirth(getTimerWrapper(0)) {}
+            mTimeOut(timeout), mTimeOfBirth(getTimerWrapper(0)), mExpired(false) {}
     inline virtual int ranks(LocRankable& rankable) {
         LocTimerTest* timer = dynamic_cast<LocTimerTest*>(&rankable);
         return timer->mTimeOut - mTimeOut;
     }
     inline virtual void timeOutCallback() {
+        __atomic_store_n(&mExpired, true, __ATOMIC_RELEASE);
         printf("timeOutCallback() - ");
         deviation();
     }
@@ -692,39 +762,92 @@ public:
     }
 };
 
+// quiet timer for the benchmark, as thousands of them are running at once
+class LocTimerBench : public LocTimer {
+public:
+    static uint32_t mExpired;
+    inline virtual void timeOutCallback() {
+        __atomic_add_fetch(&mExpired, 1, __ATOMIC_RELAXED);
+    }
+};
+uint32_t LocTimerBench::mExpired = 0;
+
+// starts n timers due in [100, 1100) ms with the given slack, waits for all
+// of them to expire, and then reports the cost per start() / stop() and the
+// number of timer fd wakeups it took.
+void benchmark(int n, uint32_t slackInMs) {
+    LocTimerBench* timers = new LocTimerBench[n];
+    __atomic_store_n(&LocTimerBench::mExpired, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&LocTimerContainer::mWakeups, 0, __ATOMIC_RELAXED);
+
+    struct timespec from = getNow();
+    for (int i = 0; i < n; i++) {
+        timers[i].start(100 + rand() % 1000, false, slackInMs);
+    }
+    struct timespec to = getNow();
+    printf("slack %ums: start() %.0lf ns/timer\n", slackInMs,
+           getDeltaSeconds(from, to) * 1000000000 / n);
+
+    for (int i = 0; i < 30 &&
+             __atomic_load_n(&LocTimerBench::mExpired, __ATOMIC_RELAXED) < (uint32_t)n; i++) {
+        usleep(100000);
+    }
+    printf("slack %ums: %u of %d timers expired with %u wakeups\n", slackInMs,
+           __atomic_load_n(&LocTimerBench::mExpired, __ATOMIC_RELAXED), n,
+           __atomic_load_n(&LocTimerContainer::mWakeups, __ATOMIC_RELAXED));
+
+    // long running timers, stopped in random order, i.e. removed from the
+    // middle of the heap
+    for (int i = 0; i < n; i++) {
+        timers[i].start(60000, false, slackInMs);
+    }
+    from = getNow();
+    for (int i = 0; i < n; i++) {
+        timers[(i * 7919) % n].stop();
+    }
+    to = getNow();
+    printf("slack %ums: stop() %.0lf ns/timer\n", slackInMs,
+           getDeltaSeconds(from, to) * 1000000000 / n);
+
+    // let the MsgTask drain the removals before the timers go away
+    usleep(100000);
+    delete[] timers;
+}
+
 // For Linux command line testing:
 // compilation:
-//     g++ -D__LOC_HOST_DEBUG__ -D__LOC_DEBUG__ -g -I. -I../../../../system/core/include -o LocHeap.o LocHeap.cpp
+//     g++ -D__LOC_HOST_DEBUG__ -D__LOC_DEBUG__ -g -I. -I../../../../system/core/include -o LocIndexedHeap.o LocIndexedHeap.cpp
 //     g++ -D__LOC_HOST_DEBUG__ -D__LOC_DEBUG__ -g -std=c++0x -I. -I../../../../system/core/include -lpthread -o LocThread.o LocThread.cpp
 //     g++ -D__LOC_HOST_DEBUG__ -D__LOC_DEBUG__ -g -I. -I../../../../system/core/include -o LocTimer.o LocTimer.cpp
+// test: ./a.out 5000 [slack in ms]
 int main(int argc, char** argv) {
     struct timespec timeOfStart=getNow();
     srand(time(NULL));
     int tries = atoi(argv[1]);
-    int checks = tries >> 3;
     LocTimerTest** timerArray = new LocTimerTest*[tries];
-    memset(timerArray, NULL, tries);
+    memset(timerArray, 0, tries * sizeof(LocTimerTest*));
 
     for (int i = 0; i < tries; i++) {
         int r = rand() % tries;
-        LocTimerTest* timer = new LocTimerTest(r);
         if (timerArray[r]) {
-            if (!timer->stop()) {
+            if (!timerArray[r]->stop() &&
+                !__atomic_load_n(&timerArray[r]->mExpired, __ATOMIC_ACQUIRE)) {
                 printf("%lf:\n", getDeltaSeconds(timeOfStart, getNow()));
                 printf("ERRER: %dth timer, id %d, not running when it should be\n", i, r);
                 exit(0);
             } else {
                 printf("stop() - %d\n", r);
-                delete timer;
+                delete timerArray[r];
                 timerArray[r] = NULL;
             }
         } else {
+            LocTimerTest* timer = new LocTimerTest(r);
             if (!timer->start(r, false)) {
                 printf("%lf:\n", getDeltaSeconds(timeOfStart, getNow()));
                 printf("ERRER: %dth timer, id %d, running when it should not be\n", i, r);
                 exit(0);
             } else {
-                printf("stop() - %d\n", r);
+                printf("start() - %d\n", r);
                 timerArray[r] = timer;
             }
         }
@@ -732,20 +855,20 @@ int main(int argc, char** argv) {
 
     for (int i = 0; i < tries; i++) {
         if (timerArray[i]) {
-            if (!timerArray[i]->stop()) {
-                printf("%lf:\n", getDeltaSeconds(timeOfStart, getNow()));
-                printf("ERRER: %dth timer, not running when it should be\n", i);
-                exit(0);
-            } else {
-                printf("stop() - %d\n", i);
-                delete timerArray[i];
-                timerArray[i] = NULL;
-            }
+            // it may have legitimately expired by now
+            printf("%s() - %d\n", timerArray[i]->stop() ? "stop" : "expired", i);
+            delete timerArray[i];
+            timerArray[i] = NULL;
         }
     }
 
     delete[] timerArray;
 
+    benchmark(tries, 0);
+    if (argc > 2) {
+        benchmark(tries, atoi(argv[2]));
+    }
+
     return 0;
 }
 
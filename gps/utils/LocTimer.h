@@ -61,6 +61,12 @@ public:
     //               false on failure, e.g. timer is already running.
     bool start(uint32_t timeOutInMs, bool wakeOnExpire);
 
+    // same as above, plus
+    // slackInMs:    how much later than timeOutInMs the client can tolerate
+    //               being notified. Timers whose windows overlap are expired
+    //               together with a single wakeup.
+    bool start(uint32_t timeOutInMs, bool wakeOnExpire, uint32_t slackInMs);
+
     // return:       true on success;
     //               false on failure, e.g. timer is not running.
     bool stop();
@@ -30,8 +30,10 @@
 #define LOG_TAG "LocSvc_MsgTask"
 
 #include <unistd.h>
+#include <string.h>
 #include <MsgTask.h>
 #include <msg_q.h>
+#include <msg_ring.h>
 #include <loc_log.h>
 #include <platform_lib_includes.h>
 
@@ -39,31 +41,55 @@ static void LocMsgDestroy(void* msg) {
     delete (LocMsg*)msg;
 }
 
+// destroy hook for msgs placed in a block from MsgTask::allocMsg()
+static void LocMsgRelease(void* msg) {
+    ((LocMsg*)msg)->~LocMsg();
+    LocMsgPool::free(msg);
+}
+
+static const void* initQ(MsgTask::QueueType qType, uint32_t ringSize) {
+    return (MsgTask::QUEUE_RING == qType) ? msg_ring_init2(ringSize) : msg_q_init2();
+}
+
 MsgTask::MsgTask(LocThread::tCreate tCreator,
                  const char* threadName, bool joinable) :
-    mQ(msg_q_init2()), mThread(new LocThread()) {
-    if (!mThread->start(tCreator, threadName, this, joinable)) {
-        delete mThread;
-        mThread = NULL;
-    }
+    MsgTask(tCreator, threadName, joinable, QUEUE_LIST) {
 }
 
 MsgTask::MsgTask(const char* threadName, bool joinable) :
-    mQ(msg_q_init2()), mThread(new LocThread()) {
-    if (!mThread->start(threadName, this, joinable)) {
+    MsgTask(NULL, threadName, joinable, QUEUE_LIST) {
+}
+
+MsgTask::MsgTask(LocThread::tCreate tCreator,
+                 const char* threadName, bool joinable,
+                 QueueType qType, uint32_t ringSize) :
+    mQ(initQ(qType, ringSize)), mThread(new LocThread()), mQType(qType),
+    mMsgPool(NULL) {
+    if (!mThread->start(tCreator, threadName, this, joinable)) {
         delete mThread;
         mThread = NULL;
     }
 }
 
 MsgTask::~MsgTask() {
-    msg_q_flush((void*)mQ);
-    msg_q_destroy((void**)&mQ);
+    if (QUEUE_RING == mQType) {
+        msg_ring_flush((void*)mQ);
+        msg_ring_destroy((void**)&mQ);
+    } else {
+        msg_q_flush((void*)mQ);
+        msg_q_destroy((void**)&mQ);
+    }
+    // pooled msgs still queued were released by the flush above
+    delete mMsgPool;
 }
 
 void MsgTask::destroy() {
     LocThread* thread = mThread;
-    msg_q_unblock((void*)mQ);
+    if (QUEUE_RING == mQType) {
+        msg_ring_unblock((void*)mQ);
+    } else {
+        msg_q_unblock((void*)mQ);
+    }
     if (thread) {
         mThread = NULL;
         delete thread;
@@ -74,12 +100,53 @@ void MsgTask::destroy() {
 
 void MsgTask::sendMsg(const LocMsg* msg) const {
     if (msg) {
-        msg_q_snd((void*)mQ, (void*)msg, LocMsgDestroy);
+        LocMsgPool* pool = __atomic_load_n(&mMsgPool, __ATOMIC_ACQUIRE);
+        void (*dealloc)(void*) = (NULL != pool && pool->owns(msg)) ?
+                LocMsgRelease : LocMsgDestroy;
+        if (QUEUE_RING == mQType) {
+            msg_ring_snd((void*)mQ, (void*)msg, dealloc);
+        } else {
+            msg_q_snd((void*)mQ, (void*)msg, dealloc);
+        }
     } else {
         LOC_LOGE("%s: msg is NULL", __func__);
     }
 }
 
+void* MsgTask::allocMsg(size_t size) const {
+    LocMsgPool* pool = __atomic_load_n(&mMsgPool, __ATOMIC_ACQUIRE);
+    if (NULL == pool) {
+        // created on first use, so that tasks never asking for pooled
+        // msgs do not carry the slab
+        LocMsgPool* newPool = new LocMsgPool();
+        if (__atomic_compare_exchange_n(&mMsgPool, &pool, newPool, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            pool = newPool;
+        } else {
+            delete newPool;
+        }
+    }
+    return pool->alloc(size);
+}
+
+void MsgTask::getMsgPoolStats(LocMsgPoolStats& stats) const {
+    LocMsgPool* pool = __atomic_load_n(&mMsgPool, __ATOMIC_ACQUIRE);
+    if (NULL != pool) {
+        pool->getStats(stats);
+    } else {
+        memset(&stats, 0, sizeof(stats));
+    }
+}
+
+void MsgTask::destroyMsg(LocMsg* msg) const {
+    LocMsgPool* pool = __atomic_load_n(&mMsgPool, __ATOMIC_ACQUIRE);
+    if (NULL != pool && pool->owns(msg)) {
+        LocMsgRelease(msg);
+    } else {
+        delete msg;
+    }
+}
+
 void MsgTask::prerun() {
     // make sure we do not run in background scheduling group
      platform_lib_abstraction_set_sched_policy(platform_lib_abstraction_gettid(), PLA_SP_FOREGROUND);
@@ -87,7 +154,9 @@ void MsgTask::prerun() {
 
 bool MsgTask::run() {
     LocMsg* msg;
-    msq_q_err_type result = msg_q_rcv((void*)mQ, (void **)&msg);
+    msq_q_err_type result = (QUEUE_RING == mQType) ?
+            msg_ring_rcv((void*)mQ, (void **)&msg) :
+            msg_q_rcv((void*)mQ, (void **)&msg);
     if (eMSG_Q_SUCCESS != result) {
         LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
                  loc_get_msg_q_status(result));
@@ -98,7 +167,7 @@ bool MsgTask::run() {
     // there is where each individual msg handling is invoked
     msg->proc();
 
-    delete msg;
+    destroyMsg(msg);
 
     return true;
 }
@@ -29,7 +29,9 @@
 #ifndef __MSG_TASK__
 #define __MSG_TASK__
 
+#include <stdint.h>
 #include <LocThread.h>
+#include <LocMsgPool.h>
 
 struct LocMsg {
     inline LocMsg() {}
@@ -39,17 +41,42 @@ struct LocMsg {
 };
 
 class MsgTask : public LocRunnable {
+public:
+    // backing store of the task's message queue
+    //   QUEUE_LIST: mutex protected linked list (msg_q)
+    //   QUEUE_RING: lock free bounded MPSC ring (msg_ring), for tasks
+    //               fed by several reporting threads at high rates
+    enum QueueType {
+        QUEUE_LIST = 0,
+        QUEUE_RING
+    };
+private:
     const void* mQ;
     LocThread* mThread;
+    const QueueType mQType;
+    mutable LocMsgPool* mMsgPool;
     friend class LocThreadDelegate;
+    void destroyMsg(LocMsg* msg) const;
 protected:
     virtual ~MsgTask();
 public:
     MsgTask(LocThread::tCreate tCreator, const char* threadName = NULL, bool joinable = true);
     MsgTask(const char* threadName = NULL, bool joinable = true);
+    // ringSize is only used for QUEUE_RING; 0 selects the default size
+    MsgTask(LocThread::tCreate tCreator, const char* threadName, bool joinable,
+            QueueType qType, uint32_t ringSize = 0);
     // this obj will be deleted once thread is deleted
     void destroy();
     void sendMsg(const LocMsg* msg) const;
+    // Placement new API for LocMsg objects on hot paths, e.g.
+    //     void* buf = msgTask->allocMsg(sizeof(MsgFoo));
+    //     msgTask->sendMsg(buf ? new (buf) MsgFoo(...) : new MsgFoo(...));
+    // Returns a block from this task's slab pool, or NULL if the pool can
+    // not serve size bytes right now. The msg constructed in the block must
+    // be sent to this same task, which destroys it and recycles the block.
+    void* allocMsg(size_t size) const;
+    // counters of this task's slab pool; all zeros if allocMsg() never called
+    void getMsgPoolStats(LocMsgPoolStats& stats) const;
     // Overrides of LocRunnable methods
     // This method will be repeated called until it returns false; or
     // until thread is stopped.
@@ -218,17 +218,17 @@ SIDE EFFECTS
 
 ===========================================================================*/
 static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtended,
-                              char* sentence,
-                              int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaBuffer &nmea)
 {
-    if (!sentence || bufSize <= 0 || !sv_meta_p)
+    if (!sv_meta_p)
     {
         LOC_LOGE("NMEA Error invalid arguments.");
         return 0;
     }
 
+    char* sentence = nmea.next();
+    int bufSize = NMEA_SENTENCE_MAX_LENGTH;
     char* pMarker = sentence;
     int lengthRemaining = bufSize;
     int length = 0;
@@ -317,7 +317,7 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
 
     /* Sentence is ready, add checksum and broadcast */
     length = loc_nmea_put_checksum(sentence, bufSize);
-    nmeaArraystr.push_back(sentence);
+    sentence = nmea.commit(length);
 
     return svUsedCount;
 }
@@ -343,17 +343,17 @@ SIDE EFFECTS
 
 ===========================================================================*/
 static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
-                              char* sentence,
-                              int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaBuffer &nmea)
 {
-    if (!sentence || bufSize <= 0)
+    if (!sv_meta_p)
     {
         LOC_LOGE("NMEA Error invalid argument.");
         return;
     }
 
+    char* sentence = nmea.next();
+    int bufSize = NMEA_SENTENCE_MAX_LENGTH;
     char* pMarker = sentence;
     int lengthRemaining = bufSize;
     int length = 0;
@@ -370,7 +370,7 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
         // no svs in view, so just send a blank $--GSV sentence
         snprintf(sentence, lengthRemaining, "$%sGSV,1,1,0,", talker);
         length = loc_nmea_put_checksum(sentence, bufSize);
-        nmeaArraystr.push_back(sentence);
+        sentence = nmea.commit(length);
         return;
     }
 
@@ -441,7 +441,7 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
         }
 
         length = loc_nmea_put_checksum(sentence, bufSize);
-        nmeaArraystr.push_back(sentence);
+        sentence = nmea.commit(length);
         sentenceNumber++;
 
     }  //while
@@ -474,7 +474,7 @@ SIDE EFFECTS
 void loc_nmea_generate_pos(const UlpLocation &location,
                                const GpsLocationExtended &locationExtended,
                                unsigned char generate_nmea,
-                               std::vector<std::string> &nmeaArraystr)
+                               LocNmeaBuffer &nmea)
 {
     ENTRY_LOG();
     time_t utcTime(location.gpsLocation.timestamp/1000);
@@ -484,9 +484,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         return;
     }
 
-    char sentence[NMEA_SENTENCE_MAX_LENGTH] = {0};
+    char* sentence = nmea.next();
     char* pMarker = sentence;
-    int lengthRemaining = sizeof(sentence);
+    int lengthRemaining = NMEA_SENTENCE_MAX_LENGTH;
     int length = 0;
     int utcYear = pTm->tm_year % 100; // 2 digit year
     int utcMonth = pTm->tm_mon + 1; // tm_mon starts at zero
@@ -505,8 +505,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GPGSA/$GNGSA---
         // -------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
-                loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_GPS, true), nmeaArraystr);
+        count = loc_nmea_generate_GSA(locationExtended,
+                loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_GPS, true), nmea);
         if (count > 0)
         {
             svUsedCount += count;
@@ -518,8 +518,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GLGSA/$GNGSA---
         // -------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
-                loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_GLONASS, true), nmeaArraystr);
+        count = loc_nmea_generate_GSA(locationExtended,
+                loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_GLONASS, true), nmea);
         if (count > 0)
         {
             svUsedCount += count;
@@ -531,8 +531,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GAGSA/$GNGSA---
         // -------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
-                loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_GALILEO, true), nmeaArraystr);
+        count = loc_nmea_generate_GSA(locationExtended,
+                loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_GALILEO, true), nmea);
         if (count > 0)
         {
             svUsedCount += count;
@@ -544,8 +544,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$PQGSA/$GNGSA (QZSS)---
         // --------------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
-                loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_QZSS, false), nmeaArraystr);
+        count = loc_nmea_generate_GSA(locationExtended,
+                loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_QZSS, false), nmea);
         if (count > 0)
         {
             svUsedCount += count;
@@ -555,8 +555,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ----------------------------
         // ---$PQGSA/$GNGSA (BEIDOU)---
         // ----------------------------
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
-                loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_BEIDOU, false), nmeaArraystr);
+        count = loc_nmea_generate_GSA(locationExtended,
+                loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_BEIDOU, false), nmea);
         if (count > 0)
         {
             svUsedCount += count;
@@ -567,8 +567,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ------$--VTG-------
         // -------------------
 
+        sentence = nmea.next();
         pMarker = sentence;
-        lengthRemaining = sizeof(sentence);
+        lengthRemaining = NMEA_SENTENCE_MAX_LENGTH;
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
         {
@@ -629,15 +630,15 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         else // A means autonomous
             length = snprintf(pMarker, lengthRemaining, "%c", 'A');
 
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        sentence = nmea.commit(length);
 
         // -------------------
         // ------$--RMC-------
         // -------------------
 
         pMarker = sentence;
-        lengthRemaining = sizeof(sentence);
+        lengthRemaining = NMEA_SENTENCE_MAX_LENGTH;
 
         length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,A," ,
                           talker, utcHours, utcMinutes, utcSeconds,utcMSeconds/10);
@@ -787,15 +788,15 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         else  // A means autonomous
             length = snprintf(pMarker, lengthRemaining, "%c", 'A');
 
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        sentence = nmea.commit(length);
 
         // -------------------
         // ------$--GGA-------
         // -------------------
 
         pMarker = sentence;
-        lengthRemaining = sizeof(sentence);
+        lengthRemaining = NMEA_SENTENCE_MAX_LENGTH;
 
         length = snprintf(pMarker, lengthRemaining, "$%sGGA,%02d%02d%02d.%02d," ,
                           talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
@@ -918,8 +919,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
             length = snprintf(pMarker, lengthRemaining,",,,");
         }
 
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        sentence = nmea.commit(length);
 
         // clear the cache so they can't be used again
         sv_cache_info.gps_used_mask = 0;
@@ -930,29 +931,29 @@ void loc_nmea_generate_pos(const UlpLocation &location,
     }
     //Send blank NMEA reports for non-final fixes
     else {
-        strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,", NMEA_SENTENCE_MAX_LENGTH);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        sentence = nmea.commit(length);
 
-        strlcpy(sentence, "$GNGSA,A,1,,,,,,,,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        strlcpy(sentence, "$GNGSA,A,1,,,,,,,,,,,,,,,", NMEA_SENTENCE_MAX_LENGTH);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        sentence = nmea.commit(length);
 
-        strlcpy(sentence, "$PQGSA,A,1,,,,,,,,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        strlcpy(sentence, "$PQGSA,A,1,,,,,,,,,,,,,,,", NMEA_SENTENCE_MAX_LENGTH);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        sentence = nmea.commit(length);
 
-        strlcpy(sentence, "$GPVTG,,T,,M,,N,,K,N", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        strlcpy(sentence, "$GPVTG,,T,,M,,N,,K,N", NMEA_SENTENCE_MAX_LENGTH);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        sentence = nmea.commit(length);
 
-        strlcpy(sentence, "$GPRMC,,V,,,,,,,,,,N", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        strlcpy(sentence, "$GPRMC,,V,,,,,,,,,,N", NMEA_SENTENCE_MAX_LENGTH);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        sentence = nmea.commit(length);
 
-        strlcpy(sentence, "$GPGGA,,,,,,0,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        strlcpy(sentence, "$GPGGA,,,,,,0,,,,,,,,", NMEA_SENTENCE_MAX_LENGTH);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        sentence = nmea.commit(length);
     }
 
     EXIT_LOG(%d, 0);
@@ -977,14 +978,10 @@ SIDE EFFECTS
 
 ===========================================================================*/
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaBuffer &nmea)
 {
     ENTRY_LOG();
 
-    char sentence[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char* pMarker = sentence;
-    int lengthRemaining = sizeof(sentence);
-    int length = 0;
     int svCount = svNotify.count;
     int sentenceCount = 0;
     int sentenceNumber = 1;
@@ -1071,36 +1068,142 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
     // ------$GPGSV------
     // ------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_GPS, false), nmeaArraystr);
+    loc_nmea_generate_GSV(svNotify,
+            loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_GPS, false), nmea);
 
     // ------------------
     // ------$GLGSV------
     // ------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_GLONASS, false), nmeaArraystr);
+    loc_nmea_generate_GSV(svNotify,
+            loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_GLONASS, false), nmea);
 
     // ------------------
     // ------$GAGSV------
     // ------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_GALILEO, false), nmeaArraystr);
+    loc_nmea_generate_GSV(svNotify,
+            loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_GALILEO, false), nmea);
 
     // -------------------------
     // ------$PQGSV (QZSS)------
     // -------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_QZSS, false), nmeaArraystr);
+    loc_nmea_generate_GSV(svNotify,
+            loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_QZSS, false), nmea);
 
     // ---------------------------
     // ------$PQGSV (BEIDOU)------
     // ---------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_BEIDOU, false), nmeaArraystr);
+    loc_nmea_generate_GSV(svNotify,
+            loc_nmea_sv_meta_init(sv_meta, GNSS_SV_TYPE_BEIDOU, false), nmea);
 
     EXIT_LOG(%d, 0);
 }
+
+#ifdef __LOC_DEBUG__
+
+#include <time.h>
+#include <vector>
+#include <string>
+
+// For Linux command line testing:
+// Measures NMEA generation and fan-out per epoch with 48 SVs in view,
+// comparing the former std::vector<std::string> hand-off against
+// LocNmeaBuffer. Bytes copied counts the sentence bytes duplicated after
+// they are formatted.
+// compilation:
+//     g++ -D__LOC_HOST_DEBUG__ -D__LOC_DEBUG__ -O2 -I. -I../location -I../../../../system/core/include -o loc_nmea_bench loc_nmea.cpp
+// usage: loc_nmea_bench [epochs]
+
+static double getNowNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static size_t sSink = 0;
+
+// stands in for a client's gnssNmeaCb
+static void benchNmeaCb(const char* nmea, size_t length) {
+    sSink += length + (uint8_t)nmea[0];
+}
+
+int main(int argc, char** argv) {
+    int epochs = argc > 1 ? atoi(argv[1]) : 10000;
+
+    GnssSvNotification svNotify = {};
+    svNotify.size = sizeof(svNotify);
+    const GnssSvType types[] = { GNSS_SV_TYPE_GPS, GNSS_SV_TYPE_GLONASS, GNSS_SV_TYPE_BEIDOU,
+                                 GNSS_SV_TYPE_GALILEO };
+    for (uint32_t i = 0; i < 48; i++) {
+        GnssSv& sv = svNotify.gnssSvs[svNotify.count++];
+        sv.size = sizeof(sv);
+        sv.type = types[i % 4];
+        sv.svId = i / 4 + 1;
+        sv.cN0Dbhz = 20 + i % 25;
+        sv.elevation = 5 + i;
+        sv.azimuth = 7 * i;
+        sv.gnssSvOptionsMask = (i % 3) ? GNSS_SV_OPTIONS_USED_IN_FIX_BIT : 0;
+    }
+
+    UlpLocation location = {};
+    location.gpsLocation.flags = LOC_GPS_LOCATION_HAS_LAT_LONG | LOC_GPS_LOCATION_HAS_ALTITUDE |
+            LOC_GPS_LOCATION_HAS_SPEED | LOC_GPS_LOCATION_HAS_BEARING |
+            LOC_GPS_LOCATION_HAS_ACCURACY;
+    location.gpsLocation.latitude = 32.89;
+    location.gpsLocation.longitude = -117.19;
+    location.gpsLocation.altitude = 120;
+    location.gpsLocation.speed = 1.5;
+    location.gpsLocation.bearing = 45;
+    location.gpsLocation.timestamp = 1500000000000LL;
+    GpsLocationExtended locationExtended = {};
+    locationExtended.flags = GPS_LOCATION_EXTENDED_HAS_DOP;
+    locationExtended.pdop = 1.2;
+    locationExtended.hdop = 0.8;
+    locationExtended.vdop = 0.9;
+
+    LocNmeaBuffer* nmea = new LocNmeaBuffer();
+    uint64_t vectorBytes = 0;
+    double vectorNs = 0, bufferNs = 0;
+    uint32_t sentences = 0;
+
+    for (int e = 0; e < epochs; e++) {
+        // former path: sentences pushed into a vector, iterated by value
+        double start = getNowNs();
+        nmea->reset();
+        loc_nmea_generate_sv(svNotify, *nmea);
+        loc_nmea_generate_pos(location, locationExtended, 1, *nmea);
+        std::vector<std::string> nmeaArraystr;
+        for (uint32_t i = 0; i < nmea->count(); i++) {
+            nmeaArraystr.push_back(nmea->sentence(i));
+            vectorBytes += nmea->length(i);
+        }
+        for (auto sentence : nmeaArraystr) {
+            vectorBytes += sentence.length();
+            benchNmeaCb(sentence.c_str(), sentence.length());
+        }
+        vectorNs += getNowNs() - start;
+
+        // buffer path: sentences handed out in place
+        start = getNowNs();
+        nmea->reset();
+        loc_nmea_generate_sv(svNotify, *nmea);
+        loc_nmea_generate_pos(location, locationExtended, 1, *nmea);
+        for (uint32_t i = 0; i < nmea->count(); i++) {
+            benchNmeaCb(nmea->sentence(i), nmea->length(i));
+        }
+        bufferNs += getNowNs() - start;
+        sentences = nmea->count();
+    }
+    delete nmea;
+
+    printf("%u sentences per epoch, %d epochs\n", sentences, epochs);
+    printf("vector: %8.0lf ns/epoch %8.0lf bytes copied/epoch\n",
+           vectorNs / epochs, (double)vectorBytes / epochs);
+    printf("buffer: %8.0lf ns/epoch %8d bytes copied/epoch\n", bufferNs / epochs, 0);
+    return (int)(sSink & 0);
+}
+
+#endif
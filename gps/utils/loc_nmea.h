@@ -31,17 +31,54 @@
 #define LOC_ENG_NMEA_H
 
 #include <gps_extended.h>
-#include <vector>
-#include <string>
+#include <stdint.h>
 #define NMEA_SENTENCE_MAX_LENGTH 200
+// enough for the GSV sentences of 64 SVs plus all position sentences
+#define NMEA_BUFFER_MAX_SENTENCES 48
+
+// Fixed capacity store for the NMEA sentences of one epoch. Generators
+// format each sentence straight into its slot, and consumers are handed
+// pointers into the slots, so fanning the sentences out to clients never
+// copies them. The owner reset()s and reuses it for the next epoch.
+class LocNmeaBuffer {
+    uint32_t mCount;
+    uint32_t mDropped;
+    uint16_t mLength[NMEA_BUFFER_MAX_SENTENCES];
+    // the extra slot takes the sentences that no longer fit
+    char mSlot[NMEA_BUFFER_MAX_SENTENCES + 1][NMEA_SENTENCE_MAX_LENGTH];
+public:
+    inline LocNmeaBuffer() : mCount(0), mDropped(0) { mSlot[0][0] = '\0'; }
+    inline void reset() { mCount = 0; mDropped = 0; mSlot[0][0] = '\0'; }
+
+    // slot of NMEA_SENTENCE_MAX_LENGTH bytes to format the next sentence in
+    inline char* next() { return mSlot[mCount]; }
+    // completes the sentence in next() of the given length, including
+    // checksum and CR LF; returns the slot for the sentence after it
+    inline char* commit(int length) {
+        if (mCount < NMEA_BUFFER_MAX_SENTENCES) {
+            if (length > 0 && length < NMEA_SENTENCE_MAX_LENGTH) {
+                mLength[mCount++] = (uint16_t)length;
+            }
+        } else {
+            mDropped++;
+        }
+        mSlot[mCount][0] = '\0';
+        return mSlot[mCount];
+    }
+
+    inline uint32_t count() const { return mCount; }
+    inline uint32_t dropped() const { return mDropped; }
+    inline const char* sentence(uint32_t i) const { return mSlot[i]; }
+    inline size_t length(uint32_t i) const { return mLength[i]; }
+};
 
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
-                              std::vector<std::string> &nmeaArraystr);
+                              LocNmeaBuffer &nmea);
 
 void loc_nmea_generate_pos(const UlpLocation &location,
                                const GpsLocationExtended &locationExtended,
                                unsigned char generate_nmea,
-                               std::vector<std::string> &nmeaArraystr);
+                               LocNmeaBuffer &nmea);
 
 #define DEBUG_NMEA_MINSIZE 6
 #define DEBUG_NMEA_MAXSIZE 4096
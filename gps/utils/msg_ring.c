@@ -0,0 +1,569 @@
+/* Copyright (c) 2011, 2017 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "msg_ring.h"
+
+#define LOG_TAG "LocSvc_utils_ring"
+#include <platform_lib_includes.h>
+#include "linked_list.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+/* keeps the producer and consumer indices on separate cache lines */
+#define MSG_RING_CACHE_LINE 64
+
+typedef struct msg_ring_cell {
+   uint32_t seq;                    /* slot sequence, see msg_ring_push() */
+   void* msg_obj;
+   void (*dealloc)(void*);
+} msg_ring_cell;
+
+typedef struct msg_ring {
+   msg_ring_cell* cells;
+   uint32_t mask;                   /* number of cells - 1 */
+   char pad0[MSG_RING_CACHE_LINE];
+   uint32_t enq_pos;                /* next slot to claim, shared by senders */
+   char pad1[MSG_RING_CACHE_LINE];
+   uint32_t deq_pos;                /* next slot to read, consumer only */
+   int waiting;                     /* Is the consumer asleep on ring_cond? */
+   int spilled;                     /* Does spill_list hold any messages? */
+   int unblocked;                   /* Has this message ring been unblocked? */
+   void* spill_list;                /* Overflow storage once the ring is full */
+   pthread_cond_t  ring_cond;       /* Condition variable for the consumer */
+   pthread_mutex_t ring_mutex;      /* Guards spill_list and consumer sleep */
+} msg_ring;
+
+/*===========================================================================
+FUNCTION    msg_ring_push
+
+DESCRIPTION
+   Lock free enqueue. Each cell carries a sequence number; a cell at
+   position pos is free for a sender when seq == pos, and holds a message
+   for the consumer when seq == pos + 1. Senders race for pos with a CAS on
+   enq_pos, and publish the message with a release store of seq.
+
+RETURN VALUE
+   1 if enqueued; 0 if the ring is full
+
+===========================================================================*/
+static int msg_ring_push(msg_ring* p_ring, void* msg_obj, void (*dealloc)(void*))
+{
+   msg_ring_cell* cell;
+   uint32_t pos = __atomic_load_n(&p_ring->enq_pos, __ATOMIC_RELAXED);
+
+   for (;;)
+   {
+      cell = &p_ring->cells[pos & p_ring->mask];
+      uint32_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+      int32_t diff = (int32_t)(seq - pos);
+
+      if (0 == diff)
+      {
+         if (__atomic_compare_exchange_n(&p_ring->enq_pos, &pos, pos + 1, 1,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+         {
+            break;
+         }
+      }
+      else if (diff < 0)
+      {
+         return 0;
+      }
+      else
+      {
+         pos = __atomic_load_n(&p_ring->enq_pos, __ATOMIC_RELAXED);
+      }
+   }
+
+   cell->msg_obj = msg_obj;
+   cell->dealloc = dealloc;
+   __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+
+   return 1;
+}
+
+/*===========================================================================
+FUNCTION    msg_ring_peek_ready
+
+DESCRIPTION
+   Consumer side check whether the cell at deq_pos has been published.
+
+===========================================================================*/
+static inline int msg_ring_peek_ready(msg_ring* p_ring)
+{
+   msg_ring_cell* cell = &p_ring->cells[p_ring->deq_pos & p_ring->mask];
+   return __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) == p_ring->deq_pos + 1;
+}
+
+/*===========================================================================
+FUNCTION    msg_ring_pop
+
+DESCRIPTION
+   Single consumer dequeue. Ring cells are always drained before the spill
+   list: a sender only spills once the ring is full or the spill list is
+   already in use, so everything still in the ring is older than anything
+   that sender spilled.
+
+RETURN VALUE
+   1 if a message was dequeued; 0 if ring and spill list are both empty
+
+===========================================================================*/
+static int msg_ring_pop(msg_ring* p_ring, void** msg_obj, void (**dealloc)(void*))
+{
+   if (msg_ring_peek_ready(p_ring))
+   {
+      msg_ring_cell* cell = &p_ring->cells[p_ring->deq_pos & p_ring->mask];
+      *msg_obj = cell->msg_obj;
+      if (dealloc)
+      {
+         *dealloc = cell->dealloc;
+      }
+      /* hand the cell back to senders for the next lap */
+      __atomic_store_n(&cell->seq, p_ring->deq_pos + p_ring->mask + 1,
+                       __ATOMIC_RELEASE);
+      p_ring->deq_pos++;
+      return 1;
+   }
+
+   if (__atomic_load_n(&p_ring->spilled, __ATOMIC_ACQUIRE))
+   {
+      int rv = 0;
+      pthread_mutex_lock(&p_ring->ring_mutex);
+      if (!linked_list_empty(p_ring->spill_list) &&
+          eLINKED_LIST_SUCCESS == linked_list_remove(p_ring->spill_list, msg_obj))
+      {
+         /* linked_list_remove does not hand out the dealloc; spilled
+            messages are freed through linked_list_flush() instead */
+         if (dealloc)
+         {
+            *dealloc = NULL;
+         }
+         rv = 1;
+      }
+      if (linked_list_empty(p_ring->spill_list))
+      {
+         __atomic_store_n(&p_ring->spilled, 0, __ATOMIC_RELEASE);
+      }
+      pthread_mutex_unlock(&p_ring->ring_mutex);
+      return rv;
+   }
+
+   return 0;
+}
+
+/* ----------------------- END INTERNAL FUNCTIONS ---------------------------------------- */
+
+/*===========================================================================
+
+  FUNCTION:   msg_ring_init2
+
+  ===========================================================================*/
+const void* msg_ring_init2(uint32_t size)
+{
+   uint32_t cells = 1;
+   uint32_t i;
+
+   if (0 == size)
+   {
+      size = MSG_RING_DEFAULT_SIZE;
+   }
+   while (cells < size && cells < 0x80000000)
+   {
+      cells <<= 1;
+   }
+
+   msg_ring* tmp_ring = (msg_ring*)calloc(1, sizeof(msg_ring));
+   if (tmp_ring == NULL)
+   {
+      LOC_LOGE("%s: Unable to allocate space for message ring!\n", __FUNCTION__);
+      return NULL;
+   }
+
+   tmp_ring->cells = (msg_ring_cell*)calloc(cells, sizeof(msg_ring_cell));
+   if (tmp_ring->cells == NULL)
+   {
+      LOC_LOGE("%s: Unable to allocate %u ring cells!\n", __FUNCTION__, cells);
+      free(tmp_ring);
+      return NULL;
+   }
+   for (i = 0; i < cells; i++)
+   {
+      tmp_ring->cells[i].seq = i;
+   }
+   tmp_ring->mask = cells - 1;
+
+   if (linked_list_init(&tmp_ring->spill_list) != 0)
+   {
+      LOC_LOGE("%s: Unable to initialize spill list!\n", __FUNCTION__);
+      free(tmp_ring->cells);
+      free(tmp_ring);
+      return NULL;
+   }
+
+   if (pthread_mutex_init(&tmp_ring->ring_mutex, NULL) != 0)
+   {
+      LOC_LOGE("%s: Unable to initialize ring mutex!\n", __FUNCTION__);
+      linked_list_destroy(&tmp_ring->spill_list);
+      free(tmp_ring->cells);
+      free(tmp_ring);
+      return NULL;
+   }
+
+   if (pthread_cond_init(&tmp_ring->ring_cond, NULL) != 0)
+   {
+      LOC_LOGE("%s: Unable to initialize ring cond var!\n", __FUNCTION__);
+      pthread_mutex_destroy(&tmp_ring->ring_mutex);
+      linked_list_destroy(&tmp_ring->spill_list);
+      free(tmp_ring->cells);
+      free(tmp_ring);
+      return NULL;
+   }
+
+   return tmp_ring;
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_ring_destroy
+
+  ===========================================================================*/
+msq_q_err_type msg_ring_destroy(void** msg_ring_data)
+{
+   if (msg_ring_data == NULL || *msg_ring_data == NULL)
+   {
+      LOC_LOGE("%s: Invalid msg_ring_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+
+   msg_ring* p_ring = (msg_ring*)*msg_ring_data;
+
+   linked_list_destroy(&p_ring->spill_list);
+   pthread_mutex_destroy(&p_ring->ring_mutex);
+   pthread_cond_destroy(&p_ring->ring_cond);
+   free(p_ring->cells);
+
+   free(*msg_ring_data);
+   *msg_ring_data = NULL;
+
+   return eMSG_Q_SUCCESS;
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_ring_snd
+
+  ===========================================================================*/
+msq_q_err_type msg_ring_snd(void* msg_ring_data, void* msg_obj, void (*dealloc)(void*))
+{
+   if (msg_ring_data == NULL)
+   {
+      LOC_LOGE("%s: Invalid msg_ring_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+   if (msg_obj == NULL)
+   {
+      LOC_LOGE("%s: Invalid msg_obj parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_PARAMETER;
+   }
+
+   msg_ring* p_ring = (msg_ring*)msg_ring_data;
+
+   if (__atomic_load_n(&p_ring->unblocked, __ATOMIC_ACQUIRE))
+   {
+      LOC_LOGE("%s: Message ring has been unblocked.\n", __FUNCTION__);
+      return eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+
+   if (!__atomic_load_n(&p_ring->spilled, __ATOMIC_ACQUIRE) &&
+       msg_ring_push(p_ring, msg_obj, dealloc))
+   {
+      /* pairs with the fence in msg_ring_rcv(): either we see the consumer
+         going to sleep, or the consumer sees our cell before sleeping */
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      if (__atomic_load_n(&p_ring->waiting, __ATOMIC_RELAXED))
+      {
+         pthread_mutex_lock(&p_ring->ring_mutex);
+         pthread_cond_signal(&p_ring->ring_cond);
+         pthread_mutex_unlock(&p_ring->ring_mutex);
+      }
+      return eMSG_Q_SUCCESS;
+   }
+
+   msq_q_err_type rv = eMSG_Q_SUCCESS;
+   pthread_mutex_lock(&p_ring->ring_mutex);
+   if (p_ring->unblocked)
+   {
+      LOC_LOGE("%s: Message ring has been unblocked.\n", __FUNCTION__);
+      rv = eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+   else if (eLINKED_LIST_SUCCESS !=
+            linked_list_add(p_ring->spill_list, msg_obj, dealloc))
+   {
+      LOC_LOGE("%s: Unable to spill message %p\n", __FUNCTION__, msg_obj);
+      rv = eMSG_Q_FAILURE_GENERAL;
+   }
+   else
+   {
+      LOC_LOGV("%s: Ring full, spilled message %p\n", __FUNCTION__, msg_obj);
+      __atomic_store_n(&p_ring->spilled, 1, __ATOMIC_RELEASE);
+      pthread_cond_signal(&p_ring->ring_cond);
+   }
+   pthread_mutex_unlock(&p_ring->ring_mutex);
+
+   return rv;
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_ring_rcv
+
+  ===========================================================================*/
+msq_q_err_type msg_ring_rcv(void* msg_ring_data, void** msg_obj)
+{
+   if (msg_ring_data == NULL)
+   {
+      LOC_LOGE("%s: Invalid msg_ring_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+   if (msg_obj == NULL)
+   {
+      LOC_LOGE("%s: Invalid msg_obj parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_PARAMETER;
+   }
+
+   msg_ring* p_ring = (msg_ring*)msg_ring_data;
+
+   for (;;)
+   {
+      if (__atomic_load_n(&p_ring->unblocked, __ATOMIC_ACQUIRE))
+      {
+         LOC_LOGE("%s: Message ring has been unblocked.\n", __FUNCTION__);
+         return eMSG_Q_UNAVAILABLE_RESOURCE;
+      }
+
+      if (msg_ring_pop(p_ring, msg_obj, NULL))
+      {
+         return eMSG_Q_SUCCESS;
+      }
+
+      /* Wait for data in the message ring */
+      pthread_mutex_lock(&p_ring->ring_mutex);
+      __atomic_store_n(&p_ring->waiting, 1, __ATOMIC_RELAXED);
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      while (!msg_ring_peek_ready(p_ring) && !p_ring->spilled && !p_ring->unblocked)
+      {
+         pthread_cond_wait(&p_ring->ring_cond, &p_ring->ring_mutex);
+      }
+      __atomic_store_n(&p_ring->waiting, 0, __ATOMIC_RELAXED);
+      pthread_mutex_unlock(&p_ring->ring_mutex);
+   }
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_ring_flush
+
+  ===========================================================================*/
+msq_q_err_type msg_ring_flush(void* msg_ring_data)
+{
+   void* msg_obj;
+   void (*dealloc)(void*);
+
+   if (msg_ring_data == NULL)
+   {
+      LOC_LOGE("%s: Invalid msg_ring_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+
+   msg_ring* p_ring = (msg_ring*)msg_ring_data;
+
+   LOC_LOGD("%s: Flushing Message Ring\n", __FUNCTION__);
+
+   while (msg_ring_peek_ready(p_ring))
+   {
+      msg_ring_pop(p_ring, &msg_obj, &dealloc);
+      if (dealloc)
+      {
+         dealloc(msg_obj);
+      }
+   }
+
+   pthread_mutex_lock(&p_ring->ring_mutex);
+   linked_list_flush(p_ring->spill_list);
+   __atomic_store_n(&p_ring->spilled, 0, __ATOMIC_RELEASE);
+   pthread_mutex_unlock(&p_ring->ring_mutex);
+
+   LOC_LOGD("%s: Message Ring flushed\n", __FUNCTION__);
+
+   return eMSG_Q_SUCCESS;
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_ring_unblock
+
+  ===========================================================================*/
+msq_q_err_type msg_ring_unblock(void* msg_ring_data)
+{
+   if (msg_ring_data == NULL)
+   {
+      LOC_LOGE("%s: Invalid msg_ring_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+
+   msg_ring* p_ring = (msg_ring*)msg_ring_data;
+   pthread_mutex_lock(&p_ring->ring_mutex);
+
+   if (p_ring->unblocked)
+   {
+      LOC_LOGE("%s: Message ring has been unblocked.\n", __FUNCTION__);
+      pthread_mutex_unlock(&p_ring->ring_mutex);
+      return eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+
+   LOC_LOGD("%s: Unblocking Message Ring\n", __FUNCTION__);
+   __atomic_store_n(&p_ring->unblocked, 1, __ATOMIC_RELEASE);
+
+   /* Allow the consumer to wake up */
+   pthread_cond_broadcast(&p_ring->ring_cond);
+
+   pthread_mutex_unlock(&p_ring->ring_mutex);
+
+   LOC_LOGD("%s: Message Ring unblocked\n", __FUNCTION__);
+
+   return eMSG_Q_SUCCESS;
+}
+
+#ifdef __LOC_DEBUG__
+
+/* Compares msg_q and msg_ring with 1..8 senders and a single receiver.
+   For Linux command line testing:
+   compilation:
+       gcc -D__LOC_HOST_DEBUG__ -D__LOC_DEBUG__ -O2 -I. -I../../../../system/core/include
+           msg_ring.c msg_q.c linked_list.c -lpthread -o msg_ring_bench
+   usage: msg_ring_bench [msgs per sender] */
+
+#include <time.h>
+
+typedef struct {
+   void* q;
+   int count;
+   int use_ring;
+} bench_arg;
+
+static int bench_payload;
+
+static double bench_now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+static void* bench_sender(void* arg)
+{
+   bench_arg* b = (bench_arg*)arg;
+   int i;
+   for (i = 0; i < b->count; i++)
+   {
+      if (b->use_ring)
+      {
+         msg_ring_snd(b->q, &bench_payload, NULL);
+      }
+      else
+      {
+         msg_q_snd(b->q, &bench_payload, NULL);
+      }
+   }
+   return NULL;
+}
+
+static double bench_run(int use_ring, int senders, int count)
+{
+   pthread_t threads[8];
+   bench_arg arg;
+   void* q = use_ring ? (void*)msg_ring_init2(0) : (void*)msg_q_init2();
+   void* msg;
+   int i;
+
+   arg.q = q;
+   arg.count = count;
+   arg.use_ring = use_ring;
+
+   double start = bench_now();
+   for (i = 0; i < senders; i++)
+   {
+      pthread_create(&threads[i], NULL, bench_sender, &arg);
+   }
+   for (i = 0; i < senders * count; i++)
+   {
+      if (use_ring)
+      {
+         msg_ring_rcv(q, &msg);
+      }
+      else
+      {
+         msg_q_rcv(q, &msg);
+      }
+   }
+   double elapsed = bench_now() - start;
+
+   for (i = 0; i < senders; i++)
+   {
+      pthread_join(threads[i], NULL);
+   }
+   if (use_ring)
+   {
+      msg_ring_destroy(&q);
+   }
+   else
+   {
+      msg_q_destroy(&q);
+   }
+
+   return elapsed * 1000000000 / ((double)senders * count);
+}
+
+int main(int argc, char** argv)
+{
+   int count = argc > 1 ? atoi(argv[1]) : 100000;
+   int senders;
+
+   printf("senders    msg_q ns/msg    msg_ring ns/msg\n");
+   for (senders = 1; senders <= 8; senders <<= 1)
+   {
+      double q_ns = bench_run(0, senders, count);
+      double ring_ns = bench_run(1, senders, count);
+      printf("%7d    %12.1lf    %15.1lf\n", senders, q_ns, ring_ns);
+   }
+
+   return 0;
+}
+
+#endif
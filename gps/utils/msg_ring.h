@@ -0,0 +1,181 @@
+/* Copyright (c) 2011, 2017 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MSG_RING_H__
+#define __MSG_RING_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+#include <msg_q.h>
+
+/* Default number of slots of a ring created with size 0 */
+#define MSG_RING_DEFAULT_SIZE 256
+
+/*===========================================================================
+FUNCTION    msg_ring_init2
+
+DESCRIPTION
+   Initializes a bounded multi-producer / single-consumer message ring.
+   Senders never take a lock while the ring has free slots. Should the ring
+   fill up, messages spill over into a mutex protected list, which keeps
+   per-sender ordering and guarantees that a send never fails for lack of
+   slots (not even when the consumer sends to itself).
+
+   size: number of slots, rounded up to a power of 2;
+         0 selects MSG_RING_DEFAULT_SIZE
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   opaque handle to the ring created; NULL if create fails
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+const void* msg_ring_init2(uint32_t size);
+
+/*===========================================================================
+FUNCTION    msg_ring_destroy
+
+DESCRIPTION
+   Releases internal structures for message ring.
+
+   msg_ring_data: State of message ring to be released.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes in msg_q.h.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_ring_destroy(void** msg_ring_data);
+
+/*===========================================================================
+FUNCTION    msg_ring_snd
+
+DESCRIPTION
+   Sends data to the message ring. Same semantics as msg_q_snd(). May be
+   called from any number of threads concurrently.
+
+   msg_ring_data: Message ring to add the element to.
+   msg_obj:       Pointer to data to add into message ring.
+   dealloc:       Function used to deallocate memory for this element. Pass
+                  NULL if you do not want data deallocated during a flush
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes in msg_q.h.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_ring_snd(void* msg_ring_data, void* msg_obj,
+                            void (*dealloc)(void*));
+
+/*===========================================================================
+FUNCTION    msg_ring_rcv
+
+DESCRIPTION
+   Retrieves the oldest message from the message ring, blocking while the
+   ring is empty. Same semantics as msg_q_rcv(). Must only be called from
+   a single consumer thread.
+
+   msg_ring_data: Message ring to retrieve data from.
+   msg_obj:       Pointer to space to copy the message pointer to.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes in msg_q.h.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_ring_rcv(void* msg_ring_data, void** msg_obj);
+
+/*===========================================================================
+FUNCTION    msg_ring_flush
+
+DESCRIPTION
+   Removes and deallocates all elements from the message ring. Must be called
+   from the consumer thread, or once the consumer thread has stopped.
+
+   msg_ring_data: Message ring to remove elements from.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes in msg_q.h.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_ring_flush(void* msg_ring_data);
+
+/*===========================================================================
+FUNCTION    msg_ring_unblock
+
+DESCRIPTION
+   Same semantics as msg_q_unblock(). The consumer wakes up and receives
+   eMSG_Q_UNAVAILABLE_RESOURCE; further sends are refused.
+
+   msg_ring_data: Message ring to unblock.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes in msg_q.h.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_ring_unblock(void* msg_ring_data);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __MSG_RING_H__ */